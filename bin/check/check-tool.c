@@ -120,6 +120,7 @@ static isc_logcategory_t categories[] = {
 	{ "update-security", 0 },
 	{ "query-errors",    0 },
 	{ "trust-anchor-telemetry",    0 },
+	{ "serve-stale",     0 },
 	{ NULL,		     0 }
 };
 
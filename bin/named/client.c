@@ -42,6 +42,7 @@
 #include <dns/rdatalist.h>
 #include <dns/rdataset.h>
 #include <dns/resolver.h>
+#include <dns/respcache.h>
 #include <dns/stats.h>
 #include <dns/tsig.h>
 #include <dns/view.h>
@@ -130,6 +131,7 @@ struct ns_clientmgr {
 	isc_mem_t *			mctx;
 	isc_taskmgr_t *			taskmgr;
 	isc_timermgr_t *		timermgr;
+	int				threadid;     /*%< Worker, or -1 */
 
 	/* Lock covers manager state. */
 	isc_mutex_t			lock;
@@ -1005,6 +1007,140 @@ ns_client_sendraw(ns_client_t *client, dns_message_t *message) {
 	ns_client_next(client, result);
 }
 
+isc_result_t
+ns_client_sendcached(ns_client_t *client, dns_respcache_t *respcache,
+		     dns_name_t *qname, dns_rdatatype_t qtype,
+		     isc_uint32_t key)
+{
+	isc_result_t result;
+	unsigned char *data;
+	isc_buffer_t buffer;
+	isc_buffer_t tcpbuffer;
+	isc_region_t r;
+	unsigned char sendbuf[SEND_BUFFER_SIZE];
+	isc_statscounter_t counter;
+	isc_stats_t *outstats;
+	unsigned int flags, rcode, ancount;
+	size_t respsize;
+
+	REQUIRE(NS_CLIENT_VALID(client));
+
+	CTRACE("sendcached");
+
+	result = client_allocsendbuf(client, &buffer, &tcpbuffer, 0,
+				     sendbuf, &data);
+	if (result == ISC_R_SUCCESS)
+		result = dns_respcache_find(respcache, qname, qtype, key,
+					    &buffer);
+	if (result != ISC_R_SUCCESS) {
+		if (client->tcpbuf != NULL) {
+			isc_mem_put(client->mctx, client->tcpbuf,
+				    TCP_BUFFER_SIZE);
+			client->tcpbuf = NULL;
+		}
+		return (ISC_R_NOTFOUND);
+	}
+
+	/*
+	 * Fix up the id and the case of the question name, which is
+	 * never compressed.
+	 */
+	isc_buffer_usedregion(&buffer, &r);
+	INSIST(r.length >= 12 + qname->length);
+	r.base[0] = (client->message->id >> 8) & 0xff;
+	r.base[1] = client->message->id & 0xff;
+	memmove(r.base + 12, qname->ndata, qname->length);
+	flags = (r.base[2] << 8) | r.base[3];
+	rcode = flags & 0x000f;
+	ancount = (r.base[6] << 8) | r.base[7];
+	respsize = r.length;
+
+	/*
+	 * Count the response as query_send() and client_send() would.
+	 */
+	if ((flags & DNS_MESSAGEFLAG_AA) == 0)
+		counter = dns_nsstatscounter_nonauthans;
+	else
+		counter = dns_nsstatscounter_authans;
+	isc_stats_increment(ns_g_server->nsstats, counter);
+	if (rcode == dns_rcode_nxdomain)
+		counter = dns_nsstatscounter_nxdomain;
+	else if (ancount != 0)
+		counter = dns_nsstatscounter_success;
+	else if ((flags & DNS_MESSAGEFLAG_AA) == 0)
+		counter = dns_nsstatscounter_referral;
+	else
+		counter = dns_nsstatscounter_nxrrset;
+	isc_stats_increment(ns_g_server->nsstats, counter);
+
+	if (TCP_CLIENT(client)) {
+		isc_buffer_putuint16(&tcpbuffer, (isc_uint16_t)r.length);
+		isc_buffer_add(&tcpbuffer, r.length);
+		result = client_sendpkg(client, &tcpbuffer);
+		if (isc_sockaddr_pf(&client->peeraddr) == AF_INET)
+			outstats = ns_g_server->tcpoutstats4;
+		else
+			outstats = ns_g_server->tcpoutstats6;
+	} else {
+		result = client_sendpkg(client, &buffer);
+		if (isc_sockaddr_pf(&client->peeraddr) == AF_INET)
+			outstats = ns_g_server->udpoutstats4;
+		else
+			outstats = ns_g_server->udpoutstats6;
+	}
+	isc_stats_increment(outstats, ISC_MIN((int)respsize / 16, 256));
+
+	isc_stats_increment(ns_g_server->nsstats, dns_nsstatscounter_response);
+	dns_rcodestats_increment(ns_g_server->rcodestats, rcode);
+	if ((client->attributes & NS_CLIENTATTR_WANTOPT) != 0) {
+		isc_stats_increment(ns_g_server->nsstats,
+				    dns_nsstatscounter_edns0out);
+	}
+
+	if (result != ISC_R_SUCCESS) {
+		if (client->tcpbuf != NULL) {
+			isc_mem_put(client->mctx, client->tcpbuf,
+				    TCP_BUFFER_SIZE);
+			client->tcpbuf = NULL;
+		}
+		ns_client_next(client, result);
+	}
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Store a rendered response in the view's response cache if
+ * query processing found nothing that would stop it from being
+ * sent in reply to the same query again.
+ */
+static void
+client_cacheresponse(ns_client_t *client, isc_buffer_t *buffer) {
+	dns_message_t *message = client->message;
+	dns_name_t *qname = client->query.origqname;
+	isc_region_t r;
+
+	if ((message->flags & DNS_MESSAGEFLAG_TC) != 0 ||
+	    (message->rcode != dns_rcode_noerror &&
+	     message->rcode != dns_rcode_nxdomain))
+		return;
+
+	/*
+	 * Only a response built from a single zone can be tracked.
+	 */
+	if (client->query.respcachezone == NULL)
+		return;
+
+	isc_buffer_usedregion(buffer, &r);
+	if (r.length < 12 + qname->length)
+		return;
+
+	dns_respcache_add(client->view->respcache, qname, client->query.qtype,
+			  client->query.respcachekey,
+			  client->query.respcachezone,
+			  client->query.respcachezonegen,
+			  client->query.respcachegen, &r);
+}
+
 static void
 client_send(ns_client_t *client) {
 	isc_result_t result;
@@ -1168,6 +1304,9 @@ client_send(ns_client_t *client) {
 	if (result != ISC_R_SUCCESS)
 		goto done;
 
+	if ((client->query.attributes & NS_QUERYATTR_RESPCACHE) != 0)
+		client_cacheresponse(client, &buffer);
+
 #ifdef HAVE_DNSTAP
 	memset(&zr, 0, sizeof(zr));
 	if (((client->message->flags & DNS_MESSAGEFLAG_AA) != 0) &&
@@ -2214,6 +2353,65 @@ process_opt(ns_client_t *client, dns_rdataset_t *opt) {
 	return (result);
 }
 
+/*
+ * Can the view and recursion ACL results for this request be reused
+ * for the next one from the same source?  Only when they depend on
+ * nothing but the addresses, the class and the RD bit: the request
+ * came over UDP, is unsigned and carries no EDNS Client Subnet option.
+ */
+static inline isc_boolean_t
+matchcache_usable(ns_client_t *client) {
+	dns_message_t *message = client->message;
+
+	return (ISC_TF(!TCP_CLIENT(client) &&
+		       (client->attributes & NS_CLIENTATTR_HAVEECS) == 0 &&
+		       message->tsigkey == NULL && message->tsig == NULL &&
+		       message->sig0 == NULL));
+}
+
+/*
+ * Has a view been matched for a request from 'netaddr' since the
+ * configuration or the set of interfaces last changed?
+ */
+static inline isc_boolean_t
+matchcache_source(ns_client_t *client, isc_netaddr_t *netaddr) {
+	return (ISC_TF(client->matchcache.view != NULL &&
+		       client->matchcache.gen == ns_g_server->matchgen &&
+		       isc_netaddr_equal(&client->matchcache.addr, netaddr)));
+}
+
+static inline isc_boolean_t
+matchcache_find(ns_client_t *client, isc_netaddr_t *netaddr) {
+	isc_boolean_t rd;
+
+	rd = ISC_TF((client->message->flags & DNS_MESSAGEFLAG_RD) != 0);
+	return (ISC_TF(matchcache_usable(client) &&
+		       matchcache_source(client, netaddr) &&
+		       client->matchcache.rdclass == client->message->rdclass &&
+		       client->matchcache.rd == rd &&
+		       isc_netaddr_equal(&client->matchcache.dest,
+					 &client->destaddr)));
+}
+
+static inline void
+matchcache_add(ns_client_t *client, isc_netaddr_t *netaddr,
+	       isc_boolean_t ra)
+{
+	if (!matchcache_usable(client)) {
+		client->matchcache.view = NULL;
+		return;
+	}
+
+	client->matchcache.addr = *netaddr;
+	client->matchcache.dest = client->destaddr;
+	client->matchcache.rdclass = client->message->rdclass;
+	client->matchcache.rd =
+		ISC_TF((client->message->flags & DNS_MESSAGEFLAG_RD) != 0);
+	client->matchcache.ra = ra;
+	client->matchcache.view = client->view;
+	client->matchcache.gen = ns_g_server->matchgen;
+}
+
 /*
  * Handle an incoming request event from the socket (UDP case)
  * or tcpmsg (TCP case).
@@ -2235,6 +2433,7 @@ client_request(isc_task_t *task, isc_event_t *event) {
 	dns_messageid_t id;
 	unsigned int flags;
 	isc_boolean_t notimp;
+	isc_boolean_t matched;
 	size_t reqsize;
 #ifdef HAVE_DNSTAP
 	dns_dtmsgtype_t dtmsgtype;
@@ -2342,9 +2541,10 @@ client_request(isc_task_t *task, isc_event_t *event) {
 
 	/*
 	 * Check the blackhole ACL for UDP only, since TCP is done in
-	 * client_newconn.
+	 * client_newconn.  A source that a view was just matched for
+	 * has already passed it.
 	 */
-	if (!TCP_CLIENT(client)) {
+	if (!TCP_CLIENT(client) && !matchcache_source(client, &netaddr)) {
 		if (ns_g_server->blackholeacl != NULL &&
 		    dns_acl_match(&netaddr, NULL, ns_g_server->blackholeacl,
 				  &ns_g_server->aclenv,
@@ -2600,41 +2800,53 @@ client_request(isc_task_t *task, isc_event_t *event) {
 	isc_sockaddr_fromnetaddr(&client->destsockaddr, &client->destaddr, 0);
 
 	/*
-	 * Find a view that matches the client's source address.
+	 * Find a view that matches the client's source address, unless
+	 * the previous request on this client already found it.
 	 */
-	for (view = ISC_LIST_HEAD(ns_g_server->viewlist);
-	     view != NULL;
-	     view = ISC_LIST_NEXT(view, link)) {
-		if (client->message->rdclass == view->rdclass ||
-		    client->message->rdclass == dns_rdataclass_any)
-		{
-			dns_name_t *tsig = NULL;
-			isc_netaddr_t *addr = NULL;
-			isc_uint8_t *scope = NULL;
+	matched = matchcache_find(client, &netaddr);
+	if (matched) {
+		view = client->matchcache.view;
+		dns_view_attach(view, &client->view);
+	} else {
+		for (view = ISC_LIST_HEAD(ns_g_server->viewlist);
+		     view != NULL;
+		     view = ISC_LIST_NEXT(view, link)) {
+			if (client->message->rdclass == view->rdclass ||
+			    client->message->rdclass == dns_rdataclass_any)
+			{
+				dns_name_t *tsig = NULL;
+				isc_netaddr_t *addr = NULL;
+				isc_uint8_t *scope = NULL;
 
-			sigresult = dns_message_rechecksig(client->message,
-							   view);
-			if (sigresult == ISC_R_SUCCESS) {
-				dns_tsigkey_t *tsigkey;
+				sigresult = dns_message_rechecksig(
+							client->message, view);
+				if (sigresult == ISC_R_SUCCESS) {
+					dns_tsigkey_t *tsigkey;
 
-				tsigkey = client->message->tsigkey;
-				tsig = dns_tsigkey_identity(tsigkey);
-			}
+					tsigkey = client->message->tsigkey;
+					tsig = dns_tsigkey_identity(tsigkey);
+				}
 
-			if ((client->attributes & NS_CLIENTATTR_HAVEECS) != 0) {
-				addr = &client->ecs_addr;
-				scope = &client->ecs_scope;
-			}
+				if ((client->attributes &
+				     NS_CLIENTATTR_HAVEECS) != 0)
+				{
+					addr = &client->ecs_addr;
+					scope = &client->ecs_scope;
+				}
 
-			if (allowed(&netaddr, tsig, addr, client->ecs_addrlen,
-				    scope, view->matchclients) &&
-			    allowed(&client->destaddr, tsig, NULL,
-				    0, NULL, view->matchdestinations) &&
-			    !(view->matchrecursiveonly &&
-			    (client->message->flags & DNS_MESSAGEFLAG_RD) == 0))
-			{
-				dns_view_attach(view, &client->view);
-				break;
+				if (allowed(&netaddr, tsig, addr,
+					    client->ecs_addrlen, scope,
+					    view->matchclients) &&
+				    allowed(&client->destaddr, tsig, NULL,
+					    0, NULL,
+					    view->matchdestinations) &&
+				    !(view->matchrecursiveonly &&
+				      (client->message->flags &
+				       DNS_MESSAGEFLAG_RD) == 0))
+				{
+					dns_view_attach(view, &client->view);
+					break;
+				}
 			}
 		}
 	}
@@ -2776,7 +2988,9 @@ client_request(isc_task_t *task, isc_event_t *event) {
 	 * cache there is no point in setting RA.
 	 */
 	ra = ISC_FALSE;
-	if (client->view->resolver != NULL &&
+	if (matched)
+		ra = client->matchcache.ra;
+	else if (client->view->resolver != NULL &&
 	    client->view->recursion == ISC_TRUE &&
 	    ns_client_checkaclsilent(client, NULL,
 				     client->view->recursionacl,
@@ -2792,6 +3006,9 @@ client_request(isc_task_t *task, isc_event_t *event) {
 				     ISC_TRUE) == ISC_R_SUCCESS)
 		ra = ISC_TRUE;
 
+	if (!matched)
+		matchcache_add(client, &netaddr, ra);
+
 	if (ra == ISC_TRUE)
 		client->attributes |= NS_CLIENTATTR_RA;
 
@@ -2955,7 +3172,8 @@ client_create(ns_clientmgr_t *manager, ns_client_t **clientp) {
 	client->mctx = mctx;
 
 	client->task = NULL;
-	result = isc_task_create(manager->taskmgr, 0, &client->task);
+	result = isc_task_create_bound(manager->taskmgr, 0, &client->task,
+				       manager->threadid);
 	if (result != ISC_R_SUCCESS)
 		goto cleanup_client;
 	isc_task_setname(client->task, "client", client);
@@ -3052,6 +3270,8 @@ client_create(ns_clientmgr_t *manager, ns_client_t **clientp) {
 	isc_sockaddr_any(&client->formerrcache.addr);
 	client->formerrcache.time = 0;
 	client->formerrcache.id = 0;
+	client->matchcache.view = NULL;
+	client->matchcache.gen = 0;
 	ISC_LINK_INIT(client, link);
 	ISC_LINK_INIT(client, rlink);
 	ISC_QLINK_INIT(client, ilink);
@@ -3393,7 +3613,8 @@ clientmgr_destroy(ns_clientmgr_t *manager) {
 
 isc_result_t
 ns_clientmgr_create(isc_mem_t *mctx, isc_taskmgr_t *taskmgr,
-		    isc_timermgr_t *timermgr, ns_clientmgr_t **managerp)
+		    isc_timermgr_t *timermgr, int threadid,
+		    ns_clientmgr_t **managerp)
 {
 	ns_clientmgr_t *manager;
 	isc_result_t result;
@@ -3420,6 +3641,7 @@ ns_clientmgr_create(isc_mem_t *mctx, isc_taskmgr_t *taskmgr,
 	manager->mctx = mctx;
 	manager->taskmgr = taskmgr;
 	manager->timermgr = timermgr;
+	manager->threadid = threadid;
 	manager->exiting = ISC_FALSE;
 	ISC_LIST_INIT(manager->clients);
 	ISC_LIST_INIT(manager->recursing);
@@ -3643,6 +3865,18 @@ ns_clientmgr_createclients(ns_clientmgr_t *manager, unsigned int n,
 	return (result);
 }
 
+isc_result_t
+ns_clientmgr_createudpclient(ns_clientmgr_t *manager, ns_interface_t *ifp,
+			     dns_dispatch_t *disp)
+{
+	REQUIRE(VALID_MANAGER(manager));
+	REQUIRE(disp != NULL);
+
+	MTRACE("createudpclient");
+
+	return (get_client(manager, ifp, disp, ISC_FALSE));
+}
+
 isc_sockaddr_t *
 ns_client_getsockaddr(ns_client_t *client) {
 	return (&client->peeraddr);
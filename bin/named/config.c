@@ -45,7 +45,8 @@ static char defaultconf[] = "\
 options {\n\
 	automatic-interface-scan yes;\n\
 	bindkeys-file \"" NS_SYSCONFDIR "/bind.keys\";\n\
-#	blackhole {none;};\n"
+#	blackhole {none;};\n\
+	cache-node-locks auto;\n"
 #if defined(HAVE_OPENSSL_AES) || defined(HAVE_OPENSSL_EVP_AES)
 "	cookie-algorithm aes;\n"
 #else
@@ -93,6 +94,7 @@ options {\n\
 	recursive-clients 1000;\n\
 	request-nsid false;\n\
 	reserved-sockets 512;\n\
+	reuseport no;\n\
 	resolver-query-timeout 10;\n\
 	rrset-order { order random; };\n\
 	secroots-file \"named.secroots\";\n\
@@ -118,14 +120,16 @@ options {\n\
 	transfers-in 10;\n\
 	transfers-out 10;\n\
 	transfers-per-ns 2;\n\
+	udp-batch-size 0;\n\
 #	treat-cr-as-space <obsolete>;\n\
 	trust-anchor-telemetry yes;\n\
 #	use-id-pool <obsolete>;\n\
 #	use-ixfr <obsolete>;\n\
+	zone-node-locks auto;\n\
 \n\
 	/* view */\n\
-	acache-cleaning-interval 60;\n\
-	acache-enable no;\n\
+#	acache-cleaning-interval <obsolete>;\n\
+#	acache-enable <obsolete>;\n\
 	additional-from-auth true;\n\
 	additional-from-cache true;\n\
 	allow-new-zones no;\n\
@@ -164,17 +168,19 @@ options {\n\
 #ifdef HAVE_GEOIP
 "	geoip-use-ecs yes;\n"
 #endif
-"	lame-ttl 600;\n"
+"	glue-cache yes;\n\
+	lame-ttl 600;\n"
 #ifdef HAVE_LMDB
 "	lmdb-mapsize 32M;\n"
 #endif
-"	max-acache-size 16M;\n\
+"#	max-acache-size <obsolete>;\n\
 	max-cache-size 90%;\n\
 	max-cache-ttl 604800; /* 1 week */\n\
 	max-clients-per-query 100;\n\
 	max-ncache-ttl 10800; /* 3 hours */\n\
 	max-recursion-depth 7;\n\
 	max-recursion-queries 75;\n\
+	max-stale-ttl 604800; /* 1 week */\n\
 	message-compression yes;\n\
 #	min-roots <obsolete>;\n\
 	minimal-any false;\n\
@@ -189,9 +195,14 @@ options {\n\
 	request-expire true;\n\
 	request-ixfr true;\n\
 	require-server-cookie no;\n\
+	response-cache-size 0;\n\
 #	rfc2308-type1 <obsolete>;\n\
 	servfail-ttl 1;\n\
 #	sortlist <none>\n\
+	stale-answer-client-timeout 1800; /* 1.8 seconds */\n\
+	stale-answer-enable false;\n\
+	stale-answer-ttl 1; /* 1 second */\n\
+	stale-refresh-time 30; /* 30 seconds */\n\
 #	topology <none>\n\
 	transfer-format many-answers;\n\
 	v6-bias 50;\n\
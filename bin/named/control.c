@@ -206,6 +206,8 @@ ns_control_docommand(isccc_sexpr_t *message, isc_boolean_t readonly,
 		result = ns_server_dumpstats(ns_g_server);
 	} else if (command_compare(command, NS_COMMAND_QUERYLOG)) {
 		result = ns_server_togglequerylog(ns_g_server, lex);
+	} else if (command_compare(command, NS_COMMAND_TASKSTATS)) {
+		result = ns_server_toggletaskstats(ns_g_server, lex);
 	} else if (command_compare(command, NS_COMMAND_DUMPDB)) {
 		ns_server_dumpdb(ns_g_server, lex, text);
 		result = ISC_R_SUCCESS;
@@ -219,6 +221,8 @@ ns_control_docommand(isccc_sexpr_t *message, isc_boolean_t readonly,
 		result = ISC_R_SUCCESS;
 	} else if (command_compare(command, NS_COMMAND_FLUSH)) {
 		result = ns_server_flushcache(ns_g_server, lex);
+	} else if (command_compare(command, NS_COMMAND_SAVECACHE)) {
+		result = ns_server_savecache(ns_g_server, lex);
 	} else if (command_compare(command, NS_COMMAND_FLUSHNAME)) {
 		result = ns_server_flushnode(ns_g_server, lex, ISC_FALSE);
 	} else if (command_compare(command, NS_COMMAND_FLUSHTREE)) {
@@ -158,6 +158,23 @@ struct ns_client {
 		dns_messageid_t		id;
 	} formerrcache;
 
+	/*%
+	 * The view matched for the most recent unsigned UDP request
+	 * without an ECS option, and whether it was offered recursion,
+	 * so that further requests from the same source can skip the
+	 * blackhole, view and recursion ACL checks.  Only valid while
+	 * 'gen' equals ns_g_server->matchgen; 'view' is not attached.
+	 */
+	struct {
+		isc_netaddr_t		addr;
+		isc_netaddr_t		dest;
+		dns_rdataclass_t	rdclass;
+		isc_boolean_t		rd;
+		isc_boolean_t		ra;
+		dns_view_t		*view;
+		unsigned int		gen;
+	} matchcache;
+
 	ISC_LINK(ns_client_t)	link;
 	ISC_LINK(ns_client_t)	rlink;
 	ISC_QLINK(ns_client_t)	ilink;
@@ -229,6 +246,18 @@ ns_client_sendraw(ns_client_t *client, dns_message_t *msg);
  * send msg as a response using client->message->id for the id.
  */
 
+isc_result_t
+ns_client_sendcached(ns_client_t *client, dns_respcache_t *respcache,
+		     dns_name_t *qname, dns_rdatatype_t qtype,
+		     isc_uint32_t key);
+/*%
+ * If 'respcache' holds a response to the current request for 'qname'
+ * and 'qtype' with key 'key' that fits the client's buffer, finish
+ * processing the request by sending it with the ID and the question
+ * name taken from the request.  Otherwise return ISC_R_NOTFOUND and
+ * do nothing.
+ */
+
 void
 ns_client_error(ns_client_t *client, isc_result_t result);
 /*%
@@ -278,9 +307,13 @@ ns_client_settimeout(ns_client_t *client, unsigned int seconds);
 
 isc_result_t
 ns_clientmgr_create(isc_mem_t *mctx, isc_taskmgr_t *taskmgr,
-		    isc_timermgr_t *timermgr, ns_clientmgr_t **managerp);
+		    isc_timermgr_t *timermgr, int threadid,
+		    ns_clientmgr_t **managerp);
 /*%
- * Create a client manager.
+ * Create a client manager.  If 'threadid' is not negative, the tasks
+ * of its clients are bound to that worker thread of 'taskmgr', so that
+ * the clients and the memory contexts they share are mostly used from
+ * that worker (see isc_task_create_bound()).
  */
 
 void
@@ -299,6 +332,15 @@ ns_clientmgr_createclients(ns_clientmgr_t *manager, unsigned int n,
  * otherwise for UDP requests.
  */
 
+isc_result_t
+ns_clientmgr_createudpclient(ns_clientmgr_t *manager, ns_interface_t *ifp,
+			     dns_dispatch_t *disp);
+/*%
+ * Create a single client listening for UDP requests on interface 'ifp'
+ * through the dispatch 'disp'.  This is used when each UDP listener of
+ * an interface has a client manager of its own.
+ */
+
 isc_sockaddr_t *
 ns_client_getsockaddr(ns_client_t *client);
 /*%
@@ -56,6 +56,8 @@
 #define NS_INTERFACE_VALID(t)	ISC_MAGIC_VALID(t, IFACE_MAGIC)
 
 #define NS_INTERFACEFLAG_ANYADDR	0x01U	/*%< bound to "any" address */
+#define NS_INTERFACEFLAG_REUSEPORT	0x02U	/*%< one SO_REUSEPORT socket
+						     per UDP listener */
 #define MAX_UDP_DISPATCH 128		/*%< Maximum number of UDP dispatchers
 						     to start per interface */
 /*% The nameserver interface structure */
@@ -77,6 +79,10 @@ struct ns_interface {
 	int			ntcpcurrent;	/*%< Current ditto, locked */
 	int			nudpdispatch;	/*%< Number of UDP dispatches */
 	ns_clientmgr_t *	clientmgr;	/*%< Client manager. */
+	ns_clientmgr_t *	udpclientmgr[MAX_UDP_DISPATCH];
+						/*%< Per-listener client
+						     managers, used with
+						     NS_INTERFACEFLAG_REUSEPORT */
 	ISC_LINK(ns_interface_t) link;
 };
 
@@ -153,6 +159,28 @@ ns_interfacemgr_setlistenon6(ns_interfacemgr_t *mgr, ns_listenlist_t *value);
  * The previous IPv6 listen-on list is freed.
  */
 
+void
+ns_interfacemgr_setreuseport(ns_interfacemgr_t *mgr, isc_boolean_t value);
+/*%
+ * If 'value' is ISC_TRUE, interfaces opened from now on get one UDP
+ * socket per task manager worker, each bound with SO_REUSEPORT and
+ * served by its own dispatch and client manager, instead of several
+ * dispatches sharing a single socket.  Interfaces that are already
+ * listening are not affected.
+ */
+
+void
+ns_interfacemgr_setudpclients(ns_interfacemgr_t *mgr, unsigned int n);
+/*%
+ * Set the number of UDP client objects waiting for requests on each
+ * UDP dispatch of interfaces opened from now on to 'n', so that up to
+ * that many datagrams can be taken from a listening socket at once.
+ * Interfaces that are already listening are not affected.
+ *
+ * Requires:
+ *\li	'n' > 0.
+ */
+
 dns_aclenv_t *
 ns_interfacemgr_getaclenv(ns_interfacemgr_t *mgr);
 
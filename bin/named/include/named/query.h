@@ -48,10 +48,15 @@ struct ns_query {
 	isc_mutex_t			fetchlock;
 	dns_fetch_t *			fetch;
 	dns_fetch_t *			prefetch;
+	isc_timer_t *			staletimer;
 	dns_rpz_st_t *			rpz_st;
 	isc_bufferlist_t		namebufs;
 	ISC_LIST(ns_dbversion_t)	activeversions;
 	ISC_LIST(ns_dbversion_t)	freeversions;
+	isc_uint32_t			respcachekey;
+	isc_uint32_t			respcachegen;
+	dns_zone_t *			respcachezone;
+	isc_uint32_t			respcachezonegen;
 	dns_rdataset_t *		dns64_aaaa;
 	dns_rdataset_t *		dns64_sigaaaa;
 	isc_boolean_t *			dns64_aaaaok;
@@ -92,6 +97,8 @@ struct ns_query {
 #define NS_QUERYATTR_DNS64EXCLUDE	0x8000
 #define NS_QUERYATTR_RRL_CHECKED	0x10000
 #define NS_QUERYATTR_REDIRECT		0x20000
+#define NS_QUERYATTR_RESPCACHE		0x40000
+#define NS_QUERYATTR_STALETIMEOUT	0x80000
 
 isc_result_t
 ns_query_init(ns_client_t *client);
@@ -86,6 +86,7 @@ struct ns_server {
 
 	isc_boolean_t		flushonshutdown;
 	isc_boolean_t		log_queries;	/*%< For BIND 8 compatibility */
+	isc_boolean_t		cpu_affinity;	/*%< Threads bound to CPUs */
 
 	ns_cachelist_t		cachelist;	/*%< Possibly shared caches */
 	isc_stats_t *		nsstats;	/*%< Server stats */
@@ -107,8 +108,10 @@ struct ns_server {
 	ns_controls_t *		controls;	/*%< Control channels */
 	unsigned int		dispatchgen;
 	ns_dispatchlist_t	dispatches;
+	unsigned int		matchgen;	/*%< Bumped whenever the
+						  view a client matches
+						  may change */
 
-	dns_acache_t		*acache;
 
 	ns_statschannellist_t	statschannels;
 
@@ -207,7 +210,10 @@ enum {
 
 	dns_nsstatscounter_keytagopt = 56,
 
-	dns_nsstatscounter_max = 57
+	dns_nsstatscounter_trystale = 57,
+	dns_nsstatscounter_usedstale = 58,
+
+	dns_nsstatscounter_max = 59
 };
 
 /*%
@@ -576,6 +582,13 @@ ns_server_togglequerylog(ns_server_t *server, isc_lex_t *lex);
  * but can also be used as a toggle for backward comptibility.)
  */
 
+isc_result_t
+ns_server_toggletaskstats(ns_server_t *server, isc_lex_t *lex);
+/*%<
+ * Enable/disable collection of task latency statistics.  (Takes "on"
+ * or "off" argument; toggles without one.)
+ */
+
 /*%
  * Save the current NTAs for all views to files.
  */
@@ -619,6 +632,13 @@ ns_server_setdebuglevel(ns_server_t *server, isc_lex_t *lex);
 isc_result_t
 ns_server_flushcache(ns_server_t *server, isc_lex_t *lex);
 
+/*%
+ * Save the cache of the specified view, or of all views, to its
+ * cache-file as a snapshot.
+ */
+isc_result_t
+ns_server_savecache(ns_server_t *server, isc_lex_t *lex);
+
 /*%
  * Flush a particular name from the server's cache.  If 'tree' is false,
  * also flush the name from the ADB and badcache.  If 'tree' is true, also
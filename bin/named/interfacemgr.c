@@ -72,6 +72,8 @@ struct ns_interfacemgr {
 	dns_aclenv_t		aclenv;		/*%< Localhost/localnets ACLs */
 	ISC_LIST(ns_interface_t) interfaces;	/*%< List of interfaces. */
 	ISC_LIST(isc_sockaddr_t) listenon;
+	isc_boolean_t		reuseport;	/*%< Per-worker UDP sockets */
+	unsigned int		udpclients;	/*%< Clients per UDP dispatch */
 #ifdef USE_ROUTE_SOCKET
 	isc_task_t *		task;
 	isc_socket_t *		route;
@@ -191,6 +193,8 @@ ns_interfacemgr_create(isc_mem_t *mctx, isc_taskmgr_t *taskmgr,
 	mgr->generation = 1;
 	mgr->listenon4 = NULL;
 	mgr->listenon6 = NULL;
+	mgr->reuseport = ISC_FALSE;
+	mgr->udpclients = 1;
 
 	ISC_LIST_INIT(mgr->interfaces);
 	ISC_LIST_INIT(mgr->listenon);
@@ -361,7 +365,7 @@ ns_interface_create(ns_interfacemgr_t *mgr, isc_sockaddr_t *addr,
 		goto lock_create_failure;
 
 	result = ns_clientmgr_create(mgr->mctx, mgr->taskmgr,
-				     ns_g_timermgr,
+				     ns_g_timermgr, -1,
 				     &ifp->clientmgr);
 	if (result != ISC_R_SUCCESS) {
 		isc_log_write(IFMGR_COMMON_LOGARGS, ISC_LOG_ERROR,
@@ -370,8 +374,10 @@ ns_interface_create(ns_interfacemgr_t *mgr, isc_sockaddr_t *addr,
 		goto clientmgr_create_failure;
 	}
 
-	for (disp = 0; disp < MAX_UDP_DISPATCH; disp++)
+	for (disp = 0; disp < MAX_UDP_DISPATCH; disp++) {
 		ifp->udpdispatch[disp] = NULL;
+		ifp->udpclientmgr[disp] = NULL;
+	}
 
 	ifp->tcpsocket = NULL;
 
@@ -408,11 +414,90 @@ ns_interface_create(ns_interfacemgr_t *mgr, isc_sockaddr_t *addr,
 	return (ISC_R_UNEXPECTED);
 }
 
+static isc_result_t
+ns_interface_listenudp_reuseport(ns_interface_t *ifp, unsigned int attrs,
+				 unsigned int attrmask)
+{
+	isc_result_t result;
+	unsigned int n;
+	int disp;
+
+	/*
+	 * Open one SO_REUSEPORT socket per worker, each with a dispatch
+	 * and a client manager of its own, so that the kernel spreads
+	 * incoming queries over independent receive queues.  The clients
+	 * of socket n run on worker n, which "cpu-affinity" may bind to
+	 * a CPU, keeping their memory on that CPU's NUMA node.
+	 */
+	attrs |= DNS_DISPATCHATTR_REUSEPORT;
+	ifp->nudpdispatch = ISC_MIN(ns_g_cpus, MAX_UDP_DISPATCH);
+	for (disp = 0; disp < ifp->nudpdispatch; disp++) {
+		result = dns_dispatch_getudp(ifp->mgr->dispatchmgr,
+					     ns_g_socketmgr,
+					     ns_g_taskmgr, &ifp->addr,
+					     4096, UDPBUFFERS,
+					     32768, 8219, 8237,
+					     attrs, attrmask,
+					     &ifp->udpdispatch[disp]);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup;
+
+		result = ns_clientmgr_create(ifp->mgr->mctx,
+					     ifp->mgr->taskmgr,
+					     ns_g_timermgr, disp,
+					     &ifp->udpclientmgr[disp]);
+		if (result != ISC_R_SUCCESS) {
+			dns_dispatch_detach(&ifp->udpdispatch[disp]);
+			goto cleanup;
+		}
+	}
+
+	for (disp = 0; disp < ifp->nudpdispatch; disp++) {
+		for (n = 0; n < ifp->mgr->udpclients; n++) {
+			result = ns_clientmgr_createudpclient(
+						ifp->udpclientmgr[disp], ifp,
+						ifp->udpdispatch[disp]);
+			if (result != ISC_R_SUCCESS) {
+				UNEXPECTED_ERROR(__FILE__, __LINE__,
+						 "UDP ns_clientmgr_"
+						 "createudpclient(): %s",
+						 isc_result_totext(result));
+				goto cleanup;
+			}
+		}
+	}
+
+	ifp->flags |= NS_INTERFACEFLAG_REUSEPORT;
+	isc_log_write(IFMGR_COMMON_LOGARGS, ISC_LOG_INFO,
+		      "using %d UDP sockets on %s, one per worker thread",
+		      ifp->nudpdispatch, ifp->name);
+	return (ISC_R_SUCCESS);
+
+ cleanup:
+	/*
+	 * Release everything set up so far, including the dispatches
+	 * and client managers beyond the one that failed.
+	 */
+	for (disp = 0; disp < ifp->nudpdispatch; disp++) {
+		if (ifp->udpclientmgr[disp] != NULL)
+			ns_clientmgr_destroy(&ifp->udpclientmgr[disp]);
+		if (ifp->udpdispatch[disp] != NULL) {
+			dns_dispatch_changeattributes(ifp->udpdispatch[disp],
+						      0,
+						      DNS_DISPATCHATTR_NOLISTEN);
+			dns_dispatch_detach(&ifp->udpdispatch[disp]);
+		}
+	}
+	ifp->nudpdispatch = 0;
+	return (result);
+}
+
 static isc_result_t
 ns_interface_listenudp(ns_interface_t *ifp) {
 	isc_result_t result;
 	unsigned int attrs;
 	unsigned int attrmask;
+	unsigned int n;
 	int disp, i;
 
 	attrs = 0;
@@ -426,6 +511,23 @@ ns_interface_listenudp(ns_interface_t *ifp) {
 	attrmask |= DNS_DISPATCHATTR_UDP | DNS_DISPATCHATTR_TCP;
 	attrmask |= DNS_DISPATCHATTR_IPV4 | DNS_DISPATCHATTR_IPV6;
 
+	if (ifp->mgr->reuseport) {
+		result = ns_interface_listenudp_reuseport(ifp, attrs,
+							  attrmask);
+		if (result != ISC_R_NOTIMPLEMENTED) {
+			if (result != ISC_R_SUCCESS)
+				isc_log_write(IFMGR_COMMON_LOGARGS,
+					      ISC_LOG_ERROR,
+					      "could not listen on UDP "
+					      "socket: %s",
+					      isc_result_totext(result));
+			return (result);
+		}
+		isc_log_write(IFMGR_COMMON_LOGARGS, ISC_LOG_WARNING,
+			      "SO_REUSEPORT is not supported; "
+			      "sharing one UDP socket between listeners");
+	}
+
 	ifp->nudpdispatch = ISC_MIN(ns_g_udpdisp, MAX_UDP_DISPATCH);
 	for (disp = 0; disp < ifp->nudpdispatch; disp++) {
 		result = dns_dispatch_getudp_dup(ifp->mgr->dispatchmgr,
@@ -447,13 +549,16 @@ ns_interface_listenudp(ns_interface_t *ifp) {
 
 	}
 
-	result = ns_clientmgr_createclients(ifp->clientmgr, ifp->nudpdispatch,
-					    ifp, ISC_FALSE);
-	if (result != ISC_R_SUCCESS) {
-		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "UDP ns_clientmgr_createclients(): %s",
-				 isc_result_totext(result));
-		goto addtodispatch_failure;
+	for (n = 0; n < ifp->mgr->udpclients; n++) {
+		result = ns_clientmgr_createclients(ifp->clientmgr,
+						    ifp->nudpdispatch,
+						    ifp, ISC_FALSE);
+		if (result != ISC_R_SUCCESS) {
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "UDP ns_clientmgr_createclients(): %s",
+					 isc_result_totext(result));
+			goto addtodispatch_failure;
+		}
 	}
 
 	return (ISC_R_SUCCESS);
@@ -587,8 +692,13 @@ ns_interface_setup(ns_interfacemgr_t *mgr, isc_sockaddr_t *addr,
 
 void
 ns_interface_shutdown(ns_interface_t *ifp) {
+	int disp;
+
 	if (ifp->clientmgr != NULL)
 		ns_clientmgr_destroy(&ifp->clientmgr);
+	for (disp = 0; disp < ifp->nudpdispatch; disp++)
+		if (ifp->udpclientmgr[disp] != NULL)
+			ns_clientmgr_destroy(&ifp->udpclientmgr[disp]);
 }
 
 static void
@@ -1214,6 +1324,25 @@ ns_interfacemgr_setlistenon6(ns_interfacemgr_t *mgr, ns_listenlist_t *value) {
 	UNLOCK(&mgr->lock);
 }
 
+void
+ns_interfacemgr_setreuseport(ns_interfacemgr_t *mgr, isc_boolean_t value) {
+	REQUIRE(NS_INTERFACEMGR_VALID(mgr));
+
+	LOCK(&mgr->lock);
+	mgr->reuseport = value;
+	UNLOCK(&mgr->lock);
+}
+
+void
+ns_interfacemgr_setudpclients(ns_interfacemgr_t *mgr, unsigned int n) {
+	REQUIRE(NS_INTERFACEMGR_VALID(mgr));
+	REQUIRE(n > 0);
+
+	LOCK(&mgr->lock);
+	mgr->udpclients = n;
+	UNLOCK(&mgr->lock);
+}
+
 void
 ns_interfacemgr_dumprecursing(FILE *f, ns_interfacemgr_t *mgr) {
 	ns_interface_t *interface;
@@ -1221,8 +1350,14 @@ ns_interfacemgr_dumprecursing(FILE *f, ns_interfacemgr_t *mgr) {
 	LOCK(&mgr->lock);
 	interface = ISC_LIST_HEAD(mgr->interfaces);
 	while (interface != NULL) {
+		int disp;
+
 		if (interface->clientmgr != NULL)
 			ns_client_dumprecursing(f, interface->clientmgr);
+		for (disp = 0; disp < interface->nudpdispatch; disp++)
+			if (interface->udpclientmgr[disp] != NULL)
+				ns_client_dumprecursing(f,
+						interface->udpclientmgr[disp]);
 		interface = ISC_LIST_NEXT(interface, link);
 	}
 	UNLOCK(&mgr->lock);
@@ -322,7 +322,7 @@ usage(void) {
 		"[-E engine] [-f|-g]\n"
 		"             [-n number_of_cpus] [-p port] [-s] "
 		"[-S sockets] [-t chrootdir]\n"
-		"             [-u username] [-U listeners] "
+		"             [-u username] [-U listeners] [-W watchers] "
 		"[-m {usage|trace|record|size|mctx}]\n"
 		"usage: named [-v|-V]\n");
 }
@@ -528,7 +528,13 @@ parse_command_line(int argc, char *argv[]) {
 			break;
 		case 'M':
 			if (strcmp(isc_commandline_argument, "external") == 0)
-				isc_mem_defaultflags = 0;
+				isc_mem_defaultflags &= ~ISC_MEMFLAG_INTERNAL;
+			else if (strcmp(isc_commandline_argument,
+					"internal") == 0)
+				isc_mem_defaultflags |= ISC_MEMFLAG_INTERNAL;
+			else if (strcmp(isc_commandline_argument,
+					"threadcache") == 0)
+				isc_mem_defaultflags |= ISC_MEMFLAG_THREADCACHE;
 			break;
 		case 'm':
 			set_flags(isc_commandline_argument, mem_debug_flags,
@@ -733,6 +739,11 @@ parse_command_line(int argc, char *argv[]) {
 			printf("threads support is disabled\n");
 #endif
 			exit(0);
+		case 'W':
+			ns_g_sockwatchers = parse_int(isc_commandline_argument,
+						      "number of socket "
+						      "watcher threads");
+			break;
 		case 'x':
 			/* Obsolete. No longer in use. Ignore. */
 			break;
@@ -808,6 +819,15 @@ create_managers(void) {
 		      ISC_LOG_INFO, "using %u UDP listener%s per interface",
 		      ns_g_udpdisp, ns_g_udpdisp == 1 ? "" : "s");
 #endif
+#ifdef ISC_PLATFORM_USETHREADS
+	if (ns_g_sockwatchers == 0)
+		ns_g_sockwatchers = ns_g_cpus;
+	isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL, NS_LOGMODULE_SERVER,
+		      ISC_LOG_INFO, "using up to %u socket watcher thread%s",
+		      ns_g_sockwatchers, ns_g_sockwatchers == 1 ? "" : "s");
+#else
+	ns_g_sockwatchers = 1;
+#endif
 
 	result = isc_taskmgr_create(ns_g_mctx, ns_g_cpus, 0, &ns_g_taskmgr);
 	if (result != ISC_R_SUCCESS) {
@@ -825,7 +845,8 @@ create_managers(void) {
 		return (ISC_R_UNEXPECTED);
 	}
 
-	result = isc_socketmgr_create2(ns_g_mctx, &ns_g_socketmgr, maxsocks);
+	result = isc_socketmgr_create3(ns_g_mctx, &ns_g_socketmgr, maxsocks,
+				       ns_g_sockwatchers);
 	if (result != ISC_R_SUCCESS) {
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
 				 "isc_socketmgr_create() failed: %s",
@@ -19,6 +19,7 @@
 #include <isc/serial.h>
 #include <isc/stats.h>
 #include <isc/thread.h>
+#include <isc/timer.h>
 #include <isc/util.h>
 
 #include <dns/adb.h>
@@ -42,6 +43,7 @@
 #include <dns/rdatastruct.h>
 #include <dns/rdatatype.h>
 #include <dns/resolver.h>
+#include <dns/respcache.h>
 #include <dns/result.h>
 #include <dns/stats.h>
 #include <dns/tkey.h>
@@ -182,11 +184,6 @@ client_trace(ns_client_t *client, int level, const char *message) {
 #define SAVE(a, b) do { INSIST(a == NULL); a = b; b = NULL; } while (0)
 #define RESTORE(a, b) SAVE(a, b)
 
-typedef struct client_additionalctx {
-	ns_client_t *client;
-	dns_rdataset_t *rdataset;
-} client_additionalctx_t;
-
 static isc_result_t
 query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype);
 
@@ -348,6 +345,8 @@ ns_query_cancel(ns_client_t *client) {
 
 		client->query.fetch = NULL;
 	}
+	if (client->query.staletimer != NULL)
+		isc_timer_detach(&client->query.staletimer);
 	UNLOCK(&client->query.fetchlock);
 }
 
@@ -399,6 +398,8 @@ query_reset(ns_client_t *client, isc_boolean_t everything) {
 		dns_db_detach(&client->query.authdb);
 	if (client->query.authzone != NULL)
 		dns_zone_detach(&client->query.authzone);
+	if (client->query.respcachezone != NULL)
+		dns_zone_detach(&client->query.respcachezone);
 
 	if (client->query.dns64_aaaa != NULL)
 		query_putrdataset(client, &client->query.dns64_aaaa);
@@ -692,8 +693,10 @@ ns_query_init(ns_client_t *client) {
 		return (result);
 	client->query.fetch = NULL;
 	client->query.prefetch = NULL;
+	client->query.staletimer = NULL;
 	client->query.authdb = NULL;
 	client->query.authzone = NULL;
+	client->query.respcachezone = NULL;
 	client->query.authdbset = ISC_FALSE;
 	client->query.isreferral = ISC_FALSE;
 	client->query.dns64_aaaa = NULL;
@@ -796,6 +799,22 @@ query_validatezonedb(ns_client_t *client, dns_name_t *name,
 		return (DNS_R_REFUSED);
 	}
 
+	/*
+	 * The view's response cache only checks the view's ACLs, and
+	 * only holds answers which do not change between queries.
+	 */
+	if ((client->query.attributes & NS_QUERYATTR_RESPCACHE) != 0) {
+		queryacl = dns_zone_getqueryacl(zone);
+		queryonacl = dns_zone_getqueryonacl(zone);
+		if ((queryacl != NULL && queryacl != client->view->queryacl) ||
+		    (queryonacl != NULL &&
+		     queryonacl != client->view->queryonacl) ||
+		    dns_db_ispersistent(db))
+		{
+			client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
+		}
+	}
+
 	/*
 	 * If the zone has an ACL, we'll check it, otherwise
 	 * we use the view's "allow-query" ACL.  Each ACL is only checked
@@ -912,6 +931,30 @@ query_validatezonedb(ns_client_t *client, dns_name_t *name,
 	return (ISC_R_SUCCESS);
 }
 
+/*%
+ * Note that the response will be built from 'zone'.  The zone's
+ * response generation has to be read before its database is, so that
+ * any change made after that stops the response from being stored.
+ */
+static void
+query_respcachezone(ns_client_t *client, dns_zone_t *zone) {
+	isc_uint32_t gen;
+
+	if (client->query.respcachezone == zone)
+		return;
+
+	if (client->query.respcachezone == NULL) {
+		gen = dns_zone_getrespgen(zone);
+		if ((gen & 1) == 0) {
+			dns_zone_attach(zone, &client->query.respcachezone);
+			client->query.respcachezonegen = gen;
+			return;
+		}
+	}
+
+	client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
+}
+
 static inline isc_result_t
 query_getzonedb(ns_client_t *client, dns_name_t *name, dns_rdatatype_t qtype,
 		unsigned int options, dns_zone_t **zonep, dns_db_t **dbp,
@@ -937,8 +980,11 @@ query_getzonedb(ns_client_t *client, dns_name_t *name, dns_rdatatype_t qtype,
 
 	if (result == DNS_R_PARTIALMATCH)
 		partial = ISC_TRUE;
-	if (result == ISC_R_SUCCESS || result == DNS_R_PARTIALMATCH)
+	if (result == ISC_R_SUCCESS || result == DNS_R_PARTIALMATCH) {
+		if ((client->query.attributes & NS_QUERYATTR_RESPCACHE) != 0)
+			query_respcachezone(client, zone);
 		result = dns_zone_getdb(zone, &db);
+	}
 
 	if (result != ISC_R_SUCCESS)
 		goto fail;
@@ -958,6 +1004,11 @@ query_getzonedb(ns_client_t *client, dns_name_t *name, dns_rdatatype_t qtype,
 	return (ISC_R_SUCCESS);
 
  fail:
+	/*
+	 * Don't store a response which depends on a zone not being
+	 * found, loaded or allowed.
+	 */
+	client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
 	if (zone != NULL)
 		dns_zone_detach(&zone);
 	if (db != NULL)
@@ -1310,6 +1361,11 @@ query_getdb(ns_client_t *client, dns_name_t *name, dns_rdatatype_t qtype,
 	} else if (result == ISC_R_NOTFOUND) {
 		result = query_getcachedb(client, name, qtype, dbp, options);
 		*is_zonep = ISC_FALSE;
+		/*
+		 * Cached data may expire or be replaced at any time,
+		 * so a response built from it can't be reused.
+		 */
+		client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
 	}
 	return (result);
 }
@@ -1370,7 +1426,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 	dns_rdatatype_t type;
 	dns_clientinfomethods_t cm;
 	dns_clientinfo_t ci;
-	dns_rdatasetadditional_t additionaltype;
+	isc_boolean_t fromcache;
 
 	REQUIRE(NS_CLIENT_VALID(client));
 	REQUIRE(qtype != dns_rdatatype_any);
@@ -1394,7 +1450,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 	added_something = ISC_FALSE;
 	need_addname = ISC_FALSE;
 	zone = NULL;
-	additionaltype = dns_rdatasetadditional_fromauth;
+	fromcache = ISC_FALSE;
 
 	dns_clientinfomethods_init(&cm, ns_client_sourceip);
 	dns_clientinfo_init(&ci, client, NULL);
@@ -1467,7 +1523,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 	 */
 
  try_cache:
-	additionaltype = dns_rdatasetadditional_fromcache;
+	fromcache = ISC_TRUE;
 	result = query_getcachedb(client, name, qtype, &db, DNS_GETDB_NOLOG);
 	if (result != ISC_R_SUCCESS)
 		/*
@@ -1491,8 +1547,10 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 	dns_cache_updatestats(client->view->cache, result);
 	if (!WANTDNSSEC(client))
 		query_putrdataset(client, &sigrdataset);
-	if (result == ISC_R_SUCCESS)
+	if (result == ISC_R_SUCCESS) {
+		client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
 		goto found;
+	}
 
 	if (dns_rdataset_isassociated(rdataset))
 		dns_rdataset_disassociate(rdataset);
@@ -1529,7 +1587,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 
 	dns_db_attach(client->query.gluedb, &db);
 
-	additionaltype = dns_rdatasetadditional_fromglue;
+	fromcache = ISC_FALSE;
 	result = dns_db_findext(db, name, version, type,
 				client->query.dboptions | DNS_DBFIND_GLUEOK,
 				client->now, &node, fname, &cm, &ci,
@@ -1622,7 +1680,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 #ifdef ALLOW_FILTER_AAAA
 			have_a = ISC_TRUE;
 #endif
-			if (additionaltype == dns_rdatasetadditional_fromcache &&
+			if (fromcache &&
 			    (DNS_TRUST_PENDING(rdataset->trust) ||
 			     DNS_TRUST_GLUE(rdataset->trust)) &&
 			    !validate(client, db, fname, rdataset, sigrdataset))
@@ -1693,7 +1751,7 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 			      !dns_rdataset_isassociated(sigrdataset)))))
 				goto addname;
 #endif
-			if (additionaltype == dns_rdatasetadditional_fromcache &&
+			if (fromcache &&
 			    (DNS_TRUST_PENDING(rdataset->trust) ||
 			     DNS_TRUST_GLUE(rdataset->trust)) &&
 			    !validate(client, db, fname, rdataset, sigrdataset))
@@ -1766,552 +1824,13 @@ query_addadditional(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 		eresult = dns_rdataset_additionaldata(trdataset,
 						      query_addadditional,
 						      client);
-	}
-
- cleanup:
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional: cleanup");
-	query_putrdataset(client, &rdataset);
-	if (sigrdataset != NULL)
-		query_putrdataset(client, &sigrdataset);
-	if (fname != NULL)
-		query_releasename(client, &fname);
-	if (node != NULL)
-		dns_db_detachnode(db, &node);
-	if (db != NULL)
-		dns_db_detach(&db);
-	if (zone != NULL)
-		dns_zone_detach(&zone);
-
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional: done");
-	return (eresult);
-}
-
-static inline void
-query_discardcache(ns_client_t *client, dns_rdataset_t *rdataset_base,
-		   dns_rdatasetadditional_t additionaltype,
-		   dns_rdatatype_t type, dns_zone_t **zonep, dns_db_t **dbp,
-		   dns_dbversion_t **versionp, dns_dbnode_t **nodep,
-		   dns_name_t *fname)
-{
-	dns_rdataset_t *rdataset;
-
-	while  ((rdataset = ISC_LIST_HEAD(fname->list)) != NULL) {
-		ISC_LIST_UNLINK(fname->list, rdataset, link);
-		query_putrdataset(client, &rdataset);
-	}
-	if (*versionp != NULL)
-		dns_db_closeversion(*dbp, versionp, ISC_FALSE);
-	if (*nodep != NULL)
-		dns_db_detachnode(*dbp, nodep);
-	if (*dbp != NULL)
-		dns_db_detach(dbp);
-	if (*zonep != NULL)
-		dns_zone_detach(zonep);
-	(void)dns_rdataset_putadditional(client->view->acache, rdataset_base,
-					 additionaltype, type);
-}
-
-static inline isc_result_t
-query_iscachevalid(dns_zone_t *zone, dns_db_t *db, dns_db_t *db0,
-		   dns_dbversion_t *version)
-{
-	isc_result_t result = ISC_R_SUCCESS;
-	dns_dbversion_t *version_current = NULL;
-	dns_db_t *db_current = db0;
-
-	if (db_current == NULL) {
-		result = dns_zone_getdb(zone, &db_current);
-		if (result != ISC_R_SUCCESS)
-			return (result);
-	}
-	dns_db_currentversion(db_current, &version_current);
-	if (db_current != db || version_current != version) {
-		result = ISC_R_FAILURE;
-		goto cleanup;
-	}
-
- cleanup:
-	dns_db_closeversion(db_current, &version_current, ISC_FALSE);
-	if (db0 == NULL && db_current != NULL)
-		dns_db_detach(&db_current);
-
-	return (result);
-}
-
-static isc_result_t
-query_addadditional2(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
-	client_additionalctx_t *additionalctx = arg;
-	dns_rdataset_t *rdataset_base;
-	ns_client_t *client;
-	isc_result_t result, eresult;
-	dns_dbnode_t *node, *cnode;
-	dns_db_t *db, *cdb;
-	dns_name_t *fname, *mname0, cfname;
-	dns_rdataset_t *rdataset, *sigrdataset;
-	dns_rdataset_t *crdataset, *crdataset_next;
-	isc_buffer_t *dbuf;
-	isc_buffer_t b;
-	dns_dbversion_t *version, *cversion;
-	isc_boolean_t added_something, need_addname, needadditionalcache;
-	isc_boolean_t need_sigrrset;
-	dns_zone_t *zone;
-	dns_rdatatype_t type;
-	dns_rdatasetadditional_t additionaltype;
-	dns_clientinfomethods_t cm;
-	dns_clientinfo_t ci;
-
-	/*
-	 * If we don't have an additional cache call query_addadditional.
-	 */
-	client = additionalctx->client;
-	REQUIRE(NS_CLIENT_VALID(client));
-
-	if (qtype != dns_rdatatype_a || client->view->acache == NULL) {
-		/*
-		 * This function is optimized for "address" types.  For other
-		 * types, use a generic routine.
-		 * XXX: ideally, this function should be generic enough.
-		 */
-		return (query_addadditional(additionalctx->client,
-					    name, qtype));
-	}
-
-	/*
-	 * Initialization.
-	 */
-	rdataset_base = additionalctx->rdataset;
-	eresult = ISC_R_SUCCESS;
-	fname = NULL;
-	rdataset = NULL;
-	sigrdataset = NULL;
-	db = NULL;
-	cdb = NULL;
-	version = NULL;
-	cversion = NULL;
-	node = NULL;
-	cnode = NULL;
-	added_something = ISC_FALSE;
-	need_addname = ISC_FALSE;
-	zone = NULL;
-	needadditionalcache = ISC_FALSE;
-	POST(needadditionalcache);
-	additionaltype = dns_rdatasetadditional_fromauth;
-	dns_name_init(&cfname, NULL);
-	dns_clientinfomethods_init(&cm, ns_client_sourceip);
-	dns_clientinfo_init(&ci, client, NULL);
-
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2");
-
-	/*
-	 * We treat type A additional section processing as if it
-	 * were "any address type" additional section processing.
-	 * To avoid multiple lookups, we do an 'any' database
-	 * lookup and iterate over the node.
-	 * XXXJT: this approach can cause a suboptimal result when the cache
-	 * DB only has partial address types and the glue DB has remaining
-	 * ones.
-	 */
-	type = dns_rdatatype_any;
-
-	/*
-	 * Get some resources.
-	 */
-	dbuf = query_getnamebuf(client);
-	if (dbuf == NULL)
-		goto cleanup;
-	fname = query_newname(client, dbuf, &b);
-	if (fname == NULL)
-		goto cleanup;
-	dns_name_setbuffer(&cfname, &b); /* share the buffer */
-
-	/* Check additional cache */
-	result = dns_rdataset_getadditional(rdataset_base, additionaltype,
-					    type, client->view->acache, &zone,
-					    &cdb, &cversion, &cnode, &cfname,
-					    client->message, client->now);
-	if (result != ISC_R_SUCCESS)
-		goto findauthdb;
-	if (zone == NULL) {
-		CTRACE(ISC_LOG_DEBUG(3),
-		       "query_addadditional2: auth zone not found");
-		goto try_cache;
-	}
-
-	/* Is the cached DB up-to-date? */
-	result = query_iscachevalid(zone, cdb, NULL, cversion);
-	if (result != ISC_R_SUCCESS) {
-		CTRACE(ISC_LOG_DEBUG(3),
-		       "query_addadditional2: old auth additional cache");
-		query_discardcache(client, rdataset_base, additionaltype,
-				   type, &zone, &cdb, &cversion, &cnode,
-				   &cfname);
-		goto findauthdb;
-	}
-
-	if (cnode == NULL) {
-		/*
-		 * We have a negative cache.  We don't have to check the zone
-		 * ACL, since the result (not using this zone) would be same
-		 * regardless of the result.
-		 */
-		CTRACE(ISC_LOG_DEBUG(3),
-		       "query_addadditional2: negative auth additional cache");
-		dns_db_closeversion(cdb, &cversion, ISC_FALSE);
-		dns_db_detach(&cdb);
-		dns_zone_detach(&zone);
-		goto try_cache;
-	}
-
-	result = query_validatezonedb(client, name, qtype, DNS_GETDB_NOLOG,
-				      zone, cdb, NULL);
-	if (result != ISC_R_SUCCESS) {
-		query_discardcache(client, rdataset_base, additionaltype,
-				   type, &zone, &cdb, &cversion, &cnode,
-				   &cfname);
-		goto try_cache;
-	}
-
-	/* We've got an active cache. */
-	CTRACE(ISC_LOG_DEBUG(3),
-	       "query_addadditional2: auth additional cache");
-	dns_db_closeversion(cdb, &cversion, ISC_FALSE);
-	db = cdb;
-	node = cnode;
-	dns_name_clone(&cfname, fname);
-	query_keepname(client, fname, dbuf);
-	goto foundcache;
-
-	/*
-	 * Look for a zone database that might contain authoritative
-	 * additional data.
-	 */
- findauthdb:
-	result = query_getzonedb(client, name, qtype, DNS_GETDB_NOLOG,
-				 &zone, &db, &version);
-	if (result != ISC_R_SUCCESS) {
-		/* Cache the negative result */
-		(void)dns_rdataset_setadditional(rdataset_base, additionaltype,
-						 type, client->view->acache,
-						 NULL, NULL, NULL, NULL,
-						 NULL);
-		goto try_cache;
-	}
-
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2: db_find");
-
-	/*
-	 * Since we are looking for authoritative data, we do not set
-	 * the GLUEOK flag.  Glue will be looked for later, but not
-	 * necessarily in the same database.
-	 */
-	node = NULL;
-	result = dns_db_findext(db, name, version, type,
-				client->query.dboptions,
-				client->now, &node, fname, &cm, &ci,
-				NULL, NULL);
-	if (result == ISC_R_SUCCESS)
-		goto found;
-
-	/* Cache the negative result */
-	(void)dns_rdataset_setadditional(rdataset_base, additionaltype,
-					 type, client->view->acache, zone, db,
-					 version, NULL, fname);
-
-	if (node != NULL)
-		dns_db_detachnode(db, &node);
-	version = NULL;
-	dns_db_detach(&db);
-
-	/*
-	 * No authoritative data was found.  The cache is our next best bet.
-	 */
-
- try_cache:
-	additionaltype = dns_rdatasetadditional_fromcache;
-	result = query_getcachedb(client, name, qtype, &db, DNS_GETDB_NOLOG);
-	if (result != ISC_R_SUCCESS)
-		/*
-		 * Most likely the client isn't allowed to query the cache.
-		 */
-		goto try_glue;
-
-	result = dns_db_findext(db, name, version, type,
-				client->query.dboptions |
-				 DNS_DBFIND_GLUEOK | DNS_DBFIND_ADDITIONALOK,
-				client->now, &node, fname, &cm, &ci,
-				NULL, NULL);
-	if (result == ISC_R_SUCCESS)
-		goto found;
-
-	if (node != NULL)
-		dns_db_detachnode(db, &node);
-	dns_db_detach(&db);
-
- try_glue:
-	/*
-	 * No cached data was found.  Glue is our last chance.
-	 * RFC1035 sayeth:
-	 *
-	 *	NS records cause both the usual additional section
-	 *	processing to locate a type A record, and, when used
-	 *	in a referral, a special search of the zone in which
-	 *	they reside for glue information.
-	 *
-	 * This is the "special search".  Note that we must search
-	 * the zone where the NS record resides, not the zone it
-	 * points to, and that we only do the search in the delegation
-	 * case (identified by client->query.gluedb being set).
-	 */
-	if (client->query.gluedb == NULL)
-		goto cleanup;
-
-	/*
-	 * Don't poison caches using the bailiwick protection model.
-	 */
-	if (!dns_name_issubdomain(name, dns_db_origin(client->query.gluedb)))
-		goto cleanup;
-
-	/* Check additional cache */
-	additionaltype = dns_rdatasetadditional_fromglue;
-	result = dns_rdataset_getadditional(rdataset_base, additionaltype,
-					    type, client->view->acache, NULL,
-					    &cdb, &cversion, &cnode, &cfname,
-					    client->message, client->now);
-	if (result != ISC_R_SUCCESS)
-		goto findglue;
-
-	result = query_iscachevalid(zone, cdb, client->query.gluedb, cversion);
-	if (result != ISC_R_SUCCESS) {
-		CTRACE(ISC_LOG_DEBUG(3),
-		       "query_addadditional2: old glue additional cache");
-		query_discardcache(client, rdataset_base, additionaltype,
-				   type, &zone, &cdb, &cversion, &cnode,
-				   &cfname);
-		goto findglue;
-	}
-
-	if (cnode == NULL) {
-		/* We have a negative cache. */
-		CTRACE(ISC_LOG_DEBUG(3),
-		       "query_addadditional2: negative glue additional cache");
-		dns_db_closeversion(cdb, &cversion, ISC_FALSE);
-		dns_db_detach(&cdb);
-		goto cleanup;
-	}
-
-	/* Cache hit. */
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2: glue additional cache");
-	dns_db_closeversion(cdb, &cversion, ISC_FALSE);
-	db = cdb;
-	node = cnode;
-	dns_name_clone(&cfname, fname);
-	query_keepname(client, fname, dbuf);
-	goto foundcache;
-
- findglue:
-	dns_db_attach(client->query.gluedb, &db);
-	result = dns_db_findext(db, name, version, type,
-				client->query.dboptions | DNS_DBFIND_GLUEOK,
-				client->now, &node, fname, &cm, &ci,
-				NULL, NULL);
-	if (!(result == ISC_R_SUCCESS ||
-	      result == DNS_R_ZONECUT ||
-	      result == DNS_R_GLUE)) {
-		/* cache the negative result */
-		(void)dns_rdataset_setadditional(rdataset_base, additionaltype,
-						 type, client->view->acache,
-						 NULL, db, version, NULL,
-						 fname);
-		goto cleanup;
-	}
-
- found:
-	/*
-	 * We have found a DB node to iterate over from a DB.
-	 * We are going to look for address RRsets (i.e., A and AAAA) in the DB
-	 * node we've just found.  We'll then store the complete information
-	 * in the additional data cache.
-	 */
-	dns_name_clone(fname, &cfname);
-	query_keepname(client, fname, dbuf);
-	needadditionalcache = ISC_TRUE;
-
-	rdataset = query_newrdataset(client);
-	if (rdataset == NULL)
-		goto cleanup;
-
-	sigrdataset = query_newrdataset(client);
-	if (sigrdataset == NULL)
-		goto cleanup;
-
-	if (additionaltype == dns_rdatasetadditional_fromcache &&
-	    query_isduplicate(client, fname, dns_rdatatype_a, NULL))
-		goto aaaa_lookup;
-	/*
-	 * Find A RRset with sig RRset.  Even if we don't find a sig RRset
-	 * for a client using DNSSEC, we'll continue the process to make a
-	 * complete list to be cached.  However, we need to cancel the
-	 * caching when something unexpected happens, in order to avoid
-	 * caching incomplete information.
-	 */
-	result = dns_db_findrdataset(db, node, version, dns_rdatatype_a, 0,
-				     client->now, rdataset, sigrdataset);
-	/*
-	 * If we can't promote glue/pending from the cache to secure
-	 * then drop it.
-	 */
-	if (result == ISC_R_SUCCESS &&
-	    additionaltype == dns_rdatasetadditional_fromcache &&
-	    (DNS_TRUST_PENDING(rdataset->trust) ||
-	     DNS_TRUST_GLUE(rdataset->trust)) &&
-	    !validate(client, db, fname, rdataset, sigrdataset)) {
-		dns_rdataset_disassociate(rdataset);
-		if (dns_rdataset_isassociated(sigrdataset))
-			dns_rdataset_disassociate(sigrdataset);
-		result = ISC_R_NOTFOUND;
-	}
-	if (result == DNS_R_NCACHENXDOMAIN)
-		goto setcache;
-	if (result == DNS_R_NCACHENXRRSET) {
-		dns_rdataset_disassociate(rdataset);
-		if (dns_rdataset_isassociated(sigrdataset))
-			dns_rdataset_disassociate(sigrdataset);
-	}
-	if (result == ISC_R_SUCCESS) {
-		/* Remember the result as a cache */
-		ISC_LIST_APPEND(cfname.list, rdataset, link);
-		if (dns_rdataset_isassociated(sigrdataset)) {
-			ISC_LIST_APPEND(cfname.list, sigrdataset, link);
-			sigrdataset = query_newrdataset(client);
-		}
-		rdataset = query_newrdataset(client);
-		if (sigrdataset == NULL || rdataset == NULL) {
-			/* do not cache incomplete information */
-			goto foundcache;
-		}
-	}
-
- aaaa_lookup:
-	if (additionaltype == dns_rdatasetadditional_fromcache &&
-	    query_isduplicate(client, fname, dns_rdatatype_aaaa, NULL))
-		goto foundcache;
-	/* Find AAAA RRset with sig RRset */
-	result = dns_db_findrdataset(db, node, version, dns_rdatatype_aaaa,
-				     0, client->now, rdataset, sigrdataset);
-	/*
-	 * If we can't promote glue/pending from the cache to secure
-	 * then drop it.
-	 */
-	if (result == ISC_R_SUCCESS &&
-	    additionaltype == dns_rdatasetadditional_fromcache &&
-	    (DNS_TRUST_PENDING(rdataset->trust) ||
-	     DNS_TRUST_GLUE(rdataset->trust)) &&
-	    !validate(client, db, fname, rdataset, sigrdataset)) {
-		dns_rdataset_disassociate(rdataset);
-		if (dns_rdataset_isassociated(sigrdataset))
-			dns_rdataset_disassociate(sigrdataset);
-		result = ISC_R_NOTFOUND;
-	}
-	if (result == ISC_R_SUCCESS) {
-		ISC_LIST_APPEND(cfname.list, rdataset, link);
-		rdataset = NULL;
-		if (dns_rdataset_isassociated(sigrdataset)) {
-			ISC_LIST_APPEND(cfname.list, sigrdataset, link);
-			sigrdataset = NULL;
-		}
-	}
-
- setcache:
-	/*
-	 * Set the new result in the cache if required.  We do not support
-	 * caching additional data from a cache DB.
-	 */
-	if (needadditionalcache == ISC_TRUE &&
-	    (additionaltype == dns_rdatasetadditional_fromauth ||
-	     additionaltype == dns_rdatasetadditional_fromglue)) {
-		(void)dns_rdataset_setadditional(rdataset_base, additionaltype,
-						 type, client->view->acache,
-						 zone, db, version, node,
-						 &cfname);
-	}
-
- foundcache:
-	need_sigrrset = ISC_FALSE;
-	mname0 = NULL;
-	for (crdataset = ISC_LIST_HEAD(cfname.list);
-	     crdataset != NULL;
-	     crdataset = crdataset_next) {
-		dns_name_t *mname;
-
-		crdataset_next = ISC_LIST_NEXT(crdataset, link);
-
-		mname = NULL;
-		if (crdataset->type == dns_rdatatype_a ||
-		    crdataset->type == dns_rdatatype_aaaa) {
-			if (!query_isduplicate(client, fname, crdataset->type,
-					       &mname)) {
-				if (mname != fname) {
-					if (mname != NULL) {
-						/*
-						 * A different type of this name is
-						 * already stored in the additional
-						 * section.  We'll reuse the name.
-						 * Note that this should happen at most
-						 * once.  Otherwise, fname->link could
-						 * leak below.
-						 */
-						INSIST(mname0 == NULL);
-
-						query_releasename(client, &fname);
-						fname = mname;
-						mname0 = mname;
-					} else
-						need_addname = ISC_TRUE;
-				}
-				ISC_LIST_UNLINK(cfname.list, crdataset, link);
-				ISC_LIST_APPEND(fname->list, crdataset, link);
-				added_something = ISC_TRUE;
-				need_sigrrset = ISC_TRUE;
-			} else
-				need_sigrrset = ISC_FALSE;
-		} else if (crdataset->type == dns_rdatatype_rrsig &&
-			   need_sigrrset && WANTDNSSEC(client)) {
-			ISC_LIST_UNLINK(cfname.list, crdataset, link);
-			ISC_LIST_APPEND(fname->list, crdataset, link);
-			added_something = ISC_TRUE; /* just in case */
-			need_sigrrset = ISC_FALSE;
-		}
-	}
-
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2: addname");
-
-	/*
-	 * If we haven't added anything, then we're done.
-	 */
-	if (!added_something)
-		goto cleanup;
-
-	/*
-	 * We may have added our rdatasets to an existing name, if so, then
-	 * need_addname will be ISC_FALSE.  Whether we used an existing name
-	 * or a new one, we must set fname to NULL to prevent cleanup.
-	 */
-	if (need_addname)
-		dns_message_addname(client->message, fname,
-				    DNS_SECTION_ADDITIONAL);
-	fname = NULL;
+	}
 
  cleanup:
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2: cleanup");
-
-	if (rdataset != NULL)
-		query_putrdataset(client, &rdataset);
+	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional: cleanup");
+	query_putrdataset(client, &rdataset);
 	if (sigrdataset != NULL)
 		query_putrdataset(client, &sigrdataset);
-	while  ((crdataset = ISC_LIST_HEAD(cfname.list)) != NULL) {
-		ISC_LIST_UNLINK(cfname.list, crdataset, link);
-		query_putrdataset(client, &crdataset);
-	}
 	if (fname != NULL)
 		query_releasename(client, &fname);
 	if (node != NULL)
@@ -2321,16 +1840,66 @@ query_addadditional2(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
 	if (zone != NULL)
 		dns_zone_detach(&zone);
 
-	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional2: done");
+	CTRACE(ISC_LOG_DEBUG(3), "query_addadditional: done");
 	return (eresult);
 }
 
+static isc_result_t
+query_addoutofzone(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
+	ns_client_t *client = arg;
+
+	/*
+	 * The glue cache has already supplied the address records for
+	 * every name server within the delegating zone; look up the rest.
+	 */
+	if (dns_name_issubdomain(name, dns_db_origin(client->query.gluedb)))
+		return (ISC_R_SUCCESS);
+
+	return (query_addadditional(client, name, qtype));
+}
+
+static inline isc_boolean_t
+query_addglue(ns_client_t *client, dns_rdataset_t *rdataset) {
+	ns_dbversion_t *dbversion;
+	unsigned int options = 0;
+	isc_result_t result;
+
+	if (!client->view->use_glue_cache ||
+	    rdataset->type != dns_rdatatype_ns ||
+	    client->query.gluedb == NULL ||
+	    !dns_db_iszone(client->query.gluedb))
+		return (ISC_FALSE);
+
+#ifdef ALLOW_FILTER_AAAA
+	/*
+	 * The glue cache knows nothing about filter-aaaa.
+	 */
+	if (client->filter_aaaa != dns_aaaa_ok)
+		return (ISC_FALSE);
+#endif
+
+	dbversion = query_findversion(client, client->query.gluedb);
+	if (dbversion == NULL)
+		return (ISC_FALSE);
+
+	if (WANTDNSSEC(client))
+		options |= DNS_RDATASETADDGLUE_DNSSEC;
+
+	result = dns_rdataset_addglue(rdataset, dbversion->version, options,
+				      client->message);
+	if (result != ISC_R_SUCCESS)
+		return (ISC_FALSE);
+
+	CTRACE(ISC_LOG_DEBUG(3), "query_addglue: added glue");
+	(void)dns_rdataset_additionaldata(rdataset, query_addoutofzone,
+					  client);
+	return (ISC_TRUE);
+}
+
 static inline void
 query_addrdataset(ns_client_t *client, dns_name_t *fname,
 		  dns_rdataset_t *rdataset)
 {
-	client_additionalctx_t additionalctx;
-
 	/*
 	 * Add 'rdataset' and any pertinent additional data to
 	 * 'fname', a name in the response message for 'client'.
@@ -2349,15 +1918,20 @@ query_addrdataset(ns_client_t *client, dns_name_t *fname,
 	if (NOADDITIONAL(client))
 		return;
 
+	/*
+	 * Referrals from a zone database can take their glue from
+	 * the database's glue cache.
+	 */
+	if (query_addglue(client, rdataset))
+		return;
+
 	/*
 	 * Add additional data.
 	 *
 	 * We don't care if dns_rdataset_additionaldata() fails.
 	 */
-	additionalctx.client = client;
-	additionalctx.rdataset = rdataset;
-	(void)dns_rdataset_additionaldata(rdataset, query_addadditional2,
-					  &additionalctx);
+	(void)dns_rdataset_additionaldata(rdataset, query_addadditional,
+					  client);
 	CTRACE(ISC_LOG_DEBUG(3), "query_addrdataset: done");
 }
 
@@ -3319,6 +2893,7 @@ query_addbestns(ns_client_t *client) {
 			SAVE(zsigrdataset, sigrdataset);
 			version = NULL;
 			dns_db_attach(client->view->cachedb, &db);
+			client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
 			is_zone = ISC_FALSE;
 			goto db_find;
 		}
@@ -3921,7 +3496,7 @@ query_resume(isc_task_t *task, isc_event_t *event) {
 	dns_fetchevent_t *devent = (dns_fetchevent_t *)event;
 	dns_fetch_t *fetch = NULL;
 	ns_client_t *client;
-	isc_boolean_t fetch_canceled, client_shuttingdown;
+	isc_boolean_t fetch_canceled, fetch_completed, client_shuttingdown;
 	isc_result_t result;
 	isc_logcategory_t *logcategory = NS_LOGCATEGORY_QUERY_ERRORS;
 	int errorloglevel;
@@ -3939,6 +3514,8 @@ query_resume(isc_task_t *task, isc_event_t *event) {
 	REQUIRE(RECURSING(client));
 
 	LOCK(&client->query.fetchlock);
+	if (client->query.staletimer != NULL)
+		isc_timer_detach(&client->query.staletimer);
 	if (client->query.fetch != NULL) {
 		/*
 		 * This is the fetch we've been waiting for.
@@ -3963,6 +3540,12 @@ query_resume(isc_task_t *task, isc_event_t *event) {
 	client->query.attributes &= ~NS_QUERYATTR_RECURSING;
 	SAVE(fetch, devent->fetch);
 
+	/*
+	 * A fetch cancelled to give a stale answer has not finished,
+	 * so there is nothing to log about it.
+	 */
+	fetch_completed = ISC_TF(devent->result != ISC_R_CANCELED);
+
 	/*
 	 * If this client is shutting down, or this transaction
 	 * has timed out, do not resume the find.
@@ -3986,7 +3569,8 @@ query_resume(isc_task_t *task, isc_event_t *event) {
 				errorloglevel = ISC_LOG_DEBUG(2);
 			else
 				errorloglevel = ISC_LOG_DEBUG(4);
-			if (isc_log_wouldlog(ns_g_lctx, errorloglevel)) {
+			if (fetch_completed &&
+			    isc_log_wouldlog(ns_g_lctx, errorloglevel)) {
 				dns_resolver_logfetch(fetch, ns_g_lctx,
 						      logcategory,
 						      NS_LOGMODULE_QUERY,
@@ -4020,6 +3604,177 @@ prefetch_done(isc_task_t *task, isc_event_t *event) {
 	ns_client_detach(&client);
 }
 
+/*%
+ * Recursion failed, or recently failed for this name: if the view
+ * serves stale answers, arrange for the next cache lookup to return
+ * expired data.
+ */
+static isc_boolean_t
+query_trystale(ns_client_t *client) {
+	if (!client->view->staleanswersenable ||
+	    client->view->cachedb == NULL || !USECACHE(client))
+		return (ISC_FALSE);
+
+	client->query.dboptions |= DNS_DBFIND_STALEOK;
+	inc_stats(client, dns_nsstatscounter_trystale);
+	return (ISC_TRUE);
+}
+
+/*%
+ * A stale answer was given after recursion failed: for the next
+ * stale-refresh-time seconds, answer from the cache at once rather
+ * than trying again, by way of the SERVFAIL cache.
+ */
+static void
+query_stalerefresh(ns_client_t *client) {
+	isc_time_t expire;
+	isc_interval_t i;
+	isc_uint32_t flags = 0;
+
+	if (client->view->stalerefresh == 0)
+		return;
+
+	if ((client->message->flags & DNS_MESSAGEFLAG_CD) != 0)
+		flags = NS_FAILCACHE_CD;
+
+	isc_interval_set(&i, client->view->stalerefresh, 0);
+	if (isc_time_nowplusinterval(&expire, &i) == ISC_R_SUCCESS)
+		dns_badcache_add(client->view->failcache, client->query.qname,
+				 client->query.qtype, ISC_TRUE, flags,
+				 &expire);
+}
+
+/*%
+ * Does the cache hold expired data that would answer the query?
+ */
+static isc_boolean_t
+query_staleavailable(ns_client_t *client) {
+	dns_fixedname_t fixed;
+	dns_name_t *fname;
+	dns_dbnode_t *node = NULL;
+	dns_rdataset_t rdataset;
+	isc_boolean_t stale = ISC_FALSE;
+	isc_stdtime_t now;
+	isc_result_t result;
+
+	dns_fixedname_init(&fixed);
+	fname = dns_fixedname_name(&fixed);
+	dns_rdataset_init(&rdataset);
+	isc_stdtime_get(&now);
+
+	result = dns_db_find(client->view->cachedb, client->query.qname,
+			     NULL, client->query.qtype, DNS_DBFIND_STALEOK,
+			     now, &node, fname, &rdataset, NULL);
+	switch (result) {
+	case ISC_R_SUCCESS:
+	case DNS_R_CNAME:
+	case DNS_R_DNAME:
+	case DNS_R_NCACHENXDOMAIN:
+	case DNS_R_NCACHENXRRSET:
+		stale = ISC_TF(dns_rdataset_isassociated(&rdataset) &&
+			       (rdataset.attributes &
+				DNS_RDATASETATTR_STALE) != 0);
+		break;
+	default:
+		break;
+	}
+
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	if (node != NULL)
+		dns_db_detachnode(client->view->cachedb, &node);
+	return (stale);
+}
+
+/*%
+ * stale-answer-client-timeout has passed and the client is still
+ * waiting for recursion.  If there is stale data to answer with, hand
+ * the fetch over to a prefetch so that it goes on refreshing the
+ * cache, and cancel the client's own fetch: query_resume() then
+ * answers from the cache as it would after a resolver failure.
+ */
+static void
+query_staletimeout(isc_task_t *task, isc_event_t *event) {
+	ns_client_t *client = event->ev_arg;
+	ns_client_t *dummy = NULL;
+	dns_rdataset_t *tmprdataset;
+	isc_result_t result;
+
+	REQUIRE(NS_CLIENT_VALID(client));
+	REQUIRE(task == client->task);
+
+	isc_event_free(&event);
+
+	LOCK(&client->query.fetchlock);
+	if (client->query.staletimer != NULL)
+		isc_timer_detach(&client->query.staletimer);
+	if (client->query.fetch == NULL || client->query.prefetch != NULL ||
+	    !query_staleavailable(client))
+		goto unlock;
+
+	tmprdataset = query_newrdataset(client);
+	if (tmprdataset == NULL)
+		goto unlock;
+	ns_client_attach(client, &dummy);
+	result = dns_resolver_createfetch3(client->view->resolver,
+					   client->query.qname,
+					   client->query.qtype, NULL, NULL,
+					   NULL, NULL, 0,
+					   client->query.fetchoptions, 0, NULL,
+					   client->task, prefetch_done, client,
+					   tmprdataset, NULL,
+					   &client->query.prefetch);
+	if (result != ISC_R_SUCCESS) {
+		query_putrdataset(client, &tmprdataset);
+		ns_client_detach(&dummy);
+		goto unlock;
+	}
+
+	client->query.attributes |= NS_QUERYATTR_STALETIMEOUT;
+	dns_resolver_cancelfetch(client->query.fetch);
+
+ unlock:
+	UNLOCK(&client->query.fetchlock);
+}
+
+/*%
+ * Recursion for the client's query has started: if a stale answer
+ * could be used, only wait stale-answer-client-timeout milliseconds
+ * for the resolver before looking for one.
+ */
+static void
+query_setstaletimer(ns_client_t *client, dns_name_t *qname,
+		    dns_rdatatype_t qtype)
+{
+	isc_uint32_t timeout = client->view->staleanswerclienttimeout;
+	isc_interval_t interval;
+	isc_result_t result;
+
+	if (!client->view->staleanswersenable || timeout == 0 ||
+	    client->view->cachedb == NULL || !USECACHE(client) ||
+	    REDIRECT(client) || qtype != client->query.qtype ||
+	    !dns_name_equal(qname, client->query.qname))
+		return;
+	if (client->query.rpz_st != NULL &&
+	    (client->query.rpz_st->state & DNS_RPZ_RECURSING) != 0)
+		return;
+
+	isc_interval_set(&interval, timeout / 1000,
+			 (timeout % 1000) * 1000000);
+	LOCK(&client->query.fetchlock);
+	INSIST(client->query.staletimer == NULL);
+	result = isc_timer_create(ns_g_timermgr, isc_timertype_once,
+				  NULL, &interval, client->task,
+				  query_staletimeout, client,
+				  &client->query.staletimer);
+	UNLOCK(&client->query.fetchlock);
+	if (result != ISC_R_SUCCESS)
+		ns_client_log(client, NS_LOGCATEGORY_CLIENT,
+			      NS_LOGMODULE_QUERY, ISC_LOG_WARNING,
+			      "failed to start stale answer timer: %s",
+			      isc_result_totext(result));
+}
+
 static void
 query_prefetch(ns_client_t *client, dns_name_t *qname,
 	       dns_rdataset_t *rdataset)
@@ -4192,6 +3947,7 @@ query_recurse(ns_client_t *client, dns_rdatatype_t qtype, dns_name_t *qname,
 		 * is shutting down will not be destroyed until all the
 		 * events have been received.
 		 */
+		query_setstaletimer(client, qname, qtype);
 	} else {
 		query_putrdataset(client, &rdataset);
 		if (sigrdataset != NULL)
@@ -6326,6 +6082,11 @@ redirect(ns_client_t *client, dns_name_t *name, dns_rdataset_t *rdataset,
 	if (result != ISC_R_SUCCESS)
 		return (ISC_R_NOTFOUND);
 
+	/*
+	 * The response now depends on the redirect zone as well.
+	 */
+	client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
+
 	result = dns_zone_getdb(client->view->redirect, &db);
 	if (result != ISC_R_SUCCESS)
 		return (ISC_R_NOTFOUND);
@@ -6596,6 +6357,7 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 	dns_ttl_t ttl;
 	isc_boolean_t failcache;
 	isc_uint32_t flags;
+	isc_boolean_t stale_lookup;
 #ifdef WANT_QUERYTRACE
 	char mbuf[BUFSIZ];
 	char qbuf[DNS_NAME_FORMATSIZE];
@@ -6632,6 +6394,7 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 	resuming = ISC_FALSE;
 	is_zone = ISC_FALSE;
 	is_staticstub_zone = ISC_FALSE;
+	stale_lookup = ISC_FALSE;
 
 	dns_clientinfomethods_init(&cm, ns_client_sourceip);
 	dns_clientinfo_init(&ci, client, NULL);
@@ -6882,8 +6645,15 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 					       : "CD=0");
 			}
 			client->attributes |= NS_CLIENTATTR_NOSETFC;
-			QUERY_ERROR(DNS_R_SERVFAIL);
-			goto cleanup;
+			/*
+			 * Answer from stale data if there is any, rather
+			 * than trying again.
+			 */
+			if (!query_trystale(client)) {
+				QUERY_ERROR(DNS_R_SERVFAIL);
+				goto cleanup;
+			}
+			stale_lookup = ISC_TRUE;
 		}
 	}
 
@@ -7072,6 +6842,64 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 	if (!is_zone)
 		dns_cache_updatestats(client->view->cache, result);
 
+	if (ISC_UNLIKELY(stale_lookup) && is_zone) {
+		/*
+		 * The name turned out to be authoritative.
+		 */
+		stale_lookup = ISC_FALSE;
+		client->query.dboptions &= ~DNS_DBFIND_STALEOK;
+	} else if (ISC_UNLIKELY(stale_lookup)) {
+		char namebuf[DNS_NAME_FORMATSIZE];
+		char typename[DNS_RDATATYPE_FORMATSIZE];
+		isc_boolean_t timedout;
+
+		stale_lookup = ISC_FALSE;
+		client->query.dboptions &= ~DNS_DBFIND_STALEOK;
+		timedout = ISC_TF((client->query.attributes &
+				   NS_QUERYATTR_STALETIMEOUT) != 0);
+		client->query.attributes &= ~NS_QUERYATTR_STALETIMEOUT;
+
+		dns_name_format(client->query.qname, namebuf, sizeof(namebuf));
+		dns_rdatatype_format(qtype, typename, sizeof(typename));
+
+		switch (result) {
+		case ISC_R_SUCCESS:
+		case DNS_R_CNAME:
+		case DNS_R_DNAME:
+		case DNS_R_NCACHENXDOMAIN:
+		case DNS_R_NCACHENXRRSET:
+			break;
+		default:
+			/*
+			 * Anything else would have us recurse again.
+			 */
+			ns_client_log(client, NS_LOGCATEGORY_SERVE_STALE,
+				      NS_LOGMODULE_QUERY, ISC_LOG_INFO,
+				      "%s/%s: no stale answer available",
+				      namebuf, typename);
+			QUERY_ERROR(DNS_R_SERVFAIL);
+			goto cleanup;
+		}
+
+		if ((rdataset->attributes & DNS_RDATASETATTR_STALE) != 0) {
+			rdataset->ttl = client->view->staleanswerttl;
+			rdataset->attributes &= ~DNS_RDATASETATTR_PREFETCH;
+			if (sigrdataset != NULL &&
+			    dns_rdataset_isassociated(sigrdataset))
+				sigrdataset->ttl = client->view->staleanswerttl;
+			inc_stats(client, dns_nsstatscounter_usedstale);
+			ns_client_log(client, NS_LOGCATEGORY_SERVE_STALE,
+				      NS_LOGMODULE_QUERY, ISC_LOG_INFO,
+				      "%s/%s: %s, stale answer used",
+				      namebuf, typename,
+				      timedout ? "client timeout"
+				      : resuming ? "resolver failure"
+						 : "servfail cache hit");
+			if (resuming && !timedout)
+				query_stalerefresh(client);
+		}
+	}
+
  resume:
 	CTRACE(ISC_LOG_DEBUG(3), "query_find: resume");
 
@@ -7577,6 +7405,7 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 				SAVE(zrdataset, rdataset);
 				SAVE(zsigrdataset, sigrdataset);
 				dns_db_attach(client->view->cachedb, &db);
+				client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
 				is_zone = ISC_FALSE;
 				goto db_find;
 			}
@@ -8399,6 +8228,32 @@ query_find(ns_client_t *client, dns_fetchevent_t *event, dns_rdatatype_t qtype)
 			 "query_find: unexpected error after resuming: %s",
 			 isc_result_totext(result));
 		CTRACE(ISC_LOG_ERROR, errmsg);
+
+		/*
+		 * If recursion failed, look in the cache again, this time
+		 * for stale data.
+		 */
+		if (resuming && !is_zone && !REDIRECT(client) &&
+		    query_trystale(client))
+		{
+			query_putrdataset(client, &rdataset);
+			if (sigrdataset != NULL)
+				query_putrdataset(client, &sigrdataset);
+			if (fname != NULL)
+				query_releasename(client, &fname);
+			if (node != NULL)
+				dns_db_detachnode(db, &node);
+			if (db != NULL)
+				dns_db_detach(&db);
+			if (zone != NULL)
+				dns_zone_detach(&zone);
+			version = NULL;
+			dns_db_attach(client->view->cachedb, &db);
+			client->query.attributes &= ~NS_QUERYATTR_RESPCACHE;
+			authoritative = ISC_FALSE;
+			stale_lookup = ISC_TRUE;
+			goto db_find;
+		}
 		QUERY_ERROR(DNS_R_SERVFAIL);
 		goto cleanup;
 	}
@@ -9189,6 +9044,126 @@ log_queryerror(ns_client_t *client, isc_result_t result, int line, int level) {
 		      classp, sep2, typep, __FILE__, line);
 }
 
+/*%
+ * Return ISC_TRUE if nothing about this query or its view stops the
+ * response from being answered from, or stored in, the view's response
+ * cache: the response has to be the same for every client that sends
+ * the same question with the same flags over the same transport.
+ */
+static isc_boolean_t
+respcache_usable(ns_client_t *client) {
+	dns_view_t *view = client->view;
+	dns_message_t *message = client->message;
+	dns_rdataset_t *opt;
+
+	if (view->respcache == NULL)
+		return (ISC_FALSE);
+
+	/*
+	 * View features which involve the resolver or which tailor
+	 * the response to the client.
+	 */
+	if (view->recursion || view->rpzs != NULL || view->rrl != NULL ||
+	    view->dns64cnt != 0 || view->sortlist != NULL ||
+	    view->v4_aaaa != dns_aaaa_ok || view->v6_aaaa != dns_aaaa_ok ||
+	    view->dtenv != NULL || !ISC_LIST_EMPTY(view->dlz_searched))
+		return (ISC_FALSE);
+
+	/*
+	 * Signed queries get signed responses, and EDNS options
+	 * (cookies, NSID, client subnet, ...) may change the response.
+	 */
+	if (dns_message_gettsig(message, NULL) != NULL ||
+	    dns_message_getsig0(message, NULL) != NULL)
+		return (ISC_FALSE);
+
+	opt = dns_message_getopt(message);
+	if (opt != NULL) {
+		dns_rdata_t rdata = DNS_RDATA_INIT;
+
+		if (dns_rdataset_first(opt) != ISC_R_SUCCESS)
+			return (ISC_FALSE);
+		dns_rdataset_current(opt, &rdata);
+		if (rdata.length != 0)
+			return (ISC_FALSE);
+	}
+
+	return (ISC_TRUE);
+}
+
+/*%
+ * The response cache key: the request flags that change the response,
+ * and the class of buffer size the response has to fit in.
+ */
+static isc_uint32_t
+respcache_key(ns_client_t *client) {
+	isc_uint32_t key, sizeclass;
+
+	key = client->message->flags & (DNS_MESSAGEFLAG_RD |
+					DNS_MESSAGEFLAG_AD |
+					DNS_MESSAGEFLAG_CD);
+	if ((client->extflags & DNS_MESSAGEEXTFLAG_DO) != 0)
+		key |= 0x10000;
+
+	if (TCP(client))
+		sizeclass = 0;
+	else if (client->ednsversion < 0)
+		sizeclass = 1;
+	else if (client->udpsize <= 512U)
+		sizeclass = 2;
+	else if (client->udpsize <= 1232U)
+		sizeclass = 3;
+	else
+		sizeclass = 4;
+
+	return (key | (sizeclass << 17));
+}
+
+/*%
+ * Answer the query from the view's response cache if we can.  If not,
+ * remember whether the response may be stored there once it has been
+ * rendered.
+ */
+static isc_boolean_t
+query_respcache(ns_client_t *client, dns_rdatatype_t qtype) {
+	isc_result_t result;
+
+	if (!respcache_usable(client))
+		return (ISC_FALSE);
+
+	client->query.respcachekey = respcache_key(client);
+	client->query.respcachegen =
+		dns_respcache_generation(client->view->respcache);
+
+	/*
+	 * Check the view's ACLs as query_validatezonedb() would; if
+	 * they refuse the query, let query_find() do the refusing.
+	 */
+	if ((client->query.attributes & NS_QUERYATTR_QUERYOKVALID) == 0) {
+		result = ns_client_checkaclsilent(client, NULL,
+						  client->view->queryacl,
+						  ISC_TRUE);
+		if (result == ISC_R_SUCCESS)
+			client->query.attributes |= NS_QUERYATTR_QUERYOK;
+		client->query.attributes |= NS_QUERYATTR_QUERYOKVALID;
+	}
+	if ((client->query.attributes & NS_QUERYATTR_QUERYOK) == 0)
+		return (ISC_FALSE);
+	result = ns_client_checkaclsilent(client, &client->destaddr,
+					  client->view->queryonacl, ISC_TRUE);
+	if (result != ISC_R_SUCCESS)
+		return (ISC_FALSE);
+
+	result = ns_client_sendcached(client, client->view->respcache,
+				      client->query.qname, qtype,
+				      client->query.respcachekey);
+	if (result == ISC_R_SUCCESS)
+		return (ISC_TRUE);
+
+	client->query.attributes |= NS_QUERYATTR_RESPCACHE;
+	return (ISC_FALSE);
+}
+
 void
 ns_query_start(ns_client_t *client) {
 	isc_result_t result;
@@ -9400,6 +9375,12 @@ ns_query_start(ns_client_t *client) {
 	if ((message->flags & DNS_MESSAGEFLAG_AD) != 0)
 		client->attributes |= NS_CLIENTATTR_WANTAD;
 
+	/*
+	 * Reuse an earlier response to the same query if we have one.
+	 */
+	if (client->view->respcache != NULL && query_respcache(client, qtype))
+		return;
+
 	/*
 	 * This is an ordinary query.
 	 */
@@ -52,7 +52,6 @@
 
 #include <bind9/check.h>
 
-#include <dns/acache.h>
 #include <dns/adb.h>
 #include <dns/badcache.h>
 #include <dns/cache.h>
@@ -82,6 +81,7 @@
 #include <dns/rdataset.h>
 #include <dns/rdatastruct.h>
 #include <dns/resolver.h>
+#include <dns/respcache.h>
 #include <dns/rootns.h>
 #include <dns/rriterator.h>
 #include <dns/secalg.h>
@@ -1703,7 +1703,8 @@ static isc_boolean_t
 cache_sharable(dns_view_t *originview, dns_view_t *view,
 	       isc_boolean_t new_zero_no_soattl,
 	       unsigned int new_cleaning_interval,
-	       isc_uint64_t new_max_cache_size)
+	       isc_uint64_t new_max_cache_size,
+	       isc_uint32_t new_stale_ttl)
 {
 	/*
 	 * If the cache cannot even reused for the same view, it cannot be
@@ -1718,7 +1719,8 @@ cache_sharable(dns_view_t *originview, dns_view_t *view,
 	 */
 	if (dns_cache_getcleaninginterval(originview->cache) !=
 	    new_cleaning_interval ||
-	    dns_cache_getcachesize(originview->cache) != new_max_cache_size) {
+	    dns_cache_getcachesize(originview->cache) != new_max_cache_size ||
+	    dns_cache_getservestalettl(originview->cache) != new_stale_ttl) {
 		return (ISC_FALSE);
 	}
 
@@ -2265,6 +2267,8 @@ catz_addmodzone_taskaction(isc_task_t *task, isc_event_t *event0) {
 
 		/* Remove the zone from the zone table */
 		dns_zt_unmount(ev->view->zonetable, zone);
+		if (ev->view->respcache != NULL)
+			dns_respcache_invalidate(ev->view->respcache);
 		goto cleanup;
 	}
 
@@ -2332,6 +2336,8 @@ catz_delzone_taskaction(isc_task_t *task, isc_event_t *event0) {
 	}
 
 	CHECK(dns_zt_unmount(ev->view->zonetable, zone));
+	if (ev->view->respcache != NULL)
+		dns_respcache_invalidate(ev->view->respcache);
 	file = dns_zone_getfile(zone);
 	if (file != NULL)
 		isc_file_remove(file);
@@ -2498,8 +2504,6 @@ configure_catz_zone(dns_view_t *view, const cfg_obj_t *config,
 			RUNTIME_CHECK(tresult == ISC_R_SUCCESS);
 
 			dns_zone_setview(dnszone, view);
-			if (view->acache != NULL)
-				dns_zone_setacache(dnszone, view->acache);
 			dns_view_addzone(view, dnszone);
 
 			/*
@@ -3263,9 +3267,9 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 	unsigned int cleaning_interval;
 	size_t max_cache_size;
 	isc_uint32_t max_cache_size_percent = 0;
-	size_t max_acache_size;
 	size_t max_adb_size;
 	isc_uint32_t lame_ttl, fail_ttl;
+	isc_uint32_t max_stale_ttl;
 	dns_tsig_keyring_t *ring = NULL;
 	dns_view_t *pview = NULL;	/* Production view */
 	isc_mem_t *cmctx = NULL, *hmctx = NULL;
@@ -3330,50 +3334,24 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 	dns_view_setdstport(view, port);
 
 	/*
-	 * Create additional cache for this view and zones under the view
-	 * if explicitly enabled.
-	 * XXX950 default to on.
+	 * Create the response cache for this view if one was asked for.
 	 */
 	obj = NULL;
-	(void)ns_config_get(maps, "acache-enable", &obj);
-	if (obj != NULL && cfg_obj_asboolean(obj)) {
-		cmctx = NULL;
-		CHECK(isc_mem_create(0, 0, &cmctx));
-		CHECK(dns_acache_create(&view->acache, cmctx, ns_g_taskmgr,
-					ns_g_timermgr));
-		isc_mem_setname(cmctx, "acache", NULL);
-		isc_mem_detach(&cmctx);
-	}
-	if (view->acache != NULL) {
-		obj = NULL;
-		result = ns_config_get(maps, "acache-cleaning-interval", &obj);
-		INSIST(result == ISC_R_SUCCESS);
-		dns_acache_setcleaninginterval(view->acache,
-					       cfg_obj_asuint32(obj) * 60);
-
-		obj = NULL;
-		result = ns_config_get(maps, "max-acache-size", &obj);
-		INSIST(result == ISC_R_SUCCESS);
-		if (cfg_obj_isstring(obj)) {
-			str = cfg_obj_asstring(obj);
-			INSIST(strcasecmp(str, "unlimited") == 0);
-			max_acache_size = 0;
-		} else {
-			isc_resourcevalue_t value;
-			value = cfg_obj_asuint64(obj);
-			if (value > SIZE_MAX) {
-				cfg_obj_log(obj, ns_g_lctx,
-					    ISC_LOG_WARNING,
-					    "'max-acache-size "
-					    "%" ISC_PRINT_QUADFORMAT "u' "
-					    "is too large for this "
-					    "system; reducing to %lu",
-					    value, (unsigned long)SIZE_MAX);
-				value = SIZE_MAX;
-			}
-			max_acache_size = (size_t) value;
+	result = ns_config_get(maps, "response-cache-size", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	if (cfg_obj_asuint64(obj) != 0) {
+		isc_resourcevalue_t value = cfg_obj_asuint64(obj);
+		if (value > SIZE_MAX) {
+			cfg_obj_log(obj, ns_g_lctx, ISC_LOG_WARNING,
+				    "'response-cache-size "
+				    "%" ISC_PRINT_QUADFORMAT "u' "
+				    "is too large for this "
+				    "system; reducing to %lu",
+				    value, (unsigned long)SIZE_MAX);
+			value = SIZE_MAX;
 		}
-		dns_acache_setcachesize(view->acache, max_acache_size);
+		CHECK(dns_respcache_create(view->mctx, (size_t)value,
+					   &view->respcache));
 	}
 
 	CHECK(configure_view_acl(vconfig, config, ns_g_config,
@@ -3710,6 +3688,37 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 	if (view->maxncachettl > 7 * 24 * 3600)
 		view->maxncachettl = 7 * 24 * 3600;
 
+	/*
+	 * Serve-stale: expired cache data is only kept, for max-stale-ttl,
+	 * when it may be used.
+	 */
+	obj = NULL;
+	result = ns_config_get(maps, "stale-answer-enable", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->staleanswersenable = cfg_obj_asboolean(obj);
+
+	obj = NULL;
+	result = ns_config_get(maps, "max-stale-ttl", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	max_stale_ttl = cfg_obj_asuint32(obj);
+	if (!view->staleanswersenable)
+		max_stale_ttl = 0;
+
+	obj = NULL;
+	result = ns_config_get(maps, "stale-answer-ttl", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->staleanswerttl = cfg_obj_asuint32(obj);
+
+	obj = NULL;
+	result = ns_config_get(maps, "stale-answer-client-timeout", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->staleanswerclienttimeout = cfg_obj_asuint32(obj);
+
+	obj = NULL;
+	result = ns_config_get(maps, "stale-refresh-time", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->stalerefresh = cfg_obj_asuint32(obj);
+
 	/*
 	 * Configure the view's cache.
 	 *
@@ -3743,7 +3752,8 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 	nsc = cachelist_find(cachelist, cachename, view->rdclass);
 	if (nsc != NULL) {
 		if (!cache_sharable(nsc->primaryview, view, zero_no_soattl,
-				    cleaning_interval, max_cache_size)) {
+				    cleaning_interval, max_cache_size,
+				    max_stale_ttl)) {
 			isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
 				      NS_LOGMODULE_SERVER, ISC_LOG_ERROR,
 				      "views %s and %s can't share the cache "
@@ -3836,12 +3846,27 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 	result = ns_config_get(maps, "cache-file", &obj);
 	if (result == ISC_R_SUCCESS && strcmp(view->name, "_bind") != 0) {
 		CHECK(dns_cache_setfilename(cache, cfg_obj_asstring(obj)));
-		if (!reused_cache && !shared_cache)
-			CHECK(dns_cache_load(cache));
+		/*
+		 * A cache file that cannot be loaded only costs us a
+		 * cold start.
+		 */
+		if (!reused_cache && !shared_cache) {
+			result = dns_cache_load(cache);
+			if (result != ISC_R_SUCCESS)
+				isc_log_write(ns_g_lctx,
+					      NS_LOGCATEGORY_GENERAL,
+					      NS_LOGMODULE_SERVER,
+					      ISC_LOG_WARNING,
+					      "view '%s': loading cache-file "
+					      "'%s' failed: %s", view->name,
+					      cfg_obj_asstring(obj),
+					      isc_result_totext(result));
+		}
 	}
 
 	dns_cache_setcleaninginterval(cache, cleaning_interval);
 	dns_cache_setcachesize(cache, max_cache_size);
+	dns_cache_setservestalettl(cache, max_stale_ttl);
 
 	dns_cache_detach(&cache);
 
@@ -4287,6 +4312,11 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist,
 		view->additionalfromcache = ISC_TRUE;
 	}
 
+	obj = NULL;
+	result = ns_config_get(maps, "glue-cache", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->use_glue_cache = cfg_obj_asboolean(obj);
+
 	/*
 	 * Set "allow-query-cache", "allow-recursion", and
 	 * "allow-recursion-on" acls if configured in named.conf.
@@ -5560,8 +5590,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		 * new view.
 		 */
 		dns_zone_setview(zone, view);
-		if (view->acache != NULL)
-			dns_zone_setacache(zone, view->acache);
 	} else {
 		/*
 		 * We cannot reuse an existing zone, we have
@@ -5570,8 +5598,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		CHECK(dns_zonemgr_createzone(ns_g_server->zonemgr, &zone));
 		CHECK(dns_zone_setorigin(zone, origin));
 		dns_zone_setview(zone, view);
-		if (view->acache != NULL)
-			dns_zone_setacache(zone, view->acache);
 		CHECK(dns_zonemgr_managezone(ns_g_server->zonemgr, zone));
 		dns_zone_setstats(zone, ns_g_server->zonestats);
 	}
@@ -5630,8 +5656,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 			CHECK(dns_zone_create(&raw, mctx));
 			CHECK(dns_zone_setorigin(raw, origin));
 			dns_zone_setview(raw, view);
-			if (view->acache != NULL)
-				dns_zone_setacache(raw, view->acache);
 			dns_zone_setstats(raw, ns_g_server->zonestats);
 			CHECK(dns_zone_link(zone, raw));
 		}
@@ -5728,8 +5752,6 @@ add_keydata_zone(dns_view_t *view, const char *directory, isc_mem_t *mctx) {
 
 	CHECK(dns_zonemgr_managezone(ns_g_server->zonemgr, zone));
 
-	if (view->acache != NULL)
-		dns_zone_setacache(zone, view->acache);
 
 	CHECK(dns_acl_none(mctx, &none));
 	dns_zone_setqueryacl(zone, none);
@@ -5832,6 +5854,7 @@ scan_interfaces(ns_server_t *server, isc_boolean_t verbose) {
 #ifdef HAVE_GEOIP
 	server->aclenv.geoip_use_ecs = use_ecs;
 #endif
+	server->matchgen++;
 
 	return (result);
 }
@@ -7270,6 +7293,128 @@ check_lockfile(ns_server_t *server, const cfg_obj_t *config,
 	return (ISC_R_FAILURE);
 }
 
+/*
+ * Apply the "cpu-affinity" list 'obj' to the worker and socket watcher
+ * threads, and log the result.  If 'obj' is NULL, threads we bound
+ * before are allowed to run on any CPU again.
+ */
+static void
+configure_cpu_affinity(ns_server_t *server, const cfg_obj_t *obj) {
+	const cfg_listelt_t *element;
+	unsigned int *cpus = NULL;
+	unsigned int ncpus = 0, i;
+	isc_result_t result;
+	isc_buffer_t b;
+	char text[256];
+
+	for (element = cfg_list_first(obj);
+	     element != NULL;
+	     element = cfg_list_next(element))
+		ncpus++;
+
+	if (ncpus == 0 && !server->cpu_affinity)
+		return;
+
+	if (ncpus != 0) {
+		cpus = isc_mem_get(server->mctx, ncpus * sizeof(*cpus));
+		if (cpus == NULL) {
+			isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+				      NS_LOGMODULE_SERVER, ISC_LOG_WARNING,
+				      "cpu-affinity: out of memory");
+			return;
+		}
+		i = 0;
+		for (element = cfg_list_first(obj);
+		     element != NULL;
+		     element = cfg_list_next(element))
+			cpus[i++] = cfg_obj_asuint32(cfg_listelt_value(element));
+	}
+
+	result = isc_taskmgr_setaffinity(ns_g_taskmgr, cpus, ncpus);
+	if (result == ISC_R_SUCCESS)
+		result = isc__socketmgr_setaffinity(ns_g_socketmgr,
+						    cpus, ncpus);
+	if (result != ISC_R_SUCCESS) {
+		isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+			      NS_LOGMODULE_SERVER, ISC_LOG_WARNING,
+			      "cpu-affinity: unable to bind threads: %s",
+			      isc_result_totext(result));
+	} else if (ncpus == 0) {
+		isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+			      NS_LOGMODULE_SERVER, ISC_LOG_INFO,
+			      "worker and socket watcher threads may run "
+			      "on any CPU");
+	} else {
+		isc_buffer_init(&b, text, sizeof(text));
+		for (i = 0; i < ncpus; i++) {
+			if (isc_buffer_availablelength(&b) < 16) {
+				isc_buffer_putstr(&b, " ...");
+				break;
+			}
+			if (i != 0)
+				isc_buffer_putstr(&b, " ");
+			isc_buffer_putdecint(&b, cpus[i]);
+		}
+		isc_buffer_putuint8(&b, 0);
+		isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+			      NS_LOGMODULE_SERVER, ISC_LOG_INFO,
+			      "binding %u worker thread%s and up to %u "
+			      "socket watcher thread%s to CPUs %s "
+			      "(thread n on CPU n modulo %u)",
+			      ns_g_cpus, ns_g_cpus == 1 ? "" : "s",
+			      ns_g_sockwatchers,
+			      ns_g_sockwatchers == 1 ? "" : "s",
+			      text, ncpus);
+	}
+	server->cpu_affinity = ISC_TF(ncpus != 0 && result == ISC_R_SUCCESS);
+
+	if (cpus != NULL)
+		isc_mem_put(server->mctx, cpus, ncpus * sizeof(*cpus));
+}
+
+/*
+ * Return the smallest prime that is at least 'n'.
+ */
+static unsigned int
+nextprime(unsigned int n) {
+	unsigned int d;
+
+	if (n <= 2)
+		return (2);
+	for (n |= 1;; n += 2) {
+		for (d = 3; d * d <= n; d += 2)
+			if (n % d == 0)
+				break;
+		if (d * d > n)
+			return (n);
+	}
+}
+
+/*
+ * Set the number of node lock buckets of the cache (if 'type' is
+ * dns_dbtype_cache) or zone databases created from now on, from the
+ * "cache-node-locks" or "zone-node-locks" option 'obj'.  "auto" scales
+ * with the number of worker threads: caches are written to by every
+ * worker, so they get about four buckets per worker.
+ */
+static void
+configure_node_locks(const cfg_obj_t *obj, dns_dbtype_t type) {
+	unsigned int count;
+
+	if (cfg_obj_isuint32(obj))
+		count = cfg_obj_asuint32(obj);
+	else if (type == dns_dbtype_cache)
+		count = nextprime(ISC_MIN(ISC_MAX(16, 4 * ns_g_cpus), 1021));
+	else
+		count = nextprime(ISC_MIN(ISC_MAX(7, ns_g_cpus), 1021));
+
+	dns_db_setnodelockcount(type, count);
+	isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+		      NS_LOGMODULE_SERVER, ISC_LOG_DEBUG(1),
+		      "new %s databases use %u node locks",
+		      type == dns_dbtype_cache ? "cache" : "zone", count);
+}
+
 static isc_result_t
 load_configuration(const char *filename, ns_server_t *server,
 		   isc_boolean_t first_time)
@@ -7300,6 +7445,7 @@ load_configuration(const char *filename, ns_server_t *server,
 	isc_uint32_t heartbeat_interval;
 	isc_uint32_t interface_interval;
 	isc_uint32_t reserved;
+	isc_uint32_t udpbatch;
 	isc_uint32_t udpsize;
 	isc_uint32_t transfer_message_size;
 	ns_cache_t *nsc;
@@ -7485,6 +7631,46 @@ load_configuration(const char *filename, ns_server_t *server,
 	}
 	isc__socketmgr_setreserved(ns_g_socketmgr, reserved);
 
+	/*
+	 * Set the number of UDP datagrams serviced per system call.
+	 */
+	obj = NULL;
+	result = ns_config_get(maps, "udp-batch-size", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	udpbatch = cfg_obj_asuint32(obj);
+	isc__socketmgr_setudpbatch(ns_g_socketmgr, udpbatch);
+
+	/*
+	 * Keep enough UDP clients waiting on each listening socket for
+	 * a whole batch of requests to be received at once.
+	 */
+	if (udpbatch < 1U)
+		udpbatch = 1;
+	if (udpbatch > ISC_SOCKET_MAXBATCH)
+		udpbatch = ISC_SOCKET_MAXBATCH;
+	ns_interfacemgr_setudpclients(server->interfacemgr, udpbatch);
+
+	/*
+	 * Bind worker and socket watcher threads to CPUs.
+	 */
+	obj = NULL;
+	(void)ns_config_get(maps, "cpu-affinity", &obj);
+	configure_cpu_affinity(server, obj);
+
+	/*
+	 * Size the node locks of databases created from here on; this
+	 * must be done before the views create their caches.
+	 */
+	obj = NULL;
+	result = ns_config_get(maps, "cache-node-locks", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	configure_node_locks(obj, dns_dbtype_cache);
+
+	obj = NULL;
+	result = ns_config_get(maps, "zone-node-locks", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	configure_node_locks(obj, dns_dbtype_zone);
+
 #ifdef HAVE_GEOIP
 	/*
 	 * Initialize GeoIP databases from the configured location.
@@ -7708,6 +7894,16 @@ load_configuration(const char *filename, ns_server_t *server,
 		ns_g_listen = 10;
 	}
 
+	/*
+	 * Decide whether newly opened interfaces get one SO_REUSEPORT
+	 * UDP socket per worker thread.
+	 */
+	obj = NULL;
+	result = ns_config_get(maps, "reuseport", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	ns_interfacemgr_setreuseport(server->interfacemgr,
+				     cfg_obj_asboolean(obj));
+
 	/*
 	 * Configure the interface manager according to the "listen-on"
 	 * statement.
@@ -8014,6 +8210,7 @@ load_configuration(const char *filename, ns_server_t *server,
 	tmpviewlist = server->viewlist;
 	server->viewlist = viewlist;
 	viewlist = tmpviewlist;
+	server->matchgen++;
 
 	/* Make the view list available to each of the views */
 	view = ISC_LIST_HEAD(server->viewlist);
@@ -8708,6 +8905,7 @@ shutdown_server(isc_task_t *task, isc_event_t *event) {
 
 	(void) ns_server_saventa(server);
 
+	server->matchgen++;
 	for (view = ISC_LIST_HEAD(server->viewlist);
 	     view != NULL;
 	     view = view_next) {
@@ -8904,8 +9102,9 @@ ns_server_create(isc_mem_t *mctx, ns_server_t **serverp) {
 	server->server_usehostname = ISC_FALSE;
 	server->server_id = NULL;
 
-	CHECKFATAL(isc_stats_create(ns_g_mctx, &server->nsstats,
-				    dns_nsstatscounter_max),
+	CHECKFATAL(isc_stats_create2(ns_g_mctx, &server->nsstats,
+				     dns_nsstatscounter_max,
+				     ISC_STATSCREATE_SHARDED),
 		   "dns_stats_create (server)");
 
 	CHECKFATAL(dns_rdatatypestats_create(ns_g_mctx,
@@ -8960,12 +9159,14 @@ ns_server_create(isc_mem_t *mctx, ns_server_t **serverp) {
 
 	server->flushonshutdown = ISC_FALSE;
 	server->log_queries = ISC_FALSE;
+	server->cpu_affinity = ISC_FALSE;
 
 	server->controls = NULL;
 	CHECKFATAL(ns_controls_create(server, &server->controls),
 		   "ns_controls_create");
 	server->dispatchgen = 0;
 	ISC_LIST_INIT(server->dispatches);
+	server->matchgen = 0;
 
 	ISC_LIST_INIT(server->statschannels);
 
@@ -9624,6 +9825,43 @@ ns_server_togglequerylog(ns_server_t *server, isc_lex_t *lex) {
 	return (ISC_R_SUCCESS);
 }
 
+isc_result_t
+ns_server_toggletaskstats(ns_server_t *server, isc_lex_t *lex) {
+	isc_boolean_t value;
+	char *ptr;
+
+	UNUSED(server);
+
+	/* Skip the command name. */
+	ptr = next_token(lex, NULL);
+	if (ptr == NULL)
+		return (ISC_R_UNEXPECTEDEND);
+
+	ptr = next_token(lex, NULL);
+	if (ptr == NULL) {
+		value = !isc_taskmgr_latencystats(ns_g_taskmgr);
+	} else if (!strcasecmp(ptr, "on") || !strcasecmp(ptr, "yes") ||
+		   !strcasecmp(ptr, "enable") || !strcasecmp(ptr, "true")) {
+		value = ISC_TRUE;
+	} else if (!strcasecmp(ptr, "off") || !strcasecmp(ptr, "no") ||
+		   !strcasecmp(ptr, "disable") || !strcasecmp(ptr, "false")) {
+		value = ISC_FALSE;
+	} else {
+		return (DNS_R_SYNTAX);
+	}
+
+	if (isc_taskmgr_latencystats(ns_g_taskmgr) == value)
+		return (ISC_R_SUCCESS);
+
+	isc_taskmgr_setlatencystats(ns_g_taskmgr, value);
+
+	isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+		      NS_LOGMODULE_SERVER, ISC_LOG_INFO,
+		      "task latency statistics are now %s",
+		      value ? "on" : "off");
+	return (ISC_R_SUCCESS);
+}
+
 static isc_result_t
 ns_listenlist_fromconfig(const cfg_obj_t *listenlist, const cfg_obj_t *config,
 			 cfg_aclconfctx_t *actx, isc_mem_t *mctx,
@@ -10446,6 +10684,59 @@ ns_server_flushcache(ns_server_t *server, isc_lex_t *lex) {
 	return (result);
 }
 
+isc_result_t
+ns_server_savecache(ns_server_t *server, isc_lex_t *lex) {
+	char *ptr;
+	dns_view_t *view;
+	ns_cache_t *nsc;
+	isc_boolean_t found = ISC_FALSE;
+	isc_result_t result = ISC_R_SUCCESS, tresult;
+
+	/* Skip the command name. */
+	ptr = next_token(lex, NULL);
+	if (ptr == NULL)
+		return (ISC_R_UNEXPECTEDEND);
+
+	/* Look for the view name. */
+	ptr = next_token(lex, NULL);
+
+	/*
+	 * Caches shared by several views are only saved once.  Caches
+	 * without a cache-file are skipped by dns_cache_dump().
+	 */
+	for (nsc = ISC_LIST_HEAD(server->cachelist);
+	     nsc != NULL;
+	     nsc = ISC_LIST_NEXT(nsc, link))
+	{
+		if (ptr != NULL) {
+			for (view = ISC_LIST_HEAD(server->viewlist);
+			     view != NULL;
+			     view = ISC_LIST_NEXT(view, link))
+			{
+				if (view->cache == nsc->cache &&
+				    strcasecmp(ptr, view->name) == 0)
+					break;
+			}
+			if (view == NULL)
+				continue;
+		}
+		found = ISC_TRUE;
+		tresult = dns_cache_dump(nsc->cache);
+		if (tresult != ISC_R_SUCCESS)
+			result = tresult;
+	}
+
+	if (!found && ptr != NULL) {
+		isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL,
+			      NS_LOGMODULE_SERVER, ISC_LOG_ERROR,
+			      "saving cache in view '%s' failed: "
+			      "view not found", ptr);
+		return (ISC_R_NOTFOUND);
+	}
+
+	return (result);
+}
+
 isc_result_t
 ns_server_flushnode(ns_server_t *server, isc_lex_t *lex, isc_boolean_t tree) {
 	char *ptr, *viewname;
@@ -12127,6 +12418,8 @@ do_addzone(ns_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 
 		/* Remove the zone from the zone table */
 		dns_zt_unmount(view->zonetable, zone);
+		if (view->respcache != NULL)
+			dns_respcache_invalidate(view->respcache);
 		goto cleanup;
 	}
 
@@ -12315,6 +12608,8 @@ do_modzone(ns_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 
 		/* Remove the zone from the zone table */
 		dns_zt_unmount(view->zonetable, zone);
+		if (view->respcache != NULL)
+			dns_respcache_invalidate(view->respcache);
 		goto cleanup;
 	}
 
@@ -12683,6 +12978,8 @@ ns_server_delzone(ns_server_t *server, isc_lex_t *lex, isc_buffer_t **text) {
 
 	view = dns_zone_getview(zone);
 	CHECK(dns_zt_unmount(view->zonetable, zone));
+	if (view->respcache != NULL)
+		dns_respcache_invalidate(view->respcache);
 
 	/* Send cleanup event */
 	dz = isc_mem_get(ns_g_mctx, sizeof(*dz));
@@ -289,6 +289,11 @@ init_desc(void) {
 		"QryNXRedirRLookup");
 	SET_NSSTATDESC(badcookie, "sent badcookie response", "QryBADCOOKIE");
 	SET_NSSTATDESC(keytagopt, "Keytag option received", "KeyTagOpt");
+	SET_NSSTATDESC(trystale,
+		       "queries that looked for stale answers in the cache",
+		       "QryTryStale");
+	SET_NSSTATDESC(usedstale, "queries answered with stale data",
+		       "QryUsedStale");
 	INSIST(i == dns_nsstatscounter_max);
 
 	/* Initialize resolver statistics */
@@ -1386,6 +1391,63 @@ rcodestat_dump(dns_rcode_t code, isc_uint64_t val, void *arg) {
 #endif
 }
 
+/*
+ * Cache node lock contention: the counter is the lock bucket.
+ */
+static void
+lockstat_dump(isc_statscounter_t counter, isc_uint64_t val, void *arg) {
+	FILE *fp;
+	char bucketbuf[16];
+	stats_dumparg_t *dumparg = arg;
+#ifdef HAVE_LIBXML2
+	xmlTextWriterPtr writer;
+	int xmlrc;
+#endif
+#ifdef HAVE_JSON
+	json_object *zoneobj, *obj;
+#endif
+
+	snprintf(bucketbuf, sizeof(bucketbuf), "%d", counter);
+
+	switch (dumparg->type) {
+	case isc_statsformat_file:
+		fp = dumparg->arg;
+		fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n", val,
+			bucketbuf);
+		break;
+	case isc_statsformat_xml:
+#ifdef HAVE_LIBXML2
+		writer = dumparg->arg;
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "counter"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "name",
+						 ISC_XMLCHAR bucketbuf));
+		TRY0(xmlTextWriterWriteFormatString(writer,
+						"%" ISC_PRINT_QUADFORMAT "u",
+						val));
+		TRY0(xmlTextWriterEndElement(writer)); /* counter */
+#endif
+		break;
+	case isc_statsformat_json:
+#ifdef HAVE_JSON
+		zoneobj = (json_object *) dumparg->arg;
+		obj = json_object_new_int64(val);
+		if (obj == NULL)
+			return;
+		json_object_object_add(zoneobj, bucketbuf, obj);
+#endif
+		break;
+	}
+	return;
+
+#ifdef HAVE_LIBXML2
+ error:
+	isc_log_write(ns_g_lctx, NS_LOGCATEGORY_GENERAL, NS_LOGMODULE_SERVER,
+		      ISC_LOG_ERROR, "failed at lockstat_dump()");
+	dumparg->result = ISC_R_FAILURE;
+	return;
+#endif
+}
+
 #ifdef HAVE_LIBXML2
 /*
  * Which statistics to include when rendering to XML
@@ -1502,6 +1564,7 @@ generatexml(ns_server_t *server, isc_uint32_t flags,
 	dns_view_t *view;
 	stats_dumparg_t dumparg;
 	dns_stats_t *cacherrstats;
+	isc_stats_t *cachelockstats;
 	isc_uint64_t nsstat_values[dns_nsstatscounter_max];
 	isc_uint64_t resstat_values[dns_resstatscounter_max];
 	isc_uint64_t adbstat_values[dns_adbstats_max];
@@ -1904,6 +1967,23 @@ generatexml(ns_server_t *server, isc_uint32_t flags,
 		TRY0(dns_cache_renderxml(view->cache, writer));
 		TRY0(xmlTextWriterEndElement(writer)); /* </cachestats> */
 
+		cachelockstats = dns_db_getlockstats(view->cachedb);
+		if (cachelockstats != NULL) {
+			/* <cachelocks> */
+			TRY0(xmlTextWriterStartElement(writer,
+						       ISC_XMLCHAR "counters"));
+			TRY0(xmlTextWriterWriteAttribute(writer,
+						 ISC_XMLCHAR "type",
+						 ISC_XMLCHAR "cachelocks"));
+			dumparg.result = ISC_R_SUCCESS;
+			isc_stats_dump(cachelockstats, lockstat_dump,
+				       &dumparg, 0);
+			if (dumparg.result != ISC_R_SUCCESS)
+				goto error;
+			/* </cachelocks> */
+			TRY0(xmlTextWriterEndElement(writer));
+		}
+
 		TRY0(xmlTextWriterEndElement(writer)); /* view */
 
 		view = ISC_LIST_NEXT(view, link);
@@ -2575,6 +2655,26 @@ generatejson(ns_server_t *server, size_t *msglen,
 				json_object_object_add(res, "cachestats",
 						       counters);
 
+				istats = dns_db_getlockstats(view->cachedb);
+				if (istats != NULL) {
+					counters = json_object_new_object();
+					CHECKMEM(counters);
+
+					dumparg.arg = counters;
+					dumparg.result = ISC_R_SUCCESS;
+					isc_stats_dump(istats, lockstat_dump,
+						       &dumparg, 0);
+					if (dumparg.result != ISC_R_SUCCESS) {
+						json_object_put(counters);
+						result = dumparg.result;
+						goto error;
+					}
+
+					json_object_object_add(res,
+							       "cachelocks",
+							       counters);
+				}
+
 				istats = view->adbstats;
 				if (istats != NULL) {
 					counters = json_object_new_object();
@@ -3523,6 +3623,30 @@ ns_stats_dump(ns_server_t *server, FILE *fp) {
 				       &dumparg, 0);
 	}
 
+	fprintf(fp, "++ Cache DB Node Lock Contention ++\n");
+	for (view = ISC_LIST_HEAD(server->viewlist);
+	     view != NULL;
+	     view = ISC_LIST_NEXT(view, link)) {
+		isc_stats_t *cachelockstats;
+
+		cachelockstats = dns_db_getlockstats(view->cachedb);
+		if (cachelockstats == NULL)
+			continue;
+		if (strcmp(view->name, "_default") == 0)
+			fprintf(fp, "[View: default]\n");
+		else
+			fprintf(fp, "[View: %s (Cache: %s)]\n", view->name,
+				dns_cache_getname(view->cache));
+		if (dns_view_iscacheshared(view)) {
+			/*
+			 * Avoid dumping redundant statistics when the cache is
+			 * shared.
+			 */
+			continue;
+		}
+		isc_stats_dump(cachelockstats, lockstat_dump, &dumparg, 0);
+	}
+
 	fprintf(fp, "++ ADB stats ++\n");
 	for (view = ISC_LIST_HEAD(server->viewlist);
 	     view != NULL;
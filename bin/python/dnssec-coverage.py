@@ -0,0 +1,24 @@
+#!
+############################################################################
+# Copyright (C) 2013-2017  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+############################################################################
+
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(sys.argv[0]))
+if os.name != 'nt':
+    if '': # value of --with-python-install-dir
+        sys.path.insert(1, '')
+    else:
+        sys.path.insert(1, os.path.join('/usr/local', 'lib',
+                        'python' + sys.version[:3], 'site-packages'))
+
+import isc.coverage
+
+if __name__ == "__main__":
+    isc.coverage.main()
@@ -155,6 +155,9 @@ command is one of the following:\n\
 		Reload a single zone.\n\
   retransfer zone [class [view]]\n\
 		Retransfer a single zone without checking serial number.\n\
+  savecache [view]\n\
+		Save the cache of a view, or of all views, to its\n\
+		cache-file.\n\
   scan		Scan available network interfaces for changes.\n\
   secroots [view ...]\n\
 		Write security roots to the secroots file.\n\
@@ -188,6 +191,8 @@ command is one of the following:\n\
   sync [-clean] zone [class [view]]\n\
 		Dump a single zone's changes to disk, and optionally\n\
 		remove its journal file.\n\
+  taskstats [ on | off ]\n\
+		Enable / disable task latency statistics.\n\
   thaw		Enable updates to all dynamic zones and reload them.\n\
   thaw zone [class [view]]\n\
 		Enable updates to a frozen dynamic zone and reload it.\n\
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* statsbench [-t threads] [-n count] [-c counters] */
+
+/*! \file
+ * Time isc_stats_increment() with 'threads' threads each updating the
+ * same 'counters' counters (as every cache lookup updates the cache
+ * statistics) 'count' times, with plain and with sharded
+ * (ISC_STATSCREATE_SHARDED) statistics.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/commandline.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/stats.h>
+#include <isc/thread.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#define MAXTHREADS	256
+
+static isc_stats_t *stats = NULL;
+static unsigned int count = 1000000, ncounters = 4;
+static isc_uint64_t total;
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *what, unsigned int threads, isc_uint64_t ops) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-8s %3u threads %12llu ops %8.3f s %8.2f ns/op\n", what,
+	       threads, (unsigned long long)ops, (double)us / 1000000,
+	       ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+static isc_threadresult_t
+#ifdef WIN32
+WINAPI
+#endif
+run(isc_threadarg_t arg) {
+	unsigned int i, c;
+
+	UNUSED(arg);
+
+	for (i = 0; i < count; i++)
+		for (c = 0; c < ncounters; c++)
+			isc_stats_increment(stats, c);
+
+	return ((isc_threadresult_t)0);
+}
+
+static void
+sum(isc_statscounter_t counter, isc_uint64_t value, void *arg) {
+	UNUSED(counter);
+	UNUSED(arg);
+
+	total += value;
+}
+
+static void
+bench(isc_mem_t *mctx, const char *what, unsigned int options,
+      unsigned int nthreads)
+{
+	isc_thread_t threads[MAXTHREADS];
+	unsigned int i;
+
+	RUNTIME_CHECK(isc_stats_create2(mctx, &stats, ncounters, options) ==
+		      ISC_R_SUCCESS);
+
+	begin();
+	for (i = 0; i < nthreads; i++)
+		RUNTIME_CHECK(isc_thread_create(run, NULL, &threads[i]) ==
+			      ISC_R_SUCCESS);
+	for (i = 0; i < nthreads; i++)
+		RUNTIME_CHECK(isc_thread_join(threads[i], NULL) ==
+			      ISC_R_SUCCESS);
+	report(what, nthreads, (isc_uint64_t)count * ncounters * nthreads);
+
+	total = 0;
+	isc_stats_dump(stats, sum, NULL, 0);
+	INSIST(total == (isc_uint64_t)count * ncounters * nthreads);
+
+	isc_stats_detach(&stats);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	unsigned int nthreads = 32;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":c:n:t:")) != -1) {
+		switch (c) {
+		case 'c':
+			ncounters = atoi(isc_commandline_argument);
+			break;
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case 't':
+			nthreads = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg || ncounters == 0 || nthreads == 0 ||
+	    nthreads > MAXTHREADS)
+	{
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr,
+			"\tstatsbench [-t threads] [-n count] [-c counters]\n");
+		exit(1);
+	}
+
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+
+	bench(mctx, "plain", 0, 1);
+	bench(mctx, "sharded", ISC_STATSCREATE_SHARDED, 1);
+	bench(mctx, "plain", 0, nthreads);
+	bench(mctx, "sharded", ISC_STATSCREATE_SHARDED, nthreads);
+
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
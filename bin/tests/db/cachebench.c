@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* cachebench [-n count] [-l lookups] [-u percent] */
+
+/*! \file
+ * Time dns_db_find() on a cache database holding 'count' A records,
+ * each at its own owner name, looked up in a pseudo-random order.
+ * 'percent' of the owner names have an upper case letter in them, and
+ * so need a case vector.  The memory used per entry is reported too.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/commandline.h>
+#include <isc/entropy.h>
+#include <isc/hash.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/stdtime.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/db.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/result.h>
+
+static isc_uint32_t state = 1;
+
+static isc_uint32_t
+next(void) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state);
+}
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *phase, unsigned int ops) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-8s %10u ops %8.3f s %8.1f ns/op\n", phase, ops,
+	       (double)us / 1000000, ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+/*
+ * Owner names are h<8 hex digits>.example, in wire format; 'upper' puts
+ * the leading 'h' in upper case.
+ */
+static unsigned char wire[] = "\011h00000000\007example";
+
+static void
+makename(dns_name_t *name, unsigned int i, isc_boolean_t upper) {
+	static const char hex[] = "0123456789abcdef";
+	isc_region_t r;
+	int j;
+
+	wire[1] = upper ? 'H' : 'h';
+	for (j = 9; j > 1; j--) {
+		wire[j] = hex[i & 0xf];
+		i >>= 4;
+	}
+	r.base = wire;
+	r.length = sizeof(wire);
+	dns_name_fromregion(name, &r);
+}
+
+static void
+add(dns_db_t *db, dns_name_t *name, unsigned int i, isc_stdtime_t now) {
+	unsigned char data[4];
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_region_t r;
+
+	data[0] = 10;
+	data[1] = (i >> 16) & 0xff;
+	data[2] = (i >> 8) & 0xff;
+	data[3] = i & 0xff;
+	r.base = data;
+	r.length = sizeof(data);
+	dns_rdata_fromregion(&rdata, dns_rdataclass_in, dns_rdatatype_a, &r);
+
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.type = dns_rdatatype_a;
+	rdatalist.ttl = 3600;
+	ISC_LIST_APPEND(rdatalist.rdata, &rdata, link);
+	dns_rdataset_init(&rdataset);
+	RUNTIME_CHECK(dns_rdatalist_tordataset(&rdatalist, &rdataset) ==
+		      ISC_R_SUCCESS);
+	rdataset.trust = dns_trust_answer;
+	dns_rdataset_setownercase(&rdataset, name);
+
+	RUNTIME_CHECK(dns_db_findnode(db, name, ISC_TRUE, &node) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_db_addrdataset(db, node, NULL, now, &rdataset,
+					 0, NULL) == ISC_R_SUCCESS);
+	dns_db_detachnode(db, &node);
+	dns_rdataset_disassociate(&rdataset);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	isc_entropy_t *ectx = NULL;
+	dns_db_t *db = NULL;
+	dns_fixedname_t fixed, ffound;
+	dns_name_t *name, *found;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node;
+	isc_stdtime_t now;
+	size_t before;
+	unsigned int count = 2000000, lookups = 0, percent = 0;
+	unsigned int i, j;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":n:l:u:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case 'l':
+			lookups = atoi(isc_commandline_argument);
+			break;
+		case 'u':
+			percent = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg || count == 0 || percent > 100) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr,
+			"\tcachebench [-n count] [-l lookups] [-u percent]\n");
+		exit(1);
+	}
+	if (lookups == 0)
+		lookups = count;
+
+	dns_result_register();
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_entropy_create(mctx, &ectx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_hash_create(mctx, ectx, DNS_NAME_MAXWIRE) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_db_create(mctx, "rbt", dns_rootname,
+				    dns_dbtype_cache, dns_rdataclass_in,
+				    0, NULL, &db) == ISC_R_SUCCESS);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	dns_fixedname_init(&ffound);
+	found = dns_fixedname_name(&ffound);
+	isc_stdtime_get(&now);
+
+	printf("%u names, %u%% with upper case, %u lookups\n",
+	       count, percent, lookups);
+
+	before = isc_mem_inuse(mctx);
+	begin();
+	for (i = 0; i < count; i++) {
+		makename(name, i, ISC_TF(i % 100 < percent));
+		add(db, name, i, now);
+	}
+	report("add", count);
+	printf("%.1f bytes per entry\n",
+	       (double)(isc_mem_inuse(mctx) - before) / count);
+
+	begin();
+	for (i = 0; i < lookups; i++) {
+		j = next() % count;
+		makename(name, j, ISC_FALSE);
+		node = NULL;
+		dns_rdataset_init(&rdataset);
+		RUNTIME_CHECK(dns_db_find(db, name, NULL, dns_rdatatype_a, 0,
+					  now, &node, found, &rdataset,
+					  NULL) == ISC_R_SUCCESS);
+		dns_rdataset_disassociate(&rdataset);
+		dns_db_detachnode(db, &node);
+	}
+	report("find", lookups);
+
+	dns_db_detach(&db);
+	isc_hash_destroy();
+	isc_entropy_detach(&ectx);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
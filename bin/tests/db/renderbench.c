@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* renderbench [-n count] */
+
+/*! \file
+ * Time rendering typical DNSSEC signed answers from rdatasets held in
+ * an "rbt" zone database: an A answer with its RRSIG and the signed
+ * NS RRset in the authority section, and a DNSKEY answer with a key
+ * signing key, two zone signing keys and two RRSIGs.  Each message is
+ * rendered 'count' times with dns_rdataset_towire().
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/buffer.h>
+#include <isc/commandline.h>
+#include <isc/entropy.h>
+#include <isc/hash.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/stdtime.h>
+#include <isc/string.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/compress.h>
+#include <dns/db.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/result.h>
+
+#include <dst/dst.h>
+
+#define MAXRDATA	3
+#define MAXSETS		4
+
+typedef struct {
+	dns_name_t		*owner;
+	dns_rdataset_t		rdataset;
+} set_t;
+
+static isc_uint32_t state = 1;
+static unsigned char message[4096];
+static dns_fixedname_t forigin, fwww;
+static dns_name_t *origin, *www;
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *answer, unsigned int ops, unsigned int size) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-6s %8u msgs %5u bytes %8.3f s %8.1f ns/msg\n",
+	       answer, ops, size, (double)us / 1000000,
+	       ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+static void
+fill(unsigned char *data, unsigned int length) {
+	while (length-- > 0) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		*data++ = state & 0xff;
+	}
+}
+
+/*
+ * Rdata for DNSKEY and RRSIG records as rendered by a 2048 bit KSK and
+ * 1024 bit ZSKs using RSASHA256.
+ */
+static unsigned int
+dnskey(unsigned char *data, isc_uint16_t flags, unsigned int keylen) {
+	data[0] = flags >> 8;
+	data[1] = flags & 0xff;
+	data[2] = 3;
+	data[3] = DST_ALG_RSASHA256;
+	data[4] = 3;
+	data[5] = 1;
+	data[6] = 0;
+	data[7] = 1;
+	fill(data + 8, keylen);
+	return (8 + keylen);
+}
+
+static unsigned int
+rrsig(unsigned char *data, dns_rdatatype_t covers, unsigned int labels,
+      unsigned int siglen)
+{
+	static const unsigned char times[] = {
+		0x00, 0x00, 0x0e, 0x10,		/* original TTL */
+		0x5a, 0x49, 0x7a, 0x00,		/* expiration */
+		0x58, 0x68, 0x46, 0x80,		/* inception */
+		0x30, 0x39			/* key tag */
+	};
+	isc_region_t r;
+
+	data[0] = covers >> 8;
+	data[1] = covers & 0xff;
+	data[2] = DST_ALG_RSASHA256;
+	data[3] = labels;
+	memmove(data + 4, times, sizeof(times));
+	dns_name_toregion(origin, &r);
+	memmove(data + 4 + sizeof(times), r.base, r.length);
+	fill(data + 4 + sizeof(times) + r.length, siglen);
+	return (4 + sizeof(times) + r.length + siglen);
+}
+
+/*
+ * Add 'n' rdatas of 'type' (RRSIGs covering 'covers') at 'name' and
+ * bind the rdataset that the database ends up with to 'set'.
+ */
+static void
+add(dns_db_t *db, dns_dbversion_t *version, dns_name_t *name,
+    dns_rdatatype_t type, dns_rdatatype_t covers, unsigned char **data,
+    unsigned int *length, unsigned int n, set_t *set)
+{
+	dns_rdata_t rdata[MAXRDATA];
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_region_t r;
+	isc_stdtime_t now;
+	unsigned int i;
+
+	INSIST(n <= MAXRDATA);
+	isc_stdtime_get(&now);
+
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.type = type;
+	rdatalist.covers = covers;
+	rdatalist.ttl = 3600;
+	for (i = 0; i < n; i++) {
+		dns_rdata_init(&rdata[i]);
+		r.base = data[i];
+		r.length = length[i];
+		dns_rdata_fromregion(&rdata[i], dns_rdataclass_in, type, &r);
+		ISC_LIST_APPEND(rdatalist.rdata, &rdata[i], link);
+	}
+	dns_rdataset_init(&rdataset);
+	RUNTIME_CHECK(dns_rdatalist_tordataset(&rdatalist, &rdataset) ==
+		      ISC_R_SUCCESS);
+
+	RUNTIME_CHECK(dns_db_findnode(db, name, ISC_TRUE, &node) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_db_addrdataset(db, node, version, now, &rdataset,
+					 0, NULL) == ISC_R_SUCCESS);
+	dns_rdataset_disassociate(&rdataset);
+
+	set->owner = name;
+	dns_rdataset_init(&set->rdataset);
+	RUNTIME_CHECK(dns_db_findrdataset(db, node, version, type, covers,
+					  now, &set->rdataset, NULL) ==
+		      ISC_R_SUCCESS);
+	set->rdataset.attributes |= DNS_RDATASETATTR_FIXEDORDER;
+	dns_db_detachnode(db, &node);
+}
+
+/*
+ * Render a response to 'qname'/'qtype' holding 'sets'.
+ */
+static unsigned int
+render(isc_mem_t *mctx, dns_name_t *qname, dns_rdatatype_t qtype,
+       set_t *sets, unsigned int nsets)
+{
+	dns_compress_t cctx;
+	isc_buffer_t b;
+	unsigned int i, count = 0;
+
+	isc_buffer_init(&b, message, sizeof(message));
+	isc_buffer_add(&b, 12);
+	RUNTIME_CHECK(dns_compress_init(&cctx, -1, mctx) == ISC_R_SUCCESS);
+
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+	RUNTIME_CHECK(dns_name_towire(qname, &cctx, &b) == ISC_R_SUCCESS);
+	isc_buffer_putuint16(&b, qtype);
+	isc_buffer_putuint16(&b, dns_rdataclass_in);
+
+	for (i = 0; i < nsets; i++)
+		RUNTIME_CHECK(dns_rdataset_towire(&sets[i].rdataset,
+						  sets[i].owner, &cctx, &b,
+						  0, &count) == ISC_R_SUCCESS);
+
+	dns_compress_invalidate(&cctx);
+	return (isc_buffer_usedlength(&b));
+}
+
+static void
+bench(isc_mem_t *mctx, const char *answer, dns_name_t *qname,
+      dns_rdatatype_t qtype, set_t *sets, unsigned int nsets,
+      unsigned int count)
+{
+	unsigned int i, size = 0;
+
+	begin();
+	for (i = 0; i < count; i++)
+		size = render(mctx, qname, qtype, sets, nsets);
+	report(answer, count, size);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	isc_entropy_t *ectx = NULL;
+	dns_db_t *db = NULL;
+	dns_dbversion_t *version = NULL;
+	dns_fixedname_t fns1, fns2;
+	unsigned char buf[MAXRDATA][512];
+	unsigned char *data[MAXRDATA];
+	unsigned int length[MAXRDATA];
+	set_t answer[MAXSETS], keys[MAXSETS];
+	unsigned int count = 200000, i;
+	isc_region_t r;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":n:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "\trenderbench [-n count]\n");
+		exit(1);
+	}
+
+	dns_result_register();
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_entropy_create(mctx, &ectx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_hash_create(mctx, ectx, DNS_NAME_MAXWIRE) ==
+		      ISC_R_SUCCESS);
+
+	dns_fixedname_init(&forigin);
+	origin = dns_fixedname_name(&forigin);
+	RUNTIME_CHECK(dns_name_fromstring(origin, "example.", 0, NULL) ==
+		      ISC_R_SUCCESS);
+	dns_fixedname_init(&fwww);
+	www = dns_fixedname_name(&fwww);
+	RUNTIME_CHECK(dns_name_fromstring(www, "www.example.", 0, NULL) ==
+		      ISC_R_SUCCESS);
+
+	for (i = 0; i < MAXRDATA; i++)
+		data[i] = buf[i];
+
+	RUNTIME_CHECK(dns_db_create(mctx, "rbt", origin, dns_dbtype_zone,
+				    dns_rdataclass_in, 0, NULL, &db) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_db_newversion(db, &version) == ISC_R_SUCCESS);
+
+	/*
+	 * www.example. A, RRSIG A; example. NS, RRSIG NS.
+	 */
+	for (i = 0; i < 2; i++) {
+		buf[i][0] = 192;
+		buf[i][1] = 0;
+		buf[i][2] = 2;
+		buf[i][3] = i + 1;
+		length[i] = 4;
+	}
+	add(db, version, www, dns_rdatatype_a, 0, data, length, 2,
+	    &answer[0]);
+	length[0] = rrsig(buf[0], dns_rdatatype_a, 2, 128);
+	add(db, version, www, dns_rdatatype_rrsig, dns_rdatatype_a,
+	    data, length, 1, &answer[1]);
+
+	dns_fixedname_init(&fns1);
+	RUNTIME_CHECK(dns_name_fromstring(dns_fixedname_name(&fns1),
+					  "ns1.example.", 0, NULL) ==
+		      ISC_R_SUCCESS);
+	dns_fixedname_init(&fns2);
+	RUNTIME_CHECK(dns_name_fromstring(dns_fixedname_name(&fns2),
+					  "ns2.example.", 0, NULL) ==
+		      ISC_R_SUCCESS);
+	dns_name_toregion(dns_fixedname_name(&fns1), &r);
+	memmove(buf[0], r.base, r.length);
+	length[0] = r.length;
+	dns_name_toregion(dns_fixedname_name(&fns2), &r);
+	memmove(buf[1], r.base, r.length);
+	length[1] = r.length;
+	add(db, version, origin, dns_rdatatype_ns, 0, data, length, 2,
+	    &answer[2]);
+	length[0] = rrsig(buf[0], dns_rdatatype_ns, 1, 128);
+	add(db, version, origin, dns_rdatatype_rrsig, dns_rdatatype_ns,
+	    data, length, 1, &answer[3]);
+
+	/*
+	 * example. DNSKEY, RRSIG DNSKEY.
+	 */
+	length[0] = dnskey(buf[0], 257, 256);
+	length[1] = dnskey(buf[1], 256, 128);
+	length[2] = dnskey(buf[2], 256, 128);
+	add(db, version, origin, dns_rdatatype_dnskey, 0, data, length, 3,
+	    &keys[0]);
+	length[0] = rrsig(buf[0], dns_rdatatype_dnskey, 1, 256);
+	length[1] = rrsig(buf[1], dns_rdatatype_dnskey, 1, 128);
+	add(db, version, origin, dns_rdatatype_rrsig, dns_rdatatype_dnskey,
+	    data, length, 2, &keys[1]);
+
+	bench(mctx, "A", www, dns_rdatatype_a, answer, 4, count);
+	bench(mctx, "DNSKEY", origin, dns_rdatatype_dnskey, keys, 2, count);
+
+	for (i = 0; i < 4; i++)
+		dns_rdataset_disassociate(&answer[i].rdataset);
+	for (i = 0; i < 2; i++)
+		dns_rdataset_disassociate(&keys[i].rdataset);
+	dns_db_closeversion(db, &version, ISC_TRUE);
+	dns_db_detach(&db);
+
+	isc_hash_destroy();
+	isc_entropy_detach(&ectx);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* zonebench [-c] [-n count] [-l lookups] */
+
+/*! \file
+ * Compare the "rbt" and "qp" database implementations: load a zone
+ * (or with -c, a cache) holding 'count' A records, each at its own
+ * owner name, then time dns_db_find() for 'lookups' names that are
+ * there and as many that are not, in a pseudo-random order.  The
+ * memory used per name is reported too.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/commandline.h>
+#include <isc/entropy.h>
+#include <isc/hash.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/stdtime.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/db.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/result.h>
+
+static isc_uint32_t state;
+
+static isc_uint32_t
+next(void) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state);
+}
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *impl, const char *phase, unsigned int ops) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-4s %-8s %10u ops %8.3f s %8.1f ns/op\n", impl, phase, ops,
+	       (double)us / 1000000, ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+/*
+ * Owner names are h<8 hex digits>.example, in wire format.
+ */
+static unsigned char wire[] = "\011h00000000\007example";
+
+static void
+makename(dns_name_t *name, unsigned int i) {
+	static const char hex[] = "0123456789abcdef";
+	isc_region_t r;
+	int j;
+
+	for (j = 9; j > 1; j--) {
+		wire[j] = hex[i & 0xf];
+		i >>= 4;
+	}
+	r.base = wire;
+	r.length = sizeof(wire);
+	dns_name_fromregion(name, &r);
+}
+
+static void
+add(dns_db_t *db, dns_dbversion_t *version, dns_name_t *name,
+    unsigned int i, isc_stdtime_t now)
+{
+	unsigned char data[4];
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_region_t r;
+
+	data[0] = 10;
+	data[1] = (i >> 16) & 0xff;
+	data[2] = (i >> 8) & 0xff;
+	data[3] = i & 0xff;
+	r.base = data;
+	r.length = sizeof(data);
+	dns_rdata_fromregion(&rdata, dns_rdataclass_in, dns_rdatatype_a, &r);
+
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.type = dns_rdatatype_a;
+	rdatalist.ttl = 3600;
+	ISC_LIST_APPEND(rdatalist.rdata, &rdata, link);
+	dns_rdataset_init(&rdataset);
+	RUNTIME_CHECK(dns_rdatalist_tordataset(&rdatalist, &rdataset) ==
+		      ISC_R_SUCCESS);
+	rdataset.trust = dns_trust_answer;
+
+	RUNTIME_CHECK(dns_db_findnode(db, name, ISC_TRUE, &node) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_db_addrdataset(db, node, version, now, &rdataset,
+					 0, NULL) == ISC_R_SUCCESS);
+	dns_db_detachnode(db, &node);
+	dns_rdataset_disassociate(&rdataset);
+}
+
+static void
+lookup(dns_db_t *db, dns_name_t *name, dns_name_t *found,
+       isc_stdtime_t now, isc_result_t expect)
+{
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, name, NULL, dns_rdatatype_a, 0, now, &node,
+			     found, &rdataset, NULL);
+	RUNTIME_CHECK(result == expect);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+}
+
+static void
+bench(isc_mem_t *mctx, const char *impl, dns_dbtype_t type,
+      unsigned int count, unsigned int lookups)
+{
+	dns_db_t *db = NULL;
+	dns_dbversion_t *version = NULL;
+	dns_fixedname_t fixed, forigin, ffound;
+	dns_name_t *name, *origin, *found;
+	isc_stdtime_t now;
+	isc_result_t miss;
+	size_t before;
+	unsigned int i;
+
+	dns_fixedname_init(&forigin);
+	origin = dns_fixedname_name(&forigin);
+	RUNTIME_CHECK(dns_name_fromstring(origin, "example.", 0, NULL) ==
+		      ISC_R_SUCCESS);
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	dns_fixedname_init(&ffound);
+	found = dns_fixedname_name(&ffound);
+	isc_stdtime_get(&now);
+
+	before = isc_mem_inuse(mctx);
+	RUNTIME_CHECK(dns_db_create(mctx, impl,
+				    type == dns_dbtype_cache ?
+				    dns_rootname : origin,
+				    type, dns_rdataclass_in,
+				    0, NULL, &db) == ISC_R_SUCCESS);
+	if (type == dns_dbtype_zone) {
+		RUNTIME_CHECK(dns_db_newversion(db, &version) ==
+			      ISC_R_SUCCESS);
+		miss = DNS_R_NXDOMAIN;
+	} else
+		miss = ISC_R_NOTFOUND;
+
+	begin();
+	for (i = 0; i < count; i++) {
+		makename(name, i);
+		add(db, version, name, i, now);
+	}
+	if (version != NULL)
+		dns_db_closeversion(db, &version, ISC_TRUE);
+	report(impl, "add", count);
+	printf("%-4s %.1f bytes per name\n", impl,
+	       (double)(isc_mem_inuse(mctx) - before) / count);
+
+	state = 1;
+	begin();
+	for (i = 0; i < lookups; i++) {
+		makename(name, next() % count);
+		lookup(db, name, found, now, ISC_R_SUCCESS);
+	}
+	report(impl, "find", lookups);
+
+	begin();
+	for (i = 0; i < lookups; i++) {
+		makename(name, count + next() % count);
+		lookup(db, name, found, now, miss);
+	}
+	report(impl, "miss", lookups);
+
+	dns_db_detach(&db);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	isc_entropy_t *ectx = NULL;
+	dns_dbtype_t type = dns_dbtype_zone;
+	unsigned int count = 1000000, lookups = 0;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":cn:l:")) != -1) {
+		switch (c) {
+		case 'c':
+			type = dns_dbtype_cache;
+			break;
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case 'l':
+			lookups = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg || count == 0 || count > 0x7fffffff) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "\tzonebench [-c] [-n count] [-l lookups]\n");
+		exit(1);
+	}
+	if (lookups == 0)
+		lookups = count;
+
+	dns_result_register();
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_entropy_create(mctx, &ectx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_hash_create(mctx, ectx, DNS_NAME_MAXWIRE) ==
+		      ISC_R_SUCCESS);
+
+	printf("%u names in a %s, %u lookups\n", count,
+	       type == dns_dbtype_cache ? "cache" : "zone", lookups);
+
+	bench(mctx, "rbt", type, count, lookups);
+	bench(mctx, "qp", type, count, lookups);
+
+	isc_hash_destroy();
+	isc_entropy_detach(&ectx);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* compressbench [-n referrals] [-a transfers] */
+
+/*! \file
+ * Time name compression while rendering two kinds of large message
+ * the way dns_rdataset_towire() does: a referral with 13 name servers
+ * and their A and AAAA glue, rendered 'referrals' times, and a 64k
+ * zone transfer message with a couple of thousand records, rendered
+ * 'transfers' times.  The rendered size is printed so that a change
+ * in how well names are compressed shows up too.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/buffer.h>
+#include <isc/commandline.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/string.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/compress.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/result.h>
+
+#define MAXRRS		3000
+#define RDATASIZE	(2 + DNS_NAME_MAXWIRE)
+
+typedef struct {
+	dns_fixedname_t		owner;
+	dns_rdata_t		rdata;
+	unsigned char		data[RDATASIZE];
+} rr_t;
+
+static rr_t rrs[MAXRRS];
+static unsigned int nrrs;
+static dns_fixedname_t question;
+static unsigned char message[65535];
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *phase, unsigned int ops, unsigned int size) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-8s %8u msgs %6u bytes %8.3f s %10.1f ns/msg\n", phase, ops,
+	       size, (double)us / 1000000,
+	       ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+static void
+fromstring(dns_fixedname_t *fixed, const char *text) {
+	dns_fixedname_init(fixed);
+	RUNTIME_CHECK(dns_name_fromstring(dns_fixedname_name(fixed), text,
+					  0, NULL) == ISC_R_SUCCESS);
+}
+
+/*
+ * Add a record whose rdata is 'prefixlen' bytes of 'prefix' followed
+ * by 'target' (if not NULL) in uncompressed wire format.
+ */
+static void
+addrr(const char *owner, dns_rdatatype_t type, const unsigned char *prefix,
+      unsigned int prefixlen, const char *target)
+{
+	dns_fixedname_t ftarget;
+	isc_region_t r;
+	rr_t *rr;
+
+	RUNTIME_CHECK(nrrs < MAXRRS);
+	rr = &rrs[nrrs++];
+	fromstring(&rr->owner, owner);
+	if (prefixlen != 0)
+		memmove(rr->data, prefix, prefixlen);
+	r.base = rr->data;
+	r.length = prefixlen;
+	if (target != NULL) {
+		isc_region_t tr;
+
+		fromstring(&ftarget, target);
+		dns_name_toregion(dns_fixedname_name(&ftarget), &tr);
+		memmove(rr->data + prefixlen, tr.base, tr.length);
+		r.length += tr.length;
+	}
+	dns_rdata_init(&rr->rdata);
+	dns_rdata_fromregion(&rr->rdata, dns_rdataclass_in, type, &r);
+}
+
+static void
+referral(void) {
+	static const unsigned char a[4] = { 192, 0, 2, 0 };
+	static const unsigned char aaaa[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+	char target[64];
+	char c;
+
+	nrrs = 0;
+	fromstring(&question, "www.example.com.");
+	for (c = 'a'; c <= 'm'; c++) {
+		snprintf(target, sizeof(target), "%c.iana-servers.net.", c);
+		addrr("example.com.", dns_rdatatype_ns, NULL, 0, target);
+	}
+	for (c = 'a'; c <= 'm'; c++) {
+		snprintf(target, sizeof(target), "%c.iana-servers.net.", c);
+		addrr(target, dns_rdatatype_a, a, sizeof(a), NULL);
+		addrr(target, dns_rdatatype_aaaa, aaaa, sizeof(aaaa), NULL);
+	}
+}
+
+static void
+transfer(void) {
+	static const unsigned char a[4] = { 10, 0, 0, 0 };
+	static const unsigned char mx[2] = { 0, 10 };
+	char owner[64], target[64];
+	unsigned int i;
+
+	nrrs = 0;
+	fromstring(&question, "example.com.");
+	for (i = 0; nrrs < MAXRRS - 3; i++) {
+		snprintf(owner, sizeof(owner), "host%u.example.com.", i);
+		addrr(owner, dns_rdatatype_a, a, sizeof(a), NULL);
+		if (i % 4 == 0) {
+			snprintf(owner, sizeof(owner),
+				 "mail%u.example.com.", i);
+			snprintf(target, sizeof(target),
+				 "host%u.example.com.", i);
+			addrr(owner, dns_rdatatype_mx, mx, sizeof(mx), target);
+		}
+		if (i % 8 == 0) {
+			snprintf(owner, sizeof(owner),
+				 "www.dept%u.example.com.", i);
+			snprintf(target, sizeof(target),
+				 "host%u.example.com.", i);
+			addrr(owner, dns_rdatatype_cname, NULL, 0, target);
+		}
+	}
+}
+
+/*
+ * Render the question and as many records as fit, as
+ * dns_message_rendersection() would.
+ */
+static unsigned int
+render(isc_mem_t *mctx) {
+	dns_compress_t cctx;
+	isc_buffer_t b;
+	unsigned int i, rdpos, rdlen;
+	isc_result_t result;
+
+	isc_buffer_init(&b, message, sizeof(message));
+	isc_buffer_add(&b, 12);
+	RUNTIME_CHECK(dns_compress_init(&cctx, -1, mctx) == ISC_R_SUCCESS);
+
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+	RUNTIME_CHECK(dns_name_towire(dns_fixedname_name(&question), &cctx,
+				      &b) == ISC_R_SUCCESS);
+	isc_buffer_putuint16(&b, dns_rdatatype_a);
+	isc_buffer_putuint16(&b, dns_rdataclass_in);
+
+	for (i = 0; i < nrrs; i++) {
+		isc_buffer_t st = b;
+
+		dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+		result = dns_name_towire(dns_fixedname_name(&rrs[i].owner),
+					 &cctx, &b);
+		if (result == ISC_R_SUCCESS &&
+		    isc_buffer_availablelength(&b) < 10)
+			result = ISC_R_NOSPACE;
+		if (result == ISC_R_SUCCESS) {
+			isc_buffer_putuint16(&b, rrs[i].rdata.type);
+			isc_buffer_putuint16(&b, dns_rdataclass_in);
+			isc_buffer_putuint32(&b, 3600);
+			rdpos = isc_buffer_usedlength(&b);
+			isc_buffer_putuint16(&b, 0);
+			result = dns_rdata_towire(&rrs[i].rdata, &cctx, &b);
+		}
+		if (result != ISC_R_SUCCESS) {
+			dns_compress_rollback(&cctx, (isc_uint16_t)st.used);
+			b = st;
+			break;
+		}
+		rdlen = isc_buffer_usedlength(&b) - rdpos - 2;
+		message[rdpos] = (rdlen >> 8) & 0xff;
+		message[rdpos + 1] = rdlen & 0xff;
+	}
+
+	dns_compress_invalidate(&cctx);
+	return (isc_buffer_usedlength(&b));
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	unsigned int referrals = 200000, transfers = 2000;
+	unsigned int i, size = 0;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":n:a:")) != -1) {
+		switch (c) {
+		case 'n':
+			referrals = atoi(isc_commandline_argument);
+			break;
+		case 'a':
+			transfers = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "\tcompressbench [-n referrals] "
+			"[-a transfers]\n");
+		exit(1);
+	}
+
+	dns_result_register();
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+
+	referral();
+	begin();
+	for (i = 0; i < referrals; i++)
+		size = render(mctx);
+	report("referral", referrals, size);
+
+	transfer();
+	begin();
+	for (i = 0; i < transfers; i++)
+		size = render(mctx);
+	report("axfr", transfers, size);
+
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* rbtbench [-n count] [-l lookups] */
+
+/*! \file
+ * Time the red-black tree and its name hash: add 'count' names (each
+ * one label below a common parent, so all but the first lookup step
+ * go through the hash), look up 'lookups' of them in a pseudo-random
+ * order, look up as many names that are not there, then delete them
+ * all.  The slowest single addition is reported too, since that is
+ * where growing the hash table shows up.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/commandline.h>
+#include <isc/entropy.h>
+#include <isc/hash.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rbt.h>
+#include <dns/result.h>
+
+static isc_uint32_t state = 1;
+
+static isc_uint32_t
+next(void) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state);
+}
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *phase, unsigned int ops) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-8s %10u ops %8.3f s %8.1f ns/op\n", phase, ops,
+	       (double)us / 1000000, ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+/*
+ * Names are h<8 hex digits>.example, in wire format.
+ */
+static unsigned char wire[] = "\011h00000000\007example";
+
+static void
+makename(dns_name_t *name, unsigned int i) {
+	static const char hex[] = "0123456789abcdef";
+	isc_region_t r;
+	int j;
+
+	for (j = 9; j > 1; j--) {
+		wire[j] = hex[i & 0xf];
+		i >>= 4;
+	}
+	r.base = wire;
+	r.length = sizeof(wire);
+	dns_name_fromregion(name, &r);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	isc_entropy_t *ectx = NULL;
+	dns_rbt_t *rbt = NULL;
+	dns_rbtnode_t *node;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	isc_time_t t0, t1;
+	isc_uint64_t us, slowest = 0;
+	isc_result_t result;
+	unsigned int count = 2000000, lookups = 0;
+	unsigned int i;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":n:l:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case 'l':
+			lookups = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg || count == 0 || count > 0x7fffffff) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr, "\trbtbench [-n count] [-l lookups]\n");
+		exit(1);
+	}
+	if (lookups == 0)
+		lookups = count;
+
+	dns_result_register();
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_entropy_create(mctx, &ectx) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_hash_create(mctx, ectx, DNS_NAME_MAXWIRE) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_rbt_create(mctx, NULL, NULL, &rbt) ==
+		      ISC_R_SUCCESS);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+
+	printf("%u names, %u lookups\n", count, lookups);
+
+	begin();
+	for (i = 0; i < count; i++) {
+		makename(name, i);
+		node = NULL;
+		TIME_NOW(&t0);
+		result = dns_rbt_addnode(rbt, name, &node);
+		TIME_NOW(&t1);
+		RUNTIME_CHECK(result == ISC_R_SUCCESS);
+		node->data = &state;
+		us = isc_time_microdiff(&t1, &t0);
+		if (us > slowest)
+			slowest = us;
+	}
+	report("add", count);
+	printf("slowest add %llu us, %lu hash slots\n",
+	       (unsigned long long)slowest,
+	       (unsigned long)dns_rbt_hashsize(rbt));
+
+	begin();
+	for (i = 0; i < lookups; i++) {
+		makename(name, next() % count);
+		node = NULL;
+		result = dns_rbt_findnode(rbt, name, NULL, &node, NULL,
+					  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
+		RUNTIME_CHECK(result == ISC_R_SUCCESS);
+	}
+	report("find", lookups);
+
+	begin();
+	for (i = 0; i < lookups; i++) {
+		makename(name, count + next() % count);
+		node = NULL;
+		result = dns_rbt_findnode(rbt, name, NULL, &node, NULL,
+					  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
+		RUNTIME_CHECK(result == DNS_R_PARTIALMATCH);
+	}
+	report("miss", lookups);
+
+	begin();
+	for (i = 0; i < count; i++) {
+		makename(name, i);
+		RUNTIME_CHECK(dns_rbt_deletename(rbt, name, ISC_FALSE) ==
+			      ISC_R_SUCCESS);
+	}
+	report("delete", count);
+
+	dns_rbt_destroy(&rbt);
+	isc_hash_destroy();
+	isc_entropy_detach(&ectx);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+# Copyright (C) 2011, 2012, 2016  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+# $Id: prereq.sh.in,v 1.2 2011/04/19 22:30:52 each Exp $
+
+TOP=${SYSTEMTESTTOP:=.}/../../../..
+
+if [ "" != "filesystem" ]; then
+        echo "I:DLZ filesystem driver not supported"
+        exit 255
+fi
+exit 0
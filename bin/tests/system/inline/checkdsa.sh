@@ -0,0 +1,14 @@
+# Copyright (C) 2013, 2014, 2016  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+if [ "0" -eq 0 ]; then
+	exit 1
+fi
+if [ ! -r /dev/random -o ! -r /dev/urandom ]; then
+	exit 1
+fi
+
+exit 0
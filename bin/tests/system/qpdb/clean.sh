@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+rm -f ns1/K*
+rm -f ns1/dsset-*
+rm -f ns1/signer.err
+rm -f ns*/*.db
+rm -f ns*/*.signed
+rm -f ns*/*.jnl
+rm -f ns2/*.bk
+rm -f ns*/named.run
+rm -f ns*/named.memstats
+rm -f ns*/named.lock
+rm -f dig.out.*
@@ -0,0 +1,29 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+SYSTEMTESTTOP=../..
+. $SYSTEMTESTTOP/conf.sh
+
+for zone in nsec nsec3
+do
+	zonefile=$zone.db
+	outfile=$zone.db.signed
+
+	keyname1=`$KEYGEN -r $RANDFILE -a RSASHA256 -b 1024 -n zone $zone 2> /dev/null`
+	keyname2=`$KEYGEN -f KSK -r $RANDFILE -a RSASHA256 -b 1024 -n zone $zone 2> /dev/null`
+
+	cat zone.db.in $keyname1.key $keyname2.key > $zonefile
+
+	case $zone in
+	nsec3) nsec3="-3 -" ;;
+	*) nsec3= ;;
+	esac
+
+	$SIGNER -r $RANDFILE $nsec3 -o $zone -f $outfile $zonefile > /dev/null 2> signer.err || cat signer.err
+	echo "I: signed $zone"
+done
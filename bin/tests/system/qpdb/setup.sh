@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+SYSTEMTESTTOP=..
+. $SYSTEMTESTTOP/conf.sh
+
+test -r $RANDFILE || $GENRANDOM 400 $RANDFILE
+
+rm -f ns*/*.jnl
+
+if $SHELL ../testcrypto.sh -q
+then
+	(cd ns1 && $SHELL -e sign.sh)
+else
+	echo "I:using unsigned nsec and nsec3 zones"
+	cp -f ns1/zone.db.in ns1/nsec.db.signed
+	cp -f ns1/zone.db.in ns1/nsec3.db.signed
+fi
+
+#
+# ns1 and ns2 serve the same zones, from "rbt" and "qp" databases.
+#
+for zone in nsec nsec3
+do
+	cp -f ns1/$zone.db.signed ns2/$zone.db.signed
+done
+cp -f ns1/zone.db.in ns1/dynamic.db
+cp -f ns1/zone.db.in ns2/dynamic.db
+cp -f ns1/zone.db.in ns1/xfer.db
@@ -0,0 +1,151 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+SYSTEMTESTTOP=..
+. $SYSTEMTESTTOP/conf.sh
+
+status=0
+n=0
+
+rm -f dig.out.*
+
+DIGOPTS="+tcp +norec +dnssec -p 5300"
+
+#
+# ns1 serves the zones from "rbt" databases and ns2 from "qp" ones;
+# every answer should be the same.
+#
+QUERIES="@/SOA @/NS @/DNSKEY @/NSEC3PARAM a/A a/AAAA a/MX a/ANY
+	 c/TXT b.c/TXT x.c/TXT x.b.c/TXT nx/A 0/A zz/A cname/A cname/CNAME
+	 dname/A x.dname/A x.y.dname/TXT wild/TXT x.wild/TXT x.wild/A
+	 y.x.wild/TXT sub/NS sub/A www.sub/A ns.sub/A ns/A z/TXT"
+
+compare () {
+	zone=$1
+	i=0
+	for q in $QUERIES
+	do
+		i=`expr $i + 1`
+		name=`echo $q | sed -e 's,/.*,,' -e 's,^@$,,'`
+		type=`echo $q | sed -e 's,.*/,,'`
+		qname=${name:+$name.}$zone
+		$DIG $DIGOPTS $qname $type @10.53.0.1 > dig.out.ns1.test$n.$i \
+			|| return 1
+		$DIG $DIGOPTS $qname $type @10.53.0.2 > dig.out.ns2.test$n.$i \
+			|| return 1
+		$PERL ../digcomp.pl dig.out.ns1.test$n.$i dig.out.ns2.test$n.$i ||
+			{ echo "I:$qname/$type differs"; return 1; }
+	done
+	return 0
+}
+
+for zone in nsec nsec3 dynamic
+do
+	n=`expr $n + 1`
+	echo "I:comparing answers from zone $zone ($n)"
+	ret=0
+	compare $zone || ret=1
+	if [ $ret != 0 ]; then echo "I:failed"; fi
+	status=`expr $status + $ret`
+
+	n=`expr $n + 1`
+	echo "I:comparing transfers of zone $zone ($n)"
+	ret=0
+	$DIG $DIGOPTS $zone axfr @10.53.0.1 > dig.out.ns1.test$n || ret=1
+	$DIG $DIGOPTS $zone axfr @10.53.0.2 > dig.out.ns2.test$n || ret=1
+	$PERL ../digcomp.pl dig.out.ns1.test$n dig.out.ns2.test$n || ret=1
+	if [ $ret != 0 ]; then echo "I:failed"; fi
+	status=`expr $status + $ret`
+done
+
+n=`expr $n + 1`
+echo "I:updating zone dynamic ($n)"
+ret=0
+for server in 10.53.0.1 10.53.0.2
+do
+	$NSUPDATE << END > /dev/null || ret=1
+server $server 5300
+zone dynamic
+update delete a.dynamic A
+update add new.dynamic 300 A 10.0.0.2
+update add x.c.dynamic 300 TXT "x.c"
+update add *.dynamic 300 TXT "wild"
+update delete z.dynamic
+send
+END
+done
+$DIG $DIGOPTS new.dynamic A @10.53.0.2 > dig.out.ns2.test$n || ret=1
+grep "10\.0\.0\.2" dig.out.ns2.test$n > /dev/null || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:comparing answers from zone dynamic after the update ($n)"
+ret=0
+QUERIES="$QUERIES new/A new/TXT x.c/TXT y.c/TXT z/TXT zz/TXT"
+compare dynamic || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:comparing transfers of zone dynamic after the update ($n)"
+ret=0
+$DIG $DIGOPTS dynamic axfr @10.53.0.1 > dig.out.ns1.test$n || ret=1
+$DIG $DIGOPTS dynamic axfr @10.53.0.2 > dig.out.ns2.test$n || ret=1
+$PERL ../digcomp.pl dig.out.ns1.test$n dig.out.ns2.test$n || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:comparing answers from slave zone xfer ($n)"
+ret=0
+for i in 1 2 3 4 5 6 7 8 9 10
+do
+	$DIG $DIGOPTS xfer SOA @10.53.0.2 > dig.out.ns2.test$n
+	grep "status: NOERROR" dig.out.ns2.test$n > /dev/null && break
+	sleep 1
+done
+compare xfer || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:updating zone xfer on the master ($n)"
+ret=0
+$NSUPDATE << END > /dev/null || ret=1
+server 10.53.0.1 5300
+zone xfer
+update delete a.xfer A
+update add new.xfer 300 A 10.0.0.2
+update add x.c.xfer 300 TXT "x.c"
+update add *.xfer 300 TXT "wild"
+update delete z.xfer
+send
+END
+for i in 1 2 3 4 5 6 7 8 9 10
+do
+	$DIG $DIGOPTS new.xfer A @10.53.0.2 > dig.out.ns2.test$n
+	grep "10\.0\.0\.2" dig.out.ns2.test$n > /dev/null && break
+	sleep 1
+done
+grep "10\.0\.0\.2" dig.out.ns2.test$n > /dev/null || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:comparing answers from slave zone xfer after IXFR ($n)"
+ret=0
+compare xfer || ret=1
+grep "transfer of 'xfer/IN' from 10.53.0.1#5300: Transfer status: success" \
+	ns2/named.run > /dev/null || ret=1
+grep "got incremental response" ns2/named.run > /dev/null || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+echo "I:exit status: $status"
+[ $status -eq 0 ] || exit 1
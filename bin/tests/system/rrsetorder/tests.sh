@@ -361,7 +361,7 @@ fi
 #
 echo "I: Checking order cyclic (cache + additional)"
 ret=0
-# prime acache
+# prime cache
 $DIGCMD @10.53.0.3 cyclic.example > dig.out.cyclic || ret=1
 matches=0
 for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
@@ -389,7 +389,7 @@ status=`expr $status + $ret`
 #
 echo "I: Checking order cyclic (cache)"
 ret=0
-# prime acache
+# prime cache
 $DIGCMD @10.53.0.3 cyclic2.example > dig.out.cyclic2 || ret=1
 matches=0
 for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
@@ -0,0 +1,113 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+SYSTEMTESTTOP=..
+. $SYSTEMTESTTOP/conf.sh
+
+status=0
+n=0
+
+rm -f dig.out.*
+
+DIGOPTS="+tries=1 +time=20 -p 5300 @10.53.0.3"
+
+#
+# Print the "Query time" dig reported in $1, in milliseconds.
+#
+querytime () {
+	sed -n 's/^;; Query time: \([0-9]*\) msec.*/\1/p' $1
+}
+
+#
+# Make ns2, which serves "example", stop or resume answering queries.
+# A stopped server still receives queries, so the resolver has to
+# wait for them to time out.
+#
+pause () {
+	$KILL -STOP `cat ns2/named.pid`
+}
+
+resume () {
+	$KILL -CONT `cat ns2/named.pid`
+}
+
+n=`expr $n + 1`
+echo "I:priming the cache ($n)"
+ret=0
+$DIG $DIGOPTS data.example a > dig.out.test$n || ret=1
+grep "^data\.example\..*A.*192\.0\.2\.1" dig.out.test$n > /dev/null || ret=1
+$DIG $DIGOPTS nodata.example a > dig.out.test$n || ret=1
+grep "status: NOERROR" dig.out.test$n > /dev/null || ret=1
+grep "ANSWER: 0," dig.out.test$n > /dev/null || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+# Let the two-second TTLs run out.
+sleep 3
+pause
+
+n=`expr $n + 1`
+echo "I:checking a stale answer is sent after stale-answer-client-timeout ($n)"
+ret=0
+$DIG $DIGOPTS data.example a > dig.out.test$n || ret=1
+grep "status: NOERROR" dig.out.test$n > /dev/null || ret=1
+grep "^data\.example\..*3.*IN.*A.*192\.0\.2\.1" dig.out.test$n > /dev/null ||
+	ret=1
+qtime=`querytime dig.out.test$n`
+[ "${qtime:-99999}" -lt 5000 ] || ret=1
+grep "data.example/A: client timeout, stale answer used" ns3/named.run \
+	> /dev/null || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:checking a stale negative answer is sent after stale-answer-client-timeout ($n)"
+ret=0
+$DIG $DIGOPTS nodata.example a > dig.out.test$n || ret=1
+grep "status: NOERROR" dig.out.test$n > /dev/null || ret=1
+grep "ANSWER: 0," dig.out.test$n > /dev/null || ret=1
+qtime=`querytime dig.out.test$n`
+[ "${qtime:-99999}" -lt 5000 ] || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+resume
+
+n=`expr $n + 1`
+echo "I:checking the fetch went on to refresh the cache ($n)"
+ret=1
+for i in 1 2 3 4 5 6 7 8 9 10
+do
+	$DIG $DIGOPTS +norec data.example a > dig.out.test$n
+	if grep "^data\.example\.[	 ]*[012][	 ]*IN.*A.*192\.0\.2\.1" \
+		dig.out.test$n > /dev/null
+	then
+		ret=0
+		break
+	fi
+	sleep 1
+done
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+pause
+
+n=`expr $n + 1`
+echo "I:checking recursion is not cut short without stale data ($n)"
+ret=0
+$DIG $DIGOPTS other.example a > dig.out.test$n
+grep "status: SERVFAIL" dig.out.test$n > /dev/null || ret=1
+qtime=`querytime dig.out.test$n`
+[ "${qtime:-0}" -ge 2000 ] || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+resume
+
+echo "I:exit status: $status"
+[ $status -eq 0 ] || exit 1
@@ -0,0 +1,13 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+for view in tsig ecs local other
+do
+	sed -e "s/@VIEW@/$view/" ns1/example.db.in > ns1/$view.db
+done
+cp -f ns1/named1.conf ns1/named.conf
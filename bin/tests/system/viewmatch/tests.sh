@@ -0,0 +1,80 @@
+#!/bin/sh
+#
+# Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+SYSTEMTESTTOP=..
+. $SYSTEMTESTTOP/conf.sh
+
+status=0
+n=0
+
+rm -f dig.out.*
+
+DIGOPTS="+norec +nocookie -p 5300 @10.53.0.1"
+RNDCCMD="$RNDC -c ../common/rndc.conf -s 10.53.0.1 -p 9953"
+sha256="R16NojROxtxH/xbDl//ehDsHm5DjWTQ2YXV+hGC2iBY="
+
+#
+# Query for view.example/TXT, which names the view that answered,
+# and check the answer against $1.  The remaining arguments are passed
+# to dig.  Each UDP client remembers the view its last unsigned request
+# without ECS matched, so repeated queries from one source exercise
+# that cache.
+#
+checkview () {
+	expect=$1
+	shift
+	$DIG $DIGOPTS "$@" view.example txt > dig.out.test$n || return 1
+	grep "status: NOERROR" dig.out.test$n > /dev/null || return 1
+	grep "^view\.example\..*TXT.*\"$expect\"" dig.out.test$n > /dev/null
+}
+
+n=`expr $n + 1`
+echo "I:checking repeated queries match the same view ($n)"
+ret=0
+for i in 1 2 3 4 5
+do
+	checkview local -b 10.53.0.1 || ret=1
+done
+checkview other -b 10.53.0.2 || ret=1
+checkview local -b 10.53.0.1 || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:checking a TSIG-signed query still walks the views ($n)"
+ret=0
+checkview local -b 10.53.0.1 || ret=1
+checkview tsig -b 10.53.0.1 -y "hmac-sha256:tsigkey:$sha256" || ret=1
+checkview local -b 10.53.0.1 || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:checking a query with ECS still walks the views ($n)"
+ret=0
+checkview local -b 10.53.0.1 || ret=1
+checkview ecs -b 10.53.0.1 +subnet=192.0.2.1/32 || ret=1
+checkview local -b 10.53.0.1 || ret=1
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+n=`expr $n + 1`
+echo "I:checking a cached match is dropped by 'rndc reconfig' ($n)"
+ret=0
+checkview local -b 10.53.0.1 || ret=1
+cp -f ns1/named2.conf ns1/named.conf
+$RNDCCMD reconfig 2>&1 | sed 's/^/I:ns1 /'
+for i in 1 2 3
+do
+	checkview other -b 10.53.0.1 || ret=1
+done
+if [ $ret != 0 ]; then echo "I:failed"; fi
+status=`expr $status + $ret`
+
+echo "I:exit status: $status"
+[ $status -eq 0 ] || exit 1
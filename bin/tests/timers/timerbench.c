@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* timerbench [-n count] [-r rounds] [-s spread] */
+
+/*! \file
+ * Compare the timing wheel used by the timer manager with the heap it
+ * replaced, with 'count' timers active at once: insert them all, move
+ * each of them 'rounds' times (as the resolver and client code do when
+ * resetting timeouts), then expire them all.  Finally, time
+ * isc_timer_reset() itself on the same number of timers.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/commandline.h>
+#include <isc/heap.h>
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/task.h>
+#include <isc/time.h>
+#include <isc/timer.h>
+#include <isc/util.h>
+#include <isc/wheel.h>
+
+typedef struct element {
+	isc_uint64_t		due;
+	unsigned int		index;
+	isc_wheelentry_t	entry;
+} element_t;
+
+static isc_uint32_t state = 1;
+
+/*
+ * A fixed pseudo-random sequence, so that both structures see the
+ * same deadlines.
+ */
+static isc_uint32_t
+next(void) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state);
+}
+
+static isc_boolean_t
+compare(void *p1, void *p2) {
+	element_t *e1 = p1, *e2 = p2;
+
+	return (ISC_TF(e1->due < e2->due));
+}
+
+static void
+idx(void *p, unsigned int i) {
+	element_t *e = p;
+
+	e->index = i;
+}
+
+static isc_time_t start;
+
+static void
+begin(void) {
+	TIME_NOW(&start);
+}
+
+static void
+report(const char *what, const char *phase, unsigned int ops) {
+	isc_time_t end;
+	isc_uint64_t us;
+
+	TIME_NOW(&end);
+	us = isc_time_microdiff(&end, &start);
+	printf("%-6s %-8s %10u ops %8.3f s %8.1f ns/op\n", what, phase, ops,
+	       (double)us / 1000000, ops == 0 ? 0.0 : (double)us * 1000 / ops);
+}
+
+static void
+bench_heap(isc_mem_t *mctx, element_t *elts, unsigned int count,
+	   unsigned int rounds, unsigned int spread)
+{
+	isc_heap_t *heap = NULL;
+	isc_uint64_t now = 0, due;
+	element_t *e;
+	unsigned int i, r, n;
+
+	RUNTIME_CHECK(isc_heap_create(mctx, compare, idx, count, &heap) ==
+		      ISC_R_SUCCESS);
+
+	state = 1;
+	begin();
+	for (i = 0; i < count; i++) {
+		elts[i].due = now + 1 + next() % spread;
+		RUNTIME_CHECK(isc_heap_insert(heap, &elts[i]) ==
+			      ISC_R_SUCCESS);
+	}
+	report("heap", "insert", count);
+
+	begin();
+	for (r = 0; r < rounds; r++) {
+		now += spread / 64;
+		for (i = 0; i < count; i++) {
+			due = now + 1 + next() % spread;
+			e = &elts[i];
+			if (due < e->due) {
+				e->due = due;
+				isc_heap_increased(heap, e->index);
+			} else {
+				e->due = due;
+				isc_heap_decreased(heap, e->index);
+			}
+		}
+	}
+	report("heap", "reset", count * rounds);
+
+	begin();
+	n = 0;
+	while ((e = isc_heap_element(heap, 1)) != NULL) {
+		if (e->due > now) {
+			now++;
+			continue;
+		}
+		isc_heap_delete(heap, 1);
+		n++;
+	}
+	report("heap", "expire", n);
+	INSIST(n == count);
+
+	isc_heap_destroy(&heap);
+}
+
+static void
+bench_wheel(isc_mem_t *mctx, element_t *elts, unsigned int count,
+	    unsigned int rounds, unsigned int spread)
+{
+	isc_wheel_t *wheel = NULL;
+	isc_uint64_t now = 0;
+	element_t *e;
+	unsigned int i, r, n;
+
+	RUNTIME_CHECK(isc_wheel_create(mctx, now, &wheel) == ISC_R_SUCCESS);
+
+	for (i = 0; i < count; i++)
+		ISC_WHEELENTRY_INIT(&elts[i].entry);
+
+	state = 1;
+	begin();
+	for (i = 0; i < count; i++)
+		isc_wheel_insert(wheel, &elts[i].entry,
+				 now + 1 + next() % spread, &elts[i]);
+	report("wheel", "insert", count);
+
+	begin();
+	for (r = 0; r < rounds; r++) {
+		now += spread / 64;
+		for (i = 0; i < count; i++) {
+			isc_wheel_delete(wheel, &elts[i].entry);
+			isc_wheel_insert(wheel, &elts[i].entry,
+					 now + 1 + next() % spread, &elts[i]);
+		}
+	}
+	report("wheel", "reset", count * rounds);
+
+	begin();
+	n = 0;
+	while (isc_wheel_count(wheel) > 0) {
+		while ((e = isc_wheel_expire(wheel, now)) != NULL)
+			n++;
+		now++;
+	}
+	report("wheel", "expire", n);
+	INSIST(n == count);
+
+	isc_wheel_destroy(&wheel);
+}
+
+static void
+tick(isc_task_t *task, isc_event_t *event) {
+	UNUSED(task);
+
+	isc_event_free(&event);
+}
+
+static void
+bench_timer(isc_mem_t *mctx, unsigned int count, unsigned int rounds) {
+	isc_taskmgr_t *taskmgr = NULL;
+	isc_timermgr_t *timermgr = NULL;
+	isc_task_t *task = NULL;
+	isc_timer_t **timers;
+	isc_interval_t interval;
+	unsigned int i, r;
+
+	timers = malloc(count * sizeof(*timers));
+	RUNTIME_CHECK(timers != NULL);
+
+	RUNTIME_CHECK(isc_taskmgr_create(mctx, 1, 0, &taskmgr) ==
+		      ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_timermgr_create(mctx, &timermgr) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(isc_task_create(taskmgr, 0, &task) == ISC_R_SUCCESS);
+
+	/*
+	 * Idle timers far enough out that none of them fire.
+	 */
+	isc_interval_set(&interval, 3600, 0);
+	begin();
+	for (i = 0; i < count; i++) {
+		timers[i] = NULL;
+		RUNTIME_CHECK(isc_timer_create(timermgr,
+					       isc_timertype_once, NULL,
+					       &interval, task, tick, NULL,
+					       &timers[i]) == ISC_R_SUCCESS);
+	}
+	report("timer", "create", count);
+
+	begin();
+	for (r = 0; r < rounds; r++) {
+		isc_interval_set(&interval, 3600 + next() % 600, 0);
+		for (i = 0; i < count; i++)
+			RUNTIME_CHECK(isc_timer_reset(timers[i],
+						      isc_timertype_once,
+						      NULL, &interval,
+						      ISC_FALSE) ==
+				      ISC_R_SUCCESS);
+	}
+	report("timer", "reset", count * rounds);
+
+	begin();
+	for (i = 0; i < count; i++)
+		isc_timer_detach(&timers[i]);
+	report("timer", "destroy", count);
+
+	isc_task_detach(&task);
+	isc_timermgr_destroy(&timermgr);
+	isc_taskmgr_destroy(&taskmgr);
+	free(timers);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *mctx = NULL;
+	element_t *elts;
+	unsigned int count = 1000000, rounds = 4, spread = 60000;
+	int c, errflg = 0;
+
+	while ((c = isc_commandline_parse(argc, argv, ":n:r:s:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = atoi(isc_commandline_argument);
+			break;
+		case 'r':
+			rounds = atoi(isc_commandline_argument);
+			break;
+		case 's':
+			spread = atoi(isc_commandline_argument);
+			break;
+		case ':':
+			fprintf(stderr,
+				"Option -%c requires an operand\n",
+				isc_commandline_option);
+			errflg++;
+			break;
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognised option: -%c\n",
+				isc_commandline_option);
+			errflg++;
+		}
+	}
+
+	if (errflg || count == 0 || spread < 64) {
+		fprintf(stderr, "Usage:\n");
+		fprintf(stderr,
+			"\ttimerbench [-n count] [-r rounds] [-s spread]\n");
+		exit(1);
+	}
+
+	RUNTIME_CHECK(isc_mem_create(0, 0, &mctx) == ISC_R_SUCCESS);
+
+	elts = malloc(count * sizeof(*elts));
+	RUNTIME_CHECK(elts != NULL);
+
+	printf("%u timers, %u resets each, deadlines up to %u ticks out\n",
+	       count, rounds, spread);
+	bench_heap(mctx, elts, count, rounds, spread);
+	bench_wheel(mctx, elts, count, rounds, spread);
+	bench_timer(mctx, count, rounds);
+
+	free(elts);
+	isc_mem_destroy(&mctx);
+
+	return (0);
+}
@@ -35,6 +35,7 @@
 #include <pk11/site.h>
 
 #include <dns/acl.h>
+#include <dns/db.h>
 #include <dns/dnstap.h>
 #include <dns/fixedname.h>
 #include <dns/rdataclass.h>
@@ -1037,6 +1038,28 @@ check_options(const cfg_obj_t *options, isc_log_t *logctx, isc_mem_t *mctx,
 		}
 	}
 
+	/*
+	 * A cache needs at least two node locks.
+	 */
+	for (i = 0; i < 2; i++) {
+		const char *option = (i == 0) ? "cache-node-locks" :
+						"zone-node-locks";
+		isc_uint32_t val, min = (i == 0) ? 2 : 1;
+
+		obj = NULL;
+		(void)cfg_map_get(options, option, &obj);
+		if (obj == NULL || !cfg_obj_isuint32(obj))
+			continue;
+		val = cfg_obj_asuint32(obj);
+		if (val < min || val > DNS_DB_NODELOCKCOUNT_MAX) {
+			cfg_obj_log(obj, logctx, ISC_LOG_ERROR,
+				    "%s '%u' is out of range (%u..%u)",
+				    option, val, min,
+				    DNS_DB_NODELOCKCOUNT_MAX);
+			result = ISC_R_RANGE;
+		}
+	}
+
 	obj = NULL;
 	cfg_map_get(options, "sig-validity-interval", &obj);
 	if (obj != NULL) {
@@ -1368,6 +1391,14 @@ check_options(const cfg_obj_t *options, isc_log_t *logctx, isc_mem_t *mctx,
 				    "(%d seconds)", recheck, lifetime);
 	}
 
+	obj = NULL;
+	(void)cfg_map_get(options, "stale-answer-ttl", &obj);
+	if (obj != NULL && cfg_obj_asuint32(obj) == 0) {
+		cfg_obj_log(obj, logctx, ISC_LOG_ERROR,
+			    "'stale-answer-ttl' may not be zero");
+		result = ISC_R_RANGE;
+	}
+
 	obj = NULL;
 	(void) cfg_map_get(options, "cookie-algorithm", &obj);
 	if (obj != NULL)
@@ -2408,7 +2439,8 @@ check_zoneconf(const cfg_obj_t *zconfig, const cfg_obj_t *voptions,
 	    (tresult == ISC_R_NOTFOUND ||
 	    (tresult == ISC_R_SUCCESS &&
 	     (strcmp("rbt", cfg_obj_asstring(obj)) == 0 ||
-	      strcmp("rbt64", cfg_obj_asstring(obj)) == 0))))
+	      strcmp("rbt64", cfg_obj_asstring(obj)) == 0 ||
+	      strcmp("qp", cfg_obj_asstring(obj)) == 0))))
 	{
 		isc_result_t res1;
 		const cfg_obj_t *fileobj = NULL;
@@ -2439,6 +2471,57 @@ check_zoneconf(const cfg_obj_t *zconfig, const cfg_obj_t *voptions,
 		}
 	}
 
+	/*
+	 * The "qp" database cannot be saved in map format and does not
+	 * keep the re-signing times needed by inline-signing and
+	 * auto-dnssec.
+	 */
+	obj = NULL;
+	(void)cfg_map_get(zoptions, "database", &obj);
+	if (!dlz && obj != NULL && strcmp("qp", cfg_obj_asstring(obj)) == 0) {
+		obj = NULL;
+		(void)cfg_map_get(zoptions, "masterfile-format", &obj);
+		if (obj == NULL && voptions != NULL)
+			(void)cfg_map_get(voptions, "masterfile-format", &obj);
+		if (obj == NULL && goptions != NULL)
+			(void)cfg_map_get(goptions, "masterfile-format", &obj);
+		if (obj != NULL &&
+		    strcasecmp(cfg_obj_asstring(obj), "map") == 0)
+		{
+			cfg_obj_log(zconfig, logctx, ISC_LOG_ERROR,
+				    "zone '%s': 'database \"qp\"' is not "
+				    "compatible with 'masterfile-format map'",
+				    znamestr);
+			result = ISC_R_FAILURE;
+		}
+
+		obj = NULL;
+		(void)cfg_map_get(zoptions, "inline-signing", &obj);
+		if (obj == NULL && voptions != NULL)
+			(void)cfg_map_get(voptions, "inline-signing", &obj);
+		if (obj == NULL && goptions != NULL)
+			(void)cfg_map_get(goptions, "inline-signing", &obj);
+		if (obj != NULL && cfg_obj_asboolean(obj)) {
+			cfg_obj_log(zconfig, logctx, ISC_LOG_ERROR,
+				    "zone '%s': 'database \"qp\"' is not "
+				    "compatible with 'inline-signing yes'",
+				    znamestr);
+			result = ISC_R_FAILURE;
+		}
+
+		obj = NULL;
+		(void)cfg_map_get(zoptions, "auto-dnssec", &obj);
+		if (obj != NULL &&
+		    strcasecmp(cfg_obj_asstring(obj), "off") != 0)
+		{
+			cfg_obj_log(zconfig, logctx, ISC_LOG_ERROR,
+				    "zone '%s': 'database \"qp\"' is not "
+				    "compatible with 'auto-dnssec %s'",
+				    znamestr, cfg_obj_asstring(obj));
+			result = ISC_R_FAILURE;
+		}
+	}
+
 	return (result);
 }
 
@@ -3015,11 +3098,12 @@ check_trusted_key(const cfg_obj_t *key, isc_boolean_t managed,
 
 static isc_result_t
 check_rpz_catz(const char *rpz_catz, const cfg_obj_t *rpz_obj,
-	       const char *viewname, isc_symtab_t *symtab, isc_log_t *logctx)
+	       isc_boolean_t rpz, const char *viewname, isc_symtab_t *symtab,
+	       isc_log_t *logctx)
 {
 	const cfg_listelt_t *element;
 	const cfg_obj_t *obj, *nameobj, *zoneobj;
-	const char *zonename, *zonetype;
+	const char *zonename, *zonetype, *dbtype;
 	const char *forview = " for view ";
 	isc_symvalue_t value;
 	isc_result_t result, tresult;
@@ -3043,6 +3127,7 @@ check_rpz_catz(const char *rpz_catz, const cfg_obj_t *rpz_obj,
 		nameobj = cfg_tuple_get(obj, "zone name");
 		zonename = cfg_obj_asstring(nameobj);
 		zonetype = "";
+		dbtype = "";
 
 		tresult = dns_name_fromstring(name, zonename, 0, NULL);
 		if (tresult != ISC_R_SUCCESS) {
@@ -3063,6 +3148,11 @@ check_rpz_catz(const char *rpz_catz, const cfg_obj_t *rpz_obj,
 				(void)cfg_map_get(zoneobj, "type", &obj);
 			if (obj != NULL)
 				zonetype = cfg_obj_asstring(obj);
+			obj = NULL;
+			if (zoneobj != NULL && cfg_obj_ismap(zoneobj))
+				(void)cfg_map_get(zoneobj, "database", &obj);
+			if (obj != NULL)
+				dbtype = cfg_obj_asstring(obj);
 		}
 		if (strcasecmp(zonetype, "master") != 0 &&
 		    strcasecmp(zonetype, "slave") != 0) {
@@ -3072,6 +3162,16 @@ check_rpz_catz(const char *rpz_catz, const cfg_obj_t *rpz_obj,
 			if (result == ISC_R_SUCCESS)
 				result = ISC_R_FAILURE;
 		}
+		/*
+		 * The "qp" database cannot feed the policy summary.
+		 */
+		if (rpz && strcmp(dbtype, "qp") == 0) {
+			cfg_obj_log(nameobj, logctx, ISC_LOG_ERROR,
+				    "%s '%s'%s%s cannot use 'database \"qp\"'",
+				    rpz_catz, zonename, forview, viewname);
+			if (result == ISC_R_SUCCESS)
+				result = ISC_R_FAILURE;
+		}
 	}
 	return (result);
 }
@@ -3161,12 +3261,12 @@ check_viewconf(const cfg_obj_t *config, const cfg_obj_t *voptions,
 	if (opts != NULL) {
 		obj = NULL;
 		if (cfg_map_get(opts, "response-policy", &obj) == ISC_R_SUCCESS
-		    && check_rpz_catz("response-policy zone", obj,
+		    && check_rpz_catz("response-policy zone", obj, ISC_TRUE,
 				 viewname, symtab, logctx) != ISC_R_SUCCESS)
 			result = ISC_R_FAILURE;
 		obj = NULL;
 		if (cfg_map_get(opts, "catalog-zones", &obj) == ISC_R_SUCCESS
-		    && check_rpz_catz("catalog zone", obj,
+		    && check_rpz_catz("catalog zone", obj, ISC_FALSE,
 				  viewname, symtab, logctx) != ISC_R_SUCCESS)
 			result = ISC_R_FAILURE;
 	}
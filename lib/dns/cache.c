@@ -12,11 +12,15 @@
 
 #include <config.h>
 
+#include <isc/crc64.h>
+#include <isc/file.h>
 #include <isc/json.h>
 #include <isc/mem.h>
 #include <isc/print.h>
 #include <isc/string.h>
 #include <isc/stats.h>
+#include <isc/stdio.h>
+#include <isc/stdtime.h>
 #include <isc/task.h>
 #include <isc/time.h>
 #include <isc/timer.h>
@@ -27,10 +31,12 @@
 #include <dns/db.h>
 #include <dns/dbiterator.h>
 #include <dns/events.h>
+#include <dns/fixedname.h>
 #include <dns/lib.h>
 #include <dns/log.h>
 #include <dns/masterdump.h>
 #include <dns/rdata.h>
+#include <dns/rdatalist.h>
 #include <dns/rdataset.h>
 #include <dns/rdatasetiter.h>
 #include <dns/result.h>
@@ -38,6 +44,14 @@
 
 #include "rbtdb.h"
 
+#ifndef WIN32
+#include <sys/mman.h>
+#else
+#define PROT_READ	0x01
+#define MAP_PRIVATE	0x0002
+#define MAP_FAILED	((void *)-1)
+#endif
+
 #define CACHE_MAGIC		ISC_MAGIC('$', '$', '$', '$')
 #define VALID_CACHE(cache)	ISC_MAGIC_VALID(cache, CACHE_MAGIC)
 
@@ -54,6 +68,23 @@
  */
 #define DNS_CACHE_CLEANERINCREMENT	1000U	/*%< Number of nodes. */
 
+/*!
+ * Control cleaning by bucket (see dns_db_cleanbucket()).
+ * CLEANERTICK is how often, in seconds, every cleaning unit is started.
+ * Each start allows between 1 and CLEANERMAXPASSES passes over the
+ * unit's buckets, more as the cache gets closer to its size limit;
+ * once it is over the limit passes continue until it is back below.
+ * CLEANERINCREMENT is how many rdatasets a pass removes from a bucket
+ * at most.
+ */
+#define DNS_CACHE_CLEANERTICK		1U	/*%< Seconds. */
+#define DNS_CACHE_CLEANERMAXPASSES	16U
+
+/*%
+ * Second argument of "rbt" cache databases, see dns_rbtdb_create().
+ */
+static char sharded[] = "sharded";
+
 /***
  ***	Types
  ***/
@@ -80,6 +111,20 @@ typedef enum {
 			 (c)->iterator != NULL && \
 			 (c)->resched_event == NULL)
 
+/*%
+ * A cleaning unit cleans buckets 'index', 'index' + 'nunits', ... of a
+ * cache database which supports dns_db_cleanbucket(), in its own task,
+ * so that the units of a cache run in parallel on the task manager's
+ * worker threads.
+ */
+typedef struct cache_cleanunit {
+	dns_cache_t	*cache;
+	unsigned int	index;
+	isc_task_t	*task;
+	isc_event_t	*event;		/*% NULL while a pass is pending. */
+	unsigned int	passes;		/*% Passes left until the next tick. */
+} cache_cleanunit_t;
+
 /*%
  * Accesses to a cache cleaner object are synchronized through
  * task/event serialization, or locked from the cache object.
@@ -108,6 +153,17 @@ struct cache_cleaner {
 	cleaner_state_t	state;		/*% Idle/Busy. */
 	isc_boolean_t	overmem;	/*% The cache is in an overmem state. */
 	isc_boolean_t	 replaceiterator;
+
+	/*
+	 * Cleaning by bucket.  'units' and 'nunits' don't change once
+	 * set up; the 'event' and 'passes' of each unit, and 'passes'
+	 * and 'exiting' below, are locked by 'lock'.
+	 */
+	cache_cleanunit_t *units;
+	unsigned int	nunits;
+	isc_timer_t	*tick_timer;	/*% Runs in the first unit's task. */
+	unsigned int	passes;		/*% Passes allowed per tick. */
+	isc_boolean_t	exiting;
 };
 
 /*%
@@ -133,6 +189,7 @@ struct dns_cache {
 	int			db_argc;
 	char			**db_argv;
 	size_t			size;
+	dns_ttl_t		serve_stale_ttl;
 	isc_stats_t		*stats;
 
 	/* Locked by 'filelock'. */
@@ -160,6 +217,22 @@ cleaner_shutdown_action(isc_task_t *task, isc_event_t *event);
 static void
 overmem_cleaning_action(isc_task_t *task, isc_event_t *event);
 
+static isc_result_t
+cleanunits_init(dns_cache_t *cache, isc_taskmgr_t *taskmgr,
+		isc_timermgr_t *timermgr, cache_cleaner_t *cleaner);
+
+static void
+cleanunit_action(isc_task_t *task, isc_event_t *event);
+
+static void
+cleanunit_shutdown_action(isc_task_t *task, isc_event_t *event);
+
+static void
+cleaner_tick_action(isc_task_t *task, isc_event_t *event);
+
+static isc_result_t
+cache_dump(dns_cache_t *cache, dns_db_t *db);
+
 static inline isc_result_t
 cache_create_db(dns_cache_t *cache, dns_db_t **db) {
 	return (dns_db_create(cache->mctx, cache->db_type, dns_rootname,
@@ -232,11 +305,13 @@ dns_cache_create3(isc_mem_t *cmctx, isc_mem_t *hmctx, isc_taskmgr_t *taskmgr,
 
 	cache->references = 1;
 	cache->live_tasks = 0;
+	cache->serve_stale_ttl = 0;
 	cache->rdclass = rdclass;
 
 	cache->stats = NULL;
-	result = isc_stats_create(cmctx, &cache->stats,
-				  dns_cachestatscounter_max);
+	result = isc_stats_create2(cmctx, &cache->stats,
+				   dns_cachestatscounter_max,
+				   ISC_STATSCREATE_SHARDED);
 	if (result != ISC_R_SUCCESS)
 		goto cleanup_filelock;
 
@@ -248,11 +323,12 @@ dns_cache_create3(isc_mem_t *cmctx, isc_mem_t *hmctx, isc_taskmgr_t *taskmgr,
 
 	/*
 	 * For databases of type "rbt" we pass hmctx to dns_db_create()
-	 * via cache->db_argv, followed by the rest of the arguments in
-	 * db_argv (of which there really shouldn't be any).
+	 * via cache->db_argv, and ask for a sharded tree, followed by the
+	 * rest of the arguments in db_argv (of which there really shouldn't
+	 * be any).
 	 */
 	if (strcmp(cache->db_type, "rbt") == 0)
-		extra = 1;
+		extra = 2;
 
 	cache->db_argc = db_argc + extra;
 	cache->db_argv = NULL;
@@ -269,6 +345,8 @@ dns_cache_create3(isc_mem_t *cmctx, isc_mem_t *hmctx, isc_taskmgr_t *taskmgr,
 			cache->db_argv[i] = NULL;
 
 		cache->db_argv[0] = (char *) hmctx;
+		if (extra > 1)
+			cache->db_argv[1] = sharded;
 		for (i = extra; i < cache->db_argc; i++) {
 			cache->db_argv[i] = isc_mem_strdup(cmctx,
 							   db_argv[i - extra]);
@@ -301,16 +379,7 @@ dns_cache_create3(isc_mem_t *cmctx, isc_mem_t *hmctx, isc_taskmgr_t *taskmgr,
 
 	cache->magic = CACHE_MAGIC;
 
-	/*
-	 * RBT-type cache DB has its own mechanism of cache cleaning and doesn't
-	 * need the control of the generic cleaner.
-	 */
-	if (strcmp(db_type, "rbt") == 0)
-		result = cache_cleaner_init(cache, NULL, NULL, &cache->cleaner);
-	else {
-		result = cache_cleaner_init(cache, taskmgr, timermgr,
-					    &cache->cleaner);
-	}
+	result = cache_cleaner_init(cache, taskmgr, timermgr, &cache->cleaner);
 	if (result != ISC_R_SUCCESS)
 		goto cleanup_db;
 
@@ -368,6 +437,23 @@ cache_free(dns_cache_t *cache) {
 	if (cache->cleaner.iterator != NULL)
 		dns_dbiterator_destroy(&cache->cleaner.iterator);
 
+	if (cache->cleaner.tick_timer != NULL)
+		isc_timer_detach(&cache->cleaner.tick_timer);
+
+	if (cache->cleaner.units != NULL) {
+		unsigned int n;
+
+		for (n = 0; n < cache->cleaner.nunits; n++) {
+			cache_cleanunit_t *unit = &cache->cleaner.units[n];
+			if (unit->event != NULL)
+				isc_event_free(&unit->event);
+			if (unit->task != NULL)
+				isc_task_detach(&unit->task);
+		}
+		isc_mem_put(cache->mctx, cache->cleaner.units,
+			    cache->cleaner.nunits * sizeof(cache_cleanunit_t));
+	}
+
 	DESTROYLOCK(&cache->cleaner.lock);
 
 	if (cache->filename) {
@@ -380,12 +466,12 @@ cache_free(dns_cache_t *cache) {
 
 	if (cache->db_argv != NULL) {
 		/*
-		 * We don't free db_argv[0] in "rbt" cache databases
-		 * as it's a pointer to hmctx
+		 * We don't free db_argv[0] and db_argv[1] in "rbt" cache
+		 * databases as they're a pointer to hmctx and a constant.
 		 */
 		int extra = 0;
 		if (strcmp(cache->db_type, "rbt") == 0)
-			extra = 1;
+			extra = 2;
 		for (i = extra; i < cache->db_argc; i++)
 			if (cache->db_argv[i] != NULL)
 				isc_mem_free(cache->mctx, cache->db_argv[i]);
@@ -448,7 +534,7 @@ dns_cache_detach(dns_cache_t **cachep) {
 		 * When the cache is shut down, dump it to a file if one is
 		 * specified.
 		 */
-		isc_result_t result = dns_cache_dump(cache);
+		isc_result_t result = cache_dump(cache, cache->db);
 		if (result != ISC_R_SUCCESS)
 			isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
 				      DNS_LOGMODULE_CACHE, ISC_LOG_WARNING,
@@ -456,10 +542,20 @@ dns_cache_detach(dns_cache_t **cachep) {
 				      isc_result_totext(result));
 
 		/*
-		 * If the cleaner task exists, let it free the cache.
+		 * If the cleaner tasks exist, let them free the cache.
 		 */
 		if (cache->live_tasks > 0) {
-			isc_task_shutdown(cache->cleaner.task);
+			unsigned int n;
+
+			if (cache->cleaner.task != NULL)
+				isc_task_shutdown(cache->cleaner.task);
+
+			LOCK(&cache->cleaner.lock);
+			cache->cleaner.exiting = ISC_TRUE;
+			UNLOCK(&cache->cleaner.lock);
+			for (n = 0; n < cache->cleaner.nunits; n++)
+				isc_task_shutdown(cache->cleaner.units[n].task);
+
 			free_cache = ISC_FALSE;
 		}
 	}
@@ -502,37 +598,570 @@ dns_cache_setfilename(dns_cache_t *cache, const char *filename) {
 	return (ISC_R_SUCCESS);
 }
 
+/*
+ * Cache snapshots.
+ *
+ * dns_cache_dump() saves the live rdatasets of the cache in a binary
+ * "snapshot" file, which dns_cache_load() maps into memory and adds
+ * back into the cache; unlike a text dump this needs no parsing, and
+ * it keeps the trust level (and so the DNSSEC validation status) and
+ * the negative cache entries.  All integers are in network byte order.
+ *
+ * The file starts with a header of SNAPSHOT_HEADERLEN bytes:
+ *
+ *	char[32]	SNAPSHOT_VERSION, NUL padded
+ *	uint32		time of the dump: TTLs are relative to this
+ *	uint16		class
+ *	uint16		reserved, 0
+ *	uint32, uint32	CRC-64 of everything after the header
+ *
+ * It is zeroed while the rest of the file is written, so a file that
+ * was not completely written is never loaded.  One record follows for
+ * each rdataset:
+ *
+ *	uint32		length of the record, this field included
+ *	uint16		type
+ *	uint16		covers
+ *	uint32		TTL at the time of the dump
+ *	uint8		trust
+ *	uint8		attributes, SNAPSHOT_ATTR_*
+ *	uint16		number of rdatas
+ *	uint8		length of the owner name
+ *	...		owner name in uncompressed wire format
+ *
+ * followed, for each rdata, by its uint16 length and its data.
+ */
+#define SNAPSHOT_VERSION	"BIND 9 Cache Snapshot 1"
+#define SNAPSHOT_HEADERLEN	48
+#define SNAPSHOT_RECORDLEN	17	/*%< Fixed part of a record */
+
+#define SNAPSHOT_ATTR_NEGATIVE	0x01
+#define SNAPSHOT_ATTR_NXDOMAIN	0x02
+#define SNAPSHOT_ATTR_OPTOUT	0x04
+#define SNAPSHOT_ATTR_PREFETCH	0x08
+
+static void
+snapshot_header(isc_buffer_t *b, isc_stdtime_t now,
+		dns_rdataclass_t rdclass, isc_uint64_t crc)
+{
+	char version[32];
+
+	memset(version, 0, sizeof(version));
+	strlcpy(version, SNAPSHOT_VERSION, sizeof(version));
+	isc_buffer_putmem(b, (unsigned char *)version, sizeof(version));
+	isc_buffer_putuint32(b, now);
+	isc_buffer_putuint16(b, rdclass);
+	isc_buffer_putuint16(b, 0);
+	isc_buffer_putuint32(b, (isc_uint32_t)(crc >> 32));
+	isc_buffer_putuint32(b, (isc_uint32_t)(crc & 0xffffffff));
+	INSIST(isc_buffer_usedlength(b) == SNAPSHOT_HEADERLEN);
+}
+
+/*
+ * Write 'rdataset', owned by 'name', to 'f'.  Rdatasets with proofs of
+ * nonexistence attached are left out: the proofs are not saved, and
+ * without them, answers synthesized from wildcards could not be
+ * validated.
+ */
+static isc_result_t
+snapshot_rdataset(FILE *f, dns_name_t *name, dns_rdataset_t *rdataset,
+		  isc_uint64_t *crc, unsigned int *countp)
+{
+	unsigned char data[SNAPSHOT_RECORDLEN + DNS_NAME_MAXWIRE];
+	isc_buffer_t b;
+	isc_region_t r;
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	isc_uint32_t length;
+	unsigned int count = 0;
+	unsigned int attributes = 0;
+	isc_result_t result;
+
+	if ((rdataset->attributes &
+	     (DNS_RDATASETATTR_NOQNAME | DNS_RDATASETATTR_CLOSEST)) != 0 ||
+	    rdataset->ttl == 0)
+		return (ISC_R_SUCCESS);
+
+	length = SNAPSHOT_RECORDLEN + name->length;
+	for (result = dns_rdataset_first(rdataset);
+	     result == ISC_R_SUCCESS;
+	     result = dns_rdataset_next(rdataset))
+	{
+		dns_rdataset_current(rdataset, &rdata);
+		length += 2 + rdata.length;
+		count++;
+		dns_rdata_reset(&rdata);
+	}
+	if (result != ISC_R_NOMORE)
+		return (result);
+	if (count == 0)
+		return (ISC_R_SUCCESS);
+
+	if ((rdataset->attributes & DNS_RDATASETATTR_NEGATIVE) != 0)
+		attributes |= SNAPSHOT_ATTR_NEGATIVE;
+	if ((rdataset->attributes & DNS_RDATASETATTR_NXDOMAIN) != 0)
+		attributes |= SNAPSHOT_ATTR_NXDOMAIN;
+	if ((rdataset->attributes & DNS_RDATASETATTR_OPTOUT) != 0)
+		attributes |= SNAPSHOT_ATTR_OPTOUT;
+	if ((rdataset->attributes & DNS_RDATASETATTR_PREFETCH) != 0)
+		attributes |= SNAPSHOT_ATTR_PREFETCH;
+
+	isc_buffer_init(&b, data, sizeof(data));
+	isc_buffer_putuint32(&b, length);
+	isc_buffer_putuint16(&b, rdataset->type);
+	isc_buffer_putuint16(&b, rdataset->covers);
+	isc_buffer_putuint32(&b, rdataset->ttl);
+	isc_buffer_putuint8(&b, rdataset->trust);
+	isc_buffer_putuint8(&b, attributes);
+	isc_buffer_putuint16(&b, count);
+	isc_buffer_putuint8(&b, name->length);
+	isc_buffer_putmem(&b, name->ndata, name->length);
+	isc_buffer_usedregion(&b, &r);
+	isc_crc64_update(crc, r.base, r.length);
+	result = isc_stdio_write(r.base, 1, r.length, f, NULL);
+	if (result != ISC_R_SUCCESS)
+		return (result);
+
+	for (result = dns_rdataset_first(rdataset);
+	     result == ISC_R_SUCCESS;
+	     result = dns_rdataset_next(rdataset))
+	{
+		dns_rdataset_current(rdataset, &rdata);
+		isc_buffer_init(&b, data, sizeof(data));
+		isc_buffer_putuint16(&b, rdata.length);
+		isc_crc64_update(crc, data, 2);
+		isc_crc64_update(crc, rdata.data, rdata.length);
+		result = isc_stdio_write(data, 1, 2, f, NULL);
+		if (result == ISC_R_SUCCESS)
+			result = isc_stdio_write(rdata.data, 1, rdata.length,
+						 f, NULL);
+		dns_rdata_reset(&rdata);
+		if (result != ISC_R_SUCCESS)
+			return (result);
+	}
+	if (result != ISC_R_NOMORE)
+		return (result);
+
+	(*countp)++;
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+snapshot_write(dns_db_t *db, FILE *f, isc_stdtime_t now,
+	       unsigned int *countp)
+{
+	unsigned char data[SNAPSHOT_HEADERLEN];
+	dns_dbiterator_t *dbiter = NULL;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	isc_buffer_t b;
+	isc_uint64_t crc;
+	isc_result_t result;
+
+	isc_crc64_init(&crc);
+
+	/*
+	 * A zeroed header, until all the data is written.
+	 */
+	memset(data, 0, sizeof(data));
+	result = isc_stdio_write(data, 1, sizeof(data), f, NULL);
+	if (result != ISC_R_SUCCESS)
+		return (result);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	result = dns_db_createiterator(db, 0, &dbiter);
+	if (result != ISC_R_SUCCESS)
+		return (result);
+
+	for (result = dns_dbiterator_first(dbiter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_next(dbiter))
+	{
+		dns_rdatasetiter_t *rdsiter = NULL;
+		dns_rdataset_t rdataset;
+		dns_dbnode_t *node = NULL;
+
+		result = dns_dbiterator_current(dbiter, &node, name);
+		if (result != ISC_R_SUCCESS)
+			break;
+		/*
+		 * Don't hold the tree lock while writing.
+		 */
+		RUNTIME_CHECK(dns_dbiterator_pause(dbiter) == ISC_R_SUCCESS);
+
+		result = dns_db_allrdatasets(db, node, NULL, now, &rdsiter);
+		if (result != ISC_R_SUCCESS) {
+			dns_db_detachnode(db, &node);
+			break;
+		}
+		dns_rdataset_init(&rdataset);
+		for (result = dns_rdatasetiter_first(rdsiter);
+		     result == ISC_R_SUCCESS;
+		     result = dns_rdatasetiter_next(rdsiter))
+		{
+			dns_rdatasetiter_current(rdsiter, &rdataset);
+			result = snapshot_rdataset(f, name, &rdataset, &crc,
+						   countp);
+			dns_rdataset_disassociate(&rdataset);
+			if (result != ISC_R_SUCCESS)
+				break;
+		}
+		dns_rdatasetiter_destroy(&rdsiter);
+		dns_db_detachnode(db, &node);
+		if (result != ISC_R_NOMORE)
+			break;
+	}
+	dns_dbiterator_destroy(&dbiter);
+	if (result != ISC_R_NOMORE)
+		return (result);
+
+	isc_crc64_final(&crc);
+	isc_buffer_init(&b, data, sizeof(data));
+	snapshot_header(&b, now, dns_db_class(db), crc);
+	result = isc_stdio_flush(f);
+	if (result == ISC_R_SUCCESS)
+		result = isc_stdio_seek(f, 0, SEEK_SET);
+	if (result == ISC_R_SUCCESS)
+		result = isc_stdio_write(data, 1, sizeof(data), f, NULL);
+	if (result == ISC_R_SUCCESS)
+		result = isc_stdio_flush(f);
+	if (result == ISC_R_SUCCESS)
+		result = isc_stdio_sync(f);
+	return (result);
+}
+
+/*
+ * Add the records of the snapshot 'base', of 'size' bytes, to 'db'.
+ */
+static isc_result_t
+snapshot_import(dns_db_t *db, isc_mem_t *mctx, unsigned char *base,
+		size_t size, isc_stdtime_t now, unsigned int *countp)
+{
+	char version[32];
+	isc_buffer_t b;
+	isc_region_t r;
+	isc_uint64_t crc, filecrc;
+	isc_stdtime_t dumptime;
+	isc_uint32_t elapsed = 0;
+	dns_rdataclass_t rdclass;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	dns_dbnode_t *node = NULL;
+	dns_rdata_t *rdatas = NULL;
+	unsigned int nrdatas = 0;
+	isc_result_t result = ISC_R_SUCCESS;
+
+	if (size < SNAPSHOT_HEADERLEN)
+		return (ISC_R_INVALIDFILE);
+	isc_buffer_init(&b, base, (unsigned int)size);
+	isc_buffer_add(&b, (unsigned int)size);
+
+	memset(version, 0, sizeof(version));
+	strlcpy(version, SNAPSHOT_VERSION, sizeof(version));
+	if (memcmp(isc_buffer_current(&b), version, sizeof(version)) != 0)
+		return (ISC_R_INVALIDFILE);
+	isc_buffer_forward(&b, sizeof(version));
+	dumptime = isc_buffer_getuint32(&b);
+	rdclass = isc_buffer_getuint16(&b);
+	(void)isc_buffer_getuint16(&b);
+	filecrc = (isc_uint64_t)isc_buffer_getuint32(&b) << 32;
+	filecrc |= isc_buffer_getuint32(&b);
+	if (rdclass != dns_db_class(db))
+		return (DNS_R_BADCLASS);
+
+	isc_buffer_remainingregion(&b, &r);
+	isc_crc64_init(&crc);
+	isc_crc64_update(&crc, r.base, r.length);
+	isc_crc64_final(&crc);
+	if (crc != filecrc)
+		return (ISC_R_INVALIDFILE);
+
+	if (now > dumptime)
+		elapsed = now - dumptime;
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+
+	while (isc_buffer_remaininglength(&b) > 0) {
+		dns_rdatalist_t rdatalist;
+		dns_rdataset_t rdataset;
+		dns_name_t owner;
+		isc_buffer_t record;
+		isc_uint32_t length;
+		unsigned int i, count, attributes, namelen;
+		dns_trust_t trust;
+
+		if (isc_buffer_remaininglength(&b) < SNAPSHOT_RECORDLEN) {
+			result = ISC_R_RANGE;
+			break;
+		}
+		length = isc_buffer_getuint32(&b);
+		if (length < SNAPSHOT_RECORDLEN ||
+		    length - 4 > isc_buffer_remaininglength(&b))
+		{
+			result = ISC_R_RANGE;
+			break;
+		}
+		isc_buffer_init(&record, isc_buffer_current(&b), length - 4);
+		isc_buffer_add(&record, length - 4);
+		isc_buffer_forward(&b, length - 4);
+
+		dns_rdatalist_init(&rdatalist);
+		rdatalist.rdclass = rdclass;
+		rdatalist.type = isc_buffer_getuint16(&record);
+		rdatalist.covers = isc_buffer_getuint16(&record);
+		rdatalist.ttl = isc_buffer_getuint32(&record);
+		trust = isc_buffer_getuint8(&record);
+		attributes = isc_buffer_getuint8(&record);
+		count = isc_buffer_getuint16(&record);
+		namelen = isc_buffer_getuint8(&record);
+		if (count == 0 ||
+		    namelen > isc_buffer_remaininglength(&record))
+		{
+			result = ISC_R_RANGE;
+			break;
+		}
+
+		/*
+		 * Expired since the dump.
+		 */
+		if (rdatalist.ttl <= elapsed)
+			continue;
+		rdatalist.ttl -= elapsed;
+
+		isc_buffer_remainingregion(&record, &r);
+		r.length = namelen;
+		dns_name_init(&owner, NULL);
+		dns_name_fromregion(&owner, &r);
+		if (owner.length != namelen ||
+		    !dns_name_isabsolute(&owner))
+		{
+			result = ISC_R_RANGE;
+			break;
+		}
+		isc_buffer_forward(&record, namelen);
+
+		if (count > nrdatas) {
+			if (rdatas != NULL)
+				isc_mem_put(mctx, rdatas,
+					    nrdatas * sizeof(*rdatas));
+			rdatas = isc_mem_get(mctx, count * sizeof(*rdatas));
+			if (rdatas == NULL) {
+				nrdatas = 0;
+				result = ISC_R_NOMEMORY;
+				break;
+			}
+			nrdatas = count;
+		}
+		for (i = 0; i < count; i++) {
+			if (isc_buffer_remaininglength(&record) < 2)
+				break;
+			isc_buffer_remainingregion(&record, &r);
+			r.length = isc_buffer_getuint16(&record);
+			r.base += 2;
+			if (r.length > isc_buffer_remaininglength(&record))
+				break;
+			isc_buffer_forward(&record, r.length);
+			dns_rdata_init(&rdatas[i]);
+			dns_rdata_fromregion(&rdatas[i], rdclass,
+					     rdatalist.type, &r);
+			ISC_LIST_APPEND(rdatalist.rdata, &rdatas[i], link);
+		}
+		if (i != count || isc_buffer_remaininglength(&record) != 0) {
+			result = ISC_R_RANGE;
+			break;
+		}
+
+		/*
+		 * Records are written node by node, so most of them are
+		 * at the same node as the one before.
+		 */
+		if (node == NULL || !dns_name_equal(&owner, name)) {
+			if (node != NULL)
+				dns_db_detachnode(db, &node);
+			dns_name_copy(&owner, name, NULL);
+			result = dns_db_findnode(db, name, ISC_TRUE, &node);
+			if (result != ISC_R_SUCCESS)
+				break;
+		}
+
+		dns_rdataset_init(&rdataset);
+		RUNTIME_CHECK(dns_rdatalist_tordataset(&rdatalist, &rdataset)
+			      == ISC_R_SUCCESS);
+		rdataset.trust = trust;
+		if ((attributes & SNAPSHOT_ATTR_NEGATIVE) != 0)
+			rdataset.attributes |= DNS_RDATASETATTR_NEGATIVE;
+		if ((attributes & SNAPSHOT_ATTR_NXDOMAIN) != 0)
+			rdataset.attributes |= DNS_RDATASETATTR_NXDOMAIN;
+		if ((attributes & SNAPSHOT_ATTR_OPTOUT) != 0)
+			rdataset.attributes |= DNS_RDATASETATTR_OPTOUT;
+		if ((attributes & SNAPSHOT_ATTR_PREFETCH) != 0)
+			rdataset.attributes |= DNS_RDATASETATTR_PREFETCH;
+		result = dns_db_addrdataset(db, node, NULL, now, &rdataset,
+					    0, NULL);
+		dns_rdataset_disassociate(&rdataset);
+		if (result == DNS_R_UNCHANGED)
+			result = ISC_R_SUCCESS;
+		if (result != ISC_R_SUCCESS)
+			break;
+		(*countp)++;
+	}
+
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+	if (rdatas != NULL)
+		isc_mem_put(mctx, rdatas, nrdatas * sizeof(*rdatas));
+	return (result);
+}
+
 isc_result_t
 dns_cache_load(dns_cache_t *cache) {
+	char version[32];
+	FILE *f = NULL;
+	off_t size = 0;
+	void *base;
+	unsigned int count = 0;
+	isc_stdtime_t now;
 	isc_result_t result;
 
 	REQUIRE(VALID_CACHE(cache));
 
-	if (cache->filename == NULL)
-		return (ISC_R_SUCCESS);
+	LOCK(&cache->filelock);
+	if (cache->filename == NULL) {
+		result = ISC_R_SUCCESS;
+		goto unlock;
+	}
+
+	result = isc_stdio_open(cache->filename, "rb", &f);
+	if (result == ISC_R_FILENOTFOUND) {
+		/*
+		 * Nothing was saved yet.
+		 */
+		result = ISC_R_SUCCESS;
+		goto unlock;
+	}
+	if (result != ISC_R_SUCCESS)
+		goto unlock;
+
+	/*
+	 * Anything but a snapshot is loaded as a master file.
+	 */
+	memset(version, 0, sizeof(version));
+	result = isc_file_getsizefd(fileno(f), &size);
+	if (result == ISC_R_SUCCESS && size >= SNAPSHOT_HEADERLEN)
+		result = isc_stdio_read(version, 1, sizeof(version), f, NULL);
+	if (result != ISC_R_SUCCESS ||
+	    size < SNAPSHOT_HEADERLEN ||
+	    memcmp(version, SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION)) != 0)
+	{
+		(void)isc_stdio_close(f);
+		result = dns_db_load(cache->db, cache->filename);
+		goto unlock;
+	}
+
+	base = isc_file_mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE,
+			     fileno(f), 0);
+	if (base == NULL || base == MAP_FAILED) {
+		(void)isc_stdio_close(f);
+		result = ISC_R_FAILURE;
+		goto unlock;
+	}
+
+	isc_stdtime_get(&now);
+	result = snapshot_import(cache->db, cache->mctx, base, (size_t)size,
+				 now, &count);
+	isc_file_munmap(base, (size_t)size);
+	(void)isc_stdio_close(f);
+
+	isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
+		      DNS_LOGMODULE_CACHE,
+		      result == ISC_R_SUCCESS ? ISC_LOG_INFO : ISC_LOG_ERROR,
+		      "cache '%s': loaded %u rdatasets from snapshot '%s': %s",
+		      cache->name, count, cache->filename,
+		      isc_result_totext(result));
+
+ unlock:
+	UNLOCK(&cache->filelock);
+
+	return (result);
+}
+
+/*
+ * Save the contents of 'db', the database of 'cache', to the cache's
+ * file, if it has one.
+ */
+static isc_result_t
+cache_dump(dns_cache_t *cache, dns_db_t *db) {
+	char *tempname = NULL;
+	size_t tempnamelen;
+	FILE *f = NULL;
+	unsigned int count = 0;
+	isc_stdtime_t now;
+	isc_result_t result, tresult;
 
 	LOCK(&cache->filelock);
-	result = dns_db_load(cache->db, cache->filename);
+	if (cache->filename == NULL) {
+		result = ISC_R_SUCCESS;
+		goto unlock;
+	}
+
+	/*
+	 * Write to a temporary file, and only replace the snapshot
+	 * once it is complete.
+	 */
+	tempnamelen = strlen(cache->filename) + 20;
+	tempname = isc_mem_allocate(cache->mctx, tempnamelen);
+	if (tempname == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto unlock;
+	}
+	result = isc_file_mktemplate(cache->filename, tempname, tempnamelen);
+	if (result == ISC_R_SUCCESS)
+		result = isc_file_bopenunique(tempname, &f);
+	if (result != ISC_R_SUCCESS)
+		goto unlock;
+
+	isc_stdtime_get(&now);
+	result = snapshot_write(db, f, now, &count);
+
+	tresult = isc_stdio_close(f);
+	if (result == ISC_R_SUCCESS)
+		result = tresult;
+	if (result == ISC_R_SUCCESS)
+		result = isc_file_rename(tempname, cache->filename);
+	else
+		(void)isc_file_remove(tempname);
+
+	isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
+		      DNS_LOGMODULE_CACHE,
+		      result == ISC_R_SUCCESS ? ISC_LOG_INFO : ISC_LOG_ERROR,
+		      "cache '%s': saved %u rdatasets to snapshot '%s': %s",
+		      cache->name, count, cache->filename,
+		      isc_result_totext(result));
+
+ unlock:
 	UNLOCK(&cache->filelock);
+	if (tempname != NULL)
+		isc_mem_free(cache->mctx, tempname);
 
 	return (result);
 }
 
 isc_result_t
 dns_cache_dump(dns_cache_t *cache) {
+	dns_db_t *db = NULL;
 	isc_result_t result;
 
 	REQUIRE(VALID_CACHE(cache));
 
-	if (cache->filename == NULL)
-		return (ISC_R_SUCCESS);
+	/*
+	 * The database may be replaced by dns_cache_flush() meanwhile.
+	 */
+	dns_cache_attachdb(cache, &db);
+	result = cache_dump(cache, db);
+	dns_db_detach(&db);
 
-	LOCK(&cache->filelock);
-	result = dns_master_dump(cache->mctx, cache->db, NULL,
-				 &dns_master_style_cache, cache->filename);
-	UNLOCK(&cache->filelock);
 	return (result);
-
 }
 
 void
@@ -619,12 +1248,30 @@ cache_cleaner_init(dns_cache_t *cache, isc_taskmgr_t *taskmgr,
 	cleaner->resched_event = NULL;
 	cleaner->overmem_event = NULL;
 	cleaner->cleaning_interval = 0; /* Initially turned off. */
+	cleaner->units = NULL;
+	cleaner->nunits = 0;
+	cleaner->tick_timer = NULL;
+	cleaner->passes = 1;
+	cleaner->exiting = ISC_FALSE;
 
 	result = dns_db_createiterator(cleaner->cache->db, ISC_FALSE,
 				       &cleaner->iterator);
 	if (result != ISC_R_SUCCESS)
 		goto cleanup;
 
+	/*
+	 * A cache DB which can clean its buckets separately is cleaned
+	 * by the cleaning units rather than by walking the whole DB.
+	 */
+	if (dns_db_bucketcount(cache->db) > 0) {
+		if (taskmgr == NULL || timermgr == NULL)
+			return (ISC_R_SUCCESS);
+		result = cleanunits_init(cache, taskmgr, timermgr, cleaner);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup;
+		return (ISC_R_SUCCESS);
+	}
+
 	if (taskmgr != NULL && timermgr != NULL) {
 		result = isc_task_create(taskmgr, 1, &cleaner->task);
 		if (result != ISC_R_SUCCESS) {
@@ -698,6 +1345,104 @@ cache_cleaner_init(dns_cache_t *cache, isc_taskmgr_t *taskmgr,
 	return (result);
 }
 
+/*
+ * Set up one cleaning unit per bucket of the cache DB, each with its
+ * own task, and the timer which starts them.
+ */
+static isc_result_t
+cleanunits_init(dns_cache_t *cache, isc_taskmgr_t *taskmgr,
+		isc_timermgr_t *timermgr, cache_cleaner_t *cleaner)
+{
+	isc_result_t result;
+	isc_interval_t interval;
+	cache_cleanunit_t *unit;
+	unsigned int n;
+
+	cleaner->nunits = dns_db_bucketcount(cache->db);
+	cleaner->units = isc_mem_get(cache->mctx, cleaner->nunits *
+				     sizeof(cache_cleanunit_t));
+	if (cleaner->units == NULL) {
+		cleaner->nunits = 0;
+		return (ISC_R_NOMEMORY);
+	}
+
+	for (n = 0; n < cleaner->nunits; n++) {
+		unit = &cleaner->units[n];
+		unit->cache = cache;
+		unit->index = n;
+		unit->task = NULL;
+		unit->event = NULL;
+		unit->passes = 0;
+	}
+
+	for (n = 0; n < cleaner->nunits; n++) {
+		unit = &cleaner->units[n];
+		unit->event = isc_event_allocate(cache->mctx, unit,
+						 DNS_EVENT_CACHEUNITCLEAN,
+						 cleanunit_action, unit,
+						 sizeof(isc_event_t));
+		if (unit->event == NULL) {
+			result = ISC_R_NOMEMORY;
+			goto cleanup;
+		}
+		result = isc_task_create(taskmgr, 1, &unit->task);
+		if (result != ISC_R_SUCCESS) {
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "isc_task_create() failed: %s",
+					 dns_result_totext(result));
+			result = ISC_R_UNEXPECTED;
+			goto cleanup;
+		}
+		isc_task_setname(unit->task, "cachecleaner", unit);
+	}
+
+	isc_interval_set(&interval, DNS_CACHE_CLEANERTICK, 0);
+	result = isc_timer_create(timermgr, isc_timertype_ticker,
+				  NULL, &interval, cleaner->units[0].task,
+				  cleaner_tick_action, cleaner,
+				  &cleaner->tick_timer);
+	if (result != ISC_R_SUCCESS) {
+		UNEXPECTED_ERROR(__FILE__, __LINE__,
+				 "isc_timer_create() failed: %s",
+				 dns_result_totext(result));
+		result = ISC_R_UNEXPECTED;
+		goto cleanup;
+	}
+
+	for (n = 0; n < cleaner->nunits; n++) {
+		unit = &cleaner->units[n];
+		result = isc_task_onshutdown(unit->task,
+					     cleanunit_shutdown_action, unit);
+		if (result != ISC_R_SUCCESS) {
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "cache cleaner: "
+					 "isc_task_onshutdown() failed: %s",
+					 dns_result_totext(result));
+			goto cleanup;
+		}
+		cache->live_tasks++;
+	}
+
+	return (ISC_R_SUCCESS);
+
+ cleanup:
+	if (cleaner->tick_timer != NULL)
+		isc_timer_detach(&cleaner->tick_timer);
+	for (n = 0; n < cleaner->nunits; n++) {
+		unit = &cleaner->units[n];
+		if (unit->event != NULL)
+			isc_event_free(&unit->event);
+		if (unit->task != NULL)
+			isc_task_detach(&unit->task);
+	}
+	isc_mem_put(cache->mctx, cleaner->units,
+		    cleaner->nunits * sizeof(cache_cleanunit_t));
+	cleaner->units = NULL;
+	cleaner->nunits = 0;
+	cache->live_tasks = 0;
+	return (result);
+}
+
 static void
 begin_cleaning(cache_cleaner_t *cleaner) {
 	isc_result_t result = ISC_R_SUCCESS;
@@ -959,6 +1704,174 @@ incremental_cleaning_action(isc_task_t *task, isc_event_t *event) {
 	return;
 }
 
+/*
+ * How many passes a cleaning unit may make per tick: one while the cache
+ * is at most half full, rising to DNS_CACHE_CLEANERMAXPASSES as it fills
+ * up.
+ */
+static unsigned int
+cleaner_passes(dns_cache_t *cache) {
+	size_t size, inuse;
+
+	LOCK(&cache->lock);
+	size = cache->size;
+	UNLOCK(&cache->lock);
+
+	if (size == 0U)
+		return (1);
+
+	inuse = isc_mem_inuse(cache->mctx);
+	if (inuse <= size / 2)
+		return (1);
+	if (inuse >= size)
+		return (DNS_CACHE_CLEANERMAXPASSES);
+	return (1 + (unsigned int)
+		((isc_uint64_t)(DNS_CACHE_CLEANERMAXPASSES - 1) *
+		 (inuse - size / 2) / (size - size / 2)));
+}
+
+/*
+ * Start every cleaning unit which is not busy.
+ *
+ * Requires cleaner->lock to be held.
+ */
+static void
+cleaner_kick(cache_cleaner_t *cleaner) {
+	unsigned int n;
+
+	if (cleaner->exiting)
+		return;
+
+	for (n = 0; n < cleaner->nunits; n++) {
+		cache_cleanunit_t *unit = &cleaner->units[n];
+
+		unit->passes = cleaner->passes;
+		if (unit->event != NULL)
+			isc_task_send(unit->task, &unit->event);
+	}
+}
+
+/*
+ * This is run every DNS_CACHE_CLEANERTICK seconds, in the first cleaning
+ * unit's task.
+ */
+static void
+cleaner_tick_action(isc_task_t *task, isc_event_t *event) {
+	cache_cleaner_t *cleaner = event->ev_arg;
+	unsigned int passes;
+
+	UNUSED(task);
+
+	INSIST(event->ev_type == ISC_TIMEREVENT_TICK);
+
+	isc_event_free(&event);
+
+	passes = cleaner_passes(cleaner->cache);
+
+	LOCK(&cleaner->lock);
+	cleaner->passes = passes;
+	cleaner_kick(cleaner);
+	UNLOCK(&cleaner->lock);
+}
+
+/*
+ * Make one pass over the buckets of a cleaning unit, then either go
+ * again or wait for the next tick.  While the cache is overmem passes
+ * continue for as long as there is anything left to remove.
+ */
+static void
+cleanunit_action(isc_task_t *task, isc_event_t *event) {
+	cache_cleanunit_t *unit = event->ev_arg;
+	dns_cache_t *cache = unit->cache;
+	cache_cleaner_t *cleaner = &cache->cleaner;
+	dns_db_t *db = NULL;
+	isc_result_t result;
+	isc_stdtime_t now;
+	isc_boolean_t more = ISC_FALSE;
+	unsigned int bucket, nbuckets, count, cleaned = 0;
+
+	INSIST(task == unit->task);
+	INSIST(event->ev_type == DNS_EVENT_CACHEUNITCLEAN);
+
+	/*
+	 * The DB may be replaced by dns_cache_flush() at any time, possibly
+	 * with one with a different number of buckets.
+	 */
+	LOCK(&cache->lock);
+	dns_db_attach(cache->db, &db);
+	UNLOCK(&cache->lock);
+
+	isc_stdtime_get(&now);
+	nbuckets = dns_db_bucketcount(db);
+	for (bucket = unit->index; bucket < nbuckets;
+	     bucket += cleaner->nunits)
+	{
+		count = cleaner->increment;
+		result = dns_db_cleanbucket(db, bucket, now, &count);
+		if (result == DNS_R_CONTINUE)
+			more = ISC_TRUE;
+		cleaned += count;
+	}
+	dns_db_detach(&db);
+
+	isc_stats_increment(cache->stats, dns_cachestatscounter_cleanerpasses);
+	if (cleaned != 0)
+		isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
+			      DNS_LOGMODULE_CACHE, ISC_LOG_DEBUG(2),
+			      "cache cleaner %u: removed %u rdatasets%s",
+			      unit->index, cleaned, more ? ", more left" : "");
+
+	LOCK(&cleaner->lock);
+	if (more && !cleaner->exiting &&
+	    (cleaner->overmem || unit->passes > 1))
+	{
+		if (unit->passes > 0)
+			unit->passes--;
+		isc_task_send(task, &event);
+	} else {
+		unit->passes = 0;
+		unit->event = event;
+	}
+	UNLOCK(&cleaner->lock);
+}
+
+/*
+ * A cleaning unit's task is shutting down.  The last one to do so frees
+ * the cache.
+ */
+static void
+cleanunit_shutdown_action(isc_task_t *task, isc_event_t *event) {
+	cache_cleanunit_t *unit = event->ev_arg;
+	dns_cache_t *cache = unit->cache;
+	isc_boolean_t should_free = ISC_FALSE;
+
+	INSIST(task == unit->task);
+	INSIST(event->ev_type == ISC_TASKEVENT_SHUTDOWN);
+
+	isc_event_free(&event);
+
+	/*
+	 * By detaching the timer in the context of its task,
+	 * we are guaranteed that there will be no further timer
+	 * events.
+	 */
+	if (unit->index == 0 && cache->cleaner.tick_timer != NULL)
+		isc_timer_detach(&cache->cleaner.tick_timer);
+
+	/* Make sure we don't reschedule anymore. */
+	(void)isc_task_purge(task, NULL, DNS_EVENT_CACHEUNITCLEAN, NULL);
+
+	LOCK(&cache->lock);
+	INSIST(cache->live_tasks > 0);
+	cache->live_tasks--;
+	if (cache->live_tasks == 0 && cache->references == 0)
+		should_free = ISC_TRUE;
+	UNLOCK(&cache->lock);
+
+	if (should_free)
+		cache_free(cache);
+}
+
 /*
  * Do immediate cleaning.
  */
@@ -1025,6 +1938,8 @@ water(void *arg, int mark) {
 		dns_db_overmem(cache->db, overmem);
 		cache->cleaner.overmem = overmem;
 		isc_mem_waterack(cache->mctx, mark);
+		if (overmem)
+			cleaner_kick(&cache->cleaner);
 	}
 
 	if (cache->cleaner.overmem_event != NULL)
@@ -1087,6 +2002,29 @@ dns_cache_getcachesize(dns_cache_t *cache) {
 	return (size);
 }
 
+void
+dns_cache_setservestalettl(dns_cache_t *cache, dns_ttl_t ttl) {
+	REQUIRE(VALID_CACHE(cache));
+
+	LOCK(&cache->lock);
+	cache->serve_stale_ttl = ttl;
+	(void)dns_db_setservestalettl(cache->db, ttl);
+	UNLOCK(&cache->lock);
+}
+
+dns_ttl_t
+dns_cache_getservestalettl(dns_cache_t *cache) {
+	dns_ttl_t ttl;
+
+	REQUIRE(VALID_CACHE(cache));
+
+	LOCK(&cache->lock);
+	ttl = cache->serve_stale_ttl;
+	UNLOCK(&cache->lock);
+
+	return (ttl);
+}
+
 /*
  * The cleaner task is shutting down; do the necessary cleanup.
  */
@@ -1160,6 +2098,7 @@ dns_cache_flush(dns_cache_t *cache) {
 	olddb = cache->db;
 	cache->db = db;
 	dns_db_setcachestats(cache->db, cache->stats);
+	(void)dns_db_setservestalettl(cache->db, cache->serve_stale_ttl);
 	UNLOCK(&cache->cleaner.lock);
 	UNLOCK(&cache->lock);
 
@@ -1237,10 +2176,17 @@ cleartree(dns_db_t *db, dns_name_t *name) {
 		if (result != ISC_R_SUCCESS)
 			goto cleanup;
 		/*
-		 * Are we done?
+		 * Are we done?  A sharded "rbt" cache database keeps names
+		 * of three or more labels in several trees, so the names
+		 * below one with fewer labels are not all in one run.
 		 */
-		if (! dns_name_issubdomain(nodename, name))
-			goto cleanup;
+		if (! dns_name_issubdomain(nodename, name)) {
+			if (dns_name_countlabels(name) >= 3)
+				goto cleanup;
+			dns_db_detachnode(db, &node);
+			result = dns_dbiterator_next(iter);
+			continue;
+		}
 
 		/*
 		 * If clearnode fails record and move onto the next node.
@@ -1377,6 +2323,24 @@ getcounters(isc_stats_t *stats, isc_statsformat_t type, int ncounters,
 	isc_stats_dump(stats, getcounter, &dumparg, ISC_STATSDUMP_VERBOSE);
 }
 
+/*
+ * The most rdatasets per second a cleaning unit currently removes from
+ * each of its buckets; 0 if there is no limit because the cache is
+ * overmem, or if there are no cleaning units.
+ */
+static isc_uint64_t
+cleaner_rate(cache_cleaner_t *cleaner) {
+	isc_uint64_t rate = 0;
+
+	LOCK(&cleaner->lock);
+	if (cleaner->nunits > 0 && !cleaner->overmem)
+		rate = (isc_uint64_t)cleaner->increment * cleaner->passes /
+			DNS_CACHE_CLEANERTICK;
+	UNLOCK(&cleaner->lock);
+
+	return (rate);
+}
+
 void
 dns_cache_dumpstats(dns_cache_t *cache, FILE *fp) {
 	int indices[dns_cachestatscounter_max];
@@ -1405,6 +2369,27 @@ dns_cache_dumpstats(dns_cache_t *cache, FILE *fp) {
 	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
 		values[dns_cachestatscounter_deletettl],
 		"cache records deleted due to TTL expiration");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		values[dns_cachestatscounter_hothits],
+		"cache hits on frequently used records");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		values[dns_cachestatscounter_promotelru],
+		"cache records marked as frequently used");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		values[dns_cachestatscounter_demotelru],
+		"cache records no longer marked as frequently used");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		values[dns_cachestatscounter_deletelruhot],
+		"frequently used cache records deleted due to memory "
+		"exhaustion");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		values[dns_cachestatscounter_cleanerpasses],
+		"cache cleaner passes");
+	fprintf(fp, "%20u %s\n", cache->cleaner.nunits,
+		"cache cleaner units");
+	fprintf(fp, "%20" ISC_PRINT_QUADFORMAT "u %s\n",
+		cleaner_rate(&cache->cleaner),
+		"cache cleaner rate limit per bucket (records/second)");
 	fprintf(fp, "%20u %s\n", dns_db_nodecount(cache->db),
 		"cache database nodes");
 	fprintf(fp, "%20" ISC_PLATFORM_QUADFORMAT "u %s\n",
@@ -1472,6 +2457,19 @@ dns_cache_renderxml(dns_cache_t *cache, xmlTextWriterPtr writer) {
 		   values[dns_cachestatscounter_deletelru], writer));
 	TRY0(renderstat("DeleteTTL",
 		   values[dns_cachestatscounter_deletettl], writer));
+	TRY0(renderstat("HotHits",
+		   values[dns_cachestatscounter_hothits], writer));
+	TRY0(renderstat("PromoteLRU",
+		   values[dns_cachestatscounter_promotelru], writer));
+	TRY0(renderstat("DemoteLRU",
+		   values[dns_cachestatscounter_demotelru], writer));
+	TRY0(renderstat("DeleteLRUHot",
+		   values[dns_cachestatscounter_deletelruhot], writer));
+	TRY0(renderstat("CleanerPasses",
+		   values[dns_cachestatscounter_cleanerpasses], writer));
+	TRY0(renderstat("CleanerUnits", cache->cleaner.nunits, writer));
+	TRY0(renderstat("CleanerRate", cleaner_rate(&cache->cleaner),
+			writer));
 
 	TRY0(renderstat("CacheNodes", dns_db_nodecount(cache->db), writer));
 	TRY0(renderstat("CacheBuckets", dns_db_hashsize(cache->db), writer));
@@ -1532,6 +2530,36 @@ dns_cache_renderjson(dns_cache_t *cache, json_object *cstats) {
 	CHECKMEM(obj);
 	json_object_object_add(cstats, "DeleteTTL", obj);
 
+	obj = json_object_new_int64(values[dns_cachestatscounter_hothits]);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "HotHits", obj);
+
+	obj = json_object_new_int64(values[dns_cachestatscounter_promotelru]);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "PromoteLRU", obj);
+
+	obj = json_object_new_int64(values[dns_cachestatscounter_demotelru]);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "DemoteLRU", obj);
+
+	obj = json_object_new_int64(
+			values[dns_cachestatscounter_deletelruhot]);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "DeleteLRUHot", obj);
+
+	obj = json_object_new_int64(
+			values[dns_cachestatscounter_cleanerpasses]);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "CleanerPasses", obj);
+
+	obj = json_object_new_int64(cache->cleaner.nunits);
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "CleanerUnits", obj);
+
+	obj = json_object_new_int64(cleaner_rate(&cache->cleaner));
+	CHECKMEM(obj);
+	json_object_object_add(cstats, "CleanerRate", obj);
+
 	obj = json_object_new_int64(dns_db_nodecount(cache->db));
 	CHECKMEM(obj);
 	json_object_object_add(cstats, "CacheNodes", obj);
@@ -12,13 +12,14 @@
 
 #include <config.h>
 
+#include <isc/buffer.h>
+#include <isc/hash.h>
 #include <isc/mem.h>
 #include <isc/string.h>
 #include <isc/util.h>
 
 #include <dns/compress.h>
-#include <dns/fixedname.h>
-#include <dns/rbt.h>
+#include <dns/name.h>
 #include <dns/result.h>
 
 #define CCTX_MAGIC	ISC_MAGIC('C', 'C', 'T', 'X')
@@ -29,15 +30,16 @@
 
 #define TABLE_READY							\
 	do {								\
-		unsigned int i;						\
-									\
 		if ((cctx->allowed & DNS_COMPRESS_READY) == 0) {	\
 			cctx->allowed |= DNS_COMPRESS_READY;		\
-			for (i = 0; i < DNS_COMPRESS_TABLESIZE; i++)	\
-				cctx->table[i] = NULL;			\
+			memset(cctx->table, 0xff, sizeof(cctx->table));	\
 		}							\
 	} while (0)
 
+#define TABLE_MASK	(DNS_COMPRESS_TABLESIZE - 1)
+#define SLOT_EMPTY		0xffff	/* coff of an unused slot */
+#define SUFFIX_ROOT		0x4000	/* soff of a label below the root */
+
 /***
  ***	Compression
  ***/
@@ -57,25 +59,8 @@ dns_compress_init(dns_compress_t *cctx, int edns, isc_mem_t *mctx) {
 
 void
 dns_compress_invalidate(dns_compress_t *cctx) {
-	dns_compressnode_t *node;
-	unsigned int i;
-
 	REQUIRE(VALID_CCTX(cctx));
 
-	if ((cctx->allowed & DNS_COMPRESS_READY) != 0) {
-		for (i = 0; i < DNS_COMPRESS_TABLESIZE; i++) {
-			while (cctx->table[i] != NULL) {
-				node = cctx->table[i];
-				cctx->table[i] = cctx->table[i]->next;
-				if ((node->offset & 0x8000) != 0)
-					isc_mem_put(cctx->mctx, node->r.base,
-						    node->r.length);
-				if (node->count < DNS_COMPRESS_INITIALNODES)
-					continue;
-				isc_mem_put(cctx->mctx, node, sizeof(*node));
-			}
-		}
-	}
 	cctx->magic = 0;
 	cctx->allowed = 0;
 	cctx->edns = -1;
@@ -124,178 +109,169 @@ dns_compress_getedns(dns_compress_t *cctx) {
 	return (cctx->edns);
 }
 
-#define NODENAME(node, name) \
-do { \
-	(name)->length = (node)->r.length; \
-	(name)->labels = (node)->labels; \
-	(name)->ndata = (node)->r.base; \
-	(name)->attributes = DNS_NAMEATTR_ABSOLUTE; \
-} while (0)
-
 /*
- * Find the longest match of name in the table.
- * If match is found return ISC_TRUE. prefix, suffix and offset are updated.
- * If no match is found return ISC_FALSE.
+ * An entry is keyed on one label and the offset of the suffix that
+ * follows it in the message (SUFFIX_ROOT for the root), so the key of
+ * a suffix is only known once the rest of the name has been found;
+ * names are therefore looked up from the top label down.
  */
-isc_boolean_t
-dns_compress_findglobal(dns_compress_t *cctx, const dns_name_t *name,
-			dns_name_t *prefix, isc_uint16_t *offset)
-{
-	dns_name_t tname, nname;
-	dns_compressnode_t *node = NULL;
-	unsigned int labels, hash, n;
-
-	REQUIRE(VALID_CCTX(cctx));
-	REQUIRE(dns_name_isabsolute(name) == ISC_TRUE);
-	REQUIRE(offset != NULL);
-
-	if ((cctx->allowed & DNS_COMPRESS_ENABLED) == 0)
-		return (ISC_FALSE);
-
-	TABLE_READY;
-
-	if (cctx->count == 0)
-		return (ISC_FALSE);
+static inline unsigned int
+hash_label(isc_uint32_t hval, const unsigned char *label, isc_uint16_t soff) {
+	unsigned int i;
+	unsigned char c;
 
-	labels = dns_name_countlabels(name);
-	INSIST(labels > 0);
-
-	dns_name_init(&tname, NULL);
-	dns_name_init(&nname, NULL);
-
-	for (n = 0; n < labels - 1; n++) {
-		dns_name_getlabelsequence(name, n, labels - n, &tname);
-		hash = dns_name_hash(&tname, ISC_FALSE) %
-		       DNS_COMPRESS_TABLESIZE;
-		for (node = cctx->table[hash]; node != NULL; node = node->next)
-		{
-			NODENAME(node, &nname);
-			if ((cctx->allowed & DNS_COMPRESS_CASESENSITIVE) != 0) {
-				if (dns_name_caseequal(&nname, &tname))
-					break;
-			} else {
-				if (dns_name_equal(&nname, &tname))
-					break;
-			}
-		}
-		if (node != NULL)
-			break;
+	/*
+	 * FNV-1a, as isc_hash_function() computes it but inline, from
+	 * the same random offset basis.
+	 */
+	hval ^= soff >> 8;
+	hval *= 16777619;
+	hval ^= soff & 0xff;
+	hval *= 16777619;
+	for (i = 0; i <= label[0]; i++) {
+		c = label[i];
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hval ^= c;
+		hval *= 16777619;
 	}
+	return ((hval ^ (hval >> 16)) & TABLE_MASK);
+}
+
+static inline isc_boolean_t
+match_label(const dns_compress_t *cctx, const isc_buffer_t *buffer,
+	    isc_uint16_t coff, const unsigned char *label)
+{
+	const unsigned char *p;
+	unsigned int i, length = label[0];
+	unsigned char c1, c2;
 
 	/*
-	 * If node == NULL, we found no match at all.
+	 * The table may have been filled while rendering into another
+	 * buffer; never look past what this one holds.
 	 */
-	if (node == NULL)
+	if (coff + length + 1 > buffer->used)
 		return (ISC_FALSE);
-
-	if (n == 0)
-		dns_name_reset(prefix);
-	else
-		dns_name_getlabelsequence(name, 0, n, prefix);
-
-	*offset = (node->offset & 0x7fff);
+	p = (unsigned char *)buffer->base + coff;
+	if (p[0] != length)
+		return (ISC_FALSE);
+	if ((cctx->allowed & DNS_COMPRESS_CASESENSITIVE) != 0)
+		return (ISC_TF(memcmp(p + 1, label + 1, length) == 0));
+	for (i = 1; i <= length; i++) {
+		c1 = p[i];
+		c2 = label[i];
+		if (c1 >= 'A' && c1 <= 'Z')
+			c1 += 'a' - 'A';
+		if (c2 >= 'A' && c2 <= 'Z')
+			c2 += 'a' - 'A';
+		if (c1 != c2)
+			return (ISC_FALSE);
+	}
 	return (ISC_TRUE);
 }
 
-static inline unsigned int
-name_length(const dns_name_t *name) {
-	isc_region_t r;
-	dns_name_toregion(name, &r);
-	return (r.length);
+static inline void
+add_label(dns_compress_t *cctx, unsigned int slot, isc_uint16_t coff,
+	  isc_uint16_t soff)
+{
+	while (cctx->table[slot].coff != SLOT_EMPTY)
+		slot = (slot + 1) & TABLE_MASK;
+	cctx->table[slot].coff = coff;
+	cctx->table[slot].soff = soff;
+	cctx->order[cctx->count++] = (isc_uint16_t)slot;
 }
 
 void
-dns_compress_add(dns_compress_t *cctx, const dns_name_t *name,
-		 const dns_name_t *prefix, isc_uint16_t offset)
+dns_compress_name(dns_compress_t *cctx, const isc_buffer_t *buffer,
+		  const dns_name_t *name, unsigned int *prefixp,
+		  isc_uint16_t *offsetp)
 {
-	dns_name_t tname, xname;
-	unsigned int start;
-	unsigned int n;
-	unsigned int count;
-	unsigned int hash;
-	dns_compressnode_t *node;
-	unsigned int length;
-	unsigned int tlength;
-	isc_uint16_t toffset;
-	unsigned char *tmp;
-	isc_region_t r;
+	unsigned char offsets[128];
+	const unsigned char *ndata, *label;
+	unsigned int n, i, slot = 0, offset;
+	isc_uint16_t coff, soff;
+	isc_uint32_t basis;
 
 	REQUIRE(VALID_CCTX(cctx));
+	REQUIRE(ISC_BUFFER_VALID(buffer));
 	REQUIRE(dns_name_isabsolute(name));
+	REQUIRE(prefixp != NULL && offsetp != NULL);
+
+	*prefixp = name->length;
+	*offsetp = 0;
 
 	if ((cctx->allowed & DNS_COMPRESS_ENABLED) == 0)
 		return;
 
 	TABLE_READY;
 
-	if (offset >= 0x4000)
-		return;
-	dns_name_init(&tname, NULL);
-	dns_name_init(&xname, NULL);
-
-	n = dns_name_countlabels(name);
-	count = dns_name_countlabels(prefix);
-	if (dns_name_isabsolute(prefix))
-		count--;
-	if (count == 0)
-		return;
-	start = 0;
-	dns_name_toregion(name, &r);
-	length = r.length;
-	tmp = isc_mem_get(cctx->mctx, length);
-	if (tmp == NULL)
+	/*
+	 * Find where each label starts; the root label is left out.
+	 */
+	ndata = name->ndata;
+	for (n = 0, i = 0; ndata[i] != 0; i += ndata[i] + 1)
+		offsets[n++] = i;
+	if (n == 0)
 		return;
+
+	basis = *(const isc_uint32_t *)isc_hash_get_initializer();
+
 	/*
-	 * Copy name data to 'tmp' and make 'r' use 'tmp'.
+	 * Look the name up one suffix at a time, starting from the
+	 * label below the root.
 	 */
-	memmove(tmp, r.base, r.length);
-	r.base = tmp;
-	dns_name_fromregion(&xname, &r);
-
-	while (count > 0) {
-		dns_name_getlabelsequence(&xname, start, n, &tname);
-		hash = dns_name_hash(&tname, ISC_FALSE) %
-		       DNS_COMPRESS_TABLESIZE;
-		tlength = name_length(&tname);
-		toffset = (isc_uint16_t)(offset + (length - tlength));
-		if (toffset >= 0x4000)
-			break;
-		/*
-		 * Create a new node and add it.
-		 */
-		if (cctx->count < DNS_COMPRESS_INITIALNODES)
-			node = &cctx->initialnodes[cctx->count];
-		else {
-			node = isc_mem_get(cctx->mctx,
-					   sizeof(dns_compressnode_t));
-			if (node == NULL)
+	soff = SUFFIX_ROOT;
+	i = n;
+	while (n > 0) {
+		label = ndata + offsets[n - 1];
+		slot = hash_label(basis, label, soff);
+		for (;;) {
+			coff = cctx->table[slot].coff;
+			if (coff == SLOT_EMPTY ||
+			    (cctx->table[slot].soff == soff &&
+			     match_label(cctx, buffer, coff, label)))
 				break;
+			slot = (slot + 1) & TABLE_MASK;
 		}
-		node->count = cctx->count++;
-		/*
-		 * 'node->r.base' becomes 'tmp' when start == 0.
-		 * Record this by setting 0x8000 so it can be freed later.
-		 */
-		if (start == 0)
-			toffset |= 0x8000;
-		node->offset = toffset;
-		dns_name_toregion(&tname, &node->r);
-		node->labels = (isc_uint8_t)dns_name_countlabels(&tname);
-		node->next = cctx->table[hash];
-		cctx->table[hash] = node;
-		start++;
+		if (coff == SLOT_EMPTY)
+			break;
+		soff = coff;
 		n--;
-		count--;
 	}
 
-	if (start == 0)
-		isc_mem_put(cctx->mctx, tmp, length);
+	if (n < i) {
+		*prefixp = (n == 0) ? 0 :
+			   offsets[n - 1] + ndata[offsets[n - 1]] + 1;
+		*offsetp = soff;
+	}
+
+	/*
+	 * Add the labels that were not found, at the offsets they are
+	 * about to be rendered at.  'slot' is where the search for the
+	 * last of them ended.  Only whole chains of labels below 0x4000
+	 * are any use, and the entries must stay in offset order for
+	 * dns_compress_rollback().
+	 */
+	offset = buffer->used;
+	if (n == 0 || offset + offsets[n - 1] >= 0x4000 ||
+	    cctx->count + n > DNS_COMPRESS_MAXENTRIES ||
+	    (cctx->count > 0 &&
+	     cctx->table[cctx->order[cctx->count - 1]].coff >= offset))
+		return;
+
+	for (i = 0; i < n - 1; i++) {
+		coff = (isc_uint16_t)(offset + offsets[i]);
+		add_label(cctx,
+			  hash_label(basis, ndata + offsets[i],
+				     (isc_uint16_t)(offset + offsets[i + 1])),
+			  coff, (isc_uint16_t)(offset + offsets[i + 1]));
+	}
+	add_label(cctx, slot, (isc_uint16_t)(offset + offsets[n - 1]), soff);
 }
 
 void
 dns_compress_rollback(dns_compress_t *cctx, isc_uint16_t offset) {
-	unsigned int i;
-	dns_compressnode_t *node;
+	dns_compressslot_t *slot;
 
 	REQUIRE(VALID_CCTX(cctx));
 
@@ -305,24 +281,18 @@ dns_compress_rollback(dns_compress_t *cctx, isc_uint16_t offset) {
 	if ((cctx->allowed & DNS_COMPRESS_READY) == 0)
 		return;
 
-	for (i = 0; i < DNS_COMPRESS_TABLESIZE; i++) {
-		node = cctx->table[i];
-		/*
-		 * This relies on nodes with greater offsets being
-		 * closer to the beginning of the list, and the
-		 * items with the greatest offsets being at the end
-		 * of the initialnodes[] array.
-		 */
-		while (node != NULL && (node->offset & 0x7fff) >= offset) {
-			cctx->table[i] = node->next;
-			if ((node->offset & 0x8000) != 0)
-				isc_mem_put(cctx->mctx, node->r.base,
-					    node->r.length);
-			if (node->count >= DNS_COMPRESS_INITIALNODES)
-				isc_mem_put(cctx->mctx, node, sizeof(*node));
-			cctx->count--;
-			node = cctx->table[i];
-		}
+	/*
+	 * Entries are added in offset order and removed in reverse, so
+	 * no entry added later can be in the probe sequence of one that
+	 * stays, and slots can simply be emptied.
+	 */
+	while (cctx->count > 0) {
+		slot = &cctx->table[cctx->order[cctx->count - 1]];
+		if (slot->coff < offset)
+			break;
+		slot->coff = SLOT_EMPTY;
+		slot->soff = SLOT_EMPTY;
+		cctx->count--;
 	}
 }
 
@@ -52,6 +52,7 @@ struct dns_dbimplementation {
  * Built in database implementations are registered here.
  */
 
+#include "qpdb.h"
 #include "rbtdb.h"
 #include "rbtdb64.h"
 
@@ -61,6 +62,7 @@ static isc_once_t once = ISC_ONCE_INIT;
 
 static dns_dbimplementation_t rbtimp;
 static dns_dbimplementation_t rbt64imp;
+static dns_dbimplementation_t qpimp;
 
 static void
 initialize(void) {
@@ -78,9 +80,16 @@ initialize(void) {
 	rbt64imp.driverarg = NULL;
 	ISC_LINK_INIT(&rbt64imp, link);
 
+	qpimp.name = "qp";
+	qpimp.create = dns_qpdb_create;
+	qpimp.mctx = NULL;
+	qpimp.driverarg = NULL;
+	ISC_LINK_INIT(&qpimp, link);
+
 	ISC_LIST_INIT(implementations);
 	ISC_LIST_APPEND(implementations, &rbtimp, link);
 	ISC_LIST_APPEND(implementations, &rbt64imp, link);
+	ISC_LIST_APPEND(implementations, &qpimp, link);
 }
 
 static inline dns_dbimplementation_t *
@@ -136,6 +145,14 @@ dns_db_create(isc_mem_t *mctx, const char *db_type, dns_name_t *origin,
 	return (ISC_R_NOTFOUND);
 }
 
+void
+dns_db_setnodelockcount(dns_dbtype_t type, unsigned int count) {
+	REQUIRE(count <= DNS_DB_NODELOCKCOUNT_MAX);
+
+	dns_rbtdb_setnodelockcount(type, count);
+	dns_rbtdb64_setnodelockcount(type, count);
+}
+
 void
 dns_db_attach(dns_db_t *source, dns_db_t **targetp) {
 
@@ -976,6 +993,64 @@ dns_db_getrrsetstats(dns_db_t *db) {
 	return (NULL);
 }
 
+isc_stats_t *
+dns_db_getlockstats(dns_db_t *db) {
+	REQUIRE(DNS_DB_VALID(db));
+
+	if (db->methods->getlockstats != NULL)
+		return ((db->methods->getlockstats)(db));
+
+	return (NULL);
+}
+
+isc_result_t
+dns_db_setservestalettl(dns_db_t *db, dns_ttl_t ttl) {
+	REQUIRE(DNS_DB_VALID(db));
+	REQUIRE((db->attributes & DNS_DBATTR_CACHE) != 0);
+
+	if (db->methods->setservestalettl != NULL)
+		return ((db->methods->setservestalettl)(db, ttl));
+
+	return (ISC_R_NOTIMPLEMENTED);
+}
+
+isc_result_t
+dns_db_getservestalettl(dns_db_t *db, dns_ttl_t *ttl) {
+	REQUIRE(DNS_DB_VALID(db));
+	REQUIRE((db->attributes & DNS_DBATTR_CACHE) != 0);
+	REQUIRE(ttl != NULL);
+
+	if (db->methods->getservestalettl != NULL)
+		return ((db->methods->getservestalettl)(db, ttl));
+
+	return (ISC_R_NOTIMPLEMENTED);
+}
+
+unsigned int
+dns_db_bucketcount(dns_db_t *db) {
+	REQUIRE(DNS_DB_VALID(db));
+	REQUIRE((db->attributes & DNS_DBATTR_CACHE) != 0);
+
+	if (db->methods->bucketcount != NULL)
+		return ((db->methods->bucketcount)(db));
+
+	return (0);
+}
+
+isc_result_t
+dns_db_cleanbucket(dns_db_t *db, unsigned int bucket, isc_stdtime_t now,
+		   unsigned int *countp)
+{
+	REQUIRE(DNS_DB_VALID(db));
+	REQUIRE((db->attributes & DNS_DBATTR_CACHE) != 0);
+	REQUIRE(countp != NULL);
+
+	if (db->methods->cleanbucket != NULL)
+		return ((db->methods->cleanbucket)(db, bucket, now, countp));
+
+	return (ISC_R_NOTIMPLEMENTED);
+}
+
 isc_result_t
 dns_db_setcachestats(dns_db_t *db, isc_stats_t *stats) {
 	REQUIRE(DNS_DB_VALID(db));
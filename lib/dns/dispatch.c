@@ -301,6 +301,7 @@ static isc_result_t get_udpsocket(dns_dispatchmgr_t *mgr,
 				  dns_dispatch_t *disp,
 				  isc_socketmgr_t *sockmgr,
 				  isc_sockaddr_t *localaddr,
+				  unsigned int attributes,
 				  isc_socket_t **sockp,
 				  isc_socket_t *dup_socket);
 static isc_result_t dispatch_createudp(dns_dispatchmgr_t *mgr,
@@ -2777,6 +2778,12 @@ dns_dispatch_getudp_dup(dns_dispatchmgr_t *mgr, isc_socketmgr_t *sockmgr,
 		goto createudp;
 	}
 
+	if ((attributes & DNS_DISPATCHATTR_REUSEPORT) != 0) {
+		REQUIRE(isc_sockaddr_getport(localaddr) != 0);
+		REQUIRE(dup_dispatch == NULL);
+		goto createudp;
+	}
+
 	/*
 	 * See if we have a dispatcher that matches.
 	 */
@@ -2854,7 +2861,8 @@ dns_dispatch_getudp(dns_dispatchmgr_t *mgr, isc_socketmgr_t *sockmgr,
 static isc_result_t
 get_udpsocket(dns_dispatchmgr_t *mgr, dns_dispatch_t *disp,
 	      isc_socketmgr_t *sockmgr, isc_sockaddr_t *localaddr,
-	      isc_socket_t **sockp, isc_socket_t *dup_socket)
+	      unsigned int attributes, isc_socket_t **sockp,
+	      isc_socket_t *dup_socket)
 {
 	unsigned int i, j;
 	isc_socket_t *held[DNS_DISPATCH_HELD];
@@ -2911,9 +2919,12 @@ get_udpsocket(dns_dispatchmgr_t *mgr, dns_dispatch_t *disp,
 		 * choosing one.
 		 */
 	} else {
+		unsigned int options = ISC_SOCKET_REUSEADDRESS;
+
 		/* Allow to reuse address for non-random ports. */
-		result = open_socket(sockmgr, localaddr,
-				     ISC_SOCKET_REUSEADDRESS, &sock,
+		if ((attributes & DNS_DISPATCHATTR_REUSEPORT) != 0)
+			options |= ISC_SOCKET_REUSEPORT;
+		result = open_socket(sockmgr, localaddr, options, &sock,
 				     dup_socket);
 
 		if (result == ISC_R_SUCCESS)
@@ -2982,8 +2993,8 @@ dispatch_createudp(dns_dispatchmgr_t *mgr, isc_socketmgr_t *sockmgr,
 	disp->socktype = isc_sockettype_udp;
 
 	if ((attributes & DNS_DISPATCHATTR_EXCLUSIVE) == 0) {
-		result = get_udpsocket(mgr, disp, sockmgr, localaddr, &sock,
-				       dup_socket);
+		result = get_udpsocket(mgr, disp, sockmgr, localaddr,
+				       attributes, &sock, dup_socket);
 		if (result != ISC_R_SUCCESS)
 			goto deallocate_dispatch;
 
@@ -182,7 +182,13 @@ dns_cache_load(dns_cache_t *cache);
 /*%<
  * If the cache has a file name, load the cache contents from the file.
  * Previous cache contents are not discarded.
- * If no file name has been set, do nothing and return success.
+ * If no file name has been set, or the file does not exist, do nothing
+ * and return success.
+ *
+ * A snapshot written by dns_cache_dump() is mapped into memory and its
+ * rdatasets are added with their trust levels and what is left of their
+ * TTLs; those that have expired since are skipped.  Any other file is
+ * loaded as a master file.
  *
  * MT:
  *\li	Multiple simultaneous attempts to load or dump the cache
@@ -195,15 +201,22 @@ dns_cache_load(dns_cache_t *cache);
  * Returns:
  *
  *\li	#ISC_R_SUCCESS
+ *\li	#ISC_R_INVALIDFILE	the snapshot is incomplete or damaged
  *  \li    Various failures depending on the database implementation type
  */
 
 isc_result_t
 dns_cache_dump(dns_cache_t *cache);
 /*%<
- * If the cache has a file name, write the cache contents to disk,
- * overwriting any preexisting file.  If no file name has been set,
- * do nothing and return success.
+ * If the cache has a file name, write a snapshot of the cache contents
+ * to disk, overwriting any preexisting file.  If no file name has been
+ * set, do nothing and return success.
+ *
+ * The snapshot is a binary file holding the rdatasets that have not
+ * expired, with their TTLs relative to the time of the dump, trust
+ * levels and negative cache attributes.  Rdatasets carrying proofs of
+ * nonexistence for wildcard answers are left out.  The file is
+ * replaced only once the new snapshot is complete.
  *
  * MT:
  *\li	Multiple simultaneous attempts to load or dump the cache
@@ -256,6 +269,28 @@ dns_cache_getcachesize(dns_cache_t *cache);
  * Get the maximum cache size.
  */
 
+void
+dns_cache_setservestalettl(dns_cache_t *cache, dns_ttl_t ttl);
+/*%<
+ * Sets the maximum length of time that cached answers may be retained
+ * past their normal TTL, so that they can be served if the authoritative
+ * servers cannot be reached.  0 means expired data is not kept.  The
+ * setting survives dns_cache_flush().
+ *
+ * Requires:
+ *\li	'cache' to be valid.
+ */
+
+dns_ttl_t
+dns_cache_getservestalettl(dns_cache_t *cache);
+/*%<
+ * Gets the maximum length of time that cached answers may be kept
+ * past their normal TTL.
+ *
+ * Requires:
+ *\li	'cache' to be valid.
+ */
+
 isc_result_t
 dns_cache_flush(dns_cache_t *cache);
 /*%<
@@ -39,28 +39,33 @@ ISC_LANG_BEGINDECLS
 
 #define DNS_COMPRESS_READY		0x80000000
 
-#define DNS_COMPRESS_TABLESIZE 64
-#define DNS_COMPRESS_INITIALNODES 16
+/*%
+ * The compression table is an open addressing hash table kept inside
+ * dns_compress_t.  Each entry records where in the message one label
+ * of a name was rendered and where the rest of that name (its suffix)
+ * is, so the name itself is never copied.  There is room for up to
+ * DNS_COMPRESS_MAXENTRIES labels; names rendered after the table is
+ * full are still compressed against it, but are not added.
+ */
+#define DNS_COMPRESS_TABLESIZE 2048
+#define DNS_COMPRESS_MAXENTRIES 1536
 
-typedef struct dns_compressnode dns_compressnode_t;
+typedef struct dns_compressslot dns_compressslot_t;
 
-struct dns_compressnode {
-	isc_region_t		r;
-	isc_uint16_t		offset;
-	isc_uint16_t		count;
-	isc_uint8_t		labels;
-	dns_compressnode_t	*next;
+struct dns_compressslot {
+	isc_uint16_t		coff;		/*%< Offset of the label. */
+	isc_uint16_t		soff;		/*%< Offset of the suffix. */
 };
 
 struct dns_compress {
 	unsigned int		magic;		/*%< Magic number. */
 	unsigned int		allowed;	/*%< Allowed methods. */
 	int			edns;		/*%< Edns version or -1. */
+	isc_uint16_t		count;		/*%< Number of entries. */
 	/*% Global compression table. */
-	dns_compressnode_t	*table[DNS_COMPRESS_TABLESIZE];
-	/*% Preallocated nodes for the table. */
-	dns_compressnode_t	initialnodes[DNS_COMPRESS_INITIALNODES];
-	isc_uint16_t		count;		/*%< Number of nodes. */
+	dns_compressslot_t	table[DNS_COMPRESS_TABLESIZE];
+	/*% Table slots in the order they were filled. */
+	isc_uint16_t		order[DNS_COMPRESS_MAXENTRIES];
 	isc_mem_t		*mctx;		/*%< Memory context. */
 };
 
@@ -172,40 +177,34 @@ dns_compress_getedns(dns_compress_t *cctx);
  *\li		-1 .. 255
  */
 
-isc_boolean_t
-dns_compress_findglobal(dns_compress_t *cctx, const dns_name_t *name,
-			dns_name_t *prefix, isc_uint16_t *offset);
-/*%<
- *	Finds longest possible match of 'name' in the global compression table.
- *
- *	Requires:
- *\li		'cctx' to be initialized.
- *\li		'name' to be a absolute name.
- *\li		'prefix' to be initialized.
- *\li		'offset' to point to an isc_uint16_t.
- *
- *	Ensures:
- *\li		'prefix' and 'offset' are valid if ISC_TRUE is 	returned.
- *
- *	Returns:
- *\li		#ISC_TRUE / #ISC_FALSE
- */
-
 void
-dns_compress_add(dns_compress_t *cctx, const dns_name_t *name,
-		 const dns_name_t *prefix, isc_uint16_t offset);
+dns_compress_name(dns_compress_t *cctx, const isc_buffer_t *buffer,
+		  const dns_name_t *name, unsigned int *prefixp,
+		  isc_uint16_t *offsetp);
 /*%<
- *	Add compression pointers for 'name' to the compression table,
- *	not replacing existing pointers.
+ *	Find the longest suffix of 'name' that has already been rendered
+ *	into 'buffer', and add the labels in front of it to the global
+ *	compression table, assuming that 'name' is about to be rendered
+ *	at the current end of 'buffer'.
  *
- *	Requires:
- *\li		'cctx' initialized
+ *	'*prefixp' is set to the length of the labels that were not
+ *	found, and '*offsetp' to the offset of the suffix that was
+ *	found.  If no suffix was found, '*prefixp' is the length of
+ *	'name' and '*offsetp' is 0.  The caller may render the labels
+ *	that were not found followed by a compression pointer to
+ *	'*offsetp', or 'name' in full; the table is correct for
+ *	either.  If the name is not rendered after all, the caller must
+ *	call dns_compress_rollback() with the current end of 'buffer'.
  *
- *\li		'name' must be initialized and absolute, and must remain
- *		valid until the message compression is complete.
+ *	Each suffix of 'name' is hashed once, and no memory is
+ *	allocated.
  *
- *\li		'prefix' must be a prefix returned by
- *		dns_compress_findglobal(), or the same as 'name'.
+ *	Requires:
+ *\li		'cctx' to be initialized.
+ *\li		'buffer' to be the buffer the message is being rendered
+ *		into, starting at the message header.
+ *\li		'name' to be an absolute name.
+ *\li		'prefixp' and 'offsetp' to be non NULL.
  */
 
 void
@@ -213,6 +212,8 @@ dns_compress_rollback(dns_compress_t *cctx, isc_uint16_t offset);
 
 /*%<
  *	Remove any compression pointers from global table >= offset.
+ *	Entries are removed newest first, so this costs one step per
+ *	entry removed.
  *
  *	Requires:
  *\li		'cctx' is initialized.
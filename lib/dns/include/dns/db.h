@@ -191,6 +191,13 @@ typedef struct dns_dbmethods {
 					dns_name_t *name);
 	isc_result_t	(*getsize)(dns_db_t *db, dns_dbversion_t *version,
 				   isc_uint64_t *records, isc_uint64_t *bytes);
+	isc_stats_t	*(*getlockstats)(dns_db_t *db);
+	isc_result_t	(*setservestalettl)(dns_db_t *db, dns_ttl_t ttl);
+	isc_result_t	(*getservestalettl)(dns_db_t *db, dns_ttl_t *ttl);
+	unsigned int	(*bucketcount)(dns_db_t *db);
+	isc_result_t	(*cleanbucket)(dns_db_t *db, unsigned int bucket,
+				       isc_stdtime_t now,
+				       unsigned int *countp);
 } dns_dbmethods_t;
 
 typedef isc_result_t
@@ -249,6 +256,7 @@ struct dns_dbonupdatelistener {
 #define DNS_DBFIND_FORCENSEC3		0x0080
 #define DNS_DBFIND_ADDITIONALOK		0x0100
 #define DNS_DBFIND_NOZONECUT		0x0200
+#define DNS_DBFIND_STALEOK		0x0400
 /*@}*/
 
 /*@{*/
@@ -277,6 +285,11 @@ struct dns_dbonupdatelistener {
 #define DNS_DB_NONSEC3		0x4
 /*@}*/
 
+/*%
+ * The largest number of node locks dns_db_setnodelockcount() accepts.
+ */
+#define DNS_DB_NODELOCKCOUNT_MAX	1023
+
 /*****
  ***** Methods
  *****/
@@ -324,6 +337,27 @@ dns_db_create(isc_mem_t *mctx, const char *db_type, dns_name_t *origin,
  *	specified.
  */
 
+void
+dns_db_setnodelockcount(dns_dbtype_t type, unsigned int count);
+/*%<
+ * Set the number of buckets into which "rbt" and "rbt64" databases of
+ * type 'type' created from now on divide their nodes.  Each bucket has
+ * its own lock and its own TTL or re-signing heap, and in a cache its
+ * own LRU list; more buckets mean less contention between threads, at
+ * the cost of memory in every database.  Databases which already exist
+ * keep the number they were created with.
+ *
+ * 'type' dns_dbtype_cache sets the count for caches; any other type
+ * sets it for zone and stub databases.  A 'count' of zero restores the
+ * built-in default.  Prime counts spread nodes most evenly.
+ *
+ * Requires:
+ *
+ * \li	'count' <= #DNS_DB_NODELOCKCOUNT_MAX
+ *
+ * \li	'count' != 1 if 'type' is dns_dbtype_cache.
+ */
+
 void
 dns_db_attach(dns_db_t *source, dns_db_t **targetp);
 /*%<
@@ -816,6 +850,11 @@ dns_db_findext(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
  *	in the NSEC3 tree and not the main tree.  Without this option being
  *	set NSEC3 records will not be found.
  *
+ * \li	If the #DNS_DBFIND_STALEOK option is set, a cache database that
+ *	keeps expired data (see dns_db_setservestalettl()) may return it.
+ *	Such rdatasets have #DNS_RDATASETATTR_STALE set.  This only affects
+ *	answers returned from the cache.
+ *
  * \li	To respond to a query for SIG records, the caller should create a
  *	rdataset iterator and extract the signatures from each rdataset.
  *
@@ -1612,6 +1651,95 @@ dns_db_getrrsetstats(dns_db_t *db);
  *	dns_rdatasetstats_create(); otherwise NULL.
  */
 
+isc_stats_t *
+dns_db_getlockstats(dns_db_t *db);
+/*%<
+ * Get statistics counting, for each bucket of node locks (see
+ * dns_db_setnodelockcount()), how often a thread found the lock held
+ * by another and had to wait for it, when available.  Counter 'n'
+ * belongs to bucket 'n'.
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database (cache only).
+ *
+ * Returns:
+ * \li	when available, a pointer to a statistics object created by
+ *	isc_stats_create(); otherwise NULL.
+ */
+
+isc_result_t
+dns_db_setservestalettl(dns_db_t *db, dns_ttl_t ttl);
+/*%<
+ * Keep cached rdatasets for 'ttl' seconds after they expire, so that
+ * they can still be returned by a lookup with #DNS_DBFIND_STALEOK set.
+ * A 'ttl' of zero turns this off.
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database (cache only).
+ *
+ * Returns:
+ * \li	#ISC_R_SUCCESS
+ * \li	#ISC_R_NOTIMPLEMENTED - Not supported by this DB implementation.
+ */
+
+isc_result_t
+dns_db_getservestalettl(dns_db_t *db, dns_ttl_t *ttl);
+/*%<
+ * Get the time for which expired rdatasets are kept, as set by
+ * dns_db_setservestalettl().
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database (cache only).
+ * \li	'ttl' is not NULL.
+ *
+ * Returns:
+ * \li	#ISC_R_SUCCESS
+ * \li	#ISC_R_NOTIMPLEMENTED - Not supported by this DB implementation.
+ */
+
+unsigned int
+dns_db_bucketcount(dns_db_t *db);
+/*%<
+ * Get the number of buckets (see dns_db_setnodelockcount()) which
+ * dns_db_cleanbucket() can clean one at a time.
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database (cache only).
+ *
+ * Returns:
+ * \li	the number of buckets, or 0 if the DB implementation cannot
+ *	clean them separately.
+ */
+
+isc_result_t
+dns_db_cleanbucket(dns_db_t *db, unsigned int bucket, isc_stdtime_t now,
+		   unsigned int *countp);
+/*%<
+ * Remove up to '*countp' rdatasets from bucket 'bucket' of 'db': first
+ * those which have expired at time 'now' (including any serve-stale
+ * period), then, while the cache is over its memory limit, the least
+ * recently used ones.  On return '*countp' is the number removed.
+ *
+ * Buckets are independent of each other, so different buckets can be
+ * cleaned in parallel.
+ *
+ * Requires:
+ *
+ * \li	'db' is a valid database (cache only).
+ * \li	'countp' is not NULL.
+ *
+ * Returns:
+ * \li	#ISC_R_SUCCESS - nothing more to remove from the bucket for now.
+ * \li	#DNS_R_CONTINUE - '*countp' rdatasets were removed and there may
+ *	be more.
+ * \li	#ISC_R_RANGE - 'bucket' is not less than dns_db_bucketcount().
+ * \li	#ISC_R_NOTIMPLEMENTED - Not supported by this DB implementation.
+ */
+
 isc_result_t
 dns_db_setcachestats(dns_db_t *db, isc_stats_t *stats);
 /*%<
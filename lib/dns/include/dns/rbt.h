@@ -116,12 +116,14 @@ struct dns_rbtnode {
 
 	/* node needs to be cleaned from rpz */
 	unsigned int rpz : 1;
+
+	/* which tree of a database keeping several the node is in */
+	unsigned int shard : 8;         /*%< range is 0..255 */
 	unsigned int :0;                /* end of bitfields c/o tree lock */
 
 #ifdef DNS_RBT_USEHASH
 	unsigned int hashval;
 	dns_rbtnode_t *uppernode;
-	dns_rbtnode_t *hashnext;
 #endif
 	dns_rbtnode_t *parent;
 	dns_rbtnode_t *left;
@@ -685,7 +687,7 @@ dns_rbt_nodecount(dns_rbt_t *rbt);
 size_t
 dns_rbt_hashsize(dns_rbt_t *rbt);
 /*%<
- * Obtain the current number of buckets in the 'rbt' hash table.
+ * Obtain the current number of slots in the 'rbt' hash table.
  *
  * Requires:
  * \li  rbt is a valid rbt manager.
@@ -674,6 +674,20 @@ dns_rdatatype_atparent(dns_rdatatype_t type);
  *
  */
 
+isc_boolean_t
+dns_rdatatype_isverbatim(dns_rdataclass_t rdclass, dns_rdatatype_t type);
+/*%<
+ * Return true iff dns_rdata_towire() renders rdata of class 'rdclass'
+ * and type 'type' exactly as it is stored: the rdata contains no
+ * domain names that are compressed or that are added to the
+ * compression table.  Such rdata can be copied straight into a
+ * message being rendered.
+ *
+ * Requires:
+ * \li	'type' is a valid rdata type.
+ *
+ */
+
 unsigned int
 dns_rdatatype_attributes(dns_rdatatype_t rdtype);
 /*%<
@@ -706,6 +720,8 @@ dns_rdatatype_attributes(dns_rdatatype_t rdtype);
 #define DNS_RDATATYPEATTR_NOTQUESTION		0x00000100U
 /*% Is present at zone cuts in the parent, not the child */
 #define DNS_RDATATYPEATTR_ATPARENT		0x00000200U
+/*% Is rendered to wire format exactly as stored */
+#define DNS_RDATATYPEATTR_VERBATIM		0x00000400U
 
 dns_rdatatype_t
 dns_rdata_covers(dns_rdata_t *rdata);
@@ -49,12 +49,6 @@
 
 ISC_LANG_BEGINDECLS
 
-typedef enum {
-	dns_rdatasetadditional_fromauth,
-	dns_rdatasetadditional_fromcache,
-	dns_rdatasetadditional_fromglue
-} dns_rdatasetadditional_t;
-
 typedef struct dns_rdatasetmethods {
 	void			(*disassociate)(dns_rdataset_t *rdataset);
 	isc_result_t		(*first)(dns_rdataset_t *rdataset);
@@ -76,30 +70,6 @@ typedef struct dns_rdatasetmethods {
 					      dns_name_t *name,
 					      dns_rdataset_t *neg,
 					      dns_rdataset_t *negsig);
-	isc_result_t		(*getadditional)(dns_rdataset_t *rdataset,
-						 dns_rdatasetadditional_t type,
-						 dns_rdatatype_t qtype,
-						 dns_acache_t *acache,
-						 dns_zone_t **zonep,
-						 dns_db_t **dbp,
-						 dns_dbversion_t **versionp,
-						 dns_dbnode_t **nodep,
-						 dns_name_t *fname,
-						 dns_message_t *msg,
-						 isc_stdtime_t now);
-	isc_result_t		(*setadditional)(dns_rdataset_t *rdataset,
-						 dns_rdatasetadditional_t type,
-						 dns_rdatatype_t qtype,
-						 dns_acache_t *acache,
-						 dns_zone_t *zone,
-						 dns_db_t *db,
-						 dns_dbversion_t *version,
-						 dns_dbnode_t *node,
-						 dns_name_t *fname);
-	isc_result_t		(*putadditional)(dns_acache_t *acache,
-						 dns_rdataset_t *rdataset,
-						 dns_rdatasetadditional_t type,
-						 dns_rdatatype_t qtype);
 	void			(*settrust)(dns_rdataset_t *rdataset,
 					    dns_trust_t trust);
 	void			(*expire)(dns_rdataset_t *rdataset);
@@ -107,6 +77,10 @@ typedef struct dns_rdatasetmethods {
 	void			(*setownercase)(dns_rdataset_t *rdataset,
 						const dns_name_t *name);
 	void			(*getownercase)(const dns_rdataset_t *rdataset,							dns_name_t *name);
+	isc_result_t		(*addglue)(dns_rdataset_t *rdataset,
+					   dns_dbversion_t *version,
+					   unsigned int options,
+					   dns_message_t *msg);
 } dns_rdatasetmethods_t;
 
 #define DNS_RDATASET_MAGIC	       ISC_MAGIC('D','N','S','R')
@@ -174,6 +148,11 @@ struct dns_rdataset {
  *
  * \def DNS_RDATASETATTR_LOADORDER
  *	Output the RRset in load order.
+ *
+ * \def DNS_RDATASETATTR_STALE
+ *	The RRset expired from the cache and was only returned because
+ *	#DNS_DBFIND_STALEOK was set; its TTL is what remains of the
+ *	serve-stale window.
  */
 
 #define DNS_RDATASETATTR_QUESTION	0x00000001
@@ -200,6 +179,7 @@ struct dns_rdataset {
 #define DNS_RDATASETATTR_OPTOUT		0x00100000	/*%< OPTOUT proof */
 #define DNS_RDATASETATTR_NEGATIVE	0x00200000
 #define DNS_RDATASETATTR_PREFETCH	0x00400000
+#define DNS_RDATASETATTR_STALE		0x00800000
 
 /*%
  * _OMITDNSSEC:
@@ -207,6 +187,12 @@ struct dns_rdataset {
  */
 #define DNS_RDATASETTOWIRE_OMITDNSSEC	0x0001
 
+/*%
+ * _DNSSEC:
+ * 	Also add the signatures of glue records, if there are any.
+ */
+#define DNS_RDATASETADDGLUE_DNSSEC	0x0001
+
 void
 dns_rdataset_init(dns_rdataset_t *rdataset);
 /*%<
@@ -542,98 +528,6 @@ dns_rdataset_addclosest(dns_rdataset_t *rdataset, dns_name_t *name);
  *\li	'name' to be valid and have NSEC3 and RRSIG(NSEC3) rdatasets.
  */
 
-isc_result_t
-dns_rdataset_getadditional(dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype,
-			   dns_acache_t *acache,
-			   dns_zone_t **zonep,
-			   dns_db_t **dbp,
-			   dns_dbversion_t **versionp,
-			   dns_dbnode_t **nodep,
-			   dns_name_t *fname,
-			   dns_message_t *msg,
-			   isc_stdtime_t now);
-/*%<
- * Get cached additional information from the DB node for a particular
- * 'rdataset.'  'type' is one of dns_rdatasetadditional_fromauth,
- * dns_rdatasetadditional_fromcache, and dns_rdatasetadditional_fromglue,
- * which specifies the origin of the information.  'qtype' is intended to
- * be used for specifying a particular rdata type in the cached information.
- *
- * Requires:
- * \li	'rdataset' is a valid rdataset.
- * \li	'acache' can be NULL, in which case this function will simply return
- * 	ISC_R_FAILURE.
- * \li	For the other pointers, see dns_acache_getentry().
- *
- * Ensures:
- * \li	See dns_acache_getentry().
- *
- * Returns:
- * \li	#ISC_R_SUCCESS
- * \li	#ISC_R_FAILURE	- additional information caching is not supported.
- * \li	#ISC_R_NOTFOUND	- the corresponding DB node has not cached additional
- *			  information for 'rdataset.'
- * \li	Any error that dns_acache_getentry() can return.
- */
-
-isc_result_t
-dns_rdataset_setadditional(dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype,
-			   dns_acache_t *acache,
-			   dns_zone_t *zone,
-			   dns_db_t *db,
-			   dns_dbversion_t *version,
-			   dns_dbnode_t *node,
-			   dns_name_t *fname);
-/*%<
- * Set cached additional information to the DB node for a particular
- * 'rdataset.'  See dns_rdataset_getadditional for the semantics of 'type'
- * and 'qtype'.
- *
- * Requires:
- * \li	'rdataset' is a valid rdataset.
- * \li	'acache' can be NULL, in which case this function will simply return
- *	ISC_R_FAILURE.
- * \li	For the other pointers, see dns_acache_setentry().
- *
- * Ensures:
- * \li	See dns_acache_setentry().
- *
- * Returns:
- * \li	#ISC_R_SUCCESS
- * \li	#ISC_R_FAILURE	- additional information caching is not supported.
- * \li	#ISC_R_NOMEMORY
- * \li	Any error that dns_acache_setentry() can return.
- */
-
-isc_result_t
-dns_rdataset_putadditional(dns_acache_t *acache,
-			   dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype);
-/*%<
- * Discard cached additional information stored in the DB node for a particular
- * 'rdataset.'  See dns_rdataset_getadditional for the semantics of 'type'
- * and 'qtype'.
- *
- * Requires:
- * \li	'rdataset' is a valid rdataset.
- * \li	'acache' can be NULL, in which case this function will simply return
- *	ISC_R_FAILURE.
- *
- * Ensures:
- * \li	See dns_acache_cancelentry().
- *
- * Returns:
- * \li	#ISC_R_SUCCESS
- * \li	#ISC_R_FAILURE	- additional information caching is not supported.
- * \li	#ISC_R_NOTFOUND	- the corresponding DB node has not cached additional
- *			  information for 'rdataset.'
- */
-
 void
 dns_rdataset_settrust(dns_rdataset_t *rdataset, dns_trust_t trust);
 /*%<
@@ -699,6 +593,35 @@ dns_trust_totext(dns_trust_t trust);
  * Display trust in textual form.
  */
 
+isc_result_t
+dns_rdataset_addglue(dns_rdataset_t *rdataset, dns_dbversion_t *version,
+		     unsigned int options, dns_message_t *msg);
+/*%<
+ * Add the addresses of the name servers in the NS rdataset 'rdataset'
+ * that are at or below the origin of its database, as found in
+ * 'version' of that database, to the additional section of 'msg'.
+ * Name servers outside the zone are left to the caller.
+ *
+ * The addresses are looked up only the first time this is called for
+ * 'rdataset' in 'version'; they are kept with the version and
+ * discarded with it, so later calls just copy them into the message.
+ * Addresses already present in the additional section of 'msg' are
+ * not added again.  Signatures are added only if 'options' includes
+ * #DNS_RDATASETADDGLUE_DNSSEC.
+ *
+ * Requires:
+ * \li	'rdataset' is a valid NS rdataset.
+ * \li	'version' is a valid database version.
+ * \li	'msg' is a valid message.
+ *
+ * Returns:
+ * \li	#ISC_R_SUCCESS
+ * \li	#ISC_R_NOTIMPLEMENTED	- the database does not keep glue.
+ * \li	#ISC_R_FAILURE		- 'rdataset' was not found in the
+ *				  database of 'version'.
+ * \li	#ISC_R_NOMEMORY
+ */
+
 ISC_LANG_ENDDECLS
 
 #endif /* DNS_RDATASET_H */
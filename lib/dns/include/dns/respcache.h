@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DNS_RESPCACHE_H
+#define DNS_RESPCACHE_H 1
+
+/*****
+ ***** Module Info
+ *****/
+
+/*! \file dns/respcache.h
+ * \brief
+ * Defines dns_respcache_t, the response cache object.
+ *
+ * Notes:
+ *\li	A response cache holds complete responses in wire format,
+ *	indexed by the query name and type and a caller supplied key
+ *	that captures everything else in the query that the response
+ *	depends on (header flags, transport, buffer size and so on).
+ *	A server can answer a repeated query by copying the cached
+ *	response and patching its message ID and the case of the
+ *	question name.
+ *
+ *\li	Each entry records the zone its response was built from and
+ *	the zone's response generation at the time (see
+ *	dns_zone_getrespgen()); an entry whose zone has since changed is
+ *	ignored and freed when next found.  Responses which depend on
+ *	more than one zone are not stored.  Changes to the set of zones
+ *	a view serves are handled by dns_respcache_invalidate().
+ *
+ *\li	The entries are spread over several shards, each with its own
+ *	lock, so that lookups for different names rarely contend.
+ *
+ * Reliability:
+ *
+ * Resources:
+ *\li	The memory used by each response cache is limited to the size
+ *	given when it is created, split evenly between the shards.  When
+ *	a shard is full, entries which have not been used recently are
+ *	discarded first.  Each entry holds a reference to its zone.
+ *
+ * Security:
+ *
+ * Standards:
+ */
+
+/***
+ ***	Imports
+ ***/
+
+#include <isc/lang.h>
+#include <isc/types.h>
+
+#include <dns/types.h>
+
+ISC_LANG_BEGINDECLS
+
+/***
+ ***	Functions
+ ***/
+
+isc_result_t
+dns_respcache_create(isc_mem_t *mctx, size_t maxsize,
+		     dns_respcache_t **rcp);
+/*%
+ * Create a response cache which will use at most 'maxsize' bytes of
+ * memory, and store it in '*rcp'.
+ *
+ * Requires:
+ * \li	mctx != NULL
+ * \li	maxsize != 0
+ * \li	rcp != NULL && *rcp == NULL
+ */
+
+void
+dns_respcache_destroy(dns_respcache_t **rcp);
+/*%
+ * Flush and then free the response cache in '*rcp'.  '*rcp' is set
+ * to NULL on return.
+ *
+ * Requires:
+ * \li	'*rcp' to be a valid response cache.
+ */
+
+isc_uint32_t
+dns_respcache_generation(dns_respcache_t *rc);
+/*%
+ * Return the cache's current generation.  A caller should obtain this
+ * before it looks up the zone to answer a query from, and pass it to
+ * dns_respcache_add() when it stores the rendered response.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ */
+
+void
+dns_respcache_invalidate(dns_respcache_t *rc);
+/*%
+ * Advance the cache's generation and remove all its entries.  Called
+ * when a zone is added to or removed from the view's zone table, which
+ * may change responses from the other zones (or none) the view serves.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ */
+
+void
+dns_respcache_add(dns_respcache_t *rc, dns_name_t *name,
+		  dns_rdatatype_t type, isc_uint32_t key,
+		  dns_zone_t *zone, isc_uint32_t zonegen,
+		  isc_uint32_t generation, const isc_region_t *wire);
+/*%
+ * Store the response 'wire' to the query for 'name' and 'type' with
+ * key 'key', built from 'zone' while its response generation was
+ * 'zonegen', replacing any existing entry for them.  Nothing is stored
+ * if 'zonegen' is odd or no longer the zone's response generation, if
+ * 'generation' is no longer the cache's generation, or if the response
+ * would take up more than the cache's maximum size allows.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ * \li	'name' to be absolute.
+ * \li	'zone' to be a valid zone.
+ * \li	wire != NULL && wire->length >= 12
+ */
+
+isc_result_t
+dns_respcache_find(dns_respcache_t *rc, dns_name_t *name,
+		   dns_rdatatype_t type, isc_uint32_t key,
+		   isc_buffer_t *target);
+/*%
+ * Look for a current response to the query for 'name' and 'type' with
+ * key 'key' and if found, copy it to 'target'.  The name is compared
+ * without regard to case.  An entry whose zone has changed since it
+ * was stored is removed and not returned.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ * \li	'target' to be a valid buffer.
+ *
+ * Returns:
+ * \li	#ISC_R_SUCCESS
+ * \li	#ISC_R_NOTFOUND		no current entry was found.
+ * \li	#ISC_R_NOSPACE		an entry was found but it does not fit
+ *				in 'target'.
+ */
+
+void
+dns_respcache_flush(dns_respcache_t *rc);
+/*%
+ * Remove all entries from the response cache.  This releases the
+ * references they hold to their zones.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ */
+
+void
+dns_respcache_getstats(dns_respcache_t *rc, unsigned int *countp,
+		       size_t *sizep);
+/*%
+ * Return the number of entries in the response cache and the memory
+ * used by them.
+ *
+ * Requires:
+ * \li	'rc' to be a valid response cache.
+ */
+
+ISC_LANG_ENDDECLS
+
+#endif /* DNS_RESPCACHE_H */
@@ -116,8 +116,13 @@ enum {
 	dns_cachestatscounter_querymisses = 4,
 	dns_cachestatscounter_deletelru = 5,
 	dns_cachestatscounter_deletettl = 6,
+	dns_cachestatscounter_cleanerpasses = 7,
+	dns_cachestatscounter_hothits = 8,
+	dns_cachestatscounter_promotelru = 9,
+	dns_cachestatscounter_demotelru = 10,
+	dns_cachestatscounter_deletelruhot = 11,
 
-	dns_cachestatscounter_max = 7,
+	dns_cachestatscounter_max = 12,
 
 	/*%
 	 * Query statistics counters (obsolete).
@@ -240,7 +245,9 @@ dns_rdatatypestats_create(isc_mem_t *mctx, dns_stats_t **statsp);
 isc_result_t
 dns_rdatasetstats_create(isc_mem_t *mctx, dns_stats_t **statsp);
 /*%<
- * Create a statistics counter structure per RRset.
+ * Create a statistics counter structure per RRset.  The counters are
+ * sharded per thread (see isc_stats_create2()), since a cache updates
+ * them on every change.
  *
  * Requires:
  *\li	'mctx' must be a valid memory context.
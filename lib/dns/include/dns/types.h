@@ -22,9 +22,6 @@
 
 #include <isc/types.h>
 
-typedef struct dns_acache			dns_acache_t;
-typedef struct dns_acacheentry			dns_acacheentry_t;
-typedef struct dns_acachestats			dns_acachestats_t;
 typedef struct dns_acl 				dns_acl_t;
 typedef struct dns_aclelement 			dns_aclelement_t;
 typedef struct dns_aclenv			dns_aclenv_t;
@@ -123,6 +120,7 @@ typedef isc_uint16_t				dns_rdatatype_t;
 typedef struct dns_request			dns_request_t;
 typedef struct dns_requestmgr			dns_requestmgr_t;
 typedef struct dns_resolver			dns_resolver_t;
+typedef struct dns_respcache			dns_respcache_t;
 typedef struct dns_sdbimplementation		dns_sdbimplementation_t;
 typedef isc_uint8_t				dns_secalg_t;
 typedef isc_uint8_t				dns_secproto_t;
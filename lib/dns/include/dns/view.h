@@ -83,7 +83,6 @@ struct dns_view {
 	dns_resolver_t *		resolver;
 	dns_adb_t *			adb;
 	dns_requestmgr_t *		requestmgr;
-	dns_acache_t *			acache;
 	dns_cache_t *			cache;
 	dns_db_t *			cachedb;
 	dns_db_t *			hints;
@@ -116,6 +115,7 @@ struct dns_view {
 	isc_boolean_t			auth_nxdomain;
 	isc_boolean_t			additionalfromcache;
 	isc_boolean_t			additionalfromauth;
+	isc_boolean_t			use_glue_cache;
 	isc_boolean_t			minimal_any;
 	dns_minimaltype_t		minimalresponses;
 	isc_boolean_t			enablednssec;
@@ -147,6 +147,10 @@ struct dns_view {
 	isc_boolean_t			sendcookie;
 	dns_ttl_t			maxcachettl;
 	dns_ttl_t			maxncachettl;
+	isc_boolean_t			staleanswersenable;
+	dns_ttl_t			staleanswerttl;
+	isc_uint32_t			staleanswerclienttimeout;
+	isc_uint32_t			stalerefresh;
 	isc_uint32_t			nta_lifetime;
 	isc_uint32_t			nta_recheck;
 	char				*nta_file;
@@ -176,6 +180,7 @@ struct dns_view {
 	dns_dlzdblist_t 		dlz_unsearched;
 	isc_uint32_t			fail_ttl;
 	dns_badcache_t			*failcache;
+	dns_respcache_t			*respcache;
 
 	/*
 	 * Configurable data for server use only,
@@ -499,6 +499,19 @@ dns_zone_getdb(dns_zone_t *zone, dns_db_t **dbp);
  *\li	DNS_R_NOTLOADED
  */
 
+isc_uint32_t
+dns_zone_getrespgen(dns_zone_t *zone);
+/*%<
+ *	Return the zone's response generation, which changes whenever
+ *	the data served from the zone may have changed: when its
+ *	database is replaced or a new version of it is committed.  An
+ *	odd generation means changes to the zone's database can't be
+ *	tracked, so responses built from it must not be reused.
+ *
+ * Require:
+ *\li	'zone' to be a valid zone.
+ */
+
 void
 dns_zone_setdb(dns_zone_t *zone, dns_db_t *db);
 /*%<
@@ -2047,19 +2060,6 @@ dns_zone_checknames(dns_zone_t *zone, dns_name_t *name, dns_rdata_t *rdata);
  *	DNS_R_BADNAME		failed rdata checks.
  */
 
-void
-dns_zone_setacache(dns_zone_t *zone, dns_acache_t *acache);
-/*%<
- *	Associate the zone with an additional cache.
- *
- * Require:
- *	'zone' to be a valid zone.
- *	'acache' to be a non NULL pointer.
- *
- * Ensures:
- *	'zone' will have a reference to 'acache'
- */
-
 void
 dns_zone_setcheckmx(dns_zone_t *zone, dns_checkmxfunc_t checkmx);
 /*%<
@@ -1972,11 +1972,9 @@ dns_name_towire(const dns_name_t *name, dns_compress_t *cctx,
 {
 	unsigned int methods;
 	isc_uint16_t offset;
-	dns_name_t gp;	/* Global compression prefix */
-	isc_boolean_t gf;	/* Global compression target found */
+	unsigned int prefix;	/* Length of the labels not found */
 	isc_uint16_t go;	/* Global compression offset */
-	dns_offsets_t clo;
-	dns_name_t clname;
+	unsigned char *base;
 
 	/*
 	 * Convert 'name' into wire format, compressing it as specified by the
@@ -1987,69 +1985,57 @@ dns_name_towire(const dns_name_t *name, dns_compress_t *cctx,
 	REQUIRE(cctx != NULL);
 	REQUIRE(ISC_BUFFER_VALID(target));
 
+	offset = target->used;	/*XXX*/
+
 	/*
-	 * If 'name' doesn't have an offsets table, make a clone which
-	 * has one.
+	 * The name is added to the compression table whether or not it
+	 * may itself be compressed.
 	 */
-	if (name->offsets == NULL) {
-#if defined(__clang__)  && \
-       ( __clang_major__ < 3 || (__clang_major__ == 3 && __clang_minor__ < 2))
-		memset(&clname, 0, sizeof(clname));
-#endif
-		DNS_NAME_INIT(&clname, clo);
-		dns_name_clone(name, &clname);
-		name = &clname;
+	if ((name->attributes & DNS_NAMEATTR_ABSOLUTE) != 0)
+		dns_compress_name(cctx, target, name, &prefix, &go);
+	else {
+		prefix = name->length;
+		go = 0;
 	}
-	DNS_NAME_INIT(&gp, NULL);
-
-	offset = target->used;	/*XXX*/
 
 	methods = dns_compress_getmethods(cctx);
-
-	if ((name->attributes & DNS_NAMEATTR_NOCOMPRESS) == 0 &&
-	    (methods & DNS_COMPRESS_GLOBAL14) != 0)
-		gf = dns_compress_findglobal(cctx, name, &gp, &go);
-	else
-		gf = ISC_FALSE;
+	if ((name->attributes & DNS_NAMEATTR_NOCOMPRESS) != 0 ||
+	    (methods & DNS_COMPRESS_GLOBAL14) == 0)
+		prefix = name->length;
 
 	/*
 	 * If the offset is too high for 14 bit global compression, we're
 	 * out of luck.
 	 */
-	if (gf && go >= 0x4000)
-		gf = ISC_FALSE;
+	if (prefix < name->length && go >= 0x4000)
+		prefix = name->length;
 
 	/*
 	 * Will the compression pointer reduce the message size?
 	 */
-	if (gf && (gp.length + 2) >= name->length)
-		gf = ISC_FALSE;
+	if (prefix < name->length && (prefix + 2) >= name->length)
+		prefix = name->length;
 
-	if (gf) {
-		if (target->length - target->used < gp.length)
+	base = target->base;
+	if (prefix < name->length) {
+		if (target->length - target->used < prefix + 2) {
+			dns_compress_rollback(cctx, offset);
 			return (ISC_R_NOSPACE);
-		if (gp.length != 0) {
-			unsigned char *base = target->base;
-			(void)memmove(base + target->used, gp.ndata,
-				      (size_t)gp.length);
 		}
-		isc_buffer_add(target, gp.length);
-		go |= 0xc000;
-		if (target->length - target->used < 2)
-			return (ISC_R_NOSPACE);
-		isc_buffer_putuint16(target, go);
-		if (gp.length != 0)
-			dns_compress_add(cctx, name, &gp, offset);
+		if (prefix != 0)
+			(void)memmove(base + target->used, name->ndata,
+				      (size_t)prefix);
+		isc_buffer_add(target, prefix);
+		isc_buffer_putuint16(target, go | 0xc000);
 	} else {
-		if (target->length - target->used < name->length)
+		if (target->length - target->used < name->length) {
+			dns_compress_rollback(cctx, offset);
 			return (ISC_R_NOSPACE);
-		if (name->length != 0) {
-			unsigned char *base = target->base;
+		}
+		if (name->length != 0)
 			(void)memmove(base + target->used, name->ndata,
 				      (size_t)name->length);
-		}
 		isc_buffer_add(target, name->length);
-		dns_compress_add(cctx, name, name, offset);
 	}
 	return (ISC_R_SUCCESS);
 }
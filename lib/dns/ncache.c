@@ -488,13 +488,11 @@ static dns_rdatasetmethods_t rdataset_methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
-	NULL,
 	rdataset_settrust,
 	NULL,
 	NULL,
 	NULL,
+	NULL,
 	NULL
 };
 
@@ -0,0 +1,6714 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*! \file
+ * \brief
+ * The "qp" database implementation.
+ *
+ * This keeps the names of a zone or cache in a qp-trie (a radix tree
+ * branching on 4-bit nibbles, whose branch nodes only hold a bitmap of
+ * the children present and a packed array of them) instead of the
+ * red-black tree of trees used by rbtdb.c.  The trie is keyed on the
+ * labels of a name in wire format, most significant first, and the key
+ * is built so that its byte order is the DNSSEC canonical order of the
+ * names (see qp_makekey()); so a lookup is one descent through a few
+ * small arrays, and the predecessor or the successor of a name, which
+ * is what NSEC proofs and iterators need, is found the same way.
+ *
+ * The rdatasets of a node are kept as in rbtdb.c: a list of
+ * rdatasetheader_t, one per type, each with the older versions of that
+ * rdataset below it, and the rdata in an rdataslab following the header.
+ *
+ * Locking is deliberately simple: 'tree_lock' protects both the tries
+ * and the rdatasets of every node, lookups hold it for reading and
+ * changes for writing.  A node is removed from its trie, under the
+ * write lock, once it has no rdatasets left and nothing refers to it.
+ *
+ * Compared with rbtdb.c this leaves out: the "map" master file format,
+ * automatic re-signing (dns_db_getsigningtime() finds nothing), response
+ * policy zones, serving stale data, preserving the case of owner names
+ * in a cache, and the additional section cache; a cache has no LRU, so
+ * it is only cleaned of expired data by the cache cleaner's iteration.
+ */
+
+#include <config.h>
+
+#include <isc/mem.h>
+#include <isc/mutex.h>
+#include <isc/print.h>
+#include <isc/random.h>
+#include <isc/refcount.h>
+#include <isc/rwlock.h>
+#include <isc/serial.h>
+#include <isc/stats.h>
+#include <isc/string.h>
+#include <isc/util.h>
+
+#include <dns/callbacks.h>
+#include <dns/db.h>
+#include <dns/dbiterator.h>
+#include <dns/fixedname.h>
+#include <dns/log.h>
+#include <dns/masterdump.h>
+#include <dns/nsec3.h>
+#include <dns/rdata.h>
+#include <dns/rdataset.h>
+#include <dns/rdatasetiter.h>
+#include <dns/rdataslab.h>
+#include <dns/rdatastruct.h>
+#include <dns/result.h>
+#include <dns/stats.h>
+#include <dns/zonekey.h>
+
+#include "qpdb.h"
+
+#define QPDB_MAGIC			ISC_MAGIC('Q', 'P', 'D', 'B')
+
+/*%
+ * Note that "impmagic" is not the first four bytes of the struct, so
+ * ISC_MAGIC_VALID cannot be used.
+ */
+#define VALID_QPDB(qpdb)	((qpdb) != NULL && \
+				 (qpdb)->common.impmagic == QPDB_MAGIC)
+
+#define CHECK(op) \
+	do { result = (op); \
+		if (result != ISC_R_SUCCESS) goto failure; \
+	} while (0)
+
+typedef isc_uint32_t			qpdb_serial_t;
+typedef isc_uint32_t			qpdb_rdatatype_t;
+
+#define QPDB_RDATATYPE_BASE(type)	((dns_rdatatype_t)((type) & 0xFFFF))
+#define QPDB_RDATATYPE_EXT(type)	((dns_rdatatype_t)((type) >> 16))
+#define QPDB_RDATATYPE_VALUE(base, ext) ((qpdb_rdatatype_t)(((isc_uint32_t)ext) << 16) | (((isc_uint32_t)base) & 0xffff))
+
+#define QPDB_RDATATYPE_SIGNSEC \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_nsec)
+#define QPDB_RDATATYPE_SIGNSEC3 \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_nsec3)
+#define QPDB_RDATATYPE_SIGNS \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_ns)
+#define QPDB_RDATATYPE_SIGCNAME \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_cname)
+#define QPDB_RDATATYPE_SIGDNAME \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_dname)
+#define QPDB_RDATATYPE_SIGDDS \
+		QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, dns_rdatatype_ds)
+#define QPDB_RDATATYPE_NCACHEANY \
+		QPDB_RDATATYPE_VALUE(0, dns_rdatatype_any)
+
+/*
+ * Allow clients with a virtual time of up to 5 minutes in the past to see
+ * records that would have otherwise have expired.
+ */
+#define QPDB_VIRTUAL 300
+
+/***
+ *** The trie
+ ***/
+
+/*
+ * A key is the name it was made from with the labels in reverse order,
+ * the root label left out, each label followed by a separator byte
+ * (QP_SEPARATOR) and each byte of a label mapped by qp_byte(); past its
+ * end a key reads as zeroes.  The mapping folds case and keeps every
+ * label byte at 0x10 or above, so that:
+ *
+ *\li	comparing two keys byte by byte compares the names in DNSSEC
+ *	canonical order, a name sorting before its descendants;
+ *
+ *\li	a name's key is a prefix of the keys of the names below it, and
+ *	the first nibble where they differ is the high nibble of the byte
+ *	just past the end of the shorter key, which is zero there and not
+ *	zero in the longer one.
+ *
+ * A key is one byte shorter than the name in wire format.
+ */
+#define QP_MAXKEY		(DNS_NAME_MAXWIRE - 1)
+#define QP_SEPARATOR		0x01
+#define QP_NODIFF		(~0U)
+/*% Deepest possible descent: one branch per nibble of the longest key. */
+#define QP_MAXDEPTH		(QP_MAXKEY * 2 + 2)
+
+typedef struct {
+	unsigned int		len;
+	unsigned char		bytes[QP_MAXKEY];
+} qp_key_t;
+
+/*%
+ * A twig is either a leaf, whose bitmap is zero and whose 'ptr' is the
+ * node (qpnode_t) the leaf stands for, or a branch, which tests the
+ * nibble 'index' of a key and whose 'ptr' is a packed array of twigs,
+ * one for each nibble value set in 'bitmap', in nibble order.
+ */
+typedef struct qp_twig {
+	isc_uint32_t		index;
+	isc_uint16_t		bitmap;
+	void *			ptr;
+} qp_twig_t;
+
+typedef struct {
+	qp_twig_t		root;
+	unsigned int		count;
+} qp_trie_t;
+
+#define QP_ISLEAF(t)		((t)->bitmap == 0)
+#define QP_BIT(nibble)		((isc_uint16_t)(1 << (nibble)))
+#define QP_HASBIT(t, bit)	(((t)->bitmap & (bit)) != 0)
+#define QP_POS(t, bit)		qp_popcount((t)->bitmap & ((bit) - 1))
+#define QP_COUNT(t)		qp_popcount((t)->bitmap)
+#define QP_CHILDREN(t)		((qp_twig_t *)(t)->ptr)
+
+static inline unsigned int
+qp_popcount(isc_uint16_t bitmap) {
+	unsigned int x = bitmap;
+
+	x = x - ((x >> 1) & 0x5555);
+	x = (x & 0x3333) + ((x >> 2) & 0x3333);
+	x = (x + (x >> 4)) & 0x0f0f;
+	return ((x + (x >> 8)) & 0x1f);
+}
+
+static inline unsigned char
+qp_byte(unsigned char c) {
+	if (c < 'A')
+		return (c + 0x10);
+	if (c <= 'Z')
+		c += 'a' - 'A';
+	return (c - 10);
+}
+
+static inline unsigned int
+qp_nibble(const qp_key_t *key, isc_uint32_t index) {
+	unsigned int off = index >> 1;
+
+	if (off >= key->len)
+		return (0);
+	if ((index & 1) == 0)
+		return (key->bytes[off] >> 4);
+	return (key->bytes[off] & 0x0f);
+}
+
+/*%
+ * Make the key of the name in wire format 'ndata', whose 'labels' labels
+ * (counting the root label) start at 'offsets'.
+ */
+static void
+qp_makekey(const unsigned char *ndata, const unsigned char *offsets,
+	   unsigned int labels, qp_key_t *key)
+{
+	const unsigned char *label;
+	unsigned char *kp = key->bytes;
+	unsigned int i, count;
+
+	REQUIRE(labels > 0);
+
+	for (i = labels - 1; i-- > 0; ) {
+		label = ndata + offsets[i];
+		count = *label++;
+		while (count-- > 0)
+			*kp++ = qp_byte(*label++);
+		*kp++ = QP_SEPARATOR;
+	}
+	key->len = (unsigned int)(kp - key->bytes);
+}
+
+/*%
+ * Make the key of the absolute name 'name'.
+ */
+static void
+qp_namekey(const dns_name_t *name, qp_key_t *key) {
+	unsigned char offsets[128];
+	const unsigned char *ndata = name->ndata;
+	unsigned int labels = 0;
+
+	REQUIRE(dns_name_isabsolute(name));
+
+	if (name->offsets != NULL) {
+		qp_makekey(ndata, name->offsets, name->labels, key);
+		return;
+	}
+	for (;;) {
+		offsets[labels++] = (unsigned char)(ndata - name->ndata);
+		if (*ndata == 0)
+			break;
+		ndata += *ndata + 1;
+	}
+	qp_makekey(name->ndata, offsets, labels, key);
+}
+
+/*%
+ * Return the index of the first nibble where 'a' and 'b' differ, or
+ * QP_NODIFF if they are the same.
+ */
+static inline unsigned int
+qp_keydiff(const qp_key_t *a, const qp_key_t *b) {
+	unsigned int i, len;
+	unsigned char x;
+
+	len = ISC_MAX(a->len, b->len);
+	for (i = 0; i < len; i++) {
+		x = (i < a->len ? a->bytes[i] : 0) ^
+		    (i < b->len ? b->bytes[i] : 0);
+		if (x != 0)
+			return (i * 2 + ((x & 0xf0) == 0 ? 1 : 0));
+	}
+	return (QP_NODIFF);
+}
+
+static void qp_leafkey(qp_twig_t *leaf, qp_key_t *key);
+static unsigned int qp_leafkeylen(qp_twig_t *leaf);
+
+static inline qp_twig_t *
+qp_edge(qp_twig_t *t, isc_boolean_t last) {
+	while (!QP_ISLEAF(t)) {
+		if (last)
+			t = QP_CHILDREN(t) + QP_COUNT(t) - 1;
+		else
+			t = QP_CHILDREN(t);
+	}
+	return (t);
+}
+
+static inline void *
+qp_first(qp_trie_t *trie) {
+	if (trie->root.ptr == NULL)
+		return (NULL);
+	return (qp_edge(&trie->root, ISC_FALSE)->ptr);
+}
+
+static inline void *
+qp_last(qp_trie_t *trie) {
+	if (trie->root.ptr == NULL)
+		return (NULL);
+	return (qp_edge(&trie->root, ISC_TRUE)->ptr);
+}
+
+/*%
+ * Look 'key' up in 'trie', returning its node, or NULL if it is not
+ * there.  If 'nancestorsp' is not NULL, the number of names above the
+ * name that are in the trie is put there, and if 'ancestors' is not
+ * NULL too, their nodes, up to 128 of them, from the top down.
+ */
+static void *
+qp_lookup(qp_trie_t *trie, const qp_key_t *key, void **ancestors,
+	  unsigned int *nancestorsp)
+{
+	qp_twig_t *t = &trie->root, *candidate[128];
+	unsigned int ncandidates = 0, nancestors = 0, i, d;
+	isc_uint16_t bit;
+	qp_key_t leafkey;
+
+	if (nancestorsp != NULL)
+		*nancestorsp = 0;
+	if (t->ptr == NULL)
+		return (NULL);
+
+	while (!QP_ISLEAF(t)) {
+		bit = QP_BIT(qp_nibble(key, t->index));
+		/*
+		 * The leaf in the first child of a branch testing the
+		 * nibble just past the end of its key is the only name in
+		 * the branch ending there: if it matches the key so far,
+		 * which is checked once we know what the key matches, it
+		 * is an ancestor.
+		 */
+		if (nancestorsp != NULL && bit != QP_BIT(0) &&
+		    (t->index & 1) == 0 && (t->index >> 1) < key->len &&
+		    (t->bitmap & 1) != 0 && QP_ISLEAF(QP_CHILDREN(t)) &&
+		    qp_leafkeylen(QP_CHILDREN(t)) == (t->index >> 1))
+			candidate[ncandidates++] = QP_CHILDREN(t);
+		if (QP_HASBIT(t, bit))
+			t = QP_CHILDREN(t) + QP_POS(t, bit);
+		else
+			t = QP_CHILDREN(t);
+	}
+
+	qp_leafkey(t, &leafkey);
+	d = qp_keydiff(key, &leafkey);
+	if (nancestorsp != NULL) {
+		for (i = 0; i < ncandidates; i++) {
+			if (candidate[i] == t)
+				break;
+			if (d != QP_NODIFF &&
+			    qp_leafkeylen(candidate[i]) * 2 > d)
+				break;
+			if (ancestors != NULL)
+				ancestors[nancestors] = candidate[i]->ptr;
+			nancestors++;
+		}
+		if (d != QP_NODIFF && leafkey.len < key->len &&
+		    leafkey.len * 2 <= d)
+		{
+			if (ancestors != NULL)
+				ancestors[nancestors] = t->ptr;
+			nancestors++;
+		}
+		*nancestorsp = nancestors;
+	}
+	if (d != QP_NODIFF)
+		return (NULL);
+	return (t->ptr);
+}
+
+/*%
+ * Add 'node', whose key is 'key', to 'trie'.
+ */
+static isc_result_t
+qp_insert(isc_mem_t *mctx, qp_trie_t *trie, const qp_key_t *key, void *node)
+{
+	qp_twig_t *t = &trie->root, *twigs;
+	unsigned int d, n, pos;
+	isc_uint16_t bit, leafbit;
+	qp_key_t leafkey;
+
+	if (t->ptr == NULL) {
+		t->index = 0;
+		t->bitmap = 0;
+		t->ptr = node;
+		trie->count++;
+		return (ISC_R_SUCCESS);
+	}
+
+	/*
+	 * Find out where the key differs from those already there.
+	 */
+	while (!QP_ISLEAF(t)) {
+		bit = QP_BIT(qp_nibble(key, t->index));
+		if (QP_HASBIT(t, bit))
+			t = QP_CHILDREN(t) + QP_POS(t, bit);
+		else
+			t = QP_CHILDREN(t);
+	}
+	qp_leafkey(t, &leafkey);
+	d = qp_keydiff(key, &leafkey);
+	if (d == QP_NODIFF)
+		return (ISC_R_EXISTS);
+	bit = QP_BIT(qp_nibble(key, d));
+
+	/*
+	 * Go back down to where the new leaf belongs: a branch that tests
+	 * nibble 'd' gets another child, anything else is split.
+	 */
+	t = &trie->root;
+	while (!QP_ISLEAF(t) && t->index < d)
+		t = QP_CHILDREN(t) + QP_POS(t, QP_BIT(qp_nibble(key,
+							       t->index)));
+
+	if (!QP_ISLEAF(t) && t->index == d) {
+		INSIST(!QP_HASBIT(t, bit));
+		n = QP_COUNT(t);
+		pos = QP_POS(t, bit);
+		twigs = isc_mem_get(mctx, (n + 1) * sizeof(qp_twig_t));
+		if (twigs == NULL)
+			return (ISC_R_NOMEMORY);
+		memmove(twigs, QP_CHILDREN(t), pos * sizeof(qp_twig_t));
+		memmove(twigs + pos + 1, QP_CHILDREN(t) + pos,
+			(n - pos) * sizeof(qp_twig_t));
+		twigs[pos].index = 0;
+		twigs[pos].bitmap = 0;
+		twigs[pos].ptr = node;
+		isc_mem_put(mctx, t->ptr, n * sizeof(qp_twig_t));
+		t->bitmap |= bit;
+		t->ptr = twigs;
+	} else {
+		leafbit = QP_BIT(qp_nibble(&leafkey, d));
+		twigs = isc_mem_get(mctx, 2 * sizeof(qp_twig_t));
+		if (twigs == NULL)
+			return (ISC_R_NOMEMORY);
+		pos = (bit < leafbit) ? 0 : 1;
+		twigs[1 - pos] = *t;
+		twigs[pos].index = 0;
+		twigs[pos].bitmap = 0;
+		twigs[pos].ptr = node;
+		t->index = d;
+		t->bitmap = bit | leafbit;
+		t->ptr = twigs;
+	}
+	trie->count++;
+
+	return (ISC_R_SUCCESS);
+}
+
+/*%
+ * Remove 'node', whose key is 'key', from 'trie'.
+ */
+static isc_result_t
+qp_delete(isc_mem_t *mctx, qp_trie_t *trie, const qp_key_t *key, void *node)
+{
+	qp_twig_t *t = &trie->root, *parent = NULL, *twigs;
+	unsigned int n, pos = 0;
+	isc_uint16_t bit = 0;
+
+	if (t->ptr == NULL)
+		return (ISC_R_NOTFOUND);
+
+	while (!QP_ISLEAF(t)) {
+		bit = QP_BIT(qp_nibble(key, t->index));
+		if (!QP_HASBIT(t, bit))
+			return (ISC_R_NOTFOUND);
+		parent = t;
+		pos = QP_POS(t, bit);
+		t = QP_CHILDREN(t) + pos;
+	}
+	if (t->ptr != node)
+		return (ISC_R_NOTFOUND);
+
+	if (parent == NULL) {
+		t->ptr = NULL;
+	} else if ((n = QP_COUNT(parent)) == 2) {
+		twigs = QP_CHILDREN(parent);
+		*parent = twigs[1 - pos];
+		isc_mem_put(mctx, twigs, 2 * sizeof(qp_twig_t));
+	} else {
+		twigs = isc_mem_get(mctx, (n - 1) * sizeof(qp_twig_t));
+		if (twigs == NULL)
+			return (ISC_R_NOMEMORY);
+		memmove(twigs, QP_CHILDREN(parent), pos * sizeof(qp_twig_t));
+		memmove(twigs + pos, QP_CHILDREN(parent) + pos + 1,
+			(n - pos - 1) * sizeof(qp_twig_t));
+		isc_mem_put(mctx, parent->ptr, n * sizeof(qp_twig_t));
+		parent->bitmap &= ~bit;
+		parent->ptr = twigs;
+	}
+	trie->count--;
+
+	return (ISC_R_SUCCESS);
+}
+
+/*%
+ * Return the node of the last name in 'trie' before 'key' (if 'forward'
+ * is false) or the first name after it, or that of 'key' itself if it
+ * is there and 'inclusive' is true; NULL if there is no such name.
+ */
+static void *
+qp_neighbor(qp_trie_t *trie, const qp_key_t *key, isc_boolean_t forward,
+	    isc_boolean_t inclusive)
+{
+	qp_twig_t *stack[QP_MAXDEPTH], *t = &trie->root, *next;
+	unsigned int depth = 0, i, d, n, pos;
+	isc_uint16_t bit;
+	qp_key_t leafkey;
+
+	if (t->ptr == NULL)
+		return (NULL);
+
+	while (!QP_ISLEAF(t)) {
+		stack[depth++] = t;
+		bit = QP_BIT(qp_nibble(key, t->index));
+		if (QP_HASBIT(t, bit))
+			t = QP_CHILDREN(t) + QP_POS(t, bit);
+		else
+			t = QP_CHILDREN(t);
+	}
+	qp_leafkey(t, &leafkey);
+	d = qp_keydiff(key, &leafkey);
+
+	if (d == QP_NODIFF) {
+		if (inclusive)
+			return (t->ptr);
+		i = depth;
+	} else {
+		/*
+		 * Find the first branch on the way down that tests a nibble
+		 * at or past the one where the key differs from the leaf.
+		 */
+		for (i = 0; i < depth; i++)
+			if (stack[i]->index >= d)
+				break;
+		if (i < depth && stack[i]->index == d) {
+			/*
+			 * The key's nibble is not there: its neighbours are
+			 * in the children on either side of where it would
+			 * be.
+			 */
+			t = stack[i];
+			bit = QP_BIT(qp_nibble(key, d));
+			pos = QP_POS(t, bit);
+			n = QP_COUNT(t);
+			if (!forward && pos > 0)
+				return (qp_edge(QP_CHILDREN(t) + pos - 1,
+						ISC_TRUE)->ptr);
+			if (forward && pos < n)
+				return (qp_edge(QP_CHILDREN(t) + pos,
+						ISC_FALSE)->ptr);
+		} else {
+			/*
+			 * Everything below this point shares the leaf's
+			 * nibbles up to 'd', so the key sorts before or
+			 * after all of it.
+			 */
+			next = (i < depth) ? stack[i] : t;
+			if (forward && qp_nibble(key, d) <
+				       qp_nibble(&leafkey, d))
+				return (qp_edge(next, ISC_FALSE)->ptr);
+			if (!forward && qp_nibble(key, d) >
+					qp_nibble(&leafkey, d))
+				return (qp_edge(next, ISC_TRUE)->ptr);
+		}
+	}
+
+	/*
+	 * Go up until there is a sibling on the wanted side.
+	 */
+	while (i-- > 0) {
+		t = stack[i];
+		bit = QP_BIT(qp_nibble(&leafkey, t->index));
+		pos = QP_POS(t, bit);
+		n = QP_COUNT(t);
+		if (!forward && pos > 0)
+			return (qp_edge(QP_CHILDREN(t) + pos - 1,
+					ISC_TRUE)->ptr);
+		if (forward && pos + 1 < n)
+			return (qp_edge(QP_CHILDREN(t) + pos + 1,
+					ISC_FALSE)->ptr);
+	}
+
+	return (NULL);
+}
+
+
+/*%
+ * Free the branches of 'trie', calling 'action' on each of its nodes.
+ */
+static void
+qp_free(isc_mem_t *mctx, qp_twig_t *t, void (*action)(void *, void *),
+	void *arg)
+{
+	unsigned int i, n;
+
+	if (t->ptr == NULL)
+		return;
+	if (QP_ISLEAF(t)) {
+		(action)(t->ptr, arg);
+		return;
+	}
+	n = QP_COUNT(t);
+	for (i = 0; i < n; i++)
+		qp_free(mctx, QP_CHILDREN(t) + i, action, arg);
+	isc_mem_put(mctx, t->ptr, n * sizeof(qp_twig_t));
+}
+
+static void
+qp_destroy(isc_mem_t *mctx, qp_trie_t *trie, void (*action)(void *, void *),
+	   void *arg)
+{
+	qp_free(mctx, &trie->root, action, arg);
+	trie->root.ptr = NULL;
+	trie->root.bitmap = 0;
+	trie->count = 0;
+}
+
+/***
+ *** Nodes, rdatasets and the database
+ ***/
+
+struct noqname {
+	dns_name_t	name;
+	void *		neg;
+	void *		negsig;
+	dns_rdatatype_t	type;
+};
+
+/*%
+ * A name in the database.  The name in wire format follows the node,
+ * and its label offsets follow the name.
+ */
+typedef struct qpnode {
+	isc_refcount_t			references;
+	/*%
+	 * Locked by the tree lock.
+	 */
+	unsigned int			wild : 1;
+	/*%<
+	 * Zone only: there is a wildcard name just below this one.
+	 */
+	unsigned int			delegating : 1;
+	/*%<
+	 * An NS or a DNAME rdataset has been added here, so finds
+	 * of the names below must check for a zone cut.
+	 */
+	unsigned int			nsec3 : 1;
+	unsigned int			dirty : 1;
+	unsigned int			namelen : 8;
+	unsigned int			labels : 8;
+	struct rdatasetheader *		data;
+	struct qpnode *			deadnext;
+	/*%<
+	 * Locked by the dead node lock: the next node on the list of
+	 * nodes to be cleaned up once the tree can be write locked.  The
+	 * last node on the list points to itself, so a node is on the
+	 * list iff this is not NULL.
+	 */
+} qpnode_t;
+
+#define QPNODE_NAME(n)		((unsigned char *)((n) + 1))
+#define QPNODE_OFFSETS(n)	(QPNODE_NAME(n) + (n)->namelen)
+#define QPNODE_SIZE(n)		(sizeof(qpnode_t) + (n)->namelen + (n)->labels)
+
+/*%
+ * The slab of rdata follows the header directly.
+ */
+typedef struct rdatasetheader {
+	/*
+	 * We don't use the LIST macros, because the LIST structure has
+	 * both head and tail pointers, and is doubly linked.
+	 */
+	struct rdatasetheader *		next;
+	/*%<
+	 * If this is the top header for an rdataset, 'next' points
+	 * to the top header for the next rdataset (i.e., the next type).
+	 * Otherwise, it points up to the header whose down pointer points
+	 * at this header.
+	 */
+	struct rdatasetheader *		down;
+	/*%<
+	 * Points to the header for the next older version of
+	 * this rdataset.
+	 */
+	qpnode_t *			node;
+	struct noqname *		noqname;
+	struct noqname *		closest;
+	qpdb_serial_t			serial;
+	dns_ttl_t			rdh_ttl;
+	qpdb_rdatatype_t		type;
+	isc_uint16_t			attributes;
+	dns_trust_t			trust;
+	isc_uint32_t			count;
+	/*%<
+	 * Monotonously increased every time this rdataset is bound so that
+	 * it is used as the base of the starting point in DNS responses
+	 * when the "cyclic" rrset-order is required.
+	 */
+} rdatasetheader_t;
+
+#define RDATASET_ATTR_NONEXISTENT	0x0001
+#define RDATASET_ATTR_STALE		0x0002
+#define RDATASET_ATTR_IGNORE		0x0004
+#define RDATASET_ATTR_RETAIN		0x0008
+#define RDATASET_ATTR_NXDOMAIN		0x0010
+#define RDATASET_ATTR_OPTOUT		0x0080
+#define RDATASET_ATTR_NEGATIVE		0x0100
+#define RDATASET_ATTR_PREFETCH		0x0200
+#define RDATASET_ATTR_ZEROTTL		0x0800
+
+#undef IGNORE			/* WIN32 winbase.h defines this. */
+
+#define EXISTS(header) \
+	(((header)->attributes & RDATASET_ATTR_NONEXISTENT) == 0)
+#define NONEXISTENT(header) \
+	(((header)->attributes & RDATASET_ATTR_NONEXISTENT) != 0)
+#define IGNORE(header) \
+	(((header)->attributes & RDATASET_ATTR_IGNORE) != 0)
+#define RETAIN(header) \
+	(((header)->attributes & RDATASET_ATTR_RETAIN) != 0)
+#define NXDOMAIN(header) \
+	(((header)->attributes & RDATASET_ATTR_NXDOMAIN) != 0)
+#define STALE(header) \
+	(((header)->attributes & RDATASET_ATTR_STALE) != 0)
+#define OPTOUT(header) \
+	(((header)->attributes & RDATASET_ATTR_OPTOUT) != 0)
+#define NEGATIVE(header) \
+	(((header)->attributes & RDATASET_ATTR_NEGATIVE) != 0)
+#define PREFETCH(header) \
+	(((header)->attributes & RDATASET_ATTR_PREFETCH) != 0)
+#define ZEROTTL(header) \
+	(((header)->attributes & RDATASET_ATTR_ZEROTTL) != 0)
+
+#define ACTIVE(header, now) \
+	(((header)->rdh_ttl > (now)) || \
+	 ((header)->rdh_ttl == (now) && ZEROTTL(header)))
+
+typedef struct qpdb_changed {
+	qpnode_t *			node;
+	isc_boolean_t			dirty;
+	ISC_LINK(struct qpdb_changed)	link;
+} qpdb_changed_t;
+
+typedef ISC_LIST(qpdb_changed_t)	qpdb_changedlist_t;
+
+typedef enum {
+	dns_db_insecure,
+	dns_db_partial,
+	dns_db_secure
+} dns_db_secure_t;
+
+typedef struct dns_qpdb dns_qpdb_t;
+
+typedef struct qpdb_version {
+	/* Not locked */
+	qpdb_serial_t			serial;
+	dns_qpdb_t *			qpdb;
+	/*
+	 * Protected in the refcount routines.
+	 */
+	isc_refcount_t			references;
+	/* Locked by database lock. */
+	isc_boolean_t			writer;
+	isc_boolean_t			commit_ok;
+	qpdb_changedlist_t		changed_list;
+	ISC_LINK(struct qpdb_version)	link;
+	dns_db_secure_t			secure;
+	isc_boolean_t			havensec3;
+	/* NSEC3 parameters */
+	dns_hash_t			hash;
+	isc_uint8_t			flags;
+	isc_uint16_t			iterations;
+	isc_uint8_t			salt_length;
+	unsigned char			salt[DNS_NSEC3_SALTSIZE];
+
+	/*
+	 * records and bytes are covered by the tree lock.
+	 */
+	isc_uint64_t			records;
+	isc_uint64_t			bytes;
+} qpdb_version_t;
+
+typedef ISC_LIST(qpdb_version_t)	qpdb_versionlist_t;
+
+struct dns_qpdb {
+	/* Unlocked. */
+	dns_db_t			common;
+	/* Locks the data in this struct */
+	isc_rwlock_t			lock;
+	/*
+	 * Locks the tries and the nodes in them, with the rdatasets of
+	 * the nodes.
+	 */
+	isc_rwlock_t			tree_lock;
+	/* Locks 'deadnodes' */
+	isc_mutex_t			deadlock;
+	isc_stats_t *			cachestats; /* cache DB only */
+	/*
+	 * Every reference to a node also counts as a reference to the
+	 * database.
+	 */
+	isc_refcount_t			references;
+	/* Locked by lock. */
+	unsigned int			attributes;
+	qpdb_serial_t			current_serial;
+	qpdb_serial_t			least_serial;
+	qpdb_serial_t			next_serial;
+	qpdb_version_t *		current_version;
+	qpdb_version_t *		future_version;
+	qpdb_versionlist_t		open_versions;
+	/* Locked by deadlock. */
+	qpnode_t *			deadnodes;
+	/* Locked by tree_lock. */
+	qpnode_t *			origin_node; /* zone DB only */
+	qpnode_t *			nsec3_origin_node; /* zone DB only */
+	qp_trie_t			tree;
+	qp_trie_t			nsec3;
+};
+
+#define QPDB_ATTR_LOADED		0x01
+#define QPDB_ATTR_LOADING		0x02
+
+#define IS_STUB(qpdb)	(((qpdb)->common.attributes & DNS_DBATTR_STUB)  != 0)
+#define IS_CACHE(qpdb)	(((qpdb)->common.attributes & DNS_DBATTR_CACHE) != 0)
+
+/*%
+ * Search Context
+ */
+typedef struct {
+	dns_qpdb_t *		qpdb;
+	qpdb_version_t *	qpversion;
+	qpdb_serial_t		serial;
+	unsigned int		options;
+	qp_trie_t *		trie;
+	qp_key_t		key;
+	/*%
+	 * The nodes of the names above the one sought, from the top
+	 * down, up to the zone cut if one stopped the search.
+	 */
+	void *			ancestors[128];
+	unsigned int		nancestors;
+	isc_boolean_t		copy_name;
+	isc_boolean_t		wild;
+	qpnode_t *		zonecut;
+	rdatasetheader_t *	zonecut_rdataset;
+	rdatasetheader_t *	zonecut_sigrdataset;
+	dns_fixedname_t		zonecut_name;
+	isc_stdtime_t		now;
+} qpdb_search_t;
+
+/*%
+ * Load Context
+ */
+typedef struct {
+	dns_qpdb_t *		qpdb;
+	isc_stdtime_t		now;
+} qpdb_load_t;
+
+static void rdataset_disassociate(dns_rdataset_t *rdataset);
+static isc_result_t rdataset_first(dns_rdataset_t *rdataset);
+static isc_result_t rdataset_next(dns_rdataset_t *rdataset);
+static void rdataset_current(dns_rdataset_t *rdataset, dns_rdata_t *rdata);
+static void rdataset_clone(dns_rdataset_t *source, dns_rdataset_t *target);
+static unsigned int rdataset_count(dns_rdataset_t *rdataset);
+static isc_result_t rdataset_getnoqname(dns_rdataset_t *rdataset,
+					dns_name_t *name,
+					dns_rdataset_t *neg,
+					dns_rdataset_t *negsig);
+static isc_result_t rdataset_getclosest(dns_rdataset_t *rdataset,
+					dns_name_t *name,
+					dns_rdataset_t *neg,
+					dns_rdataset_t *negsig);
+static void rdataset_settrust(dns_rdataset_t *rdataset, dns_trust_t trust);
+static void rdataset_expire(dns_rdataset_t *rdataset);
+static void rdataset_clearprefetch(dns_rdataset_t *rdataset);
+
+static dns_rdatasetmethods_t rdataset_methods = {
+	rdataset_disassociate,
+	rdataset_first,
+	rdataset_next,
+	rdataset_current,
+	rdataset_clone,
+	rdataset_count,
+	NULL,
+	rdataset_getnoqname,
+	NULL,
+	rdataset_getclosest,
+	rdataset_settrust,
+	rdataset_expire,
+	rdataset_clearprefetch,
+	NULL,
+	NULL,
+	NULL
+};
+
+static dns_rdatasetmethods_t slab_methods = {
+	rdataset_disassociate,
+	rdataset_first,
+	rdataset_next,
+	rdataset_current,
+	rdataset_clone,
+	rdataset_count,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+static void rdatasetiter_destroy(dns_rdatasetiter_t **iteratorp);
+static isc_result_t rdatasetiter_first(dns_rdatasetiter_t *iterator);
+static isc_result_t rdatasetiter_next(dns_rdatasetiter_t *iterator);
+static void rdatasetiter_current(dns_rdatasetiter_t *iterator,
+				 dns_rdataset_t *rdataset);
+
+static dns_rdatasetitermethods_t rdatasetiter_methods = {
+	rdatasetiter_destroy,
+	rdatasetiter_first,
+	rdatasetiter_next,
+	rdatasetiter_current
+};
+
+typedef struct qpdb_rdatasetiter {
+	dns_rdatasetiter_t		common;
+	rdatasetheader_t *		current;
+} qpdb_rdatasetiter_t;
+
+static void		dbiterator_destroy(dns_dbiterator_t **iteratorp);
+static isc_result_t	dbiterator_first(dns_dbiterator_t *iterator);
+static isc_result_t	dbiterator_last(dns_dbiterator_t *iterator);
+static isc_result_t	dbiterator_seek(dns_dbiterator_t *iterator,
+					dns_name_t *name);
+static isc_result_t	dbiterator_prev(dns_dbiterator_t *iterator);
+static isc_result_t	dbiterator_next(dns_dbiterator_t *iterator);
+static isc_result_t	dbiterator_current(dns_dbiterator_t *iterator,
+					   dns_dbnode_t **nodep,
+					   dns_name_t *name);
+static isc_result_t	dbiterator_pause(dns_dbiterator_t *iterator);
+static isc_result_t	dbiterator_origin(dns_dbiterator_t *iterator,
+					  dns_name_t *name);
+
+static dns_dbiteratormethods_t dbiterator_methods = {
+	dbiterator_destroy,
+	dbiterator_first,
+	dbiterator_last,
+	dbiterator_seek,
+	dbiterator_prev,
+	dbiterator_next,
+	dbiterator_current,
+	dbiterator_pause,
+	dbiterator_origin
+};
+
+/*
+ * Unless created with either DNS_DB_NSEC3ONLY or DNS_DB_NONSEC3, these
+ * iterators go from the last name of the main trie to the first of the
+ * NSEC3 trie as if it followed.  An iterator holds no lock between calls,
+ * only a reference to the node it is at, which keeps the node in its
+ * trie; so pausing it is a no-op.
+ */
+typedef struct qpdb_dbiterator {
+	dns_dbiterator_t		common;
+	isc_result_t			result;
+	qpnode_t *			node;
+	isc_boolean_t			nsec3only;
+	isc_boolean_t			nonsec3;
+} qpdb_dbiterator_t;
+
+static void free_qpdb(dns_qpdb_t *qpdb);
+static void detachnode(dns_db_t *db, dns_dbnode_t **targetp);
+static void setnsec3parameters(dns_db_t *db, qpdb_version_t *version);
+
+/*%
+ * Return the name of 'node', which must stay referenced (or the tree
+ * locked) while 'name' is used.
+ */
+static inline void
+nodename(qpnode_t *node, dns_name_t *name) {
+	dns_name_init(name, QPNODE_OFFSETS(node));
+	name->ndata = QPNODE_NAME(node);
+	name->length = node->namelen;
+	name->labels = node->labels;
+	name->attributes |= DNS_NAMEATTR_READONLY | DNS_NAMEATTR_ABSOLUTE;
+}
+
+static void
+qp_leafkey(qp_twig_t *leaf, qp_key_t *key) {
+	qpnode_t *node = leaf->ptr;
+
+	qp_makekey(QPNODE_NAME(node), QPNODE_OFFSETS(node), node->labels,
+		   key);
+}
+
+static unsigned int
+qp_leafkeylen(qp_twig_t *leaf) {
+	qpnode_t *node = leaf->ptr;
+
+	return (node->namelen - 1);
+}
+
+static inline void
+nodekey(qpnode_t *node, qp_key_t *key) {
+	qp_makekey(QPNODE_NAME(node), QPNODE_OFFSETS(node), node->labels,
+		   key);
+}
+
+static inline qp_trie_t *
+nodetrie(dns_qpdb_t *qpdb, qpnode_t *node) {
+	return (node->nsec3 ? &qpdb->nsec3 : &qpdb->tree);
+}
+
+static qpnode_t *
+new_node(dns_qpdb_t *qpdb, const dns_name_t *name, isc_boolean_t nsec3) {
+	qpnode_t *node;
+	unsigned char *offsets;
+	unsigned int i;
+
+	node = isc_mem_get(qpdb->common.mctx,
+			   sizeof(*node) + name->length + name->labels);
+	if (node == NULL)
+		return (NULL);
+	if (isc_refcount_init(&node->references, 0) != ISC_R_SUCCESS) {
+		isc_mem_put(qpdb->common.mctx, node,
+			    sizeof(*node) + name->length + name->labels);
+		return (NULL);
+	}
+	node->wild = 0;
+	node->delegating = 0;
+	node->nsec3 = nsec3 ? 1 : 0;
+	node->dirty = 0;
+	node->namelen = name->length;
+	node->labels = name->labels;
+	node->data = NULL;
+	node->deadnext = NULL;
+	memmove(QPNODE_NAME(node), name->ndata, name->length);
+	offsets = QPNODE_OFFSETS(node);
+	offsets[0] = 0;
+	for (i = 1; i < name->labels; i++)
+		offsets[i] = offsets[i - 1] +
+			     QPNODE_NAME(node)[offsets[i - 1]] + 1;
+
+	return (node);
+}
+
+static void
+free_node(dns_qpdb_t *qpdb, qpnode_t *node) {
+	INSIST(node->data == NULL);
+
+	isc_refcount_destroy(&node->references);
+	isc_mem_put(qpdb->common.mctx, node, QPNODE_SIZE(node));
+}
+
+static inline void
+free_noqname(isc_mem_t *mctx, struct noqname **noqname) {
+
+	if (dns_name_dynamic(&(*noqname)->name))
+		dns_name_free(&(*noqname)->name, mctx);
+	if ((*noqname)->neg != NULL)
+		isc_mem_put(mctx, (*noqname)->neg,
+			    dns_rdataslab_size((*noqname)->neg, 0));
+	if ((*noqname)->negsig != NULL)
+		isc_mem_put(mctx, (*noqname)->negsig,
+			    dns_rdataslab_size((*noqname)->negsig, 0));
+	isc_mem_put(mctx, *noqname, sizeof(**noqname));
+	*noqname = NULL;
+}
+
+static inline rdatasetheader_t *
+new_rdataset(isc_mem_t *mctx) {
+	rdatasetheader_t *h;
+
+	h = isc_mem_get(mctx, sizeof(*h));
+	if (h == NULL)
+		return (NULL);
+	h->noqname = NULL;
+	h->closest = NULL;
+	h->rdh_ttl = 0;
+	return (h);
+}
+
+static inline void
+init_rdataset(rdatasetheader_t *h) {
+	h->noqname = NULL;
+	h->closest = NULL;
+}
+
+static inline void
+free_rdataset(isc_mem_t *mctx, rdatasetheader_t *rdataset) {
+	unsigned int size;
+
+	if (rdataset->noqname != NULL)
+		free_noqname(mctx, &rdataset->noqname);
+	if (rdataset->closest != NULL)
+		free_noqname(mctx, &rdataset->closest);
+
+	if (NONEXISTENT(rdataset))
+		size = sizeof(*rdataset);
+	else
+		size = dns_rdataslab_size((unsigned char *)rdataset,
+					  sizeof(*rdataset));
+	isc_mem_put(mctx, rdataset, size);
+}
+
+/*
+ * 'header' is being kept in place of 'newheader': give it any proofs of
+ * nonexistence that 'newheader' has and it does not.
+ */
+static void
+move_proofs(rdatasetheader_t *header, rdatasetheader_t *newheader) {
+	if (header->noqname == NULL) {
+		header->noqname = newheader->noqname;
+		newheader->noqname = NULL;
+	}
+	if (header->closest == NULL) {
+		header->closest = newheader->closest;
+		newheader->closest = NULL;
+	}
+}
+
+static inline void
+rollback_node(qpnode_t *node, qpdb_serial_t serial) {
+	rdatasetheader_t *header, *dcurrent;
+	isc_boolean_t make_dirty = ISC_FALSE;
+
+	/*
+	 * Caller must hold the tree write lock.
+	 */
+
+	/*
+	 * We set the IGNORE attribute on rdatasets with serial number
+	 * 'serial'.  When the reference count goes to zero, these rdatasets
+	 * will be cleaned up; until that time, they will be ignored.
+	 */
+	for (header = node->data; header != NULL; header = header->next) {
+		if (header->serial == serial) {
+			header->attributes |= RDATASET_ATTR_IGNORE;
+			make_dirty = ISC_TRUE;
+		}
+		for (dcurrent = header->down;
+		     dcurrent != NULL;
+		     dcurrent = dcurrent->down) {
+			if (dcurrent->serial == serial) {
+				dcurrent->attributes |= RDATASET_ATTR_IGNORE;
+				make_dirty = ISC_TRUE;
+			}
+		}
+	}
+	if (make_dirty)
+		node->dirty = 1;
+}
+
+static inline void
+mark_stale_header(rdatasetheader_t *header) {
+	header->attributes |= RDATASET_ATTR_STALE;
+	header->node->dirty = 1;
+}
+
+static inline void
+clean_stale_headers(isc_mem_t *mctx, rdatasetheader_t *top) {
+	rdatasetheader_t *d, *down_next;
+
+	for (d = top->down; d != NULL; d = down_next) {
+		down_next = d->down;
+		free_rdataset(mctx, d);
+	}
+	top->down = NULL;
+}
+
+static inline void
+clean_cache_node(dns_qpdb_t *qpdb, qpnode_t *node) {
+	rdatasetheader_t *current, *top_prev, *top_next;
+	isc_mem_t *mctx = qpdb->common.mctx;
+
+	/*
+	 * Caller must be holding the tree write lock.
+	 */
+
+	top_prev = NULL;
+	for (current = node->data; current != NULL; current = top_next) {
+		top_next = current->next;
+		clean_stale_headers(mctx, current);
+		/*
+		 * If current is nonexistent or stale, we can clean it up.
+		 */
+		if ((current->attributes &
+		     (RDATASET_ATTR_NONEXISTENT|RDATASET_ATTR_STALE)) != 0) {
+			if (top_prev != NULL)
+				top_prev->next = current->next;
+			else
+				node->data = current->next;
+			free_rdataset(mctx, current);
+		} else
+			top_prev = current;
+	}
+	node->dirty = 0;
+}
+
+static inline void
+clean_zone_node(dns_qpdb_t *qpdb, qpnode_t *node, qpdb_serial_t least_serial)
+{
+	rdatasetheader_t *current, *dcurrent, *down_next, *dparent;
+	rdatasetheader_t *top_prev, *top_next;
+	isc_mem_t *mctx = qpdb->common.mctx;
+	isc_boolean_t still_dirty = ISC_FALSE;
+
+	/*
+	 * Caller must be holding the tree write lock.
+	 */
+	REQUIRE(least_serial != 0);
+
+	top_prev = NULL;
+	for (current = node->data; current != NULL; current = top_next) {
+		top_next = current->next;
+
+		/*
+		 * First, we clean up any instances of multiple rdatasets
+		 * with the same serial number, or that have the IGNORE
+		 * attribute.
+		 */
+		dparent = current;
+		for (dcurrent = current->down;
+		     dcurrent != NULL;
+		     dcurrent = down_next) {
+			down_next = dcurrent->down;
+			INSIST(dcurrent->serial <= dparent->serial);
+			if (dcurrent->serial == dparent->serial ||
+			    IGNORE(dcurrent)) {
+				if (down_next != NULL)
+					down_next->next = dparent;
+				dparent->down = down_next;
+				free_rdataset(mctx, dcurrent);
+			} else
+				dparent = dcurrent;
+		}
+
+		/*
+		 * We've now eliminated all IGNORE datasets with the possible
+		 * exception of current, which we now check.
+		 */
+		if (IGNORE(current)) {
+			down_next = current->down;
+			if (down_next == NULL) {
+				if (top_prev != NULL)
+					top_prev->next = current->next;
+				else
+					node->data = current->next;
+				free_rdataset(mctx, current);
+				/*
+				 * current no longer exists, so we can
+				 * just continue with the loop.
+				 */
+				continue;
+			} else {
+				/*
+				 * Pull up current->down, making it the new
+				 * current.
+				 */
+				if (top_prev != NULL)
+					top_prev->next = down_next;
+				else
+					node->data = down_next;
+				down_next->next = top_next;
+				free_rdataset(mctx, current);
+				current = down_next;
+			}
+		}
+
+		/*
+		 * We now try to find the first down node less than the
+		 * least serial.
+		 */
+		dparent = current;
+		for (dcurrent = current->down;
+		     dcurrent != NULL;
+		     dcurrent = down_next) {
+			down_next = dcurrent->down;
+			if (dcurrent->serial < least_serial)
+				break;
+			dparent = dcurrent;
+		}
+
+		/*
+		 * If there is a such an rdataset, delete it and any older
+		 * versions.
+		 */
+		if (dcurrent != NULL) {
+			do {
+				down_next = dcurrent->down;
+				INSIST(dcurrent->serial <= least_serial);
+				free_rdataset(mctx, dcurrent);
+				dcurrent = down_next;
+			} while (dcurrent != NULL);
+			dparent->down = NULL;
+		}
+
+		/*
+		 * Note.  The serial number of 'current' might be less than
+		 * least_serial too, but we cannot delete it because it is
+		 * the most recent version, unless it is a NONEXISTENT
+		 * rdataset.
+		 */
+		if (current->down != NULL) {
+			still_dirty = ISC_TRUE;
+			top_prev = current;
+		} else {
+			/*
+			 * If this is a NONEXISTENT rdataset, we can delete it.
+			 */
+			if (NONEXISTENT(current)) {
+				if (top_prev != NULL)
+					top_prev->next = current->next;
+				else
+					node->data = current->next;
+				free_rdataset(mctx, current);
+			} else
+				top_prev = current;
+		}
+	}
+	if (!still_dirty)
+		node->dirty = 0;
+}
+
+/*%
+ * Whether 'node' stays in its trie even when nothing refers to it and
+ * it has no rdatasets: the origin of a zone in both tries, and the
+ * wildcard names of a zone and the names just above them, which wildcard
+ * matching needs.
+ */
+static inline isc_boolean_t
+keep_node(dns_qpdb_t *qpdb, qpnode_t *node) {
+	unsigned char *ndata = QPNODE_NAME(node);
+
+	if (node->data != NULL || node == qpdb->origin_node ||
+	    node == qpdb->nsec3_origin_node)
+		return (ISC_TRUE);
+	if (IS_CACHE(qpdb))
+		return (ISC_FALSE);
+	return (ISC_TF(node->wild || (ndata[0] == 1 && ndata[1] == '*')));
+}
+
+/*%
+ * Clean up 'node', whose last reference has gone, and remove it from
+ * its trie if there is nothing left to keep it.  The caller must be
+ * holding the tree write lock.
+ */
+static void
+cleanup_node(dns_qpdb_t *qpdb, qpnode_t *node, qpdb_serial_t least_serial) {
+	qp_key_t key;
+	isc_result_t result;
+
+	if (isc_refcount_current(&node->references) != 0)
+		return;
+
+	if (node->dirty) {
+		if (IS_CACHE(qpdb))
+			clean_cache_node(qpdb, node);
+		else {
+			if (least_serial == 0) {
+				/*
+				 * Caller doesn't know the least serial.
+				 * Get it.
+				 */
+				RWLOCK(&qpdb->lock, isc_rwlocktype_read);
+				least_serial = qpdb->least_serial;
+				RWUNLOCK(&qpdb->lock, isc_rwlocktype_read);
+			}
+			clean_zone_node(qpdb, node, least_serial);
+		}
+	}
+
+	if (keep_node(qpdb, node) || node->deadnext != NULL)
+		return;
+
+	nodekey(node, &key);
+	result = qp_delete(qpdb->common.mctx, nodetrie(qpdb, node), &key,
+			   node);
+	if (result != ISC_R_SUCCESS) {
+		/*
+		 * Only possible when out of memory: leave the node where
+		 * it is, it will do no harm.
+		 */
+		isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
+			      DNS_LOGMODULE_CACHE, ISC_LOG_WARNING,
+			      "cleanup_node: %s", isc_result_totext(result));
+		return;
+	}
+	free_node(qpdb, node);
+}
+
+/*%
+ * Clean up the nodes whose last reference went while the tree could only
+ * be read locked.  The caller must be holding the tree write lock.
+ */
+static void
+reclaim_nodes(dns_qpdb_t *qpdb) {
+	qpnode_t *node, *next;
+
+	LOCK(&qpdb->deadlock);
+	node = qpdb->deadnodes;
+	qpdb->deadnodes = NULL;
+	UNLOCK(&qpdb->deadlock);
+
+	while (node != NULL) {
+		next = node->deadnext;
+		if (next == node)
+			next = NULL;
+		node->deadnext = NULL;
+		cleanup_node(qpdb, node, 0);
+		node = next;
+	}
+}
+
+/*%
+ * Add a reference to 'node'.  The caller must be holding the tree lock.
+ */
+static inline void
+new_reference(dns_qpdb_t *qpdb, qpnode_t *node) {
+	isc_refcount_increment0(&node->references, NULL);
+	isc_refcount_increment(&qpdb->references, NULL);
+}
+
+/*%
+ * Release a reference to 'node' while holding the tree write lock.  The
+ * caller must hold a reference to the database too.
+ */
+static inline void
+release_reference(dns_qpdb_t *qpdb, qpnode_t *node,
+		  qpdb_serial_t least_serial)
+{
+	unsigned int refs;
+
+	isc_refcount_decrement(&node->references, &refs);
+	if (refs == 0)
+		cleanup_node(qpdb, node, least_serial);
+	isc_refcount_decrement(&qpdb->references, &refs);
+	INSIST(refs > 0);
+}
+
+/*
+ * DB Routines
+ */
+
+static void
+attach(dns_db_t *source, dns_db_t **targetp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)source;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	isc_refcount_increment(&qpdb->references, NULL);
+
+	*targetp = source;
+}
+
+static void
+update_cachestats(dns_qpdb_t *qpdb, isc_result_t result) {
+	INSIST(IS_CACHE(qpdb));
+
+	if (qpdb->cachestats == NULL)
+		return;
+
+	switch (result) {
+	case ISC_R_SUCCESS:
+	case DNS_R_CNAME:
+	case DNS_R_DNAME:
+	case DNS_R_DELEGATION:
+	case DNS_R_NCACHENXDOMAIN:
+	case DNS_R_NCACHENXRRSET:
+		isc_stats_increment(qpdb->cachestats,
+				    dns_cachestatscounter_hits);
+		break;
+	default:
+		isc_stats_increment(qpdb->cachestats,
+				    dns_cachestatscounter_misses);
+	}
+}
+
+static void
+free_node_action(void *data, void *arg) {
+	dns_qpdb_t *qpdb = arg;
+	qpnode_t *node = data;
+	rdatasetheader_t *current, *next;
+
+	for (current = node->data; current != NULL; current = next) {
+		next = current->next;
+		clean_stale_headers(qpdb->common.mctx, current);
+		free_rdataset(qpdb->common.mctx, current);
+	}
+	node->data = NULL;
+	free_node(qpdb, node);
+}
+
+static void
+free_qpdb(dns_qpdb_t *qpdb) {
+	unsigned int refs;
+	char buf[DNS_NAME_FORMATSIZE];
+
+	REQUIRE(qpdb->current_version != NULL || EMPTY(qpdb->open_versions));
+	REQUIRE(qpdb->future_version == NULL);
+
+	if (isc_log_wouldlog(dns_lctx, ISC_LOG_DEBUG(1))) {
+		if (dns_name_dynamic(&qpdb->common.origin))
+			dns_name_format(&qpdb->common.origin, buf,
+					sizeof(buf));
+		else
+			strlcpy(buf, "<UNKNOWN>", sizeof(buf));
+		isc_log_write(dns_lctx, DNS_LOGCATEGORY_DATABASE,
+			      DNS_LOGMODULE_CACHE, ISC_LOG_DEBUG(1),
+			      "done free_qpdb(%s)", buf);
+	}
+
+	if (qpdb->current_version != NULL) {
+		isc_refcount_decrement(&qpdb->current_version->references,
+				       &refs);
+		INSIST(refs == 0);
+		UNLINK(qpdb->open_versions, qpdb->current_version, link);
+		isc_refcount_destroy(&qpdb->current_version->references);
+		isc_mem_put(qpdb->common.mctx, qpdb->current_version,
+			    sizeof(qpdb_version_t));
+	}
+
+	/*
+	 * Nothing refers to any node any more, so the dead node list can
+	 * just be forgotten.
+	 */
+	qpdb->deadnodes = NULL;
+	qp_destroy(qpdb->common.mctx, &qpdb->tree, free_node_action, qpdb);
+	qp_destroy(qpdb->common.mctx, &qpdb->nsec3, free_node_action, qpdb);
+
+	if (dns_name_dynamic(&qpdb->common.origin))
+		dns_name_free(&qpdb->common.origin, qpdb->common.mctx);
+	if (qpdb->cachestats != NULL)
+		isc_stats_detach(&qpdb->cachestats);
+
+	isc_refcount_destroy(&qpdb->references);
+	DESTROYLOCK(&qpdb->deadlock);
+	isc_rwlock_destroy(&qpdb->tree_lock);
+	isc_rwlock_destroy(&qpdb->lock);
+	qpdb->common.magic = 0;
+	qpdb->common.impmagic = 0;
+	isc_mem_putanddetach(&qpdb->common.mctx, qpdb, sizeof(*qpdb));
+}
+
+static void
+detach(dns_db_t **dbp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)(*dbp);
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	isc_refcount_decrement(&qpdb->references, &refs);
+
+	if (refs == 0)
+		free_qpdb(qpdb);
+
+	*dbp = NULL;
+}
+
+static void
+currentversion(dns_db_t *db, dns_dbversion_t **versionp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpdb_version_t *version;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	RWLOCK(&qpdb->lock, isc_rwlocktype_read);
+	version = qpdb->current_version;
+	isc_refcount_increment(&version->references, &refs);
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_read);
+
+	*versionp = (dns_dbversion_t *)version;
+}
+
+static inline qpdb_version_t *
+allocate_version(isc_mem_t *mctx, qpdb_serial_t serial,
+		 unsigned int references, isc_boolean_t writer)
+{
+	isc_result_t result;
+	qpdb_version_t *version;
+
+	version = isc_mem_get(mctx, sizeof(*version));
+	if (version == NULL)
+		return (NULL);
+	version->serial = serial;
+	result = isc_refcount_init(&version->references, references);
+	if (result != ISC_R_SUCCESS) {
+		isc_mem_put(mctx, version, sizeof(*version));
+		return (NULL);
+	}
+	version->writer = writer;
+	version->commit_ok = ISC_FALSE;
+	ISC_LIST_INIT(version->changed_list);
+	ISC_LINK_INIT(version, link);
+
+	return (version);
+}
+
+static isc_result_t
+newversion(dns_db_t *db, dns_dbversion_t **versionp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpdb_version_t *version, *current;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(versionp != NULL && *versionp == NULL);
+	REQUIRE(qpdb->future_version == NULL);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	RWLOCK(&qpdb->lock, isc_rwlocktype_write);
+	RUNTIME_CHECK(qpdb->next_serial != 0);         /* XXX Error? */
+	version = allocate_version(qpdb->common.mctx, qpdb->next_serial, 1,
+				   ISC_TRUE);
+	if (version != NULL) {
+		current = qpdb->current_version;
+		version->qpdb = qpdb;
+		version->commit_ok = ISC_TRUE;
+		version->secure = current->secure;
+		version->havensec3 = current->havensec3;
+		if (version->havensec3) {
+			version->flags = current->flags;
+			version->iterations = current->iterations;
+			version->hash = current->hash;
+			version->salt_length = current->salt_length;
+			memmove(version->salt, current->salt,
+				version->salt_length);
+		} else {
+			version->flags = 0;
+			version->iterations = 0;
+			version->hash = 0;
+			version->salt_length = 0;
+			memset(version->salt, 0, sizeof(version->salt));
+		}
+		version->records = current->records;
+		version->bytes = current->bytes;
+		qpdb->next_serial++;
+		qpdb->future_version = version;
+	}
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_write);
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (version == NULL)
+		return (ISC_R_NOMEMORY);
+
+	*versionp = version;
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+attachversion(dns_db_t *db, dns_dbversion_t *source,
+	      dns_dbversion_t **targetp)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpdb_version_t *qpversion = source;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion != NULL && qpversion->qpdb == qpdb);
+
+	isc_refcount_increment(&qpversion->references, &refs);
+	INSIST(refs > 1);
+
+	*targetp = qpversion;
+}
+
+static qpdb_changed_t *
+add_changed(dns_qpdb_t *qpdb, qpdb_version_t *version, qpnode_t *node) {
+	qpdb_changed_t *changed;
+
+	/*
+	 * Caller must be holding the tree write lock.
+	 */
+
+	changed = isc_mem_get(qpdb->common.mctx, sizeof(*changed));
+
+	RWLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	REQUIRE(version->writer);
+
+	if (changed != NULL) {
+		new_reference(qpdb, node);
+		changed->node = node;
+		changed->dirty = ISC_FALSE;
+		ISC_LIST_INITANDAPPEND(version->changed_list, changed, link);
+	} else
+		version->commit_ok = ISC_FALSE;
+
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	return (changed);
+}
+
+static inline void
+make_least_version(dns_qpdb_t *qpdb, qpdb_version_t *version,
+		   qpdb_changedlist_t *cleanup_list)
+{
+	/*
+	 * Caller must be holding the database lock.
+	 */
+
+	qpdb->least_serial = version->serial;
+	*cleanup_list = version->changed_list;
+	ISC_LIST_INIT(version->changed_list);
+}
+
+static inline void
+cleanup_nondirty(qpdb_version_t *version, qpdb_changedlist_t *cleanup_list) {
+	qpdb_changed_t *changed, *next_changed;
+
+	/*
+	 * If the changed record is dirty, then
+	 * an update created multiple versions of
+	 * a given rdataset.  We keep this list
+	 * until we're the least open version, at
+	 * which point it's safe to get rid of any
+	 * older versions.
+	 *
+	 * If the changed record isn't dirty, then
+	 * we don't need it anymore since we're
+	 * committing and not rolling back.
+	 *
+	 * The caller must be holding the database lock.
+	 */
+	for (changed = HEAD(version->changed_list);
+	     changed != NULL;
+	     changed = next_changed) {
+		next_changed = NEXT(changed, link);
+		if (!changed->dirty) {
+			UNLINK(version->changed_list,
+			       changed, link);
+			APPEND(*cleanup_list,
+			       changed, link);
+		}
+	}
+}
+
+static void
+iszonesecure(dns_db_t *db, qpdb_version_t *version, dns_dbnode_t *origin) {
+	dns_rdataset_t keyset;
+	dns_rdataset_t nsecset, signsecset;
+	isc_boolean_t haszonekey = ISC_FALSE;
+	isc_boolean_t hasnsec = ISC_FALSE;
+	isc_result_t result;
+
+	dns_rdataset_init(&keyset);
+	result = dns_db_findrdataset(db, origin, version, dns_rdatatype_dnskey,
+				     0, 0, &keyset, NULL);
+	if (result == ISC_R_SUCCESS) {
+		result = dns_rdataset_first(&keyset);
+		while (result == ISC_R_SUCCESS) {
+			dns_rdata_t keyrdata = DNS_RDATA_INIT;
+			dns_rdataset_current(&keyset, &keyrdata);
+			if (dns_zonekey_iszonekey(&keyrdata)) {
+				haszonekey = ISC_TRUE;
+				break;
+			}
+			result = dns_rdataset_next(&keyset);
+		}
+		dns_rdataset_disassociate(&keyset);
+	}
+	if (!haszonekey) {
+		version->secure = dns_db_insecure;
+		version->havensec3 = ISC_FALSE;
+		return;
+	}
+
+	dns_rdataset_init(&nsecset);
+	dns_rdataset_init(&signsecset);
+	result = dns_db_findrdataset(db, origin, version, dns_rdatatype_nsec,
+				     0, 0, &nsecset, &signsecset);
+	if (result == ISC_R_SUCCESS) {
+		if (dns_rdataset_isassociated(&signsecset)) {
+			hasnsec = ISC_TRUE;
+			dns_rdataset_disassociate(&signsecset);
+		}
+		dns_rdataset_disassociate(&nsecset);
+	}
+
+	setnsec3parameters(db, version);
+
+	/*
+	 * Do we have a valid NSEC/NSEC3 chain?
+	 */
+	if (version->havensec3 || hasnsec)
+		version->secure = dns_db_secure;
+	else
+		version->secure = dns_db_insecure;
+}
+
+/*%<
+ * Walk the origin node looking for NSEC3PARAM records.
+ * Cache the nsec3 parameters.
+ */
+static void
+setnsec3parameters(dns_db_t *db, qpdb_version_t *version) {
+	qpnode_t *node;
+	dns_rdata_nsec3param_t nsec3param;
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	isc_region_t region;
+	isc_result_t result;
+	rdatasetheader_t *header, *header_next;
+	unsigned char *raw;             /* RDATASLAB */
+	unsigned int count, length;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	version->havensec3 = ISC_FALSE;
+	node = qpdb->origin_node;
+	for (header = node->data;
+	     header != NULL;
+	     header = header_next) {
+		header_next = header->next;
+		do {
+			if (header->serial <= version->serial &&
+			    !IGNORE(header)) {
+				if (NONEXISTENT(header))
+					header = NULL;
+				break;
+			} else
+				header = header->down;
+		} while (header != NULL);
+
+		if (header != NULL &&
+		    (header->type == dns_rdatatype_nsec3param)) {
+			/*
+			 * Find A NSEC3PARAM with a supported algorithm.
+			 */
+			raw = (unsigned char *)header + sizeof(*header);
+			count = raw[0] * 256 + raw[1]; /* count */
+#if DNS_RDATASET_FIXED
+			raw += count * 4 + 2;
+#else
+			raw += 2;
+#endif
+			while (count-- > 0U) {
+				length = raw[0] * 256 + raw[1];
+#if DNS_RDATASET_FIXED
+				raw += 4;
+#else
+				raw += 2;
+#endif
+				region.base = raw;
+				region.length = length;
+				raw += length;
+				dns_rdata_fromregion(&rdata,
+						     qpdb->common.rdclass,
+						     dns_rdatatype_nsec3param,
+						     &region);
+				result = dns_rdata_tostruct(&rdata,
+							    &nsec3param,
+							    NULL);
+				INSIST(result == ISC_R_SUCCESS);
+				dns_rdata_reset(&rdata);
+
+				if (nsec3param.hash != DNS_NSEC3_UNKNOWNALG &&
+				    !dns_nsec3_supportedhash(nsec3param.hash))
+					continue;
+
+				if (nsec3param.flags != 0)
+					continue;
+
+				memmove(version->salt, nsec3param.salt,
+					nsec3param.salt_length);
+				version->hash = nsec3param.hash;
+				version->salt_length = nsec3param.salt_length;
+				version->iterations = nsec3param.iterations;
+				version->flags = nsec3param.flags;
+				version->havensec3 = ISC_TRUE;
+				/*
+				 * Look for a better algorithm than the
+				 * unknown test algorithm.
+				 */
+				if (nsec3param.hash != DNS_NSEC3_UNKNOWNALG)
+					goto unlock;
+			}
+		}
+	}
+ unlock:
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+}
+
+static void
+closeversion(dns_db_t *db, dns_dbversion_t **versionp, isc_boolean_t commit) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpdb_version_t *version, *cleanup_version, *least_greater;
+	isc_boolean_t rollback = ISC_FALSE;
+	qpdb_changedlist_t cleanup_list;
+	qpdb_changed_t *changed, *next_changed;
+	qpdb_serial_t serial, least_serial;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	version = (qpdb_version_t *)*versionp;
+	INSIST(version->qpdb == qpdb);
+
+	cleanup_version = NULL;
+	ISC_LIST_INIT(cleanup_list);
+
+	isc_refcount_decrement(&version->references, &refs);
+	if (refs > 0) {         /* typical and easy case first */
+		if (commit) {
+			RWLOCK(&qpdb->lock, isc_rwlocktype_read);
+			INSIST(!version->writer);
+			RWUNLOCK(&qpdb->lock, isc_rwlocktype_read);
+		}
+		goto end;
+	}
+
+	/*
+	 * Update the zone's secure status in version before making
+	 * it the current version.
+	 */
+	if (version->writer && commit && !IS_CACHE(qpdb))
+		iszonesecure(db, version, qpdb->origin_node);
+
+	RWLOCK(&qpdb->lock, isc_rwlocktype_write);
+	serial = version->serial;
+	if (version->writer) {
+		if (commit) {
+			unsigned cur_ref;
+			qpdb_version_t *cur_version;
+
+			INSIST(version->commit_ok);
+			INSIST(version == qpdb->future_version);
+			/*
+			 * The current version is going to be replaced.
+			 * Release the (likely last) reference to it from the
+			 * DB itself and unlink it from the open list.
+			 */
+			cur_version = qpdb->current_version;
+			isc_refcount_decrement(&cur_version->references,
+					       &cur_ref);
+			if (cur_ref == 0) {
+				if (cur_version->serial == qpdb->least_serial)
+					INSIST(EMPTY(cur_version->changed_list));
+				UNLINK(qpdb->open_versions,
+				       cur_version, link);
+			}
+			if (EMPTY(qpdb->open_versions)) {
+				/*
+				 * We're going to become the least open
+				 * version.
+				 */
+				make_least_version(qpdb, version,
+						   &cleanup_list);
+			} else {
+				/*
+				 * Some other open version is the
+				 * least version.  We can't cleanup
+				 * records that were changed in this
+				 * version because the older versions
+				 * may still be in use by an open
+				 * version.
+				 *
+				 * We can, however, discard the
+				 * changed records for things that
+				 * we've added that didn't exist in
+				 * prior versions.
+				 */
+				cleanup_nondirty(version, &cleanup_list);
+			}
+			/*
+			 * If the (soon to be former) current version
+			 * isn't being used by anyone, we can clean
+			 * it up.
+			 */
+			if (cur_ref == 0) {
+				cleanup_version = cur_version;
+				APPENDLIST(version->changed_list,
+					   cleanup_version->changed_list,
+					   link);
+			}
+			/*
+			 * Become the current version.
+			 */
+			version->writer = ISC_FALSE;
+			qpdb->current_version = version;
+			qpdb->current_serial = version->serial;
+			qpdb->future_version = NULL;
+
+			/*
+			 * Keep the current version in the open list, and
+			 * gain a reference for the DB itself (see the DB
+			 * creation function below).  This must be the only
+			 * case where we need to increment the counter from
+			 * zero and need to use isc_refcount_increment0().
+			 */
+			isc_refcount_increment0(&version->references,
+						&cur_ref);
+			INSIST(cur_ref == 1);
+			PREPEND(qpdb->open_versions,
+				qpdb->current_version, link);
+		} else {
+			/*
+			 * We're rolling back this transaction.
+			 */
+			cleanup_list = version->changed_list;
+			ISC_LIST_INIT(version->changed_list);
+			rollback = ISC_TRUE;
+			cleanup_version = version;
+			qpdb->future_version = NULL;
+		}
+	} else {
+		if (version != qpdb->current_version) {
+			/*
+			 * There are no external or internal references
+			 * to this version and it can be cleaned up.
+			 */
+			cleanup_version = version;
+
+			/*
+			 * Find the version with the least serial
+			 * number greater than ours.
+			 */
+			least_greater = PREV(version, link);
+			if (least_greater == NULL)
+				least_greater = qpdb->current_version;
+
+			INSIST(version->serial < least_greater->serial);
+			/*
+			 * Is this the least open version?
+			 */
+			if (version->serial == qpdb->least_serial) {
+				/*
+				 * Yes.  Install the new least open
+				 * version.
+				 */
+				make_least_version(qpdb,
+						   least_greater,
+						   &cleanup_list);
+			} else {
+				/*
+				 * Add any unexecuted cleanups to
+				 * those of the least greater version.
+				 */
+				APPENDLIST(least_greater->changed_list,
+					   version->changed_list,
+					   link);
+			}
+		} else if (version->serial == qpdb->least_serial)
+			INSIST(EMPTY(version->changed_list));
+		UNLINK(qpdb->open_versions, version, link);
+	}
+	least_serial = qpdb->least_serial;
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	if (cleanup_version != NULL) {
+		INSIST(EMPTY(cleanup_version->changed_list));
+		isc_refcount_destroy(&cleanup_version->references);
+		isc_mem_put(qpdb->common.mctx, cleanup_version,
+			    sizeof(*cleanup_version));
+	}
+
+	if (!EMPTY(cleanup_list)) {
+		RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+		/*
+		 * This is a good opportunity to purge any dead nodes,
+		 * so use it.
+		 */
+		reclaim_nodes(qpdb);
+		for (changed = HEAD(cleanup_list);
+		     changed != NULL;
+		     changed = next_changed) {
+			next_changed = NEXT(changed, link);
+			if (rollback)
+				rollback_node(changed->node, serial);
+			release_reference(qpdb, changed->node, least_serial);
+			isc_mem_put(qpdb->common.mctx, changed,
+				    sizeof(*changed));
+		}
+		RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+	}
+
+ end:
+	*versionp = NULL;
+}
+
+/*%
+ * Add a node for 'name' to 'trie', or find the one already there (and
+ * return ISC_R_EXISTS).  The caller must be holding the tree write lock.
+ */
+static isc_result_t
+addnode(dns_qpdb_t *qpdb, qp_trie_t *trie, const dns_name_t *name,
+	qpnode_t **nodep)
+{
+	qp_key_t key;
+	qpnode_t *node;
+	isc_result_t result;
+
+	qp_namekey(name, &key);
+	node = qp_lookup(trie, &key, NULL, NULL);
+	if (node != NULL) {
+		*nodep = node;
+		return (ISC_R_EXISTS);
+	}
+
+	node = new_node(qpdb, name, ISC_TF(trie == &qpdb->nsec3));
+	if (node == NULL)
+		return (ISC_R_NOMEMORY);
+	result = qp_insert(qpdb->common.mctx, trie, &key, node);
+	if (result != ISC_R_SUCCESS) {
+		free_node(qpdb, node);
+		return (result);
+	}
+
+	*nodep = node;
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Add the necessary magic for the wildcard name 'name'
+ * to be found in 'qpdb'.
+ *
+ * In order for wildcard matching to work correctly in
+ * zone_find(), we must ensure that a node for the wildcarding
+ * level exists in the database, and has its 'wild' bit set.
+ *
+ * E.g. if the wildcard name is "*.sub.example." then we
+ * must ensure that "sub.example." exists and is marked as
+ * a wildcard level.
+ */
+static isc_result_t
+add_wildcard_magic(dns_qpdb_t *qpdb, dns_name_t *name) {
+	isc_result_t result;
+	dns_name_t foundname;
+	dns_offsets_t offsets;
+	unsigned int n;
+	qpnode_t *node = NULL;
+
+	dns_name_init(&foundname, offsets);
+	n = dns_name_countlabels(name);
+	INSIST(n >= 2);
+	n--;
+	dns_name_getlabelsequence(name, 1, n, &foundname);
+	result = addnode(qpdb, &qpdb->tree, &foundname, &node);
+	if (result != ISC_R_SUCCESS && result != ISC_R_EXISTS)
+		return (result);
+	node->wild = 1;
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+add_empty_wildcards(dns_qpdb_t *qpdb, dns_name_t *name) {
+	isc_result_t result;
+	dns_name_t foundname;
+	dns_offsets_t offsets;
+	unsigned int n, l, i;
+
+	dns_name_init(&foundname, offsets);
+	n = dns_name_countlabels(name);
+	l = dns_name_countlabels(&qpdb->common.origin);
+	i = l + 1;
+	while (i < n) {
+		qpnode_t *node = NULL;     /* dummy */
+		dns_name_getlabelsequence(name, n - i, i, &foundname);
+		if (dns_name_iswildcard(&foundname)) {
+			result = add_wildcard_magic(qpdb, &foundname);
+			if (result != ISC_R_SUCCESS)
+				return (result);
+			result = addnode(qpdb, &qpdb->tree, &foundname,
+					 &node);
+			if (result != ISC_R_SUCCESS && result != ISC_R_EXISTS)
+				return (result);
+		}
+		i++;
+	}
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+findnodeintree(dns_qpdb_t *qpdb, qp_trie_t *trie, dns_name_t *name,
+	       isc_boolean_t create, dns_dbnode_t **nodep)
+{
+	qpnode_t *node = NULL;
+	qp_key_t key;
+	isc_result_t result;
+	isc_rwlocktype_t locktype = isc_rwlocktype_read;
+
+	INSIST(trie == &qpdb->tree || trie == &qpdb->nsec3);
+	REQUIRE(dns_name_isabsolute(name));
+
+	qp_namekey(name, &key);
+	RWLOCK(&qpdb->tree_lock, locktype);
+	node = qp_lookup(trie, &key, NULL, NULL);
+	if (node == NULL) {
+		if (!create) {
+			RWUNLOCK(&qpdb->tree_lock, locktype);
+			return (ISC_R_NOTFOUND);
+		}
+		if (isc_rwlock_tryupgrade(&qpdb->tree_lock) != ISC_R_SUCCESS) {
+			RWUNLOCK(&qpdb->tree_lock, locktype);
+			RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+		}
+		locktype = isc_rwlocktype_write;
+		reclaim_nodes(qpdb);
+		result = addnode(qpdb, trie, name, &node);
+		if (result == ISC_R_SUCCESS) {
+			if (trie == &qpdb->tree && !IS_CACHE(qpdb)) {
+				add_empty_wildcards(qpdb, name);
+
+				if (dns_name_iswildcard(name)) {
+					result = add_wildcard_magic(qpdb, name);
+					if (result != ISC_R_SUCCESS) {
+						RWUNLOCK(&qpdb->tree_lock,
+							 locktype);
+						return (result);
+					}
+				}
+			}
+		} else if (result != ISC_R_EXISTS) {
+			RWUNLOCK(&qpdb->tree_lock, locktype);
+			return (result);
+		}
+	}
+
+	new_reference(qpdb, node);
+
+	RWUNLOCK(&qpdb->tree_lock, locktype);
+
+	*nodep = (dns_dbnode_t *)node;
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+findnode(dns_db_t *db, dns_name_t *name, isc_boolean_t create,
+	 dns_dbnode_t **nodep)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	return (findnodeintree(qpdb, &qpdb->tree, name, create, nodep));
+}
+
+static isc_result_t
+findnsec3node(dns_db_t *db, dns_name_t *name, isc_boolean_t create,
+	      dns_dbnode_t **nodep)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	return (findnodeintree(qpdb, &qpdb->nsec3, name, create, nodep));
+}
+
+static void
+attachnode(dns_db_t *db, dns_dbnode_t *source, dns_dbnode_t **targetp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *node = (qpnode_t *)source;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(targetp != NULL && *targetp == NULL);
+
+	isc_refcount_increment(&node->references, &refs);
+	INSIST(refs > 1);
+	isc_refcount_increment(&qpdb->references, NULL);
+
+	*targetp = source;
+}
+
+static void
+detachnode(dns_db_t *db, dns_dbnode_t **targetp) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *node;
+	isc_rwlocktype_t locktype = isc_rwlocktype_read;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(targetp != NULL && *targetp != NULL);
+
+	node = (qpnode_t *)(*targetp);
+
+	RWLOCK(&qpdb->tree_lock, locktype);
+	isc_refcount_decrement(&node->references, &refs);
+	if (refs == 0 && (node->dirty || !keep_node(qpdb, node))) {
+		/*
+		 * The node needs cleaning up or removing, which takes the
+		 * tree write lock.  If that can't be had right now, leave
+		 * the node for whoever next holds it.
+		 */
+		if (isc_rwlock_tryupgrade(&qpdb->tree_lock) == ISC_R_SUCCESS) {
+			locktype = isc_rwlocktype_write;
+			reclaim_nodes(qpdb);
+			cleanup_node(qpdb, node, 0);
+		} else {
+			LOCK(&qpdb->deadlock);
+			if (node->deadnext == NULL) {
+				node->deadnext = (qpdb->deadnodes != NULL) ?
+						 qpdb->deadnodes : node;
+				qpdb->deadnodes = node;
+			}
+			UNLOCK(&qpdb->deadlock);
+		}
+	}
+	RWUNLOCK(&qpdb->tree_lock, locktype);
+
+	*targetp = NULL;
+
+	isc_refcount_decrement(&qpdb->references, &refs);
+	if (refs == 0)
+		free_qpdb(qpdb);
+}
+
+static isc_result_t
+expirenode(dns_db_t *db, dns_dbnode_t *node, isc_stdtime_t now) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = node;
+	rdatasetheader_t *header;
+	isc_boolean_t force_expire = ISC_FALSE;
+	/*
+	 * These are the category and module used by the cache cleaner.
+	 */
+	isc_boolean_t log = ISC_FALSE;
+	isc_logcategory_t *category = DNS_LOGCATEGORY_DATABASE;
+	isc_logmodule_t *module = DNS_LOGMODULE_CACHE;
+	int level = ISC_LOG_DEBUG(2);
+	char printname[DNS_NAME_FORMATSIZE];
+	dns_name_t name;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	if (now == 0)
+		isc_stdtime_get(&now);
+
+	if (isc_mem_isovermem(qpdb->common.mctx)) {
+		isc_uint32_t val;
+
+		isc_random_get(&val);
+		/*
+		 * XXXDCL Could stand to have a better policy, like LRU.
+		 */
+		force_expire = ISC_TF(val % 4 == 0);
+
+		/*
+		 * Note that 'log' can be true IFF overmem is also true.
+		 * overmem can currently only be true for cache
+		 * databases -- hence all of the "overmem cache" log strings.
+		 */
+		log = ISC_TF(isc_log_wouldlog(dns_lctx, level));
+		if (log) {
+			nodename(qpnode, &name);
+			dns_name_format(&name, printname, sizeof(printname));
+			isc_log_write(dns_lctx, category, module, level,
+				      "overmem cache: %s %s",
+				      force_expire ? "FORCE" : "check",
+				      printname);
+		}
+	}
+
+	/*
+	 * We may not need write access, but this code path is not performance
+	 * sensitive, so it should be okay to always lock as a writer.
+	 */
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	for (header = qpnode->data; header != NULL; header = header->next)
+		if (header->rdh_ttl <= now - QPDB_VIRTUAL) {
+			/*
+			 * The node cannot be freed here, since 'node' is
+			 * an argument to the function and so referenced.
+			 */
+			mark_stale_header(header);
+			if (log)
+				isc_log_write(dns_lctx, category, module,
+					      level, "overmem cache: stale %s",
+					      printname);
+		} else if (force_expire) {
+			if (! RETAIN(header)) {
+				header->rdh_ttl = 0;
+				mark_stale_header(header);
+			} else if (log) {
+				isc_log_write(dns_lctx, category, module,
+					      level, "overmem cache: "
+					      "reprieve by RETAIN() %s",
+					      printname);
+			}
+		} else if (isc_mem_isovermem(qpdb->common.mctx) && log)
+			isc_log_write(dns_lctx, category, module, level,
+				      "overmem cache: saved %s", printname);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+overmem(dns_db_t *db, isc_boolean_t over) {
+	/* This is an empty callback.  See adb.c:water() */
+
+	UNUSED(db);
+	UNUSED(over);
+
+	return;
+}
+
+static void
+printnode(dns_db_t *db, dns_dbnode_t *node, FILE *out) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = node;
+	isc_boolean_t first;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	fprintf(out, "node %p, %u references\n",
+		qpnode, isc_refcount_current(&qpnode->references));
+	if (qpnode->data != NULL) {
+		rdatasetheader_t *current, *top_next;
+
+		for (current = qpnode->data; current != NULL;
+		     current = top_next) {
+			top_next = current->next;
+			first = ISC_TRUE;
+			fprintf(out, "\ttype %u", current->type);
+			do {
+				if (!first)
+					fprintf(out, "\t");
+				first = ISC_FALSE;
+				fprintf(out,
+					"\tserial = %lu, ttl = %u, "
+					"trust = %u, attributes = %u\n",
+					(unsigned long)current->serial,
+					current->rdh_ttl,
+					current->trust,
+					current->attributes);
+				current = current->down;
+			} while (current != NULL);
+		}
+	} else
+		fprintf(out, "(empty)\n");
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+}
+
+/*%
+ * Set up 'search' for a lookup of 'name' in 'trie', and look the name up,
+ * leaving the names above it that are in the trie in search->ancestors.
+ * The caller must be holding the tree lock.
+ */
+static qpnode_t *
+search_lookup(qpdb_search_t *search, qp_trie_t *trie, const dns_name_t *name)
+{
+	search->trie = trie;
+	qp_namekey(name, &search->key);
+	return (qp_lookup(trie, &search->key, search->ancestors,
+			  &search->nancestors));
+}
+
+#define ANCESTOR(search, i)	((qpnode_t *)(search)->ancestors[i])
+
+/*%
+ * Whether 'node' has any rdataset in the version of 'search'.
+ */
+static inline isc_boolean_t
+activenode(qpdb_search_t *search, qpnode_t *node) {
+	rdatasetheader_t *header;
+
+	for (header = node->data; header != NULL; header = header->next)
+		if (header->serial <= search->serial &&
+		    !IGNORE(header) && EXISTS(header))
+			return (ISC_TRUE);
+	return (ISC_FALSE);
+}
+
+/*%
+ * The first node after 'key' (or before it if 'forward' is false)
+ * in the trie of 'search' that is active in its version.
+ */
+static qpnode_t *
+activeneighbor(qpdb_search_t *search, const qp_key_t *key,
+	       isc_boolean_t forward, isc_boolean_t inclusive)
+{
+	qpnode_t *node;
+	qp_key_t nkey;
+
+	node = qp_neighbor(search->trie, key, forward, inclusive);
+	while (node != NULL && !activenode(search, node)) {
+		nodekey(node, &nkey);
+		node = qp_neighbor(search->trie, &nkey, forward, ISC_FALSE);
+	}
+	return (node);
+}
+
+static isc_result_t
+zone_zonecut_callback(qpnode_t *node, qpdb_search_t *search) {
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *dname_header, *sigdname_header, *ns_header;
+	rdatasetheader_t *found;
+	isc_result_t result;
+	qpnode_t *onode;
+
+	/*
+	 * We only want to remember the topmost zone cut, since it's the one
+	 * that counts, so we'll just continue if we've already found a
+	 * zonecut.
+	 */
+	if (search->zonecut != NULL)
+		return (DNS_R_CONTINUE);
+
+	found = NULL;
+	result = DNS_R_CONTINUE;
+	onode = search->qpdb->origin_node;
+
+	/*
+	 * Look for an NS or DNAME rdataset active in our version.
+	 */
+	ns_header = NULL;
+	dname_header = NULL;
+	sigdname_header = NULL;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (header->type == dns_rdatatype_ns ||
+		    header->type == dns_rdatatype_dname ||
+		    header->type == QPDB_RDATATYPE_SIGDNAME) {
+			do {
+				if (header->serial <= search->serial &&
+				    !IGNORE(header)) {
+					/*
+					 * Is this a "this rdataset doesn't
+					 * exist" record?
+					 */
+					if (NONEXISTENT(header))
+						header = NULL;
+					break;
+				} else
+					header = header->down;
+			} while (header != NULL);
+			if (header != NULL) {
+				if (header->type == dns_rdatatype_dname)
+					dname_header = header;
+				else if (header->type ==
+					   QPDB_RDATATYPE_SIGDNAME)
+					sigdname_header = header;
+				else if (node != onode ||
+					 IS_STUB(search->qpdb)) {
+					/*
+					 * We've found an NS rdataset that
+					 * isn't at the origin node.  We check
+					 * that they're not at the origin node,
+					 * because otherwise we'd erroneously
+					 * treat the zone top as if it were
+					 * a delegation.
+					 */
+					ns_header = header;
+				}
+			}
+		}
+	}
+
+	/*
+	 * Did we find anything?
+	 */
+	if (!IS_CACHE(search->qpdb) && !IS_STUB(search->qpdb) &&
+	    ns_header != NULL) {
+		/*
+		 * Note that NS has precedence over DNAME if both exist
+		 * in a zone.  Otherwise DNAME take precedence over NS.
+		 */
+		found = ns_header;
+		search->zonecut_sigrdataset = NULL;
+	} else if (dname_header != NULL) {
+		found = dname_header;
+		search->zonecut_sigrdataset = sigdname_header;
+	} else if (ns_header != NULL) {
+		found = ns_header;
+		search->zonecut_sigrdataset = NULL;
+	}
+
+	if (found != NULL) {
+		/*
+		 * The tree lock is held for the whole search, so the
+		 * zone cut needs no reference of its own.
+		 */
+		search->zonecut = node;
+		search->zonecut_rdataset = found;
+		/*
+		 * Since we've found a zonecut, anything beneath it is
+		 * glue and is not subject to wildcard matching, so we
+		 * may clear search->wild.
+		 */
+		search->wild = ISC_FALSE;
+		if ((search->options & DNS_DBFIND_GLUEOK) == 0) {
+			/*
+			 * If the caller does not want to find glue, then
+			 * this is the best answer and the search should
+			 * stop now.
+			 */
+			result = DNS_R_PARTIALMATCH;
+		} else {
+			dns_name_t name, *zcname;
+
+			/*
+			 * The search will continue beneath the zone cut.
+			 * This may or may not be the best match.  In case it
+			 * is, we need to remember the node name.
+			 */
+			nodename(node, &name);
+			zcname = dns_fixedname_name(&search->zonecut_name);
+			RUNTIME_CHECK(dns_name_copy(&name, zcname, NULL) ==
+				      ISC_R_SUCCESS);
+			search->copy_name = ISC_TRUE;
+		}
+	} else {
+		/*
+		 * There is no zonecut at this node which is active in this
+		 * version.
+		 *
+		 * If this is a "wild" node and the caller hasn't disabled
+		 * wildcard matching, remember that we've seen a wild node
+		 * in case we need to go searching for wildcard matches
+		 * later on.
+		 */
+		if (node->wild && (search->options & DNS_DBFIND_NOWILD) == 0)
+			search->wild = ISC_TRUE;
+	}
+
+	return (result);
+}
+
+static inline void
+bind_rdataset(dns_qpdb_t *qpdb, qpnode_t *node, rdatasetheader_t *header,
+	      isc_stdtime_t now, dns_rdataset_t *rdataset)
+{
+	unsigned char *raw;     /* RDATASLAB */
+
+	/*
+	 * Caller must be holding the tree lock.
+	 * Technically, we need a writer lock, since we'll increment the
+	 * header count below.  However, since the actual counter value
+	 * doesn't matter, we prioritize performance here.
+	 */
+
+	if (rdataset == NULL)
+		return;
+
+	new_reference(qpdb, node);
+
+	INSIST(rdataset->methods == NULL);      /* We must be disassociated. */
+
+	rdataset->methods = &rdataset_methods;
+	rdataset->rdclass = qpdb->common.rdclass;
+	rdataset->type = QPDB_RDATATYPE_BASE(header->type);
+	rdataset->covers = QPDB_RDATATYPE_EXT(header->type);
+	rdataset->trust = header->trust;
+	rdataset->ttl = header->rdh_ttl - now;
+	if (NEGATIVE(header))
+		rdataset->attributes |= DNS_RDATASETATTR_NEGATIVE;
+	if (NXDOMAIN(header))
+		rdataset->attributes |= DNS_RDATASETATTR_NXDOMAIN;
+	if (OPTOUT(header))
+		rdataset->attributes |= DNS_RDATASETATTR_OPTOUT;
+	if (PREFETCH(header))
+		rdataset->attributes |= DNS_RDATASETATTR_PREFETCH;
+	rdataset->private1 = qpdb;
+	rdataset->private2 = node;
+	raw = (unsigned char *)header + sizeof(*header);
+	rdataset->private3 = raw;
+	rdataset->count = header->count++;
+	if (rdataset->count == ISC_UINT32_MAX)
+		rdataset->count = 0;
+
+	/*
+	 * Reset iterator state.
+	 */
+	rdataset->privateuint4 = 0;
+	rdataset->private5 = NULL;
+
+	/*
+	 * Add noqname proof.
+	 */
+	rdataset->private6 = header->noqname;
+	if (rdataset->private6 != NULL)
+		rdataset->attributes |=  DNS_RDATASETATTR_NOQNAME;
+	rdataset->private7 = header->closest;
+	if (rdataset->private7 != NULL)
+		rdataset->attributes |=  DNS_RDATASETATTR_CLOSEST;
+
+	rdataset->resign = 0;
+}
+
+static inline isc_result_t
+setup_delegation(qpdb_search_t *search, dns_dbnode_t **nodep,
+		 dns_name_t *foundname, dns_rdataset_t *rdataset,
+		 dns_rdataset_t *sigrdataset)
+{
+	isc_result_t result;
+	dns_name_t *zcname;
+	qpdb_rdatatype_t type;
+	qpnode_t *node;
+
+	/*
+	 * The caller must be holding the tree lock.
+	 */
+
+	node = search->zonecut;
+	type = search->zonecut_rdataset->type;
+
+	/*
+	 * If we have to set foundname, we do it before anything else.
+	 * If we were to set foundname after we had set nodep or bound the
+	 * rdataset, then we'd have to undo that work if dns_name_copy()
+	 * failed.  By setting foundname first, there's nothing to undo if
+	 * we have trouble.
+	 */
+	if (foundname != NULL && search->copy_name) {
+		zcname = dns_fixedname_name(&search->zonecut_name);
+		result = dns_name_copy(zcname, foundname, NULL);
+		if (result != ISC_R_SUCCESS)
+			return (result);
+	}
+	if (nodep != NULL) {
+		new_reference(search->qpdb, node);
+		*nodep = node;
+	}
+	if (rdataset != NULL) {
+		bind_rdataset(search->qpdb, node, search->zonecut_rdataset,
+			      search->now, rdataset);
+		if (sigrdataset != NULL && search->zonecut_sigrdataset != NULL)
+			bind_rdataset(search->qpdb, node,
+				      search->zonecut_sigrdataset,
+				      search->now, sigrdataset);
+	}
+
+	if (type == dns_rdatatype_dname)
+		return (DNS_R_DNAME);
+	return (DNS_R_DELEGATION);
+}
+
+static inline isc_boolean_t
+valid_glue(qpdb_search_t *search, dns_name_t *name, qpdb_rdatatype_t type,
+	   qpnode_t *node)
+{
+	unsigned char *raw;     /* RDATASLAB */
+	unsigned int count, size;
+	dns_name_t ns_name;
+	isc_boolean_t valid = ISC_FALSE;
+	dns_offsets_t offsets;
+	isc_region_t region;
+	rdatasetheader_t *header;
+
+	/*
+	 * No additional locking is required.
+	 */
+
+	/*
+	 * Valid glue types are A, AAAA, A6.  NS is also a valid glue type
+	 * if it occurs at a zone cut, but is not valid below it.
+	 */
+	if (type == dns_rdatatype_ns) {
+		if (node != search->zonecut) {
+			return (ISC_FALSE);
+		}
+	} else if (type != dns_rdatatype_a &&
+		   type != dns_rdatatype_aaaa &&
+		   type != dns_rdatatype_a6) {
+		return (ISC_FALSE);
+	}
+
+	header = search->zonecut_rdataset;
+	raw = (unsigned char *)header + sizeof(*header);
+	count = raw[0] * 256 + raw[1];
+#if DNS_RDATASET_FIXED
+	raw += 2 + (4 * count);
+#else
+	raw += 2;
+#endif
+
+	while (count > 0) {
+		count--;
+		size = raw[0] * 256 + raw[1];
+#if DNS_RDATASET_FIXED
+		raw += 4;
+#else
+		raw += 2;
+#endif
+		region.base = raw;
+		region.length = size;
+		raw += size;
+		/*
+		 * XXX Until we have rdata structures, we have no choice but
+		 * to directly access the rdata format.
+		 */
+		dns_name_init(&ns_name, offsets);
+		dns_name_fromregion(&ns_name, &region);
+		if (dns_name_compare(&ns_name, name) == 0) {
+			valid = ISC_TRUE;
+			break;
+		}
+	}
+
+	return (valid);
+}
+
+/*%
+ * Whether the first name after 'name', whose key is 'key', that is
+ * active in the version of 'search' is below 'name'.
+ */
+static inline isc_boolean_t
+activeempty(qpdb_search_t *search, const qp_key_t *key, dns_name_t *name) {
+	qpnode_t *next;
+	dns_name_t nextname;
+
+	next = activeneighbor(search, key, ISC_TRUE, ISC_FALSE);
+	if (next == NULL)
+		return (ISC_FALSE);
+	nodename(next, &nextname);
+	return (dns_name_issubdomain(&nextname, name));
+}
+
+/*%
+ * Whether 'qname', which is not in the trie, is at or below an empty
+ * non-terminal that is below the wildcard 'wname' would match at.
+ */
+static inline isc_boolean_t
+activeemtpynode(qpdb_search_t *search, dns_name_t *qname, dns_name_t *wname) {
+	qpnode_t *node;
+	dns_name_t next;
+	dns_name_t prev;
+	dns_name_t rname;
+	dns_name_t tname;
+	isc_boolean_t check_next = ISC_TRUE;
+	isc_boolean_t check_prev = ISC_TRUE;
+	isc_boolean_t answer = ISC_FALSE;
+	unsigned int n;
+
+	dns_name_init(&tname, NULL);
+	dns_name_init(&rname, NULL);
+
+	/*
+	 * Find if qname is at or below a empty node.
+	 */
+	node = activeneighbor(search, &search->key, ISC_FALSE, ISC_TRUE);
+	if (node != NULL)
+		nodename(node, &prev);
+	else
+		check_prev = ISC_FALSE;
+
+	node = activeneighbor(search, &search->key, ISC_TRUE, ISC_FALSE);
+	if (node != NULL)
+		nodename(node, &next);
+	else
+		check_next = ISC_FALSE;
+
+	dns_name_clone(qname, &rname);
+
+	/*
+	 * Remove the wildcard label to find the terminal name.
+	 */
+	n = dns_name_countlabels(wname);
+	dns_name_getlabelsequence(wname, 1, n - 1, &tname);
+
+	do {
+		if ((check_prev && dns_name_issubdomain(&prev, &rname)) ||
+		    (check_next && dns_name_issubdomain(&next, &rname))) {
+			answer = ISC_TRUE;
+			break;
+		}
+		/*
+		 * Remove the left hand label.
+		 */
+		n = dns_name_countlabels(&rname);
+		dns_name_getlabelsequence(&rname, 1, n - 1, &rname);
+	} while (!dns_name_equal(&rname, &tname));
+	return (answer);
+}
+
+static inline isc_result_t
+find_wildcard(qpdb_search_t *search, qpnode_t **nodep, dns_name_t *qname) {
+	unsigned int i;
+	qpnode_t *node, *wnode;
+	isc_result_t result = ISC_R_NOTFOUND;
+	dns_name_t name;
+	dns_name_t *wname;
+	dns_fixedname_t fwname;
+	qp_key_t wkey;
+
+	/*
+	 * Caller must be holding the tree lock.  '*nodep' is the node of
+	 * 'qname' if it is in the trie but empty, NULL otherwise.
+	 */
+
+	/*
+	 * Examine each ancestor level.  If the level's wild bit
+	 * is set, then construct the corresponding wildcard name and
+	 * search for it.  If the wildcard node exists, and is active in
+	 * this version, we're done.  If not, then we next check to see
+	 * if the ancestor is active in this version.  If so, then there
+	 * can be no possible wildcard match and again we're done.  If not,
+	 * continue the search.
+	 */
+
+	i = search->nancestors;
+	node = *nodep;
+	if (node == NULL) {
+		if (i == 0)
+			return (ISC_R_NOTFOUND);
+		node = ANCESTOR(search, --i);
+	}
+	for (;;) {
+		if (node->wild) {
+			/*
+			 * Construct the wildcard name for this level.
+			 */
+			nodename(node, &name);
+			dns_fixedname_init(&fwname);
+			wname = dns_fixedname_name(&fwname);
+			result = dns_name_concatenate(dns_wildcardname, &name,
+						      wname, NULL);
+			if (result != ISC_R_SUCCESS)
+				break;
+
+			qp_namekey(wname, &wkey);
+			wnode = qp_lookup(&search->qpdb->tree, &wkey,
+					  NULL, NULL);
+			if (wnode != NULL &&
+			    (activenode(search, wnode) ||
+			     activeempty(search, &wkey, wname)))
+			{
+				/*
+				 * We have found the wildcard node, and it
+				 * is active in the search's version.
+				 */
+				if (activeemtpynode(search, qname, wname))
+					return (ISC_R_NOTFOUND);
+				*nodep = wnode;
+				return (ISC_R_SUCCESS);
+			}
+			result = ISC_R_NOTFOUND;
+		}
+
+		if (activenode(search, node)) {
+			/*
+			 * The level node is active.  Any wildcarding
+			 * present at higher levels has no
+			 * effect and we're done.
+			 */
+			break;
+		}
+
+		if (i == 0)
+			break;
+		node = ANCESTOR(search, --i);
+	}
+
+	return (result);
+}
+
+static isc_boolean_t
+matchparams(rdatasetheader_t *header, qpdb_search_t *search)
+{
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdata_nsec3_t nsec3;
+	unsigned char *raw;                     /* RDATASLAB */
+	unsigned int rdlen, count;
+	isc_region_t region;
+	isc_result_t result;
+
+	REQUIRE(header->type == dns_rdatatype_nsec3);
+
+	raw = (unsigned char *)header + sizeof(*header);
+	count = raw[0] * 256 + raw[1]; /* count */
+#if DNS_RDATASET_FIXED
+	raw += count * 4 + 2;
+#else
+	raw += 2;
+#endif
+	while (count-- > 0) {
+		rdlen = raw[0] * 256 + raw[1];
+#if DNS_RDATASET_FIXED
+		raw += 4;
+#else
+		raw += 2;
+#endif
+		region.base = raw;
+		region.length = rdlen;
+		dns_rdata_fromregion(&rdata, search->qpdb->common.rdclass,
+				     dns_rdatatype_nsec3, &region);
+		raw += rdlen;
+		result = dns_rdata_tostruct(&rdata, &nsec3, NULL);
+		INSIST(result == ISC_R_SUCCESS);
+		if (nsec3.hash == search->qpversion->hash &&
+		    nsec3.iterations == search->qpversion->iterations &&
+		    nsec3.salt_length == search->qpversion->salt_length &&
+		    memcmp(nsec3.salt, search->qpversion->salt,
+			   nsec3.salt_length) == 0)
+			return (ISC_TRUE);
+		dns_rdata_reset(&rdata);
+	}
+	return (ISC_FALSE);
+}
+
+/*
+ * Find the NSEC or NSEC3 record that covers the name sought by 'search':
+ * walk back from the name itself, if it is there, or from the name before
+ * it, to the first node with the record.  Since the keys of the trie are
+ * in canonical order this needs no auxiliary NSEC tree.
+ */
+static inline isc_result_t
+find_closest_nsec(qpdb_search_t *search, dns_dbnode_t **nodep,
+		  dns_name_t *foundname, dns_rdataset_t *rdataset,
+		  dns_rdataset_t *sigrdataset, qp_trie_t *trie,
+		  dns_db_secure_t secure)
+{
+	qpnode_t *node;
+	rdatasetheader_t *header, *header_next, *found, *foundsig;
+	isc_boolean_t empty_node;
+	isc_result_t result;
+	dns_name_t name;
+	dns_rdatatype_t type;
+	qpdb_rdatatype_t sigtype;
+	isc_boolean_t wraps;
+	isc_boolean_t need_sig = ISC_TF(secure == dns_db_secure);
+	qp_key_t key;
+
+	if (trie == &search->qpdb->nsec3) {
+		type = dns_rdatatype_nsec3;
+		sigtype = QPDB_RDATATYPE_SIGNSEC3;
+		wraps = ISC_TRUE;
+	} else {
+		type = dns_rdatatype_nsec;
+		sigtype = QPDB_RDATATYPE_SIGNSEC;
+		wraps = ISC_FALSE;
+	}
+
+	node = qp_neighbor(trie, &search->key, ISC_FALSE, ISC_TRUE);
+ again:
+	result = ISC_R_NOMORE;
+	while (node != NULL) {
+		found = NULL;
+		foundsig = NULL;
+		empty_node = ISC_TRUE;
+		for (header = node->data;
+		     header != NULL;
+		     header = header_next) {
+			header_next = header->next;
+			/*
+			 * Look for an active, extant NSEC or RRSIG NSEC.
+			 */
+			do {
+				if (header->serial <= search->serial &&
+				    !IGNORE(header)) {
+					/*
+					 * Is this a "this rdataset doesn't
+					 * exist" record?
+					 */
+					if (NONEXISTENT(header))
+						header = NULL;
+					break;
+				} else
+					header = header->down;
+			} while (header != NULL);
+			if (header != NULL) {
+				/*
+				 * We now know that there is at least one
+				 * active rdataset at this node.
+				 */
+				empty_node = ISC_FALSE;
+				if (header->type == type) {
+					found = header;
+					if (foundsig != NULL)
+						break;
+				} else if (header->type == sigtype) {
+					foundsig = header;
+					if (found != NULL)
+						break;
+				}
+			}
+		}
+		if (!empty_node) {
+			if (found != NULL && search->qpversion->havensec3 &&
+			    found->type == dns_rdatatype_nsec3 &&
+			    !matchparams(found, search)) {
+				/*
+				 * Not from the chain in use: keep looking.
+				 */
+				empty_node = ISC_TRUE;
+			} else if (found != NULL &&
+				   (foundsig != NULL || !need_sig)) {
+				/*
+				 * We've found the right NSEC/NSEC3 record.
+				 *
+				 * Note: for this to really be the right
+				 * NSEC record, it's essential that the NSEC
+				 * records of any nodes obscured by a zone
+				 * cut have been removed; we assume this is
+				 * the case.
+				 */
+				nodename(node, &name);
+				result = dns_name_copy(&name, foundname, NULL);
+				if (result == ISC_R_SUCCESS) {
+					if (nodep != NULL) {
+						new_reference(search->qpdb,
+							      node);
+						*nodep = node;
+					}
+					bind_rdataset(search->qpdb, node,
+						      found, search->now,
+						      rdataset);
+					if (foundsig != NULL)
+						bind_rdataset(search->qpdb,
+							      node,
+							      foundsig,
+							      search->now,
+							      sigrdataset);
+				}
+				break;
+			} else if (found == NULL && foundsig == NULL) {
+				/*
+				 * This node is active, but has no NSEC or
+				 * RRSIG NSEC.  That means it's glue or
+				 * other obscured zone data that isn't
+				 * relevant for our search.  Treat the
+				 * node as if it were empty and keep looking.
+				 */
+				empty_node = ISC_TRUE;
+			} else {
+				/*
+				 * We found an active node, but either the
+				 * NSEC or the RRSIG NSEC is missing.  This
+				 * shouldn't happen.
+				 */
+				result = DNS_R_BADDB;
+				break;
+			}
+		}
+		INSIST(empty_node);
+		nodekey(node, &key);
+		node = qp_neighbor(trie, &key, ISC_FALSE, ISC_FALSE);
+	}
+
+	if (result == ISC_R_NOMORE && wraps) {
+		node = qp_last(trie);
+		wraps = ISC_FALSE;
+		goto again;
+	}
+
+	/*
+	 * If the result is ISC_R_NOMORE, then we got to the beginning of
+	 * the database and didn't find a NSEC record.  This shouldn't
+	 * happen.
+	 */
+	if (result == ISC_R_NOMORE)
+		result = DNS_R_BADDB;
+
+	return (result);
+}
+
+static isc_result_t
+zone_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
+	  dns_rdatatype_t type, unsigned int options, isc_stdtime_t now,
+	  dns_dbnode_t **nodep, dns_name_t *foundname,
+	  dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	qpnode_t *node = NULL;
+	isc_result_t result;
+	qpdb_search_t search;
+	isc_boolean_t cname_ok = ISC_TRUE;
+	isc_boolean_t close_version = ISC_FALSE;
+	isc_boolean_t maybe_zonecut = ISC_FALSE;
+	isc_boolean_t wild;
+	isc_boolean_t empty_node;
+	rdatasetheader_t *header, *header_next, *found, *nsecheader;
+	rdatasetheader_t *foundsig, *cnamesig, *nsecsig;
+	qpdb_rdatatype_t sigtype;
+	isc_boolean_t active;
+	qp_trie_t *trie;
+	qpnode_t *ancestor;
+	dns_name_t nname;
+	unsigned int i;
+
+	search.qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(search.qpdb));
+	INSIST(version == NULL ||
+	       ((qpdb_version_t *)version)->qpdb == (dns_qpdb_t *)db);
+
+	/*
+	 * We don't care about 'now'.
+	 */
+	UNUSED(now);
+
+	/*
+	 * If the caller didn't supply a version, attach to the current
+	 * version.
+	 */
+	if (version == NULL) {
+		currentversion(db, &version);
+		close_version = ISC_TRUE;
+	}
+
+	search.qpversion = version;
+	search.serial = search.qpversion->serial;
+	search.options = options;
+	search.copy_name = ISC_FALSE;
+	search.wild = ISC_FALSE;
+	search.zonecut = NULL;
+	dns_fixedname_init(&search.zonecut_name);
+	search.now = 0;
+
+	/*
+	 * 'wild' will be true iff. we've matched a wildcard.
+	 */
+	wild = ISC_FALSE;
+
+	RWLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	/*
+	 * Look the name up, then go down through the names above it that
+	 * are in the trie, letting zone_zonecut_callback() search the
+	 * rdatasets at the possible zone cuts for active DNAME or NS
+	 * rdatasets.
+	 */
+	trie = (options & DNS_DBFIND_FORCENSEC3) != 0 ? &search.qpdb->nsec3 :
+							&search.qpdb->tree;
+	node = search_lookup(&search, trie, name);
+	for (i = 0; i < search.nancestors; i++) {
+		ancestor = ANCESTOR(&search, i);
+		if ((ancestor->delegating || ancestor->wild) &&
+		    zone_zonecut_callback(ancestor, &search) ==
+		    DNS_R_PARTIALMATCH)
+		{
+			search.nancestors = i + 1;
+			node = NULL;
+			break;
+		}
+	}
+
+	if (node == NULL) {
+		if (search.nancestors == 0) {
+			result = ISC_R_NOTFOUND;
+			goto tree_exit;
+		}
+		nodename(ANCESTOR(&search, search.nancestors - 1), &nname);
+		result = dns_name_copy(&nname, foundname, NULL);
+		if (result != ISC_R_SUCCESS)
+			goto tree_exit;
+	partial_match:
+		if (search.zonecut != NULL) {
+		    result = setup_delegation(&search, nodep, foundname,
+					      rdataset, sigrdataset);
+		    goto tree_exit;
+		}
+
+		if (search.wild) {
+			/*
+			 * At least one of the levels in the search chain
+			 * potentially has a wildcard.  For each such level,
+			 * we must see if there's a matching wildcard active
+			 * in the current version.
+			 */
+			result = find_wildcard(&search, &node, name);
+			if (result == ISC_R_SUCCESS) {
+				result = dns_name_copy(name, foundname, NULL);
+				if (result != ISC_R_SUCCESS)
+					goto tree_exit;
+				wild = ISC_TRUE;
+				goto found;
+			}
+			else if (result != ISC_R_NOTFOUND)
+				goto tree_exit;
+		}
+
+		active = activeempty(&search, &search.key, name);
+
+		/*
+		 * If we're here, then the name does not exist, is not
+		 * beneath a zonecut, and there's no matching wildcard.
+		 */
+		if ((search.qpversion->secure == dns_db_secure &&
+		     !search.qpversion->havensec3) ||
+		    (search.options & DNS_DBFIND_FORCENSEC) != 0 ||
+		    (search.options & DNS_DBFIND_FORCENSEC3) != 0)
+		{
+			result = find_closest_nsec(&search, nodep, foundname,
+						   rdataset, sigrdataset, trie,
+						   search.qpversion->secure);
+			if (result == ISC_R_SUCCESS)
+				result = active ? DNS_R_EMPTYNAME :
+						  DNS_R_NXDOMAIN;
+		} else
+			result = active ? DNS_R_EMPTYNAME : DNS_R_NXDOMAIN;
+		goto tree_exit;
+	}
+
+	nodename(node, &nname);
+	result = dns_name_copy(&nname, foundname, NULL);
+	if (result != ISC_R_SUCCESS)
+		goto tree_exit;
+
+ found:
+	/*
+	 * We have found a node whose name is the desired name, or we
+	 * have matched a wildcard.
+	 */
+
+	if (search.zonecut != NULL) {
+		/*
+		 * If we're beneath a zone cut, we don't want to look for
+		 * CNAMEs because they're not legitimate zone glue.
+		 */
+		cname_ok = ISC_FALSE;
+	} else {
+		/*
+		 * The node may be a zone cut itself.  If it might be one,
+		 * make sure we check for it later.
+		 *
+		 * DS records live above the zone cut in ordinary zone so
+		 * we want to ignore any referral.
+		 *
+		 * Stub zones don't have anything "above" the delgation so
+		 * we always return a referral.
+		 */
+		if (node->delegating &&
+		    ((node != search.qpdb->origin_node &&
+		      !dns_rdatatype_atparent(type)) ||
+		     IS_STUB(search.qpdb)))
+			maybe_zonecut = ISC_TRUE;
+	}
+
+	/*
+	 * Certain DNSSEC types are not subject to CNAME matching
+	 * (RFC4035, section 2.5 and RFC3007).
+	 *
+	 * We don't check for RRSIG, because we don't store RRSIG records
+	 * directly.
+	 */
+	if (type == dns_rdatatype_key || type == dns_rdatatype_nsec)
+		cname_ok = ISC_FALSE;
+
+	/*
+	 * We now go looking for rdata...
+	 */
+
+	found = NULL;
+	foundsig = NULL;
+	sigtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, type);
+	nsecheader = NULL;
+	nsecsig = NULL;
+	cnamesig = NULL;
+	empty_node = ISC_TRUE;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		/*
+		 * Look for an active, extant rdataset.
+		 */
+		do {
+			if (header->serial <= search.serial &&
+			    !IGNORE(header)) {
+				/*
+				 * Is this a "this rdataset doesn't
+				 * exist" record?
+				 */
+				if (NONEXISTENT(header))
+					header = NULL;
+				break;
+			} else
+				header = header->down;
+		} while (header != NULL);
+		if (header != NULL) {
+			/*
+			 * We now know that there is at least one active
+			 * rdataset at this node.
+			 */
+			empty_node = ISC_FALSE;
+
+			/*
+			 * Do special zone cut handling, if requested.
+			 */
+			if (maybe_zonecut &&
+			    header->type == dns_rdatatype_ns) {
+				search.zonecut = node;
+				search.zonecut_rdataset = header;
+				search.zonecut_sigrdataset = NULL;
+				maybe_zonecut = ISC_FALSE;
+				/*
+				 * It is not clear if KEY should still be
+				 * allowed at the parent side of the zone
+				 * cut or not.  It is needed for RFC3007
+				 * validated updates.
+				 */
+				if ((search.options & DNS_DBFIND_GLUEOK) == 0
+				    && type != dns_rdatatype_nsec
+				    && type != dns_rdatatype_key) {
+					/*
+					 * Glue is not OK, but any answer we
+					 * could return would be glue.  Return
+					 * the delegation.
+					 */
+					found = NULL;
+					break;
+				}
+				if (found != NULL && foundsig != NULL)
+					break;
+			}
+
+
+			/*
+			 * If the NSEC3 record doesn't match the chain
+			 * we are using behave as if it isn't here.
+			 */
+			if (header->type == dns_rdatatype_nsec3 &&
+			   !matchparams(header, &search)) {
+				goto partial_match;
+			}
+			/*
+			 * If we found a type we were looking for,
+			 * remember it.
+			 */
+			if (header->type == type ||
+			    type == dns_rdatatype_any ||
+			    (header->type == dns_rdatatype_cname &&
+			     cname_ok)) {
+				/*
+				 * We've found the answer!
+				 */
+				found = header;
+				if (header->type == dns_rdatatype_cname &&
+				    cname_ok) {
+					/*
+					 * We may be finding a CNAME instead
+					 * of the desired type.
+					 *
+					 * If we've already got the CNAME RRSIG,
+					 * use it, otherwise change sigtype
+					 * so that we find it.
+					 */
+					if (cnamesig != NULL)
+						foundsig = cnamesig;
+					else
+						sigtype =
+						    QPDB_RDATATYPE_SIGCNAME;
+				}
+				/*
+				 * If we've got all we need, end the search.
+				 */
+				if (!maybe_zonecut && foundsig != NULL)
+					break;
+			} else if (header->type == sigtype) {
+				/*
+				 * We've found the RRSIG rdataset for our
+				 * target type.  Remember it.
+				 */
+				foundsig = header;
+				/*
+				 * If we've got all we need, end the search.
+				 */
+				if (!maybe_zonecut && found != NULL)
+					break;
+			} else if (header->type == dns_rdatatype_nsec &&
+				   !search.qpversion->havensec3) {
+				/*
+				 * Remember a NSEC rdataset even if we're
+				 * not specifically looking for it, because
+				 * we might need it later.
+				 */
+				nsecheader = header;
+			} else if (header->type == QPDB_RDATATYPE_SIGNSEC &&
+				   !search.qpversion->havensec3) {
+				/*
+				 * If we need the NSEC rdataset, we'll also
+				 * need its signature.
+				 */
+				nsecsig = header;
+			} else if (cname_ok &&
+				   header->type == QPDB_RDATATYPE_SIGCNAME) {
+				/*
+				 * If we get a CNAME match, we'll also need
+				 * its signature.
+				 */
+				cnamesig = header;
+			}
+		}
+	}
+
+	if (empty_node) {
+		/*
+		 * We have an exact match for the name, but there are no
+		 * active rdatasets in the desired version.  That means that
+		 * this node doesn't exist in the desired version, and that
+		 * we really have a partial match.
+		 */
+		if (!wild)
+			goto partial_match;
+	}
+
+	/*
+	 * If we didn't find what we were looking for...
+	 */
+	if (found == NULL) {
+		if (search.zonecut != NULL) {
+			/*
+			 * We were trying to find glue at a node beneath a
+			 * zone cut, but didn't.
+			 *
+			 * Return the delegation.
+			 */
+			result = setup_delegation(&search, nodep, foundname,
+						  rdataset, sigrdataset);
+			goto tree_exit;
+		}
+		/*
+		 * The desired type doesn't exist.
+		 */
+		result = DNS_R_NXRRSET;
+		if (search.qpversion->secure == dns_db_secure &&
+		    !search.qpversion->havensec3 &&
+		    (nsecheader == NULL || nsecsig == NULL)) {
+			/*
+			 * The zone is secure but there's no NSEC,
+			 * or the NSEC has no signature!
+			 */
+			if (!wild) {
+				result = DNS_R_BADDB;
+				goto tree_exit;
+			}
+
+			result = find_closest_nsec(&search, nodep, foundname,
+						   rdataset, sigrdataset,
+						   &search.qpdb->tree,
+						   search.qpversion->secure);
+			if (result == ISC_R_SUCCESS)
+				result = DNS_R_EMPTYWILD;
+			goto tree_exit;
+		}
+		if ((search.options & DNS_DBFIND_FORCENSEC) != 0 &&
+		    nsecheader == NULL)
+		{
+			/*
+			 * There's no NSEC record, and we were told
+			 * to find one.
+			 */
+			result = DNS_R_BADDB;
+			goto tree_exit;
+		}
+		if (nodep != NULL) {
+			new_reference(search.qpdb, node);
+			*nodep = node;
+		}
+		if ((search.qpversion->secure == dns_db_secure &&
+		     !search.qpversion->havensec3) ||
+		    (search.options & DNS_DBFIND_FORCENSEC) != 0)
+		{
+			bind_rdataset(search.qpdb, node, nsecheader,
+				      0, rdataset);
+			if (nsecsig != NULL)
+				bind_rdataset(search.qpdb, node,
+					      nsecsig, 0, sigrdataset);
+		}
+		if (wild)
+			foundname->attributes |= DNS_NAMEATTR_WILDCARD;
+		goto tree_exit;
+	}
+
+	/*
+	 * We found what we were looking for, or we found a CNAME.
+	 */
+
+	if (type != found->type &&
+	    type != dns_rdatatype_any &&
+	    found->type == dns_rdatatype_cname) {
+		/*
+		 * We weren't doing an ANY query and we found a CNAME instead
+		 * of the type we were looking for, so we need to indicate
+		 * that result to the caller.
+		 */
+		result = DNS_R_CNAME;
+	} else if (search.zonecut != NULL) {
+		/*
+		 * If we're beneath a zone cut, we must indicate that the
+		 * result is glue, unless we're actually at the zone cut
+		 * and the type is NSEC or KEY.
+		 */
+		if (search.zonecut == node) {
+			/*
+			 * It is not clear if KEY should still be
+			 * allowed at the parent side of the zone
+			 * cut or not.  It is needed for RFC3007
+			 * validated updates.
+			 */
+			if (type == dns_rdatatype_nsec ||
+			    type == dns_rdatatype_nsec3 ||
+			    type == dns_rdatatype_key)
+				result = ISC_R_SUCCESS;
+			else if (type == dns_rdatatype_any)
+				result = DNS_R_ZONECUT;
+			else
+				result = DNS_R_GLUE;
+		} else
+			result = DNS_R_GLUE;
+		/*
+		 * We might have found data that isn't glue, but was occluded
+		 * by a dynamic update.  If the caller cares about this, they
+		 * will have told us to validate glue.
+		 *
+		 * XXX We should cache the glue validity state!
+		 */
+		if (result == DNS_R_GLUE &&
+		    (search.options & DNS_DBFIND_VALIDATEGLUE) != 0 &&
+		    !valid_glue(&search, foundname, type, node)) {
+			result = setup_delegation(&search, nodep, foundname,
+						  rdataset, sigrdataset);
+			goto tree_exit;
+		}
+	} else {
+		/*
+		 * An ordinary successful query!
+		 */
+		result = ISC_R_SUCCESS;
+	}
+
+	if (nodep != NULL) {
+		new_reference(search.qpdb, node);
+		*nodep = node;
+	}
+
+	if (type != dns_rdatatype_any) {
+		bind_rdataset(search.qpdb, node, found, 0, rdataset);
+		if (foundsig != NULL)
+			bind_rdataset(search.qpdb, node, foundsig, 0,
+				      sigrdataset);
+	}
+
+	if (wild)
+		foundname->attributes |= DNS_NAMEATTR_WILDCARD;
+
+ tree_exit:
+	RWUNLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (close_version)
+		closeversion(db, &version, ISC_FALSE);
+
+	return (result);
+}
+
+static isc_result_t
+zone_findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
+		 isc_stdtime_t now, dns_dbnode_t **nodep,
+		 dns_name_t *foundname,
+		 dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	UNUSED(db);
+	UNUSED(name);
+	UNUSED(options);
+	UNUSED(now);
+	UNUSED(nodep);
+	UNUSED(foundname);
+	UNUSED(rdataset);
+	UNUSED(sigrdataset);
+
+	FATAL_ERROR(__FILE__, __LINE__, "zone_findzonecut() called!");
+
+	/* NOTREACHED */
+	return (ISC_R_NOTIMPLEMENTED);
+}
+
+/*
+ * In a cache, expired rdatasets are skipped by the lookups, which only
+ * hold the tree lock for reading; they are freed once the cache cleaner
+ * has marked them stale with expirenode().
+ */
+
+static isc_result_t
+cache_zonecut_callback(qpnode_t *node, qpdb_search_t *search) {
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *dname_header, *sigdname_header;
+	isc_result_t result;
+
+	REQUIRE(search->zonecut == NULL);
+
+	/*
+	 * Look for a DNAME or RRSIG DNAME rdataset.
+	 */
+	dname_header = NULL;
+	sigdname_header = NULL;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (!ACTIVE(header, search->now)) {
+			/* Do nothing. */
+		} else if (header->type == dns_rdatatype_dname &&
+			   EXISTS(header)) {
+			dname_header = header;
+		} else if (header->type == QPDB_RDATATYPE_SIGDNAME &&
+			 EXISTS(header)) {
+			sigdname_header = header;
+		}
+	}
+
+	if (dname_header != NULL &&
+	    (!DNS_TRUST_PENDING(dname_header->trust) ||
+	     (search->options & DNS_DBFIND_PENDINGOK) != 0)) {
+		search->zonecut = node;
+		search->zonecut_rdataset = dname_header;
+		search->zonecut_sigrdataset = sigdname_header;
+		result = DNS_R_PARTIALMATCH;
+	} else
+		result = DNS_R_CONTINUE;
+
+	return (result);
+}
+
+/*%
+ * Find the deepest NS rdataset at or above the name sought by 'search':
+ * at 'node', the node of the name itself if it is not NULL, or else at
+ * the names above it.
+ */
+static inline isc_result_t
+find_deepest_zonecut(qpdb_search_t *search, qpnode_t *node,
+		     dns_dbnode_t **nodep, dns_name_t *foundname,
+		     dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	unsigned int i;
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *found, *foundsig;
+	isc_result_t result = ISC_R_NOTFOUND;
+	dns_name_t name;
+
+	/*
+	 * Caller must be holding the tree lock.
+	 */
+
+	i = search->nancestors;
+	if (node == NULL) {
+		if (i == 0)
+			return (ISC_R_NOTFOUND);
+		node = ANCESTOR(search, --i);
+	}
+	for (;;) {
+		/*
+		 * Look for NS and RRSIG NS rdatasets.
+		 */
+		found = NULL;
+		foundsig = NULL;
+		for (header = node->data; header != NULL; header = header_next) {
+			header_next = header->next;
+			if (!ACTIVE(header, search->now)) {
+				/* Do nothing. */
+			} else if (EXISTS(header)) {
+				/*
+				 * We've found an extant rdataset.  See if
+				 * we're interested in it.
+				 */
+				if (header->type == dns_rdatatype_ns) {
+					found = header;
+					if (foundsig != NULL)
+						break;
+				} else if (header->type ==
+					   QPDB_RDATATYPE_SIGNS) {
+					foundsig = header;
+					if (found != NULL)
+						break;
+				}
+			}
+		}
+
+		if (found != NULL) {
+			/*
+			 * If we have to set foundname, we do it before
+			 * anything else.  If we were to set foundname after
+			 * we had set nodep or bound the rdataset, then we'd
+			 * have to undo that work if dns_name_copy()
+			 * failed.  By setting foundname first, there's
+			 * nothing to undo if we have trouble.
+			 */
+			if (foundname != NULL) {
+				nodename(node, &name);
+				result = dns_name_copy(&name, foundname, NULL);
+				if (result != ISC_R_SUCCESS)
+					return (result);
+			}
+			result = DNS_R_DELEGATION;
+			if (nodep != NULL) {
+				new_reference(search->qpdb, node);
+				*nodep = node;
+			}
+			bind_rdataset(search->qpdb, node, found, search->now,
+				      rdataset);
+			if (foundsig != NULL)
+				bind_rdataset(search->qpdb, node, foundsig,
+					      search->now, sigrdataset);
+			break;
+		}
+
+		if (i == 0)
+			break;
+		node = ANCESTOR(search, --i);
+	}
+
+	return (result);
+}
+
+static isc_result_t
+find_coveringnsec(qpdb_search_t *search, dns_dbnode_t **nodep,
+		  isc_stdtime_t now, dns_name_t *foundname,
+		  dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	qpnode_t *node;
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *found, *foundsig;
+	isc_boolean_t empty_node;
+	isc_result_t result;
+	dns_name_t name;
+	qpdb_rdatatype_t matchtype, sigmatchtype;
+	qp_key_t key;
+
+	matchtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_nsec, 0);
+	sigmatchtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig,
+					    dns_rdatatype_nsec);
+
+	node = qp_neighbor(search->trie, &search->key, ISC_FALSE, ISC_FALSE);
+	while (node != NULL) {
+		found = NULL;
+		foundsig = NULL;
+		empty_node = ISC_TRUE;
+		for (header = node->data; header != NULL; header = header_next) {
+			header_next = header->next;
+			if (!ACTIVE(header, search->now))
+				continue;
+			if (NONEXISTENT(header) ||
+			    QPDB_RDATATYPE_BASE(header->type) == 0)
+				continue;
+			empty_node = ISC_FALSE;
+			if (header->type == matchtype)
+				found = header;
+			else if (header->type == sigmatchtype)
+				foundsig = header;
+		}
+		if (found != NULL) {
+			nodename(node, &name);
+			result = dns_name_copy(&name, foundname, NULL);
+			if (result != ISC_R_SUCCESS)
+				return (result);
+			bind_rdataset(search->qpdb, node, found,
+				      now, rdataset);
+			if (foundsig != NULL)
+				bind_rdataset(search->qpdb, node, foundsig,
+					      now, sigrdataset);
+			new_reference(search->qpdb, node);
+			*nodep = node;
+			return (DNS_R_COVERINGNSEC);
+		} else if (!empty_node)
+			return (ISC_R_NOTFOUND);
+		nodekey(node, &key);
+		node = qp_neighbor(search->trie, &key, ISC_FALSE, ISC_FALSE);
+	}
+	return (ISC_R_NOMORE);
+}
+
+static isc_result_t
+cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
+	   dns_rdatatype_t type, unsigned int options, isc_stdtime_t now,
+	   dns_dbnode_t **nodep, dns_name_t *foundname,
+	   dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	qpnode_t *node = NULL;
+	isc_result_t result;
+	qpdb_search_t search;
+	isc_boolean_t cname_ok = ISC_TRUE;
+	isc_boolean_t empty_node;
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *found, *nsheader;
+	rdatasetheader_t *foundsig, *nssig, *cnamesig;
+	qpdb_rdatatype_t sigtype, negtype;
+	qpnode_t *ancestor;
+	dns_name_t nname;
+	unsigned int i;
+
+	UNUSED(version);
+
+	search.qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(search.qpdb));
+	REQUIRE(version == NULL);
+
+	if (now == 0)
+		isc_stdtime_get(&now);
+
+	search.qpversion = NULL;
+	search.serial = 1;
+	search.options = options;
+	search.copy_name = ISC_FALSE;
+	search.wild = ISC_FALSE;
+	search.zonecut = NULL;
+	dns_fixedname_init(&search.zonecut_name);
+	search.now = now;
+
+	RWLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	/*
+	 * Look the name up, then go down through the names above it that
+	 * are in the trie, letting cache_zonecut_callback() search the
+	 * rdatasets at the possible zone cuts for a DNAME rdataset.
+	 */
+	node = search_lookup(&search, &search.qpdb->tree, name);
+	for (i = 0; i < search.nancestors; i++) {
+		ancestor = ANCESTOR(&search, i);
+		if (ancestor->delegating &&
+		    cache_zonecut_callback(ancestor, &search) ==
+		    DNS_R_PARTIALMATCH)
+		{
+			search.nancestors = i + 1;
+			node = NULL;
+			break;
+		}
+	}
+
+	if (node == NULL) {
+		if (search.nancestors == 0) {
+			result = ISC_R_NOTFOUND;
+			goto tree_exit;
+		}
+		nodename(ANCESTOR(&search, search.nancestors - 1), &nname);
+		result = dns_name_copy(&nname, foundname, NULL);
+		if (result != ISC_R_SUCCESS)
+			goto tree_exit;
+		if ((search.options & DNS_DBFIND_COVERINGNSEC) != 0) {
+			result = find_coveringnsec(&search, nodep, now,
+						   foundname, rdataset,
+						   sigrdataset);
+			if (result == DNS_R_COVERINGNSEC)
+				goto tree_exit;
+		}
+		if (search.zonecut != NULL) {
+		    result = setup_delegation(&search, nodep, foundname,
+					      rdataset, sigrdataset);
+		    goto tree_exit;
+		} else {
+		find_ns:
+			result = find_deepest_zonecut(&search, node, nodep,
+						      foundname, rdataset,
+						      sigrdataset);
+			goto tree_exit;
+		}
+	}
+
+	nodename(node, &nname);
+	result = dns_name_copy(&nname, foundname, NULL);
+	if (result != ISC_R_SUCCESS)
+		goto tree_exit;
+
+	/*
+	 * Certain DNSSEC types are not subject to CNAME matching
+	 * (RFC4035, section 2.5 and RFC3007).
+	 *
+	 * We don't check for RRSIG, because we don't store RRSIG records
+	 * directly.
+	 */
+	if (type == dns_rdatatype_key || type == dns_rdatatype_nsec)
+		cname_ok = ISC_FALSE;
+
+	/*
+	 * We now go looking for rdata...
+	 */
+
+	found = NULL;
+	foundsig = NULL;
+	sigtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, type);
+	negtype = QPDB_RDATATYPE_VALUE(0, type);
+	nsheader = NULL;
+	nssig = NULL;
+	cnamesig = NULL;
+	empty_node = ISC_TRUE;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (!ACTIVE(header, search.now)) {
+			/* Do nothing. */
+		} else if (EXISTS(header) && (!STALE(header))) {
+			/*
+			 * We now know that there is at least one active
+			 * non-stale rdataset at this node.
+			 */
+			empty_node = ISC_FALSE;
+
+			/*
+			 * If we found a type we were looking for, remember
+			 * it.
+			 */
+			if (header->type == type ||
+			    (type == dns_rdatatype_any &&
+			     QPDB_RDATATYPE_BASE(header->type) != 0) ||
+			    (cname_ok && header->type ==
+			     dns_rdatatype_cname)) {
+				/*
+				 * We've found the answer.
+				 */
+				found = header;
+				if (header->type == dns_rdatatype_cname &&
+				    cname_ok &&
+				    cnamesig != NULL) {
+					/*
+					 * If we've already got the
+					 * CNAME RRSIG, use it.
+					 */
+					foundsig = cnamesig;
+				}
+			} else if (header->type == sigtype) {
+				/*
+				 * We've found the RRSIG rdataset for our
+				 * target type.  Remember it.
+				 */
+				foundsig = header;
+			} else if (header->type == QPDB_RDATATYPE_NCACHEANY ||
+				   header->type == negtype) {
+				/*
+				 * We've found a negative cache entry.
+				 */
+				found = header;
+			} else if (header->type == dns_rdatatype_ns) {
+				/*
+				 * Remember a NS rdataset even if we're
+				 * not specifically looking for it, because
+				 * we might need it later.
+				 */
+				nsheader = header;
+			} else if (header->type == QPDB_RDATATYPE_SIGNS) {
+				/*
+				 * If we need the NS rdataset, we'll also
+				 * need its signature.
+				 */
+				nssig = header;
+			} else if (cname_ok &&
+				   header->type == QPDB_RDATATYPE_SIGCNAME) {
+				/*
+				 * If we get a CNAME match, we'll also need
+				 * its signature.
+				 */
+				cnamesig = header;
+			}
+		}
+	}
+
+	if (empty_node) {
+		/*
+		 * We have an exact match for the name, but there are no
+		 * extant rdatasets.  That means that this node doesn't
+		 * meaningfully exist, and that we really have a partial match.
+		 */
+		goto find_ns;
+	}
+
+	/*
+	 * If we didn't find what we were looking for...
+	 */
+	if (found == NULL ||
+	    (DNS_TRUST_ADDITIONAL(found->trust) &&
+	     ((options & DNS_DBFIND_ADDITIONALOK) == 0)) ||
+	    (found->trust == dns_trust_glue &&
+	     ((options & DNS_DBFIND_GLUEOK) == 0)) ||
+	    (DNS_TRUST_PENDING(found->trust) &&
+	     ((options & DNS_DBFIND_PENDINGOK) == 0))) {
+		/*
+		 * If there is an NS rdataset at this node, then this is the
+		 * deepest zone cut.
+		 */
+		if (nsheader != NULL) {
+			if (nodep != NULL) {
+				new_reference(search.qpdb, node);
+				*nodep = node;
+			}
+			bind_rdataset(search.qpdb, node, nsheader, search.now,
+				      rdataset);
+			if (nssig != NULL)
+				bind_rdataset(search.qpdb, node, nssig,
+					      search.now, sigrdataset);
+			result = DNS_R_DELEGATION;
+			goto tree_exit;
+		}
+
+		/*
+		 * Go find the deepest zone cut.
+		 */
+		goto find_ns;
+	}
+
+	/*
+	 * We found what we were looking for, or we found a CNAME.
+	 */
+
+	if (nodep != NULL) {
+		new_reference(search.qpdb, node);
+		*nodep = node;
+	}
+
+	if (NEGATIVE(found)) {
+		/*
+		 * We found a negative cache entry.
+		 */
+		if (NXDOMAIN(found))
+			result = DNS_R_NCACHENXDOMAIN;
+		else
+			result = DNS_R_NCACHENXRRSET;
+	} else if (type != found->type &&
+		   type != dns_rdatatype_any &&
+		   found->type == dns_rdatatype_cname) {
+		/*
+		 * We weren't doing an ANY query and we found a CNAME instead
+		 * of the type we were looking for, so we need to indicate
+		 * that result to the caller.
+		 */
+		result = DNS_R_CNAME;
+	} else {
+		/*
+		 * An ordinary successful query!
+		 */
+		result = ISC_R_SUCCESS;
+	}
+
+	if (type != dns_rdatatype_any || result == DNS_R_NCACHENXDOMAIN ||
+	    result == DNS_R_NCACHENXRRSET) {
+		bind_rdataset(search.qpdb, node, found, search.now,
+			      rdataset);
+		if (!NEGATIVE(found) && foundsig != NULL)
+			bind_rdataset(search.qpdb, node, foundsig, search.now,
+				      sigrdataset);
+	}
+
+ tree_exit:
+	RWUNLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	update_cachestats(search.qpdb, result);
+	return (result);
+}
+
+static isc_result_t
+cache_findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
+		  isc_stdtime_t now, dns_dbnode_t **nodep,
+		  dns_name_t *foundname,
+		  dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	qpnode_t *node = NULL;
+	isc_result_t result;
+	qpdb_search_t search;
+	rdatasetheader_t *header, *header_next;
+	rdatasetheader_t *found, *foundsig;
+	dns_name_t nname;
+
+	search.qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(search.qpdb));
+
+	if (now == 0)
+		isc_stdtime_get(&now);
+
+	search.qpversion = NULL;
+	search.serial = 1;
+	search.options = options;
+	search.copy_name = ISC_FALSE;
+	search.wild = ISC_FALSE;
+	search.zonecut = NULL;
+	dns_fixedname_init(&search.zonecut_name);
+	search.now = now;
+
+	RWLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	node = search_lookup(&search, &search.qpdb->tree, name);
+	if ((options & DNS_DBFIND_NOEXACT) != 0)
+		node = NULL;
+
+	if (node == NULL) {
+	find_ns:
+		result = find_deepest_zonecut(&search, node, nodep, foundname,
+					      rdataset, sigrdataset);
+		goto tree_exit;
+	}
+
+	/*
+	 * We now go looking for an NS rdataset at the node.
+	 */
+
+	found = NULL;
+	foundsig = NULL;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (!ACTIVE(header, search.now)) {
+			/* Do nothing. */
+		} else if (EXISTS(header)) {
+			/*
+			 * If we found a type we were looking for, remember
+			 * it.
+			 */
+			if (header->type == dns_rdatatype_ns) {
+				/*
+				 * Remember a NS rdataset even if we're
+				 * not specifically looking for it, because
+				 * we might need it later.
+				 */
+				found = header;
+			} else if (header->type == QPDB_RDATATYPE_SIGNS) {
+				/*
+				 * If we need the NS rdataset, we'll also
+				 * need its signature.
+				 */
+				foundsig = header;
+			}
+		}
+	}
+
+	if (found == NULL) {
+		/*
+		 * No NS records here.
+		 */
+		goto find_ns;
+	}
+
+	nodename(node, &nname);
+	result = dns_name_copy(&nname, foundname, NULL);
+	if (result != ISC_R_SUCCESS)
+		goto tree_exit;
+
+	if (nodep != NULL) {
+		new_reference(search.qpdb, node);
+		*nodep = node;
+	}
+
+	bind_rdataset(search.qpdb, node, found, search.now, rdataset);
+	if (foundsig != NULL)
+		bind_rdataset(search.qpdb, node, foundsig, search.now,
+			      sigrdataset);
+
+ tree_exit:
+	RWUNLOCK(&search.qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (result == DNS_R_DELEGATION)
+		result = ISC_R_SUCCESS;
+
+	return (result);
+}
+
+static isc_result_t
+createiterator(dns_db_t *db, unsigned int options, dns_dbiterator_t **iteratorp)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpdb_dbiterator_t *qpdbiter;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	qpdbiter = isc_mem_get(qpdb->common.mctx, sizeof(*qpdbiter));
+	if (qpdbiter == NULL)
+		return (ISC_R_NOMEMORY);
+
+	qpdbiter->common.methods = &dbiterator_methods;
+	qpdbiter->common.db = NULL;
+	dns_db_attach(db, &qpdbiter->common.db);
+	qpdbiter->common.relative_names =
+			ISC_TF((options & DNS_DB_RELATIVENAMES) != 0);
+	qpdbiter->common.magic = DNS_DBITERATOR_MAGIC;
+	qpdbiter->common.cleaning = ISC_FALSE;
+	qpdbiter->result = ISC_R_SUCCESS;
+	qpdbiter->node = NULL;
+	qpdbiter->nsec3only = ISC_TF((options & DNS_DB_NSEC3ONLY) != 0);
+	qpdbiter->nonsec3 = ISC_TF((options & DNS_DB_NONSEC3) != 0);
+
+	*iteratorp = (dns_dbiterator_t *)qpdbiter;
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+zone_findrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+		  dns_rdatatype_t type, dns_rdatatype_t covers,
+		  isc_stdtime_t now, dns_rdataset_t *rdataset,
+		  dns_rdataset_t *sigrdataset)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	rdatasetheader_t *header, *header_next, *found, *foundsig;
+	qpdb_serial_t serial;
+	qpdb_version_t *qpversion = version;
+	isc_boolean_t close_version = ISC_FALSE;
+	qpdb_rdatatype_t matchtype, sigmatchtype;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(type != dns_rdatatype_any);
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	if (qpversion == NULL) {
+		currentversion(db, (dns_dbversion_t **) (void *)(&qpversion));
+		close_version = ISC_TRUE;
+	}
+	serial = qpversion->serial;
+	now = 0;
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	found = NULL;
+	foundsig = NULL;
+	matchtype = QPDB_RDATATYPE_VALUE(type, covers);
+	if (covers == 0)
+		sigmatchtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, type);
+	else
+		sigmatchtype = 0;
+
+	for (header = qpnode->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		do {
+			if (header->serial <= serial &&
+			    !IGNORE(header)) {
+				/*
+				 * Is this a "this rdataset doesn't
+				 * exist" record?
+				 */
+				if (NONEXISTENT(header))
+					header = NULL;
+				break;
+			} else
+				header = header->down;
+		} while (header != NULL);
+		if (header != NULL) {
+			/*
+			 * We have an active, extant rdataset.  If it's a
+			 * type we're looking for, remember it.
+			 */
+			if (header->type == matchtype) {
+				found = header;
+				if (foundsig != NULL)
+					break;
+			} else if (header->type == sigmatchtype) {
+				foundsig = header;
+				if (found != NULL)
+					break;
+			}
+		}
+	}
+	if (found != NULL) {
+		bind_rdataset(qpdb, qpnode, found, now, rdataset);
+		if (foundsig != NULL)
+			bind_rdataset(qpdb, qpnode, foundsig, now,
+				      sigrdataset);
+	}
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (close_version)
+		closeversion(db, (dns_dbversion_t **) (void *)(&qpversion),
+			     ISC_FALSE);
+
+	if (found == NULL)
+		return (ISC_R_NOTFOUND);
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+cache_findrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+		   dns_rdatatype_t type, dns_rdatatype_t covers,
+		   isc_stdtime_t now, dns_rdataset_t *rdataset,
+		   dns_rdataset_t *sigrdataset)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	rdatasetheader_t *header, *header_next, *found, *foundsig;
+	qpdb_rdatatype_t matchtype, sigmatchtype, negtype;
+	isc_result_t result;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(type != dns_rdatatype_any);
+
+	UNUSED(version);
+
+	result = ISC_R_SUCCESS;
+
+	if (now == 0)
+		isc_stdtime_get(&now);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	found = NULL;
+	foundsig = NULL;
+	matchtype = QPDB_RDATATYPE_VALUE(type, covers);
+	negtype = QPDB_RDATATYPE_VALUE(0, type);
+	if (covers == 0)
+		sigmatchtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, type);
+	else
+		sigmatchtype = 0;
+
+	for (header = qpnode->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (!ACTIVE(header, now)) {
+			/* Do nothing. */
+		} else if (EXISTS(header) && (!STALE(header))) {
+			if (header->type == matchtype)
+				found = header;
+			else if (header->type == QPDB_RDATATYPE_NCACHEANY ||
+				 header->type == negtype)
+				found = header;
+			else if (header->type == sigmatchtype)
+				foundsig = header;
+		}
+	}
+	if (found != NULL) {
+		bind_rdataset(qpdb, qpnode, found, now, rdataset);
+		if (!NEGATIVE(found) && foundsig != NULL)
+			bind_rdataset(qpdb, qpnode, foundsig, now,
+				      sigrdataset);
+	}
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (found == NULL)
+		return (ISC_R_NOTFOUND);
+
+	if (NEGATIVE(found)) {
+		/*
+		 * We found a negative cache entry.
+		 */
+		if (NXDOMAIN(found))
+			result = DNS_R_NCACHENXDOMAIN;
+		else
+			result = DNS_R_NCACHENXRRSET;
+	}
+
+	update_cachestats(qpdb, result);
+
+	return (result);
+}
+
+static isc_result_t
+allrdatasets(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+	     isc_stdtime_t now, dns_rdatasetiter_t **iteratorp)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	qpdb_version_t *qpversion = version;
+	qpdb_rdatasetiter_t *iterator;
+	unsigned int refs;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	iterator = isc_mem_get(qpdb->common.mctx, sizeof(*iterator));
+	if (iterator == NULL)
+		return (ISC_R_NOMEMORY);
+
+	if ((db->attributes & DNS_DBATTR_CACHE) == 0) {
+		now = 0;
+		if (qpversion == NULL)
+			currentversion(db,
+				 (dns_dbversion_t **) (void *)(&qpversion));
+		else {
+			INSIST(qpversion->qpdb == qpdb);
+
+			isc_refcount_increment(&qpversion->references,
+					       &refs);
+			INSIST(refs > 1);
+		}
+	} else {
+		if (now == 0)
+			isc_stdtime_get(&now);
+		qpversion = NULL;
+	}
+
+	iterator->common.magic = DNS_RDATASETITER_MAGIC;
+	iterator->common.methods = &rdatasetiter_methods;
+	iterator->common.db = db;
+	iterator->common.node = node;
+	iterator->common.version = (dns_dbversion_t *)qpversion;
+	iterator->common.now = now;
+
+	/*
+	 * The caller holds a reference to 'node', so the node can be
+	 * referenced again without the tree lock.  Like every node
+	 * reference, it also holds the database; detachnode() releases
+	 * both when the iterator is destroyed.
+	 */
+	isc_refcount_increment(&qpnode->references, &refs);
+	INSIST(refs > 1);
+	isc_refcount_increment(&qpdb->references, NULL);
+
+	iterator->current = NULL;
+
+	*iteratorp = (dns_rdatasetiter_t *)iterator;
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_boolean_t
+cname_and_other_data(qpnode_t *node, qpdb_serial_t serial) {
+	rdatasetheader_t *header, *header_next;
+	isc_boolean_t cname, other_data;
+	dns_rdatatype_t rdtype;
+
+	/*
+	 * The caller must hold the tree lock.
+	 */
+
+	/*
+	 * Look for CNAME and "other data" rdatasets active in our version.
+	 */
+	cname = ISC_FALSE;
+	other_data = ISC_FALSE;
+	for (header = node->data; header != NULL; header = header_next) {
+		header_next = header->next;
+		if (header->type == dns_rdatatype_cname) {
+			/*
+			 * Look for an active extant CNAME.
+			 */
+			do {
+				if (header->serial <= serial &&
+				    !IGNORE(header)) {
+					/*
+					 * Is this a "this rdataset doesn't
+					 * exist" record?
+					 */
+					if (NONEXISTENT(header))
+						header = NULL;
+					break;
+				} else
+					header = header->down;
+			} while (header != NULL);
+			if (header != NULL)
+				cname = ISC_TRUE;
+		} else {
+			/*
+			 * Look for active extant "other data".
+			 *
+			 * "Other data" is any rdataset whose type is not
+			 * KEY, NSEC, SIG or RRSIG.
+			 */
+			rdtype = QPDB_RDATATYPE_BASE(header->type);
+			if (rdtype != dns_rdatatype_key &&
+			    rdtype != dns_rdatatype_sig &&
+			    rdtype != dns_rdatatype_nsec &&
+			    rdtype != dns_rdatatype_rrsig) {
+				/*
+				 * Is it active and extant?
+				 */
+				do {
+					if (header->serial <= serial &&
+					    !IGNORE(header)) {
+						/*
+						 * Is this a "this rdataset
+						 * doesn't exist" record?
+						 */
+						if (NONEXISTENT(header))
+							header = NULL;
+						break;
+					} else
+						header = header->down;
+				} while (header != NULL);
+				if (header != NULL)
+					other_data = ISC_TRUE;
+			}
+		}
+	}
+
+	if (cname && other_data)
+		return (ISC_TRUE);
+
+	return (ISC_FALSE);
+}
+
+static void
+update_recordsandbytes(isc_boolean_t add, qpdb_version_t *qpversion,
+		       rdatasetheader_t *header)
+{
+	unsigned char *hdr = (unsigned char *)header;
+	size_t hdrsize = sizeof (*header);
+
+	if (add) {
+		qpversion->records += dns_rdataslab_count(hdr, hdrsize);
+		qpversion->bytes += dns_rdataslab_size(hdr, hdrsize);
+	} else {
+		qpversion->records -= dns_rdataslab_count(hdr, hdrsize);
+		qpversion->bytes -= dns_rdataslab_size(hdr, hdrsize);
+	}
+}
+
+static isc_result_t
+add(dns_qpdb_t *qpdb, qpnode_t *qpnode, qpdb_version_t *qpversion,
+    rdatasetheader_t *newheader, unsigned int options, isc_boolean_t loading,
+    dns_rdataset_t *addedrdataset, isc_stdtime_t now)
+{
+	qpdb_changed_t *changed = NULL;
+	rdatasetheader_t *topheader, *topheader_prev, *header, *sigheader;
+	unsigned char *merged;
+	isc_result_t result;
+	isc_boolean_t header_nx;
+	isc_boolean_t newheader_nx;
+	isc_boolean_t merge;
+	dns_rdatatype_t rdtype, covers;
+	qpdb_rdatatype_t negtype, sigtype;
+	dns_trust_t trust;
+
+	/*
+	 * Add an rdatasetheader_t to a node.
+	 */
+
+	/*
+	 * Caller must be holding the tree write lock.
+	 */
+
+	if ((options & DNS_DBADD_MERGE) != 0) {
+		REQUIRE(qpversion != NULL);
+		merge = ISC_TRUE;
+	} else
+		merge = ISC_FALSE;
+
+	if ((options & DNS_DBADD_FORCE) != 0)
+		trust = dns_trust_ultimate;
+	else
+		trust = newheader->trust;
+
+	if (qpversion != NULL && !loading) {
+		/*
+		 * We always add a changed record, even if no changes end up
+		 * being made to this node, because it's harmless and
+		 * simplifies the code.
+		 */
+		changed = add_changed(qpdb, qpversion, qpnode);
+		if (changed == NULL) {
+			free_rdataset(qpdb->common.mctx, newheader);
+			return (ISC_R_NOMEMORY);
+		}
+	}
+
+	newheader_nx = NONEXISTENT(newheader) ? ISC_TRUE : ISC_FALSE;
+	topheader_prev = NULL;
+	sigheader = NULL;
+	negtype = 0;
+	if (qpversion == NULL && !newheader_nx) {
+		rdtype = QPDB_RDATATYPE_BASE(newheader->type);
+		covers = QPDB_RDATATYPE_EXT(newheader->type);
+		sigtype = QPDB_RDATATYPE_VALUE(dns_rdatatype_rrsig, covers);
+		if (NEGATIVE(newheader)) {
+			/*
+			 * We're adding a negative cache entry.
+			 */
+			if (covers == dns_rdatatype_any) {
+				/*
+				 * If we're adding an negative cache entry
+				 * which covers all types (NXDOMAIN,
+				 * NODATA(QTYPE=ANY)),
+				 *
+				 * We make all other data stale so that the
+				 * only rdataset that can be found at this
+				 * node is the negative cache entry.
+				 */
+				for (topheader = qpnode->data;
+				     topheader != NULL;
+				     topheader = topheader->next)
+				{
+					topheader->rdh_ttl = 0;
+					mark_stale_header(topheader);
+				}
+				goto find_header;
+			}
+			/*
+			 * Otherwise look for any RRSIGs of the given
+			 * type so they can be marked stale later.
+			 */
+			for (topheader = qpnode->data;
+			     topheader != NULL;
+			     topheader = topheader->next)
+				if (topheader->type == sigtype)
+					sigheader = topheader;
+			negtype = QPDB_RDATATYPE_VALUE(covers, 0);
+		} else {
+			/*
+			 * We're adding something that isn't a
+			 * negative cache entry.  Look for an extant
+			 * non-stale NXDOMAIN/NODATA(QTYPE=ANY) negative
+			 * cache entry.  If we're adding an RRSIG, also
+			 * check for an extant non-stale NODATA ncache
+			 * entry which covers the same type as the RRSIG.
+			 */
+			for (topheader = qpnode->data;
+			     topheader != NULL;
+			     topheader = topheader->next) {
+				if ((topheader->type ==
+					QPDB_RDATATYPE_NCACHEANY) ||
+					(newheader->type == sigtype &&
+					topheader->type ==
+					QPDB_RDATATYPE_VALUE(0, covers))) {
+						break;
+					}
+			}
+			if (topheader != NULL && EXISTS(topheader) &&
+			    ACTIVE(topheader, now)) {
+				/*
+				 * Found one.
+				 */
+				if (trust < topheader->trust) {
+					/*
+					 * The NXDOMAIN/NODATA(QTYPE=ANY)
+					 * is more trusted.
+					 */
+					free_rdataset(qpdb->common.mctx,
+						      newheader);
+					if (addedrdataset != NULL)
+						bind_rdataset(qpdb, qpnode,
+							      topheader, now,
+							      addedrdataset);
+					return (DNS_R_UNCHANGED);
+				}
+				/*
+				 * The new rdataset is better.  Expire the
+				 * ncache entry.
+				 */
+				topheader->rdh_ttl = 0;
+				mark_stale_header(topheader);
+				topheader = NULL;
+				goto find_header;
+			}
+			negtype = QPDB_RDATATYPE_VALUE(0, rdtype);
+		}
+	}
+
+	for (topheader = qpnode->data;
+	     topheader != NULL;
+	     topheader = topheader->next) {
+		if (topheader->type == newheader->type ||
+		    topheader->type == negtype)
+			break;
+		topheader_prev = topheader;
+	}
+
+ find_header:
+	/*
+	 * If header isn't NULL, we've found the right type.  There may be
+	 * IGNORE rdatasets between the top of the chain and the first real
+	 * data.  We skip over them.
+	 */
+	header = topheader;
+	while (header != NULL && IGNORE(header))
+		header = header->down;
+	if (header != NULL) {
+		header_nx = NONEXISTENT(header) ? ISC_TRUE : ISC_FALSE;
+
+		/*
+		 * Deleting an already non-existent rdataset has no effect.
+		 */
+		if (header_nx && newheader_nx) {
+			free_rdataset(qpdb->common.mctx, newheader);
+			return (DNS_R_UNCHANGED);
+		}
+
+		/*
+		 * Trying to add an rdataset with lower trust to a cache DB
+		 * has no effect, provided that the cache data isn't stale.
+		 */
+		if (qpversion == NULL && trust < header->trust &&
+		    (ACTIVE(header, now) || header_nx)) {
+			free_rdataset(qpdb->common.mctx, newheader);
+			if (addedrdataset != NULL)
+				bind_rdataset(qpdb, qpnode, header, now,
+					      addedrdataset);
+			return (DNS_R_UNCHANGED);
+		}
+
+		/*
+		 * Don't merge if a nonexistent rdataset is involved.
+		 */
+		if (merge && (header_nx || newheader_nx))
+			merge = ISC_FALSE;
+
+		/*
+		 * If 'merge' is ISC_TRUE, we'll try to create a new rdataset
+		 * that is the union of 'newheader' and 'header'.
+		 */
+		if (merge) {
+			unsigned int flags = 0;
+			struct noqname *noqname, *closest;
+
+			INSIST(qpversion->serial >= header->serial);
+			merged = NULL;
+			result = ISC_R_SUCCESS;
+
+			if ((options & DNS_DBADD_EXACT) != 0)
+				flags |= DNS_RDATASLAB_EXACT;
+			if ((options & DNS_DBADD_EXACTTTL) != 0 &&
+			     newheader->rdh_ttl != header->rdh_ttl)
+					result = DNS_R_NOTEXACT;
+			else if (newheader->rdh_ttl != header->rdh_ttl)
+				flags |= DNS_RDATASLAB_FORCE;
+			if (result == ISC_R_SUCCESS)
+				result = dns_rdataslab_merge(
+					     (unsigned char *)header,
+					     (unsigned char *)newheader,
+					     (unsigned int)(sizeof(*newheader)),
+					     qpdb->common.mctx,
+					     qpdb->common.rdclass,
+					     (dns_rdatatype_t)header->type,
+					     flags, &merged);
+			if (result == ISC_R_SUCCESS) {
+				/*
+				 * If 'header' has the same serial number as
+				 * we do, we could clean it up now if we knew
+				 * that our caller had no references to it.
+				 * We don't know this, however, so we leave it
+				 * alone.  It will get cleaned up when
+				 * clean_zone_node() runs.
+				 *
+				 * The merged header is a copy of 'newheader',
+				 * so it takes over its proofs.
+				 */
+				noqname = newheader->noqname;
+				closest = newheader->closest;
+				newheader->noqname = NULL;
+				newheader->closest = NULL;
+				free_rdataset(qpdb->common.mctx, newheader);
+				newheader = (rdatasetheader_t *)merged;
+				newheader->noqname = noqname;
+				newheader->closest = closest;
+			} else {
+				free_rdataset(qpdb->common.mctx, newheader);
+				return (result);
+			}
+		}
+		/*
+		 * Don't replace existing NS, A and AAAA RRsets
+		 * in the cache if they are already exist.  This
+		 * prevents named being locked to old servers.
+		 * Don't lower trust of existing record if the
+		 * update is forced.
+		 */
+		if (IS_CACHE(qpdb) && ACTIVE(header, now) &&
+		    header->type == dns_rdatatype_ns &&
+		    !header_nx && !newheader_nx &&
+		    header->trust >= newheader->trust &&
+		    dns_rdataslab_equalx((unsigned char *)header,
+					 (unsigned char *)newheader,
+					 (unsigned int)(sizeof(*newheader)),
+					 qpdb->common.rdclass,
+					 (dns_rdatatype_t)header->type)) {
+			/*
+			 * Honour the new ttl if it is less than the
+			 * older one.
+			 */
+			if (header->rdh_ttl > newheader->rdh_ttl)
+				header->rdh_ttl = newheader->rdh_ttl;
+			move_proofs(header, newheader);
+			free_rdataset(qpdb->common.mctx, newheader);
+			if (addedrdataset != NULL)
+				bind_rdataset(qpdb, qpnode, header, now,
+					      addedrdataset);
+			return (ISC_R_SUCCESS);
+		}
+		/*
+		 * If we have will be replacing a NS RRset force its TTL
+		 * to be no more than the current NS RRset's TTL.  This
+		 * ensures the delegations that are withdrawn are honoured.
+		 */
+		if (IS_CACHE(qpdb) && ACTIVE(header, now) &&
+		    header->type == dns_rdatatype_ns &&
+		    !header_nx && !newheader_nx &&
+		    header->trust <= newheader->trust) {
+			if (newheader->rdh_ttl > header->rdh_ttl) {
+				newheader->rdh_ttl = header->rdh_ttl;
+			}
+		}
+		if (IS_CACHE(qpdb) && ACTIVE(header, now) &&
+		    (options & DNS_DBADD_PREFETCH) == 0 &&
+		    (header->type == dns_rdatatype_a ||
+		     header->type == dns_rdatatype_aaaa ||
+		     header->type == dns_rdatatype_ds ||
+		     header->type == QPDB_RDATATYPE_SIGDDS) &&
+		    !header_nx && !newheader_nx &&
+		    header->trust >= newheader->trust &&
+		    dns_rdataslab_equal((unsigned char *)header,
+					(unsigned char *)newheader,
+					(unsigned int)(sizeof(*newheader)))) {
+			/*
+			 * Honour the new ttl if it is less than the
+			 * older one.
+			 */
+			if (header->rdh_ttl > newheader->rdh_ttl)
+				header->rdh_ttl = newheader->rdh_ttl;
+			move_proofs(header, newheader);
+			free_rdataset(qpdb->common.mctx, newheader);
+			if (addedrdataset != NULL)
+				bind_rdataset(qpdb, qpnode, header, now,
+					      addedrdataset);
+			return (ISC_R_SUCCESS);
+		}
+		INSIST(qpversion == NULL ||
+		       qpversion->serial >= topheader->serial);
+		if (loading) {
+			newheader->down = NULL;
+			/*
+			 * There are no other references to 'header' when
+			 * loading, so we MAY clean up 'header' now.
+			 * Since we don't generate changed records when
+			 * loading, we MUST clean up 'header' now.
+			 */
+			if (topheader_prev != NULL)
+				topheader_prev->next = newheader;
+			else
+				qpnode->data = newheader;
+			newheader->next = topheader->next;
+			if (qpversion != NULL && !header_nx)
+				update_recordsandbytes(ISC_FALSE, qpversion,
+						       header);
+			free_rdataset(qpdb->common.mctx, header);
+		} else {
+			if (topheader_prev != NULL)
+				topheader_prev->next = newheader;
+			else
+				qpnode->data = newheader;
+			newheader->next = topheader->next;
+			newheader->down = topheader;
+			topheader->next = newheader;
+			qpnode->dirty = 1;
+			if (changed != NULL)
+				changed->dirty = ISC_TRUE;
+			if (qpversion == NULL) {
+				header->rdh_ttl = 0;
+				mark_stale_header(header);
+				if (sigheader != NULL) {
+					sigheader->rdh_ttl = 0;
+					mark_stale_header(sigheader);
+				}
+			}
+			if (qpversion != NULL && !header_nx)
+				update_recordsandbytes(ISC_FALSE, qpversion,
+						       header);
+		}
+	} else {
+		/*
+		 * No non-IGNORED rdatasets of the given type exist at
+		 * this node.
+		 */
+
+		/*
+		 * If we're trying to delete the type, don't bother.
+		 */
+		if (newheader_nx) {
+			free_rdataset(qpdb->common.mctx, newheader);
+			return (DNS_R_UNCHANGED);
+		}
+
+		if (topheader != NULL) {
+			/*
+			 * We have an list of rdatasets of the given type,
+			 * but they're all marked IGNORE.  We simply insert
+			 * the new rdataset at the head of the list.
+			 *
+			 * Ignored rdatasets cannot occur during loading, so
+			 * we INSIST on it.
+			 */
+			INSIST(!loading);
+			INSIST(qpversion == NULL ||
+			       qpversion->serial >= topheader->serial);
+			if (topheader_prev != NULL)
+				topheader_prev->next = newheader;
+			else
+				qpnode->data = newheader;
+			newheader->next = topheader->next;
+			newheader->down = topheader;
+			topheader->next = newheader;
+			qpnode->dirty = 1;
+			if (changed != NULL)
+				changed->dirty = ISC_TRUE;
+		} else {
+			/*
+			 * No rdatasets of the given type exist at the node.
+			 */
+			newheader->next = qpnode->data;
+			newheader->down = NULL;
+			qpnode->data = newheader;
+		}
+	}
+
+	if (qpversion != NULL && !newheader_nx)
+		update_recordsandbytes(ISC_TRUE, qpversion, newheader);
+
+	/*
+	 * Check if the node now contains CNAME and other data.
+	 */
+	if (qpversion != NULL &&
+	    cname_and_other_data(qpnode, qpversion->serial))
+		return (DNS_R_CNAMEANDOTHER);
+
+	if (addedrdataset != NULL)
+		bind_rdataset(qpdb, qpnode, newheader, now, addedrdataset);
+
+	return (ISC_R_SUCCESS);
+}
+
+static inline isc_boolean_t
+delegating_type(dns_qpdb_t *qpdb, qpnode_t *node, qpdb_rdatatype_t type) {
+	if (IS_CACHE(qpdb)) {
+		if (type == dns_rdatatype_dname)
+			return (ISC_TRUE);
+		else
+			return (ISC_FALSE);
+	} else if (type == dns_rdatatype_dname ||
+		   (type == dns_rdatatype_ns &&
+		    (node != qpdb->origin_node || IS_STUB(qpdb))))
+		return (ISC_TRUE);
+	return (ISC_FALSE);
+}
+
+/*%
+ * Copy a proof of nonexistence, got with dns_rdataset_getnoqname() or
+ * dns_rdataset_getclosest() from 'rdataset', into '*proofp'.
+ */
+static isc_result_t
+addproof(dns_qpdb_t *qpdb, dns_rdataset_t *rdataset, isc_boolean_t closest,
+	 struct noqname **proofp)
+{
+	struct noqname *noqname;
+	isc_mem_t *mctx = qpdb->common.mctx;
+	dns_name_t name;
+	dns_rdataset_t neg, negsig;
+	isc_result_t result;
+	isc_region_t r;
+
+	dns_name_init(&name, NULL);
+	dns_rdataset_init(&neg);
+	dns_rdataset_init(&negsig);
+
+	if (closest)
+		result = dns_rdataset_getclosest(rdataset, &name, &neg,
+						 &negsig);
+	else
+		result = dns_rdataset_getnoqname(rdataset, &name, &neg,
+						 &negsig);
+	RUNTIME_CHECK(result == ISC_R_SUCCESS);
+
+	noqname = isc_mem_get(mctx, sizeof(*noqname));
+	if (noqname == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto cleanup;
+	}
+	dns_name_init(&noqname->name, NULL);
+	noqname->neg = NULL;
+	noqname->negsig = NULL;
+	noqname->type = neg.type;
+	result = dns_name_dup(&name, mctx, &noqname->name);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup;
+	result = dns_rdataslab_fromrdataset(&neg, mctx, &r, 0);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup;
+	noqname->neg = r.base;
+	result = dns_rdataslab_fromrdataset(&negsig, mctx, &r, 0);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup;
+	noqname->negsig = r.base;
+	dns_rdataset_disassociate(&neg);
+	dns_rdataset_disassociate(&negsig);
+	*proofp = noqname;
+	return (ISC_R_SUCCESS);
+
+ cleanup:
+	dns_rdataset_disassociate(&neg);
+	dns_rdataset_disassociate(&negsig);
+	if (noqname != NULL)
+		free_noqname(mctx, &noqname);
+	return (result);
+}
+
+static unsigned int init_count;
+
+static isc_result_t
+addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+	    isc_stdtime_t now, dns_rdataset_t *rdataset, unsigned int options,
+	    dns_rdataset_t *addedrdataset)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	qpdb_version_t *qpversion = version;
+	isc_region_t region;
+	rdatasetheader_t *newheader;
+	isc_result_t result;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	if (!IS_CACHE(qpdb))
+		REQUIRE(((qpnode->nsec3 &&
+			  (rdataset->type == dns_rdatatype_nsec3 ||
+			   rdataset->covers == dns_rdatatype_nsec3)) ||
+			 (!qpnode->nsec3 &&
+			   rdataset->type != dns_rdatatype_nsec3 &&
+			   rdataset->covers != dns_rdatatype_nsec3)));
+
+	if (qpversion == NULL) {
+		if (now == 0)
+			isc_stdtime_get(&now);
+	} else
+		now = 0;
+
+	result = dns_rdataslab_fromrdataset(rdataset, qpdb->common.mctx,
+					    &region, sizeof(rdatasetheader_t));
+	if (result != ISC_R_SUCCESS)
+		return (result);
+
+	newheader = (rdatasetheader_t *)region.base;
+	init_rdataset(newheader);
+	newheader->rdh_ttl = rdataset->ttl + now;
+	newheader->type = QPDB_RDATATYPE_VALUE(rdataset->type,
+					       rdataset->covers);
+	newheader->attributes = 0;
+	if (rdataset->ttl == 0U)
+		newheader->attributes |= RDATASET_ATTR_ZEROTTL;
+	newheader->count = init_count++;
+	newheader->trust = rdataset->trust;
+	newheader->node = qpnode;
+	if (qpversion != NULL) {
+		newheader->serial = qpversion->serial;
+		now = 0;
+	} else {
+		newheader->serial = 1;
+		if ((rdataset->attributes & DNS_RDATASETATTR_PREFETCH) != 0)
+			newheader->attributes |= RDATASET_ATTR_PREFETCH;
+		if ((rdataset->attributes & DNS_RDATASETATTR_NEGATIVE) != 0)
+			newheader->attributes |= RDATASET_ATTR_NEGATIVE;
+		if ((rdataset->attributes & DNS_RDATASETATTR_NXDOMAIN) != 0)
+			newheader->attributes |= RDATASET_ATTR_NXDOMAIN;
+		if ((rdataset->attributes & DNS_RDATASETATTR_OPTOUT) != 0)
+			newheader->attributes |= RDATASET_ATTR_OPTOUT;
+		if ((rdataset->attributes & DNS_RDATASETATTR_NOQNAME) != 0) {
+			result = addproof(qpdb, rdataset, ISC_FALSE,
+					  &newheader->noqname);
+			if (result != ISC_R_SUCCESS) {
+				free_rdataset(qpdb->common.mctx, newheader);
+				return (result);
+			}
+		}
+		if ((rdataset->attributes & DNS_RDATASETATTR_CLOSEST) != 0) {
+			result = addproof(qpdb, rdataset, ISC_TRUE,
+					  &newheader->closest);
+			if (result != ISC_R_SUCCESS) {
+				free_rdataset(qpdb->common.mctx, newheader);
+				return (result);
+			}
+		}
+	}
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	reclaim_nodes(qpdb);
+
+	result = add(qpdb, qpnode, qpversion, newheader, options, ISC_FALSE,
+		     addedrdataset, now);
+	/*
+	 * If we've added a delegation type (e.g. NS or DNAME for a zone,
+	 * just DNAME for the cache), finds of the names below must look
+	 * for it.
+	 */
+	if (result == ISC_R_SUCCESS &&
+	    delegating_type(qpdb, qpnode, rdataset->type))
+		qpnode->delegating = 1;
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	/*
+	 * Update the zone's secure status.  If version is non-NULL
+	 * this is deferred until closeversion() is called.
+	 */
+	if (result == ISC_R_SUCCESS && version == NULL && !IS_CACHE(qpdb))
+		iszonesecure(db, version, qpdb->origin_node);
+
+	return (result);
+}
+
+static isc_result_t
+subtractrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+		 dns_rdataset_t *rdataset, unsigned int options,
+		 dns_rdataset_t *newrdataset)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	qpdb_version_t *qpversion = version;
+	rdatasetheader_t *topheader, *topheader_prev, *header, *newheader;
+	unsigned char *subresult;
+	isc_region_t region;
+	isc_result_t result;
+	qpdb_changed_t *changed;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(qpversion != NULL && qpversion->qpdb == qpdb);
+
+	if (!IS_CACHE(qpdb))
+		REQUIRE(((qpnode->nsec3 &&
+			  (rdataset->type == dns_rdatatype_nsec3 ||
+			   rdataset->covers == dns_rdatatype_nsec3)) ||
+			 (!qpnode->nsec3 &&
+			   rdataset->type != dns_rdatatype_nsec3 &&
+			   rdataset->covers != dns_rdatatype_nsec3)));
+
+	result = dns_rdataslab_fromrdataset(rdataset, qpdb->common.mctx,
+					    &region, sizeof(rdatasetheader_t));
+	if (result != ISC_R_SUCCESS)
+		return (result);
+	newheader = (rdatasetheader_t *)region.base;
+	init_rdataset(newheader);
+	newheader->rdh_ttl = rdataset->ttl;
+	newheader->type = QPDB_RDATATYPE_VALUE(rdataset->type,
+					       rdataset->covers);
+	newheader->attributes = 0;
+	newheader->serial = qpversion->serial;
+	newheader->trust = 0;
+	newheader->count = init_count++;
+	newheader->node = qpnode;
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	reclaim_nodes(qpdb);
+
+	changed = add_changed(qpdb, qpversion, qpnode);
+	if (changed == NULL) {
+		free_rdataset(qpdb->common.mctx, newheader);
+		RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+		return (ISC_R_NOMEMORY);
+	}
+
+	topheader_prev = NULL;
+	for (topheader = qpnode->data;
+	     topheader != NULL;
+	     topheader = topheader->next) {
+		if (topheader->type == newheader->type)
+			break;
+		topheader_prev = topheader;
+	}
+	/*
+	 * If header isn't NULL, we've found the right type.  There may be
+	 * IGNORE rdatasets between the top of the chain and the first real
+	 * data.  We skip over them.
+	 */
+	header = topheader;
+	while (header != NULL && IGNORE(header))
+		header = header->down;
+	if (header != NULL && EXISTS(header)) {
+		unsigned int flags = 0;
+		subresult = NULL;
+		result = ISC_R_SUCCESS;
+		if ((options & DNS_DBSUB_EXACT) != 0) {
+			flags |= DNS_RDATASLAB_EXACT;
+			if (newheader->rdh_ttl != header->rdh_ttl)
+				result = DNS_R_NOTEXACT;
+		}
+		if (result == ISC_R_SUCCESS)
+			result = dns_rdataslab_subtract(
+					(unsigned char *)header,
+					(unsigned char *)newheader,
+					(unsigned int)(sizeof(*newheader)),
+					qpdb->common.mctx,
+					qpdb->common.rdclass,
+					(dns_rdatatype_t)header->type,
+					flags, &subresult);
+		if (result == ISC_R_SUCCESS) {
+			free_rdataset(qpdb->common.mctx, newheader);
+			newheader = (rdatasetheader_t *)subresult;
+			/*
+			 * dns_rdataslab_subtract() copied the reserved
+			 * portion of 'header', including its proofs, which
+			 * stay with 'header'.
+			 */
+			init_rdataset(newheader);
+			/*
+			 * We have to set the serial since the rdataslab
+			 * subtraction routine copies the reserved portion of
+			 * header, not newheader.
+			 */
+			newheader->serial = qpversion->serial;
+			update_recordsandbytes(ISC_TRUE, qpversion, newheader);
+		} else if (result == DNS_R_NXRRSET) {
+			/*
+			 * This subtraction would remove all of the rdata;
+			 * add a nonexistent header instead.
+			 */
+			free_rdataset(qpdb->common.mctx, newheader);
+			newheader = new_rdataset(qpdb->common.mctx);
+			if (newheader == NULL) {
+				result = ISC_R_NOMEMORY;
+				goto unlock;
+			}
+			newheader->rdh_ttl = 0;
+			newheader->type = topheader->type;
+			newheader->attributes = RDATASET_ATTR_NONEXISTENT;
+			newheader->trust = 0;
+			newheader->serial = qpversion->serial;
+			newheader->count = 0;
+			newheader->node = qpnode;
+		} else {
+			free_rdataset(qpdb->common.mctx, newheader);
+			goto unlock;
+		}
+
+		/*
+		 * If we're here, we want to link newheader in front of
+		 * topheader.
+		 */
+		INSIST(qpversion->serial >= topheader->serial);
+		update_recordsandbytes(ISC_FALSE, qpversion, header);
+		if (topheader_prev != NULL)
+			topheader_prev->next = newheader;
+		else
+			qpnode->data = newheader;
+		newheader->next = topheader->next;
+		newheader->down = topheader;
+		topheader->next = newheader;
+		qpnode->dirty = 1;
+		changed->dirty = ISC_TRUE;
+	} else {
+		/*
+		 * The rdataset doesn't exist, so we don't need to do anything
+		 * to satisfy the deletion request.
+		 */
+		free_rdataset(qpdb->common.mctx, newheader);
+		if ((options & DNS_DBSUB_EXACT) != 0)
+			result = DNS_R_NOTEXACT;
+		else
+			result = DNS_R_UNCHANGED;
+	}
+
+	if (result == ISC_R_SUCCESS && newrdataset != NULL)
+		bind_rdataset(qpdb, qpnode, newheader, 0, newrdataset);
+
+	if (result == DNS_R_NXRRSET && newrdataset != NULL &&
+	    (options & DNS_DBSUB_WANTOLD) != 0)
+		bind_rdataset(qpdb, qpnode, header, 0, newrdataset);
+
+ unlock:
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	/*
+	 * Update the zone's secure status.  If version is non-NULL
+	 * this is deferred until closeversion() is called.
+	 */
+	if (result == ISC_R_SUCCESS && version == NULL && !IS_CACHE(qpdb))
+		iszonesecure(db, qpdb->current_version, qpdb->origin_node);
+
+	return (result);
+}
+
+static isc_result_t
+deleterdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
+	       dns_rdatatype_t type, dns_rdatatype_t covers)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	qpdb_version_t *qpversion = version;
+	isc_result_t result;
+	rdatasetheader_t *newheader;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	if (type == dns_rdatatype_any)
+		return (ISC_R_NOTIMPLEMENTED);
+	if (type == dns_rdatatype_rrsig && covers == 0)
+		return (ISC_R_NOTIMPLEMENTED);
+
+	newheader = new_rdataset(qpdb->common.mctx);
+	if (newheader == NULL)
+		return (ISC_R_NOMEMORY);
+	newheader->rdh_ttl = 0;
+	newheader->type = QPDB_RDATATYPE_VALUE(type, covers);
+	newheader->attributes = RDATASET_ATTR_NONEXISTENT;
+	newheader->trust = 0;
+	if (qpversion != NULL)
+		newheader->serial = qpversion->serial;
+	else
+		newheader->serial = 0;
+	newheader->count = 0;
+	newheader->node = qpnode;
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	reclaim_nodes(qpdb);
+
+	result = add(qpdb, qpnode, qpversion, newheader, DNS_DBADD_FORCE,
+		     ISC_FALSE, NULL, 0);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	/*
+	 * Update the zone's secure status.  If version is non-NULL
+	 * this is deferred until closeversion() is called.
+	 */
+	if (result == ISC_R_SUCCESS && version == NULL && !IS_CACHE(qpdb))
+		iszonesecure(db, qpdb->current_version, qpdb->origin_node);
+
+	return (result);
+}
+
+static isc_result_t
+loading_addrdataset(void *arg, dns_name_t *name, dns_rdataset_t *rdataset) {
+	qpdb_load_t *loadctx = arg;
+	dns_qpdb_t *qpdb = loadctx->qpdb;
+	qpnode_t *node;
+	isc_result_t result;
+	isc_region_t region;
+	rdatasetheader_t *newheader;
+
+	REQUIRE(rdataset->rdclass == qpdb->common.rdclass);
+
+	/*
+	 * SOA records are only allowed at top of zone.
+	 */
+	if (rdataset->type == dns_rdatatype_soa &&
+	    !IS_CACHE(qpdb) && !dns_name_equal(name, &qpdb->common.origin))
+		return (DNS_R_NOTZONETOP);
+
+	if (dns_name_iswildcard(name)) {
+		/*
+		 * NS record owners cannot legally be wild cards.
+		 */
+		if (rdataset->type == dns_rdatatype_ns)
+			return (DNS_R_INVALIDNS);
+		/*
+		 * NSEC3 record owners cannot legally be wild cards.
+		 */
+		if (rdataset->type == dns_rdatatype_nsec3)
+			return (DNS_R_INVALIDNSEC3);
+	}
+
+	result = dns_rdataslab_fromrdataset(rdataset, qpdb->common.mctx,
+					    &region,
+					    sizeof(rdatasetheader_t));
+	if (result != ISC_R_SUCCESS)
+		return (result);
+	newheader = (rdatasetheader_t *)region.base;
+	init_rdataset(newheader);
+	newheader->rdh_ttl = rdataset->ttl + loadctx->now; /* XXX overflow check */
+	newheader->type = QPDB_RDATATYPE_VALUE(rdataset->type,
+					       rdataset->covers);
+	newheader->attributes = 0;
+	newheader->trust = rdataset->trust;
+	newheader->serial = 1;
+	newheader->count = init_count++;
+
+	/*
+	 * Nothing else can use the database while it is loading, but
+	 * holding the tree lock costs little and keeps add() honest.
+	 */
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	/*
+	 * Caches do not synthesize answers from wildcards.
+	 */
+	if (!IS_CACHE(qpdb) && rdataset->type != dns_rdatatype_nsec3 &&
+	    rdataset->covers != dns_rdatatype_nsec3)
+	{
+		result = add_empty_wildcards(qpdb, name);
+		if (result == ISC_R_SUCCESS && dns_name_iswildcard(name))
+			result = add_wildcard_magic(qpdb, name);
+		if (result != ISC_R_SUCCESS)
+			goto failure;
+	}
+
+	node = NULL;
+	if (rdataset->type == dns_rdatatype_nsec3 ||
+	    rdataset->covers == dns_rdatatype_nsec3)
+		result = addnode(qpdb, &qpdb->nsec3, name, &node);
+	else
+		result = addnode(qpdb, &qpdb->tree, name, &node);
+	if (result != ISC_R_SUCCESS && result != ISC_R_EXISTS)
+		goto failure;
+
+	newheader->node = node;
+	result = add(qpdb, node, qpdb->current_version, newheader,
+		     DNS_DBADD_MERGE, ISC_TRUE, NULL, 0);
+	if (result == ISC_R_SUCCESS &&
+	    delegating_type(qpdb, node, rdataset->type))
+		node->delegating = 1;
+	else if (result == DNS_R_UNCHANGED)
+		result = ISC_R_SUCCESS;
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+
+	return (result);
+
+ failure:
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+	free_rdataset(qpdb->common.mctx, newheader);
+	return (result);
+}
+
+static isc_result_t
+beginload(dns_db_t *db, dns_rdatacallbacks_t *callbacks) {
+	qpdb_load_t *loadctx;
+	dns_qpdb_t *qpdb;
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(DNS_CALLBACK_VALID(callbacks));
+	REQUIRE(VALID_QPDB(qpdb));
+
+	loadctx = isc_mem_get(qpdb->common.mctx, sizeof(*loadctx));
+	if (loadctx == NULL)
+		return (ISC_R_NOMEMORY);
+
+	loadctx->qpdb = qpdb;
+	if (IS_CACHE(qpdb))
+		isc_stdtime_get(&loadctx->now);
+	else
+		loadctx->now = 0;
+
+	RWLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	REQUIRE((qpdb->attributes & (QPDB_ATTR_LOADED|QPDB_ATTR_LOADING))
+		== 0);
+	qpdb->attributes |= QPDB_ATTR_LOADING;
+
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	callbacks->add = loading_addrdataset;
+	callbacks->add_private = loadctx;
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+endload(dns_db_t *db, dns_rdatacallbacks_t *callbacks) {
+	qpdb_load_t *loadctx;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(DNS_CALLBACK_VALID(callbacks));
+	loadctx = callbacks->add_private;
+	REQUIRE(loadctx != NULL);
+	REQUIRE(loadctx->qpdb == qpdb);
+
+	RWLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	REQUIRE((qpdb->attributes & QPDB_ATTR_LOADING) != 0);
+	REQUIRE((qpdb->attributes & QPDB_ATTR_LOADED) == 0);
+
+	qpdb->attributes &= ~QPDB_ATTR_LOADING;
+	qpdb->attributes |= QPDB_ATTR_LOADED;
+
+	RWUNLOCK(&qpdb->lock, isc_rwlocktype_write);
+
+	/*
+	 * If there's a KEY rdataset at the zone origin containing a
+	 * zone key, we consider the zone secure.
+	 */
+	if (! IS_CACHE(qpdb) && qpdb->origin_node != NULL)
+		iszonesecure(db, qpdb->current_version, qpdb->origin_node);
+
+	callbacks->add = NULL;
+	callbacks->add_private = NULL;
+
+	isc_mem_put(qpdb->common.mctx, loadctx, sizeof(*loadctx));
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+dump(dns_db_t *db, dns_dbversion_t *version, const char *filename,
+     dns_masterformat_t masterformat)
+{
+	dns_qpdb_t *qpdb;
+	qpdb_version_t *qpversion = version;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	return (dns_master_dump2(qpdb->common.mctx, db, version,
+				 &dns_master_style_default,
+				 filename, masterformat));
+}
+
+static isc_boolean_t
+issecure(dns_db_t *db) {
+	dns_qpdb_t *qpdb;
+	isc_boolean_t secure;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	secure = ISC_TF(qpdb->current_version->secure == dns_db_secure);
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	return (secure);
+}
+
+static isc_boolean_t
+isdnssec(dns_db_t *db) {
+	dns_qpdb_t *qpdb;
+	isc_boolean_t dnssec;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	dnssec = ISC_TF(qpdb->current_version->secure != dns_db_insecure);
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	return (dnssec);
+}
+
+static unsigned int
+nodecount(dns_db_t *db) {
+	dns_qpdb_t *qpdb;
+	unsigned int count;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	count = qpdb->tree.count;
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	return (count);
+}
+
+static void
+settask(dns_db_t *db, isc_task_t *task) {
+	/*
+	 * There are no events to post: nodes are freed when their last
+	 * reference goes, or by the next writer.
+	 */
+	UNUSED(db);
+	UNUSED(task);
+}
+
+static isc_boolean_t
+ispersistent(dns_db_t *db) {
+	UNUSED(db);
+	return (ISC_FALSE);
+}
+
+static isc_result_t
+getoriginnode(dns_db_t *db, dns_dbnode_t **nodep) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *onode;
+	isc_result_t result = ISC_R_SUCCESS;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(nodep != NULL && *nodep == NULL);
+
+	/*
+	 * The origin node is never removed from the trie, so it
+	 * doesn't need the tree lock.
+	 */
+	onode = qpdb->origin_node;
+	if (onode != NULL) {
+		new_reference(qpdb, onode);
+		*nodep = qpdb->origin_node;
+	} else {
+		INSIST(IS_CACHE(qpdb));
+		result = ISC_R_NOTFOUND;
+	}
+
+	return (result);
+}
+
+static isc_result_t
+getnsec3parameters(dns_db_t *db, dns_dbversion_t *version, dns_hash_t *hash,
+		   isc_uint8_t *flags, isc_uint16_t *iterations,
+		   unsigned char *salt, size_t *salt_length)
+{
+	dns_qpdb_t *qpdb;
+	isc_result_t result = ISC_R_NOTFOUND;
+	qpdb_version_t *qpversion = version;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (qpversion == NULL)
+		qpversion = qpdb->current_version;
+
+	if (qpversion->havensec3) {
+		if (hash != NULL)
+			*hash = qpversion->hash;
+		if (salt != NULL && salt_length != NULL) {
+			REQUIRE(*salt_length >= qpversion->salt_length);
+			memmove(salt, qpversion->salt,
+				qpversion->salt_length);
+		}
+		if (salt_length != NULL)
+			*salt_length = qpversion->salt_length;
+		if (iterations != NULL)
+			*iterations = qpversion->iterations;
+		if (flags != NULL)
+			*flags = qpversion->flags;
+		result = ISC_R_SUCCESS;
+	}
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	return (result);
+}
+
+static isc_result_t
+getsize(dns_db_t *db, dns_dbversion_t *version, isc_uint64_t *records,
+	isc_uint64_t *bytes)
+{
+	dns_qpdb_t *qpdb;
+	isc_result_t result = ISC_R_SUCCESS;
+	qpdb_version_t *qpversion = version;
+
+	qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	INSIST(qpversion == NULL || qpversion->qpdb == qpdb);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+	if (qpversion == NULL)
+		qpversion = qpdb->current_version;
+
+	if (records != NULL)
+		*records = qpversion->records;
+
+	if (bytes != NULL)
+		*bytes = qpversion->bytes;
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	return (result);
+}
+
+static isc_result_t
+setcachestats(dns_db_t *db, isc_stats_t *stats) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(IS_CACHE(qpdb)); /* current restriction */
+	REQUIRE(stats != NULL);
+
+	isc_stats_attach(stats, &qpdb->cachestats);
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+nodefullname(dns_db_t *db, dns_dbnode_t *node, dns_name_t *name) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)db;
+	qpnode_t *qpnode = (qpnode_t *)node;
+	dns_name_t nname;
+
+	REQUIRE(VALID_QPDB(qpdb));
+	REQUIRE(node != NULL);
+	REQUIRE(name != NULL);
+
+	/*
+	 * The name of a node never changes, and the caller's reference
+	 * keeps the node in place.
+	 */
+	nodename(qpnode, &nname);
+	return (dns_name_copy(&nname, name, NULL));
+}
+
+static dns_dbmethods_t zone_methods = {
+	attach,
+	detach,
+	beginload,
+	endload,
+	NULL,
+	dump,
+	currentversion,
+	newversion,
+	attachversion,
+	closeversion,
+	findnode,
+	zone_find,
+	zone_findzonecut,
+	attachnode,
+	detachnode,
+	expirenode,
+	printnode,
+	createiterator,
+	zone_findrdataset,
+	allrdatasets,
+	addrdataset,
+	subtractrdataset,
+	deleterdataset,
+	issecure,
+	nodecount,
+	ispersistent,
+	overmem,
+	settask,
+	getoriginnode,
+	NULL,
+	getnsec3parameters,
+	findnsec3node,
+	NULL,
+	NULL,
+	NULL,
+	isdnssec,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	nodefullname,
+	getsize,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+static dns_dbmethods_t cache_methods = {
+	attach,
+	detach,
+	beginload,
+	endload,
+	NULL,
+	dump,
+	currentversion,
+	newversion,
+	attachversion,
+	closeversion,
+	findnode,
+	cache_find,
+	cache_findzonecut,
+	attachnode,
+	detachnode,
+	expirenode,
+	printnode,
+	createiterator,
+	cache_findrdataset,
+	allrdatasets,
+	addrdataset,
+	subtractrdataset,
+	deleterdataset,
+	issecure,
+	nodecount,
+	ispersistent,
+	overmem,
+	settask,
+	getoriginnode,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	isdnssec,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	setcachestats,
+	NULL,
+	nodefullname,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+isc_result_t
+dns_qpdb_create(isc_mem_t *mctx, dns_name_t *origin, dns_dbtype_t type,
+		dns_rdataclass_t rdclass, unsigned int argc, char *argv[],
+		void *driverarg, dns_db_t **dbp)
+{
+	dns_qpdb_t *qpdb;
+	isc_result_t result;
+
+	/* Keep the compiler happy. */
+	UNUSED(argc);
+	UNUSED(argv);
+	UNUSED(driverarg);
+
+	REQUIRE(dbp != NULL && *dbp == NULL);
+
+	qpdb = isc_mem_get(mctx, sizeof(*qpdb));
+	if (qpdb == NULL)
+		return (ISC_R_NOMEMORY);
+
+	memset(qpdb, '\0', sizeof(*qpdb));
+	dns_name_init(&qpdb->common.origin, NULL);
+	qpdb->common.attributes = 0;
+	if (type == dns_dbtype_cache) {
+		qpdb->common.methods = &cache_methods;
+		qpdb->common.attributes |= DNS_DBATTR_CACHE;
+	} else if (type == dns_dbtype_stub) {
+		qpdb->common.methods = &zone_methods;
+		qpdb->common.attributes |= DNS_DBATTR_STUB;
+	} else
+		qpdb->common.methods = &zone_methods;
+	qpdb->common.rdclass = rdclass;
+	qpdb->common.mctx = NULL;
+
+	ISC_LIST_INIT(qpdb->common.update_listeners);
+
+	result = isc_rwlock_init(&qpdb->lock, 0, 0);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup_qpdb;
+
+	result = isc_rwlock_init(&qpdb->tree_lock, 0, 0);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup_lock;
+
+	result = isc_mutex_init(&qpdb->deadlock);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup_tree_lock;
+
+	result = isc_refcount_init(&qpdb->references, 1);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup_deadlock;
+
+	qpdb->current_version = allocate_version(mctx, 1, 1, ISC_FALSE);
+	if (qpdb->current_version == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto cleanup_references;
+	}
+
+	/*
+	 * Attach to the mctx.  The database will persist so long as there
+	 * are references to it, and attaching to the mctx ensures that our
+	 * mctx won't disappear out from under us.
+	 */
+	isc_mem_attach(mctx, &qpdb->common.mctx);
+
+	/*
+	 * Must be initialized before free_qpdb() is called.
+	 */
+	isc_ondestroy_init(&qpdb->common.ondest);
+
+	/*
+	 * Version Initialization.
+	 */
+	qpdb->current_serial = 1;
+	qpdb->least_serial = 1;
+	qpdb->next_serial = 2;
+	qpdb->current_version->qpdb = qpdb;
+	qpdb->current_version->secure = dns_db_insecure;
+	qpdb->current_version->havensec3 = ISC_FALSE;
+	qpdb->current_version->flags = 0;
+	qpdb->current_version->iterations = 0;
+	qpdb->current_version->hash = 0;
+	qpdb->current_version->salt_length = 0;
+	memset(qpdb->current_version->salt, 0,
+	       sizeof(qpdb->current_version->salt));
+	qpdb->current_version->records = 0;
+	qpdb->current_version->bytes = 0;
+	qpdb->future_version = NULL;
+	ISC_LIST_INIT(qpdb->open_versions);
+	/*
+	 * Keep the current version in the open list so that list operation
+	 * won't happen in normal lookup operations.
+	 */
+	PREPEND(qpdb->open_versions, qpdb->current_version, link);
+
+	qpdb->common.magic = DNS_DB_MAGIC;
+	qpdb->common.impmagic = QPDB_MAGIC;
+
+	/*
+	 * From here on free_qpdb() cleans up.
+	 */
+
+	/*
+	 * Make a copy of the origin name.
+	 */
+	result = dns_name_dupwithoffsets(origin, mctx, &qpdb->common.origin);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup;
+
+	/*
+	 * In order to set the delegating bit correctly in zone databases,
+	 * we need to know if the node has the origin name of the zone.
+	 * We explicitly create a node for the zone's origin, and then
+	 * we simply remember the node's address.  This is safe, because
+	 * the top-of-zone node is never deleted, nor does its address
+	 * change.
+	 *
+	 * An apex node in the NSEC3 trie makes NSEC3 searches return
+	 * partial matches even when there is only a single NSEC3 record
+	 * in the trie.
+	 */
+	if (!IS_CACHE(qpdb)) {
+		result = addnode(qpdb, &qpdb->tree, &qpdb->common.origin,
+				 &qpdb->origin_node);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup;
+		result = addnode(qpdb, &qpdb->nsec3, &qpdb->common.origin,
+				 &qpdb->nsec3_origin_node);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup;
+	}
+
+	*dbp = (dns_db_t *)qpdb;
+
+	return (ISC_R_SUCCESS);
+
+ cleanup:
+	isc_refcount_decrement(&qpdb->references, NULL);
+	free_qpdb(qpdb);
+	return (result);
+
+ cleanup_references:
+	isc_refcount_decrement(&qpdb->references, NULL);
+	isc_refcount_destroy(&qpdb->references);
+ cleanup_deadlock:
+	DESTROYLOCK(&qpdb->deadlock);
+ cleanup_tree_lock:
+	isc_rwlock_destroy(&qpdb->tree_lock);
+ cleanup_lock:
+	isc_rwlock_destroy(&qpdb->lock);
+ cleanup_qpdb:
+	isc_mem_put(mctx, qpdb, sizeof(*qpdb));
+	return (result);
+}
+
+/*
+ * Slabbed Rdataset Methods
+ */
+
+static void
+rdataset_disassociate(dns_rdataset_t *rdataset) {
+	dns_db_t *db = rdataset->private1;
+	dns_dbnode_t *node = rdataset->private2;
+
+	detachnode(db, &node);
+}
+
+static isc_result_t
+rdataset_first(dns_rdataset_t *rdataset) {
+	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
+	unsigned int count;
+
+	count = raw[0] * 256 + raw[1];
+	if (count == 0) {
+		rdataset->private5 = NULL;
+		return (ISC_R_NOMORE);
+	}
+
+#if DNS_RDATASET_FIXED
+	if ((rdataset->attributes & DNS_RDATASETATTR_LOADORDER) == 0)
+		raw += 2 + (4 * count);
+	else
+#endif
+		raw += 2;
+
+	/*
+	 * The privateuint4 field is the number of rdata beyond the
+	 * cursor position, so we decrement the total count by one
+	 * before storing it.
+	 *
+	 * If DNS_RDATASETATTR_LOADORDER is not set 'raw' points to the
+	 * first record.  If DNS_RDATASETATTR_LOADORDER is set 'raw' points
+	 * to the first entry in the offset table.
+	 */
+	count--;
+	rdataset->privateuint4 = count;
+	rdataset->private5 = raw;
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+rdataset_next(dns_rdataset_t *rdataset) {
+	unsigned int count;
+	unsigned int length;
+	unsigned char *raw;     /* RDATASLAB */
+
+	count = rdataset->privateuint4;
+	if (count == 0)
+		return (ISC_R_NOMORE);
+	count--;
+	rdataset->privateuint4 = count;
+
+	/*
+	 * Skip forward one record (length + 4) or one offset (4).
+	 */
+	raw = rdataset->private5;
+#if DNS_RDATASET_FIXED
+	if ((rdataset->attributes & DNS_RDATASETATTR_LOADORDER) == 0) {
+#endif
+		length = raw[0] * 256 + raw[1];
+		raw += length;
+#if DNS_RDATASET_FIXED
+	}
+	rdataset->private5 = raw + 4;           /* length(2) + order(2) */
+#else
+	rdataset->private5 = raw + 2;           /* length(2) */
+#endif
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+rdataset_current(dns_rdataset_t *rdataset, dns_rdata_t *rdata) {
+	unsigned char *raw = rdataset->private5;        /* RDATASLAB */
+#if DNS_RDATASET_FIXED
+	unsigned int offset;
+#endif
+	unsigned int length;
+	isc_region_t r;
+	unsigned int flags = 0;
+
+	REQUIRE(raw != NULL);
+
+	/*
+	 * Find the start of the record if not already in private5
+	 * then skip the length and order fields.
+	 */
+#if DNS_RDATASET_FIXED
+	if ((rdataset->attributes & DNS_RDATASETATTR_LOADORDER) != 0) {
+		offset = (raw[0] << 24) + (raw[1] << 16) +
+			 (raw[2] << 8) + raw[3];
+		raw = rdataset->private3;
+		raw += offset;
+	}
+#endif
+	length = raw[0] * 256 + raw[1];
+#if DNS_RDATASET_FIXED
+	raw += 4;
+#else
+	raw += 2;
+#endif
+	if (rdataset->type == dns_rdatatype_rrsig) {
+		if (*raw & DNS_RDATASLAB_OFFLINE)
+			flags |= DNS_RDATA_OFFLINE;
+		length--;
+		raw++;
+	}
+	r.length = length;
+	r.base = raw;
+	dns_rdata_fromregion(rdata, rdataset->rdclass, rdataset->type, &r);
+	rdata->flags |= flags;
+}
+
+static void
+rdataset_clone(dns_rdataset_t *source, dns_rdataset_t *target) {
+	dns_db_t *db = source->private1;
+	dns_dbnode_t *node = source->private2;
+	dns_dbnode_t *cloned_node = NULL;
+
+	attachnode(db, node, &cloned_node);
+	INSIST(!ISC_LINK_LINKED(target, link));
+	*target = *source;
+	ISC_LINK_INIT(target, link);
+
+	/*
+	 * Reset iterator state.
+	 */
+	target->privateuint4 = 0;
+	target->private5 = NULL;
+}
+
+static unsigned int
+rdataset_count(dns_rdataset_t *rdataset) {
+	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
+	unsigned int count;
+
+	count = raw[0] * 256 + raw[1];
+
+	return (count);
+}
+
+/*%
+ * Bind 'nsec' and 'nsecsig' to the proof of nonexistence 'proof' kept
+ * with 'rdataset'.
+ */
+static void
+bind_proof(dns_rdataset_t *rdataset, struct noqname *proof,
+	   dns_name_t *name, dns_rdataset_t *nsec, dns_rdataset_t *nsecsig)
+{
+	dns_db_t *db = rdataset->private1;
+	dns_dbnode_t *node = rdataset->private2;
+	dns_dbnode_t *cloned_node;
+
+	cloned_node = NULL;
+	attachnode(db, node, &cloned_node);
+	nsec->methods = &slab_methods;
+	nsec->rdclass = db->rdclass;
+	nsec->type = proof->type;
+	nsec->covers = 0;
+	nsec->ttl = rdataset->ttl;
+	nsec->trust = rdataset->trust;
+	nsec->private1 = rdataset->private1;
+	nsec->private2 = rdataset->private2;
+	nsec->private3 = proof->neg;
+	nsec->privateuint4 = 0;
+	nsec->private5 = NULL;
+	nsec->private6 = NULL;
+	nsec->private7 = NULL;
+
+	cloned_node = NULL;
+	attachnode(db, node, &cloned_node);
+	nsecsig->methods = &slab_methods;
+	nsecsig->rdclass = db->rdclass;
+	nsecsig->type = dns_rdatatype_rrsig;
+	nsecsig->covers = proof->type;
+	nsecsig->ttl = rdataset->ttl;
+	nsecsig->trust = rdataset->trust;
+	nsecsig->private1 = rdataset->private1;
+	nsecsig->private2 = rdataset->private2;
+	nsecsig->private3 = proof->negsig;
+	nsecsig->privateuint4 = 0;
+	nsecsig->private5 = NULL;
+	nsecsig->private6 = NULL;
+	nsecsig->private7 = NULL;
+
+	dns_name_clone(&proof->name, name);
+}
+
+static isc_result_t
+rdataset_getnoqname(dns_rdataset_t *rdataset, dns_name_t *name,
+		    dns_rdataset_t *nsec, dns_rdataset_t *nsecsig)
+{
+	bind_proof(rdataset, rdataset->private6, name, nsec, nsecsig);
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+rdataset_getclosest(dns_rdataset_t *rdataset, dns_name_t *name,
+		    dns_rdataset_t *nsec, dns_rdataset_t *nsecsig)
+{
+	bind_proof(rdataset, rdataset->private7, name, nsec, nsecsig);
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+rdataset_settrust(dns_rdataset_t *rdataset, dns_trust_t trust) {
+	dns_qpdb_t *qpdb = rdataset->private1;
+	rdatasetheader_t *header = rdataset->private3;
+
+	header--;
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+	header->trust = rdataset->trust = trust;
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+}
+
+static void
+rdataset_expire(dns_rdataset_t *rdataset) {
+	dns_qpdb_t *qpdb = rdataset->private1;
+	rdatasetheader_t *header = rdataset->private3;
+
+	header--;
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+	header->rdh_ttl = 0;
+	mark_stale_header(header);
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+}
+
+static void
+rdataset_clearprefetch(dns_rdataset_t *rdataset) {
+	dns_qpdb_t *qpdb = rdataset->private1;
+	rdatasetheader_t *header = rdataset->private3;
+
+	header--;
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+	header->attributes &= ~RDATASET_ATTR_PREFETCH;
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_write);
+}
+
+/*
+ * Rdataset Iterator Methods
+ */
+
+static void
+rdatasetiter_destroy(dns_rdatasetiter_t **iteratorp) {
+	qpdb_rdatasetiter_t *qpiterator;
+
+	qpiterator = (qpdb_rdatasetiter_t *)(*iteratorp);
+
+	if (qpiterator->common.version != NULL)
+		closeversion(qpiterator->common.db,
+			     &qpiterator->common.version, ISC_FALSE);
+	detachnode(qpiterator->common.db, &qpiterator->common.node);
+	isc_mem_put(qpiterator->common.db->mctx, qpiterator,
+		    sizeof(*qpiterator));
+
+	*iteratorp = NULL;
+}
+
+static isc_result_t
+rdatasetiter_first(dns_rdatasetiter_t *iterator) {
+	qpdb_rdatasetiter_t *qpiterator = (qpdb_rdatasetiter_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)(qpiterator->common.db);
+	qpnode_t *qpnode = qpiterator->common.node;
+	qpdb_version_t *qpversion = qpiterator->common.version;
+	rdatasetheader_t *header, *top_next;
+	qpdb_serial_t serial;
+	isc_stdtime_t now;
+
+	if (IS_CACHE(qpdb)) {
+		serial = 1;
+		now = qpiterator->common.now;
+	} else {
+		serial = qpversion->serial;
+		now = 0;
+	}
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	for (header = qpnode->data; header != NULL; header = top_next) {
+		top_next = header->next;
+		do {
+			if (header->serial <= serial && !IGNORE(header)) {
+				/*
+				 * Is this a "this rdataset doesn't exist"
+				 * record?  Or is it too old in the cache?
+				 *
+				 * Note: unlike everywhere else, we
+				 * check for now > header->rdh_ttl instead
+				 * of now >= header->rdh_ttl.  This allows
+				 * ANY and RRSIG queries for 0 TTL
+				 * rdatasets to work.
+				 */
+				if (NONEXISTENT(header) ||
+				    (now != 0 && now > header->rdh_ttl))
+					header = NULL;
+				break;
+			} else
+				header = header->down;
+		} while (header != NULL);
+		if (header != NULL)
+			break;
+	}
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	qpiterator->current = header;
+
+	if (header == NULL)
+		return (ISC_R_NOMORE);
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+rdatasetiter_next(dns_rdatasetiter_t *iterator) {
+	qpdb_rdatasetiter_t *qpiterator = (qpdb_rdatasetiter_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)(qpiterator->common.db);
+	qpdb_version_t *qpversion = qpiterator->common.version;
+	rdatasetheader_t *header, *top_next;
+	qpdb_serial_t serial;
+	isc_stdtime_t now;
+	qpdb_rdatatype_t type, negtype;
+	dns_rdatatype_t rdtype, covers;
+
+	header = qpiterator->current;
+	if (header == NULL)
+		return (ISC_R_NOMORE);
+
+	if (IS_CACHE(qpdb)) {
+		serial = 1;
+		now = qpiterator->common.now;
+	} else {
+		serial = qpversion->serial;
+		now = 0;
+	}
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	type = header->type;
+	rdtype = QPDB_RDATATYPE_BASE(header->type);
+	if (NEGATIVE(header)) {
+		covers = QPDB_RDATATYPE_EXT(header->type);
+		negtype = QPDB_RDATATYPE_VALUE(covers, 0);
+	} else
+		negtype = QPDB_RDATATYPE_VALUE(0, rdtype);
+	for (header = header->next; header != NULL; header = top_next) {
+		top_next = header->next;
+		/*
+		 * If not walking back up the down list.
+		 */
+		if (header->type != type && header->type != negtype) {
+			do {
+				if (header->serial <= serial &&
+				    !IGNORE(header)) {
+					/*
+					 * Is this a "this rdataset doesn't
+					 * exist" record?
+					 *
+					 * Note: unlike everywhere else, we
+					 * check for now > header->ttl instead
+					 * of now >= header->ttl.  This allows
+					 * ANY and RRSIG queries for 0 TTL
+					 * rdatasets to work.
+					 */
+					if (NONEXISTENT(header) ||
+					    (now != 0 && now > header->rdh_ttl))
+						header = NULL;
+					break;
+				} else
+					header = header->down;
+			} while (header != NULL);
+			if (header != NULL)
+				break;
+		}
+	}
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	qpiterator->current = header;
+
+	if (header == NULL)
+		return (ISC_R_NOMORE);
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+rdatasetiter_current(dns_rdatasetiter_t *iterator, dns_rdataset_t *rdataset) {
+	qpdb_rdatasetiter_t *qpiterator = (qpdb_rdatasetiter_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)(qpiterator->common.db);
+	qpnode_t *qpnode = qpiterator->common.node;
+	rdatasetheader_t *header;
+
+	header = qpiterator->current;
+	REQUIRE(header != NULL);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	bind_rdataset(qpdb, qpnode, header, qpiterator->common.now,
+		      rdataset);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+}
+
+/*
+ * Database Iterator Methods
+ */
+
+/*%
+ * Move 'qpdbiter' to 'node', which may be NULL, returning the node it
+ * was on.  The caller must be holding the tree lock, and must release
+ * the iterator's reference to the node returned with detachnode() once
+ * it has let go of the lock, so that the node can be cleaned up then if
+ * that was the last reference.
+ */
+static inline dns_dbnode_t *
+setiternode(qpdb_dbiterator_t *qpdbiter, qpnode_t *node) {
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)qpdbiter->common.db;
+	qpnode_t *old = qpdbiter->node;
+
+	if (node != NULL)
+		new_reference(qpdb, node);
+	qpdbiter->node = node;
+
+	return (old);
+}
+
+static void
+dbiterator_destroy(dns_dbiterator_t **iteratorp) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)(*iteratorp);
+	dns_db_t *db = NULL;
+	dns_dbnode_t *node;
+
+	if (qpdbiter->node != NULL) {
+		node = qpdbiter->node;
+		qpdbiter->node = NULL;
+		detachnode(qpdbiter->common.db, &node);
+	}
+
+	dns_db_attach(qpdbiter->common.db, &db);
+	dns_db_detach(&qpdbiter->common.db);
+
+	isc_mem_put(db->mctx, qpdbiter, sizeof(*qpdbiter));
+	dns_db_detach(&db);
+
+	*iteratorp = NULL;
+}
+
+static isc_result_t
+dbiterator_first(dns_dbiterator_t *iterator) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qpnode_t *node;
+	dns_dbnode_t *old;
+	isc_result_t result;
+
+	if (qpdbiter->result != ISC_R_SUCCESS &&
+	    qpdbiter->result != ISC_R_NOTFOUND &&
+	    qpdbiter->result != DNS_R_PARTIALMATCH &&
+	    qpdbiter->result != ISC_R_NOMORE)
+		return (qpdbiter->result);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (qpdbiter->nsec3only)
+		node = qp_first(&qpdb->nsec3);
+	else {
+		node = qp_first(&qpdb->tree);
+		if (!qpdbiter->nonsec3 && node == NULL)
+			node = qp_first(&qpdb->nsec3);
+	}
+	old = setiternode(qpdbiter, node);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (old != NULL)
+		detachnode(iterator->db, &old);
+
+	result = (node != NULL) ? ISC_R_SUCCESS : ISC_R_NOMORE;
+	qpdbiter->result = result;
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_last(dns_dbiterator_t *iterator) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qpnode_t *node = NULL;
+	dns_dbnode_t *old;
+	isc_result_t result;
+
+	if (qpdbiter->result != ISC_R_SUCCESS &&
+	    qpdbiter->result != ISC_R_NOTFOUND &&
+	    qpdbiter->result != DNS_R_PARTIALMATCH &&
+	    qpdbiter->result != ISC_R_NOMORE)
+		return (qpdbiter->result);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (qpdbiter->nsec3only && !qpdbiter->nonsec3)
+		node = qp_last(&qpdb->nsec3);
+	if (!qpdbiter->nsec3only && node == NULL)
+		node = qp_last(&qpdb->tree);
+	old = setiternode(qpdbiter, node);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (old != NULL)
+		detachnode(iterator->db, &old);
+
+	result = (node != NULL) ? ISC_R_SUCCESS : ISC_R_NOMORE;
+	qpdbiter->result = result;
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_seek(dns_dbiterator_t *iterator, dns_name_t *name) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qp_trie_t *trie;
+	qpnode_t *node;
+	qp_key_t key;
+	unsigned int nancestors;
+	dns_dbnode_t *old;
+	isc_result_t result;
+
+	if (qpdbiter->result != ISC_R_SUCCESS &&
+	    qpdbiter->result != ISC_R_NOTFOUND &&
+	    qpdbiter->result != DNS_R_PARTIALMATCH &&
+	    qpdbiter->result != ISC_R_NOMORE)
+		return (qpdbiter->result);
+
+	qp_namekey(name, &key);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	trie = qpdbiter->nsec3only ? &qpdb->nsec3 : &qpdb->tree;
+	nancestors = 0;
+	node = qp_lookup(trie, &key, NULL, &nancestors);
+	if (node == NULL && !qpdbiter->nsec3only && !qpdbiter->nonsec3) {
+		/*
+		 * Stay on the main trie if the name is in neither.
+		 */
+		node = qp_lookup(&qpdb->nsec3, &key, NULL, NULL);
+	}
+	if (node != NULL)
+		result = ISC_R_SUCCESS;
+	else if (nancestors != 0) {
+		/*
+		 * Like rbtdb.c, leave the iterator at the name before
+		 * the one sought.
+		 */
+		result = DNS_R_PARTIALMATCH;
+		node = qp_neighbor(trie, &key, ISC_FALSE, ISC_FALSE);
+		INSIST(node != NULL);
+	} else
+		result = ISC_R_NOTFOUND;
+	old = setiternode(qpdbiter, node);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (old != NULL)
+		detachnode(iterator->db, &old);
+
+	qpdbiter->result = (result == DNS_R_PARTIALMATCH) ?
+			   ISC_R_SUCCESS : result;
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_prev(dns_dbiterator_t *iterator) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qpnode_t *node;
+	qp_key_t key;
+	dns_dbnode_t *old;
+	isc_result_t result;
+
+	REQUIRE(qpdbiter->node != NULL);
+
+	if (qpdbiter->result != ISC_R_SUCCESS)
+		return (qpdbiter->result);
+
+	nodekey(qpdbiter->node, &key);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	node = qp_neighbor(nodetrie(qpdb, qpdbiter->node), &key,
+			   ISC_FALSE, ISC_FALSE);
+	if (node == NULL && qpdbiter->node->nsec3 &&
+	    !qpdbiter->nsec3only && !qpdbiter->nonsec3)
+		node = qp_last(&qpdb->tree);
+	old = setiternode(qpdbiter, node);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (old != NULL)
+		detachnode(iterator->db, &old);
+
+	result = (node != NULL) ? ISC_R_SUCCESS : ISC_R_NOMORE;
+	qpdbiter->result = result;
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_next(dns_dbiterator_t *iterator) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qpnode_t *node;
+	qp_key_t key;
+	dns_dbnode_t *old;
+	isc_result_t result;
+
+	REQUIRE(qpdbiter->node != NULL);
+
+	if (qpdbiter->result != ISC_R_SUCCESS)
+		return (qpdbiter->result);
+
+	nodekey(qpdbiter->node, &key);
+
+	RWLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	node = qp_neighbor(nodetrie(qpdb, qpdbiter->node), &key,
+			   ISC_TRUE, ISC_FALSE);
+	if (node == NULL && !qpdbiter->node->nsec3 &&
+	    !qpdbiter->nsec3only && !qpdbiter->nonsec3)
+		node = qp_first(&qpdb->nsec3);
+	old = setiternode(qpdbiter, node);
+
+	RWUNLOCK(&qpdb->tree_lock, isc_rwlocktype_read);
+
+	if (old != NULL)
+		detachnode(iterator->db, &old);
+
+	result = (node != NULL) ? ISC_R_SUCCESS : ISC_R_NOMORE;
+	qpdbiter->result = result;
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_current(dns_dbiterator_t *iterator, dns_dbnode_t **nodep,
+		   dns_name_t *name)
+{
+	dns_qpdb_t *qpdb = (dns_qpdb_t *)iterator->db;
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+	qpnode_t *node = qpdbiter->node;
+	isc_result_t result;
+	dns_name_t nname;
+
+	REQUIRE(qpdbiter->result == ISC_R_SUCCESS);
+	REQUIRE(qpdbiter->node != NULL);
+
+	/*
+	 * Names are always absolute: dbiterator_origin() is the root.
+	 */
+	if (name != NULL) {
+		nodename(node, &nname);
+		result = dns_name_copy(&nname, name, NULL);
+		if (result != ISC_R_SUCCESS)
+			return (result);
+	} else
+		result = ISC_R_SUCCESS;
+
+	new_reference(qpdb, node);
+
+	*nodep = qpdbiter->node;
+
+	/*
+	 * The node is cleaned up when the iterator and the caller have
+	 * both let go of it.
+	 */
+	if (iterator->cleaning)
+		(void)expirenode(iterator->db, *nodep, 0);
+
+	return (result);
+}
+
+static isc_result_t
+dbiterator_pause(dns_dbiterator_t *iterator) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+
+	/*
+	 * No lock is held between calls.
+	 */
+	if (qpdbiter->result != ISC_R_SUCCESS &&
+	    qpdbiter->result != ISC_R_NOTFOUND &&
+	    qpdbiter->result != DNS_R_PARTIALMATCH &&
+	    qpdbiter->result != ISC_R_NOMORE)
+		return (qpdbiter->result);
+
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+dbiterator_origin(dns_dbiterator_t *iterator, dns_name_t *name) {
+	qpdb_dbiterator_t *qpdbiter = (qpdb_dbiterator_t *)iterator;
+
+	if (qpdbiter->result != ISC_R_SUCCESS)
+		return (qpdbiter->result);
+
+	return (dns_name_copy(dns_rootname, name, NULL));
+}
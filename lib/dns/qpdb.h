@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DNS_QPDB_H
+#define DNS_QPDB_H 1
+
+#include <isc/lang.h>
+#include <dns/types.h>
+
+/*****
+ ***** Module Info
+ *****/
+
+/*! \file
+ * \brief
+ * DNS qp-trie DB Implementation
+ */
+
+ISC_LANG_BEGINDECLS
+
+isc_result_t
+dns_qpdb_create(isc_mem_t *mctx, dns_name_t *base, dns_dbtype_t type,
+		dns_rdataclass_t rdclass, unsigned int argc, char *argv[],
+		void *driverarg, dns_db_t **dbp);
+
+/*%<
+ * Create a new database of type "qp".  Called via dns_db_create(); see
+ * documentation for that function for more details.
+ *
+ * Databases of this type can be used for zones, including stub zones,
+ * and for caches, but not for zones loaded from the "map" format,
+ * zones that are automatically re-signed or response policy zones.
+ * 'argc', 'argv' and 'driverarg' are ignored.
+ */
+
+ISC_LANG_ENDDECLS
+
+#endif /* DNS_QPDB_H */
@@ -62,13 +62,52 @@
 #define CHAIN_MAGIC             ISC_MAGIC('0', '-', '0', '-')
 #define VALID_CHAIN(chain)      ISC_MAGIC_VALID(chain, CHAIN_MAGIC)
 
-#define RBT_HASH_SIZE           64
+#define RBT_HASH_SIZE           64	/*%< must be a power of 2 */
+#define RBT_HASH_MOVE           8	/*%< slots moved per addition */
+#define RBT_HASH_CLEAR          32	/*%< slots cleared per addition */
 
 #ifdef RBT_MEM_TEST
 #undef RBT_HASH_SIZE
 #define RBT_HASH_SIZE 2 /*%< To give the reallocation code a workout. */
 #endif
 
+/*%
+ * The name hash is an open-addressing table with linear probing.  Each
+ * slot holds the hash value of its node next to the node pointer, so
+ * probing a slot only touches the node itself when the hash values
+ * match.  Removing an entry shifts the entries that follow it back
+ * into place, so the table never fills up with deleted entries.
+ *
+ * The table is kept no more than 3/4 full.  Growing it is spread over
+ * many additions rather than done all at once while the tree is locked:
+ * once the table is half full, a table twice the size is allocated and
+ * RBT_HASH_CLEAR of its slots are cleared on each addition.  When the
+ * current table is full, the new one replaces it, and the entries of
+ * the old one are moved over RBT_HASH_MOVE slots at a time on each
+ * later addition.  Until the move is complete, lookups try the new
+ * table and then the old one, and the slots already moved out of the
+ * old table are marked HASH_MOVED so that probing carries on past them.
+ */
+typedef struct {
+	unsigned int		hashval;
+	dns_rbtnode_t *		node;	/*%< NULL if the slot is empty */
+} rbt_hashslot_t;
+
+static unsigned char		hash_moved;
+#define HASH_MOVED		((dns_rbtnode_t *)&hash_moved)
+#define HASH_MAXLOAD(size)	((size) / 4 * 3)
+
+/*%
+ * The home slot of a hash value in a table of mask + 1 slots.  Name
+ * hashes of similar names differ little in their low bits, and with a
+ * power-of-two table (unlike the prime-ish sizes a chained table can
+ * use) that would leave long runs of occupied slots, so the value is
+ * mixed with a Fibonacci multiplier first.
+ */
+#define HASH_HOME(hashval, mask) \
+	((size_t)(((isc_uint64_t)(hashval) * 0x9E3779B97F4A7C15ULL) >> 32) & \
+	 (mask))
+
 struct dns_rbt {
 	unsigned int		magic;
 	isc_mem_t *		mctx;
@@ -76,8 +115,16 @@ struct dns_rbt {
 	void			(*data_deleter)(void *, void *);
 	void *			deleter_arg;
 	unsigned int		nodecount;
-	size_t			hashsize;
-	dns_rbtnode_t **	hashtable;
+	size_t			hashsize;	/*%< slots, a power of 2 */
+	size_t			hashcount;	/*%< entries */
+	rbt_hashslot_t *	hashtable;
+	size_t			oldhashsize;
+	size_t			oldhashcount;	/*%< entries not moved yet */
+	size_t			oldhashnext;	/*%< next slot to move */
+	rbt_hashslot_t *	oldhashtable;	/*%< being moved, or NULL */
+	size_t			nexthashsize;
+	size_t			nexthashclear;	/*%< slots cleared so far */
+	rbt_hashslot_t *	nexthashtable;	/*%< being cleared, or NULL */
 	void *			mmap_location;
 };
 
@@ -208,7 +255,6 @@ getdata(dns_rbtnode_t *node, file_header_t *header) {
 #endif /* DNS_RBT_USEHASH */
 #define DATA(node)              ((node)->data)
 #define IS_EMPTY(node)          ((node)->data == NULL)
-#define HASHNEXT(node)          ((node)->hashnext)
 #define HASHVAL(node)           ((node)->hashval)
 #define COLOR(node)             ((node)->color)
 #define NAMELEN(node)           ((node)->namelen)
@@ -429,12 +475,18 @@ static inline void
 hash_node(dns_rbt_t *rbt, dns_rbtnode_t *node, dns_name_t *name);
 static inline void
 unhash_node(dns_rbt_t *rbt, dns_rbtnode_t *node);
+static dns_rbtnode_t *
+hash_lookup(rbt_hashslot_t *table, size_t size, unsigned int hash,
+	    dns_rbtnode_t *upper, dns_name_t *name);
+static isc_result_t
+hash_reserve(dns_rbt_t *rbt, size_t count);
 static void
-rehash(dns_rbt_t *rbt, unsigned int newcount);
+freehash(dns_rbt_t *rbt);
 #else
 #define hash_node(rbt, node, name)
 #define unhash_node(rbt, node)
-#define rehash(rbt, newcount)
+#define hash_reserve(rbt, count) ISC_R_SUCCESS
+#define freehash(rbt)
 #endif
 
 static inline void
@@ -944,7 +996,7 @@ dns_rbt_deserialize_tree(void *base_address, size_t filesize,
 		result = ISC_R_INVALIDFILE;
 		goto cleanup;
 	}
-	rehash(rbt, header->nodecount);
+	CHECK(hash_reserve(rbt, header->nodecount));
 
 	CHECK(treefix(rbt, base_address, filesize, rbt->root,
 		      dns_rootname, datafixer, fixer_arg, &crc));
@@ -1011,6 +1063,14 @@ dns_rbt_create(isc_mem_t *mctx, dns_rbtdeleter_t deleter,
 	rbt->nodecount = 0;
 	rbt->hashtable = NULL;
 	rbt->hashsize = 0;
+	rbt->hashcount = 0;
+	rbt->oldhashtable = NULL;
+	rbt->oldhashsize = 0;
+	rbt->oldhashcount = 0;
+	rbt->oldhashnext = 0;
+	rbt->nexthashtable = NULL;
+	rbt->nexthashsize = 0;
+	rbt->nexthashclear = 0;
 	rbt->mmap_location = NULL;
 
 #ifdef DNS_RBT_USEHASH
@@ -1052,9 +1112,7 @@ dns_rbt_destroy2(dns_rbt_t **rbtp, unsigned int quantum) {
 
 	rbt->mmap_location = NULL;
 
-	if (rbt->hashtable != NULL)
-		isc_mem_put(rbt->mctx, rbt->hashtable,
-			    rbt->hashsize * sizeof(dns_rbtnode_t *));
+	freehash(rbt);
 
 	rbt->magic = 0;
 
@@ -1184,6 +1242,15 @@ dns_rbt_addnode(dns_rbt_t *rbt, dns_name_t *name, dns_rbtnode_t **nodep) {
 	 * comparisons.
 	 */
 
+	/*
+	 * Make room in the hash table for the (up to) two nodes this
+	 * may add, so that hashing them cannot fail once the tree has
+	 * been changed.
+	 */
+	result = hash_reserve(rbt, 2);
+	if (result != ISC_R_SUCCESS)
+		return (result);
+
 	/*
 	 * Create a copy of the name so the original name structure is
 	 * not modified.
@@ -1618,32 +1685,16 @@ dns_rbt_findnode(dns_rbt_t *rbt, const dns_name_t *name, dns_name_t *foundname,
 						  tlabels, &hash_name);
 
 			/*
-			 * Walk all the nodes in the hash bucket pointed
-			 * by the computed hash value.
+			 * Look for a node with the computed hash value,
+			 * in the table being moved too if there is one.
 			 */
-			for (hnode = rbt->hashtable[hash % rbt->hashsize];
-			     hnode != NULL;
-			     hnode = hnode->hashnext)
-			{
-				dns_name_t hnode_name;
-
-				if (ISC_LIKELY(hash != HASHVAL(hnode)))
-					continue;
-				/*
-				 * This checks that the hashed label
-				 * sequence being looked up is at the
-				 * same tree level, so that we don't
-				 * match a labelsequence from some other
-				 * subdomain.
-				 */
-				if (ISC_LIKELY(get_upper_node(hnode) != up_current))
-					continue;
-
-				dns_name_init(&hnode_name, NULL);
-				NODENAME(hnode, &hnode_name);
-				if (ISC_LIKELY(dns_name_equal(&hnode_name, &hash_name)))
-					break;
-			}
+			hnode = hash_lookup(rbt->hashtable, rbt->hashsize,
+					    hash, up_current, &hash_name);
+			if (hnode == NULL &&
+			    ISC_UNLIKELY(rbt->oldhashtable != NULL))
+				hnode = hash_lookup(rbt->oldhashtable,
+						    rbt->oldhashsize, hash,
+						    up_current, &hash_name);
 
 			if (hnode != NULL) {
 				current = hnode;
@@ -2263,9 +2314,9 @@ create_node(isc_mem_t *mctx, dns_name_t *name, dns_rbtnode_t **nodep) {
 	node->parent_is_relative = 0;
 	node->data_is_relative = 0;
 	node->rpz = 0;
+	node->shard = 0;
 
 #ifdef DNS_RBT_USEHASH
-	HASHNEXT(node) = NULL;
 	HASHVAL(node) = 0;
 #endif
 
@@ -2310,26 +2361,233 @@ create_node(isc_mem_t *mctx, dns_name_t *name, dns_rbtnode_t **nodep) {
 }
 
 #ifdef DNS_RBT_USEHASH
+/*%
+ * Put 'node' in the first free slot for 'hashval' in 'table'.
+ */
 static inline void
-hash_add_node(dns_rbt_t *rbt, dns_rbtnode_t *node, dns_name_t *name) {
-	unsigned int hash;
+hash_insert(rbt_hashslot_t *table, size_t size, unsigned int hashval,
+	    dns_rbtnode_t *node)
+{
+	size_t mask = size - 1;
+	size_t i;
 
-	REQUIRE(name != NULL);
+	for (i = HASH_HOME(hashval, mask); table[i].node != NULL;
+	     i = (i + 1) & mask)
+		;
+	table[i].hashval = hashval;
+	table[i].node = node;
+}
 
-	HASHVAL(node) = dns_name_fullhash(name, ISC_FALSE);
+/*%
+ * Find the node whose name is 'name' and whose upper node is 'upper' in
+ * 'table'.  'hash' is the hash of the node's full name.
+ */
+static dns_rbtnode_t *
+hash_lookup(rbt_hashslot_t *table, size_t size, unsigned int hash,
+	    dns_rbtnode_t *upper, dns_name_t *name)
+{
+	size_t mask = size - 1;
+	size_t i;
+	dns_rbtnode_t *node;
+	dns_name_t nodename;
+
+	for (i = HASH_HOME(hash, mask); table[i].node != NULL;
+	     i = (i + 1) & mask)
+	{
+		if (ISC_LIKELY(table[i].hashval != hash))
+			continue;
+		node = table[i].node;
+		if (ISC_UNLIKELY(node == HASH_MOVED))
+			continue;
+		/*
+		 * This checks that the hashed label sequence being
+		 * looked up is at the same tree level, so that we don't
+		 * match a labelsequence from some other subdomain.
+		 */
+		if (ISC_LIKELY(get_upper_node(node) != upper))
+			continue;
+
+		dns_name_init(&nodename, NULL);
+		NODENAME(node, &nodename);
+		if (ISC_LIKELY(dns_name_equal(&nodename, name)))
+			return (node);
+	}
+
+	return (NULL);
+}
+
+/*%
+ * Find the slot holding 'node' in 'table', or return -1.
+ */
+static inline isc_int64_t
+hash_slot(rbt_hashslot_t *table, size_t size, dns_rbtnode_t *node) {
+	size_t mask = size - 1;
+	size_t i;
+
+	for (i = HASH_HOME(HASHVAL(node), mask); table[i].node != NULL;
+	     i = (i + 1) & mask)
+	{
+		if (table[i].node == node)
+			return ((isc_int64_t)i);
+	}
+
+	return (-1);
+}
+
+static inline void
+free_oldhash(dns_rbt_t *rbt) {
+	isc_mem_put(rbt->mctx, rbt->oldhashtable,
+		    rbt->oldhashsize * sizeof(rbt_hashslot_t));
+	rbt->oldhashtable = NULL;
+	rbt->oldhashsize = 0;
+	rbt->oldhashcount = 0;
+	rbt->oldhashnext = 0;
+}
+
+/*%
+ * Move up to 'count' slots of the old table into the current one,
+ * freeing the old table once it is empty.
+ */
+static void
+hash_move(dns_rbt_t *rbt, size_t count) {
+	rbt_hashslot_t *slot;
+
+	while (rbt->oldhashtable != NULL && count-- > 0) {
+		if (rbt->oldhashcount == 0 ||
+		    rbt->oldhashnext == rbt->oldhashsize)
+			break;
+		slot = &rbt->oldhashtable[rbt->oldhashnext++];
+		if (slot->node == NULL || slot->node == HASH_MOVED)
+			continue;
+		hash_insert(rbt->hashtable, rbt->hashsize, slot->hashval,
+			    slot->node);
+		slot->node = HASH_MOVED;
+		rbt->hashcount++;
+		rbt->oldhashcount--;
+	}
+
+	if (rbt->oldhashtable != NULL && rbt->oldhashcount == 0)
+		free_oldhash(rbt);
+}
 
-	hash = HASHVAL(node) % rbt->hashsize;
-	HASHNEXT(node) = rbt->hashtable[hash];
+/*%
+ * Allocate the next hash table, big enough for 'count' entries.  Its
+ * slots are cleared later, by hash_clear().
+ */
+static void
+hash_prepare(dns_rbt_t *rbt, size_t count) {
+	size_t size;
+
+	INSIST(rbt->nexthashtable == NULL);
+
+	size = rbt->hashsize;
+	do {
+		INSIST(size * 2 > size);
+		size *= 2;
+	} while (count > HASH_MAXLOAD(size));
+
+	rbt->nexthashtable = isc_mem_get(rbt->mctx,
+					 size * sizeof(rbt_hashslot_t));
+	if (rbt->nexthashtable == NULL)
+		return;
+	rbt->nexthashsize = size;
+	rbt->nexthashclear = 0;
+}
+
+static inline void
+free_nexthash(dns_rbt_t *rbt) {
+	isc_mem_put(rbt->mctx, rbt->nexthashtable,
+		    rbt->nexthashsize * sizeof(rbt_hashslot_t));
+	rbt->nexthashtable = NULL;
+	rbt->nexthashsize = 0;
+	rbt->nexthashclear = 0;
+}
+
+/*%
+ * Clear up to 'count' more slots of the next hash table.
+ */
+static inline void
+hash_clear(dns_rbt_t *rbt, size_t count) {
+	if (count > rbt->nexthashsize - rbt->nexthashclear)
+		count = rbt->nexthashsize - rbt->nexthashclear;
+	memset(&rbt->nexthashtable[rbt->nexthashclear], 0,
+	       count * sizeof(rbt_hashslot_t));
+	rbt->nexthashclear += count;
+}
+
+/*%
+ * Make the (cleared) next hash table the current one, leaving the
+ * current one to be moved over.
+ */
+static void
+hash_switch(dns_rbt_t *rbt) {
+	INSIST(rbt->oldhashtable == NULL);
+	INSIST(rbt->nexthashclear == rbt->nexthashsize);
+
+	rbt->oldhashtable = rbt->hashtable;
+	rbt->oldhashsize = rbt->hashsize;
+	rbt->oldhashcount = rbt->hashcount;
+	rbt->oldhashnext = 0;
+	rbt->hashtable = rbt->nexthashtable;
+	rbt->hashsize = rbt->nexthashsize;
+	rbt->hashcount = 0;
+	rbt->nexthashtable = NULL;
+	rbt->nexthashsize = 0;
+	rbt->nexthashclear = 0;
+
+	if (rbt->oldhashcount == 0)
+		free_oldhash(rbt);
+}
+
+/*%
+ * Make sure that 'count' more nodes can be hashed, doing a share of the
+ * work of growing the table along the way.  If a bigger table cannot be
+ * allocated, the current one is allowed to fill up beyond its usual
+ * limit, as long as one slot stays empty to end the probes.
+ */
+static isc_result_t
+hash_reserve(dns_rbt_t *rbt, size_t count) {
+	size_t total;
+
+	if (rbt->oldhashtable != NULL)
+		hash_move(rbt, RBT_HASH_MOVE);
+	if (rbt->nexthashtable != NULL)
+		hash_clear(rbt, RBT_HASH_CLEAR);
+
+	total = rbt->hashcount + rbt->oldhashcount + count;
+	if (total > rbt->hashsize / 2 && rbt->nexthashtable == NULL)
+		hash_prepare(rbt, total);
+	if (ISC_LIKELY(total <= HASH_MAXLOAD(rbt->hashsize)))
+		return (ISC_R_SUCCESS);
+
+	/*
+	 * The table is full: finish whatever is left of the growing,
+	 * which is everything when many entries are reserved at once.
+	 */
+	if (rbt->oldhashtable != NULL)
+		hash_move(rbt, rbt->oldhashsize);
+	if (rbt->nexthashtable != NULL &&
+	    total > HASH_MAXLOAD(rbt->nexthashsize))
+		free_nexthash(rbt);
+	if (rbt->nexthashtable == NULL)
+		hash_prepare(rbt, total);
+	if (rbt->nexthashtable != NULL) {
+		hash_clear(rbt, rbt->nexthashsize);
+		hash_switch(rbt);
+		return (ISC_R_SUCCESS);
+	}
 
-	rbt->hashtable[hash] = node;
+	if (total < rbt->hashsize)
+		return (ISC_R_SUCCESS);
+	return (ISC_R_NOMEMORY);
 }
 
 static isc_result_t
 inithash(dns_rbt_t *rbt) {
-	unsigned int bytes;
+	size_t bytes;
 
 	rbt->hashsize = RBT_HASH_SIZE;
-	bytes = (unsigned int)rbt->hashsize * sizeof(dns_rbtnode_t *);
+	bytes = rbt->hashsize * sizeof(rbt_hashslot_t);
 	rbt->hashtable = isc_mem_get(rbt->mctx, bytes);
 
 	if (rbt->hashtable == NULL)
@@ -2341,72 +2599,72 @@ inithash(dns_rbt_t *rbt) {
 }
 
 static void
-rehash(dns_rbt_t *rbt, unsigned int newcount) {
-	unsigned int oldsize;
-	dns_rbtnode_t **oldtable;
-	dns_rbtnode_t *node;
-	dns_rbtnode_t *nextnode;
-	unsigned int hash;
-	unsigned int i;
-
-	oldsize = (unsigned int)rbt->hashsize;
-	oldtable = rbt->hashtable;
-	do {
-		INSIST((rbt->hashsize * 2 + 1) > rbt->hashsize);
-		rbt->hashsize = rbt->hashsize * 2 + 1;
-	} while (newcount >= (rbt->hashsize * 3));
-	rbt->hashtable = isc_mem_get(rbt->mctx,
-				     rbt->hashsize * sizeof(dns_rbtnode_t *));
-	if (rbt->hashtable == NULL) {
-		rbt->hashtable = oldtable;
-		rbt->hashsize = oldsize;
-		return;
-	}
-
-	for (i = 0; i < rbt->hashsize; i++)
-		rbt->hashtable[i] = NULL;
-
-	for (i = 0; i < oldsize; i++) {
-		for (node = oldtable[i]; node != NULL; node = nextnode) {
-			hash = HASHVAL(node) % rbt->hashsize;
-			nextnode = HASHNEXT(node);
-			HASHNEXT(node) = rbt->hashtable[hash];
-			rbt->hashtable[hash] = node;
-		}
-	}
-
-	isc_mem_put(rbt->mctx, oldtable, oldsize * sizeof(dns_rbtnode_t *));
+freehash(dns_rbt_t *rbt) {
+	if (rbt->oldhashtable != NULL)
+		free_oldhash(rbt);
+	if (rbt->nexthashtable != NULL)
+		free_nexthash(rbt);
+	if (rbt->hashtable != NULL)
+		isc_mem_put(rbt->mctx, rbt->hashtable,
+			    rbt->hashsize * sizeof(rbt_hashslot_t));
+	rbt->hashtable = NULL;
+	rbt->hashsize = 0;
+	rbt->hashcount = 0;
 }
 
+/*%
+ * Hash 'node', whose full name is 'name'.  Room has been made for it by
+ * hash_reserve().
+ */
 static inline void
 hash_node(dns_rbt_t *rbt, dns_rbtnode_t *node, dns_name_t *name) {
 	REQUIRE(DNS_RBTNODE_VALID(node));
+	REQUIRE(name != NULL);
+	INSIST(rbt->hashcount + 1 < rbt->hashsize);
 
-	if (rbt->nodecount >= (rbt->hashsize * 3))
-		rehash(rbt, rbt->nodecount);
-
-	hash_add_node(rbt, node, name);
+	HASHVAL(node) = dns_name_fullhash(name, ISC_FALSE);
+	hash_insert(rbt->hashtable, rbt->hashsize, HASHVAL(node), node);
+	rbt->hashcount++;
 }
 
 static inline void
 unhash_node(dns_rbt_t *rbt, dns_rbtnode_t *node) {
-	unsigned int bucket;
-	dns_rbtnode_t *bucket_node;
+	rbt_hashslot_t *table = rbt->hashtable;
+	size_t mask = rbt->hashsize - 1;
+	size_t i, j, home;
+	isc_int64_t slot;
 
 	REQUIRE(DNS_RBTNODE_VALID(node));
 
-	bucket = HASHVAL(node) % rbt->hashsize;
-	bucket_node = rbt->hashtable[bucket];
+	slot = hash_slot(table, rbt->hashsize, node);
+	if (slot < 0) {
+		/*
+		 * Not moved yet.  Probes in the old table must carry on
+		 * past the slot, so it is marked rather than emptied.
+		 */
+		INSIST(rbt->oldhashtable != NULL);
+		slot = hash_slot(rbt->oldhashtable, rbt->oldhashsize, node);
+		INSIST(slot >= 0);
+		rbt->oldhashtable[slot].node = HASH_MOVED;
+		if (--rbt->oldhashcount == 0)
+			free_oldhash(rbt);
+		return;
+	}
 
-	if (bucket_node == node) {
-		rbt->hashtable[bucket] = HASHNEXT(node);
-	} else {
-		while (HASHNEXT(bucket_node) != node) {
-			INSIST(HASHNEXT(bucket_node) != NULL);
-			bucket_node = HASHNEXT(bucket_node);
-		}
-		HASHNEXT(bucket_node) = HASHNEXT(node);
+	/*
+	 * Shift back each following entry that would no longer be found
+	 * from its home slot once this one is empty.
+	 */
+	i = (size_t)slot;
+	for (j = (i + 1) & mask; table[j].node != NULL; j = (j + 1) & mask) {
+		home = HASH_HOME(table[j].hashval, mask);
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		table[i] = table[j];
+		i = j;
 	}
+	table[i].node = NULL;
+	rbt->hashcount--;
 }
 #endif /* DNS_RBT_USEHASH */
 
@@ -41,7 +41,6 @@
 #include <isc/time.h>
 #include <isc/util.h>
 
-#include <dns/acache.h>
 #include <dns/callbacks.h>
 #include <dns/db.h>
 #include <dns/dbiterator.h>
@@ -50,6 +49,7 @@
 #include <dns/lib.h>
 #include <dns/log.h>
 #include <dns/masterdump.h>
+#include <dns/message.h>
 #include <dns/nsec.h>
 #include <dns/nsec3.h>
 #include <dns/rbt.h>
@@ -144,8 +144,6 @@ typedef isc_uint64_t                    rbtdb_serial_t;
 #define slab_methods slab_methods64
 #define zone_methods zone_methods64
 
-#define acache_callback acache_callback64
-#define acache_cancelentry acache_cancelentry64
 #define activeempty activeempty64
 #define activeemtpynode activeemtpynode64
 #define add32 add64
@@ -162,12 +160,15 @@ typedef isc_uint64_t                    rbtdb_serial_t;
 #define attachnode attachnode64
 #define attachversion attachversion64
 #define beginload beginload64
+#define bucketcount bucketcount64
 #define bind_rdataset bind_rdataset64
 #define cache_find cache_find64
 #define cache_findrdataset cache_findrdataset64
+#define cache_findtop cache_findtop64
 #define cache_findzonecut cache_findzonecut64
 #define cache_zonecut_callback cache_zonecut_callback64
 #define check_stale_header check_stale_header64
+#define cleanbucket cleanbucket64
 #define clean_cache_node clean_cache_node64
 #define clean_stale_headers clean_stale_headers64
 #define clean_zone_node clean_zone_node64
@@ -208,38 +209,54 @@ typedef isc_uint64_t                    rbtdb_serial_t;
 #define findnodeintree findnodeintree64
 #define findnsec3node findnsec3node64
 #define flush_deletions flush_deletions64
-#define free_acachearray free_acachearray64
+#define free_ext free_ext64
+#define free_gluetable free_gluetable64
 #define free_noqname free_noqname64
 #define free_rbtdb free_rbtdb64
 #define free_rbtdb_callback free_rbtdb_callback64
 #define free_rdataset free_rdataset64
+#define getlockstats getlockstats64
 #define getnsec3parameters getnsec3parameters64
 #define getoriginnode getoriginnode64
 #define getrrsetstats getrrsetstats64
+#define getservestalettl getservestalettl64
 #define getsigningtime getsigningtime64
 #define getsize getsize64
 #define hashsize hashsize64
+#define header_ext header_ext64
 #define init_file_version init_file_version64
 #define init_rdataset init_rdataset64
 #define isdnssec isdnssec64
 #define ispersistent ispersistent64
 #define issecure issecure64
 #define iszonesecure iszonesecure64
+#define iterator_setshard iterator_setshard64
+#define iterator_shardfirst iterator_shardfirst64
+#define iterator_shardlast iterator_shardlast64
 #define loading_addrdataset loading_addrdataset64
 #define loadnode loadnode64
+#define lru_balance lru_balance64
+#define lru_insert lru_insert64
+#define lru_key lru_key64
+#define lru_tail lru_tail64
+#define lru_unlink lru_unlink64
 #define make_least_version make_least_version64
 #define mark_stale_header mark_stale_header64
 #define match_header_version match_header_version64
 #define matchparams matchparams64
+#define move_proofs move_proofs64
 #define maybe_free_rbtdb maybe_free_rbtdb64
+#define name_shard name_shard64
 #define need_headerupdate need_headerupdate64
 #define new_rdataset new_rdataset64
 #define new_reference new_reference64
 #define newversion newversion64
 #define nodecount nodecount64
+#define node_lock node_lock64
 #define nodefullname nodefullname64
 #define overmem overmem64
 #define overmem_purge overmem_purge64
+#define overmem_victim overmem_victim64
 #define previous_closest_nsec previous_closest_nsec64
 #define printnode printnode64
 #define prune_tree prune_tree64
@@ -248,19 +265,17 @@ typedef isc_uint64_t                    rbtdb_serial_t;
 #define rbtdb_write_header rbtdb_write_header64
 #define rbtdb_zero_header rbtdb_zero_header64
 #define rdataset_clearprefetch rdataset_clearprefetch64
+#define rdataset_addglue rdataset_addglue64
 #define rdataset_clone rdataset_clone64
 #define rdataset_count rdataset_count64
 #define rdataset_current rdataset_current64
 #define rdataset_disassociate rdataset_disassociate64
 #define rdataset_expire rdataset_expire64
 #define rdataset_first rdataset_first64
-#define rdataset_getadditional rdataset_getadditional64
 #define rdataset_getclosest rdataset_getclosest64
 #define rdataset_getnoqname rdataset_getnoqname64
 #define rdataset_getownercase rdataset_getownercase64
 #define rdataset_next rdataset_next64
-#define rdataset_putadditional rdataset_putadditional64
-#define rdataset_setadditional rdataset_setadditional64
 #define rdataset_setownercase rdataset_setownercase64
 #define rdataset_settrust rdataset_settrust64
 #define rdatasetiter_current rdatasetiter_current64
@@ -279,10 +294,12 @@ typedef isc_uint64_t                    rbtdb_serial_t;
 #define rpz_ready rpz_ready64
 #define serialize serialize64
 #define set_index set_index64
+#define set_shard set_shard64
 #define set_ttl set_ttl64
 #define setcachestats setcachestats64
 #define setnsec3parameters setnsec3parameters64
 #define setownercase setownercase64
+#define setservestalettl setservestalettl64
 #define setsigningtime setsigningtime64
 #define settask settask64
 #define setup_delegation setup_delegation64
@@ -374,7 +391,8 @@ typedef isc_rwlock_t nodelock_t;
 
 #define NODE_INITLOCK(l)        isc_rwlock_init((l), 0, 0)
 #define NODE_DESTROYLOCK(l)     isc_rwlock_destroy(l)
-#define NODE_LOCK(l, t)         RWLOCK((l), (t))
+#define NODE_LOCK(l, t)         node_lock((l), (t))
+#define NODE_TRYLOCK(l, t)      isc_rwlock_trylock((l), (t))
 #define NODE_UNLOCK(l, t)       RWUNLOCK((l), (t))
 #define NODE_TRYUPGRADE(l)      isc_rwlock_tryupgrade(l)
 
@@ -388,11 +406,12 @@ typedef isc_mutex_t nodelock_t;
 
 #define NODE_INITLOCK(l)        isc_mutex_init(l)
 #define NODE_DESTROYLOCK(l)     DESTROYLOCK(l)
-#define NODE_LOCK(l, t)         LOCK(l)
+#define NODE_LOCK(l, t)         node_lock((l), (t))
+#define NODE_TRYLOCK(l, t)      isc_mutex_trylock(l)
 #define NODE_UNLOCK(l, t)       UNLOCK(l)
 #define NODE_TRYUPGRADE(l)      ISC_R_SUCCESS
 
-#define NODE_STRONGLOCK(l)      LOCK(l)
+#define NODE_STRONGLOCK(l)      node_lock((l), isc_rwlocktype_write)
 #define NODE_STRONGUNLOCK(l)    UNLOCK(l)
 #define NODE_WEAKLOCK(l, t)     ((void)0)
 #define NODE_WEAKUNLOCK(l, t)   ((void)0)
@@ -421,8 +440,30 @@ struct noqname {
 	dns_rdatatype_t	type;
 };
 
-typedef struct acachectl acachectl_t;
+/*%
+ * The parts of an rdatasetheader that most headers do without.  They
+ * are kept out of line so that the fields used on every lookup share
+ * as few cache lines as possible, and are only allocated when one of
+ * them is set.
+ */
+typedef struct rdatasetheader_ext {
+	struct noqname                  *noqname;
+	struct noqname                  *closest;
+	/*%
+	 * Case vector.  If the bit is set then the corresponding
+	 * character in the owner name needs to be AND'd with 0x20,
+	 * rendering that character upper case.  Only valid when the
+	 * header is CASESET and not CASEFULLYLOWER.
+	 */
+	unsigned char			upper[32];
+} rdatasetheader_ext_t;
 
+/*%
+ * The slab of rdata follows the header directly.  The fields that
+ * lookups use come first, within the first cache line on 64-bit
+ * platforms.  Keep the header small: anything that most rdatasets do
+ * without belongs in rdatasetheader_ext_t.
+ */
 typedef struct rdatasetheader {
 	/*%
 	 * Locked by the owning node's lock.
@@ -432,17 +473,24 @@ typedef struct rdatasetheader {
 	rbtdb_rdatatype_t               type;
 	isc_uint16_t                    attributes;
 	dns_trust_t                     trust;
-	struct noqname                  *noqname;
-	struct noqname                  *closest;
 	unsigned int 			is_mmapped : 1;
 	unsigned int 			next_is_relative : 1;
 	unsigned int 			node_is_relative : 1;
 	unsigned int 			resign_lsb : 1;
+	unsigned int 			ext_is_mmapped : 1;
+	isc_uint32_t                    count;
 	/*%<
+	 * Monotonously increased every time this rdataset is bound so that
+	 * it is used as the base of the starting point in DNS responses
+	 * when the "cyclic" rrset-order is required.  Since the ordering
+	 * should not be so crucial, no lock is set for the counter for
+	 * performance reasons.
+	 */
+
+	/*
 	 * We don't use the LIST macros, because the LIST structure has
 	 * both head and tail pointers, and is doubly linked.
 	 */
-
 	struct rdatasetheader           *next;
 	/*%<
 	 * If this is the top header for an rdataset, 'next' points
@@ -457,38 +505,43 @@ typedef struct rdatasetheader {
 	 * this rdataset.
 	 */
 
-	isc_uint32_t                    count;
-	/*%<
-	 * Monotonously increased every time this rdataset is bound so that
-	 * it is used as the base of the starting point in DNS responses
-	 * when the "cyclic" rrset-order is required.  Since the ordering
-	 * should not be so crucial, no lock is set for the counter for
-	 * performance reasons.
-	 */
-
-	acachectl_t                     *additional_auth;
-	acachectl_t                     *additional_glue;
-
 	dns_rbtnode_t                   *node;
-	isc_stdtime_t                   last_used;
-	ISC_LINK(struct rdatasetheader) link;
-
+	union {
+		isc_stdtime_t           last_used;
+		/*%<
+		 * Cache only: when the rdataset was last bound, for LRU
+		 * cleaning.
+		 */
+		isc_stdtime_t           resign;
+		/*%<
+		 * Zone only: the re-signing time, shifted right by one
+		 * (see resign_lsb).
+		 */
+	} u;
 	unsigned int                    heap_index;
 	/*%<
 	 * Used for TTL-based cache cleaning.
 	 */
-	isc_stdtime_t                   resign;
+	ISC_LINK(struct rdatasetheader) link;
+	rdatasetheader_ext_t            *ext;
 	/*%<
-	 * Case vector.  If the bit is set then the corresponding
-	 * character in the owner name needs to be AND'd with 0x20,
-	 * rendering that character upper case.
+	 * NULL unless one of the rarely used fields has been set.
 	 */
-	unsigned char			upper[32];
 } rdatasetheader_t;
 
 typedef ISC_LIST(rdatasetheader_t)      rdatasetheaderlist_t;
 typedef ISC_LIST(dns_rbtnode_t)         rbtnodelist_t;
 
+/*%
+ * The LRU lists of a cache bucket, see lru_insert().
+ */
+typedef struct {
+	rdatasetheaderlist_t            cold;
+	rdatasetheaderlist_t            hot;
+	unsigned int                    ncold;
+	unsigned int                    nhot;
+} rbtdb_lru_t;
+
 #define RDATASET_ATTR_NONEXISTENT       0x0001
 #define RDATASET_ATTR_STALE             0x0002
 #define RDATASET_ATTR_IGNORE            0x0004
@@ -502,19 +555,7 @@ typedef ISC_LIST(dns_rbtnode_t)         rbtnodelist_t;
 #define RDATASET_ATTR_CASESET           0x0400
 #define RDATASET_ATTR_ZEROTTL           0x0800
 #define RDATASET_ATTR_CASEFULLYLOWER    0x1000
-
-typedef struct acache_cbarg {
-	dns_rdatasetadditional_t        type;
-	unsigned int                    count;
-	dns_db_t                        *db;
-	dns_dbnode_t                    *node;
-	rdatasetheader_t                *header;
-} acache_cbarg_t;
-
-struct acachectl {
-	dns_acacheentry_t               *entry;
-	acache_cbarg_t                  *cbarg;
-};
+#define RDATASET_ATTR_HOT               0x2000
 
 /*
  * XXX
@@ -552,6 +593,8 @@ struct acachectl {
 	(((header)->attributes & RDATASET_ATTR_ZEROTTL) != 0)
 #define CASEFULLYLOWER(header) \
 	(((header)->attributes & RDATASET_ATTR_CASEFULLYLOWER) != 0)
+#define HOT(header) \
+	(((header)->attributes & RDATASET_ATTR_HOT) != 0)
 
 
 #define ACTIVE(header, now) \
@@ -580,14 +623,93 @@ struct acachectl {
 #define DEFAULT_CACHE_NODE_LOCK_COUNT   16
 #endif	/* DNS_RBTDB_CACHE_NODE_LOCK_COUNT */
 
+/*%
+ * The bucket counts of databases created from now on, as set by
+ * dns_rbtdb_setnodelockcount(); 0 means the defaults above.
+ */
+static unsigned int cache_node_lock_count = 0;
+static unsigned int zone_node_lock_count = 0;
+
+/*%
+ * Number of buckets whose LRU lists overmem_purge() compares before
+ * purging from one of them.
+ */
+#define OVERMEM_SAMPLES			4
+
+/*%
+ * Number of trees ("shards"), besides the main one, over which a "sharded"
+ * cache DB (see dns_rbtdb_create()) spreads its names.  A name with at
+ * least SHARD_LABELS labels (counting the root label) lives in the shard
+ * picked by a hash of its last SHARD_LABELS labels, so that a domain
+ * registered under a top-level domain and everything below it share a
+ * shard; the root and the top-level domains themselves stay in the main
+ * tree.  Each shard has its
+ * own tree lock, so adding a name to the cache only stalls lookups of
+ * names in the same shard.  This can be set at compilation time via the
+ * DNS_RBTDB_CACHE_SHARD_COUNT variable; 0 keeps the whole cache in the
+ * main tree.
+ */
+#ifdef DNS_RBTDB_CACHE_SHARD_COUNT
+#if DNS_RBTDB_CACHE_SHARD_COUNT < 0 || DNS_RBTDB_CACHE_SHARD_COUNT > 255
+#error "DNS_RBTDB_CACHE_SHARD_COUNT must be between 0 and 255"
+#else
+#define DEFAULT_CACHE_SHARD_COUNT DNS_RBTDB_CACHE_SHARD_COUNT
+#endif
+#else
+#define DEFAULT_CACHE_SHARD_COUNT	16
+#endif	/* DNS_RBTDB_CACHE_SHARD_COUNT */
+
+#define SHARD_LABELS			3
+
 typedef struct {
+	/* Must come first; see node_lock(). */
 	nodelock_t                      lock;
 	/* Protected in the refcount routines. */
 	isc_refcount_t                  references;
 	/* Locked by lock. */
 	isc_boolean_t                   exiting;
+	/*
+	 * Set on creation: where to count attempts to take the lock
+	 * while it was held (cache DB only), and this lock's counter.
+	 */
+	isc_stats_t *                   lockstats;
+	isc_statscounter_t              bucket;
 } rbtdb_nodelock_t;
 
+/*%
+ * Take a node lock.  'l' is always the 'lock' member of an
+ * rbtdb_nodelock_t, which tells us where to count contention.
+ */
+static inline void
+node_lock(nodelock_t *l, isc_rwlocktype_t t) {
+	rbtdb_nodelock_t *nodelock = (rbtdb_nodelock_t *)l;
+
+#if defined(ISC_RWLOCK_USEATOMIC) && defined(DNS_RBT_USEISCREFCOUNT)
+	if (nodelock->lockstats != NULL) {
+		if (isc_rwlock_trylock(l, t) == ISC_R_SUCCESS)
+			return;
+		isc_stats_increment(nodelock->lockstats, nodelock->bucket);
+	}
+	RWLOCK(l, t);
+#else
+	UNUSED(t);
+
+	if (nodelock->lockstats != NULL) {
+		if (isc_mutex_trylock(l) == ISC_R_SUCCESS)
+			return;
+		isc_stats_increment(nodelock->lockstats, nodelock->bucket);
+	}
+	LOCK(l);
+#endif
+}
+
+typedef struct {
+	/* Locks the tree structure of this shard */
+	isc_rwlock_t                    tree_lock;
+	/* Locked by tree_lock. */
+	dns_rbt_t *                     tree;
+} rbtdb_shard_t;
+
 typedef struct rbtdb_changed {
 	dns_rbtnode_t *                 node;
 	isc_boolean_t                   dirty;
@@ -611,6 +733,32 @@ typedef enum {
 	expire_flush
 } expire_t;
 
+/*%
+ * The addresses of one name server, found while adding glue for an
+ * NS rdataset.
+ */
+typedef struct rbtdb_glue {
+	struct rbtdb_glue		*next;
+	dns_fixedname_t			fixedname;
+	dns_rdataset_t			rdataset_a;
+	dns_rdataset_t			sigrdataset_a;
+	dns_rdataset_t			rdataset_aaaa;
+	dns_rdataset_t			sigrdataset_aaaa;
+} rbtdb_glue_t;
+
+/*%
+ * The glue for one NS rdataset header.  'glue_list' is NULL if none
+ * of the name servers has an address in the database.
+ */
+typedef struct rbtdb_glue_table_node {
+	struct rbtdb_glue_table_node	*next;
+	rdatasetheader_t		*header;
+	rbtdb_glue_t			*glue_list;
+} rbtdb_glue_table_node_t;
+
+#define GLUE_TABLE_INIT_BITS		4U
+#define GLUE_TABLE_MAX_BITS		24U
+
 typedef struct rbtdb_version {
 	/* Not locked */
 	rbtdb_serial_t                  serial;
@@ -637,11 +785,19 @@ typedef struct rbtdb_version {
 	unsigned char			salt[DNS_NSEC3_SALTSIZE];
 
 	/*
-	 * records and bytes are covered by rwlock.
+	 * records, bytes and the glue table are covered by rwlock.
 	 */
 	isc_rwlock_t                    rwlock;
 	isc_uint64_t			records;
 	isc_uint64_t			bytes;
+
+	/*
+	 * Glue for the NS rdatasets of this version, added to by
+	 * rdataset_addglue() and freed with the version.
+	 */
+	rbtdb_glue_table_node_t		**glue_table;
+	unsigned int			glue_table_bits;
+	unsigned int			glue_table_count;
 } rbtdb_version_t;
 
 typedef ISC_LIST(rbtdb_version_t)       rbtdb_versionlist_t;
@@ -657,6 +813,19 @@ struct dns_rbtdb {
 #endif
 	/* Locks the tree structure (prevents nodes appearing/disappearing) */
 	isc_rwlock_t                    tree_lock;
+	/*
+	 * Cache DB only: the shards, see DEFAULT_CACHE_SHARD_COUNT.  A
+	 * node's 'shard' is 0 in the main tree (and the auxiliary ones),
+	 * and its shard's index in this array plus 1 otherwise.
+	 */
+	unsigned int                    shard_count;
+	rbtdb_shard_t *                 shards;
+	/*
+	 * Set, with the main tree locked, once a main tree node gets a
+	 * DNAME; until then a lookup of a name in a shard does not need to
+	 * look for one above it.
+	 */
+	isc_boolean_t                   top_dname;
 	/* Locks for individual tree nodes */
 	unsigned int                    node_lock_count;
 	rbtdb_nodelock_t *              node_locks;
@@ -664,6 +833,17 @@ struct dns_rbtdb {
 	dns_rbtnode_t *			nsec3_origin_node;
 	dns_stats_t *			rrsetstats; /* cache DB only */
 	isc_stats_t *			cachestats; /* cache DB only */
+	isc_stats_t *			lockstats; /* cache DB only */
+	/*
+	 * Cache DB only: how long after they expire rdatasets are kept to
+	 * be served stale (see DNS_DBFIND_STALEOK).
+	 */
+	dns_ttl_t			serve_stale_ttl;
+	/*
+	 * Where overmem_purge() next looks for buckets to purge from;
+	 * updated without locking, as it is only a hint.
+	 */
+	unsigned int			lru_cursor;
 	/* Locked by lock. */
 	unsigned int                    active;
 	isc_refcount_t                  references;
@@ -679,15 +859,16 @@ struct dns_rbtdb {
 	dns_dbnode_t                    *nsnode;
 
 	/*
-	 * This is a linked list used to implement the LRU cache.  There will
-	 * be node_lock_count linked lists here.  Nodes in bucket 1 will be
-	 * placed on the linked list rdatasets[1].
+	 * These are the linked lists used to implement the LRU cache.  There
+	 * will be node_lock_count sets of them here.  Nodes in bucket 1 will
+	 * be placed on the lists of lru[1].
 	 */
-	rdatasetheaderlist_t            *rdatasets;
+	rbtdb_lru_t                     *lru;
 
 	/*%
 	 * Temporary storage for stale cache nodes and dynamically deleted
-	 * nodes that await being cleaned up.
+	 * nodes that await being cleaned up.  There is one list per
+	 * locking bucket in each tree, see DEADNODES().
 	 */
 	rbtnodelist_t                   *deadnodes;
 
@@ -763,38 +944,22 @@ static isc_result_t rdataset_getclosest(dns_rdataset_t *rdataset,
 					dns_name_t *name,
 					dns_rdataset_t *neg,
 					dns_rdataset_t *negsig);
-static isc_result_t rdataset_getadditional(dns_rdataset_t *rdataset,
-					   dns_rdatasetadditional_t type,
-					   dns_rdatatype_t qtype,
-					   dns_acache_t *acache,
-					   dns_zone_t **zonep,
-					   dns_db_t **dbp,
-					   dns_dbversion_t **versionp,
-					   dns_dbnode_t **nodep,
-					   dns_name_t *fname,
-					   dns_message_t *msg,
-					   isc_stdtime_t now);
-static isc_result_t rdataset_setadditional(dns_rdataset_t *rdataset,
-					   dns_rdatasetadditional_t type,
-					   dns_rdatatype_t qtype,
-					   dns_acache_t *acache,
-					   dns_zone_t *zone,
-					   dns_db_t *db,
-					   dns_dbversion_t *version,
-					   dns_dbnode_t *node,
-					   dns_name_t *fname);
-static isc_result_t rdataset_putadditional(dns_acache_t *acache,
-					   dns_rdataset_t *rdataset,
-					   dns_rdatasetadditional_t type,
-					   dns_rdatatype_t qtype);
 static inline isc_boolean_t need_headerupdate(rdatasetheader_t *header,
 					      isc_stdtime_t now);
 static void update_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
 			  isc_stdtime_t now);
+static inline void lru_insert(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
+			      isc_boolean_t hot);
+static inline void lru_unlink(dns_rbtdb_t *rbtdb, rdatasetheader_t *header);
+static inline rdatasetheader_t *lru_tail(dns_rbtdb_t *rbtdb,
+					 unsigned int locknum);
+static inline isc_uint64_t lru_key(rdatasetheader_t *header);
+static inline void lru_balance(dns_rbtdb_t *rbtdb, rbtdb_lru_t *lru);
 static void expire_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
 			  isc_boolean_t tree_locked, expire_t reason);
 static void overmem_purge(dns_rbtdb_t *rbtdb, unsigned int locknum_start,
-			  isc_stdtime_t now, isc_boolean_t tree_locked);
+			  unsigned int shard, isc_stdtime_t now,
+			  isc_boolean_t tree_locked);
 static isc_result_t resign_insert(dns_rbtdb_t *rbtdb, int idx,
 				  rdatasetheader_t *newheader);
 static void resign_delete(dns_rbtdb_t *rbtdb, rbtdb_version_t *version,
@@ -807,6 +972,11 @@ static void rdataset_setownercase(dns_rdataset_t *rdataset,
 				  const dns_name_t *name);
 static void rdataset_getownercase(const dns_rdataset_t *rdataset,
 				  dns_name_t *name);
+static isc_result_t rdataset_addglue(dns_rdataset_t *rdataset,
+				     dns_dbversion_t *version,
+				     unsigned int options,
+				     dns_message_t *msg);
+static void free_gluetable(rbtdb_version_t *version);
 
 static dns_rdatasetmethods_t rdataset_methods = {
 	rdataset_disassociate,
@@ -819,14 +989,12 @@ static dns_rdatasetmethods_t rdataset_methods = {
 	rdataset_getnoqname,
 	NULL,
 	rdataset_getclosest,
-	rdataset_getadditional,
-	rdataset_setadditional,
-	rdataset_putadditional,
 	rdataset_settrust,
 	rdataset_expire,
 	rdataset_clearprefetch,
 	rdataset_setownercase,
-	rdataset_getownercase
+	rdataset_getownercase,
+	rdataset_addglue
 };
 
 static dns_rdatasetmethods_t slab_methods = {
@@ -845,8 +1013,6 @@ static dns_rdatasetmethods_t slab_methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
 	NULL
 };
 
@@ -906,13 +1072,15 @@ static dns_dbiteratormethods_t dbiterator_methods = {
 #define DELETION_BATCH_MAX 64
 
 /*
- * If 'paused' is ISC_TRUE, then the tree lock is not being held.
+ * If 'paused' is ISC_TRUE, then the tree lock is not being held.  Otherwise
+ * it is the lock of 'shard', the tree 'chain' is in.
  */
 typedef struct rbtdb_dbiterator {
 	dns_dbiterator_t                common;
 	isc_boolean_t                   paused;
 	isc_boolean_t                   new_origin;
 	isc_rwlocktype_t                tree_locked;
+	unsigned int                    shard;
 	isc_result_t                    result;
 	dns_fixedname_t                 name;
 	dns_fixedname_t                 origin;
@@ -930,11 +1098,28 @@ typedef struct rbtdb_dbiterator {
 #define IS_STUB(rbtdb)  (((rbtdb)->common.attributes & DNS_DBATTR_STUB)  != 0)
 #define IS_CACHE(rbtdb) (((rbtdb)->common.attributes & DNS_DBATTR_CACHE) != 0)
 
+/*%
+ * How long past its TTL 'header' is kept for serving stale.  Negative
+ * answers saying that the name does not exist are not kept.
+ */
+#define KEEPSTALE(rbtdb) ((rbtdb)->serve_stale_ttl > 0)
+#define STALE_TTL(header, rbtdb) \
+	(NXDOMAIN(header) ? 0 : (rbtdb)->serve_stale_ttl)
+
+#define SHARD_TREE(rbtdb, shard) \
+	((shard) == 0 ? (rbtdb)->tree : (rbtdb)->shards[(shard) - 1].tree)
+#define SHARD_LOCK(rbtdb, shard) \
+	((shard) == 0 ? &(rbtdb)->tree_lock : \
+	 &(rbtdb)->shards[(shard) - 1].tree_lock)
+#define DEADNODES(rbtdb, shard, bucket) \
+	((rbtdb)->deadnodes[(shard) * (rbtdb)->node_lock_count + (bucket)])
+
 static void free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log,
 		       isc_event_t *event);
 static void overmem(dns_db_t *db, isc_boolean_t over);
 static void setnsec3parameters(dns_db_t *db, rbtdb_version_t *version);
-static void setownercase(rdatasetheader_t *header, const dns_name_t *name);
+static void setownercase(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
+			 const dns_name_t *name);
 
 static isc_boolean_t match_header_version(rbtdb_file_header_t *header);
 
@@ -1133,8 +1318,8 @@ resign_sooner(void *v1, void *v2) {
 	rdatasetheader_t *h1 = v1;
 	rdatasetheader_t *h2 = v2;
 
-	return (ISC_TF(h1->resign < h2->resign ||
-		       (h1->resign == h2->resign &&
+	return (ISC_TF(h1->u.resign < h2->u.resign ||
+		       (h1->u.resign == h2->u.resign &&
 			h1->resign_lsb < h2->resign_lsb)));
 }
 
@@ -1222,6 +1407,7 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 		INSIST(refs == 0);
 		UNLINK(rbtdb->open_versions, rbtdb->current_version, link);
 		isc_refcount_destroy(&rbtdb->current_version->references);
+		free_gluetable(rbtdb->current_version);
 		isc_rwlock_destroy(&rbtdb->current_version->rwlock);
 		isc_mem_put(rbtdb->common.mctx, rbtdb->current_version,
 			    sizeof(rbtdb_version_t));
@@ -1231,7 +1417,8 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 	 * We assume the number of remaining dead nodes is reasonably small;
 	 * the overhead of unlinking all nodes here should be negligible.
 	 */
-	for (i = 0; i < rbtdb->node_lock_count; i++) {
+	for (i = 0; i < (rbtdb->shard_count + 1) * rbtdb->node_lock_count;
+	     i++) {
 		dns_rbtnode_t *node;
 
 		node = ISC_LIST_HEAD(rbtdb->deadnodes[i]);
@@ -1249,6 +1436,8 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 		 * pick the next tree to (start to) destroy
 		 */
 		treep = &rbtdb->tree;
+		for (i = 0; *treep == NULL && i < rbtdb->shard_count; i++)
+			treep = &rbtdb->shards[i].tree;
 		if (*treep == NULL) {
 			treep = &rbtdb->nsec;
 			if (*treep == NULL) {
@@ -1305,21 +1494,25 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 	/*
 	 * Clean up LRU / re-signing order lists.
 	 */
-	if (rbtdb->rdatasets != NULL) {
-		for (i = 0; i < rbtdb->node_lock_count; i++)
-			INSIST(ISC_LIST_EMPTY(rbtdb->rdatasets[i]));
-		isc_mem_put(rbtdb->common.mctx, rbtdb->rdatasets,
-			    rbtdb->node_lock_count *
-			    sizeof(rdatasetheaderlist_t));
+	if (rbtdb->lru != NULL) {
+		for (i = 0; i < rbtdb->node_lock_count; i++) {
+			INSIST(ISC_LIST_EMPTY(rbtdb->lru[i].cold));
+			INSIST(ISC_LIST_EMPTY(rbtdb->lru[i].hot));
+		}
+		isc_mem_put(rbtdb->common.mctx, rbtdb->lru,
+			    rbtdb->node_lock_count * sizeof(rbtdb_lru_t));
 	}
 	/*
 	 * Clean up dead node buckets.
 	 */
 	if (rbtdb->deadnodes != NULL) {
-		for (i = 0; i < rbtdb->node_lock_count; i++)
+		for (i = 0;
+		     i < (rbtdb->shard_count + 1) * rbtdb->node_lock_count;
+		     i++)
 			INSIST(ISC_LIST_EMPTY(rbtdb->deadnodes[i]));
 		isc_mem_put(rbtdb->common.mctx, rbtdb->deadnodes,
-		    rbtdb->node_lock_count * sizeof(rbtnodelist_t));
+			    (rbtdb->shard_count + 1) *
+			    rbtdb->node_lock_count * sizeof(rbtnodelist_t));
 	}
 	/*
 	 * Clean up heap objects.
@@ -1335,6 +1528,8 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 		dns_stats_detach(&rbtdb->rrsetstats);
 	if (rbtdb->cachestats != NULL)
 		isc_stats_detach(&rbtdb->cachestats);
+	if (rbtdb->lockstats != NULL)
+		isc_stats_detach(&rbtdb->lockstats);
 
 	if (rbtdb->load_rpzs != NULL) {
 		/*
@@ -1351,6 +1546,12 @@ free_rbtdb(dns_rbtdb_t *rbtdb, isc_boolean_t log, isc_event_t *event) {
 
 	isc_mem_put(rbtdb->common.mctx, rbtdb->node_locks,
 		    rbtdb->node_lock_count * sizeof(rbtdb_nodelock_t));
+	if (rbtdb->shards != NULL) {
+		for (i = 0; i < rbtdb->shard_count; i++)
+			isc_rwlock_destroy(&rbtdb->shards[i].tree_lock);
+		isc_mem_put(rbtdb->common.mctx, rbtdb->shards,
+			    rbtdb->shard_count * sizeof(rbtdb_shard_t));
+	}
 	isc_rwlock_destroy(&rbtdb->tree_lock);
 	isc_refcount_destroy(&rbtdb->references);
 	if (rbtdb->task != NULL)
@@ -1393,6 +1594,13 @@ maybe_free_rbtdb(dns_rbtdb_t *rbtdb) {
 	if (rbtdb->nsnode != NULL)
 		dns_db_detachnode((dns_db_t *)rbtdb, &rbtdb->nsnode);
 
+	/*
+	 * The glue of the current version holds node references, so
+	 * it has to go before the nodes in use are counted below.
+	 */
+	if (rbtdb->current_version != NULL)
+		free_gluetable(rbtdb->current_version);
+
 	/*
 	 * Even though there are no external direct references, there still
 	 * may be nodes in use.
@@ -1481,6 +1689,9 @@ allocate_version(isc_mem_t *mctx, rbtdb_serial_t serial,
 	ISC_LIST_INIT(version->changed_list);
 	ISC_LIST_INIT(version->resigned_list);
 	ISC_LINK_INIT(version, link);
+	version->glue_table = NULL;
+	version->glue_table_bits = 0;
+	version->glue_table_count = 0;
 
 	return (version);
 }
@@ -1597,35 +1808,6 @@ add_changed(dns_rbtdb_t *rbtdb, rbtdb_version_t *version,
 	return (changed);
 }
 
-static void
-free_acachearray(isc_mem_t *mctx, rdatasetheader_t *header,
-		 acachectl_t *array)
-{
-	unsigned int count;
-	unsigned int i;
-	unsigned char *raw;     /* RDATASLAB */
-
-	/*
-	 * The caller must be holding the corresponding node lock.
-	 */
-
-	if (array == NULL)
-		return;
-
-	raw = (unsigned char *)header + sizeof(*header);
-	count = raw[0] * 256 + raw[1];
-
-	/*
-	 * Sanity check: since an additional cache entry has a reference to
-	 * the original DB node (in the callback arg), there should be no
-	 * acache entries when the node can be freed.
-	 */
-	for (i = 0; i < count; i++)
-		INSIST(array[i].entry == NULL && array[i].cbarg == NULL);
-
-	isc_mem_put(mctx, array, count * sizeof(acachectl_t));
-}
-
 static inline void
 free_noqname(isc_mem_t *mctx, struct noqname **noqname) {
 
@@ -1648,6 +1830,8 @@ init_rdataset(dns_rbtdb_t *rbtdb, rdatasetheader_t *h) {
 	h->is_mmapped = 0;
 	h->next_is_relative = 0;
 	h->node_is_relative = 0;
+	h->ext_is_mmapped = 0;
+	h->ext = NULL;
 
 #if TRACE_HEADER
 	if (IS_CACHE(rbtdb) && rbtdb->common.rdclass == dns_rdataclass_in)
@@ -1658,10 +1842,37 @@ init_rdataset(dns_rbtdb_t *rbtdb, rdatasetheader_t *h) {
 }
 
 /*
- * Update the copied values of 'next' and 'node' if they are relative.
+ * Return the side structure of 'h', allocating it if need be.
  */
-static void
-update_newheader(rdatasetheader_t *newh, rdatasetheader_t *old) {
+static rdatasetheader_ext_t *
+header_ext(dns_rbtdb_t *rbtdb, rdatasetheader_t *h) {
+	rdatasetheader_ext_t *ext;
+
+	if (h->ext != NULL)
+		return (h->ext);
+
+	ext = isc_mem_get(rbtdb->common.mctx, sizeof(*ext));
+	if (ext == NULL)
+		return (NULL);
+	ext->noqname = NULL;
+	ext->closest = NULL;
+	memset(ext->upper, 0xeb, sizeof(ext->upper));
+	h->ext = ext;
+	h->ext_is_mmapped = 0;
+	return (ext);
+}
+
+/*
+ * Update the copied values of 'next' and 'node' if they are relative,
+ * and copy the case of 'old' into 'newh' if it has been set.
+ *
+ * 'newh' must not share its side structure with any other header.
+ */
+static isc_result_t
+update_newheader(dns_rbtdb_t *rbtdb, rdatasetheader_t *newh,
+		 rdatasetheader_t *old)
+{
+	rdatasetheader_ext_t *ext;
 	char *p;
 
 	if (old->next_is_relative) {
@@ -1675,13 +1886,41 @@ update_newheader(rdatasetheader_t *newh, rdatasetheader_t *old) {
 		newh->node = (dns_rbtnode_t *)p;
 	}
 	if (CASESET(old)) {
-		isc_uint16_t attr;
-
-		memmove(newh->upper, old->upper, sizeof(old->upper));
-		attr = old->attributes & (RDATASET_ATTR_CASESET |
-					  RDATASET_ATTR_CASEFULLYLOWER);
-		newh->attributes |= attr;
+		newh->attributes &= ~(RDATASET_ATTR_CASESET |
+				      RDATASET_ATTR_CASEFULLYLOWER);
+		if (!CASEFULLYLOWER(old)) {
+			ext = header_ext(rbtdb, newh);
+			if (ext == NULL)
+				return (ISC_R_NOMEMORY);
+			memmove(ext->upper, old->ext->upper,
+				sizeof(ext->upper));
+		}
+		newh->attributes |= old->attributes &
+				    (RDATASET_ATTR_CASESET |
+				     RDATASET_ATTR_CASEFULLYLOWER);
 	}
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Free the side structure of 'h', and whatever hangs off it.
+ */
+static void
+free_ext(isc_mem_t *mctx, rdatasetheader_t *h) {
+	rdatasetheader_ext_t *ext = h->ext;
+
+	if (ext == NULL)
+		return;
+
+	if (ext->noqname != NULL)
+		free_noqname(mctx, &ext->noqname);
+	if (ext->closest != NULL)
+		free_noqname(mctx, &ext->closest);
+
+	if (!h->ext_is_mmapped)
+		isc_mem_put(mctx, ext, sizeof(*ext));
+	h->ext = NULL;
+	h->ext_is_mmapped = 0;
 }
 
 static inline rdatasetheader_t *
@@ -1696,7 +1935,6 @@ new_rdataset(dns_rbtdb_t *rbtdb, isc_mem_t *mctx) {
 	if (IS_CACHE(rbtdb) && rbtdb->common.rdclass == dns_rdataclass_in)
 		fprintf(stderr, "allocated header: %p\n", h);
 #endif
-	memset(h->upper, 0xeb, sizeof(h->upper));
 	init_rdataset(rbtdb, h);
 	h->rdh_ttl = 0;
 	return (h);
@@ -1715,20 +1953,14 @@ free_rdataset(dns_rbtdb_t *rbtdb, isc_mem_t *mctx, rdatasetheader_t *rdataset) {
 	idx = rdataset->node->locknum;
 	if (ISC_LINK_LINKED(rdataset, link)) {
 		INSIST(IS_CACHE(rbtdb));
-		ISC_LIST_UNLINK(rbtdb->rdatasets[idx], rdataset, link);
+		lru_unlink(rbtdb, rdataset);
 	}
 
 	if (rdataset->heap_index != 0)
 		isc_heap_delete(rbtdb->heaps[idx], rdataset->heap_index);
 	rdataset->heap_index = 0;
 
-	if (rdataset->noqname != NULL)
-		free_noqname(mctx, &rdataset->noqname);
-	if (rdataset->closest != NULL)
-		free_noqname(mctx, &rdataset->closest);
-
-	free_acachearray(mctx, rdataset, rdataset->additional_auth);
-	free_acachearray(mctx, rdataset, rdataset->additional_glue);
+	free_ext(mctx, rdataset);
 
 	if (NONEXISTENT(rdataset))
 		size = sizeof(*rdataset);
@@ -1742,6 +1974,40 @@ free_rdataset(dns_rbtdb_t *rbtdb, isc_mem_t *mctx, rdatasetheader_t *rdataset) {
 	isc_mem_put(mctx, rdataset, size);
 }
 
+/*
+ * 'header' is being kept in place of 'newheader': give it any proofs of
+ * nonexistence that 'newheader' has and it does not.
+ */
+static void
+move_proofs(rdatasetheader_t *header, rdatasetheader_t *newheader) {
+	rdatasetheader_ext_t *ext = newheader->ext;
+
+	if (ext == NULL || (ext->noqname == NULL && ext->closest == NULL))
+		return;
+
+	if (header->ext == NULL) {
+		/*
+		 * 'header' has no case vector (or it would have a side
+		 * structure), so that in 'ext' will never be looked at,
+		 * and 'newheader' has not been bound, so it has no
+		 * additional cache entries either: just take it over.
+		 */
+		header->ext = ext;
+		header->ext_is_mmapped = newheader->ext_is_mmapped;
+		newheader->ext = NULL;
+		return;
+	}
+
+	if (header->ext->noqname == NULL) {
+		header->ext->noqname = ext->noqname;
+		ext->noqname = NULL;
+	}
+	if (header->ext->closest == NULL) {
+		header->ext->closest = ext->closest;
+		ext->closest = NULL;
+	}
+}
+
 static inline void
 rollback_node(dns_rbtnode_t *node, rbtdb_serial_t serial) {
 	rdatasetheader_t *header, *dcurrent;
@@ -1963,6 +2229,37 @@ clean_zone_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 		node->dirty = 0;
 }
 
+/*%
+ * Return the shard that 'name' belongs in.
+ */
+static inline unsigned int
+name_shard(dns_rbtdb_t *rbtdb, const dns_name_t *name) {
+	dns_name_t suffix;
+	unsigned int labels;
+
+	labels = dns_name_countlabels(name);
+	if (rbtdb->shard_count == 0 || labels < SHARD_LABELS)
+		return (0);
+
+	dns_name_init(&suffix, NULL);
+	dns_name_getlabelsequence(name, labels - SHARD_LABELS, SHARD_LABELS,
+				  &suffix);
+	return (1 + dns_name_hash(&suffix, ISC_FALSE) % rbtdb->shard_count);
+}
+
+/*%
+ * Mark 'node', just added to the tree of 'shard', as being in it.  Any
+ * node above it may have been split off an existing one by
+ * dns_rbt_addnode(), so they are all marked.
+ *
+ * The caller must hold the shard's tree write lock.
+ */
+static inline void
+set_shard(dns_rbtnode_t *node, unsigned int shard) {
+	for (; node != NULL; node = node->parent)
+		node->shard = shard;
+}
+
 static void
 delete_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node) {
 	dns_rbtnode_t *nsecnode;
@@ -2003,7 +2300,8 @@ delete_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node) {
 		 */
 		node_has_rpz = node->rpz;
 		node->rpz = 0;
-		result = dns_rbt_deletenode(rbtdb->tree, node, ISC_FALSE);
+		result = dns_rbt_deletenode(SHARD_TREE(rbtdb, node->shard),
+					    node, ISC_FALSE);
 		if (result == ISC_R_SUCCESS &&
 		    rbtdb->rpzs != NULL && node_has_rpz)
 			dns_rpz_delete(rbtdb->rpzs, rbtdb->rpz_num, name);
@@ -2046,7 +2344,8 @@ delete_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node) {
 		 */
 		node_has_rpz = node->rpz;
 		node->rpz = 0;
-		result = dns_rbt_deletenode(rbtdb->tree, node, ISC_FALSE);
+		result = dns_rbt_deletenode(SHARD_TREE(rbtdb, node->shard),
+					    node, ISC_FALSE);
 		if (result == ISC_R_SUCCESS &&
 		    rbtdb->rpzs != NULL && node_has_rpz)
 			dns_rpz_delete(rbtdb->rpzs, rbtdb->rpz_num, name);
@@ -2093,16 +2392,18 @@ new_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node) {
  * them when we deleted all the data at that node because we did not want
  * to wait for the tree write lock.
  *
- * The caller must hold a tree write lock and bucketnum'th node (write) lock.
+ * The caller must hold the shard's tree write lock and bucketnum'th node
+ * (write) lock.
  */
 static void
-cleanup_dead_nodes(dns_rbtdb_t *rbtdb, int bucketnum) {
+cleanup_dead_nodes(dns_rbtdb_t *rbtdb, unsigned int shard, int bucketnum) {
 	dns_rbtnode_t *node;
 	int count = 10;         /* XXXJT: should be adjustable */
 
-	node = ISC_LIST_HEAD(rbtdb->deadnodes[bucketnum]);
+	node = ISC_LIST_HEAD(DEADNODES(rbtdb, shard, bucketnum));
 	while (node != NULL && count > 0) {
-		ISC_LIST_UNLINK(rbtdb->deadnodes[bucketnum], node, deadlink);
+		ISC_LIST_UNLINK(DEADNODES(rbtdb, shard, bucketnum), node,
+				deadlink);
 
 		/*
 		 * Since we're holding a tree write lock, it should be
@@ -2129,13 +2430,14 @@ cleanup_dead_nodes(dns_rbtdb_t *rbtdb, int bucketnum) {
 				ev->ev_sender = db;
 				isc_task_send(rbtdb->task, &ev);
 			} else {
-				ISC_LIST_APPEND(rbtdb->deadnodes[bucketnum],
+				ISC_LIST_APPEND(DEADNODES(rbtdb, shard,
+							  bucketnum),
 						node, deadlink);
 			}
 		} else {
 			delete_node(rbtdb, node);
 		}
-		node = ISC_LIST_HEAD(rbtdb->deadnodes[bucketnum]);
+		node = ISC_LIST_HEAD(DEADNODES(rbtdb, shard, bucketnum));
 		count--;
 	}
 }
@@ -2167,7 +2469,7 @@ reactivate_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	 * Check if we can possibly cleanup the dead node.  If so, upgrade
 	 * the node lock below to perform the cleanup.
 	 */
-	if (!ISC_LIST_EMPTY(rbtdb->deadnodes[node->locknum]) &&
+	if (!ISC_LIST_EMPTY(DEADNODES(rbtdb, node->shard, node->locknum)) &&
 	    treelocktype == isc_rwlocktype_write) {
 		maybe_cleanup = ISC_TRUE;
 	}
@@ -2181,10 +2483,11 @@ reactivate_node(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 		POST(locktype);
 		NODE_WEAKLOCK(nodelock, locktype);
 		if (ISC_LINK_LINKED(node, deadlink))
-			ISC_LIST_UNLINK(rbtdb->deadnodes[node->locknum],
+			ISC_LIST_UNLINK(DEADNODES(rbtdb, node->shard,
+						  node->locknum),
 					node, deadlink);
 		if (maybe_cleanup)
-			cleanup_dead_nodes(rbtdb, node->locknum);
+			cleanup_dead_nodes(rbtdb, node->shard, node->locknum);
 	}
 
 	new_reference(rbtdb, node);
@@ -2216,6 +2519,7 @@ decrement_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	isc_result_t result;
 	isc_boolean_t write_locked;
 	rbtdb_nodelock_t *nodelock;
+	isc_rwlock_t *tree_lock = SHARD_LOCK(rbtdb, node->shard);
 	unsigned int refs, nrefs;
 	int bucket = node->locknum;
 	isc_boolean_t no_reference = ISC_TRUE;
@@ -2282,9 +2586,9 @@ decrement_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 		 * we only do a trylock.
 		 */
 		if (tlock == isc_rwlocktype_read)
-			result = isc_rwlock_tryupgrade(&rbtdb->tree_lock);
+			result = isc_rwlock_tryupgrade(tree_lock);
 		else
-			result = isc_rwlock_trylock(&rbtdb->tree_lock,
+			result = isc_rwlock_trylock(tree_lock,
 						    isc_rwlocktype_write);
 		RUNTIME_CHECK(result == ISC_R_SUCCESS ||
 			      result == ISC_R_LOCKBUSY);
@@ -2357,8 +2661,9 @@ decrement_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 					      "allocate pruning event");
 				INSIST(node->data == NULL);
 				INSIST(!ISC_LINK_LINKED(node, deadlink));
-				ISC_LIST_APPEND(rbtdb->deadnodes[bucket], node,
-						deadlink);
+				ISC_LIST_APPEND(DEADNODES(rbtdb, node->shard,
+							  bucket),
+						node, deadlink);
 			}
 		} else {
 			delete_node(rbtdb, node);
@@ -2366,7 +2671,8 @@ decrement_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	} else {
 		INSIST(node->data == NULL);
 		INSIST(!ISC_LINK_LINKED(node, deadlink));
-		ISC_LIST_APPEND(rbtdb->deadnodes[bucket], node, deadlink);
+		ISC_LIST_APPEND(DEADNODES(rbtdb, node->shard, bucket), node,
+				deadlink);
 	}
 
  restore_locks:
@@ -2379,11 +2685,11 @@ decrement_reference(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	 */
 	if (tlock == isc_rwlocktype_none)
 		if (write_locked)
-			RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+			RWUNLOCK(tree_lock, isc_rwlocktype_write);
 
 	if (tlock == isc_rwlocktype_read)
 		if (write_locked)
-			isc_rwlock_downgrade(&rbtdb->tree_lock);
+			isc_rwlock_downgrade(tree_lock);
 
 	return (no_reference);
 }
@@ -2400,13 +2706,15 @@ prune_tree(isc_task_t *task, isc_event_t *event) {
 	dns_rbtdb_t *rbtdb = event->ev_sender;
 	dns_rbtnode_t *node = event->ev_arg;
 	dns_rbtnode_t *parent;
+	isc_rwlock_t *tree_lock;
 	unsigned int locknum;
 
 	UNUSED(task);
 
 	isc_event_free(&event);
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+	tree_lock = SHARD_LOCK(rbtdb, node->shard);
+	RWLOCK(tree_lock, isc_rwlocktype_write);
 	locknum = node->locknum;
 	NODE_LOCK(&rbtdb->node_locks[locknum].lock, isc_rwlocktype_write);
 	do {
@@ -2437,7 +2745,8 @@ prune_tree(isc_task_t *task, isc_event_t *event) {
 			 * reactivate_node().
 			 */
 			if (ISC_LINK_LINKED(parent, deadlink))
-				ISC_LIST_UNLINK(rbtdb->deadnodes[locknum],
+				ISC_LIST_UNLINK(DEADNODES(rbtdb, parent->shard,
+							  locknum),
 						parent, deadlink);
 			new_reference(rbtdb, parent);
 		} else
@@ -2446,7 +2755,7 @@ prune_tree(isc_task_t *task, isc_event_t *event) {
 		node = parent;
 	} while (node != NULL);
 	NODE_UNLOCK(&rbtdb->node_locks[locknum].lock, isc_rwlocktype_write);
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+	RWUNLOCK(tree_lock, isc_rwlocktype_write);
 
 	detach((dns_db_t **)&rbtdb);
 }
@@ -2648,20 +2957,23 @@ static void
 cleanup_dead_nodes_callback(isc_task_t *task, isc_event_t *event) {
 	dns_rbtdb_t *rbtdb = event->ev_arg;
 	isc_boolean_t again = ISC_FALSE;
-	unsigned int locknum;
+	unsigned int locknum, shard;
 	unsigned int refs;
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
-	for (locknum = 0; locknum < rbtdb->node_lock_count; locknum++) {
-		NODE_LOCK(&rbtdb->node_locks[locknum].lock,
-			  isc_rwlocktype_write);
-		cleanup_dead_nodes(rbtdb, locknum);
-		if (ISC_LIST_HEAD(rbtdb->deadnodes[locknum]) != NULL)
-			again = ISC_TRUE;
-		NODE_UNLOCK(&rbtdb->node_locks[locknum].lock,
-			    isc_rwlocktype_write);
+	for (shard = 0; shard <= rbtdb->shard_count; shard++) {
+		RWLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_write);
+		for (locknum = 0; locknum < rbtdb->node_lock_count; locknum++) {
+			NODE_LOCK(&rbtdb->node_locks[locknum].lock,
+				  isc_rwlocktype_write);
+			cleanup_dead_nodes(rbtdb, shard, locknum);
+			if (ISC_LIST_HEAD(DEADNODES(rbtdb, shard, locknum))
+			    != NULL)
+				again = ISC_TRUE;
+			NODE_UNLOCK(&rbtdb->node_locks[locknum].lock,
+				    isc_rwlocktype_write);
+		}
+		RWUNLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_write);
 	}
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
 	if (again)
 		isc_task_send(task, &event);
 	else {
@@ -2847,6 +3159,7 @@ closeversion(dns_db_t *db, dns_dbversion_t **versionp, isc_boolean_t commit) {
 
 	if (cleanup_version != NULL) {
 		INSIST(EMPTY(cleanup_version->changed_list));
+		free_gluetable(cleanup_version);
 		isc_rwlock_destroy(&cleanup_version->rwlock);
 		isc_mem_put(rbtdb->common.mctx, cleanup_version,
 			    sizeof(*cleanup_version));
@@ -2920,7 +3233,8 @@ closeversion(dns_db_t *db, dns_dbversion_t **versionp, isc_boolean_t commit) {
 			 * so use it.
 			 */
 			if (event == NULL)
-				cleanup_dead_nodes(rbtdb, rbtnode->locknum);
+				cleanup_dead_nodes(rbtdb, rbtnode->shard,
+						   rbtnode->locknum);
 
 			if (rollback)
 				rollback_node(rbtnode, serial);
@@ -3018,15 +3332,23 @@ findnodeintree(dns_rbtdb_t *rbtdb, dns_rbt_t *tree, dns_name_t *name,
 	dns_name_t nodename;
 	isc_result_t result;
 	isc_rwlocktype_t locktype = isc_rwlocktype_read;
+	isc_rwlock_t *tree_lock;
+	unsigned int shard = 0;
 
 	INSIST(tree == rbtdb->tree || tree == rbtdb->nsec3);
 
+	if (tree == rbtdb->tree) {
+		shard = name_shard(rbtdb, name);
+		tree = SHARD_TREE(rbtdb, shard);
+	}
+	tree_lock = SHARD_LOCK(rbtdb, shard);
+
 	dns_name_init(&nodename, NULL);
-	RWLOCK(&rbtdb->tree_lock, locktype);
+	RWLOCK(tree_lock, locktype);
 	result = dns_rbt_findnode(tree, name, NULL, &node, NULL,
 				  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
 	if (result != ISC_R_SUCCESS) {
-		RWUNLOCK(&rbtdb->tree_lock, locktype);
+		RWUNLOCK(tree_lock, locktype);
 		if (!create) {
 			if (result == DNS_R_PARTIALMATCH)
 				result = ISC_R_NOTFOUND;
@@ -3037,10 +3359,12 @@ findnodeintree(dns_rbtdb_t *rbtdb, dns_rbt_t *tree, dns_name_t *name,
 		 * unlocking then relocking.
 		 */
 		locktype = isc_rwlocktype_write;
-		RWLOCK(&rbtdb->tree_lock, locktype);
+		RWLOCK(tree_lock, locktype);
 		node = NULL;
 		result = dns_rbt_addnode(tree, name, &node);
 		if (result == ISC_R_SUCCESS) {
+			if (shard != 0)
+				set_shard(node, shard);
 			dns_rbt_namefromnode(node, &nodename);
 #ifdef DNS_RBT_USEHASH
 			node->locknum = node->hashval % rbtdb->node_lock_count;
@@ -3054,7 +3378,7 @@ findnodeintree(dns_rbtdb_t *rbtdb, dns_rbt_t *tree, dns_name_t *name,
 				if (dns_name_iswildcard(name)) {
 					result = add_wildcard_magic(rbtdb, name);
 					if (result != ISC_R_SUCCESS) {
-						RWUNLOCK(&rbtdb->tree_lock, locktype);
+						RWUNLOCK(tree_lock, locktype);
 						return (result);
 					}
 				}
@@ -3062,7 +3386,7 @@ findnodeintree(dns_rbtdb_t *rbtdb, dns_rbt_t *tree, dns_name_t *name,
 			if (tree == rbtdb->nsec3)
 				node->nsec = DNS_RBT_NSEC_NSEC3;
 		} else if (result != ISC_R_EXISTS) {
-			RWUNLOCK(&rbtdb->tree_lock, locktype);
+			RWUNLOCK(tree_lock, locktype);
 			return (result);
 		}
 	}
@@ -3100,7 +3424,7 @@ findnodeintree(dns_rbtdb_t *rbtdb, dns_rbt_t *tree, dns_name_t *name,
 		}
 	}
 
-	RWUNLOCK(&rbtdb->tree_lock, locktype);
+	RWUNLOCK(tree_lock, locktype);
 
 	*nodep = (dns_dbnode_t *)node;
 
@@ -3299,8 +3623,17 @@ bind_rdataset(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	rdataset->rdclass = rbtdb->common.rdclass;
 	rdataset->type = RBTDB_RDATATYPE_BASE(header->type);
 	rdataset->covers = RBTDB_RDATATYPE_EXT(header->type);
-	rdataset->ttl = header->rdh_ttl - now;
 	rdataset->trust = header->trust;
+	if (IS_CACHE(rbtdb) && !ACTIVE(header, now)) {
+		/*
+		 * Expired, and only found because the caller asked for
+		 * stale data: the TTL is what is left of the stale window.
+		 */
+		rdataset->ttl = header->rdh_ttl + STALE_TTL(header, rbtdb);
+		rdataset->ttl = (rdataset->ttl > now) ? rdataset->ttl - now : 0;
+		rdataset->attributes |= DNS_RDATASETATTR_STALE;
+	} else
+		rdataset->ttl = header->rdh_ttl - now;
 	if (NEGATIVE(header))
 		rdataset->attributes |= DNS_RDATASETATTR_NEGATIVE;
 	if (NXDOMAIN(header))
@@ -3326,19 +3659,24 @@ bind_rdataset(dns_rbtdb_t *rbtdb, dns_rbtnode_t *node,
 	/*
 	 * Add noqname proof.
 	 */
-	rdataset->private6 = header->noqname;
-	if (rdataset->private6 != NULL)
-		rdataset->attributes |=  DNS_RDATASETATTR_NOQNAME;
-	rdataset->private7 = header->closest;
-	if (rdataset->private7 != NULL)
-		rdataset->attributes |=  DNS_RDATASETATTR_CLOSEST;
+	if (header->ext != NULL) {
+		rdataset->private6 = header->ext->noqname;
+		if (rdataset->private6 != NULL)
+			rdataset->attributes |=  DNS_RDATASETATTR_NOQNAME;
+		rdataset->private7 = header->ext->closest;
+		if (rdataset->private7 != NULL)
+			rdataset->attributes |=  DNS_RDATASETATTR_CLOSEST;
+	} else {
+		rdataset->private6 = NULL;
+		rdataset->private7 = NULL;
+	}
 
 	/*
 	 * Copy out re-signing information.
 	 */
 	if (RESIGN(header)) {
 		rdataset->attributes |=  DNS_RDATASETATTR_RESIGN;
-		rdataset->resign = (header->resign << 1) | header->resign_lsb;
+		rdataset->resign = (header->u.resign << 1) | header->resign_lsb;
 	} else
 		rdataset->resign = 0;
 }
@@ -4673,13 +5011,27 @@ check_stale_header(dns_rbtnode_t *node, rdatasetheader_t *header,
 #endif
 
 	if (!ACTIVE(header, search->now)) {
+		isc_stdtime_t stale = header->rdh_ttl;
+
+		if (!STALE(header))
+			stale += STALE_TTL(header, search->rbtdb);
+		/*
+		 * If this data is in the serve-stale window, keep it, and
+		 * return it if DNS_DBFIND_STALEOK is set.
+		 */
+		if (KEEPSTALE(search->rbtdb) && stale > search->now) {
+			*header_prev = header;
+			return (ISC_TF((search->options &
+					DNS_DBFIND_STALEOK) == 0));
+		}
+
 		/*
 		 * This rdataset is stale.  If no one else is using the
 		 * node, we can clean it up right now, otherwise we mark
 		 * it as stale, and the node as dirty, so it will get
 		 * cleaned up later.
 		 */
-		if ((header->rdh_ttl < search->now - RBTDB_VIRTUAL) &&
+		if ((stale < search->now - RBTDB_VIRTUAL) &&
 		    (*locktype == isc_rwlocktype_write ||
 		     NODE_TRYUPGRADE(lock) == ISC_R_SUCCESS))
 		{
@@ -5044,6 +5396,47 @@ rpz_ready(dns_db_t *db) {
 	return (result);
 }
 
+/*%
+ * Search the main tree of a sharded cache for a zone cut above 'name',
+ * which is in a shard.  With 'dname' set, only a DNAME is looked for: one
+ * at or above a top-level domain overrides anything in the shard.
+ * Otherwise, this finds the deepest NS rdataset, for when the shard had
+ * none for the name.
+ */
+static isc_result_t
+cache_findtop(rbtdb_search_t *search, dns_name_t *name, isc_boolean_t dname,
+	      dns_dbnode_t **nodep, dns_name_t *foundname,
+	      dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	dns_rbtdb_t *rbtdb = search->rbtdb;
+	dns_rbtnode_t *node = NULL;
+	isc_result_t result;
+
+	REQUIRE(search->zonecut == NULL);
+
+	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+
+	result = dns_rbt_findnode(rbtdb->tree, name, foundname, &node,
+				  &search->chain, DNS_RBTFIND_EMPTYDATA,
+				  dname ? cache_zonecut_callback : NULL,
+				  search);
+	if (result == DNS_R_PARTIALMATCH) {
+		if (search->zonecut != NULL)
+			result = setup_delegation(search, nodep, foundname,
+						  rdataset, sigrdataset);
+		else if (dname)
+			result = ISC_R_NOTFOUND;
+		else
+			result = find_deepest_zonecut(search, node, nodep,
+						      foundname, rdataset,
+						      sigrdataset);
+	}
+
+	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+
+	return (result);
+}
+
 static isc_result_t
 cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
 	   dns_rdatatype_t type, unsigned int options, isc_stdtime_t now,
@@ -5062,6 +5455,8 @@ cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
 	rdatasetheader_t *foundsig, *nssig, *cnamesig;
 	rdatasetheader_t *update, *updatesig;
 	rbtdb_rdatatype_t sigtype, negtype;
+	isc_rwlock_t *tree_lock;
+	unsigned int shard;
 
 	UNUSED(version);
 
@@ -5086,15 +5481,26 @@ cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
 	update = NULL;
 	updatesig = NULL;
 
-	RWLOCK(&search.rbtdb->tree_lock, isc_rwlocktype_read);
+	shard = name_shard(search.rbtdb, name);
+	tree_lock = SHARD_LOCK(search.rbtdb, shard);
+
+	if (shard != 0 && search.rbtdb->top_dname) {
+		result = cache_findtop(&search, name, ISC_TRUE, nodep,
+				       foundname, rdataset, sigrdataset);
+		if (result != ISC_R_NOTFOUND)
+			goto cleanup;
+	}
+
+	RWLOCK(tree_lock, isc_rwlocktype_read);
 
 	/*
 	 * Search down from the root of the tree.  If, while going down, we
 	 * encounter a callback node, cache_zonecut_callback() will search the
 	 * rdatasets at the zone cut for a DNAME rdataset.
 	 */
-	result = dns_rbt_findnode(search.rbtdb->tree, name, foundname, &node,
-				  &search.chain, DNS_RBTFIND_EMPTYDATA,
+	result = dns_rbt_findnode(SHARD_TREE(search.rbtdb, shard), name,
+				  foundname, &node, &search.chain,
+				  DNS_RBTFIND_EMPTYDATA,
 				  cache_zonecut_callback, &search);
 
 	if (result == DNS_R_PARTIALMATCH) {
@@ -5308,6 +5714,9 @@ cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
 	    result == DNS_R_NCACHENXRRSET) {
 		bind_rdataset(search.rbtdb, node, found, search.now,
 			      rdataset);
+		if (HOT(found) && search.rbtdb->cachestats != NULL)
+			isc_stats_increment(search.rbtdb->cachestats,
+					    dns_cachestatscounter_hothits);
 		if (need_headerupdate(found, search.now))
 			update = found;
 		if (!NEGATIVE(found) && foundsig != NULL) {
@@ -5334,8 +5743,16 @@ cache_find(dns_db_t *db, dns_name_t *name, dns_dbversion_t *version,
 	NODE_UNLOCK(lock, locktype);
 
  tree_exit:
-	RWUNLOCK(&search.rbtdb->tree_lock, isc_rwlocktype_read);
+	RWUNLOCK(tree_lock, isc_rwlocktype_read);
 
+	/*
+	 * The zone cut may be above the shard.
+	 */
+	if (result == ISC_R_NOTFOUND && shard != 0 && search.zonecut == NULL)
+		result = cache_findtop(&search, name, ISC_FALSE, nodep,
+				       foundname, rdataset, sigrdataset);
+
+ cleanup:
 	/*
 	 * If we found a zonecut but aren't going to use it, we have to
 	 * let go of it.
@@ -5372,6 +5789,8 @@ cache_findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
 	rdatasetheader_t *found, *foundsig;
 	unsigned int rbtoptions = DNS_RBTFIND_EMPTYDATA;
 	isc_rwlocktype_t locktype;
+	isc_rwlock_t *tree_lock;
+	unsigned int shard;
 
 	search.rbtdb = (dns_rbtdb_t *)db;
 
@@ -5394,13 +5813,17 @@ cache_findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
 	if ((options & DNS_DBFIND_NOEXACT) != 0)
 		rbtoptions |= DNS_RBTFIND_NOEXACT;
 
-	RWLOCK(&search.rbtdb->tree_lock, isc_rwlocktype_read);
+	shard = name_shard(search.rbtdb, name);
+	tree_lock = SHARD_LOCK(search.rbtdb, shard);
+
+	RWLOCK(tree_lock, isc_rwlocktype_read);
 
 	/*
 	 * Search down from the root of the tree.
 	 */
-	result = dns_rbt_findnode(search.rbtdb->tree, name, foundname, &node,
-				  &search.chain, rbtoptions, NULL, &search);
+	result = dns_rbt_findnode(SHARD_TREE(search.rbtdb, shard), name,
+				  foundname, &node, &search.chain, rbtoptions,
+				  NULL, &search);
 
 	if (result == DNS_R_PARTIALMATCH) {
 	find_ns:
@@ -5489,7 +5912,14 @@ cache_findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
 	NODE_UNLOCK(lock, locktype);
 
  tree_exit:
-	RWUNLOCK(&search.rbtdb->tree_lock, isc_rwlocktype_read);
+	RWUNLOCK(tree_lock, isc_rwlocktype_read);
+
+	/*
+	 * The zone cut may be above the shard.
+	 */
+	if (result == ISC_R_NOTFOUND && shard != 0)
+		result = cache_findtop(&search, name, ISC_FALSE, nodep,
+				       foundname, rdataset, sigrdataset);
 
 	INSIST(!search.need_cleanup);
 
@@ -5623,7 +6053,9 @@ expirenode(dns_db_t *db, dns_dbnode_t *node, isc_stdtime_t now) {
 		  isc_rwlocktype_write);
 
 	for (header = rbtnode->data; header != NULL; header = header->next)
-		if (header->rdh_ttl <= now - RBTDB_VIRTUAL) {
+		if (header->rdh_ttl + STALE_TTL(header, rbtdb) <=
+		    now - RBTDB_VIRTUAL)
+		{
 			/*
 			 * We don't check if refcurrent(rbtnode) == 0 and try
 			 * to free like we do in cache_find(), because
@@ -5699,7 +6131,7 @@ printnode(dns_db_t *db, dns_dbnode_t *node, FILE *out) {
 					current->rdh_ttl,
 					current->trust,
 					current->attributes,
-					(current->resign << 1) |
+					(current->u.resign << 1) |
 					current->resign_lsb);
 				current = current->down;
 			} while (current != NULL);
@@ -5732,6 +6164,7 @@ createiterator(dns_db_t *db, unsigned int options, dns_dbiterator_t **iteratorp)
 	rbtdbiter->common.cleaning = ISC_FALSE;
 	rbtdbiter->paused = ISC_TRUE;
 	rbtdbiter->tree_locked = isc_rwlocktype_none;
+	rbtdbiter->shard = 0;
 	rbtdbiter->result = ISC_R_SUCCESS;
 	dns_fixedname_init(&rbtdbiter->name);
 	dns_fixedname_init(&rbtdbiter->origin);
@@ -5739,6 +6172,11 @@ createiterator(dns_db_t *db, unsigned int options, dns_dbiterator_t **iteratorp)
 	rbtdbiter->delcnt = 0;
 	rbtdbiter->nsec3only = ISC_TF((options & DNS_DB_NSEC3ONLY) != 0);
 	rbtdbiter->nonsec3 = ISC_TF((options & DNS_DB_NONSEC3) != 0);
+	/*
+	 * Nothing is added to the NSEC3 tree of a cache.
+	 */
+	if (rbtdb->shard_count != 0 && !rbtdbiter->nsec3only)
+		rbtdbiter->nonsec3 = ISC_TRUE;
 	memset(rbtdbiter->deletions, 0, sizeof(rbtdbiter->deletions));
 	dns_rbtnodechain_init(&rbtdbiter->chain, db->mctx);
 	dns_rbtnodechain_init(&rbtdbiter->nsec3chain, db->mctx);
@@ -5879,7 +6317,8 @@ cache_findrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	for (header = rbtnode->data; header != NULL; header = header_next) {
 		header_next = header->next;
 		if (!ACTIVE(header, now)) {
-			if ((header->rdh_ttl < now - RBTDB_VIRTUAL) &&
+			if ((header->rdh_ttl + STALE_TTL(header, rbtdb) <
+			     now - RBTDB_VIRTUAL) &&
 			    (locktype == isc_rwlocktype_write ||
 			     NODE_TRYUPGRADE(lock) == ISC_R_SUCCESS)) {
 				/*
@@ -6118,6 +6557,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 {
 	rbtdb_changed_t *changed = NULL;
 	rdatasetheader_t *topheader, *topheader_prev, *header, *sigheader;
+	rdatasetheader_ext_t *ext;
 	unsigned char *merged;
 	isc_result_t result;
 	isc_boolean_t header_nx;
@@ -6335,17 +6775,30 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 				 * We don't know this, however, so we leave it
 				 * alone.  It will get cleaned up when
 				 * clean_zone_node() runs.
+				 *
+				 * The merged header is a copy of 'newheader',
+				 * so it takes over its side structure.
 				 */
+				ext = newheader->ext;
+				newheader->ext = NULL;
 				free_rdataset(rbtdb, rbtdb->common.mctx,
 					      newheader);
 				newheader = (rdatasetheader_t *)merged;
 				init_rdataset(rbtdb, newheader);
-				update_newheader(newheader, header);
-				if (loading && RESIGN(newheader) &&
-				    RESIGN(header) &&
+				newheader->ext = ext;
+				result = update_newheader(rbtdb, newheader,
+							  header);
+				if (result != ISC_R_SUCCESS) {
+					free_rdataset(rbtdb,
+						      rbtdb->common.mctx,
+						      newheader);
+					return (result);
+				}
+				if (loading && RESIGN(newheader) &&
+				    RESIGN(header) &&
 				    resign_sooner(header, newheader))
 				{
-					newheader->resign = header->resign;
+					newheader->u.resign = header->u.resign;
 					newheader->resign_lsb =
 							header->resign_lsb;
 				}
@@ -6377,16 +6830,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 			 */
 			if (header->rdh_ttl > newheader->rdh_ttl)
 				set_ttl(rbtdb, header, newheader->rdh_ttl);
-			if (header->noqname == NULL &&
-			    newheader->noqname != NULL) {
-				header->noqname = newheader->noqname;
-				newheader->noqname = NULL;
-			}
-			if (header->closest == NULL &&
-			    newheader->closest != NULL) {
-				header->closest = newheader->closest;
-				newheader->closest = NULL;
-			}
+			move_proofs(header, newheader);
 			free_rdataset(rbtdb, rbtdb->common.mctx, newheader);
 			if (addedrdataset != NULL)
 				bind_rdataset(rbtdb, rbtnode, header, now,
@@ -6423,16 +6867,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 			 */
 			if (header->rdh_ttl > newheader->rdh_ttl)
 				set_ttl(rbtdb, header, newheader->rdh_ttl);
-			if (header->noqname == NULL &&
-			    newheader->noqname != NULL) {
-				header->noqname = newheader->noqname;
-				newheader->noqname = NULL;
-			}
-			if (header->closest == NULL &&
-			    newheader->closest != NULL) {
-				header->closest = newheader->closest;
-				newheader->closest = NULL;
-			}
+			move_proofs(header, newheader);
 			free_rdataset(rbtdb, rbtdb->common.mctx, newheader);
 			if (addedrdataset != NULL)
 				bind_rdataset(rbtdb, rbtnode, header, now,
@@ -6445,12 +6880,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 			newheader->down = NULL;
 			idx = newheader->node->locknum;
 			if (IS_CACHE(rbtdb)) {
-				if (ZEROTTL(newheader))
-					ISC_LIST_APPEND(rbtdb->rdatasets[idx],
-							newheader, link);
-				else
-					ISC_LIST_PREPEND(rbtdb->rdatasets[idx],
-							 newheader, link);
+				lru_insert(rbtdb, newheader, HOT(header));
 				INSIST(rbtdb->heaps != NULL);
 				result = isc_heap_insert(rbtdb->heaps[idx],
 							 newheader);
@@ -6507,12 +6937,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 						      newheader);
 					return (result);
 				}
-				if (ZEROTTL(newheader))
-					ISC_LIST_APPEND(rbtdb->rdatasets[idx],
-							newheader, link);
-				else
-					ISC_LIST_PREPEND(rbtdb->rdatasets[idx],
-							 newheader, link);
+				lru_insert(rbtdb, newheader, HOT(header));
 			} else if (RESIGN(newheader)) {
 				result = resign_insert(rbtdb, idx, newheader);
 				if (result != ISC_R_SUCCESS) {
@@ -6572,12 +6997,7 @@ add32(dns_rbtdb_t *rbtdb, dns_rbtnode_t *rbtnode, rbtdb_version_t *rbtversion,
 					      newheader);
 				return (result);
 			}
-			if (ZEROTTL(newheader))
-				ISC_LIST_APPEND(rbtdb->rdatasets[idx],
-						newheader, link);
-			else
-				ISC_LIST_PREPEND(rbtdb->rdatasets[idx],
-						 newheader, link);
+			lru_insert(rbtdb, newheader, ISC_FALSE);
 		} else if (RESIGN(newheader)) {
 			result = resign_insert(rbtdb, idx, newheader);
 			if (result != ISC_R_SUCCESS) {
@@ -6660,6 +7080,7 @@ addnoqname(dns_rbtdb_t *rbtdb, rdatasetheader_t *newheader,
 	   dns_rdataset_t *rdataset)
 {
 	struct noqname *noqname;
+	rdatasetheader_ext_t *ext;
 	isc_mem_t *mctx = rbtdb->common.mctx;
 	dns_name_t name;
 	dns_rdataset_t neg, negsig;
@@ -6693,9 +7114,14 @@ addnoqname(dns_rbtdb_t *rbtdb, rdatasetheader_t *newheader,
 	if (result != ISC_R_SUCCESS)
 		goto cleanup;
 	noqname->negsig = r.base;
+	ext = header_ext(rbtdb, newheader);
+	if (ext == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto cleanup;
+	}
 	dns_rdataset_disassociate(&neg);
 	dns_rdataset_disassociate(&negsig);
-	newheader->noqname = noqname;
+	ext->noqname = noqname;
 	return (ISC_R_SUCCESS);
 
 cleanup:
@@ -6711,6 +7137,7 @@ addclosest(dns_rbtdb_t *rbtdb, rdatasetheader_t *newheader,
 	   dns_rdataset_t *rdataset)
 {
 	struct noqname *closest;
+	rdatasetheader_ext_t *ext;
 	isc_mem_t *mctx = rbtdb->common.mctx;
 	dns_name_t name;
 	dns_rdataset_t neg, negsig;
@@ -6744,9 +7171,14 @@ addclosest(dns_rbtdb_t *rbtdb, rdatasetheader_t *newheader,
 	if (result != ISC_R_SUCCESS)
 		goto cleanup;
 	closest->negsig = r.base;
+	ext = header_ext(rbtdb, newheader);
+	if (ext == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto cleanup;
+	}
 	dns_rdataset_disassociate(&neg);
 	dns_rdataset_disassociate(&negsig);
-	newheader->closest = closest;
+	ext->closest = closest;
 	return (ISC_R_SUCCESS);
 
  cleanup:
@@ -6774,6 +7206,7 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	isc_boolean_t delegating;
 	isc_boolean_t newnsec;
 	isc_boolean_t tree_locked = ISC_FALSE;
+	isc_rwlock_t *tree_lock;
 	isc_boolean_t cache_is_overmem = ISC_FALSE;
 	dns_fixedname_t fixed;
 	dns_name_t *name;
@@ -6800,29 +7233,26 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	if (result != ISC_R_SUCCESS)
 		return (result);
 
+	tree_lock = SHARD_LOCK(rbtdb, rbtnode->shard);
+
 	dns_fixedname_init(&fixed);
 	name = dns_fixedname_name(&fixed);
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	RWLOCK(tree_lock, isc_rwlocktype_read);
 	dns_rbt_fullnamefromnode(node, name);
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	RWUNLOCK(tree_lock, isc_rwlocktype_read);
 	dns_rdataset_getownercase(rdataset, name);
 
 	newheader = (rdatasetheader_t *)region.base;
 	init_rdataset(rbtdb, newheader);
-	setownercase(newheader, name);
 	set_ttl(rbtdb, newheader, rdataset->ttl + now);
 	newheader->type = RBTDB_RDATATYPE_VALUE(rdataset->type,
 						rdataset->covers);
 	newheader->attributes = 0;
 	if (rdataset->ttl == 0U)
 		newheader->attributes |= RDATASET_ATTR_ZEROTTL;
-	newheader->noqname = NULL;
-	newheader->closest = NULL;
+	setownercase(rbtdb, newheader, name);
 	newheader->count = init_count++;
 	newheader->trust = rdataset->trust;
-	newheader->additional_auth = NULL;
-	newheader->additional_glue = NULL;
-	newheader->last_used = now;
 	newheader->node = rbtnode;
 	if (rbtversion != NULL) {
 		newheader->serial = rbtversion->serial;
@@ -6830,16 +7260,16 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 
 		if ((rdataset->attributes & DNS_RDATASETATTR_RESIGN) != 0) {
 			newheader->attributes |= RDATASET_ATTR_RESIGN;
-			newheader->resign = (isc_stdtime_t)
+			newheader->u.resign = (isc_stdtime_t)
 				(dns_time64_from32(rdataset->resign) >> 1);
 			newheader->resign_lsb = rdataset->resign & 0x1;
 		} else {
-			newheader->resign = 0;
+			newheader->u.resign = 0;
 			newheader->resign_lsb = 0;
 		}
 	} else {
 		newheader->serial = 1;
-		newheader->resign = 0;
+		newheader->u.last_used = now;
 		newheader->resign_lsb = 0;
 		if ((rdataset->attributes & DNS_RDATASETATTR_PREFETCH) != 0)
 			newheader->attributes |= RDATASET_ATTR_PREFETCH;
@@ -6879,8 +7309,9 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 
 	/*
 	 * Add to the auxiliary NSEC tree if we're adding an NSEC record.
+	 * Nothing searches it in a cache.
 	 */
-	if (rbtnode->nsec != DNS_RBT_NSEC_HAS_NSEC &&
+	if (!IS_CACHE(rbtdb) && rbtnode->nsec != DNS_RBT_NSEC_HAS_NSEC &&
 	    rdataset->type == dns_rdatatype_nsec)
 		newnsec = ISC_TRUE;
 	else
@@ -6896,11 +7327,12 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 		cache_is_overmem = ISC_TRUE;
 	if (delegating || newnsec || cache_is_overmem) {
 		tree_locked = ISC_TRUE;
-		RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+		RWLOCK(tree_lock, isc_rwlocktype_write);
 	}
 
 	if (cache_is_overmem)
-		overmem_purge(rbtdb, rbtnode->locknum, now, tree_locked);
+		overmem_purge(rbtdb, rbtnode->locknum, rbtnode->shard, now,
+			      tree_locked);
 
 	NODE_LOCK(&rbtdb->node_locks[rbtnode->locknum].lock,
 		  isc_rwlocktype_write);
@@ -6912,11 +7344,17 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 
 	if (IS_CACHE(rbtdb)) {
 		if (tree_locked)
-			cleanup_dead_nodes(rbtdb, rbtnode->locknum);
+			cleanup_dead_nodes(rbtdb, rbtnode->shard,
+					   rbtnode->locknum);
 
 		header = isc_heap_element(rbtdb->heaps[rbtnode->locknum], 1);
-		if (header && header->rdh_ttl < now - RBTDB_VIRTUAL)
-			expire_header(rbtdb, header, tree_locked,
+		if (header != NULL &&
+		    header->rdh_ttl + STALE_TTL(header, rbtdb) <
+		    now - RBTDB_VIRTUAL)
+			expire_header(rbtdb, header,
+				      ISC_TF(tree_locked &&
+					     header->node->shard ==
+					     rbtnode->shard),
 				      expire_ttl);
 
 		/*
@@ -6925,7 +7363,7 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 		 * node lock.
 		 */
 		if (tree_locked && !delegating && !newnsec) {
-			RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+			RWUNLOCK(tree_lock, isc_rwlocktype_write);
 			tree_locked = ISC_FALSE;
 		}
 	}
@@ -6949,14 +7387,17 @@ addrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	if (result == ISC_R_SUCCESS)
 		result = add32(rbtdb, rbtnode, rbtversion, newheader, options,
 			       ISC_FALSE, addedrdataset, now);
-	if (result == ISC_R_SUCCESS && delegating)
+	if (result == ISC_R_SUCCESS && delegating) {
 		rbtnode->find_callback = 1;
+		if (rbtnode->shard == 0 && rbtdb->shard_count != 0)
+			rbtdb->top_dname = ISC_TRUE;
+	}
 
 	NODE_UNLOCK(&rbtdb->node_locks[rbtnode->locknum].lock,
 		    isc_rwlocktype_write);
 
 	if (tree_locked)
-		RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+		RWUNLOCK(tree_lock, isc_rwlocktype_write);
 
 	/*
 	 * Update the zone's secure status.  If version is non-NULL
@@ -7005,20 +7446,16 @@ subtractrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	newheader->attributes = 0;
 	newheader->serial = rbtversion->serial;
 	newheader->trust = 0;
-	newheader->noqname = NULL;
-	newheader->closest = NULL;
 	newheader->count = init_count++;
-	newheader->additional_auth = NULL;
-	newheader->additional_glue = NULL;
-	newheader->last_used = 0;
+	newheader->u.last_used = 0;
 	newheader->node = rbtnode;
 	if ((rdataset->attributes & DNS_RDATASETATTR_RESIGN) != 0) {
 		newheader->attributes |= RDATASET_ATTR_RESIGN;
-		newheader->resign = (isc_stdtime_t)
+		newheader->u.resign = (isc_stdtime_t)
 			(dns_time64_from32(rdataset->resign) >> 1);
 		newheader->resign_lsb = rdataset->resign & 0x1;
 	} else {
-		newheader->resign = 0;
+		newheader->u.resign = 0;
 		newheader->resign_lsb = 0;
 	}
 
@@ -7070,11 +7507,22 @@ subtractrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 		if (result == ISC_R_SUCCESS) {
 			free_rdataset(rbtdb, rbtdb->common.mctx, newheader);
 			newheader = (rdatasetheader_t *)subresult;
+			/*
+			 * dns_rdataslab_subtract() copied the reserved
+			 * portion of 'header', including the pointer to its
+			 * side structure; init_rdataset() clears that, and
+			 * update_newheader() makes a copy of the case.
+			 */
 			init_rdataset(rbtdb, newheader);
-			update_newheader(newheader, header);
+			result = update_newheader(rbtdb, newheader, header);
+			if (result != ISC_R_SUCCESS) {
+				free_rdataset(rbtdb, rbtdb->common.mctx,
+					      newheader);
+				goto unlock;
+			}
 			if (RESIGN(header)) {
 				newheader->attributes |= RDATASET_ATTR_RESIGN;
-				newheader->resign = header->resign;
+				newheader->u.resign = header->u.resign;
 				newheader->resign_lsb = header->resign_lsb;
 				result = resign_insert(rbtdb, rbtnode->locknum,
 						       newheader);
@@ -7091,13 +7539,6 @@ subtractrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 			 * header, not newheader.
 			 */
 			newheader->serial = rbtversion->serial;
-			/*
-			 * XXXJT: dns_rdataslab_subtract() copied the pointers
-			 * to additional info.  We need to clear these fields
-			 * to avoid having duplicated references.
-			 */
-			newheader->additional_auth = NULL;
-			newheader->additional_glue = NULL;
 			update_recordsandbytes(ISC_TRUE, rbtversion, newheader);
 		} else if (result == DNS_R_NXRRSET) {
 			/*
@@ -7116,15 +7557,11 @@ subtractrdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 			newheader->attributes = RDATASET_ATTR_NONEXISTENT;
 			newheader->trust = 0;
 			newheader->serial = rbtversion->serial;
-			newheader->noqname = NULL;
-			newheader->closest = NULL;
 			newheader->count = 0;
-			newheader->additional_auth = NULL;
-			newheader->additional_glue = NULL;
 			newheader->node = rbtnode;
-			newheader->resign = 0;
+			newheader->u.resign = 0;
 			newheader->resign_lsb = 0;
-			newheader->last_used = 0;
+			newheader->u.last_used = 0;
 		} else {
 			free_rdataset(rbtdb, rbtdb->common.mctx, newheader);
 			goto unlock;
@@ -7205,16 +7642,12 @@ deleterdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 	newheader->type = RBTDB_RDATATYPE_VALUE(type, covers);
 	newheader->attributes = RDATASET_ATTR_NONEXISTENT;
 	newheader->trust = 0;
-	newheader->noqname = NULL;
-	newheader->closest = NULL;
-	newheader->additional_auth = NULL;
-	newheader->additional_glue = NULL;
 	if (rbtversion != NULL)
 		newheader->serial = rbtversion->serial;
 	else
 		newheader->serial = 0;
 	newheader->count = 0;
-	newheader->last_used = 0;
+	newheader->u.last_used = 0;
 	newheader->node = rbtnode;
 
 	NODE_LOCK(&rbtdb->node_locks[rbtnode->locknum].lock,
@@ -7237,7 +7670,8 @@ deleterdataset(dns_db_t *db, dns_dbnode_t *node, dns_dbversion_t *version,
 }
 
 /*
- * load a non-NSEC3 node in the main tree and optionally to the auxiliary NSEC
+ * load a non-NSEC3 node in the main tree (or its shard of a cache) and
+ * optionally to the auxiliary NSEC
  */
 static isc_result_t
 loadnode(dns_rbtdb_t *rbtdb, dns_name_t *name, dns_rbtnode_t **nodep,
@@ -7245,8 +7679,12 @@ loadnode(dns_rbtdb_t *rbtdb, dns_name_t *name, dns_rbtnode_t **nodep,
 {
 	isc_result_t noderesult, rpzresult, nsecresult, tmpresult;
 	dns_rbtnode_t *nsecnode = NULL, *node = NULL;
+	unsigned int shard;
 
-	noderesult = dns_rbt_addnode(rbtdb->tree, name, &node);
+	shard = name_shard(rbtdb, name);
+	noderesult = dns_rbt_addnode(SHARD_TREE(rbtdb, shard), name, &node);
+	if (noderesult == ISC_R_SUCCESS && shard != 0)
+		set_shard(node, shard);
 	if (rbtdb->rpzs != NULL &&
 	    (noderesult == ISC_R_SUCCESS || noderesult == ISC_R_EXISTS)) {
 		rpzresult = dns_rpz_add(rbtdb->load_rpzs, rbtdb->rpz_num,
@@ -7379,7 +7817,11 @@ loading_addrdataset(void *arg, dns_name_t *name, dns_rdataset_t *rdataset) {
 	    !IS_CACHE(rbtdb) && !dns_name_equal(name, &rbtdb->common.origin))
 		return (DNS_R_NOTZONETOP);
 
-	if (rdataset->type != dns_rdatatype_nsec3 &&
+	/*
+	 * Caches do not synthesize answers from wildcards, and the magic
+	 * would have to be kept in the shards.
+	 */
+	if (!IS_CACHE(rbtdb) && rdataset->type != dns_rdatatype_nsec3 &&
 	    rdataset->covers != dns_rdatatype_nsec3)
 		add_empty_wildcards(rbtdb, name);
 
@@ -7394,9 +7836,11 @@ loading_addrdataset(void *arg, dns_name_t *name, dns_rdataset_t *rdataset) {
 		 */
 		if (rdataset->type == dns_rdatatype_nsec3)
 			return (DNS_R_INVALIDNSEC3);
-		result = add_wildcard_magic(rbtdb, name);
-		if (result != ISC_R_SUCCESS)
-			return (result);
+		if (!IS_CACHE(rbtdb)) {
+			result = add_wildcard_magic(rbtdb, name);
+			if (result != ISC_R_SUCCESS)
+				return (result);
+		}
 	}
 
 	node = NULL;
@@ -7406,7 +7850,7 @@ loading_addrdataset(void *arg, dns_name_t *name, dns_rdataset_t *rdataset) {
 		if (result == ISC_R_SUCCESS)
 			node->nsec = DNS_RBT_NSEC_NSEC3;
 	} else if (rdataset->type == dns_rdatatype_nsec) {
-		result = loadnode(rbtdb, name, &node, ISC_TRUE);
+		result = loadnode(rbtdb, name, &node, ISC_TF(!IS_CACHE(rbtdb)));
 	} else {
 		result = loadnode(rbtdb, name, &node, ISC_FALSE);
 	}
@@ -7438,22 +7882,18 @@ loading_addrdataset(void *arg, dns_name_t *name, dns_rdataset_t *rdataset) {
 	newheader->attributes = 0;
 	newheader->trust = rdataset->trust;
 	newheader->serial = 1;
-	newheader->noqname = NULL;
-	newheader->closest = NULL;
 	newheader->count = init_count++;
-	newheader->additional_auth = NULL;
-	newheader->additional_glue = NULL;
-	newheader->last_used = 0;
+	newheader->u.last_used = 0;
 	newheader->node = node;
-	setownercase(newheader, name);
+	setownercase(rbtdb, newheader, name);
 
 	if ((rdataset->attributes & DNS_RDATASETATTR_RESIGN) != 0) {
 		newheader->attributes |= RDATASET_ATTR_RESIGN;
-		newheader->resign = (isc_stdtime_t)
+		newheader->u.resign = (isc_stdtime_t)
 			(dns_time64_from32(rdataset->resign) >> 1);
 		newheader->resign_lsb = rdataset->resign & 0x1;
 	} else {
-		newheader->resign = 0;
+		newheader->u.resign = 0;
 		newheader->resign_lsb = 0;
 	}
 
@@ -7477,7 +7917,7 @@ rbt_datafixer(dns_rbtnode_t *rbtnode, void *base, size_t filesize,
 	rdatasetheader_t *header;
 	unsigned char *limit = ((unsigned char *) base) + filesize;
 	unsigned char *p;
-	size_t size;
+	size_t size, cooked;
 	unsigned int count;
 
 	REQUIRE(rbtnode != NULL);
@@ -7500,8 +7940,22 @@ rbt_datafixer(dns_rbtnode_t *rbtnode, void *base, size_t filesize,
 		header->node = rbtnode;
 		header->node_is_relative = 0;
 
+		cooked = dns_rbt_serialize_align(size);
+		if (header->ext != NULL) {
+			if ((uintptr_t)header->ext !=
+				    (p - (unsigned char *)base) + cooked)
+				return (ISC_R_INVALIDFILE);
+			if (p + cooked + sizeof(*header->ext) > limit)
+				return (ISC_R_INVALIDFILE);
+			header->ext = (rdatasetheader_ext_t *)(p + cooked);
+			header->ext_is_mmapped = 1;
+			isc_crc64_update(crc, p + cooked,
+					 sizeof(*header->ext));
+			cooked += dns_rbt_serialize_align(sizeof(*header->ext));
+		}
+
 		if (rbtdb != NULL && RESIGN(header) &&
-		    (header->resign != 0 || header->resign_lsb != 0))
+		    (header->u.resign != 0 || header->resign_lsb != 0))
 		{
 			int idx = header->node->locknum;
 			result = isc_heap_insert(rbtdb->heaps[idx], header);
@@ -7510,7 +7964,6 @@ rbt_datafixer(dns_rbtnode_t *rbtnode, void *base, size_t filesize,
 		}
 
 		if (header->next != NULL) {
-			size_t cooked = dns_rbt_serialize_align(size);
 			if ((uintptr_t)header->next !=
 				    (p - (unsigned char *)base) + cooked)
 				return (ISC_R_INVALIDFILE);
@@ -7741,9 +8194,10 @@ rbt_datawriter(FILE *rbtfile, unsigned char *data, void *arg,
 	rbtdb_version_t *version = (rbtdb_version_t *) arg;
 	rbtdb_serial_t serial;
 	rdatasetheader_t newheader;
+	rdatasetheader_ext_t newext;
 	rdatasetheader_t *header = (rdatasetheader_t *) data, *next;
 	off_t where;
-	size_t cooked, size;
+	size_t cooked, extcooked, size;
 	unsigned char *p;
 	isc_result_t result = ISC_R_SUCCESS;
 	char pad[sizeof(char *)];
@@ -7789,8 +8243,26 @@ rbt_datawriter(FILE *rbtfile, unsigned char *data, void *arg,
 		 * will be properly aligned when read back in.
 		 */
 		cooked = dns_rbt_serialize_align(size);
+
+		/*
+		 * Of the side structure, only the case vector is worth
+		 * keeping; if there is one it follows the slab.
+		 */
+		newheader.ext = NULL;
+		newheader.ext_is_mmapped = 0;
+		extcooked = 0;
+		if (CASESET(header) && !CASEFULLYLOWER(header)) {
+			memset(&newext, 0, sizeof(newext));
+			memmove(newext.upper, header->ext->upper,
+				sizeof(newext.upper));
+			newheader.ext = (rdatasetheader_ext_t *)
+					(off + cooked);
+			extcooked = dns_rbt_serialize_align(sizeof(newext));
+		}
+
 		if (next != NULL) {
-			newheader.next = (rdatasetheader_t *) (off + cooked);
+			newheader.next = (rdatasetheader_t *)
+					 (off + cooked + extcooked);
 			newheader.next_is_relative = 1;
 		}
 
@@ -7818,6 +8290,19 @@ rbt_datawriter(FILE *rbtfile, unsigned char *data, void *arg,
 			CHECK(isc_stdio_write(pad, cooked - size, 1,
 					      rbtfile, NULL));
 		}
+
+		if (newheader.ext != NULL) {
+			isc_crc64_update(crc, (unsigned char *) &newext,
+					 sizeof(newext));
+			CHECK(isc_stdio_write(&newext, sizeof(newext), 1,
+					      rbtfile, NULL));
+			if (sizeof(newext) != extcooked) {
+				memset(pad, 0, sizeof(pad));
+				CHECK(isc_stdio_write(pad,
+						      extcooked - sizeof(newext),
+						      1, rbtfile, NULL));
+			}
+		}
 	}
 
  failure:
@@ -8010,15 +8495,17 @@ isdnssec(dns_db_t *db) {
 static unsigned int
 nodecount(dns_db_t *db) {
 	dns_rbtdb_t *rbtdb;
-	unsigned int count;
+	unsigned int count = 0, shard;
 
 	rbtdb = (dns_rbtdb_t *)db;
 
 	REQUIRE(VALID_RBTDB(rbtdb));
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
-	count = dns_rbt_nodecount(rbtdb->tree);
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	for (shard = 0; shard <= rbtdb->shard_count; shard++) {
+		RWLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_read);
+		count += dns_rbt_nodecount(SHARD_TREE(rbtdb, shard));
+		RWUNLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_read);
+	}
 
 	return (count);
 }
@@ -8027,14 +8514,18 @@ static size_t
 hashsize(dns_db_t *db) {
 	dns_rbtdb_t *rbtdb;
 	size_t size;
+	unsigned int shard;
 
 	rbtdb = (dns_rbtdb_t *)db;
 
 	REQUIRE(VALID_RBTDB(rbtdb));
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
-	size = dns_rbt_hashsize(rbtdb->tree);
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	size = 0;
+	for (shard = 0; shard <= rbtdb->shard_count; shard++) {
+		RWLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_read);
+		size += dns_rbt_hashsize(SHARD_TREE(rbtdb, shard));
+		RWUNLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_read);
+	}
 
 	return (size);
 }
@@ -8176,7 +8667,7 @@ setsigningtime(dns_db_t *db, dns_rdataset_t *rdataset, isc_stdtime_t resign) {
 	 * or isc_heap_decreased.
 	 */
 	if (resign != 0) {
-		header->resign =
+		header->u.resign =
 			 (isc_stdtime_t)(dns_time64_from32(resign) >> 1);
 		header->resign_lsb = resign & 0x1;
 	}
@@ -8315,6 +8806,139 @@ getrrsetstats(dns_db_t *db) {
 	return (rbtdb->rrsetstats);
 }
 
+static isc_stats_t *
+getlockstats(dns_db_t *db) {
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
+
+	REQUIRE(VALID_RBTDB(rbtdb));
+	REQUIRE(IS_CACHE(rbtdb)); /* current restriction */
+
+	return (rbtdb->lockstats);
+}
+
+static isc_result_t
+setservestalettl(dns_db_t *db, dns_ttl_t ttl) {
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
+
+	REQUIRE(VALID_RBTDB(rbtdb));
+	REQUIRE(IS_CACHE(rbtdb));
+
+	rbtdb->serve_stale_ttl = ttl;
+	return (ISC_R_SUCCESS);
+}
+
+static isc_result_t
+getservestalettl(dns_db_t *db, dns_ttl_t *ttl) {
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
+
+	REQUIRE(VALID_RBTDB(rbtdb));
+	REQUIRE(IS_CACHE(rbtdb));
+
+	*ttl = rbtdb->serve_stale_ttl;
+	return (ISC_R_SUCCESS);
+}
+
+static unsigned int
+bucketcount(dns_db_t *db) {
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
+
+	REQUIRE(VALID_RBTDB(rbtdb));
+
+	if (!IS_CACHE(rbtdb))
+		return (0);
+	return (rbtdb->node_lock_count);
+}
+
+/*%
+ * Remove up to '*countp' entries from bucket 'bucket': first those whose
+ * TTL (plus the serve-stale period) has passed, taken off the top of the
+ * bucket's TTL heap, then, while the cache is over its memory limit, the
+ * least recently used ones.  Nodes left without data are then deleted
+ * from every tree whose write lock can be had without waiting.
+ */
+static isc_result_t
+cleanbucket(dns_db_t *db, unsigned int bucket, isc_stdtime_t now,
+	    unsigned int *countp)
+{
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
+	rdatasetheader_t *header;
+	unsigned char dead[256];
+	unsigned int budget, cleaned = 0, ndead = 0, shard, i, n;
+	isc_result_t result = ISC_R_SUCCESS;
+
+	REQUIRE(VALID_RBTDB(rbtdb));
+	REQUIRE(IS_CACHE(rbtdb));
+	REQUIRE(countp != NULL);
+
+	if (bucket >= rbtdb->node_lock_count) {
+		*countp = 0;
+		return (ISC_R_RANGE);
+	}
+
+	budget = *countp;
+
+	NODE_LOCK(&rbtdb->node_locks[bucket].lock, isc_rwlocktype_write);
+
+	while (cleaned < budget) {
+		header = isc_heap_element(rbtdb->heaps[bucket], 1);
+		if (header == NULL ||
+		    header->rdh_ttl + STALE_TTL(header, rbtdb) >=
+		    now - RBTDB_VIRTUAL)
+			break;
+		expire_header(rbtdb, header, ISC_FALSE, expire_ttl);
+		cleaned++;
+		/*
+		 * A header whose node is in use stays until the node is
+		 * released; take it off the heap so that it doesn't hide
+		 * the ones below it.
+		 */
+		if (isc_heap_element(rbtdb->heaps[bucket], 1) == header)
+			isc_heap_delete(rbtdb->heaps[bucket], 1);
+	}
+
+	if (isc_mem_isovermem(rbtdb->common.mctx)) {
+		while (cleaned < budget &&
+		       (header = lru_tail(rbtdb, bucket)) != NULL)
+		{
+			lru_unlink(rbtdb, header);
+			expire_header(rbtdb, header, ISC_FALSE, expire_lru);
+			cleaned++;
+		}
+	}
+
+	if (cleaned == budget)
+		result = DNS_R_CONTINUE;
+
+	for (shard = 0; shard <= rbtdb->shard_count; shard++) {
+		if (!ISC_LIST_EMPTY(DEADNODES(rbtdb, shard, bucket)))
+			dead[ndead++] = shard;
+	}
+
+	NODE_UNLOCK(&rbtdb->node_locks[bucket].lock, isc_rwlocktype_write);
+
+	for (i = 0; i < ndead; i++) {
+		isc_rwlock_t *tree_lock = SHARD_LOCK(rbtdb, dead[i]);
+
+		if (isc_rwlock_trylock(tree_lock, isc_rwlocktype_write) !=
+		    ISC_R_SUCCESS)
+			continue;
+		NODE_LOCK(&rbtdb->node_locks[bucket].lock,
+			  isc_rwlocktype_write);
+		/* cleanup_dead_nodes() deletes up to 10 nodes per call. */
+		for (n = 0;
+		     n < budget &&
+		     !ISC_LIST_EMPTY(DEADNODES(rbtdb, dead[i], bucket));
+		     n += 10)
+			cleanup_dead_nodes(rbtdb, dead[i], bucket);
+		NODE_UNLOCK(&rbtdb->node_locks[bucket].lock,
+			    isc_rwlocktype_write);
+		RWUNLOCK(tree_lock, isc_rwlocktype_write);
+	}
+
+	*countp = cleaned;
+	return (result);
+}
+
 static isc_result_t
 nodefullname(dns_db_t *db, dns_dbnode_t *node, dns_name_t *name) {
 	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)db;
@@ -8325,9 +8949,9 @@ nodefullname(dns_db_t *db, dns_dbnode_t *node, dns_name_t *name) {
 	REQUIRE(node != NULL);
 	REQUIRE(name != NULL);
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	RWLOCK(SHARD_LOCK(rbtdb, rbtnode->shard), isc_rwlocktype_read);
 	result = dns_rbt_fullnamefromnode(rbtnode, name);
-	RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	RWUNLOCK(SHARD_LOCK(rbtdb, rbtnode->shard), isc_rwlocktype_read);
 
 	return (result);
 }
@@ -8377,7 +9001,12 @@ static dns_dbmethods_t zone_methods = {
 	NULL,
 	hashsize,
 	nodefullname,
-	getsize
+	getsize,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
 };
 
 static dns_dbmethods_t cache_methods = {
@@ -8425,9 +9054,31 @@ static dns_dbmethods_t cache_methods = {
 	setcachestats,
 	hashsize,
 	nodefullname,
-	NULL
+	NULL,
+	getlockstats,
+	setservestalettl,
+	getservestalettl,
+	bucketcount,
+	cleanbucket
 };
 
+void
+#ifdef DNS_RBTDB_VERSION64
+dns_rbtdb64_setnodelockcount
+#else
+dns_rbtdb_setnodelockcount
+#endif
+		(dns_dbtype_t type, unsigned int count)
+{
+	REQUIRE(count < (1 << DNS_RBT_LOCKLENGTH));
+
+	if (type == dns_dbtype_cache) {
+		REQUIRE(count != 1);
+		cache_node_lock_count = count;
+	} else
+		zone_node_lock_count = count;
+}
+
 isc_result_t
 #ifdef DNS_RBTDB_VERSION64
 dns_rbtdb64_create
@@ -8483,11 +9134,15 @@ dns_rbtdb_create
 		goto cleanup_lock;
 
 	/*
-	 * Initialize node_lock_count in a generic way to support future
-	 * extension which allows the user to specify this value on creation.
-	 * Note that when specified for a cache DB it must be larger than 1
-	 * as commented with the definition of DEFAULT_CACHE_NODE_LOCK_COUNT.
+	 * Initialize node_lock_count from the value set with
+	 * dns_rbtdb_setnodelockcount(), if any.  Note that for a cache DB
+	 * it must be larger than 1 as commented with the definition of
+	 * DEFAULT_CACHE_NODE_LOCK_COUNT.
 	 */
+	if (IS_CACHE(rbtdb))
+		rbtdb->node_lock_count = cache_node_lock_count;
+	else
+		rbtdb->node_lock_count = zone_node_lock_count;
 	if (rbtdb->node_lock_count == 0) {
 		if (IS_CACHE(rbtdb))
 			rbtdb->node_lock_count = DEFAULT_CACHE_NODE_LOCK_COUNT;
@@ -8505,22 +9160,63 @@ dns_rbtdb_create
 		goto cleanup_tree_lock;
 	}
 
+	/*
+	 * Create the shard locks of a "sharded" cache; the trees are made
+	 * below.
+	 */
+	if (IS_CACHE(rbtdb) && argc > 1 && strcmp(argv[1], "sharded") == 0 &&
+	    DEFAULT_CACHE_SHARD_COUNT != 0)
+	{
+		rbtdb->shards = isc_mem_get(mctx, DEFAULT_CACHE_SHARD_COUNT *
+					    sizeof(rbtdb_shard_t));
+		if (rbtdb->shards == NULL) {
+			result = ISC_R_NOMEMORY;
+			goto cleanup_node_locks;
+		}
+		for (i = 0; i < DEFAULT_CACHE_SHARD_COUNT; i++) {
+			result = isc_rwlock_init(&rbtdb->shards[i].tree_lock,
+						 0, 0);
+			if (result != ISC_R_SUCCESS) {
+				while (i-- > 0)
+					isc_rwlock_destroy(
+						&rbtdb->shards[i].tree_lock);
+				isc_mem_put(mctx, rbtdb->shards,
+					    DEFAULT_CACHE_SHARD_COUNT *
+					    sizeof(rbtdb_shard_t));
+				rbtdb->shards = NULL;
+				goto cleanup_node_locks;
+			}
+			rbtdb->shards[i].tree = NULL;
+		}
+		rbtdb->shard_count = DEFAULT_CACHE_SHARD_COUNT;
+	}
+
 	rbtdb->cachestats = NULL;
 	rbtdb->rrsetstats = NULL;
+	rbtdb->lockstats = NULL;
+	rbtdb->serve_stale_ttl = 0;
 	if (IS_CACHE(rbtdb)) {
 		result = dns_rdatasetstats_create(mctx, &rbtdb->rrsetstats);
 		if (result != ISC_R_SUCCESS)
-			goto cleanup_node_locks;
-		rbtdb->rdatasets = isc_mem_get(mctx, rbtdb->node_lock_count *
-					       sizeof(rdatasetheaderlist_t));
-		if (rbtdb->rdatasets == NULL) {
+			goto cleanup_shards;
+		result = isc_stats_create(mctx, &rbtdb->lockstats,
+					  rbtdb->node_lock_count);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup_rrsetstats;
+		rbtdb->lru = isc_mem_get(mctx, rbtdb->node_lock_count *
+					 sizeof(rbtdb_lru_t));
+		if (rbtdb->lru == NULL) {
 			result = ISC_R_NOMEMORY;
 			goto cleanup_rrsetstats;
 		}
-		for (i = 0; i < (int)rbtdb->node_lock_count; i++)
-			ISC_LIST_INIT(rbtdb->rdatasets[i]);
+		for (i = 0; i < (int)rbtdb->node_lock_count; i++) {
+			ISC_LIST_INIT(rbtdb->lru[i].cold);
+			ISC_LIST_INIT(rbtdb->lru[i].hot);
+			rbtdb->lru[i].ncold = 0;
+			rbtdb->lru[i].nhot = 0;
+		}
 	} else
-		rbtdb->rdatasets = NULL;
+		rbtdb->lru = NULL;
 
 	/*
 	 * Create the heaps.
@@ -8529,7 +9225,7 @@ dns_rbtdb_create
 				   sizeof(isc_heap_t *));
 	if (rbtdb->heaps == NULL) {
 		result = ISC_R_NOMEMORY;
-		goto cleanup_rdatasets;
+		goto cleanup_lru;
 	}
 	for (i = 0; i < (int)rbtdb->node_lock_count; i++)
 		rbtdb->heaps[i] = NULL;
@@ -8544,13 +9240,16 @@ dns_rbtdb_create
 	/*
 	 * Create deadnode lists.
 	 */
-	rbtdb->deadnodes = isc_mem_get(mctx, rbtdb->node_lock_count *
+	rbtdb->deadnodes = isc_mem_get(mctx, (rbtdb->shard_count + 1) *
+				       rbtdb->node_lock_count *
 				       sizeof(rbtnodelist_t));
 	if (rbtdb->deadnodes == NULL) {
 		result = ISC_R_NOMEMORY;
 		goto cleanup_heaps;
 	}
-	for (i = 0; i < (int)rbtdb->node_lock_count; i++)
+	for (i = 0;
+	     i < (int)((rbtdb->shard_count + 1) * rbtdb->node_lock_count);
+	     i++)
 		ISC_LIST_INIT(rbtdb->deadnodes[i]);
 
 	rbtdb->active = rbtdb->node_lock_count;
@@ -8571,6 +9270,8 @@ dns_rbtdb_create
 			goto cleanup_deadnodes;
 		}
 		rbtdb->node_locks[i].exiting = ISC_FALSE;
+		rbtdb->node_locks[i].lockstats = rbtdb->lockstats;
+		rbtdb->node_locks[i].bucket = i;
 	}
 
 	/*
@@ -8604,6 +9305,15 @@ dns_rbtdb_create
 		return (result);
 	}
 
+	for (i = 0; i < (int)rbtdb->shard_count; i++) {
+		result = dns_rbt_create(mctx, delete_callback, rbtdb,
+					&rbtdb->shards[i].tree);
+		if (result != ISC_R_SUCCESS) {
+			free_rbtdb(rbtdb, ISC_FALSE, NULL);
+			return (result);
+		}
+	}
+
 	result = dns_rbt_create(mctx, delete_callback, rbtdb, &rbtdb->nsec);
 	if (result != ISC_R_SUCCESS) {
 		free_rbtdb(rbtdb, ISC_FALSE, NULL);
@@ -8751,7 +9461,8 @@ dns_rbtdb_create
 
  cleanup_deadnodes:
 	isc_mem_put(mctx, rbtdb->deadnodes,
-		    rbtdb->node_lock_count * sizeof(rbtnodelist_t));
+		    (rbtdb->shard_count + 1) * rbtdb->node_lock_count *
+		    sizeof(rbtnodelist_t));
 
  cleanup_heaps:
 	if (rbtdb->heaps != NULL) {
@@ -8762,13 +9473,23 @@ dns_rbtdb_create
 			    rbtdb->node_lock_count * sizeof(isc_heap_t *));
 	}
 
- cleanup_rdatasets:
-	if (rbtdb->rdatasets != NULL)
-		isc_mem_put(mctx, rbtdb->rdatasets, rbtdb->node_lock_count *
-			    sizeof(rdatasetheaderlist_t));
+ cleanup_lru:
+	if (rbtdb->lru != NULL)
+		isc_mem_put(mctx, rbtdb->lru, rbtdb->node_lock_count *
+			    sizeof(rbtdb_lru_t));
  cleanup_rrsetstats:
 	if (rbtdb->rrsetstats != NULL)
 		dns_stats_detach(&rbtdb->rrsetstats);
+	if (rbtdb->lockstats != NULL)
+		isc_stats_detach(&rbtdb->lockstats);
+
+ cleanup_shards:
+	if (rbtdb->shards != NULL) {
+		for (i = 0; i < (int)rbtdb->shard_count; i++)
+			isc_rwlock_destroy(&rbtdb->shards[i].tree_lock);
+		isc_mem_put(mctx, rbtdb->shards,
+			    rbtdb->shard_count * sizeof(rbtdb_shard_t));
+	}
 
  cleanup_node_locks:
 	isc_mem_put(mctx, rbtdb->node_locks,
@@ -9279,6 +10000,7 @@ static void
 flush_deletions(rbtdb_dbiterator_t *rbtdbiter) {
 	dns_rbtnode_t *node;
 	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)rbtdbiter->common.db;
+	isc_rwlock_t *tree_lock = SHARD_LOCK(rbtdb, rbtdbiter->shard);
 	isc_boolean_t was_read_locked = ISC_FALSE;
 	nodelock_t *lock;
 	int i;
@@ -9294,13 +10016,14 @@ flush_deletions(rbtdb_dbiterator_t *rbtdbiter) {
 			      DNS_LOGMODULE_CACHE, ISC_LOG_DEBUG(1),
 			      "flush_deletions: %d nodes of %d in tree",
 			      rbtdbiter->delcnt,
-			      dns_rbt_nodecount(rbtdb->tree));
+			      dns_rbt_nodecount(SHARD_TREE(rbtdb,
+							   rbtdbiter->shard)));
 
 		if (rbtdbiter->tree_locked == isc_rwlocktype_read) {
-			RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+			RWUNLOCK(tree_lock, isc_rwlocktype_read);
 			was_read_locked = ISC_TRUE;
 		}
-		RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+		RWLOCK(tree_lock, isc_rwlocktype_write);
 		rbtdbiter->tree_locked = isc_rwlocktype_write;
 
 		for (i = 0; i < rbtdbiter->delcnt; i++) {
@@ -9316,9 +10039,9 @@ flush_deletions(rbtdb_dbiterator_t *rbtdbiter) {
 
 		rbtdbiter->delcnt = 0;
 
-		RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_write);
+		RWUNLOCK(tree_lock, isc_rwlocktype_write);
 		if (was_read_locked) {
-			RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+			RWLOCK(tree_lock, isc_rwlocktype_read);
 			rbtdbiter->tree_locked = isc_rwlocktype_read;
 
 		} else {
@@ -9334,12 +10057,85 @@ resume_iteration(rbtdb_dbiterator_t *rbtdbiter) {
 	REQUIRE(rbtdbiter->paused);
 	REQUIRE(rbtdbiter->tree_locked == isc_rwlocktype_none);
 
-	RWLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+	RWLOCK(SHARD_LOCK(rbtdb, rbtdbiter->shard), isc_rwlocktype_read);
 	rbtdbiter->tree_locked = isc_rwlocktype_read;
 
 	rbtdbiter->paused = ISC_FALSE;
 }
 
+/*%
+ * Move the iterator of a sharded cache to the tree 'shard', trading the
+ * read lock of the tree it was in for that of the new one.  The iterator
+ * must not hold a reference to a node.
+ */
+static void
+iterator_setshard(rbtdb_dbiterator_t *rbtdbiter, unsigned int shard) {
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)rbtdbiter->common.db;
+
+	if (shard == rbtdbiter->shard)
+		return;
+
+	INSIST(rbtdbiter->node == NULL);
+	INSIST(rbtdbiter->tree_locked == isc_rwlocktype_read);
+
+	/*
+	 * Pending deletions are in the tree we're leaving.
+	 */
+	flush_deletions(rbtdbiter);
+
+	RWUNLOCK(SHARD_LOCK(rbtdb, rbtdbiter->shard), isc_rwlocktype_read);
+	rbtdbiter->shard = shard;
+	RWLOCK(SHARD_LOCK(rbtdb, shard), isc_rwlocktype_read);
+}
+
+/*%
+ * Position the main chain at the first node of the first non-empty tree
+ * from 'shard' on (or the last node of the last one up to 'shard').
+ */
+static isc_result_t
+iterator_shardfirst(rbtdb_dbiterator_t *rbtdbiter, unsigned int shard,
+		    dns_name_t *name, dns_name_t *origin)
+{
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)rbtdbiter->common.db;
+	isc_result_t result;
+
+	for (;;) {
+		iterator_setshard(rbtdbiter, shard);
+		result = dns_rbtnodechain_first(&rbtdbiter->chain,
+						SHARD_TREE(rbtdb, shard),
+						name, origin);
+		if (result != ISC_R_NOTFOUND || shard == rbtdb->shard_count)
+			return (result);
+		shard++;
+	}
+}
+
+static isc_result_t
+iterator_shardlast(rbtdb_dbiterator_t *rbtdbiter, unsigned int shard,
+		   dns_name_t *name, dns_name_t *origin)
+{
+	dns_rbtdb_t *rbtdb = (dns_rbtdb_t *)rbtdbiter->common.db;
+	isc_result_t result;
+
+	for (;;) {
+		iterator_setshard(rbtdbiter, shard);
+		/*
+		 * dns_rbtnodechain_last() can't cope with an empty tree.
+		 */
+		if (dns_rbt_nodecount(SHARD_TREE(rbtdb, shard)) == 0) {
+			dns_rbtnodechain_reset(&rbtdbiter->chain);
+			result = ISC_R_NOTFOUND;
+		} else
+			result = dns_rbtnodechain_last(&rbtdbiter->chain,
+						       SHARD_TREE(rbtdb,
+								  shard),
+						       name, origin);
+		if (result != ISC_R_NOTFOUND || shard == 0)
+			return (result);
+		shard--;
+	}
+}
+
 static void
 dbiterator_destroy(dns_dbiterator_t **iteratorp) {
 	rbtdb_dbiterator_t *rbtdbiter = (rbtdb_dbiterator_t *)(*iteratorp);
@@ -9347,7 +10143,8 @@ dbiterator_destroy(dns_dbiterator_t **iteratorp) {
 	dns_db_t *db = NULL;
 
 	if (rbtdbiter->tree_locked == isc_rwlocktype_read) {
-		RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+		RWUNLOCK(SHARD_LOCK(rbtdb, rbtdbiter->shard),
+			 isc_rwlocktype_read);
 		rbtdbiter->tree_locked = isc_rwlocktype_none;
 	} else
 		INSIST(rbtdbiter->tree_locked == isc_rwlocktype_none);
@@ -9396,8 +10193,7 @@ dbiterator_first(dns_dbiterator_t *iterator) {
 						rbtdb->nsec3, name, origin);
 	} else {
 		rbtdbiter->current = &rbtdbiter->chain;
-		result = dns_rbtnodechain_first(rbtdbiter->current,
-						rbtdb->tree, name, origin);
+		result = iterator_shardfirst(rbtdbiter, 0, name, origin);
 		if (!rbtdbiter->nonsec3 && result == ISC_R_NOTFOUND) {
 			rbtdbiter->current = &rbtdbiter->nsec3chain;
 			result = dns_rbtnodechain_first(rbtdbiter->current,
@@ -9456,8 +10252,8 @@ dbiterator_last(dns_dbiterator_t *iterator) {
 	}
 	if (!rbtdbiter->nsec3only && result == ISC_R_NOTFOUND) {
 		rbtdbiter->current = &rbtdbiter->chain;
-		result = dns_rbtnodechain_last(rbtdbiter->current, rbtdb->tree,
-					       name, origin);
+		result = iterator_shardlast(rbtdbiter, rbtdb->shard_count,
+					    name, origin);
 	}
 	if (result == ISC_R_SUCCESS || result == DNS_R_NEWORIGIN) {
 		result = dns_rbtnodechain_current(rbtdbiter->current, NULL,
@@ -9507,8 +10303,9 @@ dbiterator_seek(dns_dbiterator_t *iterator, dns_name_t *name) {
 					  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
 	} else if (rbtdbiter->nonsec3) {
 		rbtdbiter->current = &rbtdbiter->chain;
-		result = dns_rbt_findnode(rbtdb->tree, name, NULL,
-					  &rbtdbiter->node,
+		iterator_setshard(rbtdbiter, name_shard(rbtdb, name));
+		result = dns_rbt_findnode(SHARD_TREE(rbtdb, rbtdbiter->shard),
+					  name, NULL, &rbtdbiter->node,
 					  rbtdbiter->current,
 					  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
 	} else {
@@ -9571,6 +10368,14 @@ dbiterator_prev(dns_dbiterator_t *iterator) {
 	name = dns_fixedname_name(&rbtdbiter->name);
 	origin = dns_fixedname_name(&rbtdbiter->origin);
 	result = dns_rbtnodechain_prev(rbtdbiter->current, name, origin);
+	if (result == ISC_R_NOMORE && rbtdbiter->shard > 0 &&
+	    &rbtdbiter->chain == rbtdbiter->current) {
+		dereference_iter_node(rbtdbiter);
+		result = iterator_shardlast(rbtdbiter, rbtdbiter->shard - 1,
+					    name, origin);
+		if (result == ISC_R_NOTFOUND)
+			result = ISC_R_NOMORE;
+	}
 	if (result == ISC_R_NOMORE && !rbtdbiter->nsec3only &&
 	    !rbtdbiter->nonsec3 &&
 	    &rbtdbiter->nsec3chain == rbtdbiter->current) {
@@ -9616,6 +10421,14 @@ dbiterator_next(dns_dbiterator_t *iterator) {
 	name = dns_fixedname_name(&rbtdbiter->name);
 	origin = dns_fixedname_name(&rbtdbiter->origin);
 	result = dns_rbtnodechain_next(rbtdbiter->current, name, origin);
+	if (result == ISC_R_NOMORE && rbtdbiter->shard < rbtdb->shard_count &&
+	    &rbtdbiter->chain == rbtdbiter->current) {
+		dereference_iter_node(rbtdbiter);
+		result = iterator_shardfirst(rbtdbiter, rbtdbiter->shard + 1,
+					     name, origin);
+		if (result == ISC_R_NOTFOUND)
+			result = ISC_R_NOMORE;
+	}
 	if (result == ISC_R_NOMORE && !rbtdbiter->nsec3only &&
 	    !rbtdbiter->nonsec3 && &rbtdbiter->chain == rbtdbiter->current) {
 		rbtdbiter->current = &rbtdbiter->nsec3chain;
@@ -9723,7 +10536,8 @@ dbiterator_pause(dns_dbiterator_t *iterator) {
 
 	if (rbtdbiter->tree_locked != isc_rwlocktype_none) {
 		INSIST(rbtdbiter->tree_locked == isc_rwlocktype_read);
-		RWUNLOCK(&rbtdb->tree_lock, isc_rwlocktype_read);
+		RWUNLOCK(SHARD_LOCK(rbtdb, rbtdbiter->shard),
+			 isc_rwlocktype_read);
 		rbtdbiter->tree_locked = isc_rwlocktype_none;
 	}
 
@@ -9744,385 +10558,478 @@ dbiterator_origin(dns_dbiterator_t *iterator, dns_name_t *name) {
 }
 
 /*%
- * Additional cache routines.
+ * Glue routines.
  */
-static isc_result_t
-rdataset_getadditional(dns_rdataset_t *rdataset, dns_rdatasetadditional_t type,
-		       dns_rdatatype_t qtype, dns_acache_t *acache,
-		       dns_zone_t **zonep, dns_db_t **dbp,
-		       dns_dbversion_t **versionp, dns_dbnode_t **nodep,
-		       dns_name_t *fname, dns_message_t *msg,
-		       isc_stdtime_t now)
-{
-	dns_rbtdb_t *rbtdb = rdataset->private1;
-	dns_rbtnode_t *rbtnode = rdataset->private2;
-	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
-	unsigned int current_count = rdataset->privateuint4;
-	unsigned int count;
-	rdatasetheader_t *header;
-	nodelock_t *nodelock;
-	unsigned int total_count;
-	acachectl_t *acarray;
-	dns_acacheentry_t *entry;
-	isc_result_t result;
+typedef struct {
+	dns_rbtdb_t			*rbtdb;
+	rbtdb_version_t			*rbtversion;
+	rbtdb_glue_t			*glue_list;
+	rbtdb_glue_t			*glue_tail;
+	isc_result_t			result;
+} rbtdb_glue_additionaldata_ctx_t;
 
-	UNUSED(qtype); /* we do not use this value at least for now */
-	UNUSED(acache);
+static inline unsigned int
+glue_hash(rdatasetheader_t *header, unsigned int bits) {
+	isc_uint64_t key = (isc_uint64_t)(uintptr_t)header;
 
-	header = (struct rdatasetheader *)(raw - sizeof(*header));
+	/*
+	 * Fibonacci hashing: headers are allocated on aligned
+	 * boundaries, so the low bits of their addresses are
+	 * useless on their own.
+	 */
+	return ((unsigned int)((key * 0x9E3779B97F4A7C15ULL)
+			       >> (64 - bits)));
+}
 
-	total_count = raw[0] * 256 + raw[1];
-	INSIST(total_count > current_count);
-	count = total_count - current_count - 1;
+static void
+free_gluelist(isc_mem_t *mctx, rbtdb_glue_t *glue_list) {
+	rbtdb_glue_t *glue, *next;
 
-	acarray = NULL;
+	for (glue = glue_list; glue != NULL; glue = next) {
+		next = glue->next;
+		if (dns_rdataset_isassociated(&glue->rdataset_a))
+			dns_rdataset_disassociate(&glue->rdataset_a);
+		if (dns_rdataset_isassociated(&glue->sigrdataset_a))
+			dns_rdataset_disassociate(&glue->sigrdataset_a);
+		if (dns_rdataset_isassociated(&glue->rdataset_aaaa))
+			dns_rdataset_disassociate(&glue->rdataset_aaaa);
+		if (dns_rdataset_isassociated(&glue->sigrdataset_aaaa))
+			dns_rdataset_disassociate(&glue->sigrdataset_aaaa);
+		isc_mem_put(mctx, glue, sizeof(*glue));
+	}
+}
 
-	nodelock = &rbtdb->node_locks[rbtnode->locknum].lock;
-	NODE_LOCK(nodelock, isc_rwlocktype_read);
+/*
+ * Free the glue table of 'version'.  The caller must be the last user
+ * of the version, so no locking is needed.
+ */
+static void
+free_gluetable(rbtdb_version_t *version) {
+	isc_mem_t *mctx = version->rbtdb->common.mctx;
+	rbtdb_glue_table_node_t *cur, *next;
+	size_t i, size;
 
-	switch (type) {
-	case dns_rdatasetadditional_fromauth:
-		acarray = header->additional_auth;
-		break;
-	case dns_rdatasetadditional_fromcache:
-		acarray = NULL;
-		break;
-	case dns_rdatasetadditional_fromglue:
-		acarray = header->additional_glue;
-		break;
-	default:
-		INSIST(0);
-	}
+	if (version->glue_table == NULL)
+		return;
 
-	if (acarray == NULL) {
-		if (type != dns_rdatasetadditional_fromcache)
-			dns_acache_countquerymiss(acache);
-		NODE_UNLOCK(nodelock, isc_rwlocktype_read);
-		return (ISC_R_NOTFOUND);
+	size = (size_t)1 << version->glue_table_bits;
+	for (i = 0; i < size; i++) {
+		for (cur = version->glue_table[i]; cur != NULL; cur = next) {
+			next = cur->next;
+			free_gluelist(mctx, cur->glue_list);
+			isc_mem_put(mctx, cur, sizeof(*cur));
+		}
 	}
+	isc_mem_put(mctx, version->glue_table,
+		    size * sizeof(*version->glue_table));
+	version->glue_table = NULL;
+	version->glue_table_bits = 0;
+	version->glue_table_count = 0;
+}
 
-	if (acarray[count].entry == NULL) {
-		dns_acache_countquerymiss(acache);
-		NODE_UNLOCK(nodelock, isc_rwlocktype_read);
-		return (ISC_R_NOTFOUND);
-	}
+/*
+ * The caller must hold the version lock.
+ */
+static rbtdb_glue_table_node_t *
+glue_find(rbtdb_version_t *version, rdatasetheader_t *header) {
+	rbtdb_glue_table_node_t *cur;
 
-	entry = NULL;
-	dns_acache_attachentry(acarray[count].entry, &entry);
+	if (version->glue_table == NULL)
+		return (NULL);
 
-	NODE_UNLOCK(nodelock, isc_rwlocktype_read);
+	cur = version->glue_table[glue_hash(header, version->glue_table_bits)];
+	while (cur != NULL && cur->header != header)
+		cur = cur->next;
+	return (cur);
+}
 
-	result = dns_acache_getentry(entry, zonep, dbp, versionp,
-				     nodep, fname, msg, now);
+/*
+ * Double the size of the glue table of 'version', or create it if it
+ * does not exist yet.  Failure is not fatal as long as the table
+ * exists: it just stays crowded.  The caller must hold the version
+ * lock for writing.
+ */
+static isc_result_t
+glue_grow(dns_rbtdb_t *rbtdb, rbtdb_version_t *version) {
+	rbtdb_glue_table_node_t **table, *cur, *next;
+	unsigned int bits, hash;
+	size_t i, oldsize, size;
+
+	if (version->glue_table == NULL)
+		bits = GLUE_TABLE_INIT_BITS;
+	else if (version->glue_table_bits < GLUE_TABLE_MAX_BITS)
+		bits = version->glue_table_bits + 1;
+	else
+		return (ISC_R_SUCCESS);
 
-	dns_acache_detachentry(&entry);
+	size = (size_t)1 << bits;
+	table = isc_mem_get(rbtdb->common.mctx, size * sizeof(*table));
+	if (table == NULL)
+		return (ISC_R_NOMEMORY);
+	for (i = 0; i < size; i++)
+		table[i] = NULL;
+
+	if (version->glue_table != NULL) {
+		oldsize = (size_t)1 << version->glue_table_bits;
+		for (i = 0; i < oldsize; i++) {
+			for (cur = version->glue_table[i];
+			     cur != NULL;
+			     cur = next)
+			{
+				next = cur->next;
+				hash = glue_hash(cur->header, bits);
+				cur->next = table[hash];
+				table[hash] = cur;
+			}
+		}
+		isc_mem_put(rbtdb->common.mctx, version->glue_table,
+			    oldsize * sizeof(*version->glue_table));
+	}
 
-	return (result);
+	version->glue_table = table;
+	version->glue_table_bits = bits;
+	return (ISC_R_SUCCESS);
 }
 
-static void
-acache_callback(dns_acacheentry_t *entry, void **arg) {
-	dns_rbtdb_t *rbtdb;
-	dns_rbtnode_t *rbtnode;
-	nodelock_t *nodelock;
-	acachectl_t *acarray = NULL;
-	acache_cbarg_t *cbarg;
-	unsigned int count;
-
-	REQUIRE(arg != NULL);
-	cbarg = *arg;
+/*
+ * Look up the A and AAAA records of a name server in the NS rdataset
+ * being processed by rdataset_addglue(), the way query_addadditional()
+ * in named would, and add them to the glue list being built.
+ */
+static isc_result_t
+glue_nsdname_cb(void *arg, dns_name_t *name, dns_rdatatype_t qtype) {
+	rbtdb_glue_additionaldata_ctx_t *ctx = arg;
+	dns_rbtdb_t *rbtdb = ctx->rbtdb;
+	dns_dbversion_t *version = (dns_dbversion_t *)ctx->rbtversion;
+	dns_rdataset_t *sigrdataset_a = NULL, *sigrdataset_aaaa = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_fixedname_t fixed;
+	dns_name_t *foundname;
+	rbtdb_glue_t *glue;
+	isc_result_t result;
 
 	/*
-	 * The caller must hold the entry lock.
+	 * NS records want addresses in additional records.
 	 */
+	INSIST(qtype == dns_rdatatype_a);
 
-	rbtdb = (dns_rbtdb_t *)cbarg->db;
-	rbtnode = (dns_rbtnode_t *)cbarg->node;
+	/*
+	 * Name servers outside the zone are not ours to find.
+	 */
+	if (!dns_name_issubdomain(name, &rbtdb->common.origin))
+		return (ISC_R_SUCCESS);
 
-	nodelock = &rbtdb->node_locks[rbtnode->locknum].lock;
-	NODE_LOCK(nodelock, isc_rwlocktype_write);
+	dns_fixedname_init(&fixed);
+	foundname = dns_fixedname_name(&fixed);
+	result = zone_find((dns_db_t *)rbtdb, name, version,
+			   dns_rdatatype_any, DNS_DBFIND_GLUEOK, 0, &node,
+			   foundname, NULL, NULL);
+	if (result != ISC_R_SUCCESS && result != DNS_R_GLUE &&
+	    result != DNS_R_ZONECUT)
+	{
+		if (node != NULL)
+			detachnode((dns_db_t *)rbtdb, &node);
+		return (ISC_R_SUCCESS);
+	}
 
-	switch (cbarg->type) {
-	case dns_rdatasetadditional_fromauth:
-		acarray = cbarg->header->additional_auth;
-		break;
-	case dns_rdatasetadditional_fromglue:
-		acarray = cbarg->header->additional_glue;
-		break;
-	default:
-		INSIST(0);
+	glue = isc_mem_get(rbtdb->common.mctx, sizeof(*glue));
+	if (glue == NULL) {
+		detachnode((dns_db_t *)rbtdb, &node);
+		ctx->result = ISC_R_NOMEMORY;
+		return (ISC_R_NOMEMORY);
 	}
+	glue->next = NULL;
+	dns_fixedname_init(&glue->fixedname);
+	dns_name_copy(foundname, dns_fixedname_name(&glue->fixedname), NULL);
+	dns_rdataset_init(&glue->rdataset_a);
+	dns_rdataset_init(&glue->sigrdataset_a);
+	dns_rdataset_init(&glue->rdataset_aaaa);
+	dns_rdataset_init(&glue->sigrdataset_aaaa);
 
-	count = cbarg->count;
-	if (acarray != NULL && acarray[count].entry == entry) {
-		acarray[count].entry = NULL;
-		INSIST(acarray[count].cbarg == cbarg);
-		acarray[count].cbarg = NULL;
-		isc_mem_put(rbtdb->common.mctx, cbarg, sizeof(acache_cbarg_t));
-		dns_acache_detachentry(&entry);
+	/*
+	 * Only a secure zone's signatures are worth keeping.
+	 */
+	if (ctx->rbtversion->secure == dns_db_secure) {
+		sigrdataset_a = &glue->sigrdataset_a;
+		sigrdataset_aaaa = &glue->sigrdataset_aaaa;
 	}
 
-	NODE_UNLOCK(nodelock, isc_rwlocktype_write);
+	(void)zone_findrdataset((dns_db_t *)rbtdb, node, version,
+				dns_rdatatype_a, 0, 0, &glue->rdataset_a,
+				sigrdataset_a);
+	(void)zone_findrdataset((dns_db_t *)rbtdb, node, version,
+				dns_rdatatype_aaaa, 0, 0, &glue->rdataset_aaaa,
+				sigrdataset_aaaa);
+	detachnode((dns_db_t *)rbtdb, &node);
 
-	dns_db_detachnode((dns_db_t *)rbtdb, (dns_dbnode_t **)(void*)&rbtnode);
-	dns_db_detach((dns_db_t **)(void*)&rbtdb);
+	if (!dns_rdataset_isassociated(&glue->rdataset_a) &&
+	    !dns_rdataset_isassociated(&glue->rdataset_aaaa))
+	{
+		free_gluelist(rbtdb->common.mctx, glue);
+		return (ISC_R_SUCCESS);
+	}
 
-	*arg = NULL;
+	if (ctx->glue_tail == NULL)
+		ctx->glue_list = glue;
+	else
+		ctx->glue_tail->next = glue;
+	ctx->glue_tail = glue;
+
+	return (ISC_R_SUCCESS);
 }
 
-static void
-acache_cancelentry(isc_mem_t *mctx, dns_acacheentry_t *entry,
-		      acache_cbarg_t **cbargp)
+/*
+ * Add 'rdataset' and, if wanted, 'sigrdataset' to 'name' in 'msg',
+ * unless 'name' already has the type.
+ */
+static isc_result_t
+glue_addrdataset(dns_message_t *msg, dns_name_t *name,
+		 dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
 {
-	acache_cbarg_t *cbarg;
+	dns_rdataset_t *clone = NULL, *sigclone = NULL;
+	isc_result_t result;
 
-	REQUIRE(mctx != NULL);
-	REQUIRE(entry != NULL);
-	REQUIRE(cbargp != NULL && *cbargp != NULL);
+	if (!dns_rdataset_isassociated(rdataset))
+		return (ISC_R_SUCCESS);
 
-	cbarg = *cbargp;
+	if (dns_message_findtype(name, rdataset->type, 0, NULL) ==
+	    ISC_R_SUCCESS)
+		return (ISC_R_SUCCESS);
 
-	if (dns_acache_cancelentry(entry)) {
-		dns_db_detachnode(cbarg->db, &cbarg->node);
-		dns_db_detach(&cbarg->db);
+	result = dns_message_gettemprdataset(msg, &clone);
+	if (result != ISC_R_SUCCESS)
+		return (result);
+	if (sigrdataset != NULL && dns_rdataset_isassociated(sigrdataset)) {
+		result = dns_message_gettemprdataset(msg, &sigclone);
+		if (result != ISC_R_SUCCESS) {
+			dns_message_puttemprdataset(msg, &clone);
+			return (result);
+		}
 	}
 
-	isc_mem_put(mctx, cbarg, sizeof(acache_cbarg_t));
-
-	*cbargp = NULL;
+	dns_rdataset_clone(rdataset, clone);
+	ISC_LIST_APPEND(name->list, clone, link);
+	if (sigclone != NULL) {
+		dns_rdataset_clone(sigrdataset, sigclone);
+		ISC_LIST_APPEND(name->list, sigclone, link);
+	}
+	return (ISC_R_SUCCESS);
 }
 
+/*
+ * Copy 'glue_list' into the additional section of 'msg'.
+ */
 static isc_result_t
-rdataset_setadditional(dns_rdataset_t *rdataset, dns_rdatasetadditional_t type,
-		       dns_rdatatype_t qtype, dns_acache_t *acache,
-		       dns_zone_t *zone, dns_db_t *db,
-		       dns_dbversion_t *version, dns_dbnode_t *node,
-		       dns_name_t *fname)
+glue_addmessage(rbtdb_glue_t *glue_list, unsigned int options,
+		dns_message_t *msg)
 {
-	dns_rbtdb_t *rbtdb = rdataset->private1;
-	dns_rbtnode_t *rbtnode = rdataset->private2;
-	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
-	unsigned int current_count = rdataset->privateuint4;
-	rdatasetheader_t *header;
-	unsigned int total_count, count;
-	nodelock_t *nodelock;
+	isc_boolean_t dnssec = ISC_TF((options &
+				       DNS_RDATASETADDGLUE_DNSSEC) != 0);
+	isc_buffer_t *buffer = NULL;
+	rbtdb_glue_t *glue;
+	dns_name_t *gluename, *name;
+	unsigned int length = 0;
 	isc_result_t result;
-	acachectl_t *acarray;
-	dns_acacheentry_t *newentry, *oldentry = NULL;
-	acache_cbarg_t *newcbarg, *oldcbarg = NULL;
-
-	UNUSED(qtype);
 
-	if (type == dns_rdatasetadditional_fromcache)
+	if (glue_list == NULL)
 		return (ISC_R_SUCCESS);
 
-	header = (struct rdatasetheader *)(raw - sizeof(*header));
-
-	total_count = raw[0] * 256 + raw[1];
-	INSIST(total_count > current_count);
-	count = total_count - current_count - 1; /* should be private data */
-
-	newcbarg = isc_mem_get(rbtdb->common.mctx, sizeof(*newcbarg));
-	if (newcbarg == NULL)
-		return (ISC_R_NOMEMORY);
-	newcbarg->type = type;
-	newcbarg->count = count;
-	newcbarg->header = header;
-	newcbarg->db = NULL;
-	dns_db_attach((dns_db_t *)rbtdb, &newcbarg->db);
-	newcbarg->node = NULL;
-	dns_db_attachnode((dns_db_t *)rbtdb, (dns_dbnode_t *)rbtnode,
-			  &newcbarg->node);
-	newentry = NULL;
-	result = dns_acache_createentry(acache, (dns_db_t *)rbtdb,
-					acache_callback, newcbarg, &newentry);
-	if (result != ISC_R_SUCCESS)
-		goto fail;
-
-	/* Set cache data in the new entry. */
-	result = dns_acache_setentry(acache, newentry, zone, db,
-				     version, node, fname);
+	/*
+	 * One buffer holds all the owner names that have to be added.
+	 */
+	for (glue = glue_list; glue != NULL; glue = glue->next)
+		length += dns_fixedname_name(&glue->fixedname)->length;
+	result = isc_buffer_allocate(msg->mctx, &buffer, length);
 	if (result != ISC_R_SUCCESS)
-		goto fail;
-
-	nodelock = &rbtdb->node_locks[rbtnode->locknum].lock;
-	NODE_LOCK(nodelock, isc_rwlocktype_write);
-
-	acarray = NULL;
-	switch (type) {
-	case dns_rdatasetadditional_fromauth:
-		acarray = header->additional_auth;
-		break;
-	case dns_rdatasetadditional_fromglue:
-		acarray = header->additional_glue;
-		break;
-	default:
-		INSIST(0);
-	}
-
-	if (acarray == NULL) {
-		unsigned int i;
-
-		acarray = isc_mem_get(rbtdb->common.mctx, total_count *
-				      sizeof(acachectl_t));
+		return (result);
 
-		if (acarray == NULL) {
-			NODE_UNLOCK(nodelock, isc_rwlocktype_write);
-			goto fail;
-		}
+	for (glue = glue_list; glue != NULL; glue = glue->next) {
+		isc_boolean_t need_addname = ISC_FALSE;
 
-		for (i = 0; i < total_count; i++) {
-			acarray[i].entry = NULL;
-			acarray[i].cbarg = NULL;
+		gluename = dns_fixedname_name(&glue->fixedname);
+		name = NULL;
+		result = dns_message_findname(msg, DNS_SECTION_ADDITIONAL,
+					      gluename, dns_rdatatype_any, 0,
+					      &name, NULL);
+		if (result != ISC_R_SUCCESS) {
+			result = dns_message_gettempname(msg, &name);
+			if (result != ISC_R_SUCCESS)
+				goto cleanup;
+			dns_name_init(name, NULL);
+			result = dns_name_copy(gluename, name, buffer);
+			INSIST(result == ISC_R_SUCCESS);
+			need_addname = ISC_TRUE;
 		}
-	}
-	switch (type) {
-	case dns_rdatasetadditional_fromauth:
-		header->additional_auth = acarray;
-		break;
-	case dns_rdatasetadditional_fromglue:
-		header->additional_glue = acarray;
-		break;
-	default:
-		INSIST(0);
-	}
-
-	if (acarray[count].entry != NULL) {
-		/*
-		 * Swap the entry.  Delay cleaning-up the old entry since
-		 * it would require a node lock.
-		 */
-		oldentry = acarray[count].entry;
-		INSIST(acarray[count].cbarg != NULL);
-		oldcbarg = acarray[count].cbarg;
-	}
-	acarray[count].entry = newentry;
-	acarray[count].cbarg = newcbarg;
 
-	NODE_UNLOCK(nodelock, isc_rwlocktype_write);
-
-	if (oldentry != NULL) {
-		acache_cancelentry(rbtdb->common.mctx, oldentry, &oldcbarg);
-		dns_acache_detachentry(&oldentry);
-	}
-
-	return (ISC_R_SUCCESS);
-
- fail:
-	if (newcbarg != NULL) {
-		if (newentry != NULL) {
-			acache_cancelentry(rbtdb->common.mctx, newentry,
-					   &newcbarg);
-			dns_acache_detachentry(&newentry);
-		} else {
-			dns_db_detachnode((dns_db_t *)rbtdb, &newcbarg->node);
-			dns_db_detach(&newcbarg->db);
-			isc_mem_put(rbtdb->common.mctx, newcbarg,
-			    sizeof(*newcbarg));
+		result = glue_addrdataset(msg, name, &glue->rdataset_a,
+					  dnssec ? &glue->sigrdataset_a : NULL);
+		if (result == ISC_R_SUCCESS)
+			result = glue_addrdataset(msg, name,
+						  &glue->rdataset_aaaa,
+						  dnssec ?
+						  &glue->sigrdataset_aaaa :
+						  NULL);
+
+		if (need_addname) {
+			if (ISC_LIST_EMPTY(name->list))
+				dns_message_puttempname(msg, &name);
+			else
+				dns_message_addname(msg, name,
+						    DNS_SECTION_ADDITIONAL);
 		}
+		if (result != ISC_R_SUCCESS)
+			goto cleanup;
 	}
 
+ cleanup:
+	/*
+	 * The names added refer to the buffer, so it has to last as
+	 * long as the message does.
+	 */
+	dns_message_takebuffer(msg, &buffer);
 	return (result);
 }
 
 static isc_result_t
-rdataset_putadditional(dns_acache_t *acache, dns_rdataset_t *rdataset,
-		       dns_rdatasetadditional_t type, dns_rdatatype_t qtype)
+rdataset_addglue(dns_rdataset_t *rdataset, dns_dbversion_t *version,
+		 unsigned int options, dns_message_t *msg)
 {
 	dns_rbtdb_t *rbtdb = rdataset->private1;
-	dns_rbtnode_t *rbtnode = rdataset->private2;
+	rbtdb_version_t *rbtversion = version;
 	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
-	unsigned int current_count = rdataset->privateuint4;
 	rdatasetheader_t *header;
-	nodelock_t *nodelock;
-	unsigned int total_count, count;
-	acachectl_t *acarray;
-	dns_acacheentry_t *entry;
-	acache_cbarg_t *cbarg;
-
-	UNUSED(qtype);          /* we do not use this value at least for now */
-	UNUSED(acache);
+	rbtdb_glue_table_node_t *cur;
+	rbtdb_glue_additionaldata_ctx_t ctx;
+	rbtdb_glue_t *glue_list;
+	unsigned int hash;
+	isc_result_t result;
 
-	if (type == dns_rdatasetadditional_fromcache)
-		return (ISC_R_SUCCESS);
+	if (rbtversion->rbtdb != rbtdb || IS_CACHE(rbtdb))
+		return (ISC_R_FAILURE);
 
 	header = (struct rdatasetheader *)(raw - sizeof(*header));
 
-	total_count = raw[0] * 256 + raw[1];
-	INSIST(total_count > current_count);
-	count = total_count - current_count - 1;
-
-	acarray = NULL;
-	entry = NULL;
-
-	nodelock = &rbtdb->node_locks[rbtnode->locknum].lock;
-	NODE_LOCK(nodelock, isc_rwlocktype_write);
+	/*
+	 * The glue list of a table node never changes once it has
+	 * been added, and is only freed with the version, which the
+	 * caller has open; so it can be used after the lock is
+	 * released.
+	 */
+	RWLOCK(&rbtversion->rwlock, isc_rwlocktype_read);
+	cur = glue_find(rbtversion, header);
+	RWUNLOCK(&rbtversion->rwlock, isc_rwlocktype_read);
+	if (cur != NULL)
+		return (glue_addmessage(cur->glue_list, options, msg));
 
-	switch (type) {
-	case dns_rdatasetadditional_fromauth:
-		acarray = header->additional_auth;
-		break;
-	case dns_rdatasetadditional_fromglue:
-		acarray = header->additional_glue;
-		break;
-	default:
-		INSIST(0);
+	/*
+	 * Not seen in this version yet.  Look the addresses up without
+	 * holding the lock, then add them to the table unless another
+	 * thread got there first.
+	 */
+	ctx.rbtdb = rbtdb;
+	ctx.rbtversion = rbtversion;
+	ctx.glue_list = NULL;
+	ctx.glue_tail = NULL;
+	ctx.result = ISC_R_SUCCESS;
+	(void)dns_rdataset_additionaldata(rdataset, glue_nsdname_cb, &ctx);
+	if (ctx.result != ISC_R_SUCCESS) {
+		free_gluelist(rbtdb->common.mctx, ctx.glue_list);
+		return (ctx.result);
+	}
+
+	RWLOCK(&rbtversion->rwlock, isc_rwlocktype_write);
+	cur = glue_find(rbtversion, header);
+	if (cur == NULL) {
+		result = ISC_R_SUCCESS;
+		if (rbtversion->glue_table == NULL ||
+		    rbtversion->glue_table_count >
+		    (1U << rbtversion->glue_table_bits))
+			result = glue_grow(rbtdb, rbtversion);
+		if (rbtversion->glue_table == NULL)
+			cur = NULL;
+		else
+			cur = isc_mem_get(rbtdb->common.mctx, sizeof(*cur));
+		if (cur == NULL) {
+			RWUNLOCK(&rbtversion->rwlock, isc_rwlocktype_write);
+			free_gluelist(rbtdb->common.mctx, ctx.glue_list);
+			return (result != ISC_R_SUCCESS ? result :
+				ISC_R_NOMEMORY);
+		}
+		cur->header = header;
+		cur->glue_list = ctx.glue_list;
+		ctx.glue_list = NULL;
+		hash = glue_hash(header, rbtversion->glue_table_bits);
+		cur->next = rbtversion->glue_table[hash];
+		rbtversion->glue_table[hash] = cur;
+		rbtversion->glue_table_count++;
 	}
+	glue_list = cur->glue_list;
+	RWUNLOCK(&rbtversion->rwlock, isc_rwlocktype_write);
 
-	if (acarray == NULL) {
-		NODE_UNLOCK(nodelock, isc_rwlocktype_write);
-		return (ISC_R_NOTFOUND);
-	}
+	free_gluelist(rbtdb->common.mctx, ctx.glue_list);
 
-	entry = acarray[count].entry;
-	if (entry == NULL) {
-		NODE_UNLOCK(nodelock, isc_rwlocktype_write);
-		return (ISC_R_NOTFOUND);
-	}
+	return (glue_addmessage(glue_list, options, msg));
+}
 
-	acarray[count].entry = NULL;
-	cbarg = acarray[count].cbarg;
-	acarray[count].cbarg = NULL;
+/*
+ * The caller must hold the node lock for writing, unless 'header' has
+ * not been linked into the database yet.
+ */
+static void
+setownercase(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
+	     const dns_name_t *name)
+{
+	rdatasetheader_ext_t *ext;
+	unsigned int i;
 
-	NODE_UNLOCK(nodelock, isc_rwlocktype_write);
+	header->attributes &= ~(RDATASET_ATTR_CASESET |
+				RDATASET_ATTR_CASEFULLYLOWER);
 
-	if (entry != NULL) {
-		if (cbarg != NULL)
-			acache_cancelentry(rbtdb->common.mctx, entry, &cbarg);
-		dns_acache_detachentry(&entry);
+	for (i = 0; i < name->length; i++)
+		if (name->ndata[i] >= 0x41 && name->ndata[i] <= 0x5a)
+			break;
+	if (ISC_LIKELY(i == name->length)) {
+		/*
+		 * The usual case, which needs no case vector.
+		 */
+		header->attributes |= RDATASET_ATTR_CASESET |
+				      RDATASET_ATTR_CASEFULLYLOWER;
+		return;
 	}
 
-	return (ISC_R_SUCCESS);
-}
-
-static void
-setownercase(rdatasetheader_t *header, const dns_name_t *name) {
-	unsigned int i;
-	isc_boolean_t fully_lower;
+	/*
+	 * If there is no memory for the case vector, leave the case
+	 * unset: the owner name is then rendered as it was asked for.
+	 */
+	ext = header_ext(rbtdb, header);
+	if (ext == NULL)
+		return;
 
 	/*
 	 * We do not need to worry about label lengths as they are all
 	 * less than or equal to 63.
 	 */
-	memset(header->upper, 0, sizeof(header->upper));
-	fully_lower = ISC_TRUE;
-	for (i = 0; i < name->length; i++)
-		if (name->ndata[i] >= 0x41 && name->ndata[i] <= 0x5a) {
-			header->upper[i/8] |= 1 << (i%8);
-			fully_lower = ISC_FALSE;
-		}
+	memset(ext->upper, 0, sizeof(ext->upper));
+	for (; i < name->length; i++)
+		if (name->ndata[i] >= 0x41 && name->ndata[i] <= 0x5a)
+			ext->upper[i/8] |= 1 << (i%8);
 	header->attributes |= RDATASET_ATTR_CASESET;
-	if (ISC_LIKELY(fully_lower))
-		header->attributes |= RDATASET_ATTR_CASEFULLYLOWER;
 }
 
 static void
 rdataset_setownercase(dns_rdataset_t *rdataset, const dns_name_t *name) {
+	dns_rbtdb_t *rbtdb = rdataset->private1;
+	dns_rbtnode_t *rbtnode = rdataset->private2;
 	unsigned char *raw = rdataset->private3;        /* RDATASLAB */
 	rdatasetheader_t *header;
 
 	header = (struct rdatasetheader *)(raw - sizeof(*header));
-	setownercase(header, name);
+
+	NODE_LOCK(&rbtdb->node_locks[rbtnode->locknum].lock,
+		  isc_rwlocktype_write);
+	setownercase(rbtdb, header, name);
+	NODE_UNLOCK(&rbtdb->node_locks[rbtnode->locknum].lock,
+		    isc_rwlocktype_write);
 }
 
 static const unsigned char charmask[] = {
@@ -10199,6 +11106,7 @@ static void
 rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 	const unsigned char *raw = rdataset->private3;        /* RDATASLAB */
 	const rdatasetheader_t *header;
+	const unsigned char *upper;
 	unsigned int i, j;
 	unsigned char bits;
 	unsigned char c, flip;
@@ -10218,10 +11126,10 @@ rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 		 * Set the case bit if it does not match the recorded bit.
 		 */
 		if (name->ndata[i] >= 0x61 && name->ndata[i] <= 0x7a &&
-		    (header->upper[i/8] & (1 << (i%8))) != 0)
+		    (upper[i/8] & (1 << (i%8))) != 0)
 			name->ndata[i] &= ~0x20; /* clear the lower case bit */
 		else if (name->ndata[i] >= 0x41 && name->ndata[i] <= 0x5a &&
-			 (header->upper[i/8] & (1 << (i%8))) == 0)
+			 (upper[i/8] & (1 << (i%8))) == 0)
 			name->ndata[i] |= 0x20; /* set the lower case bit */
 	}
 #else
@@ -10248,11 +11156,12 @@ rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 		return;
 	}
 
+	upper = header->ext->upper;
 	i = 0;
 	for (j = 0; j < (name->length >> 3); j++) {
 		unsigned int k;
 
-		bits = ~(header->upper[j]);
+		bits = ~(upper[j]);
 
 		for (k = 0; k < 8; k++) {
 			c = name->ndata[i];
@@ -10269,7 +11178,7 @@ rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 	if (ISC_UNLIKELY(i == name->length))
 		return;
 
-	bits = ~(header->upper[j]);
+	bits = ~(upper[j]);
 
 	for (; i < name->length; i++) {
 		c = name->ndata[i];
@@ -10285,7 +11194,101 @@ rdataset_getownercase(const dns_rdataset_t *rdataset, dns_name_t *name) {
 
 /*%
  * Routines for LRU-based cache management.
+ *
+ * Each bucket of a cache keeps a segmented LRU list, a simple form of
+ * 2Q: new entries go to the head of the bucket's cold list, and move to
+ * the head of its hot list when they are used again at least
+ * LRU_PROMOTE_DELAY seconds after they were added.  Entries are purged
+ * from the tail of the cold list first, and from the hot list only once
+ * the cold list is empty, so a flood of names which are each looked up
+ * only once (a random subdomain attack, say) only displaces other such
+ * names rather than the popular ones.  The hot list may hold at most
+ * three quarters of the bucket's entries; beyond that its tail goes back
+ * to the head of the cold list.
+ *
+ * Caller must hold the node (write) lock of the bucket.
  */
+#define LRU_PROMOTE_DELAY	3	/*%< Seconds. */
+
+static inline void
+lru_insert(dns_rbtdb_t *rbtdb, rdatasetheader_t *header, isc_boolean_t hot) {
+	rbtdb_lru_t *lru = &rbtdb->lru[header->node->locknum];
+
+	if (hot && !ZEROTTL(header)) {
+		header->attributes |= RDATASET_ATTR_HOT;
+		ISC_LIST_PREPEND(lru->hot, header, link);
+		lru->nhot++;
+		lru_balance(rbtdb, lru);
+		return;
+	}
+
+	header->attributes &= ~RDATASET_ATTR_HOT;
+	if (ZEROTTL(header))
+		ISC_LIST_APPEND(lru->cold, header, link);
+	else
+		ISC_LIST_PREPEND(lru->cold, header, link);
+	lru->ncold++;
+}
+
+static inline void
+lru_unlink(dns_rbtdb_t *rbtdb, rdatasetheader_t *header) {
+	rbtdb_lru_t *lru = &rbtdb->lru[header->node->locknum];
+
+	if (HOT(header)) {
+		ISC_LIST_UNLINK(lru->hot, header, link);
+		INSIST(lru->nhot > 0);
+		lru->nhot--;
+	} else {
+		ISC_LIST_UNLINK(lru->cold, header, link);
+		INSIST(lru->ncold > 0);
+		lru->ncold--;
+	}
+}
+
+/*%
+ * The entry of bucket 'locknum' to be purged next.
+ */
+static inline rdatasetheader_t *
+lru_tail(dns_rbtdb_t *rbtdb, unsigned int locknum) {
+	rdatasetheader_t *header;
+
+	header = ISC_LIST_TAIL(rbtdb->lru[locknum].cold);
+	if (header == NULL)
+		header = ISC_LIST_TAIL(rbtdb->lru[locknum].hot);
+	return (header);
+}
+
+/*%
+ * The order in which overmem_purge() compares the LRU tails of different
+ * buckets: every cold entry comes before every hot one, and within each
+ * list the least recently used come first.
+ */
+static inline isc_uint64_t
+lru_key(rdatasetheader_t *header) {
+	return ((HOT(header) ? (isc_uint64_t)1 << 32 : 0) +
+		header->u.last_used);
+}
+
+/*%
+ * Move entries from the tail of the hot list to the cold list until the
+ * hot list holds no more than its share of the bucket's entries.
+ */
+static inline void
+lru_balance(dns_rbtdb_t *rbtdb, rbtdb_lru_t *lru) {
+	rdatasetheader_t *header;
+
+	while (lru->nhot > 1 && lru->nhot * 4 > (lru->nhot + lru->ncold) * 3) {
+		header = ISC_LIST_TAIL(lru->hot);
+		ISC_LIST_UNLINK(lru->hot, header, link);
+		lru->nhot--;
+		header->attributes &= ~RDATASET_ATTR_HOT;
+		ISC_LIST_PREPEND(lru->cold, header, link);
+		lru->ncold++;
+		if (rbtdb->cachestats != NULL)
+			isc_stats_increment(rbtdb->cachestats,
+					    dns_cachestatscounter_demotelru);
+	}
+}
 
 /*%
  * See if a given cache entry that is being reused needs to be updated
@@ -10311,6 +11314,14 @@ need_headerupdate(rdatasetheader_t *header, isc_stdtime_t now) {
 	      RDATASET_ATTR_ZEROTTL)) != 0)
 		return (ISC_FALSE);
 
+	/*
+	 * A cold entry stays where it is until it is used again a while
+	 * after it was added; the lookup right after the resolver added
+	 * it doesn't count.
+	 */
+	if (!HOT(header) && header->u.last_used + LRU_PROMOTE_DELAY > now)
+		return (ISC_FALSE);
+
 #if DNS_RBTDB_LIMITLRUUPDATE
 	if (header->type == dns_rdatatype_ns ||
 	    (header->trust == dns_trust_glue &&
@@ -10320,11 +11331,11 @@ need_headerupdate(rdatasetheader_t *header, isc_stdtime_t now) {
 		 * Glue records are updated if at least 60 seconds have passed
 		 * since the previous update time.
 		 */
-		return (header->last_used + 60 <= now);
+		return (header->u.last_used + 60 <= now);
 	}
 
 	/* Other records are updated if 5 minutes have passed. */
-	return (header->last_used + 300 <= now);
+	return (header->u.last_used + 300 <= now);
 #else
 	UNUSED(now);
 
@@ -10334,7 +11345,7 @@ need_headerupdate(rdatasetheader_t *header, isc_stdtime_t now) {
 
 /*%
  * Update the timestamp of a given cache entry and move it to the head
- * of the corresponding LRU list.
+ * of the corresponding hot LRU list.
  *
  * Caller must hold the node (write) lock.
  *
@@ -10349,9 +11360,77 @@ update_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
 	/* To be checked: can we really assume this? XXXMLG */
 	INSIST(ISC_LINK_LINKED(header, link));
 
-	ISC_LIST_UNLINK(rbtdb->rdatasets[header->node->locknum], header, link);
-	header->last_used = now;
-	ISC_LIST_PREPEND(rbtdb->rdatasets[header->node->locknum], header, link);
+	if (!HOT(header) && rbtdb->cachestats != NULL)
+		isc_stats_increment(rbtdb->cachestats,
+				    dns_cachestatscounter_promotelru);
+
+	lru_unlink(rbtdb, header);
+	header->u.last_used = now;
+	lru_insert(rbtdb, header, ISC_TRUE);
+}
+
+/*%
+ * Pick the bucket, other than 'locknum_start', from which overmem_purge()
+ * should purge next.
+ *
+ * Each bucket has its own LRU list, so with many buckets the tail of any
+ * one of them is unlikely to be among the least recently used entries of
+ * the whole cache.  Look at the tails of a few buckets, taking turns so
+ * that every bucket is looked at now and then, and pick the one with an
+ * expired entry at the top of its heap or else the least recently used
+ * tail, preferring cold tails to hot ones (see lru_key()).  Buckets which
+ * are busy are not waited for.  '*limitp' is set to the key of the next
+ * best tail: entries with a greater key should not be purged from the
+ * chosen bucket.
+ */
+static unsigned int
+overmem_victim(dns_rbtdb_t *rbtdb, unsigned int locknum_start,
+	       isc_stdtime_t now, isc_uint64_t *limitp)
+{
+	rdatasetheader_t *header;
+	unsigned int locknum, victim, samples, i;
+	isc_uint64_t used, oldest = 0, limit = ISC_UINT64_MAX;
+	isc_boolean_t found = ISC_FALSE;
+
+	samples = ISC_MIN(OVERMEM_SAMPLES, rbtdb->node_lock_count - 1);
+	locknum = rbtdb->lru_cursor % rbtdb->node_lock_count;
+	victim = locknum_start;
+	for (i = 0; i < samples; i++) {
+		locknum = (locknum + 1) % rbtdb->node_lock_count;
+		if (locknum == locknum_start)
+			locknum = (locknum + 1) % rbtdb->node_lock_count;
+		if (i == 0)
+			victim = locknum;
+
+		if (NODE_TRYLOCK(&rbtdb->node_locks[locknum].lock,
+				 isc_rwlocktype_read) != ISC_R_SUCCESS)
+			continue;
+		header = isc_heap_element(rbtdb->heaps[locknum], 1);
+		if (header != NULL && header->rdh_ttl < now - RBTDB_VIRTUAL) {
+			used = 0;
+		} else {
+			header = lru_tail(rbtdb, locknum);
+			used = (header != NULL) ? lru_key(header) : 0;
+		}
+		NODE_UNLOCK(&rbtdb->node_locks[locknum].lock,
+			    isc_rwlocktype_read);
+
+		if (header == NULL)
+			continue;
+		if (!found || used < oldest) {
+			if (found)
+				limit = oldest;
+			victim = locknum;
+			oldest = used;
+			found = ISC_TRUE;
+		} else if (used < limit)
+			limit = used;
+	}
+	rbtdb->lru_cursor = locknum;
+
+	INSIST(victim != locknum_start);
+	*limitp = limit;
+	return (victim);
 }
 
 /*%
@@ -10362,33 +11441,47 @@ update_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
  * the one to which the new entry will belong.  Otherwise, we might purge
  * entries of the same name of different RR types while adding RRsets from a
  * single response (consider the case where we're adding A and AAAA glue records
- * of the same NS name).
+ * of the same NS name).  'tree_locked' is set if the caller holds the write
+ * lock of the tree 'shard'; headers of nodes in other trees are expired as if
+ * no tree lock were held.
  */
 static void
 overmem_purge(dns_rbtdb_t *rbtdb, unsigned int locknum_start,
-	      isc_stdtime_t now, isc_boolean_t tree_locked)
+	      unsigned int shard, isc_stdtime_t now, isc_boolean_t tree_locked)
 {
-	rdatasetheader_t *header, *header_prev;
-	unsigned int locknum;
+	rdatasetheader_t *header;
+	unsigned int locknum, round;
+	isc_uint64_t limit;
 	int purgecount = 2;
+	int purged;
+
+	for (round = 0; round < 2 && purgecount > 0; round++) {
+		locknum = overmem_victim(rbtdb, locknum_start, now, &limit);
+		purged = 0;
 
-	for (locknum = (locknum_start + 1) % rbtdb->node_lock_count;
-	     locknum != locknum_start && purgecount > 0;
-	     locknum = (locknum + 1) % rbtdb->node_lock_count) {
 		NODE_LOCK(&rbtdb->node_locks[locknum].lock,
 			  isc_rwlocktype_write);
 
 		header = isc_heap_element(rbtdb->heaps[locknum], 1);
 		if (header && header->rdh_ttl < now - RBTDB_VIRTUAL) {
-			expire_header(rbtdb, header, tree_locked,
+			expire_header(rbtdb, header,
+				      ISC_TF(tree_locked &&
+					     header->node->shard == shard),
 				      expire_ttl);
 			purgecount--;
+			purged++;
 		}
 
-		for (header = ISC_LIST_TAIL(rbtdb->rdatasets[locknum]);
-		     header != NULL && purgecount > 0;
-		     header = header_prev) {
-			header_prev = ISC_LIST_PREV(header, link);
+		while (purgecount > 0 &&
+		       (header = lru_tail(rbtdb, locknum)) != NULL)
+		{
+			/*
+			 * Once something has been purged here, leave entries
+			 * used more recently than the tail of another bucket
+			 * for the next round.
+			 */
+			if (purged > 0 && lru_key(header) > limit)
+				break;
 			/*
 			 * Unlink the entry at this point to avoid checking it
 			 * again even if it's currently used someone else and
@@ -10396,15 +11489,20 @@ overmem_purge(dns_rbtdb_t *rbtdb, unsigned int locknum_start,
 			 * referenced any more (so unlinking is safe) since the
 			 * TTL was reset to 0.
 			 */
-			ISC_LIST_UNLINK(rbtdb->rdatasets[locknum], header,
-					link);
-			expire_header(rbtdb, header, tree_locked,
+			lru_unlink(rbtdb, header);
+			expire_header(rbtdb, header,
+				      ISC_TF(tree_locked &&
+					     header->node->shard == shard),
 				      expire_lru);
 			purgecount--;
+			purged++;
 		}
 
 		NODE_UNLOCK(&rbtdb->node_locks[locknum].lock,
-				    isc_rwlocktype_write);
+			    isc_rwlocktype_write);
+
+		if (purged == 0)
+			break;
 	}
 }
 
@@ -10412,6 +11510,8 @@ static void
 expire_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
 	      isc_boolean_t tree_locked, expire_t reason)
 {
+	isc_boolean_t hot = HOT(header);
+
 	set_ttl(rbtdb, header, 0);
 	mark_stale_header(rbtdb, header);
 
@@ -10442,6 +11542,9 @@ expire_header(dns_rbtdb_t *rbtdb, rdatasetheader_t *header,
 		case expire_lru:
 			isc_stats_increment(rbtdb->cachestats,
 					    dns_cachestatscounter_deletelru);
+			if (hot)
+				isc_stats_increment(rbtdb->cachestats,
+					    dns_cachestatscounter_deletelruhot);
 			break;
 		default:
 			break;
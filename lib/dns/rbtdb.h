@@ -38,9 +38,24 @@ dns_rbtdb_create(isc_mem_t *mctx, dns_name_t *base, dns_dbtype_t type,
  * allocation of heap memory.  Generally this is used for cache databases
  * only.
  *
+ * A cache database whose argv[1] is "sharded" keeps names of three or more
+ * labels (counting the root label) in several trees, each with its own lock, chosen by their last
+ * three labels.  Lookups then only contend with changes to the same tree,
+ * but the database iterator no longer returns names in DNSSEC order: it
+ * walks the trees one after the other.
+ *
  * Requires:
  *
  * \li argc == 0 or argv[0] is a valid memory context.
+ * \li argc < 2 or argv[1] is a NUL-terminated string.
+ */
+
+void
+dns_rbtdb_setnodelockcount(dns_dbtype_t type, unsigned int count);
+/*%<
+ * Set the number of node lock buckets of databases of type "rbt"
+ * created from now on.  Called via dns_db_setnodelockcount(); see
+ * documentation for that function for more details.
  */
 
 ISC_LANG_ENDDECLS
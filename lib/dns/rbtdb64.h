@@ -31,6 +31,9 @@ dns_rbtdb64_create(isc_mem_t *mctx, dns_name_t *base, dns_dbtype_t type,
 		   dns_rdataclass_t rdclass, unsigned int argc, char *argv[],
 		   void *driverarg, dns_db_t **dbp);
 
+void
+dns_rbtdb64_setnodelockcount(dns_dbtype_t type, unsigned int count);
+
 ISC_LANG_ENDDECLS
 
 #endif /* DNS_RBTDB64_H */
@@ -2300,6 +2300,24 @@ dns_rdatatype_atparent(dns_rdatatype_t type) {
 	return (ISC_FALSE);
 }
 
+isc_boolean_t
+dns_rdatatype_isverbatim(dns_rdataclass_t rdclass, dns_rdatatype_t type) {
+	/*
+	 * The attributes are the same for a type in every class, but
+	 * the Chaosnet A record holds a domain name.
+	 */
+	if (type == dns_rdatatype_a)
+		return (ISC_TF(rdclass != dns_rdataclass_ch));
+
+	/*
+	 * dns_rdata_towire() copies rdata of unknown types unchanged.
+	 */
+	if ((dns_rdatatype_attributes(type) &
+	     (DNS_RDATATYPEATTR_VERBATIM | DNS_RDATATYPEATTR_UNKNOWN)) != 0)
+		return (ISC_TRUE);
+	return (ISC_FALSE);
+}
+
 isc_boolean_t
 dns_rdataclass_ismeta(dns_rdataclass_t rdclass) {
 
@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_AVC_258_C
 #define RDATA_GENERIC_AVC_258_C
 
-#define RRTYPE_AVC_ATTRIBUTES (0)
+#define RRTYPE_AVC_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_avc(ARGS_FROMTEXT) {
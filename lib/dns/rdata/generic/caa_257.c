@@ -9,7 +9,7 @@
 #ifndef GENERIC_CAA_257_C
 #define GENERIC_CAA_257_C 1
 
-#define RRTYPE_CAA_ATTRIBUTES (0)
+#define RRTYPE_CAA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static unsigned char const alphanumeric[256] = {
 	/* 0x00-0x0f */ 0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0, 0, 0, 0,
@@ -13,7 +13,7 @@
 
 #include <dst/dst.h>
 
-#define RRTYPE_CDNSKEY_ATTRIBUTES 0
+#define RRTYPE_CDNSKEY_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_cdnskey(ARGS_FROMTEXT) {
@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_CDS_59_C
 #define RDATA_GENERIC_CDS_59_C
 
-#define RRTYPE_CDS_ATTRIBUTES 0
+#define RRTYPE_CDS_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 #include <isc/sha1.h>
 #include <isc/sha2.h>
@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_CERT_37_C
 #define RDATA_GENERIC_CERT_37_C
 
-#define RRTYPE_CERT_ATTRIBUTES (0)
+#define RRTYPE_CERT_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_cert(ARGS_FROMTEXT) {
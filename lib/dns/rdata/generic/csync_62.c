@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_CSYNC_62_C
 #define RDATA_GENERIC_CSYNC_62_C
 
-#define RRTYPE_CSYNC_ATTRIBUTES 0
+#define RRTYPE_CSYNC_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_csync(ARGS_FROMTEXT) {
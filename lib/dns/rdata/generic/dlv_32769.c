@@ -13,7 +13,7 @@
 #ifndef RDATA_GENERIC_DLV_32769_C
 #define RDATA_GENERIC_DLV_32769_C
 
-#define RRTYPE_DLV_ATTRIBUTES 0
+#define RRTYPE_DLV_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 #include <isc/sha1.h>
 #include <isc/sha2.h>
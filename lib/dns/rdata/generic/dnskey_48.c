@@ -19,7 +19,8 @@
 
 #include <dst/dst.h>
 
-#define RRTYPE_DNSKEY_ATTRIBUTES (DNS_RDATATYPEATTR_DNSSEC)
+#define RRTYPE_DNSKEY_ATTRIBUTES \
+	(DNS_RDATATYPEATTR_DNSSEC | DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_dnskey(ARGS_FROMTEXT) {
@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_DOA_259_C
 #define RDATA_GENERIC_DOA_259_C
 
-#define RRTYPE_DOA_ATTRIBUTES (0)
+#define RRTYPE_DOA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_doa(ARGS_FROMTEXT) {
@@ -14,7 +14,8 @@
 #define RDATA_GENERIC_DS_43_C
 
 #define RRTYPE_DS_ATTRIBUTES \
-	(DNS_RDATATYPEATTR_DNSSEC|DNS_RDATATYPEATTR_ATPARENT)
+	(DNS_RDATATYPEATTR_DNSSEC|DNS_RDATATYPEATTR_ATPARENT|\
+	 DNS_RDATATYPEATTR_VERBATIM)
 
 #include <isc/sha1.h>
 #include <isc/sha2.h>
@@ -11,7 +11,7 @@
 
 #include <string.h>
 
-#define RRTYPE_EUI64_ATTRIBUTES (0)
+#define RRTYPE_EUI64_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_eui64(ARGS_FROMTEXT) {
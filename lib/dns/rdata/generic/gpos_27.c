@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_GPOS_27_C
 #define RDATA_GENERIC_GPOS_27_C
 
-#define RRTYPE_GPOS_ATTRIBUTES (0)
+#define RRTYPE_GPOS_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_gpos(ARGS_FROMTEXT) {
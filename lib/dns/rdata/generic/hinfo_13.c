@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_HINFO_13_C
 #define RDATA_GENERIC_HINFO_13_C
 
-#define RRTYPE_HINFO_ATTRIBUTES (0)
+#define RRTYPE_HINFO_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_hinfo(ARGS_FROMTEXT) {
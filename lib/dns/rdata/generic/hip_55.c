@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_HIP_5_C
 #define RDATA_GENERIC_HIP_5_C
 
-#define RRTYPE_HIP_ATTRIBUTES (0)
+#define RRTYPE_HIP_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_hip(ARGS_FROMTEXT) {
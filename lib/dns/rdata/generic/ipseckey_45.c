@@ -15,7 +15,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_IPSECKEY_ATTRIBUTES (0)
+#define RRTYPE_IPSECKEY_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_ipseckey(ARGS_FROMTEXT) {
@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_ISDN_20_C
 #define RDATA_GENERIC_ISDN_20_C
 
-#define RRTYPE_ISDN_ATTRIBUTES (0)
+#define RRTYPE_ISDN_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_isdn(ARGS_FROMTEXT) {
@@ -14,7 +14,7 @@
 
 #include <dst/dst.h>
 
-#define RRTYPE_KEYDATA_ATTRIBUTES (0)
+#define RRTYPE_KEYDATA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_keydata(ARGS_FROMTEXT) {
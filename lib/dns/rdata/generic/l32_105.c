@@ -13,7 +13,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_L32_ATTRIBUTES (0)
+#define RRTYPE_L32_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_l32(ARGS_FROMTEXT) {
@@ -13,7 +13,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_L64_ATTRIBUTES (0)
+#define RRTYPE_L64_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_l64(ARGS_FROMTEXT) {
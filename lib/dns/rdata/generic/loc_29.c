@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_LOC_29_C
 #define RDATA_GENERIC_LOC_29_C
 
-#define RRTYPE_LOC_ATTRIBUTES (0)
+#define RRTYPE_LOC_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_loc(ARGS_FROMTEXT) {
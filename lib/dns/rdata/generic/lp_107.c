@@ -13,7 +13,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_LP_ATTRIBUTES (0)
+#define RRTYPE_LP_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_lp(ARGS_FROMTEXT) {
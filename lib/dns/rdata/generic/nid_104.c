@@ -13,7 +13,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_NID_ATTRIBUTES (0)
+#define RRTYPE_NID_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_nid(ARGS_FROMTEXT) {
@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_NINFO_56_C
 #define RDATA_GENERIC_NINFO_56_C
 
-#define RRTYPE_NINFO_ATTRIBUTES (0)
+#define RRTYPE_NINFO_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_ninfo(ARGS_FROMTEXT) {
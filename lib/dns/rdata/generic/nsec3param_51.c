@@ -32,7 +32,8 @@
 #include <isc/iterated_hash.h>
 #include <isc/base32.h>
 
-#define RRTYPE_NSEC3PARAM_ATTRIBUTES (DNS_RDATATYPEATTR_DNSSEC)
+#define RRTYPE_NSEC3PARAM_ATTRIBUTES \
+	(DNS_RDATATYPEATTR_DNSSEC | DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_nsec3param(ARGS_FROMTEXT) {
@@ -19,7 +19,8 @@
  * The attributes do not include DNS_RDATATYPEATTR_SINGLETON
  * because we must be able to handle a parent/child NSEC pair.
  */
-#define RRTYPE_NSEC_ATTRIBUTES (DNS_RDATATYPEATTR_DNSSEC)
+#define RRTYPE_NSEC_ATTRIBUTES \
+	(DNS_RDATATYPEATTR_DNSSEC | DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_nsec(ARGS_FROMTEXT) {
@@ -90,19 +91,17 @@ fromwire_nsec(ARGS_FROMWIRE) {
 static inline isc_result_t
 towire_nsec(ARGS_TOWIRE) {
 	isc_region_t sr;
-	dns_name_t name;
-	dns_offsets_t offsets;
 
 	REQUIRE(rdata->type == dns_rdatatype_nsec);
 	REQUIRE(rdata->length != 0);
 
-	dns_compress_setmethods(cctx, DNS_COMPRESS_NONE);
-	dns_name_init(&name, offsets);
-	dns_rdata_toregion(rdata, &sr);
-	dns_name_fromregion(&name, &sr);
-	isc_region_consume(&sr, name_length(&name));
-	RETERR(dns_name_towire(&name, cctx, target));
+	UNUSED(cctx);
 
+	/*
+	 * The next owner name is neither compressed nor made available
+	 * as a compression target, so the rdata is copied unchanged.
+	 */
+	dns_rdata_toregion(rdata, &sr);
 	return (mem_tobuffer(target, sr.base, sr.length));
 }
 
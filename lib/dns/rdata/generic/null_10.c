@@ -13,7 +13,7 @@
 #ifndef RDATA_GENERIC_NULL_10_C
 #define RDATA_GENERIC_NULL_10_C
 
-#define RRTYPE_NULL_ATTRIBUTES (0)
+#define RRTYPE_NULL_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_null(ARGS_FROMTEXT) {
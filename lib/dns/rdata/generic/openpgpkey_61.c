@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_OPENPGPKEY_61_C
 #define RDATA_GENERIC_OPENPGPKEY_61_C
 
-#define RRTYPE_OPENPGPKEY_ATTRIBUTES 0
+#define RRTYPE_OPENPGPKEY_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_openpgpkey(ARGS_FROMTEXT) {
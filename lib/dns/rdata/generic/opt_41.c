@@ -15,7 +15,8 @@
 
 #define RRTYPE_OPT_ATTRIBUTES (DNS_RDATATYPEATTR_SINGLETON | \
 			       DNS_RDATATYPEATTR_META | \
-			       DNS_RDATATYPEATTR_NOTQUESTION)
+			       DNS_RDATATYPEATTR_NOTQUESTION | \
+			       DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_opt(ARGS_FROMTEXT) {
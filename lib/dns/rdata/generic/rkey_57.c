@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_RKEY_57_C
 #define RDATA_GENERIC_RKEY_57_C
 
-#define RRTYPE_RKEY_ATTRIBUTES 0
+#define RRTYPE_RKEY_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_rkey(ARGS_FROMTEXT) {
@@ -15,7 +15,8 @@
 #ifndef RDATA_GENERIC_RRSIG_46_C
 #define RDATA_GENERIC_RRSIG_46_C
 
-#define RRTYPE_RRSIG_ATTRIBUTES (DNS_RDATATYPEATTR_DNSSEC)
+#define RRTYPE_RRSIG_ATTRIBUTES \
+	(DNS_RDATATYPEATTR_DNSSEC | DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_rrsig(ARGS_FROMTEXT) {
@@ -300,37 +301,17 @@ fromwire_rrsig(ARGS_FROMWIRE) {
 static inline isc_result_t
 towire_rrsig(ARGS_TOWIRE) {
 	isc_region_t sr;
-	dns_name_t name;
-	dns_offsets_t offsets;
 
 	REQUIRE(rdata->type == dns_rdatatype_rrsig);
 	REQUIRE(rdata->length != 0);
 
-	dns_compress_setmethods(cctx, DNS_COMPRESS_NONE);
-	dns_rdata_toregion(rdata, &sr);
-	/*
-	 * type covered: 2
-	 * algorithm: 1
-	 * labels: 1
-	 * original ttl: 4
-	 * signature expiration: 4
-	 * time signed: 4
-	 * key footprint: 2
-	 */
-	RETERR(mem_tobuffer(target, sr.base, 18));
-	isc_region_consume(&sr, 18);
-
-	/*
-	 * Signer.
-	 */
-	dns_name_init(&name, offsets);
-	dns_name_fromregion(&name, &sr);
-	isc_region_consume(&sr, name_length(&name));
-	RETERR(dns_name_towire(&name, cctx, target));
+	UNUSED(cctx);
 
 	/*
-	 * Signature.
+	 * The signer name is neither compressed nor made available
+	 * as a compression target, so the rdata is copied unchanged.
 	 */
+	dns_rdata_toregion(rdata, &sr);
 	return (mem_tobuffer(target, sr.base, sr.length));
 }
 
@@ -11,7 +11,7 @@
 
 #include <dst/dst.h>
 
-#define RRTYPE_SINK_ATTRIBUTES (0)
+#define RRTYPE_SINK_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_sink(ARGS_FROMTEXT) {
@@ -9,7 +9,7 @@
 #ifndef RDATA_GENERIC_SMIMEA_53_C
 #define RDATA_GENERIC_SMIMEA_53_C
 
-#define RRTYPE_SMIMEA_ATTRIBUTES 0
+#define RRTYPE_SMIMEA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_smimea(ARGS_FROMTEXT) {
@@ -13,7 +13,7 @@
 #ifndef RDATA_GENERIC_SPF_99_C
 #define RDATA_GENERIC_SPF_99_C
 
-#define RRTYPE_SPF_ATTRIBUTES (0)
+#define RRTYPE_SPF_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_spf(ARGS_FROMTEXT) {
@@ -13,7 +13,7 @@
 #ifndef RDATA_GENERIC_SSHFP_44_C
 #define RDATA_GENERIC_SSHFP_44_C
 
-#define RRTYPE_SSHFP_ATTRIBUTES (0)
+#define RRTYPE_SSHFP_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_sshfp(ARGS_FROMTEXT) {
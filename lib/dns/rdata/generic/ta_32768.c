@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_TA_32768_C
 #define RDATA_GENERIC_TA_32768_C
 
-#define RRTYPE_TA_ATTRIBUTES 0
+#define RRTYPE_TA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_ta(ARGS_FROMTEXT) {
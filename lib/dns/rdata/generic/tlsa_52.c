@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_TLSA_52_C
 #define RDATA_GENERIC_TLSA_52_C
 
-#define RRTYPE_TLSA_ATTRIBUTES 0
+#define RRTYPE_TLSA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 generic_fromtext_tlsa(ARGS_FROMTEXT) {
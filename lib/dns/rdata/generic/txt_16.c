@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_TXT_16_C
 #define RDATA_GENERIC_TXT_16_C
 
-#define RRTYPE_TXT_ATTRIBUTES (0)
+#define RRTYPE_TXT_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 generic_fromtext_txt(ARGS_FROMTEXT) {
@@ -11,7 +11,7 @@
 #ifndef RDATA_GENERIC_UNSPEC_103_C
 #define RDATA_GENERIC_UNSPEC_103_C
 
-#define RRTYPE_UNSPEC_ATTRIBUTES (0)
+#define RRTYPE_UNSPEC_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_unspec(ARGS_FROMTEXT) {
@@ -11,7 +11,7 @@
 #ifndef GENERIC_URI_256_C
 #define GENERIC_URI_256_C 1
 
-#define RRTYPE_URI_ATTRIBUTES (0)
+#define RRTYPE_URI_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_uri(ARGS_FROMTEXT) {
@@ -15,7 +15,7 @@
 #ifndef RDATA_GENERIC_X25_19_C
 #define RDATA_GENERIC_X25_19_C
 
-#define RRTYPE_X25_ATTRIBUTES (0)
+#define RRTYPE_X25_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_x25(ARGS_FROMTEXT) {
@@ -17,7 +17,7 @@
 
 #include <isc/net.h>
 
-#define RRTYPE_AAAA_ATTRIBUTES (0)
+#define RRTYPE_AAAA_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_in_aaaa(ARGS_FROMTEXT) {
@@ -13,7 +13,7 @@
 #ifndef RDATA_IN_1_APL_42_C
 #define RDATA_IN_1_APL_42_C
 
-#define RRTYPE_APL_ATTRIBUTES (0)
+#define RRTYPE_APL_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_in_apl(ARGS_FROMTEXT) {
@@ -13,7 +13,7 @@
 #ifndef RDATA_IN_1_DHCID_49_C
 #define RDATA_IN_1_DHCID_49_C 1
 
-#define RRTYPE_DHCID_ATTRIBUTES 0
+#define RRTYPE_DHCID_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_in_dhcid(ARGS_FROMTEXT) {
@@ -15,7 +15,7 @@
 #ifndef RDATA_IN_1_NSAP_22_C
 #define RDATA_IN_1_NSAP_22_C
 
-#define RRTYPE_NSAP_ATTRIBUTES (0)
+#define RRTYPE_NSAP_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static inline isc_result_t
 fromtext_in_nsap(ARGS_FROMTEXT) {
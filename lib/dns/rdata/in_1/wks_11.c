@@ -20,7 +20,7 @@
 #include <isc/netdb.h>
 #include <isc/once.h>
 
-#define RRTYPE_WKS_ATTRIBUTES (0)
+#define RRTYPE_WKS_ATTRIBUTES (DNS_RDATATYPEATTR_VERBATIM)
 
 static isc_mutex_t wks_lock;
 
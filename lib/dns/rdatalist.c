@@ -39,11 +39,9 @@ static dns_rdatasetmethods_t methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
-	NULL,
 	isc__rdatalist_setownercase,
-	isc__rdatalist_getownercase
+	isc__rdatalist_getownercase,
+	NULL
 };
 
 void
@@ -197,8 +197,6 @@ static dns_rdatasetmethods_t question_methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
 	NULL
 };
 
@@ -317,8 +315,11 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 	unsigned int i, count = 0, added, choice;
 	isc_buffer_t savedbuffer, rdlen, rrbuffer;
 	unsigned int headlen;
+	unsigned char head[2 + 8];	/* pointer, type, class, ttl */
+	unsigned int samehead = 0;
 	isc_boolean_t question = ISC_FALSE;
 	isc_boolean_t shuffle = ISC_FALSE;
+	isc_boolean_t verbatim = ISC_FALSE;
 	dns_rdata_t *in = NULL, in_fixed[MAX_SHUFFLE];
 	struct towire_sort *out = NULL, out_fixed[MAX_SHUFFLE];
 	dns_fixedname_t fixed;
@@ -456,6 +457,17 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 			qsort(out, count, sizeof(out[0]), towire_compare);
 	}
 
+	/*
+	 * Rdata that dns_rdata_towire() would render unchanged is
+	 * copied straight from the rdataset instead.  Such rdata adds
+	 * nothing to the compression table, so once the owner name has
+	 * been rendered as a compression pointer every following record
+	 * starts with the same bytes, and they are copied too.
+	 */
+	if (!question)
+		verbatim = dns_rdatatype_isverbatim(rdataset->rdclass,
+						    rdataset->type);
+
 	savedbuffer = *target;
 	i = 0;
 	added = 0;
@@ -474,24 +486,44 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 		 */
 
 		rrbuffer = *target;
-		dns_compress_setmethods(cctx, DNS_COMPRESS_GLOBAL14);
-		result = dns_name_towire(name, cctx, target);
-		if (result != ISC_R_SUCCESS)
-			goto rollback;
-		headlen = sizeof(dns_rdataclass_t) + sizeof(dns_rdatatype_t);
-		if (!question)
-			headlen += sizeof(dns_ttl_t)
-				+ 2;  /* XXX 2 for rdata len */
-		isc_buffer_availableregion(target, &r);
-		if (r.length < headlen) {
-			result = ISC_R_NOSPACE;
-			goto rollback;
+		if (samehead != 0) {
+			isc_buffer_availableregion(target, &r);
+			if (r.length < samehead + 2) {
+				result = ISC_R_NOSPACE;
+				goto rollback;
+			}
+			isc_buffer_putmem(target, head, samehead);
+		} else {
+			dns_compress_setmethods(cctx, DNS_COMPRESS_GLOBAL14);
+			result = dns_name_towire(name, cctx, target);
+			if (result != ISC_R_SUCCESS)
+				goto rollback;
+			headlen = sizeof(dns_rdataclass_t) +
+				  sizeof(dns_rdatatype_t);
+			if (!question)
+				headlen += sizeof(dns_ttl_t)
+					+ 2;  /* XXX 2 for rdata len */
+			isc_buffer_availableregion(target, &r);
+			if (r.length < headlen) {
+				result = ISC_R_NOSPACE;
+				goto rollback;
+			}
+			isc_buffer_putuint16(target, rdataset->type);
+			isc_buffer_putuint16(target, rdataset->rdclass);
+			if (!question)
+				isc_buffer_putuint32(target, rdataset->ttl);
+			if (verbatim &&
+			    target->used - rrbuffer.used <= sizeof(head)) {
+				/*
+				 * The owner name was rendered as a
+				 * pointer (or is the root name).
+				 */
+				samehead = target->used - rrbuffer.used;
+				memmove(head, (unsigned char *)rrbuffer.base +
+					rrbuffer.used, samehead);
+			}
 		}
-		isc_buffer_putuint16(target, rdataset->type);
-		isc_buffer_putuint16(target, rdataset->rdclass);
 		if (!question) {
-			isc_buffer_putuint32(target, rdataset->ttl);
-
 			/*
 			 * Save space for rdlen.
 			 */
@@ -507,9 +539,20 @@ towiresorted(dns_rdataset_t *rdataset, const dns_name_t *owner_name,
 				dns_rdata_reset(&rdata);
 				dns_rdataset_current(rdataset, &rdata);
 			}
-			result = dns_rdata_towire(&rdata, cctx, target);
-			if (result != ISC_R_SUCCESS)
-				goto rollback;
+			if (verbatim) {
+				isc_buffer_availableregion(target, &r);
+				if (r.length < rdata.length) {
+					result = ISC_R_NOSPACE;
+					goto rollback;
+				}
+				memmove(r.base, rdata.data, rdata.length);
+				isc_buffer_add(target, rdata.length);
+			} else {
+				result = dns_rdata_towire(&rdata, cctx,
+							  target);
+				if (result != ISC_R_SUCCESS)
+					goto rollback;
+			}
 			INSIST((target->used >= rdlen.used + 2) &&
 			       (target->used - rdlen.used - 2 < 65536));
 			isc_buffer_putuint16(&rdlen,
@@ -679,83 +722,6 @@ dns_rdataset_getclosest(dns_rdataset_t *rdataset, dns_name_t *name,
 	return((rdataset->methods->getclosest)(rdataset, name, neg, negsig));
 }
 
-/*
- * Additional cache stuff
- */
-isc_result_t
-dns_rdataset_getadditional(dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype,
-			   dns_acache_t *acache,
-			   dns_zone_t **zonep,
-			   dns_db_t **dbp,
-			   dns_dbversion_t **versionp,
-			   dns_dbnode_t **nodep,
-			   dns_name_t *fname,
-			   dns_message_t *msg,
-			   isc_stdtime_t now)
-{
-	REQUIRE(DNS_RDATASET_VALID(rdataset));
-	REQUIRE(rdataset->methods != NULL);
-	REQUIRE(zonep == NULL || *zonep == NULL);
-	REQUIRE(dbp != NULL && *dbp == NULL);
-	REQUIRE(versionp != NULL && *versionp == NULL);
-	REQUIRE(nodep != NULL && *nodep == NULL);
-	REQUIRE(fname != NULL);
-	REQUIRE(msg != NULL);
-
-	if (acache != NULL && rdataset->methods->getadditional != NULL) {
-		return ((rdataset->methods->getadditional)(rdataset, type,
-							   qtype, acache,
-							   zonep, dbp,
-							   versionp, nodep,
-							   fname, msg, now));
-	}
-
-	return (ISC_R_FAILURE);
-}
-
-isc_result_t
-dns_rdataset_setadditional(dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype,
-			   dns_acache_t *acache,
-			   dns_zone_t *zone,
-			   dns_db_t *db,
-			   dns_dbversion_t *version,
-			   dns_dbnode_t *node,
-			   dns_name_t *fname)
-{
-	REQUIRE(DNS_RDATASET_VALID(rdataset));
-	REQUIRE(rdataset->methods != NULL);
-
-	if (acache != NULL && rdataset->methods->setadditional != NULL) {
-		return ((rdataset->methods->setadditional)(rdataset, type,
-							   qtype, acache, zone,
-							   db, version,
-							   node, fname));
-	}
-
-	return (ISC_R_FAILURE);
-}
-
-isc_result_t
-dns_rdataset_putadditional(dns_acache_t *acache,
-			   dns_rdataset_t *rdataset,
-			   dns_rdatasetadditional_t type,
-			   dns_rdatatype_t qtype)
-{
-	REQUIRE(DNS_RDATASET_VALID(rdataset));
-	REQUIRE(rdataset->methods != NULL);
-
-	if (acache != NULL && rdataset->methods->putadditional != NULL) {
-		return ((rdataset->methods->putadditional)(acache, rdataset,
-							   type, qtype));
-	}
-
-	return (ISC_R_FAILURE);
-}
-
 void
 dns_rdataset_settrust(dns_rdataset_t *rdataset, dns_trust_t trust) {
 	REQUIRE(DNS_RDATASET_VALID(rdataset));
@@ -829,3 +795,19 @@ dns_rdataset_trimttl(dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset,
 	rdataset->ttl = ttl;
 	sigrdataset->ttl = ttl;
 }
+
+isc_result_t
+dns_rdataset_addglue(dns_rdataset_t *rdataset, dns_dbversion_t *version,
+		     unsigned int options, dns_message_t *msg)
+{
+	REQUIRE(DNS_RDATASET_VALID(rdataset));
+	REQUIRE(rdataset->methods != NULL);
+	REQUIRE(rdataset->type == dns_rdatatype_ns);
+	REQUIRE(version != NULL);
+	REQUIRE(msg != NULL);
+
+	if (rdataset->methods->addglue == NULL)
+		return (ISC_R_NOTIMPLEMENTED);
+
+	return ((rdataset->methods->addglue)(rdataset, version, options, msg));
+}
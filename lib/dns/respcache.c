@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*! \file */
+
+#include <config.h>
+
+#include <isc/atomic.h>
+#include <isc/buffer.h>
+#include <isc/magic.h>
+#include <isc/mem.h>
+#include <isc/mutex.h>
+#include <isc/platform.h>
+#include <isc/string.h>
+#include <isc/util.h>
+
+#include <dns/name.h>
+#include <dns/respcache.h>
+#include <dns/types.h>
+#include <dns/zone.h>
+
+typedef struct dns_rcentry dns_rcentry_t;
+typedef struct dns_rcshard dns_rcshard_t;
+typedef ISC_LIST(dns_rcentry_t) dns_rcentrylist_t;
+
+/*
+ * The entries are spread over a fixed number of shards by their hash
+ * value, each with its own lock, table and share of the memory limit,
+ * so that queries for different names rarely wait for each other.
+ */
+#define RESPCACHE_SHARDS	16
+
+struct dns_rcshard {
+	isc_mutex_t		lock;
+	dns_rcentry_t		**table;
+	unsigned int		count;
+	unsigned int		hashsize;
+	size_t			size;
+	size_t			maxsize;
+	/*
+	 * The entries in the order the clock hand visits them.
+	 */
+	dns_rcentrylist_t	entries;
+	dns_rcentry_t		*hand;
+};
+
+struct dns_respcache {
+	unsigned int		magic;
+	isc_mem_t		*mctx;
+#ifdef ISC_PLATFORM_HAVEXADD
+	isc_int32_t		generation;
+#else
+	isc_mutex_t		lock;
+	isc_uint32_t		generation;	/* Locked by lock */
+#endif
+	dns_rcshard_t		shards[RESPCACHE_SHARDS];
+};
+
+#define RESPCACHE_MAGIC			ISC_MAGIC('R', 's', 'p', 'C')
+#define VALID_RESPCACHE(m)		ISC_MAGIC_VALID(m, RESPCACHE_MAGIC)
+
+/*
+ * Each entry is allocated together with the (lower case) query name
+ * and the response that follow it.  'referenced' is set whenever the
+ * entry is used and cleared when the clock hand passes it; entries
+ * which have not been used since the hand last passed are evicted.
+ */
+struct dns_rcentry {
+	dns_rcentry_t			*next;
+	ISC_LINK(dns_rcentry_t)		link;
+	unsigned int			hashval;
+	isc_boolean_t			referenced;
+	dns_zone_t			*zone;
+	isc_uint32_t			zonegen;
+	isc_uint32_t			key;
+	dns_rdatatype_t			type;
+	unsigned int			wirelen;
+	dns_name_t			name;
+};
+
+#define RESPCACHE_INITIALSIZE	61
+
+#define ENTRYSIZE(e) \
+	(sizeof(*(e)) + (e)->name.length + (e)->wirelen)
+#define ENTRYWIRE(e) \
+	((unsigned char *)((e) + 1) + (e)->name.length)
+
+#define SHARD(rc, hashval) \
+	(&(rc)->shards[(hashval) % RESPCACHE_SHARDS])
+
+isc_uint32_t
+dns_respcache_generation(dns_respcache_t *rc) {
+#ifdef ISC_PLATFORM_HAVEXADD
+	REQUIRE(VALID_RESPCACHE(rc));
+
+	return ((isc_uint32_t)isc_atomic_xadd(&rc->generation, 0));
+#else
+	isc_uint32_t value;
+
+	REQUIRE(VALID_RESPCACHE(rc));
+
+	LOCK(&rc->lock);
+	value = rc->generation;
+	UNLOCK(&rc->lock);
+	return (value);
+#endif
+}
+
+isc_result_t
+dns_respcache_create(isc_mem_t *mctx, size_t maxsize,
+		     dns_respcache_t **rcp)
+{
+	isc_result_t result;
+	dns_respcache_t *rc;
+	dns_rcshard_t *shard;
+	unsigned int i;
+
+	REQUIRE(mctx != NULL);
+	REQUIRE(maxsize != 0);
+	REQUIRE(rcp != NULL && *rcp == NULL);
+
+	rc = isc_mem_get(mctx, sizeof(*rc));
+	if (rc == NULL)
+		return (ISC_R_NOMEMORY);
+	memset(rc, 0, sizeof(*rc));
+
+	isc_mem_attach(mctx, &rc->mctx);
+#ifndef ISC_PLATFORM_HAVEXADD
+	result = isc_mutex_init(&rc->lock);
+	if (result != ISC_R_SUCCESS)
+		goto cleanup;
+#endif
+
+	for (i = 0; i < RESPCACHE_SHARDS; i++) {
+		shard = &rc->shards[i];
+		result = isc_mutex_init(&shard->lock);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup_shards;
+		shard->table = isc_mem_get(rc->mctx, sizeof(*shard->table) *
+					   RESPCACHE_INITIALSIZE);
+		if (shard->table == NULL) {
+			DESTROYLOCK(&shard->lock);
+			result = ISC_R_NOMEMORY;
+			goto cleanup_shards;
+		}
+		memset(shard->table, 0,
+		       sizeof(*shard->table) * RESPCACHE_INITIALSIZE);
+		shard->hashsize = RESPCACHE_INITIALSIZE;
+		shard->count = 0;
+		shard->size = 0;
+		shard->maxsize = maxsize / RESPCACHE_SHARDS;
+		ISC_LIST_INIT(shard->entries);
+		shard->hand = NULL;
+	}
+	rc->generation = 0;
+	rc->magic = RESPCACHE_MAGIC;
+
+	*rcp = rc;
+	return (ISC_R_SUCCESS);
+
+ cleanup_shards:
+	while (i-- > 0) {
+		shard = &rc->shards[i];
+		DESTROYLOCK(&shard->lock);
+		isc_mem_put(rc->mctx, shard->table,
+			    sizeof(*shard->table) * shard->hashsize);
+	}
+#ifndef ISC_PLATFORM_HAVEXADD
+	DESTROYLOCK(&rc->lock);
+ cleanup:
+#endif
+	isc_mem_putanddetach(&rc->mctx, rc, sizeof(*rc));
+	return (result);
+}
+
+void
+dns_respcache_destroy(dns_respcache_t **rcp) {
+	dns_respcache_t *rc;
+	dns_rcshard_t *shard;
+	unsigned int i;
+
+	REQUIRE(rcp != NULL);
+	rc = *rcp;
+	REQUIRE(VALID_RESPCACHE(rc));
+
+	dns_respcache_flush(rc);
+
+	rc->magic = 0;
+	for (i = 0; i < RESPCACHE_SHARDS; i++) {
+		shard = &rc->shards[i];
+		DESTROYLOCK(&shard->lock);
+		isc_mem_put(rc->mctx, shard->table,
+			    sizeof(*shard->table) * shard->hashsize);
+	}
+#ifndef ISC_PLATFORM_HAVEXADD
+	DESTROYLOCK(&rc->lock);
+#endif
+	isc_mem_putanddetach(&rc->mctx, rc, sizeof(*rc));
+	*rcp = NULL;
+}
+
+static inline unsigned int
+hash(dns_name_t *name, dns_rdatatype_t type, isc_uint32_t key) {
+	return (dns_name_hash(name, ISC_FALSE) ^ (type << 16) ^ key);
+}
+
+/*
+ * Free the entries on 'list'.  This detaches their zones, so the shard
+ * they came from must not be locked.
+ */
+static void
+free_entries(dns_respcache_t *rc, dns_rcentrylist_t *list) {
+	dns_rcentry_t *entry;
+
+	while ((entry = ISC_LIST_HEAD(*list)) != NULL) {
+		ISC_LIST_UNLINK(*list, entry, link);
+		dns_zone_idetach(&entry->zone);
+		isc_mem_put(rc->mctx, entry, ENTRYSIZE(entry));
+	}
+}
+
+/*
+ * Unlink 'entry', whose predecessor in its hash chain is 'prev', from
+ * 'shard' and add it to 'dead' to be freed once the shard is unlocked.
+ * The shard must be locked.
+ */
+static void
+unlink_entry(dns_rcshard_t *shard, dns_rcentry_t *entry, dns_rcentry_t *prev,
+	     dns_rcentrylist_t *dead)
+{
+	if (prev == NULL)
+		shard->table[entry->hashval % shard->hashsize] = entry->next;
+	else
+		prev->next = entry->next;
+	if (shard->hand == entry)
+		shard->hand = ISC_LIST_NEXT(entry, link);
+	ISC_LIST_UNLINK(shard->entries, entry, link);
+	INSIST(shard->size >= ENTRYSIZE(entry));
+	shard->size -= ENTRYSIZE(entry);
+	shard->count--;
+	ISC_LIST_APPEND(*dead, entry, link);
+}
+
+/*
+ * Find the entry for 'name', 'type' and 'key'; if 'prevp' is not NULL
+ * set it to the entry's predecessor in its hash chain.  The shard must
+ * be locked.
+ */
+static dns_rcentry_t *
+find_entry(dns_rcshard_t *shard, dns_name_t *name, dns_rdatatype_t type,
+	   isc_uint32_t key, unsigned int hashval, dns_rcentry_t **prevp)
+{
+	dns_rcentry_t *entry, *prev = NULL;
+
+	for (entry = shard->table[hashval % shard->hashsize];
+	     entry != NULL;
+	     prev = entry, entry = entry->next)
+	{
+		if (entry->hashval == hashval && entry->type == type &&
+		    entry->key == key && dns_name_equal(name, &entry->name))
+			break;
+	}
+	if (prevp != NULL)
+		*prevp = prev;
+	return (entry);
+}
+
+/*
+ * Advance the clock hand until it reaches an entry which has not been
+ * used since the hand last passed it, and evict that entry.  The shard
+ * must be locked and not empty.
+ */
+static void
+evict_entry(dns_rcshard_t *shard, dns_rcentrylist_t *dead) {
+	dns_rcentry_t *entry, *prev;
+
+	for (;;) {
+		if (shard->hand == NULL)
+			shard->hand = ISC_LIST_HEAD(shard->entries);
+		entry = shard->hand;
+		INSIST(entry != NULL);
+		if (!entry->referenced)
+			break;
+		entry->referenced = ISC_FALSE;
+		shard->hand = ISC_LIST_NEXT(entry, link);
+	}
+
+	(void)find_entry(shard, &entry->name, entry->type, entry->key,
+			 entry->hashval, &prev);
+	unlink_entry(shard, entry, prev, dead);
+}
+
+static void
+resize(dns_respcache_t *rc, dns_rcshard_t *shard) {
+	dns_rcentry_t **newtable, *entry, *next;
+	unsigned int newsize, i;
+
+	newsize = shard->hashsize * 2 + 1;
+	newtable = isc_mem_get(rc->mctx, sizeof(*newtable) * newsize);
+	if (newtable == NULL)
+		return;
+	memset(newtable, 0, sizeof(*newtable) * newsize);
+
+	for (i = 0; i < shard->hashsize; i++) {
+		for (entry = shard->table[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			entry->next = newtable[entry->hashval % newsize];
+			newtable[entry->hashval % newsize] = entry;
+		}
+	}
+
+	isc_mem_put(rc->mctx, shard->table,
+		    sizeof(*shard->table) * shard->hashsize);
+	shard->table = newtable;
+	shard->hashsize = newsize;
+}
+
+void
+dns_respcache_add(dns_respcache_t *rc, dns_name_t *name,
+		  dns_rdatatype_t type, isc_uint32_t key,
+		  dns_zone_t *zone, isc_uint32_t zonegen,
+		  isc_uint32_t generation, const isc_region_t *wire)
+{
+	dns_rcentry_t *entry, *old, *prev;
+	dns_rcshard_t *shard;
+	dns_rcentrylist_t dead;
+	unsigned int hashval;
+	isc_buffer_t buffer;
+	size_t size;
+
+	REQUIRE(VALID_RESPCACHE(rc));
+	REQUIRE(dns_name_isabsolute(name));
+	REQUIRE(zone != NULL);
+	REQUIRE(wire != NULL && wire->length >= 12);
+
+	hashval = hash(name, type, key);
+	shard = SHARD(rc, hashval);
+
+	size = sizeof(*entry) + name->length + wire->length;
+	if (size > shard->maxsize || (zonegen & 1) != 0 ||
+	    zonegen != dns_zone_getrespgen(zone))
+		return;
+
+	entry = isc_mem_get(rc->mctx, size);
+	if (entry == NULL)
+		return;
+	entry->hashval = hashval;
+	entry->referenced = ISC_FALSE;
+	entry->zone = NULL;
+	dns_zone_iattach(zone, &entry->zone);
+	entry->zonegen = zonegen;
+	entry->key = key;
+	entry->type = type;
+	entry->wirelen = wire->length;
+	dns_name_init(&entry->name, NULL);
+	isc_buffer_init(&buffer, entry + 1, name->length);
+	RUNTIME_CHECK(dns_name_downcase(name, &entry->name, &buffer) ==
+		      ISC_R_SUCCESS);
+	memmove(ENTRYWIRE(entry), wire->base, wire->length);
+	INSIST(ENTRYSIZE(entry) == size);
+	ISC_LINK_INIT(entry, link);
+
+	ISC_LIST_INIT(dead);
+
+	LOCK(&shard->lock);
+
+	/*
+	 * dns_respcache_invalidate() advances the generation before it
+	 * flushes the shards, so checking it with the shard locked means
+	 * the entry is either not added or flushed with the rest.
+	 */
+	if (generation != dns_respcache_generation(rc)) {
+		ISC_LIST_APPEND(dead, entry, link);
+		goto unlock;
+	}
+
+	old = find_entry(shard, name, type, key, hashval, &prev);
+	if (old != NULL)
+		unlink_entry(shard, old, prev, &dead);
+
+	/*
+	 * Make room for the new entry.
+	 */
+	while (shard->size + size > shard->maxsize)
+		evict_entry(shard, &dead);
+
+	entry->next = shard->table[hashval % shard->hashsize];
+	shard->table[hashval % shard->hashsize] = entry;
+	/*
+	 * Put the new entry just behind the hand, so that it is the last
+	 * one the hand reaches.
+	 */
+	if (shard->hand != NULL)
+		ISC_LIST_INSERTBEFORE(shard->entries, shard->hand,
+				      entry, link);
+	else
+		ISC_LIST_APPEND(shard->entries, entry, link);
+	shard->size += size;
+	shard->count++;
+
+	if (shard->count > shard->hashsize * 4)
+		resize(rc, shard);
+
+ unlock:
+	UNLOCK(&shard->lock);
+
+	free_entries(rc, &dead);
+}
+
+isc_result_t
+dns_respcache_find(dns_respcache_t *rc, dns_name_t *name,
+		   dns_rdatatype_t type, isc_uint32_t key,
+		   isc_buffer_t *target)
+{
+	dns_rcentry_t *entry, *prev;
+	dns_rcshard_t *shard;
+	dns_rcentrylist_t dead;
+	unsigned int hashval;
+	isc_result_t result;
+
+	REQUIRE(VALID_RESPCACHE(rc));
+	REQUIRE(ISC_BUFFER_VALID(target));
+
+	hashval = hash(name, type, key);
+	shard = SHARD(rc, hashval);
+	ISC_LIST_INIT(dead);
+
+	LOCK(&shard->lock);
+
+	if (shard->count == 0) {
+		result = ISC_R_NOTFOUND;
+		goto unlock;
+	}
+
+	entry = find_entry(shard, name, type, key, hashval, &prev);
+	if (entry == NULL) {
+		result = ISC_R_NOTFOUND;
+		goto unlock;
+	}
+	if (entry->zonegen != dns_zone_getrespgen(entry->zone)) {
+		unlink_entry(shard, entry, prev, &dead);
+		result = ISC_R_NOTFOUND;
+		goto unlock;
+	}
+	if (isc_buffer_availablelength(target) < entry->wirelen) {
+		result = ISC_R_NOSPACE;
+		goto unlock;
+	}
+
+	isc_buffer_putmem(target, ENTRYWIRE(entry), entry->wirelen);
+	entry->referenced = ISC_TRUE;
+	result = ISC_R_SUCCESS;
+
+ unlock:
+	UNLOCK(&shard->lock);
+
+	free_entries(rc, &dead);
+	return (result);
+}
+
+/*
+ * Remove all entries from 'shard'.
+ */
+static void
+flush_shard(dns_respcache_t *rc, dns_rcshard_t *shard) {
+	dns_rcentry_t *entry, *next;
+	dns_rcentrylist_t dead;
+	unsigned int i;
+
+	ISC_LIST_INIT(dead);
+
+	LOCK(&shard->lock);
+	for (i = 0; shard->count > 0 && i < shard->hashsize; i++) {
+		for (entry = shard->table[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			unlink_entry(shard, entry, NULL, &dead);
+		}
+	}
+	INSIST(shard->count == 0 && shard->size == 0);
+	INSIST(shard->hand == NULL);
+	UNLOCK(&shard->lock);
+
+	free_entries(rc, &dead);
+}
+
+void
+dns_respcache_flush(dns_respcache_t *rc) {
+	unsigned int i;
+
+	REQUIRE(VALID_RESPCACHE(rc));
+
+	for (i = 0; i < RESPCACHE_SHARDS; i++)
+		flush_shard(rc, &rc->shards[i]);
+}
+
+void
+dns_respcache_invalidate(dns_respcache_t *rc) {
+	REQUIRE(VALID_RESPCACHE(rc));
+
+#ifdef ISC_PLATFORM_HAVEXADD
+	(void)isc_atomic_xadd(&rc->generation, 1);
+#else
+	LOCK(&rc->lock);
+	rc->generation++;
+	UNLOCK(&rc->lock);
+#endif
+	dns_respcache_flush(rc);
+}
+
+void
+dns_respcache_getstats(dns_respcache_t *rc, unsigned int *countp,
+		       size_t *sizep)
+{
+	dns_rcshard_t *shard;
+	unsigned int i, count = 0;
+	size_t size = 0;
+
+	REQUIRE(VALID_RESPCACHE(rc));
+
+	for (i = 0; i < RESPCACHE_SHARDS; i++) {
+		shard = &rc->shards[i];
+		LOCK(&shard->lock);
+		count += shard->count;
+		size += shard->size;
+		UNLOCK(&shard->lock);
+	}
+	if (countp != NULL)
+		*countp = count;
+	if (sizep != NULL)
+		*sizep = size;
+}
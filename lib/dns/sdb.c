@@ -1291,7 +1291,12 @@ static dns_dbmethods_t sdb_methods = {
 	NULL,			/* setcachestats */
 	NULL,			/* hashsize */
 	NULL,			/* nodefullname */
-	NULL			/* getsize */
+	NULL,			/* getsize */
+	NULL,			/* getlockstats */
+	NULL,			/* setservestalettl */
+	NULL,			/* getservestalettl */
+	NULL,			/* bucketcount */
+	NULL			/* cleanbucket */
 };
 
 static isc_result_t
@@ -1421,8 +1426,6 @@ static dns_rdatasetmethods_t methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
 	NULL
 };
 
@@ -1325,7 +1325,12 @@ static dns_dbmethods_t sdlzdb_methods = {
 	NULL,			/* setcachestats */
 	NULL,			/* hashsize */
 	NULL,			/* nodefullname */
-	NULL			/* getsize */
+	NULL,			/* getsize */
+	NULL,			/* getlockstats */
+	NULL,			/* setservestalettl */
+	NULL,			/* getservestalettl */
+	NULL,			/* bucketcount */
+	NULL			/* cleanbucket */
 };
 
 /*
@@ -1475,8 +1480,6 @@ static dns_rdatasetmethods_t rdataset_methods = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,
 	NULL
 };
 
@@ -17,10 +17,21 @@
 #include <unistd.h>
 #include <stdlib.h>
 
+#include <isc/mem.h>
+#include <isc/print.h>
+#include <isc/stats.h>
+#include <isc/stdtime.h>
+
+#include <dns/cache.h>
 #include <dns/db.h>
 #include <dns/dbiterator.h>
+#include <dns/fixedname.h>
 #include <dns/name.h>
 #include <dns/journal.h>
+#include <dns/masterdump.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/stats.h>
 
 #include "dnstest.h"
 
@@ -32,6 +43,89 @@
 #define	BIGBUFLEN	(64 * 1024)
 #define TEST_ORIGIN	"test"
 
+static char sharded[] = "sharded";
+
+static void
+addrdatatrust(dns_db_t *db, const char *owner, dns_rdatatype_t type,
+	      const char *text, dns_trust_t trust, isc_stdtime_t now)
+{
+	unsigned char buf[BUFLEN];
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t rdataset;
+	dns_fixedname_t fixed;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	result = dns_test_rdata_fromstring(&rdata, dns_rdataclass_in, type,
+					   buf, sizeof(buf), text);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.type = type;
+	rdatalist.ttl = 3600;
+	ISC_LIST_APPEND(rdatalist.rdata, &rdata, link);
+	dns_rdataset_init(&rdataset);
+	result = dns_rdatalist_tordataset(&rdatalist, &rdataset);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	rdataset.trust = trust;
+
+	dns_fixedname_init(&fixed);
+	result = dns_name_fromstring(dns_fixedname_name(&fixed), owner, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_db_findnode(db, dns_fixedname_name(&fixed), ISC_TRUE,
+				 &node);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_addrdataset(db, node, NULL, now, &rdataset, 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_db_detachnode(db, &node);
+	dns_rdataset_disassociate(&rdataset);
+}
+
+static void
+addrdata(dns_db_t *db, const char *owner, dns_rdatatype_t type,
+	 const char *text, isc_stdtime_t now)
+{
+	addrdatatrust(db, owner, type, text, dns_trust_answer, now);
+}
+
+static isc_result_t
+findname(dns_db_t *db, const char *qname, isc_stdtime_t now,
+	 const char *expected)
+{
+	dns_fixedname_t fqname, ffound, fexpected;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	dns_fixedname_init(&fqname);
+	dns_fixedname_init(&ffound);
+	dns_fixedname_init(&fexpected);
+	result = dns_name_fromstring(dns_fixedname_name(&fqname), qname, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_name_fromstring(dns_fixedname_name(&fexpected),
+				     expected, 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, dns_fixedname_name(&fqname), NULL,
+			     dns_rdatatype_a, 0, now, &node,
+			     dns_fixedname_name(&ffound), &rdataset, NULL);
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	if (result == ISC_R_SUCCESS || result == DNS_R_DELEGATION ||
+	    result == DNS_R_DNAME)
+		ATF_CHECK(dns_name_equal(dns_fixedname_name(&ffound),
+					 dns_fixedname_name(&fexpected)));
+	return (result);
+}
+
 /*
  * Individual unit tests
  */
@@ -69,10 +163,725 @@ ATF_TC_BODY(getoriginnode, tc) {
 	isc_mem_detach(&mymctx);
 }
 
+ATF_TC(shardedcache);
+ATF_TC_HEAD(shardedcache, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "test lookups and iteration across the trees of "
+			  "a sharded cache database");
+}
+ATF_TC_BODY(shardedcache, tc) {
+	dns_db_t *db = NULL;
+	dns_dbiterator_t *iter = NULL;
+	dns_dbnode_t *node = NULL;
+	char *argv[2];
+	isc_stdtime_t now;
+	isc_result_t result;
+	unsigned int forward = 0, backward = 0;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	argv[0] = (char *)mctx;
+	argv[1] = sharded;
+	result = dns_db_create(mctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 2, argv, &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	isc_stdtime_get(&now);
+
+	/*
+	 * The top-level domains are in the main tree, the rest in shards.
+	 */
+	addrdata(db, "com.", dns_rdatatype_ns, "a.gtld.example.", now);
+	addrdata(db, "org.", dns_rdatatype_ns, "a.gtld.example.", now);
+	addrdata(db, "example.com.", dns_rdatatype_ns, "ns.example.com.", now);
+	addrdata(db, "www.example.com.", dns_rdatatype_a, "192.0.2.1", now);
+	addrdata(db, "www.example.org.", dns_rdatatype_a, "192.0.2.2", now);
+	addrdata(db, "a.b.example.info.", dns_rdatatype_a, "192.0.2.3", now);
+
+	ATF_CHECK_EQ(findname(db, "www.example.com.", now,
+			      "www.example.com."), ISC_R_SUCCESS);
+	ATF_CHECK_EQ(findname(db, "a.b.example.info.", now,
+			      "a.b.example.info."), ISC_R_SUCCESS);
+	/* Delegation in the same shard. */
+	ATF_CHECK_EQ(findname(db, "ftp.example.com.", now, "example.com."),
+		     DNS_R_DELEGATION);
+	/* Delegation from the main tree. */
+	ATF_CHECK_EQ(findname(db, "ftp.example.org.", now, "org."),
+		     DNS_R_DELEGATION);
+	ATF_CHECK_EQ(findname(db, "www.example.net.", now, "."),
+		     ISC_R_NOTFOUND);
+
+	/* A DNAME in the main tree applies to names in the shards. */
+	addrdata(db, "net.", dns_rdatatype_dname, "example.com.", now);
+	ATF_CHECK_EQ(findname(db, "www.example.net.", now, "net."),
+		     DNS_R_DNAME);
+
+	result = dns_db_createiterator(db, 0, &iter);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	for (result = dns_dbiterator_first(iter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_next(iter)) {
+		result = dns_dbiterator_current(iter, &node, NULL);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		forward++;
+	}
+	ATF_CHECK_EQ(result, ISC_R_NOMORE);
+	for (result = dns_dbiterator_last(iter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_prev(iter)) {
+		result = dns_dbiterator_current(iter, &node, NULL);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		backward++;
+	}
+	ATF_CHECK_EQ(result, ISC_R_NOMORE);
+	dns_dbiterator_destroy(&iter);
+
+	ATF_CHECK(forward >= 7);
+	ATF_CHECK_EQ(forward, backward);
+	ATF_CHECK_EQ(forward, dns_db_nodecount(db));
+
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+static void
+water(void *arg, int mark) {
+	UNUSED(arg);
+	UNUSED(mark);
+}
+
+static void
+countbuckets(isc_statscounter_t counter, isc_uint64_t value, void *arg) {
+	unsigned int *countp = arg;
+
+	UNUSED(value);
+
+	ATF_CHECK(counter < 5);
+	(*countp)++;
+}
+
+ATF_TC(nodelockcount);
+ATF_TC_HEAD(nodelockcount, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "test that a cache database gets the configured "
+			  "number of node locks, and purges the least "
+			  "recently used entries across them when over "
+			  "memory");
+}
+ATF_TC_BODY(nodelockcount, tc) {
+	dns_db_t *db = NULL;
+	isc_mem_t *dbmctx = NULL;
+	isc_stats_t *stats;
+	char *argv[1];
+	char name[64];
+	isc_stdtime_t now;
+	isc_result_t result;
+	unsigned int i, buckets = 0;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_mem_create(0, 0, &dbmctx);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_db_setnodelockcount(dns_dbtype_cache, 5);
+	argv[0] = (char *)dbmctx;
+	result = dns_db_create(dbmctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 1, argv, &db);
+	dns_db_setnodelockcount(dns_dbtype_cache, 0);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	stats = dns_db_getlockstats(db);
+	ATF_REQUIRE(stats != NULL);
+	isc_stats_dump(stats, countbuckets, &buckets, ISC_STATSDUMP_VERBOSE);
+	ATF_CHECK_EQ(buckets, 5);
+
+	/*
+	 * Twenty names, each used one second after the one before.
+	 */
+	isc_stdtime_get(&now);
+	for (i = 0; i < 20; i++) {
+		snprintf(name, sizeof(name), "name%u.example.", i);
+		addrdata(db, name, dns_rdatatype_a, "192.0.2.1", now + i);
+	}
+
+	/*
+	 * Over memory, every new name purges old ones; the oldest go
+	 * first, whichever bucket they are in.
+	 */
+	isc_mem_setwater(dbmctx, water, NULL, 1, 1);
+	for (i = 0; i < 5; i++) {
+		snprintf(name, sizeof(name), "new%u.example.", i);
+		addrdata(db, name, dns_rdatatype_a, "192.0.2.2", now + 100);
+	}
+	ATF_CHECK(findname(db, "name0.example.", now + 100,
+			   "name0.example.") != ISC_R_SUCCESS);
+	ATF_CHECK_EQ(findname(db, "name19.example.", now + 100,
+			      "name19.example."), ISC_R_SUCCESS);
+	isc_mem_setwater(dbmctx, NULL, NULL, 0, 0);
+
+	dns_db_detach(&db);
+	isc_mem_detach(&dbmctx);
+	dns_test_end();
+}
+
+/*
+ * Look 'qname' up in 'db' and check that the case of the owner name
+ * recorded with the A rdataset is 'expected'.
+ */
+static void
+checkcase(dns_db_t *db, dns_dbversion_t *version, const char *qname,
+	  isc_stdtime_t now, const char *expected)
+{
+	dns_fixedname_t fqname, ffound;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	char text[DNS_NAME_FORMATSIZE];
+	isc_result_t result;
+
+	dns_fixedname_init(&fqname);
+	dns_fixedname_init(&ffound);
+	result = dns_name_fromstring(dns_fixedname_name(&fqname), qname, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, dns_fixedname_name(&fqname), version,
+			     dns_rdatatype_a, 0, now, &node,
+			     dns_fixedname_name(&ffound), &rdataset, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_rdataset_getownercase(&rdataset, dns_fixedname_name(&ffound));
+	dns_name_format(dns_fixedname_name(&ffound), text, sizeof(text));
+	ATF_CHECK_STREQ(text, expected);
+	dns_rdataset_disassociate(&rdataset);
+	dns_db_detachnode(db, &node);
+}
+
+ATF_TC(ownercase);
+ATF_TC_HEAD(ownercase, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "test that the case of owner names is kept by "
+			  "cache and zone databases, and in map files");
+}
+ATF_TC_BODY(ownercase, tc) {
+	dns_db_t *db = NULL, *mapdb = NULL;
+	dns_dbversion_t *version = NULL;
+	dns_fixedname_t forigin;
+	isc_stdtime_t now;
+	isc_result_t result;
+	FILE *f;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	isc_stdtime_get(&now);
+
+	result = dns_db_create(mctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 0, NULL, &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	addrdata(db, "lower.example.", dns_rdatatype_a, "192.0.2.1", now);
+	addrdata(db, "MiXeD.example.", dns_rdatatype_a, "192.0.2.2", now);
+	checkcase(db, NULL, "LOWER.example.", now, "lower.example");
+	checkcase(db, NULL, "mixed.EXAMPLE.", now, "MiXeD.example");
+	dns_db_detach(&db);
+
+	f = fopen("ownercase.db", "w");
+	ATF_REQUIRE(f != NULL);
+	fprintf(f, "$TTL 3600\n"
+		   "@ SOA ns hostmaster 1 3600 1800 604800 3600\n"
+		   "@ NS ns\n"
+		   "ns A 192.0.2.1\n"
+		   "UPPER A 192.0.2.2\n"
+		   "MiXeD A 192.0.2.3\n");
+	fclose(f);
+
+	dns_fixedname_init(&forigin);
+	result = dns_name_fromstring(dns_fixedname_name(&forigin), "test.",
+				     0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_create(mctx, "rbt", dns_fixedname_name(&forigin),
+			       dns_dbtype_zone, dns_rdataclass_in, 0, NULL,
+			       &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_load(db, "ownercase.db");
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	checkcase(db, NULL, "upper.test.", 0, "UPPER.test");
+	checkcase(db, NULL, "mixed.test.", 0, "MiXeD.test");
+
+	dns_db_currentversion(db, &version);
+	result = dns_master_dump2(mctx, db, version,
+				  &dns_master_style_default, "ownercase.map",
+				  dns_masterformat_map);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_db_closeversion(db, &version, ISC_FALSE);
+
+	result = dns_db_create(mctx, "rbt", dns_fixedname_name(&forigin),
+			       dns_dbtype_zone, dns_rdataclass_in, 0, NULL,
+			       &mapdb);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_load2(mapdb, "ownercase.map", dns_masterformat_map);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	checkcase(mapdb, NULL, "ns.test.", 0, "ns.test");
+	checkcase(mapdb, NULL, "upper.test.", 0, "UPPER.test");
+	checkcase(mapdb, NULL, "mixed.test.", 0, "MiXeD.test");
+
+	dns_db_detach(&mapdb);
+	dns_db_detach(&db);
+	unlink("ownercase.db");
+	unlink("ownercase.map");
+	dns_test_end();
+}
+
+static isc_result_t
+findstale(dns_db_t *db, const char *qname, unsigned int options,
+	  isc_stdtime_t now, dns_ttl_t *ttlp, isc_boolean_t *stalep)
+{
+	dns_fixedname_t fqname, ffound;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	dns_fixedname_init(&fqname);
+	dns_fixedname_init(&ffound);
+	result = dns_name_fromstring(dns_fixedname_name(&fqname), qname, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, dns_fixedname_name(&fqname), NULL,
+			     dns_rdatatype_a, options, now, &node,
+			     dns_fixedname_name(&ffound), &rdataset, NULL);
+	if (result == ISC_R_SUCCESS) {
+		*ttlp = rdataset.ttl;
+		*stalep = ISC_TF((rdataset.attributes &
+				  DNS_RDATASETATTR_STALE) != 0);
+	}
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	return (result);
+}
+
+ATF_TC(servestale);
+ATF_TC_HEAD(servestale, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "expired cache data is found with DNS_DBFIND_STALEOK "
+			  "until the serve-stale window closes");
+}
+ATF_TC_BODY(servestale, tc) {
+	dns_db_t *db = NULL;
+	dns_ttl_t ttl = 0;
+	isc_boolean_t stale = ISC_FALSE;
+	isc_stdtime_t now;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	isc_stdtime_get(&now);
+
+	result = dns_db_create(mctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 0, NULL, &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Without a serve-stale window, expired data is gone.
+	 */
+	addrdata(db, "old.example.", dns_rdatatype_a, "192.0.2.1", now);
+	result = findstale(db, "old.example.", DNS_DBFIND_STALEOK,
+			   now + 3601, &ttl, &stale);
+	ATF_CHECK_EQ(result, ISC_R_NOTFOUND);
+
+	result = dns_db_setservestalettl(db, 3600);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_getservestalettl(db, &ttl);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(ttl, 3600);
+
+	addrdata(db, "stale.example.", dns_rdatatype_a, "192.0.2.2", now);
+	result = findstale(db, "stale.example.", 0, now + 10, &ttl,
+			   &stale);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(ttl, 3590);
+	ATF_CHECK(!stale);
+	result = findstale(db, "stale.example.", DNS_DBFIND_STALEOK,
+			   now + 10, &ttl, &stale);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(ttl, 3590);
+	ATF_CHECK(!stale);
+
+	/*
+	 * Expired: only a lookup asking for stale data finds it, with
+	 * what is left of the window as its TTL.
+	 */
+	result = findstale(db, "stale.example.", 0, now + 3700, &ttl,
+			   &stale);
+	ATF_CHECK_EQ(result, ISC_R_NOTFOUND);
+	result = findstale(db, "stale.example.", DNS_DBFIND_STALEOK,
+			   now + 3700, &ttl, &stale);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(ttl, 3500);
+	ATF_CHECK(stale);
+
+	/*
+	 * Past the window, it is gone for good.
+	 */
+	result = findstale(db, "stale.example.", DNS_DBFIND_STALEOK,
+			   now + 7300, &ttl, &stale);
+	ATF_CHECK_EQ(result, ISC_R_NOTFOUND);
+
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+ATF_TC(cleanbucket);
+ATF_TC_HEAD(cleanbucket, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "dns_db_cleanbucket() removes expired cache data "
+			  "one bucket at a time");
+}
+ATF_TC_BODY(cleanbucket, tc) {
+	dns_db_t *db = NULL;
+	char *argv[2];
+	char owner[64];
+	isc_stdtime_t now;
+	isc_result_t result;
+	unsigned int i, bucket, nbuckets, count, removed = 0;
+	unsigned int before;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	argv[0] = (char *)mctx;
+	argv[1] = sharded;
+	result = dns_db_create(mctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 2, argv, &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	nbuckets = dns_db_bucketcount(db);
+	ATF_REQUIRE(nbuckets > 1);
+
+	isc_stdtime_get(&now);
+
+	for (i = 0; i < 50; i++) {
+		snprintf(owner, sizeof(owner), "host%u.example.com.", i);
+		addrdata(db, owner, dns_rdatatype_a, "192.0.2.1", now);
+	}
+	addrdata(db, "fresh.example.org.", dns_rdatatype_a, "192.0.2.2",
+		 now + 3600);
+	before = dns_db_nodecount(db);
+
+	/*
+	 * Nothing has expired yet.
+	 */
+	for (bucket = 0; bucket < nbuckets; bucket++) {
+		count = 1000;
+		result = dns_db_cleanbucket(db, bucket, now, &count);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+		ATF_CHECK_EQ(count, 0);
+	}
+
+	/*
+	 * Remove one rdataset per call until each bucket is clean.  Data
+	 * is only removed RBTDB_VIRTUAL (300) seconds after it expires.
+	 */
+	for (bucket = 0; bucket < nbuckets; bucket++) {
+		do {
+			count = 1;
+			result = dns_db_cleanbucket(db, bucket, now + 4000,
+						    &count);
+			ATF_REQUIRE(result == ISC_R_SUCCESS ||
+				    result == DNS_R_CONTINUE);
+			removed += count;
+		} while (result == DNS_R_CONTINUE);
+	}
+	ATF_CHECK_EQ(removed, 50);
+	ATF_CHECK(dns_db_nodecount(db) < before);
+
+	count = 1;
+	result = dns_db_cleanbucket(db, nbuckets, now, &count);
+	ATF_CHECK_EQ(result, ISC_R_RANGE);
+
+	result = findname(db, "host0.example.com.", now + 4000,
+			  "host0.example.com.");
+	ATF_CHECK(result != ISC_R_SUCCESS);
+	result = findname(db, "fresh.example.org.", now + 4000,
+			  "fresh.example.org.");
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+ATF_TC(cachecleaner);
+ATF_TC_HEAD(cachecleaner, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "the cache cleaning units remove expired data "
+			  "in the background");
+}
+ATF_TC_BODY(cachecleaner, tc) {
+	dns_cache_t *cache = NULL;
+	dns_db_t *db = NULL;
+	char owner[64];
+	isc_stdtime_t now;
+	isc_result_t result;
+	unsigned int i, before;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_cache_create3(mctx, mctx, taskmgr, timermgr,
+				   dns_rdataclass_in, "test", "rbt", 0, NULL,
+				   &cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_cache_attachdb(cache, &db);
+
+	isc_stdtime_get(&now);
+	for (i = 0; i < 50; i++) {
+		snprintf(owner, sizeof(owner), "host%u.example.com.", i);
+		addrdata(db, owner, dns_rdatatype_a, "192.0.2.1", now - 4000);
+	}
+	before = dns_db_nodecount(db);
+
+	for (i = 0; i < 50 && dns_db_nodecount(db) >= before; i++)
+		dns_test_nap(100000);
+	ATF_CHECK(dns_db_nodecount(db) < before);
+
+	dns_db_detach(&db);
+	dns_cache_detach(&cache);
+	dns_test_end();
+}
+
+static void
+checktrust(dns_db_t *db, const char *qname, isc_stdtime_t now,
+	   dns_trust_t trust)
+{
+	dns_fixedname_t fqname, ffound;
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	dns_fixedname_init(&fqname);
+	dns_fixedname_init(&ffound);
+	result = dns_name_fromstring(dns_fixedname_name(&fqname), qname, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, dns_fixedname_name(&fqname), NULL,
+			     dns_rdatatype_a, 0, now, &node,
+			     dns_fixedname_name(&ffound), &rdataset, NULL);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	if (result == ISC_R_SUCCESS) {
+		ATF_CHECK_EQ(rdataset.trust, trust);
+		/* The TTL goes on counting down from the dump. */
+		ATF_CHECK(rdataset.ttl <= 3600 && rdataset.ttl > 3500);
+	}
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+}
+
+typedef struct {
+	isc_statscounter_t counter;
+	isc_uint64_t value;
+} getcounter_t;
+
+static void
+getcounter_cb(isc_statscounter_t counter, isc_uint64_t value, void *arg) {
+	getcounter_t *gc = arg;
+
+	if (counter == gc->counter)
+		gc->value = value;
+}
+
+static isc_uint64_t
+getcounter(isc_stats_t *stats, isc_statscounter_t counter) {
+	getcounter_t gc;
+
+	gc.counter = counter;
+	gc.value = 0;
+	isc_stats_dump(stats, getcounter_cb, &gc, ISC_STATSDUMP_VERBOSE);
+	return (gc.value);
+}
+
+ATF_TC(segmentedlru);
+ATF_TC_HEAD(segmentedlru, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "cache data found again after a delay is promoted "
+			  "to the hot LRU segment");
+}
+ATF_TC_BODY(segmentedlru, tc) {
+	dns_db_t *db = NULL;
+	isc_stats_t *stats = NULL;
+	isc_stdtime_t now;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_db_create(mctx, "rbt", dns_rootname, dns_dbtype_cache,
+			       dns_rdataclass_in, 0, NULL, &db);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_stats_create(mctx, &stats, dns_cachestatscounter_max);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_setcachestats(db, stats);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	isc_stdtime_get(&now);
+
+	addrdata(db, "popular.example.", dns_rdatatype_a, "192.0.2.1", now);
+
+	/*
+	 * Lookups straight after the data was added (as in a single
+	 * resolution) leave it in the cold segment.
+	 */
+	result = findname(db, "popular.example.", now, "popular.example.");
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	result = findname(db, "popular.example.", now + 1,
+			  "popular.example.");
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(getcounter(stats, dns_cachestatscounter_promotelru), 0);
+	ATF_CHECK_EQ(getcounter(stats, dns_cachestatscounter_hothits), 0);
+
+	/*
+	 * A later hit promotes it, and hits after that are counted as
+	 * hot.
+	 */
+	result = findname(db, "popular.example.", now + 10,
+			  "popular.example.");
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(getcounter(stats, dns_cachestatscounter_promotelru), 1);
+	result = findname(db, "popular.example.", now + 20,
+			  "popular.example.");
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(getcounter(stats, dns_cachestatscounter_promotelru), 1);
+	ATF_CHECK(getcounter(stats, dns_cachestatscounter_hothits) >= 1);
+
+	isc_stats_detach(&stats);
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+ATF_TC(cachesnapshot);
+ATF_TC_HEAD(cachesnapshot, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "a cache saved by dns_cache_dump() is loaded back "
+			  "with its trust levels by dns_cache_load()");
+}
+ATF_TC_BODY(cachesnapshot, tc) {
+	dns_cache_t *cache = NULL;
+	dns_db_t *db = NULL;
+	isc_stdtime_t now;
+	isc_result_t result;
+	FILE *f;
+	int c;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	unlink("cache.snapshot");
+	isc_stdtime_get(&now);
+
+	result = dns_cache_create3(mctx, mctx, taskmgr, timermgr,
+				   dns_rdataclass_in, "test", "rbt", 0, NULL,
+				   &cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_cache_setfilename(cache, "cache.snapshot");
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * No snapshot yet: nothing is loaded.
+	 */
+	result = dns_cache_load(cache);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+
+	dns_cache_attachdb(cache, &db);
+	addrdatatrust(db, "secure.example.", dns_rdatatype_a, "192.0.2.1",
+		      dns_trust_secure, now);
+	addrdata(db, "answer.example.", dns_rdatatype_a, "192.0.2.2", now);
+	addrdata(db, "www.sub.answer.example.", dns_rdatatype_a,
+		 "192.0.2.3", now);
+	dns_db_detach(&db);
+
+	result = dns_cache_dump(cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_cache_detach(&cache);
+
+	result = dns_cache_create3(mctx, mctx, taskmgr, timermgr,
+				   dns_rdataclass_in, "test", "rbt", 0, NULL,
+				   &cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_cache_setfilename(cache, "cache.snapshot");
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_cache_load(cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_cache_attachdb(cache, &db);
+	checktrust(db, "secure.example.", now, dns_trust_secure);
+	checktrust(db, "answer.example.", now, dns_trust_answer);
+	checktrust(db, "www.sub.answer.example.", now, dns_trust_answer);
+	dns_db_detach(&db);
+	dns_cache_detach(&cache);
+
+	/*
+	 * A damaged snapshot is refused.
+	 */
+	f = fopen("cache.snapshot", "r+b");
+	ATF_REQUIRE(f != NULL);
+	ATF_REQUIRE(fseek(f, -1, SEEK_END) == 0);
+	c = fgetc(f);
+	ATF_REQUIRE(fseek(f, -1, SEEK_END) == 0);
+	fputc(c ^ 0xff, f);
+	fclose(f);
+
+	result = dns_cache_create3(mctx, mctx, taskmgr, timermgr,
+				   dns_rdataclass_in, "test", "rbt", 0, NULL,
+				   &cache);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_cache_setfilename(cache, "cache.snapshot");
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_cache_load(cache);
+	ATF_CHECK_EQ(result, ISC_R_INVALIDFILE);
+	dns_cache_detach(&cache);
+
+	unlink("cache.snapshot");
+	dns_test_end();
+}
+
 /*
  * Main
  */
 ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, getoriginnode);
+	ATF_TP_ADD_TC(tp, shardedcache);
+	ATF_TP_ADD_TC(tp, nodelockcount);
+	ATF_TP_ADD_TC(tp, ownercase);
+	ATF_TP_ADD_TC(tp, servestale);
+	ATF_TP_ADD_TC(tp, cleanbucket);
+	ATF_TP_ADD_TC(tp, cachecleaner);
+	ATF_TP_ADD_TC(tp, cachesnapshot);
+	ATF_TP_ADD_TC(tp, segmentedlru);
 	return (atf_no_error());
 }
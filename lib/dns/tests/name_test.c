@@ -277,6 +277,117 @@ ATF_TC_BODY(compression, tc) {
 	dns_test_end();
 }
 
+/*
+ * Render 'text' into 'target' and check that exactly 'length' bytes of
+ * 'expected' were added.
+ */
+static void
+towire_check(const char *text, dns_compress_t *cctx, isc_buffer_t *target,
+	     const unsigned char *expected, unsigned int length)
+{
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	unsigned int used = target->used;
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	ATF_REQUIRE_EQ(dns_name_fromstring(name, text, 0, NULL),
+		       ISC_R_SUCCESS);
+	ATF_REQUIRE_EQ(dns_name_towire(name, cctx, target), ISC_R_SUCCESS);
+	ATF_CHECK_EQ_MSG(target->used - used, length, "%s", text);
+	ATF_CHECK_MSG(memcmp((unsigned char *)target->base + used,
+			     expected, length) == 0, "%s", text);
+}
+
+ATF_TC(compressedwire);
+ATF_TC_HEAD(compressedwire, tc) {
+	atf_tc_set_md_var(tc, "descr", "compression pointers, case "
+			  "sensitivity and rollback");
+}
+ATF_TC_BODY(compressedwire, tc) {
+	dns_compress_t cctx;
+	isc_buffer_t target;
+	unsigned char buf[1024];
+	isc_uint16_t offset;
+
+	UNUSED(tc);
+
+	ATF_REQUIRE_EQ(dns_test_begin(NULL, ISC_FALSE), ISC_R_SUCCESS);
+
+	/*
+	 * Names start after a 12 byte header, as in a message.
+	 */
+	ATF_REQUIRE_EQ(dns_compress_init(&cctx, -1, mctx), ISC_R_SUCCESS);
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+	isc_buffer_init(&target, buf, sizeof(buf));
+	isc_buffer_add(&target, 12);
+
+	/* www at 12, example at 16, com at 24 */
+	towire_check("www.example.com.", &cctx, &target,
+		     (const unsigned char *)"\003www\007example\003com", 17);
+	/* mail at 29 */
+	towire_check("mail.example.com.", &cctx, &target,
+		     (const unsigned char *)"\004mail\300\020", 7);
+	towire_check("EXAMPLE.com.", &cctx, &target,
+		     (const unsigned char *)"\300\020", 2);
+	towire_check("a.mail.example.com.", &cctx, &target,
+		     (const unsigned char *)"\001a\300\035", 4);
+	towire_check("www.example.com.", &cctx, &target,
+		     (const unsigned char *)"\300\014", 2);
+
+	/*
+	 * Names that are rolled back are no longer compression targets;
+	 * the ones before them still are.
+	 */
+	offset = target.used;
+	towire_check("host.example.net.", &cctx, &target,
+		     (const unsigned char *)"\004host\007example\003net", 18);
+	dns_compress_rollback(&cctx, offset);
+	target.used = offset;
+	towire_check("example.net.", &cctx, &target,
+		     (const unsigned char *)"\007example\003net", 13);
+	towire_check("com.", &cctx, &target,
+		     (const unsigned char *)"\300\030", 2);
+
+	/*
+	 * Names that may not be compressed are still compression
+	 * targets.
+	 */
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_NONE);
+	offset = target.used;
+	towire_check("srv.example.org.", &cctx, &target,
+		     (const unsigned char *)"\003srv\007example\003org", 17);
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+	buf[0] = 0xc0 | (offset >> 8);
+	buf[1] = offset & 0xff;
+	towire_check("srv.example.org.", &cctx, &target, buf, 2);
+
+	dns_compress_invalidate(&cctx);
+
+	/*
+	 * With case sensitive compression, only a suffix in the same
+	 * case is used.
+	 */
+	ATF_REQUIRE_EQ(dns_compress_init(&cctx, -1, mctx), ISC_R_SUCCESS);
+	dns_compress_setmethods(&cctx, DNS_COMPRESS_GLOBAL14);
+	dns_compress_setsensitive(&cctx, ISC_TRUE);
+	isc_buffer_init(&target, buf + 2, sizeof(buf) - 2);
+	isc_buffer_add(&target, 12);
+
+	towire_check("www.example.com.", &cctx, &target,
+		     (const unsigned char *)"\003www\007example\003com", 17);
+	towire_check("www.EXAMPLE.com.", &cctx, &target,
+		     (const unsigned char *)"\003www\007EXAMPLE\300\030", 14);
+	towire_check("www.EXAMPLE.com.", &cctx, &target,
+		     (const unsigned char *)"\300\035", 2);
+	towire_check("www.example.com.", &cctx, &target,
+		     (const unsigned char *)"\300\014", 2);
+
+	dns_compress_invalidate(&cctx);
+
+	dns_test_end();
+}
+
 ATF_TC(istat);
 ATF_TC_HEAD(istat, tc) {
 	atf_tc_set_md_var(tc, "descr", "is trust-anchor-telementry test");
@@ -429,6 +540,7 @@ ATF_TC_BODY(benchmark, tc) {
 ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, fullcompare);
 	ATF_TP_ADD_TC(tp, compression);
+	ATF_TP_ADD_TC(tp, compressedwire);
 	ATF_TP_ADD_TC(tp, istat);
 #ifdef ISC_PLATFORM_USETHREADS
 #ifdef DNS_BENCHMARK_TESTS
@@ -0,0 +1,605 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*! \file */
+
+#include <config.h>
+
+#include <atf-c.h>
+
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <isc/print.h>
+#include <isc/stdtime.h>
+#include <isc/string.h>
+
+#include <dns/db.h>
+#include <dns/dbiterator.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdatalist.h>
+#include <dns/rdataset.h>
+#include <dns/rdatasetiter.h>
+#include <dns/rdatatype.h>
+#include <dns/result.h>
+
+#include "dnstest.h"
+
+/*
+ * Helper functions
+ */
+
+#define	BUFLEN		255
+#define	TEST_ORIGIN	"test"
+#define	MAXNAMES	256
+
+static void
+loaddb(const char *impl, dns_dbtype_t dbtype, const char *file,
+       dns_db_t **dbp)
+{
+	dns_fixedname_t fixed;
+	isc_result_t result;
+
+	dns_fixedname_init(&fixed);
+	result = dns_name_fromstring(dns_fixedname_name(&fixed), TEST_ORIGIN,
+				     0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_db_create(mctx, impl, dns_fixedname_name(&fixed),
+			       dbtype, dns_rdataclass_in, 0, NULL, dbp);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	if (file != NULL) {
+		result = dns_db_load(*dbp, file);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	}
+}
+
+static void
+addrdata(dns_db_t *db, dns_dbversion_t *version, const char *owner,
+	 dns_rdatatype_t type, dns_ttl_t ttl, const char *text,
+	 isc_stdtime_t now)
+{
+	unsigned char buf[BUFLEN];
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdatalist_t rdatalist;
+	dns_rdataset_t rdataset;
+	dns_fixedname_t fixed;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	result = dns_test_rdata_fromstring(&rdata, dns_rdataclass_in, type,
+					   buf, sizeof(buf), text);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_rdatalist_init(&rdatalist);
+	rdatalist.rdclass = dns_rdataclass_in;
+	rdatalist.type = type;
+	rdatalist.ttl = ttl;
+	ISC_LIST_APPEND(rdatalist.rdata, &rdata, link);
+	dns_rdataset_init(&rdataset);
+	result = dns_rdatalist_tordataset(&rdatalist, &rdataset);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	rdataset.trust = dns_trust_answer;
+
+	dns_fixedname_init(&fixed);
+	result = dns_name_fromstring(dns_fixedname_name(&fixed), owner, 0,
+				     NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_db_findnode(db, dns_fixedname_name(&fixed), ISC_TRUE,
+				 &node);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_db_addrdataset(db, node, version, now, &rdataset, 0,
+				    NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_db_detachnode(db, &node);
+	dns_rdataset_disassociate(&rdataset);
+}
+
+/*
+ * Describe the outcome of a lookup so that the "rbt" and "qp"
+ * implementations can be compared with a string comparison.
+ */
+static void
+describe(char *buf, size_t size, isc_result_t result, dns_name_t *found,
+	 dns_rdataset_t *rdataset, dns_rdataset_t *sigrdataset)
+{
+	char namebuf[DNS_NAME_FORMATSIZE];
+	char typebuf[DNS_RDATATYPE_FORMATSIZE];
+
+	namebuf[0] = '\0';
+	if (found != NULL && result != ISC_R_NOTFOUND &&
+	    result != DNS_R_NXDOMAIN && result != DNS_R_NXRRSET)
+		dns_name_format(found, namebuf, sizeof(namebuf));
+	typebuf[0] = '\0';
+	if (rdataset != NULL && dns_rdataset_isassociated(rdataset))
+		dns_rdatatype_format(rdataset->type, typebuf,
+				     sizeof(typebuf));
+	snprintf(buf, size, "%s %s %s/%u %s", isc_result_totext(result),
+		 namebuf, typebuf,
+		 (rdataset != NULL && dns_rdataset_isassociated(rdataset)) ?
+		 dns_rdataset_count(rdataset) : 0,
+		 (sigrdataset != NULL &&
+		  dns_rdataset_isassociated(sigrdataset)) ? "signed" : "-");
+}
+
+static void
+find(dns_db_t *db, dns_name_t *name, dns_rdatatype_t type,
+     unsigned int options, char *buf, size_t size)
+{
+	dns_fixedname_t ffound;
+	dns_rdataset_t rdataset, sigrdataset;
+	dns_dbversion_t *version = NULL;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	dns_fixedname_init(&ffound);
+	dns_rdataset_init(&rdataset);
+	dns_rdataset_init(&sigrdataset);
+	if (dns_db_iszone(db))
+		dns_db_currentversion(db, &version);
+	result = dns_db_find(db, name, version, type, options, 0, &node,
+			     dns_fixedname_name(&ffound), &rdataset,
+			     &sigrdataset);
+	describe(buf, size, result, dns_fixedname_name(&ffound), &rdataset,
+		 &sigrdataset);
+	if (node != NULL)
+		dns_db_detachnode(db, &node);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	if (dns_rdataset_isassociated(&sigrdataset))
+		dns_rdataset_disassociate(&sigrdataset);
+	if (version != NULL)
+		dns_db_closeversion(db, &version, ISC_FALSE);
+}
+
+static void
+findzonecut(dns_db_t *db, dns_name_t *name, unsigned int options,
+	    char *buf, size_t size)
+{
+	dns_fixedname_t ffound;
+	dns_rdataset_t rdataset, sigrdataset;
+	isc_result_t result;
+
+	dns_fixedname_init(&ffound);
+	dns_rdataset_init(&rdataset);
+	dns_rdataset_init(&sigrdataset);
+	result = dns_db_findzonecut(db, name, options, 0, NULL,
+				    dns_fixedname_name(&ffound), &rdataset,
+				    &sigrdataset);
+	describe(buf, size, result, dns_fixedname_name(&ffound), &rdataset,
+		 &sigrdataset);
+	if (dns_rdataset_isassociated(&rdataset))
+		dns_rdataset_disassociate(&rdataset);
+	if (dns_rdataset_isassociated(&sigrdataset))
+		dns_rdataset_disassociate(&sigrdataset);
+}
+
+static void
+seek(dns_db_t *db, dns_name_t *name, char *buf, size_t size) {
+	dns_fixedname_t fixed;
+	dns_dbiterator_t *iter = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_name_t *current;
+	char namebuf[DNS_NAME_FORMATSIZE];
+	isc_result_t result;
+	size_t len;
+
+	dns_fixedname_init(&fixed);
+	current = dns_fixedname_name(&fixed);
+
+	result = dns_db_createiterator(db, 0, &iter);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_dbiterator_seek(iter, name);
+	snprintf(buf, size, "%s", isc_result_totext(result));
+	if (result == ISC_R_SUCCESS || result == DNS_R_PARTIALMATCH) {
+		result = dns_dbiterator_current(iter, &node, current);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		dns_name_format(current, namebuf, sizeof(namebuf));
+		len = strlen(buf);
+		snprintf(buf + len, size - len, " %s", namebuf);
+
+		result = dns_dbiterator_next(iter);
+		if (result == ISC_R_SUCCESS) {
+			result = dns_dbiterator_current(iter, &node, current);
+			ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+			dns_db_detachnode(db, &node);
+			dns_name_format(current, namebuf, sizeof(namebuf));
+		} else
+			strlcpy(namebuf, isc_result_totext(result),
+				sizeof(namebuf));
+		len = strlen(buf);
+		snprintf(buf + len, size - len, " %s", namebuf);
+	}
+	dns_dbiterator_destroy(&iter);
+}
+
+/*
+ * Walk 'db' forward, and then backward, with an iterator created with
+ * 'options', checking that both walks give the names in 'names' in
+ * that order; if 'names' is empty, fill it with at most 'size' names.
+ */
+static void
+walk(dns_db_t *db, unsigned int options, dns_name_t *names,
+     unsigned int size, unsigned int *countp)
+{
+	dns_fixedname_t fixed;
+	dns_dbiterator_t *iter = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_name_t *name;
+	isc_result_t result;
+	unsigned int i = 0;
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+
+	result = dns_db_createiterator(db, options, &iter);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (result = dns_dbiterator_first(iter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_next(iter))
+	{
+		result = dns_dbiterator_current(iter, &node, name);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		ATF_REQUIRE(i < size);
+		if (i >= *countp) {
+			dns_name_init(&names[i], NULL);
+			result = dns_name_dup(name, mctx, &names[i]);
+			ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		} else
+			ATF_CHECK(dns_name_equal(name, &names[i]));
+		i++;
+	}
+	ATF_CHECK_EQ(result, ISC_R_NOMORE);
+	if (*countp == 0)
+		*countp = i;
+	ATF_CHECK_EQ(i, *countp);
+
+	for (result = dns_dbiterator_last(iter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_prev(iter))
+	{
+		result = dns_dbiterator_current(iter, &node, name);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+		ATF_REQUIRE(i > 0);
+		ATF_CHECK(dns_name_equal(name, &names[--i]));
+	}
+	ATF_CHECK_EQ(result, ISC_R_NOMORE);
+	ATF_CHECK_EQ(i, 0);
+
+	dns_dbiterator_destroy(&iter);
+}
+
+static const char *prefixes[] = { NULL, "x", "*", "0", "zz", "a.b" };
+
+static const dns_rdatatype_t types[] = {
+	dns_rdatatype_a, dns_rdatatype_ns, dns_rdatatype_txt,
+	dns_rdatatype_cname, dns_rdatatype_dname, dns_rdatatype_nsec,
+	dns_rdatatype_any
+};
+
+/*
+ * Load 'file' into an "rbt" and a "qp" database of type 'dbtype' and
+ * check that every name is found the same way in both.  The names
+ * looked up are those in the zone and names one label below them;
+ * 'options' are tried in turn with every name and type.
+ */
+static void
+compare(const char *file, dns_dbtype_t dbtype, const unsigned int *options,
+	unsigned int noptions)
+{
+	dns_db_t *rbtdb = NULL, *qpdb = NULL;
+	dns_name_t *names;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	char expected[1024], got[1024];
+	char namebuf[DNS_NAME_FORMATSIZE];
+	char typebuf[DNS_RDATATYPE_FORMATSIZE];
+	unsigned int count = 0, nsec3count = 0, i, j, o, t;
+	isc_result_t result;
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	loaddb("rbt", dbtype, file, &rbtdb);
+	loaddb("qp", dbtype, file, &qpdb);
+
+	ATF_CHECK_EQ(dns_db_nodecount(rbtdb), dns_db_nodecount(qpdb));
+	if (dbtype == dns_dbtype_zone)
+		ATF_CHECK_EQ(dns_db_issecure(rbtdb), dns_db_issecure(qpdb));
+
+	names = isc_mem_get(mctx, MAXNAMES * sizeof(*names));
+	ATF_REQUIRE(names != NULL);
+	walk(rbtdb, DNS_DB_NONSEC3, names, MAXNAMES, &count);
+	ATF_REQUIRE(count > 0);
+	walk(qpdb, DNS_DB_NONSEC3, names, MAXNAMES, &count);
+	if (dbtype == dns_dbtype_zone) {
+		walk(rbtdb, DNS_DB_NSEC3ONLY, names + count,
+		     MAXNAMES - count, &nsec3count);
+		walk(qpdb, DNS_DB_NSEC3ONLY, names + count,
+		     MAXNAMES - count, &nsec3count);
+		count += nsec3count;
+	}
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < sizeof(prefixes) / sizeof(prefixes[0]); j++) {
+			if (prefixes[j] == NULL)
+				dns_name_copy(&names[i], name, NULL);
+			else {
+				result = dns_name_fromstring2(name,
+							      prefixes[j],
+							      &names[i], 0,
+							      NULL);
+				ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+			}
+			dns_name_format(name, namebuf, sizeof(namebuf));
+
+			for (o = 0; o < noptions; o++) {
+				for (t = 0;
+				     t < sizeof(types) / sizeof(types[0]);
+				     t++)
+				{
+					find(rbtdb, name, types[t], options[o],
+					     expected, sizeof(expected));
+					find(qpdb, name, types[t], options[o],
+					     got, sizeof(got));
+					dns_rdatatype_format(types[t], typebuf,
+							     sizeof(typebuf));
+					ATF_CHECK_STREQ_MSG(expected, got,
+							    "find %s/%s "
+							    "options %#x",
+							    namebuf, typebuf,
+							    options[o]);
+				}
+				if (dbtype != dns_dbtype_cache)
+					continue;
+				findzonecut(rbtdb, name, options[o],
+					    expected, sizeof(expected));
+				findzonecut(qpdb, name, options[o],
+					    got, sizeof(got));
+				ATF_CHECK_STREQ_MSG(expected, got,
+						    "findzonecut %s options %#x",
+						    namebuf, options[o]);
+			}
+
+			seek(rbtdb, name, expected, sizeof(expected));
+			seek(qpdb, name, got, sizeof(got));
+			ATF_CHECK_STREQ_MSG(expected, got, "seek %s", namebuf);
+		}
+	}
+
+	for (i = 0; i < count; i++)
+		dns_name_free(&names[i], mctx);
+	isc_mem_put(mctx, names, MAXNAMES * sizeof(*names));
+
+	dns_db_detach(&rbtdb);
+	dns_db_detach(&qpdb);
+	dns_test_end();
+}
+
+/*
+ * Individual unit tests
+ */
+
+ATF_TC(zone);
+ATF_TC_HEAD(zone, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "lookups and iteration in a \"qp\" zone database "
+			  "give the same results as in an \"rbt\" one");
+}
+ATF_TC_BODY(zone, tc) {
+	static const unsigned int options[] = {
+		0, DNS_DBFIND_GLUEOK, DNS_DBFIND_NOWILD,
+		DNS_DBFIND_PENDINGOK | DNS_DBFIND_NOEXACT
+	};
+
+	UNUSED(tc);
+
+	compare("testdata/qpdb/zone1.data", dns_dbtype_zone, options,
+		sizeof(options) / sizeof(options[0]));
+}
+
+ATF_TC(zone_nsec3);
+ATF_TC_HEAD(zone_nsec3, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "lookups and iteration in a \"qp\" zone database "
+			  "give the same results as in an \"rbt\" one "
+			  "(NSEC3)");
+}
+ATF_TC_BODY(zone_nsec3, tc) {
+	static const unsigned int options[] = {
+		0, DNS_DBFIND_FORCENSEC3
+	};
+
+	UNUSED(tc);
+
+	compare("testdata/dbiterator/zone2.data", dns_dbtype_zone, options,
+		sizeof(options) / sizeof(options[0]));
+}
+
+ATF_TC(cache);
+ATF_TC_HEAD(cache, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "lookups and iteration in a \"qp\" cache database "
+			  "give the same results as in an \"rbt\" one");
+}
+ATF_TC_BODY(cache, tc) {
+	static const unsigned int options[] = {
+		0, DNS_DBFIND_NOEXACT
+	};
+
+	UNUSED(tc);
+
+	compare("testdata/qpdb/zone1.data", dns_dbtype_cache, options,
+		sizeof(options) / sizeof(options[0]));
+}
+
+ATF_TC(versions);
+ATF_TC_HEAD(versions, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "changes to a \"qp\" zone database are only seen "
+			  "in the versions they were committed to");
+}
+ATF_TC_BODY(versions, tc) {
+	dns_db_t *db = NULL;
+	dns_dbversion_t *v1 = NULL, *v2 = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_rdataset_t rdataset;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	char buf[1024];
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	loaddb("qp", dns_dbtype_zone, "testdata/qpdb/zone1.data", &db);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	result = dns_name_fromstring(name, "new.test.", 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * An abandoned change leaves nothing behind.
+	 */
+	result = dns_db_newversion(db, &v1);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	addrdata(db, v1, "new.test.", dns_rdatatype_a, 600, "10.0.0.4", 0);
+	dns_db_closeversion(db, &v1, ISC_FALSE);
+	find(db, name, dns_rdatatype_a, 0, buf, sizeof(buf));
+	ATF_CHECK_STREQ(buf, "NXDOMAIN  NSEC/1 signed");
+
+	/*
+	 * A committed change is not seen by an older version.
+	 */
+	dns_db_currentversion(db, &v1);
+	result = dns_db_newversion(db, &v2);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	addrdata(db, v2, "new.test.", dns_rdatatype_a, 600, "10.0.0.4", 0);
+	dns_db_closeversion(db, &v2, ISC_TRUE);
+	find(db, name, dns_rdatatype_a, 0, buf, sizeof(buf));
+	ATF_CHECK_STREQ(buf, "success new.test A/1 -");
+
+	result = dns_db_findnode(db, name, ISC_FALSE, &node);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_rdataset_init(&rdataset);
+	result = dns_db_findrdataset(db, node, v1, dns_rdatatype_a, 0, 0,
+				     &rdataset, NULL);
+	ATF_CHECK_EQ(result, ISC_R_NOTFOUND);
+	result = dns_db_findrdataset(db, node, NULL, dns_rdatatype_a, 0, 0,
+				     &rdataset, NULL);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	dns_rdataset_disassociate(&rdataset);
+	dns_db_detachnode(db, &node);
+	dns_db_closeversion(db, &v1, ISC_FALSE);
+
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+static isc_result_t
+findat(dns_db_t *db, dns_name_t *name, isc_stdtime_t now) {
+	dns_fixedname_t ffound;
+
+	dns_fixedname_init(&ffound);
+	return (dns_db_find(db, name, NULL, dns_rdatatype_a, 0, now, NULL,
+			    dns_fixedname_name(&ffound), NULL, NULL));
+}
+
+ATF_TC(expire);
+ATF_TC_HEAD(expire, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "expired data in a \"qp\" cache database is not "
+			  "found, and cleaning it empties the database");
+}
+ATF_TC_BODY(expire, tc) {
+	dns_db_t *db = NULL;
+	dns_dbiterator_t *iter = NULL;
+	dns_dbnode_t *node = NULL;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	isc_stdtime_t now;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	loaddb("qp", dns_dbtype_cache, NULL, &db);
+
+	isc_stdtime_get(&now);
+	addrdata(db, NULL, "a.example.", dns_rdatatype_a, 60, "10.0.0.1",
+		 now);
+	addrdata(db, NULL, "b.example.", dns_rdatatype_a, 3600, "10.0.0.2",
+		 now);
+	ATF_CHECK_EQ(dns_db_nodecount(db), 2);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+	result = dns_name_fromstring(name, "a.example.", 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	ATF_CHECK_EQ(findat(db, name, now + 30), ISC_R_SUCCESS);
+	ATF_CHECK_EQ(findat(db, name, now + 120), ISC_R_NOTFOUND);
+
+	/*
+	 * Cleaning walks the whole database, expiring what it finds
+	 * stale, the same way the cache cleaner does.  Data is only
+	 * expired some time after its TTL has run out.
+	 */
+	result = dns_db_createiterator(db, 0, &iter);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_dbiterator_setcleanmode(iter, ISC_TRUE);
+	for (result = dns_dbiterator_first(iter);
+	     result == ISC_R_SUCCESS;
+	     result = dns_dbiterator_next(iter))
+	{
+		result = dns_dbiterator_current(iter, &node, NULL);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		result = dns_db_expirenode(db, node, now + 600);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+		dns_db_detachnode(db, &node);
+	}
+	ATF_CHECK_EQ(result, ISC_R_NOMORE);
+	dns_dbiterator_destroy(&iter);
+
+	ATF_CHECK_EQ(dns_db_nodecount(db), 1);
+
+	result = dns_name_fromstring(name, "b.example.", 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(findat(db, name, now + 120), ISC_R_SUCCESS);
+
+	dns_db_detach(&db);
+	dns_test_end();
+}
+
+/*
+ * Main
+ */
+ATF_TP_ADD_TCS(tp) {
+	ATF_TP_ADD_TC(tp, zone);
+	ATF_TP_ADD_TC(tp, zone_nsec3);
+	ATF_TP_ADD_TC(tp, cache);
+	ATF_TP_ADD_TC(tp, versions);
+	ATF_TP_ADD_TC(tp, expire);
+	return (atf_no_error());
+}
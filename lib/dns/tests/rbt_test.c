@@ -1078,6 +1078,80 @@ ATF_TC_BODY(rbt_insert_and_remove, tc) {
 	dns_test_end();
 }
 
+static void
+hashname(dns_name_t *name, unsigned int i) {
+	char namebuf[DNS_NAME_FORMATSIZE];
+	isc_buffer_t b;
+	isc_result_t result;
+
+	snprintf(namebuf, sizeof(namebuf), "n%u.example", i);
+	isc_buffer_constinit(&b, namebuf, strlen(namebuf));
+	isc_buffer_add(&b, strlen(namebuf));
+	result = dns_name_fromtext(name, &b, dns_rootname, 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+}
+
+ATF_TC(rbt_hash_grow);
+ATF_TC_HEAD(rbt_hash_grow, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "Names stay reachable while the name hash grows "
+			  "and its entries are being moved");
+}
+ATF_TC_BODY(rbt_hash_grow, tc) {
+	dns_rbt_t *rbt = NULL;
+	dns_rbtnode_t *node;
+	dns_fixedname_t fixed;
+	dns_name_t *name;
+	isc_result_t result;
+	unsigned int i;
+	const unsigned int count = 20000;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_rbt_create(mctx, NULL, NULL, &rbt);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	dns_fixedname_init(&fixed);
+	name = dns_fixedname_name(&fixed);
+
+	/*
+	 * Add names, deleting every third one shortly afterwards, so
+	 * that deletions happen from both the old and the new tables
+	 * while the hash is growing.
+	 */
+	for (i = 0; i < count; i++) {
+		hashname(name, i);
+		node = NULL;
+		result = dns_rbt_addnode(rbt, name, &node);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		node->data = rbt;
+		if (i >= 10 && (i - 10) % 3 == 0) {
+			hashname(name, i - 10);
+			result = dns_rbt_deletename(rbt, name, ISC_FALSE);
+			ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		}
+	}
+	ATF_CHECK(dns_rbt_hashsize(rbt) > count);
+
+	for (i = 0; i < count + 100; i++) {
+		hashname(name, i);
+		node = NULL;
+		result = dns_rbt_findnode(rbt, name, NULL, &node, NULL,
+					  DNS_RBTFIND_EMPTYDATA, NULL, NULL);
+		if (i >= count || (i + 10 < count && i % 3 == 0))
+			ATF_CHECK_EQ(result, DNS_R_PARTIALMATCH);
+		else
+			ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	}
+
+	dns_rbt_destroy(&rbt);
+
+	dns_test_end();
+}
+
 #ifdef ISC_PLATFORM_USETHREADS
 #ifdef DNS_BENCHMARK_TESTS
 
@@ -1220,6 +1294,7 @@ ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, rbt_insert);
 	ATF_TP_ADD_TC(tp, rbt_remove);
 	ATF_TP_ADD_TC(tp, rbt_insert_and_remove);
+	ATF_TP_ADD_TC(tp, rbt_hash_grow);
 #ifdef ISC_PLATFORM_USETHREADS
 #ifdef DNS_BENCHMARK_TESTS
 	ATF_TP_ADD_TC(tp, benchmark);
@@ -16,11 +16,90 @@
 
 #include <unistd.h>
 
+#include <isc/buffer.h>
+#include <isc/string.h>
+
+#include <dns/compress.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdatalist.h>
 #include <dns/rdataset.h>
 #include <dns/rdatastruct.h>
 
 #include "dnstest.h"
 
+/*
+ * Helper functions
+ */
+
+#define MAXRDATA	4
+
+typedef struct {
+	dns_rdatalist_t		rdatalist;
+	dns_rdataset_t		rdataset;
+	dns_rdata_t		rdata[MAXRDATA];
+	unsigned char		data[MAXRDATA][512];
+} testset_t;
+
+static void
+makeset(testset_t *set, dns_rdatatype_t type, const char **text) {
+	isc_result_t result;
+	unsigned int i;
+
+	dns_rdatalist_init(&set->rdatalist);
+	set->rdatalist.rdclass = dns_rdataclass_in;
+	set->rdatalist.type = type;
+	set->rdatalist.ttl = 300;
+	if (type == dns_rdatatype_rrsig)
+		set->rdatalist.covers = dns_rdatatype_a;
+	for (i = 0; text[i] != NULL; i++) {
+		ATF_REQUIRE(i < MAXRDATA);
+		dns_rdata_init(&set->rdata[i]);
+		result = dns_test_rdata_fromstring(&set->rdata[i],
+						   dns_rdataclass_in, type,
+						   set->data[i],
+						   sizeof(set->data[i]),
+						   text[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		ISC_LIST_APPEND(set->rdatalist.rdata, &set->rdata[i], link);
+	}
+	dns_rdataset_init(&set->rdataset);
+	result = dns_rdatalist_tordataset(&set->rdatalist, &set->rdataset);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	set->rdataset.attributes |= DNS_RDATASETATTR_FIXEDORDER;
+}
+
+/*
+ * Render 'set' one record at a time with dns_rdata_towire(), the way
+ * dns_rdataset_towire() renders rdata that has to be compressed.
+ */
+static void
+slowtowire(testset_t *set, dns_name_t *owner, dns_compress_t *cctx,
+	   isc_buffer_t *target)
+{
+	dns_rdata_t *rdata;
+	isc_result_t result;
+
+	for (rdata = ISC_LIST_HEAD(set->rdatalist.rdata);
+	     rdata != NULL;
+	     rdata = ISC_LIST_NEXT(rdata, link))
+	{
+		isc_buffer_t rdlen;
+
+		dns_compress_setmethods(cctx, DNS_COMPRESS_GLOBAL14);
+		result = dns_name_towire(owner, cctx, target);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		isc_buffer_putuint16(target, set->rdatalist.type);
+		isc_buffer_putuint16(target, set->rdatalist.rdclass);
+		isc_buffer_putuint32(target, set->rdatalist.ttl);
+		rdlen = *target;
+		isc_buffer_add(target, 2);
+		result = dns_rdata_towire(rdata, cctx, target);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		isc_buffer_putuint16(&rdlen, (isc_uint16_t)(target->used -
+							   rdlen.used - 2));
+	}
+}
 
 /*
  * Individual unit tests
@@ -112,11 +191,151 @@ ATF_TC_BODY(trimttl, tc) {
 	dns_test_end();
 }
 
+ATF_TC(isverbatim);
+ATF_TC_HEAD(isverbatim, tc) {
+	atf_tc_set_md_var(tc, "descr", "dns_rdatatype_isverbatim() knows "
+				       "which rdata holds domain names");
+}
+ATF_TC_BODY(isverbatim, tc) {
+	UNUSED(tc);
+
+	ATF_CHECK(dns_rdatatype_isverbatim(dns_rdataclass_in,
+					   dns_rdatatype_a));
+	ATF_CHECK(!dns_rdatatype_isverbatim(dns_rdataclass_ch,
+					    dns_rdatatype_a));
+	ATF_CHECK(dns_rdatatype_isverbatim(dns_rdataclass_in,
+					   dns_rdatatype_aaaa));
+	ATF_CHECK(dns_rdatatype_isverbatim(dns_rdataclass_in,
+					   dns_rdatatype_rrsig));
+	ATF_CHECK(dns_rdatatype_isverbatim(dns_rdataclass_in,
+					   dns_rdatatype_dnskey));
+	ATF_CHECK(dns_rdatatype_isverbatim(dns_rdataclass_in,
+					   (dns_rdatatype_t)65000));
+	ATF_CHECK(!dns_rdatatype_isverbatim(dns_rdataclass_in,
+					    dns_rdatatype_ns));
+	ATF_CHECK(!dns_rdatatype_isverbatim(dns_rdataclass_in,
+					    dns_rdatatype_mx));
+	ATF_CHECK(!dns_rdatatype_isverbatim(dns_rdataclass_in,
+					    dns_rdatatype_soa));
+}
+
+ATF_TC(towire);
+ATF_TC_HEAD(towire, tc) {
+	atf_tc_set_md_var(tc, "descr", "dns_rdataset_towire() renders "
+				       "copied rdata the same as "
+				       "dns_rdata_towire()");
+}
+ATF_TC_BODY(towire, tc) {
+	static const char *a[] = { "10.0.0.1", "10.0.0.2", "10.0.0.3",
+				   NULL };
+	static const char *mx[] = { "10 mail.example.", "20 www.example.",
+				    NULL };
+	static const char *rrsig[] = {
+		"A 8 2 300 20180101000000 20170101000000 12345 example. "
+		"AwEAAaetidLzsKWUt4swWR8yu0wPHPiUi8LUsAD0QPWU+wzt89epO6tH "
+		"zkMBVDkC7qphQO2hTY4hHn9npWFRw5BYubE=",
+		NULL };
+	testset_t *aset, *mxset, *sigset;
+	unsigned char fast[1024], slow[1024];
+	dns_fixedname_t fixed;
+	dns_name_t *owner;
+	dns_compress_t cctx;
+	isc_buffer_t b;
+	unsigned int count, used;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	aset = isc_mem_get(mctx, sizeof(*aset));
+	mxset = isc_mem_get(mctx, sizeof(*mxset));
+	sigset = isc_mem_get(mctx, sizeof(*sigset));
+	ATF_REQUIRE(aset != NULL && mxset != NULL && sigset != NULL);
+	memset(aset, 0, sizeof(*aset));
+	memset(mxset, 0, sizeof(*mxset));
+	memset(sigset, 0, sizeof(*sigset));
+	makeset(aset, dns_rdatatype_a, a);
+	makeset(mxset, dns_rdatatype_mx, mx);
+	makeset(sigset, dns_rdatatype_rrsig, rrsig);
+
+	dns_fixedname_init(&fixed);
+	owner = dns_fixedname_name(&fixed);
+	result = dns_name_fromstring(owner, "www.example.", 0, NULL);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Render the sets through dns_rdataset_towire()...
+	 */
+	isc_buffer_init(&b, fast, sizeof(fast));
+	result = dns_compress_init(&cctx, -1, mctx);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	count = 0;
+	result = dns_rdataset_towire(&aset->rdataset, owner, &cctx, &b, 0,
+				     &count);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_rdataset_towire(&sigset->rdataset, owner, &cctx, &b, 0,
+				     &count);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = dns_rdataset_towire(&mxset->rdataset, owner, &cctx, &b, 0,
+				     &count);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(count, 6);
+	dns_compress_invalidate(&cctx);
+	used = isc_buffer_usedlength(&b);
+
+	/*
+	 * ...and one record at a time; the results must be identical.
+	 */
+	isc_buffer_init(&b, slow, sizeof(slow));
+	result = dns_compress_init(&cctx, -1, mctx);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	slowtowire(aset, owner, &cctx, &b);
+	slowtowire(sigset, owner, &cctx, &b);
+	slowtowire(mxset, owner, &cctx, &b);
+	dns_compress_invalidate(&cctx);
+	ATF_REQUIRE_EQ(isc_buffer_usedlength(&b), used);
+	ATF_CHECK(memcmp(fast, slow, used) == 0);
+
+	/*
+	 * The owner name was compressed in the second and third A
+	 * records: 27 bytes for the first, 16 for each of the others.
+	 */
+	ATF_CHECK_EQ(fast[13 + 10 + 4], 0xc0);
+	ATF_CHECK_EQ(fast[13 + 10 + 4 + 16], 0xc0);
+
+	/*
+	 * A partial render stops at the last A record that fits.
+	 */
+	isc_buffer_init(&b, fast, 13 + 10 + 4 + 16 + 15);
+	result = dns_compress_init(&cctx, -1, mctx);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	count = 0;
+	result = dns_rdataset_towirepartial(&aset->rdataset, owner, &cctx,
+					    &b, NULL, NULL, 0, &count, NULL);
+	ATF_CHECK_EQ(result, ISC_R_NOSPACE);
+	ATF_CHECK_EQ(count, 2);
+	ATF_CHECK_EQ(isc_buffer_usedlength(&b), 13 + 10 + 4 + 16);
+	dns_compress_invalidate(&cctx);
+
+	dns_rdataset_disassociate(&aset->rdataset);
+	dns_rdataset_disassociate(&mxset->rdataset);
+	dns_rdataset_disassociate(&sigset->rdataset);
+	isc_mem_put(mctx, aset, sizeof(*aset));
+	isc_mem_put(mctx, mxset, sizeof(*mxset));
+	isc_mem_put(mctx, sigset, sizeof(*sigset));
+
+	dns_test_end();
+}
+
 /*
  * Main
  */
 ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, trimttl);
+	ATF_TP_ADD_TC(tp, isverbatim);
+	ATF_TP_ADD_TC(tp, towire);
 
 	return (atf_no_error());
 }
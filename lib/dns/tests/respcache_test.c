@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*! \file */
+
+#include <config.h>
+
+#include <atf-c.h>
+
+#include <unistd.h>
+
+#include <isc/buffer.h>
+#include <isc/print.h>
+#include <isc/string.h>
+
+#include <dns/db.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdatatype.h>
+#include <dns/respcache.h>
+#include <dns/zone.h>
+
+#include "dnstest.h"
+
+static dns_zone_t *testzone = NULL;
+
+/*
+ * Helper functions
+ */
+
+static dns_name_t *
+makename(dns_fixedname_t *fixed, const char *text) {
+	dns_name_t *name;
+
+	dns_fixedname_init(fixed);
+	name = dns_fixedname_name(fixed);
+	ATF_REQUIRE_EQ(dns_name_fromstring(name, text, 0, NULL),
+		       ISC_R_SUCCESS);
+	return (name);
+}
+
+static dns_zone_t *
+makezone(const char *text) {
+	dns_fixedname_t fixed;
+	dns_zone_t *zone = NULL;
+
+	ATF_REQUIRE_EQ(dns_zone_create(&zone, mctx), ISC_R_SUCCESS);
+	ATF_REQUIRE_EQ(dns_zone_setorigin(zone, makename(&fixed, text)),
+		       ISC_R_SUCCESS);
+	dns_zone_setclass(zone, dns_rdataclass_in);
+	dns_zone_settype(zone, dns_zone_master);
+	return (zone);
+}
+
+/*
+ * Store a fake response to 'text' from 'zone' whose bytes after the
+ * header are all 'fill'.
+ */
+static void
+addzone(dns_respcache_t *rc, dns_zone_t *zone, const char *text,
+	isc_uint32_t key, unsigned int length, unsigned char fill)
+{
+	unsigned char wire[512];
+	dns_fixedname_t fixed;
+	isc_region_t r;
+
+	ATF_REQUIRE(length <= sizeof(wire));
+	memset(wire, fill, length);
+	wire[0] = wire[1] = 0;
+	r.base = wire;
+	r.length = length;
+	dns_respcache_add(rc, makename(&fixed, text), dns_rdatatype_a, key,
+			  zone, dns_zone_getrespgen(zone),
+			  dns_respcache_generation(rc), &r);
+}
+
+static void
+add(dns_respcache_t *rc, const char *text, isc_uint32_t key,
+    unsigned int length, unsigned char fill)
+{
+	addzone(rc, testzone, text, key, length, fill);
+}
+
+static isc_result_t
+find(dns_respcache_t *rc, const char *text, isc_uint32_t key,
+     unsigned int *lengthp, unsigned char *fillp)
+{
+	unsigned char wire[512];
+	dns_fixedname_t fixed;
+	isc_buffer_t b;
+	isc_result_t result;
+
+	isc_buffer_init(&b, wire, sizeof(wire));
+	result = dns_respcache_find(rc, makename(&fixed, text),
+				    dns_rdatatype_a, key, &b);
+	if (result == ISC_R_SUCCESS) {
+		if (lengthp != NULL)
+			*lengthp = isc_buffer_usedlength(&b);
+		if (fillp != NULL)
+			*fillp = wire[isc_buffer_usedlength(&b) - 1];
+	}
+	return (result);
+}
+
+/*
+ * Individual unit tests
+ */
+ATF_TC(addfind);
+ATF_TC_HEAD(addfind, tc) {
+	atf_tc_set_md_var(tc, "descr", "add and find responses");
+}
+ATF_TC_BODY(addfind, tc) {
+	dns_respcache_t *rc = NULL;
+	dns_fixedname_t fixed;
+	unsigned char wire[64];
+	unsigned char fill;
+	unsigned int length;
+	isc_buffer_t b;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	testzone = makezone("example.");
+
+	result = dns_respcache_create(mctx, 100000, &rc);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL),
+		     ISC_R_NOTFOUND);
+
+	add(rc, "www.example.", 0, 100, 1);
+	add(rc, "www.example.", 1, 200, 2);
+
+	/* Names match without regard to case. */
+	ATF_CHECK_EQ(find(rc, "WWW.Example.", 0, &length, &fill),
+		     ISC_R_SUCCESS);
+	ATF_CHECK_EQ(length, 100);
+	ATF_CHECK_EQ(fill, 1);
+	ATF_CHECK_EQ(find(rc, "www.example.", 1, &length, &fill),
+		     ISC_R_SUCCESS);
+	ATF_CHECK_EQ(length, 200);
+	ATF_CHECK_EQ(fill, 2);
+
+	/* The key and the type have to match too. */
+	ATF_CHECK_EQ(find(rc, "www.example.", 2, NULL, NULL),
+		     ISC_R_NOTFOUND);
+	isc_buffer_init(&b, wire, sizeof(wire));
+	result = dns_respcache_find(rc, makename(&fixed, "www.example."),
+				    dns_rdatatype_aaaa, 0, &b);
+	ATF_CHECK_EQ(result, ISC_R_NOTFOUND);
+
+	/* A response that doesn't fit isn't copied. */
+	result = dns_respcache_find(rc, makename(&fixed, "www.example."),
+				    dns_rdatatype_a, 0, &b);
+	ATF_CHECK_EQ(result, ISC_R_NOSPACE);
+	ATF_CHECK_EQ(isc_buffer_usedlength(&b), 0);
+
+	/* Adding again replaces the entry. */
+	add(rc, "www.example.", 0, 50, 3);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, &length, &fill),
+		     ISC_R_SUCCESS);
+	ATF_CHECK_EQ(length, 50);
+	ATF_CHECK_EQ(fill, 3);
+
+	dns_respcache_getstats(rc, &length, NULL);
+	ATF_CHECK_EQ(length, 2);
+
+	dns_respcache_flush(rc);
+	ATF_CHECK_EQ(find(rc, "www.example.", 1, NULL, NULL),
+		     ISC_R_NOTFOUND);
+
+	dns_respcache_destroy(&rc);
+	ATF_CHECK_EQ(rc, NULL);
+
+	dns_zone_detach(&testzone);
+	dns_test_end();
+}
+
+ATF_TC(zonechange);
+ATF_TC_HEAD(zonechange, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "changing a zone invalidates its responses");
+}
+ATF_TC_BODY(zonechange, tc) {
+	dns_respcache_t *rc = NULL;
+	dns_fixedname_t fixed;
+	dns_zone_t *other;
+	dns_db_t *db = NULL;
+	dns_dbversion_t *version = NULL;
+	unsigned char wire[100];
+	isc_uint32_t gen, zonegen;
+	isc_region_t r;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	testzone = makezone("example.");
+	other = makezone("other.");
+
+	result = dns_respcache_create(mctx, 100000, &rc);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = dns_test_loaddb(&db, dns_dbtype_zone, "example.",
+				 "testdata/zt/zone1.db");
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Loading the zone changes its generation.
+	 */
+	zonegen = dns_zone_getrespgen(testzone);
+	result = dns_zone_replacedb(testzone, db, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK(dns_zone_getrespgen(testzone) != zonegen);
+	ATF_CHECK_EQ(dns_zone_getrespgen(testzone) & 1, 0);
+
+	/*
+	 * Opening and abandoning a version changes nothing.
+	 */
+	add(rc, "www.example.", 0, 100, 1);
+	addzone(rc, other, "www.other.", 0, 100, 1);
+	result = dns_db_newversion(db, &version);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_db_closeversion(db, &version, ISC_FALSE);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL), ISC_R_SUCCESS);
+
+	/*
+	 * Committing one makes the zone's responses stale, but not
+	 * those from other zones.
+	 */
+	zonegen = dns_zone_getrespgen(testzone);
+	result = dns_db_newversion(db, &version);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	dns_db_closeversion(db, &version, ISC_TRUE);
+	ATF_CHECK(dns_zone_getrespgen(testzone) != zonegen);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL),
+		     ISC_R_NOTFOUND);
+	ATF_CHECK_EQ(find(rc, "www.other.", 0, NULL, NULL), ISC_R_SUCCESS);
+
+	/*
+	 * A response rendered before a change isn't stored after it.
+	 */
+	memset(wire, 0, sizeof(wire));
+	r.base = wire;
+	r.length = sizeof(wire);
+	dns_respcache_add(rc, makename(&fixed, "www.example."),
+			  dns_rdatatype_a, 0, testzone, zonegen,
+			  dns_respcache_generation(rc), &r);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL),
+		     ISC_R_NOTFOUND);
+
+	/*
+	 * Invalidating the cache discards everything, and responses
+	 * rendered before that aren't stored.
+	 */
+	gen = dns_respcache_generation(rc);
+	dns_respcache_invalidate(rc);
+	ATF_CHECK_EQ(find(rc, "www.other.", 0, NULL, NULL), ISC_R_NOTFOUND);
+	dns_respcache_add(rc, makename(&fixed, "www.other."),
+			  dns_rdatatype_a, 0, other,
+			  dns_zone_getrespgen(other), gen, &r);
+	ATF_CHECK_EQ(find(rc, "www.other.", 0, NULL, NULL), ISC_R_NOTFOUND);
+
+	/*
+	 * Unloading the zone makes its responses stale.
+	 */
+	add(rc, "www.example.", 0, 100, 1);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL), ISC_R_SUCCESS);
+	dns_zone_unload(testzone);
+	ATF_CHECK_EQ(find(rc, "www.example.", 0, NULL, NULL),
+		     ISC_R_NOTFOUND);
+
+	dns_respcache_destroy(&rc);
+	dns_db_detach(&db);
+	dns_zone_detach(&other);
+	dns_zone_detach(&testzone);
+	dns_test_end();
+}
+
+ATF_TC(clock);
+ATF_TC_HEAD(clock, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "responses which are not being used are "
+			  "discarded first");
+}
+ATF_TC_BODY(clock, tc) {
+	dns_respcache_t *rc = NULL;
+	char text[DNS_NAME_FORMATSIZE];
+	unsigned int i, count;
+	size_t size;
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = dns_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	testzone = makezone("example.");
+
+	result = dns_respcache_create(mctx, 20000, &rc);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Keep looking up the first name while adding more than fit.
+	 */
+	for (i = 0; i < 200; i++) {
+		snprintf(text, sizeof(text), "n%u.example.", i);
+		add(rc, text, 0, 400, 0);
+		ATF_CHECK_EQ(find(rc, "n0.example.", 0, NULL, NULL),
+			     ISC_R_SUCCESS);
+	}
+
+	dns_respcache_getstats(rc, &count, &size);
+	ATF_CHECK(size <= 20000);
+	ATF_CHECK(count > 10 && count < 50);
+
+	ATF_CHECK_EQ(find(rc, "n1.example.", 0, NULL, NULL),
+		     ISC_R_NOTFOUND);
+	ATF_CHECK_EQ(find(rc, "n199.example.", 0, NULL, NULL),
+		     ISC_R_SUCCESS);
+
+	/* A response bigger than the cache is never stored. */
+	dns_respcache_destroy(&rc);
+	result = dns_respcache_create(mctx, 300, &rc);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	add(rc, "big.example.", 0, 400, 0);
+	dns_respcache_getstats(rc, &count, &size);
+	ATF_CHECK_EQ(count, 0);
+	ATF_CHECK_EQ(size, 0);
+
+	dns_respcache_destroy(&rc);
+	dns_zone_detach(&testzone);
+	dns_test_end();
+}
+
+/*
+ * Main
+ */
+ATF_TP_ADD_TCS(tp) {
+	ATF_TP_ADD_TC(tp, addfind);
+	ATF_TP_ADD_TC(tp, zonechange);
+	ATF_TP_ADD_TC(tp, clock);
+	return (atf_no_error());
+}
@@ -24,7 +24,6 @@
 #include <isc/task.h>
 #include <isc/util.h>
 
-#include <dns/acache.h>
 #include <dns/acl.h>
 #include <dns/adb.h>
 #include <dns/badcache.h>
@@ -47,6 +46,7 @@
 #include <dns/rdataset.h>
 #include <dns/request.h>
 #include <dns/resolver.h>
+#include <dns/respcache.h>
 #include <dns/result.h>
 #include <dns/rpz.h>
 #include <dns/rrl.h>
@@ -137,7 +137,6 @@ dns_view_create(isc_mem_t *mctx, dns_rdataclass_t rdclass,
 		goto cleanup_zt;
 	}
 
-	view->acache = NULL;
 	view->cache = NULL;
 	view->cachedb = NULL;
 	ISC_LIST_INIT(view->dlz_searched);
@@ -182,6 +181,7 @@ dns_view_create(isc_mem_t *mctx, dns_rdataclass_t rdclass,
 	view->auth_nxdomain = ISC_FALSE; /* Was true in BIND 8 */
 	view->additionalfromcache = ISC_TRUE;
 	view->additionalfromauth = ISC_TRUE;
+	view->use_glue_cache = ISC_TRUE;
 	view->enablednssec = ISC_TRUE;
 	view->enablevalidation = ISC_TRUE;
 	view->acceptexpired = ISC_FALSE;
@@ -209,6 +209,10 @@ dns_view_create(isc_mem_t *mctx, dns_rdataclass_t rdclass,
 	view->provideixfr = ISC_TRUE;
 	view->maxcachettl = 7 * 24 * 3600;
 	view->maxncachettl = 3 * 3600;
+	view->staleanswersenable = ISC_FALSE;
+	view->staleanswerttl = 1;
+	view->staleanswerclienttimeout = 0;
+	view->stalerefresh = 0;
 	view->nta_lifetime = 0;
 	view->nta_recheck = 0;
 	view->prefetch_eligible = 0;
@@ -244,6 +248,7 @@ dns_view_create(isc_mem_t *mctx, dns_rdataclass_t rdclass,
 	view->failcache = NULL;
 	(void)dns_badcache_init(view->mctx, DNS_VIEW_FAILCACHESIZE,
 				   &view->failcache);
+	view->respcache = NULL;
 	view->v6bias = 0;
 	view->dtenv = NULL;
 	view->dttypes = 0;
@@ -379,11 +384,6 @@ destroy(dns_view_t *view) {
 		dns_adb_detach(&view->adb);
 	if (view->resolver != NULL)
 		dns_resolver_detach(&view->resolver);
-	if (view->acache != NULL) {
-		if (view->cachedb != NULL)
-			dns_acache_putdb(view->acache, view->cachedb);
-		dns_acache_detach(&view->acache);
-	}
 	dns_rrl_view_destroy(view);
 	if (view->rpzs != NULL)
 		dns_rpz_detach_rpzs(&view->rpzs);
@@ -527,6 +527,8 @@ destroy(dns_view_t *view) {
 	dns_aclenv_destroy(&view->aclenv);
 	if (view->failcache != NULL)
 		dns_badcache_destroy(&view->failcache);
+	if (view->respcache != NULL)
+		dns_respcache_destroy(&view->respcache);
 	DESTROYLOCK(&view->new_zone_lock);
 	DESTROYLOCK(&view->lock);
 	isc_refcount_destroy(&view->references);
@@ -577,6 +579,13 @@ view_flushanddetach(dns_view_t **viewp, isc_boolean_t flush) {
 	if (refs == 0) {
 		dns_zone_t *mkzone = NULL, *rdzone = NULL;
 
+		/*
+		 * The response cache holds references to the view's
+		 * zones, which hold weak references to the view.
+		 */
+		if (view->respcache != NULL)
+			dns_respcache_flush(view->respcache);
+
 		LOCK(&view->lock);
 		if (!RESSHUTDOWN(view))
 			dns_resolver_shutdown(view->resolver);
@@ -584,8 +593,6 @@ view_flushanddetach(dns_view_t **viewp, isc_boolean_t flush) {
 			dns_adb_shutdown(view->adb);
 		if (!REQSHUTDOWN(view))
 			dns_requestmgr_shutdown(view->requestmgr);
-		if (view->acache != NULL)
-			dns_acache_shutdown(view->acache);
 		if (view->zonetable != NULL) {
 			if (view->flush)
 				dns_zt_flushanddetach(&view->zonetable);
@@ -850,17 +857,12 @@ dns_view_setcache2(dns_view_t *view, dns_cache_t *cache, isc_boolean_t shared) {
 
 	view->cacheshared = shared;
 	if (view->cache != NULL) {
-		if (view->acache != NULL)
-			dns_acache_putdb(view->acache, view->cachedb);
 		dns_db_detach(&view->cachedb);
 		dns_cache_detach(&view->cache);
 	}
 	dns_cache_attach(cache, &view->cache);
 	dns_cache_attachdb(cache, &view->cachedb);
 	INSIST(DNS_DB_VALID(view->cachedb));
-
-	if (view->acache != NULL)
-		dns_acache_setdb(view->acache, view->cachedb);
 }
 
 isc_boolean_t
@@ -962,6 +964,8 @@ dns_view_addzone(dns_view_t *view, dns_zone_t *zone) {
 	REQUIRE(view->zonetable != NULL);
 
 	result = dns_zt_mount(view->zonetable, zone);
+	if (result == ISC_R_SUCCESS && view->respcache != NULL)
+		dns_respcache_invalidate(view->respcache);
 
 	return (result);
 }
@@ -1632,12 +1636,8 @@ dns_view_flushcache2(dns_view_t *view, isc_boolean_t fixuponly) {
 		if (result != ISC_R_SUCCESS)
 			return (result);
 	}
-	if (view->acache != NULL)
-		dns_acache_putdb(view->acache, view->cachedb);
 	dns_db_detach(&view->cachedb);
 	dns_cache_attachdb(view->cache, &view->cachedb);
-	if (view->acache != NULL)
-		dns_acache_setdb(view->acache, view->cachedb);
 	if (view->resolver != NULL)
 		dns_resolver_flushbadcache(view->resolver, NULL);
 	if (view->failcache != NULL)
@@ -11,9 +11,12 @@
 #include <config.h>
 #include <errno.h>
 
+#include <isc/atomic.h>
 #include <isc/file.h>
 #include <isc/hex.h>
 #include <isc/mutex.h>
+#include <isc/once.h>
+#include <isc/platform.h>
 #include <isc/pool.h>
 #include <isc/print.h>
 #include <isc/random.h>
@@ -30,7 +33,6 @@
 #include <isc/timer.h>
 #include <isc/util.h>
 
-#include <dns/acache.h>
 #include <dns/acl.h>
 #include <dns/adb.h>
 #include <dns/callbacks.h>
@@ -198,6 +200,11 @@ struct dns_zone {
 	isc_mutex_t		dblock;
 #endif
 	dns_db_t		*db;		/* Locked by dblock */
+#ifdef ISC_PLATFORM_HAVEXADD
+	isc_int32_t		respgen;
+#else
+	isc_uint32_t		respgen;	/* Locked by respgen_lock */
+#endif
 
 	/* Locked */
 	dns_zonemgr_t		*zmgr;
@@ -303,7 +310,6 @@ struct dns_zone {
 	isc_uint32_t		sigresigninginterval;
 	dns_view_t		*view;
 	dns_view_t		*prev_view;
-	dns_acache_t		*acache;
 	dns_checkmxfunc_t	checkmx;
 	dns_checksrvfunc_t	checksrv;
 	dns_checknsfunc_t	checkns;
@@ -919,6 +925,7 @@ dns_zone_create(dns_zone_t **zonep, isc_mem_t *mctx) {
 	zone->locked = ISC_FALSE;
 #endif
 	zone->db = NULL;
+	zone->respgen = 0;
 	zone->zmgr = NULL;
 	ISC_LINK_INIT(zone, link);
 	result = isc_refcount_init(&zone->erefs, 1);	/* Implicit attach. */
@@ -1022,7 +1029,6 @@ dns_zone_create(dns_zone_t **zonep, isc_mem_t *mctx) {
 	zone->sigresigninginterval = 7 * 24 * 3600;
 	zone->view = NULL;
 	zone->prev_view = NULL;
-	zone->acache = NULL;
 	zone->checkmx = NULL;
 	zone->checksrv = NULL;
 	zone->checkns = NULL;
@@ -1192,9 +1198,6 @@ zone_free(dns_zone_t *zone) {
 	if (zone->db != NULL) {
 		zone_detachdb(zone);
 	}
-	if (zone->acache != NULL) {
-		dns_acache_detach(&zone->acache);
-	}
 	if (zone->rpzs != NULL) {
 		REQUIRE(zone->rpz_num < zone->rpzs->p.num_zones);
 		dns_rpz_detach_rpzs(&zone->rpzs);
@@ -1592,36 +1595,6 @@ dns_zone_setorigin(dns_zone_t *zone, const dns_name_t *origin) {
 	return (result);
 }
 
-void
-dns_zone_setacache(dns_zone_t *zone, dns_acache_t *acache) {
-	REQUIRE(DNS_ZONE_VALID(zone));
-	REQUIRE(acache != NULL);
-
-	LOCK_ZONE(zone);
-	if (zone->acache != NULL)
-		dns_acache_detach(&zone->acache);
-	dns_acache_attach(acache, &zone->acache);
-	ZONEDB_LOCK(&zone->dblock, isc_rwlocktype_read);
-	if (zone->db != NULL) {
-		isc_result_t result;
-
-		/*
-		 * If the zone reuses an existing DB, the DB needs to be
-		 * set in the acache explicitly.  We can safely ignore the
-		 * case where the DB is already set.  If other error happens,
-		 * the acache will not work effectively.
-		 */
-		result = dns_acache_setdb(acache, zone->db);
-		if (result != ISC_R_SUCCESS && result != ISC_R_EXISTS) {
-			UNEXPECTED_ERROR(__FILE__, __LINE__,
-					 "dns_acache_setdb() failed: %s",
-					 isc_result_totext(result));
-		}
-	}
-	ZONEDB_UNLOCK(&zone->dblock, isc_rwlocktype_read);
-	UNLOCK_ZONE(zone);
-}
-
 static isc_result_t
 dns_zone_setstring(dns_zone_t *zone, char **field, const char *value) {
 	char *copy;
@@ -1780,13 +1753,8 @@ dns_zone_isdynamic(dns_zone_t *zone, isc_boolean_t ignore_freeze) {
 
 }
 
-/*
- * Set the response policy index and information for a zone.
- */
-isc_result_t
-dns_zone_rpz_enable(dns_zone_t *zone, dns_rpz_zones_t *rpzs,
-		    dns_rpz_num_t rpz_num)
-{
+static isc_boolean_t
+zone_rpz_capable(dns_zone_t *zone) {
 	/*
 	 * Only RBTDB zones can be used for response policy zones,
 	 * because only they have the code to load the create the summary data.
@@ -1795,8 +1763,20 @@ dns_zone_rpz_enable(dns_zone_t *zone, dns_rpz_zones_t *rpzs,
 	 */
 	if (strcmp(zone->db_argv[0], "rbt") != 0 &&
 	    strcmp(zone->db_argv[0], "rbt64") != 0)
-		return (ISC_R_NOTIMPLEMENTED);
+		return (ISC_FALSE);
 	if (zone->masterformat == dns_masterformat_map)
+		return (ISC_FALSE);
+	return (ISC_TRUE);
+}
+
+/*
+ * Set the response policy index and information for a zone.
+ */
+isc_result_t
+dns_zone_rpz_enable(dns_zone_t *zone, dns_rpz_zones_t *rpzs,
+		    dns_rpz_num_t rpz_num)
+{
+	if (!zone_rpz_capable(zone))
 		return (ISC_R_NOTIMPLEMENTED);
 
 	/*
@@ -1823,10 +1803,12 @@ dns_zone_get_rpz_num(dns_zone_t *zone) {
 
 /*
  * If a zone is a response policy zone, mark its new database.
+ * The zone's database type may have changed since the zone was
+ * made a policy zone; zone_load() reports that.
  */
 void
 dns_zone_rpz_enable_db(dns_zone_t *zone, dns_db_t *db) {
-	if (zone->rpz_num != DNS_RPZ_INVALID_NUM) {
+	if (zone->rpz_num != DNS_RPZ_INVALID_NUM && zone_rpz_capable(zone)) {
 		REQUIRE(zone->rpzs != NULL);
 		dns_db_rpz_attach(db, zone->rpzs, zone->rpz_num);
 	}
@@ -1944,7 +1926,34 @@ zone_load(dns_zone_t *zone, unsigned int flags, isc_boolean_t locked) {
 	INSIST(zone->db_argc >= 1);
 
 	rbt = strcmp(zone->db_argv[0], "rbt") == 0 ||
-	      strcmp(zone->db_argv[0], "rbt64") == 0;
+	      strcmp(zone->db_argv[0], "rbt64") == 0 ||
+	      strcmp(zone->db_argv[0], "qp") == 0;
+
+	/*
+	 * A zone can be made a policy zone before its database type is
+	 * set, so check again here.  The "qp" database also cannot be
+	 * mmap()ed and does not record re-signing times.
+	 */
+	if (zone->rpz_num != DNS_RPZ_INVALID_NUM && !zone_rpz_capable(zone)) {
+		dns_zone_log(zone, ISC_LOG_ERROR,
+			     "database '%s' cannot be used for a response "
+			     "policy zone", zone->db_argv[0]);
+		result = ISC_R_NOTIMPLEMENTED;
+		goto cleanup;
+	}
+	if (strcmp(zone->db_argv[0], "qp") == 0 &&
+	    (zone->masterformat == dns_masterformat_map ||
+	     zone->raw != NULL ||
+	     DNS_ZONEKEY_OPTION(zone, DNS_ZONEKEY_ALLOW |
+				      DNS_ZONEKEY_MAINTAIN)))
+	{
+		dns_zone_log(zone, ISC_LOG_ERROR,
+			     "database 'qp' cannot be used with "
+			     "'masterfile-format map', inline-signing "
+			     "or auto-dnssec");
+		result = ISC_R_NOTIMPLEMENTED;
+		goto cleanup;
+	}
 
 	if (zone->db != NULL && zone->masterfile == NULL && rbt) {
 		/*
@@ -14988,31 +14997,98 @@ zone_replacedb(dns_zone_t *zone, dns_db_t *db, isc_boolean_t dump) {
 	return (result);
 }
 
-/* The caller must hold the dblock as a writer. */
+/*
+ * The response generation of a zone changes whenever the data it
+ * serves may have: when its database is replaced and when a version
+ * of the database is committed.  It is even while changes to the
+ * database are being tracked and odd when they are not.
+ */
+#ifndef ISC_PLATFORM_HAVEXADD
+static isc_once_t respgen_once = ISC_ONCE_INIT;
+static isc_mutex_t respgen_lock;
+
+static void
+initialize_respgen(void) {
+	RUNTIME_CHECK(isc_mutex_init(&respgen_lock) == ISC_R_SUCCESS);
+}
+#endif
+
+static void
+zone_advancerespgen(dns_zone_t *zone, isc_int32_t delta) {
+#ifdef ISC_PLATFORM_HAVEXADD
+	(void)isc_atomic_xadd(&zone->respgen, delta);
+#else
+	RUNTIME_CHECK(isc_once_do(&respgen_once,
+				  initialize_respgen) == ISC_R_SUCCESS);
+	LOCK(&respgen_lock);
+	zone->respgen += delta;
+	UNLOCK(&respgen_lock);
+#endif
+}
+
+isc_uint32_t
+dns_zone_getrespgen(dns_zone_t *zone) {
+#ifdef ISC_PLATFORM_HAVEXADD
+	REQUIRE(DNS_ZONE_VALID(zone));
+
+	return ((isc_uint32_t)isc_atomic_xadd(&zone->respgen, 0));
+#else
+	isc_uint32_t value;
+
+	REQUIRE(DNS_ZONE_VALID(zone));
+
+	RUNTIME_CHECK(isc_once_do(&respgen_once,
+				  initialize_respgen) == ISC_R_SUCCESS);
+	LOCK(&respgen_lock);
+	value = zone->respgen;
+	UNLOCK(&respgen_lock);
+	return (value);
+#endif
+}
+
+static isc_result_t
+zone_respgen_update(dns_db_t *db, void *fn_arg) {
+	dns_zone_t *zone = fn_arg;
+
+	UNUSED(db);
+
+	zone_advancerespgen(zone, 2);
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * The caller must hold the dblock as a writer.
+ *
+ * Changes to a persistent database are not seen by dns_db_closeversion()
+ * and so can't be tracked; the response generation is left odd while
+ * such a database is attached.
+ */
 static inline void
 zone_attachdb(dns_zone_t *zone, dns_db_t *db) {
+	isc_result_t result = ISC_R_NOTIMPLEMENTED;
+
 	REQUIRE(zone->db == NULL && db != NULL);
 
 	dns_db_attach(db, &zone->db);
-	if (zone->acache != NULL) {
-		isc_result_t result;
-		result = dns_acache_setdb(zone->acache, db);
-		if (result != ISC_R_SUCCESS && result != ISC_R_EXISTS) {
-			UNEXPECTED_ERROR(__FILE__, __LINE__,
-					 "dns_acache_setdb() failed: %s",
-					 isc_result_totext(result));
-		}
-	}
+	if (!dns_db_ispersistent(db))
+		result = dns_db_updatenotify_register(db, zone_respgen_update,
+						      zone);
+	zone_advancerespgen(zone, (result == ISC_R_SUCCESS) ? 2 : 1);
 }
 
 /* The caller must hold the dblock as a writer. */
 static inline void
 zone_detachdb(dns_zone_t *zone) {
+	isc_result_t result = ISC_R_NOTFOUND;
+
 	REQUIRE(zone->db != NULL);
 
-	if (zone->acache != NULL)
-		(void)dns_acache_putdb(zone->acache, zone->db);
+	if (!dns_db_ispersistent(zone->db))
+		result = dns_db_updatenotify_unregister(zone->db,
+							zone_respgen_update,
+							zone);
 	dns_db_detach(&zone->db);
+	zone_advancerespgen(zone, (result == ISC_R_SUCCESS) ? 2 : 1);
 }
 
 static void
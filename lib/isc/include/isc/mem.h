@@ -142,6 +142,7 @@ LIBISC_EXTERNAL_DATA extern unsigned int isc_mem_defaultflags;
  */
 #define ISC_MEMFLAG_NOLOCK	0x00000001	 /* no lock is necessary */
 #define ISC_MEMFLAG_INTERNAL	0x00000002	 /* use internal malloc */
+#define ISC_MEMFLAG_THREADCACHE	0x00000004	 /* per-thread free lists */
 #if ISC_MEM_USE_INTERNAL_MALLOC
 #define ISC_MEMFLAG_DEFAULT 	ISC_MEMFLAG_INTERNAL
 #else
@@ -330,6 +331,15 @@ isc_mem_createx2(size_t max_size, size_t target_size,
  * inadvisable to use this flag unless the user is very sure about the race
  * condition and the access to the object is highly performance sensitive.
  *
+ * If ISC_MEMFLAG_THREADCACHE is set in 'flags' (and ISC_MEMFLAG_NOLOCK is
+ * not), each thread keeps a small cache of freed blocks of the sizes it
+ * uses, and of the items of each memory pool with an associated lock,
+ * and only takes the context lock to move blocks in batches.  Cached
+ * blocks are counted as in use: isc_mem_inuse(), the quota and the water
+ * marks may overstate the memory actually in use by a bounded amount
+ * per thread.  The caches are not used while ISC_MEM_DEBUGTRACE or
+ * ISC_MEM_DEBUGRECORD is set.
+ *
  * Requires:
  * mctxp != NULL && *mctxp == NULL */
 /*@}*/
@@ -68,6 +68,7 @@
 #define isc_socket_detach isc__socket_detach
 #define isc_socketmgr_create isc__socketmgr_create
 #define isc_socketmgr_create2 isc__socketmgr_create2
+#define isc_socketmgr_create3 isc__socketmgr_create3
 #define isc_socketmgr_destroy isc__socketmgr_destroy
 #define isc_socket_open isc__socket_open
 #define isc_socket_close isc__socket_close
@@ -119,12 +120,33 @@ ISC_LANG_BEGINDECLS
  */
 #define ISC_SOCKET_MAXSCATTERGATHER	8
 
+/*%
+ * Maximum number of datagrams received or sent by a single batched
+ * UDP system call.  See isc__socketmgr_setudpbatch().
+ */
+#define ISC_SOCKET_MAXBATCH		32
+
+/*%
+ * Maximum number of watcher threads a socket manager will start.
+ * See isc_socketmgr_create3().
+ */
+#define ISC_SOCKET_MAXWATCHERS		64
+
 /*%
  * In isc_socket_bind() set socket option SO_REUSEADDR prior to calling
  * bind() if a non zero port is specified (AF_INET and AF_INET6).
  */
 #define ISC_SOCKET_REUSEADDRESS		0x01U
 
+/*%
+ * In isc_socket_bind() set socket option SO_REUSEPORT prior to calling
+ * bind() so that several sockets may be bound to the same address and
+ * port, with the kernel distributing incoming datagrams between them.
+ * isc_socket_bind() returns ISC_R_NOTIMPLEMENTED if the operating system
+ * does not support this.
+ */
+#define ISC_SOCKET_REUSEPORT		0x02U
+
 /*%
  * Statistics counters.  Used as isc_statscounter_t values.
  */
@@ -1022,11 +1044,20 @@ isc_socketmgr_create(isc_mem_t *mctx, isc_socketmgr_t **managerp);
 isc_result_t
 isc_socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 		      unsigned int maxsocks);
+
+isc_result_t
+isc_socketmgr_create3(isc_mem_t *mctx, isc_socketmgr_t **managerp,
+		      unsigned int maxsocks, unsigned int nthreads);
 /*%<
  * Create a socket manager.  If "maxsocks" is non-zero, it specifies the
  * maximum number of sockets that the created manager should handle.
  * isc_socketmgr_create() is equivalent of isc_socketmgr_create2() with
  * "maxsocks" being zero.
+ * isc_socketmgr_create3() additionally spreads the sockets over
+ * "nthreads" watcher threads, each polling its own share of the
+ * descriptors; isc_socketmgr_create2() uses a single watcher.  More
+ * than one watcher is only supported with epoll, and "nthreads" is
+ * capped at #ISC_SOCKET_MAXWATCHERS.
  * isc_socketmgr_createinctx() also associates the new manager with the
  * specified application context.
  *
@@ -1224,6 +1255,36 @@ isc__socketmgr_maxudp(isc_socketmgr_t *mgr, int maxudp);
  * Test interface. Drop UDP packet > 'maxudp'.
  */
 
+void
+isc__socketmgr_setudpbatch(isc_socketmgr_t *mgr, unsigned int n);
+/*%<
+ * Service up to 'n' queued UDP receive or send requests of a socket with
+ * a single recvmmsg()/sendmmsg() call when the socket becomes readable
+ * or writable.  Values of 0 or 1 disable batching, and values above
+ * #ISC_SOCKET_MAXBATCH are capped.  Ignored on platforms without
+ * recvmmsg() and sendmmsg().
+ *
+ * Requires:
+ *\li	'mgr' is a valid socket manager.
+ */
+
+isc_result_t
+isc__socketmgr_setaffinity(isc_socketmgr_t *mgr, const unsigned int *cpus,
+			   unsigned int ncpus);
+/*%<
+ * Bind watcher thread 'n' of 'mgr' to CPU 'cpus[n % ncpus]'.  If 'ncpus'
+ * is zero, let every watcher run on any CPU again.
+ *
+ * Requires:
+ *\li	'mgr' is a valid socket manager.
+ *
+ *\li	'cpus' is not NULL unless 'ncpus' is zero.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS
+ *\li	the result of the first isc_thread_setaffinity() call that failed.
+ */
+
 #ifdef HAVE_LIBXML2
 int
 isc_socketmgr_renderxml(isc_socketmgr_t *mgr, xmlTextWriterPtr writer);
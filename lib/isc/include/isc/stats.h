@@ -22,6 +22,11 @@ ISC_LANG_BEGINDECLS
  */
 #define ISC_STATSDUMP_VERBOSE	0x00000001 /*%< dump 0-value counters */
 
+/*%<
+ * Flag(s) for isc_stats_create2().
+ */
+#define ISC_STATSCREATE_SHARDED	0x00000001 /*%< per-thread counter copies */
+
 /*%<
  * Dump callback type.
  */
@@ -44,6 +49,30 @@ isc_stats_create(isc_mem_t *mctx, isc_stats_t **statsp, int ncounters);
  *\li	anything else	-- failure
  */
 
+isc_result_t
+isc_stats_create2(isc_mem_t *mctx, isc_stats_t **statsp, int ncounters,
+		  unsigned int options);
+/*%<
+ * Like isc_stats_create(), but if 'options' has the
+ * ISC_STATSCREATE_SHARDED flag, the counters are kept in several copies
+ * ("shards"), up to one per CPU, and each thread updates its own copy.
+ * This avoids contention between threads that update the same counters
+ * all the time, at the cost of more memory and a slower
+ * isc_stats_dump(), which adds the copies up.  A counter that is
+ * incremented and decremented by different threads may briefly appear
+ * to be lower than it is; it is never reported below zero.
+ *
+ * Requires:
+ *\li	'mctx' must be a valid memory context.
+ *
+ *\li	'statsp' != NULL && '*statsp' == NULL.
+ *
+ * Returns:
+ *\li	ISC_R_SUCCESS	-- all ok
+ *
+ *\li	anything else	-- failure
+ */
+
 void
 isc_stats_attach(isc_stats_t *stats, isc_stats_t **statsp);
 /*%<
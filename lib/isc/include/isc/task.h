@@ -202,6 +202,22 @@ isc_task_create(isc_taskmgr_t *manager, unsigned int quantum,
  *\li	#ISC_R_SHUTTINGDOWN
  */
 
+isc_result_t
+isc_task_create_bound(isc_taskmgr_t *manager, unsigned int quantum,
+		      isc_task_t **taskp, int threadid);
+/*%<
+ * Like isc_task_create(), but if 'threadid' is not negative the task
+ * is bound to worker thread 'threadid' modulo the number of workers:
+ * its events are normally run by that worker, which another worker
+ * only helps out when it is busy.
+ *
+ * Requires:
+ *
+ *\li	'manager' is a valid task manager created by this library.
+ *
+ *\li	taskp != NULL && *taskp == NULL
+ */
+
 void
 isc_task_attach(isc_task_t *source, isc_task_t **targetp);
 /*%<
@@ -782,6 +798,44 @@ isc_taskmgr_excltask(isc_taskmgr_t *mgr, isc_task_t **taskp);
  *\li	taskp != NULL && *taskp == NULL
  */
 
+isc_result_t
+isc_taskmgr_setaffinity(isc_taskmgr_t *mgr, const unsigned int *cpus,
+			unsigned int ncpus);
+/*%<
+ * Bind worker thread 'n' of 'mgr' to CPU 'cpus[n % ncpus]'.  If 'ncpus'
+ * is zero, let every worker run on any CPU again.
+ *
+ * Requires:
+ *\li	'mgr' is a valid task manager.
+ *
+ *\li	'cpus' is not NULL unless 'ncpus' is zero.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS
+ *\li	the result of the first isc_thread_setaffinity() call that failed.
+ */
+
+void
+isc_taskmgr_setlatencystats(isc_taskmgr_t *mgr, isc_boolean_t enable);
+/*%<
+ * Enable or disable the collection of latency histograms.  While enabled,
+ * the task manager records, per task name, how long tasks wait on a ready
+ * queue, how long each event action runs and how many events are run per
+ * quantum.  The histograms are kept when collection is disabled and are
+ * rendered by isc_taskmgr_renderxml() and isc_taskmgr_renderjson().
+ *
+ * Requires:
+ *\li	'mgr' is a valid task manager.
+ */
+
+isc_boolean_t
+isc_taskmgr_latencystats(isc_taskmgr_t *mgr);
+/*%<
+ * Return ISC_TRUE if latency histograms are being collected.
+ *
+ * Requires:
+ *\li	'mgr' is a valid task manager.
+ */
 
 #ifdef HAVE_LIBXML2
 int
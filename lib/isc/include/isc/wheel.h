@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ISC_WHEEL_H
+#define ISC_WHEEL_H 1
+
+/*! \file isc/wheel.h
+ * \brief A hierarchical timing wheel.
+ *
+ * The wheel keeps entries ordered by an integer deadline (a "tick"),
+ * with constant time insertion and deletion.  Entries are kept in
+ * per-level buckets of geometrically increasing width, and are moved
+ * into finer buckets as the wheel's clock approaches their deadline,
+ * so each entry is moved at most once per level before it expires.
+ *
+ * The unit of a tick is up to the caller.  An entry is never returned
+ * by isc_wheel_expire() before its tick has been reached.
+ *
+ * The wheel is not locked; callers must serialize access to it.
+ */
+
+#include <isc/lang.h>
+#include <isc/list.h>
+#include <isc/types.h>
+
+ISC_LANG_BEGINDECLS
+
+typedef struct isc_wheel isc_wheel_t;
+typedef struct isc_wheelentry isc_wheelentry_t;
+
+/*%
+ * An entry is embedded in the structure being scheduled.  Its members
+ * are private to the wheel.
+ */
+struct isc_wheelentry {
+	ISC_LINK(isc_wheelentry_t)	link;
+	isc_uint64_t			tick;
+	unsigned int			slot;
+	void *				value;
+};
+
+#define ISC_WHEELENTRY_INIT(e) \
+	do { \
+		ISC_LINK_INIT((e), link); \
+		(e)->tick = 0; \
+		(e)->slot = 0; \
+		(e)->value = NULL; \
+	} while (0)
+
+/*%
+ * True if the entry is currently in a wheel.
+ */
+#define ISC_WHEELENTRY_SCHEDULED(e)	((e)->slot != 0)
+
+isc_result_t
+isc_wheel_create(isc_mem_t *mctx, isc_uint64_t now, isc_wheel_t **wheelp);
+/*!<
+ * \brief Create a new timing wheel whose clock starts at 'now'.
+ *
+ * Requires:
+ *\li	"mctx" is valid.
+ *\li	"wheelp" is not NULL, and "*wheelp" is NULL.
+ *
+ * Returns:
+ *\li	ISC_R_SUCCESS		- success
+ *\li	ISC_R_NOMEMORY		- insufficient memory
+ */
+
+void
+isc_wheel_destroy(isc_wheel_t **wheelp);
+/*!<
+ * \brief Destroys a wheel.  Any entries still in it are forgotten.
+ *
+ * Requires:
+ *\li	"wheelp" is not NULL and "*wheelp" points to a valid isc_wheel_t.
+ */
+
+void
+isc_wheel_insert(isc_wheel_t *wheel, isc_wheelentry_t *entry,
+		 isc_uint64_t tick, void *value);
+/*!<
+ * \brief Schedule 'entry' to expire at 'tick'.  'value' is returned by
+ * isc_wheel_expire() when it does.  A tick which the wheel's clock has
+ * already passed is treated as the next tick.
+ *
+ * Requires:
+ *\li	"wheel" is a valid wheel.
+ *\li	"entry" has been initialized with ISC_WHEELENTRY_INIT() and is
+ *	not scheduled.
+ */
+
+void
+isc_wheel_delete(isc_wheel_t *wheel, isc_wheelentry_t *entry);
+/*!<
+ * \brief Remove a scheduled 'entry' from the wheel.
+ *
+ * Requires:
+ *\li	"wheel" is a valid wheel.
+ *\li	"entry" is scheduled in "wheel".
+ */
+
+void *
+isc_wheel_expire(isc_wheel_t *wheel, isc_uint64_t now);
+/*!<
+ * \brief Advance the wheel's clock to 'now', and remove and return the
+ * value of an entry whose tick is at or before 'now'.
+ *
+ * Entries are returned in tick order, except that entries expiring on
+ * the same tick are returned in no particular order.  Entries may be
+ * inserted and deleted between calls.
+ *
+ * Requires:
+ *\li	"wheel" is a valid wheel.
+ *
+ * Returns:
+ *\li	The value of the expired entry, or NULL if no more entries have
+ *	expired.
+ */
+
+isc_boolean_t
+isc_wheel_next(isc_wheel_t *wheel, isc_uint64_t *tickp);
+/*!<
+ * \brief Find the tick at which the wheel next has work to do.
+ *
+ * This is no later than the earliest tick of any entry in the wheel,
+ * but may be earlier, when entries need to be moved between levels;
+ * isc_wheel_expire() may therefore return NULL when called with the
+ * tick returned here.
+ *
+ * Requires:
+ *\li	"wheel" is a valid wheel.
+ *\li	"tickp" is not NULL.
+ *
+ * Returns:
+ *\li	ISC_TRUE, with '*tickp' set, if the wheel is not empty, and
+ *	ISC_FALSE otherwise.
+ */
+
+unsigned int
+isc_wheel_count(isc_wheel_t *wheel);
+/*!<
+ * \brief Return the number of entries in the wheel.
+ *
+ * Requires:
+ *\li	"wheel" is a valid wheel.
+ */
+
+ISC_LANG_ENDDECLS
+
+#endif /* ISC_WHEEL_H */
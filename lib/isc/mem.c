@@ -16,6 +16,10 @@
 
 #include <limits.h>
 
+#ifdef HAVE_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
 #include <isc/bind9.h>
 #include <isc/json.h>
 #include <isc/magic.h>
@@ -25,7 +29,9 @@
 #include <isc/ondestroy.h>
 #include <isc/string.h>
 #include <isc/mutex.h>
+#include <isc/platform.h>
 #include <isc/print.h>
+#include <isc/thread.h>
 #include <isc/util.h>
 #include <isc/xml.h>
 
@@ -36,7 +42,16 @@
 #define ISC_MEM_DEBUGGING 0
 #endif
 LIBISC_EXTERNAL_DATA unsigned int isc_mem_debugging = ISC_MEM_DEBUGGING;
+#ifdef HAVE_JEMALLOC
+/*
+ * jemalloc is both faster and less prone to fragmentation than the
+ * internal block allocator, so let it handle every allocation.
+ */
+LIBISC_EXTERNAL_DATA unsigned int isc_mem_defaultflags =
+	ISC_MEMFLAG_DEFAULT & ~ISC_MEMFLAG_INTERNAL;
+#else
 LIBISC_EXTERNAL_DATA unsigned int isc_mem_defaultflags = ISC_MEMFLAG_DEFAULT;
+#endif
 
 /*
  * Constants.
@@ -49,6 +64,16 @@ LIBISC_EXTERNAL_DATA unsigned int isc_mem_defaultflags = ISC_MEMFLAG_DEFAULT;
 #define TABLE_INCREMENT		1024
 #define DEBUGLIST_COUNT		1024
 
+#ifdef ISC_PLATFORM_USETHREADS
+#define USE_TCACHE
+#endif
+
+#define TCACHE_SLOTS		64	/*%< threads with their own caches */
+#define TCACHE_BINS		32	/*%< sizes cached per thread */
+#define TCACHE_MAXSIZE		1024	/*%< largest block cached */
+#define TCACHE_MAXITEMS		32	/*%< most blocks cached per size */
+#define TCACHE_MAXBYTES		8192	/*%< most bytes cached per size */
+
 /*
  * Types.
  */
@@ -96,6 +121,39 @@ struct stats {
 	unsigned long		freefrags;
 };
 
+/*%
+ * Per-thread caches ("magazines") of free blocks, used by contexts
+ * created with ISC_MEMFLAG_THREADCACHE.  Each thread is given a slot
+ * number the first time it uses a cache; slot 'n' of a context or pool
+ * is only used by the thread holding slot number 'n', so no lock is
+ * needed to take or return a block.  Blocks are moved between the
+ * context and a cache in batches, under the context lock.
+ *
+ * Cached blocks are still counted as in use by the context (and as
+ * allocated from the pool), so quota and water marks are never
+ * exceeded; the accounting overstates the memory in use by at most
+ * TCACHE_BINS * TCACHE_MAXBYTES per thread, or for a pool
+ * TCACHE_MAXITEMS items per thread.
+ */
+typedef struct {
+	size_t			size;	/*%< exact size of the blocks */
+	unsigned int		count;
+	element *		items;
+} tcache_bin_t;
+
+typedef struct {
+	tcache_bin_t		bins[TCACHE_BINS];
+} tcache_t;
+
+typedef struct {
+	unsigned int		count;
+	element *		items;
+} tcache_mag_t;
+
+#define TCACHE_BIN(size)	(((size) / ALIGNMENT_SIZE) % TCACHE_BINS)
+#define TCACHE_DEBUGGING \
+	((isc_mem_debugging & (ISC_MEM_DEBUGTRACE|ISC_MEM_DEBUGRECORD)) != 0)
+
 #define MEM_MAGIC		ISC_MAGIC('M', 'e', 'm', 'C')
 #define VALID_CONTEXT(c)	ISC_MAGIC_VALID(c, MEM_MAGIC)
 
@@ -111,6 +169,17 @@ static isc_once_t		once = ISC_ONCE_INIT;
 static isc_mutex_t		contextslock;
 static isc_mutex_t 		createlock;
 
+#ifdef USE_TCACHE
+/*%
+ * 'tcache_key' points each thread to its entry in 'tcache_used', whose
+ * index is the thread's cache slot.  'tcache_used' is locked by the
+ * create lock.
+ */
+static isc_boolean_t		tcache_keyok = ISC_FALSE;
+static isc_thread_key_t		tcache_key;
+static isc_boolean_t		tcache_used[TCACHE_SLOTS];
+#endif
+
 /*%
  * Total size of lost memory due to a bug of external library.
  * Locked by the global lock.
@@ -161,6 +230,9 @@ struct isc__mem {
 
 	unsigned int		memalloc_failures;
 	ISC_LINK(isc__mem_t)	link;
+
+	/*  ISC_MEMFLAG_THREADCACHE; slot 'n' is only used by its thread. */
+	tcache_t **		tcaches;
 };
 
 #define MEMPOOL_MAGIC		ISC_MAGIC('M', 'E', 'M', 'p')
@@ -183,6 +255,8 @@ struct isc__mempool {
 	unsigned int	fillcount;	/*%< # of items to fetch on each fill */
 	/*%< Stats only. */
 	unsigned int	gets;		/*%< # of requests to this pool */
+	/*%< Per-thread caches; set when the lock is associated. */
+	tcache_mag_t   *tcache;
 	/*%< Debugging only. */
 #if ISC_MEMPOOL_NAMES
 	char		name[16];	/*%< printed name in stats reports */
@@ -310,6 +384,11 @@ isc__mem_printallactive(FILE *file);
 unsigned int
 isc__mem_references(isc_mem_t *ctx0);
 
+static inline void
+mempool_putunlocked(isc__mempool_t *mpctx, void *mem);
+static void
+default_memfree(void *arg, void *ptr);
+
 static struct isc__memmethods {
 	isc_memmethods_t methods;
 
@@ -807,7 +886,20 @@ mem_put(isc__mem_t *ctx, void *mem, size_t size) {
 #endif
 #if ISC_MEM_FILL
 	memset(mem, 0xde, size); /* Mnemonic for "dead". */
-#else
+#endif
+#ifdef HAVE_JEMALLOC
+	/*
+	 * We know the size, so spare jemalloc looking it up.
+	 */
+	if (ctx->memfree == default_memfree) {
+#if ISC_MEM_CHECKOVERRUN
+		size += 1;
+#endif
+		sdallocx(mem, size, 0);
+		return;
+	}
+#endif
+#if !ISC_MEM_FILL && !defined(HAVE_JEMALLOC)
 	UNUSED(size);
 #endif
 	(ctx->memfree)(ctx->arg, mem);
@@ -849,6 +941,305 @@ mem_putstats(isc__mem_t *ctx, void *ptr, size_t size) {
 	}
 }
 
+/*!
+ * Update the over memory state and maxinuse after a memory get.  Returns
+ * ISC_TRUE if the high water callback should be called.
+ *
+ * Caller must hold the context lock.
+ */
+static inline isc_boolean_t
+mem_hiwater(isc__mem_t *ctx) {
+	isc_boolean_t call_water = ISC_FALSE;
+
+	if (ctx->hi_water != 0U && ctx->inuse > ctx->hi_water) {
+		ctx->is_overmem = ISC_TRUE;
+		if (!ctx->hi_called)
+			call_water = ISC_TRUE;
+	}
+	if (ctx->inuse > ctx->maxinuse) {
+		ctx->maxinuse = ctx->inuse;
+		if (ctx->hi_water != 0U && ctx->inuse > ctx->hi_water &&
+		    (isc_mem_debugging & ISC_MEM_DEBUGUSAGE) != 0)
+			fprintf(stderr, "maxinuse = %lu\n",
+				(unsigned long)ctx->inuse);
+	}
+
+	return (call_water);
+}
+
+/*!
+ * Update the over memory state after a memory put.  Returns ISC_TRUE
+ * if the low water callback should be called.
+ *
+ * Caller must hold the context lock.
+ */
+static inline isc_boolean_t
+mem_lowater(isc__mem_t *ctx) {
+	isc_boolean_t call_water = ISC_FALSE;
+
+	/*
+	 * The check against ctx->lo_water == 0 is for the condition
+	 * when the context was pushed over hi_water but then had
+	 * isc_mem_setwater() called with 0 for hi_water and lo_water.
+	 */
+	if ((ctx->inuse < ctx->lo_water) || (ctx->lo_water == 0U)) {
+		ctx->is_overmem = ISC_FALSE;
+		if (ctx->hi_called)
+			call_water = ISC_TRUE;
+	}
+
+	return (call_water);
+}
+
+#ifdef USE_TCACHE
+static void
+tcache_release(void *arg) {
+	unsigned int slot = (unsigned int)((isc_boolean_t *)arg - tcache_used);
+
+	/*
+	 * The thread is exiting.  Whatever it left in its caches is
+	 * taken over by the next thread to be given this slot.
+	 */
+	LOCK(&createlock);
+	tcache_used[slot] = ISC_FALSE;
+	UNLOCK(&createlock);
+}
+
+/*!
+ * Return the cache slot of the calling thread, giving it one if it has
+ * none yet, or -1 if all the slots are taken.
+ */
+static int
+tcache_slot(void) {
+	void *value;
+	unsigned int slot;
+
+	value = isc_thread_key_getspecific(tcache_key);
+	if (ISC_LIKELY(value != NULL))
+		return ((int)((isc_boolean_t *)value - tcache_used));
+
+	LOCK(&createlock);
+	for (slot = 0; slot < TCACHE_SLOTS; slot++) {
+		if (!tcache_used[slot]) {
+			tcache_used[slot] = ISC_TRUE;
+			break;
+		}
+	}
+	UNLOCK(&createlock);
+	if (slot == TCACHE_SLOTS)
+		return (-1);
+
+	if (isc_thread_key_setspecific(tcache_key, &tcache_used[slot]) != 0) {
+		LOCK(&createlock);
+		tcache_used[slot] = ISC_FALSE;
+		UNLOCK(&createlock);
+		return (-1);
+	}
+	return ((int)slot);
+}
+
+/*!
+ * The number of blocks of 'size' bytes a thread may keep.
+ */
+static inline unsigned int
+tcache_max(size_t size) {
+	size_t n = TCACHE_MAXBYTES / size;
+
+	if (n > TCACHE_MAXITEMS)
+		n = TCACHE_MAXITEMS;
+	if (n < 2)
+		n = 2;
+	return ((unsigned int)n);
+}
+
+/*!
+ * Return the calling thread's cache for 'ctx', or NULL.
+ */
+static tcache_t *
+tcache_get(isc__mem_t *ctx) {
+	tcache_t *tc;
+	int slot;
+
+	slot = tcache_slot();
+	if (slot < 0)
+		return (NULL);
+
+	tc = ctx->tcaches[slot];
+	if (ISC_UNLIKELY(tc == NULL)) {
+		tc = (ctx->memalloc)(ctx->arg, sizeof(*tc));
+		if (tc == NULL)
+			return (NULL);
+		memset(tc, 0, sizeof(*tc));
+		ctx->tcaches[slot] = tc;
+	}
+	return (tc);
+}
+
+/*!
+ * Take up to 'n' blocks of 'bin->size' bytes from 'ctx' into 'bin'.
+ * Returns ISC_TRUE if the high water callback should be called.
+ */
+static isc_boolean_t
+tcache_fill(isc__mem_t *ctx, tcache_bin_t *bin, unsigned int n) {
+	isc_boolean_t call_water;
+	element *item;
+
+	MCTXLOCK(ctx, &ctx->lock);
+	while (n-- > 0) {
+		if ((ctx->flags & ISC_MEMFLAG_INTERNAL) != 0) {
+			item = mem_getunlocked(ctx, bin->size);
+		} else {
+			item = mem_get(ctx, bin->size);
+			if (item != NULL)
+				mem_getstats(ctx, bin->size);
+		}
+		if (item == NULL)
+			break;
+		item->next = bin->items;
+		bin->items = item;
+		bin->count++;
+	}
+	call_water = mem_hiwater(ctx);
+	MCTXUNLOCK(ctx, &ctx->lock);
+
+	return (call_water);
+}
+
+/*!
+ * Return up to 'n' blocks from 'bin' to 'ctx'.  Returns ISC_TRUE if
+ * the low water callback should be called.
+ */
+static isc_boolean_t
+tcache_flush(isc__mem_t *ctx, tcache_bin_t *bin, unsigned int n) {
+	isc_boolean_t call_water;
+	element *item;
+
+	MCTXLOCK(ctx, &ctx->lock);
+	while (n-- > 0 && bin->items != NULL) {
+		item = bin->items;
+		bin->items = item->next;
+		bin->count--;
+		if ((ctx->flags & ISC_MEMFLAG_INTERNAL) != 0) {
+			mem_putunlocked(ctx, item, bin->size);
+		} else {
+			mem_putstats(ctx, item, bin->size);
+			mem_put(ctx, item, bin->size);
+		}
+	}
+	call_water = mem_lowater(ctx);
+	MCTXUNLOCK(ctx, &ctx->lock);
+
+	return (call_water);
+}
+
+/*!
+ * Take a block of 'size' bytes from the calling thread's cache,
+ * refilling it from 'ctx' if it is empty.  Returns NULL if the block
+ * must be taken from 'ctx' directly.
+ */
+static void *
+tcache_memget(isc__mem_t *ctx, size_t size) {
+	tcache_t *tc;
+	tcache_bin_t *bin;
+	element *item;
+
+	tc = tcache_get(ctx);
+	if (tc == NULL)
+		return (NULL);
+
+	bin = &tc->bins[TCACHE_BIN(size)];
+	if (bin->count == 0) {
+		bin->size = size;
+		if (tcache_fill(ctx, bin, tcache_max(size) / 2) &&
+		    ctx->water != NULL)
+			(ctx->water)(ctx->water_arg, ISC_MEM_HIWATER);
+	} else if (bin->size != size)
+		return (NULL);
+
+	item = bin->items;
+	if (item == NULL)
+		return (NULL);
+	bin->items = item->next;
+	bin->count--;
+
+#if ISC_MEM_FILL
+	memset(item, 0xbe, size); /* Mnemonic for "beef". */
+#endif
+	return (item);
+}
+
+/*!
+ * Put a block of 'size' bytes into the calling thread's cache,
+ * returning half of the cache to 'ctx' if it is full.  Returns
+ * ISC_FALSE if the block must be returned to 'ctx' directly.
+ */
+static isc_boolean_t
+tcache_memput(isc__mem_t *ctx, void *mem, size_t size) {
+	tcache_t *tc;
+	tcache_bin_t *bin;
+	element *item = mem;
+	unsigned int max;
+	isc_boolean_t call_water = ISC_FALSE;
+
+	tc = tcache_get(ctx);
+	if (tc == NULL)
+		return (ISC_FALSE);
+
+	bin = &tc->bins[TCACHE_BIN(size)];
+	if (ctx->is_overmem) {
+		/*
+		 * Give back everything we can while over the high
+		 * water mark.
+		 */
+		if (bin->count != 0)
+			call_water = tcache_flush(ctx, bin, bin->count);
+		if (call_water && ctx->water != NULL)
+			(ctx->water)(ctx->water_arg, ISC_MEM_LOWATER);
+		return (ISC_FALSE);
+	}
+	if (bin->count != 0 && bin->size != size)
+		return (ISC_FALSE);
+
+	max = tcache_max(size);
+	if (bin->count >= max) {
+		if (tcache_flush(ctx, bin, max / 2) && ctx->water != NULL)
+			(ctx->water)(ctx->water_arg, ISC_MEM_LOWATER);
+	}
+
+#if ISC_MEM_FILL
+	memset(mem, 0xde, size); /* Mnemonic for "dead". */
+#endif
+	bin->size = size;
+	item->next = bin->items;
+	bin->items = item;
+	bin->count++;
+
+	return (ISC_TRUE);
+}
+
+/*!
+ * Return all the blocks in every thread's cache to 'ctx' and free the
+ * caches.  No other thread may be using 'ctx'.
+ */
+static void
+tcache_destroy(isc__mem_t *ctx) {
+	tcache_t *tc;
+	unsigned int i, j;
+
+	for (i = 0; i < TCACHE_SLOTS; i++) {
+		tc = ctx->tcaches[i];
+		if (tc == NULL)
+			continue;
+		for (j = 0; j < TCACHE_BINS; j++)
+			(void)tcache_flush(ctx, &tc->bins[j],
+					   tc->bins[j].count);
+		(ctx->memfree)(ctx->arg, tc);
+	}
+	(ctx->memfree)(ctx->arg, ctx->tcaches);
+	ctx->tcaches = NULL;
+}
+#endif /* USE_TCACHE */
+
 /*
  * Private.
  */
@@ -873,6 +1264,10 @@ initialize_action(void) {
 	RUNTIME_CHECK(isc_mutex_init(&contextslock) == ISC_R_SUCCESS);
 	ISC_LIST_INIT(contexts);
 	totallost = 0;
+#ifdef USE_TCACHE
+	tcache_keyok = ISC_TF(isc_thread_key_create(&tcache_key,
+						    tcache_release) == 0);
+#endif
 }
 
 /*
@@ -957,6 +1352,7 @@ isc_mem_createx2(size_t init_max_size, size_t target_size,
 	ctx->basic_table_size = 0;
 	ctx->lowest = NULL;
 	ctx->highest = NULL;
+	ctx->tcaches = NULL;
 
 	ctx->stats = (memalloc)(arg,
 				(ctx->max_size+1) * sizeof(struct stats));
@@ -996,6 +1392,24 @@ isc_mem_createx2(size_t init_max_size, size_t target_size,
 	}
 #endif
 
+#ifdef USE_TCACHE
+	/*
+	 * Per-thread caches are only worth having if the context is
+	 * locked.
+	 */
+	if ((flags & ISC_MEMFLAG_THREADCACHE) != 0 &&
+	    (flags & ISC_MEMFLAG_NOLOCK) == 0 && tcache_keyok)
+	{
+		ctx->tcaches = (memalloc)(arg,
+					  TCACHE_SLOTS * sizeof(tcache_t *));
+		if (ctx->tcaches == NULL) {
+			result = ISC_R_NOMEMORY;
+			goto error;
+		}
+		memset(ctx->tcaches, 0, TCACHE_SLOTS * sizeof(tcache_t *));
+	}
+#endif
+
 	ctx->memalloc_failures = 0;
 
 	LOCK(&contextslock);
@@ -1028,6 +1442,11 @@ destroy(isc__mem_t *ctx) {
 	unsigned int i;
 	isc_ondestroy_t ondest;
 
+#ifdef USE_TCACHE
+	if (ctx->tcaches != NULL)
+		tcache_destroy(ctx);
+#endif
+
 	LOCK(&contextslock);
 	ISC_LIST_UNLINK(contexts, ctx, link);
 	totallost += ctx->inuse;
@@ -1255,6 +1674,16 @@ isc___mem_get(isc_mem_t *ctx0, size_t size FLARG) {
 	if ((isc_mem_debugging & (ISC_MEM_DEBUGSIZE|ISC_MEM_DEBUGCTX)) != 0)
 		return (isc__mem_allocate(ctx0, size FLARG_PASS));
 
+#ifdef USE_TCACHE
+	if (ctx->tcaches != NULL && size >= sizeof(element) &&
+	    size <= TCACHE_MAXSIZE && !TCACHE_DEBUGGING)
+	{
+		ptr = tcache_memget(ctx, size);
+		if (ptr != NULL)
+			return (ptr);
+	}
+#endif
+
 	if ((ctx->flags & ISC_MEMFLAG_INTERNAL) != 0) {
 		MCTXLOCK(ctx, &ctx->lock);
 		ptr = mem_getunlocked(ctx, size);
@@ -1266,18 +1695,7 @@ isc___mem_get(isc_mem_t *ctx0, size_t size FLARG) {
 	}
 
 	ADD_TRACE(ctx, ptr, size, file, line);
-	if (ctx->hi_water != 0U && ctx->inuse > ctx->hi_water) {
-		ctx->is_overmem = ISC_TRUE;
-		if (!ctx->hi_called)
-			call_water = ISC_TRUE;
-	}
-	if (ctx->inuse > ctx->maxinuse) {
-		ctx->maxinuse = ctx->inuse;
-		if (ctx->hi_water != 0U && ctx->inuse > ctx->hi_water &&
-		    (isc_mem_debugging & ISC_MEM_DEBUGUSAGE) != 0)
-			fprintf(stderr, "maxinuse = %lu\n",
-				(unsigned long)ctx->inuse);
-	}
+	call_water = mem_hiwater(ctx);
 	MCTXUNLOCK(ctx, &ctx->lock);
 
 	if (call_water && (ctx->water != NULL))
@@ -1308,6 +1726,13 @@ isc___mem_put(isc_mem_t *ctx0, void *ptr, size_t size FLARG) {
 		return;
 	}
 
+#ifdef USE_TCACHE
+	if (ctx->tcaches != NULL && size >= sizeof(element) &&
+	    size <= TCACHE_MAXSIZE && !TCACHE_DEBUGGING &&
+	    tcache_memput(ctx, ptr, size))
+		return;
+#endif
+
 	MCTXLOCK(ctx, &ctx->lock);
 
 	DELETE_TRACE(ctx, ptr, size, file, line);
@@ -1319,17 +1744,7 @@ isc___mem_put(isc_mem_t *ctx0, void *ptr, size_t size FLARG) {
 		mem_put(ctx, ptr, size);
 	}
 
-	/*
-	 * The check against ctx->lo_water == 0 is for the condition
-	 * when the context was pushed over hi_water but then had
-	 * isc_mem_setwater() called with 0 for hi_water and lo_water.
-	 */
-	if ((ctx->inuse < ctx->lo_water) || (ctx->lo_water == 0U)) {
-		ctx->is_overmem = ISC_FALSE;
-		if (ctx->hi_called)
-			call_water = ISC_TRUE;
-	}
-
+	call_water = mem_lowater(ctx);
 	MCTXUNLOCK(ctx, &ctx->lock);
 
 	if (call_water && (ctx->water != NULL))
@@ -1864,6 +2279,7 @@ isc__mempool_create(isc_mem_t *mctx0, size_t size, isc_mempool_t **mpctxp) {
 	mpctx->name[0] = 0;
 #endif
 	mpctx->items = NULL;
+	mpctx->tcache = NULL;
 
 	*mpctxp = (isc_mempool_t *)mpctx;
 
@@ -1906,6 +2322,30 @@ isc__mempool_destroy(isc_mempool_t **mpctxp) {
 	REQUIRE(mpctxp != NULL);
 	mpctx = (isc__mempool_t *)*mpctxp;
 	REQUIRE(VALID_MEMPOOL(mpctx));
+
+	mctx = mpctx->mctx;
+
+#ifdef USE_TCACHE
+	/*
+	 * Return the items cached by each thread to the pool.
+	 */
+	if (mpctx->tcache != NULL) {
+		unsigned int i;
+
+		LOCK(mpctx->lock);
+		for (i = 0; i < TCACHE_SLOTS; i++) {
+			while (mpctx->tcache[i].items != NULL) {
+				item = mpctx->tcache[i].items;
+				mpctx->tcache[i].items = item->next;
+				mempool_putunlocked(mpctx, item);
+			}
+		}
+		UNLOCK(mpctx->lock);
+		(mctx->memfree)(mctx->arg, mpctx->tcache);
+		mpctx->tcache = NULL;
+	}
+#endif
+
 #if ISC_MEMPOOL_NAMES
 	if (mpctx->allocated > 0)
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
@@ -1915,8 +2355,6 @@ isc__mempool_destroy(isc_mempool_t **mpctxp) {
 #endif
 	REQUIRE(mpctx->allocated == 0);
 
-	mctx = mpctx->mctx;
-
 	lock = mpctx->lock;
 
 	if (lock != NULL)
@@ -1969,29 +2407,41 @@ isc__mempool_associatelock(isc_mempool_t *mpctx0, isc_mutex_t *lock) {
 	REQUIRE(lock != NULL);
 
 	mpctx->lock = lock;
+
+#ifdef USE_TCACHE
+	/*
+	 * A pool with a lock may be shared by several threads; give
+	 * each of them a cache if the memory context wants it.
+	 */
+	if (mpctx->mctx->tcaches != NULL) {
+		isc__mem_t *mctx = mpctx->mctx;
+
+		mpctx->tcache = (mctx->memalloc)(mctx->arg, TCACHE_SLOTS *
+						 sizeof(tcache_mag_t));
+		if (mpctx->tcache != NULL)
+			memset(mpctx->tcache, 0,
+			       TCACHE_SLOTS * sizeof(tcache_mag_t));
+	}
+#endif
 }
 
-void *
-isc___mempool_get(isc_mempool_t *mpctx0 FLARG) {
-	isc__mempool_t *mpctx = (isc__mempool_t *)mpctx0;
+/*!
+ * Take an item from 'mpctx', filling its free list from the memory
+ * context if need be.
+ *
+ * Caller must hold the pool lock, if any.
+ */
+static inline element *
+mempool_getunlocked(isc__mempool_t *mpctx) {
+	isc__mem_t *mctx = mpctx->mctx;
 	element *item;
-	isc__mem_t *mctx;
 	unsigned int i;
 
-	REQUIRE(VALID_MEMPOOL(mpctx));
-
-	mctx = mpctx->mctx;
-
-	if (mpctx->lock != NULL)
-		LOCK(mpctx->lock);
-
 	/*
 	 * Don't let the caller go over quota
 	 */
-	if (ISC_UNLIKELY(mpctx->allocated >= mpctx->maxalloc)) {
-		item = NULL;
-		goto out;
-	}
+	if (ISC_UNLIKELY(mpctx->allocated >= mpctx->maxalloc))
+		return (NULL);
 
 	if (ISC_UNLIKELY(mpctx->items == NULL)) {
 		/*
@@ -2021,7 +2471,7 @@ isc___mempool_get(isc_mempool_t *mpctx0 FLARG) {
 	 */
 	item = mpctx->items;
 	if (ISC_UNLIKELY(item == NULL))
-		goto out;
+		return (NULL);
 
 	mpctx->items = item->next;
 	INSIST(mpctx->freecount > 0);
@@ -2029,11 +2479,152 @@ isc___mempool_get(isc_mempool_t *mpctx0 FLARG) {
 	mpctx->gets++;
 	mpctx->allocated++;
 
- out:
+	return (item);
+}
+
+/*!
+ * Return an item to 'mpctx', or to the memory context if the pool's
+ * free list is full.
+ *
+ * Caller must hold the pool lock, if any.
+ */
+static inline void
+mempool_putunlocked(isc__mempool_t *mpctx, void *mem) {
+	isc__mem_t *mctx = mpctx->mctx;
+	element *item;
+
+	INSIST(mpctx->allocated > 0);
+	mpctx->allocated--;
+
+	/*
+	 * If our free list is full, return this to the mctx directly.
+	 */
+	if (mpctx->freecount >= mpctx->freemax) {
+		MCTXLOCK(mctx, &mctx->lock);
+		if ((mctx->flags & ISC_MEMFLAG_INTERNAL) != 0) {
+			mem_putunlocked(mctx, mem, mpctx->size);
+		} else {
+			mem_putstats(mctx, mem, mpctx->size);
+			mem_put(mctx, mem, mpctx->size);
+		}
+		MCTXUNLOCK(mctx, &mctx->lock);
+		return;
+	}
+
+	/*
+	 * Otherwise, attach it to our free list and bump the counter.
+	 */
+	mpctx->freecount++;
+	item = (element *)mem;
+	item->next = mpctx->items;
+	mpctx->items = item;
+}
+
+#ifdef USE_TCACHE
+/*!
+ * Take an item from the calling thread's cache for 'mpctx', refilling
+ * the cache from the pool if it is empty.  Items in the cache count as
+ * allocated from the pool, so 'maxalloc' still holds.
+ */
+static element *
+tcache_poolget(isc__mempool_t *mpctx) {
+	tcache_mag_t *mag;
+	element *item;
+	unsigned int n;
+	int slot;
+
+	slot = tcache_slot();
+	if (slot < 0)
+		return (NULL);
+	mag = &mpctx->tcache[slot];
+
+	if (mag->count == 0) {
+		n = tcache_max(mpctx->size) / 2;
+		LOCK(mpctx->lock);
+		while (n-- > 0) {
+			item = mempool_getunlocked(mpctx);
+			if (item == NULL)
+				break;
+			item->next = mag->items;
+			mag->items = item;
+			mag->count++;
+		}
+		UNLOCK(mpctx->lock);
+	}
+
+	item = mag->items;
+	if (item != NULL) {
+		mag->items = item->next;
+		mag->count--;
+	}
+	return (item);
+}
+
+/*!
+ * Put an item into the calling thread's cache for 'mpctx', returning
+ * half of the cache to the pool if it is full.
+ */
+static isc_boolean_t
+tcache_poolput(isc__mempool_t *mpctx, void *mem) {
+	tcache_mag_t *mag;
+	element *item;
+	unsigned int max, n;
+	int slot;
+
+	slot = tcache_slot();
+	if (slot < 0)
+		return (ISC_FALSE);
+	mag = &mpctx->tcache[slot];
+
+	max = tcache_max(mpctx->size);
+	if (mag->count >= max) {
+		LOCK(mpctx->lock);
+		for (n = max / 2; n > 0; n--) {
+			item = mag->items;
+			mag->items = item->next;
+			mag->count--;
+			mempool_putunlocked(mpctx, item);
+		}
+		UNLOCK(mpctx->lock);
+	}
+
+	item = mem;
+	item->next = mag->items;
+	mag->items = item;
+	mag->count++;
+
+	return (ISC_TRUE);
+}
+#endif /* USE_TCACHE */
+
+void *
+isc___mempool_get(isc_mempool_t *mpctx0 FLARG) {
+	isc__mempool_t *mpctx = (isc__mempool_t *)mpctx0;
+	element *item;
+#if ISC_MEM_TRACKLINES
+	isc__mem_t *mctx;
+#endif
+
+	REQUIRE(VALID_MEMPOOL(mpctx));
+
+#ifdef USE_TCACHE
+	if (mpctx->tcache != NULL && !TCACHE_DEBUGGING) {
+		item = tcache_poolget(mpctx);
+		if (item != NULL)
+			return (item);
+	}
+#endif
+
+	if (mpctx->lock != NULL)
+		LOCK(mpctx->lock);
+
+	item = mempool_getunlocked(mpctx);
+
 	if (mpctx->lock != NULL)
 		UNLOCK(mpctx->lock);
 
 #if ISC_MEM_TRACKLINES
+	mctx = mpctx->mctx;
 	if (((isc_mem_debugging & TRACE_OR_RECORD) != 0) && item != NULL) {
 		MCTXLOCK(mctx, &mctx->lock);
 		ADD_TRACE(mctx, item, mpctx->size, file, line);
@@ -2048,21 +2639,21 @@ isc___mempool_get(isc_mempool_t *mpctx0 FLARG) {
 void
 isc___mempool_put(isc_mempool_t *mpctx0, void *mem FLARG) {
 	isc__mempool_t *mpctx = (isc__mempool_t *)mpctx0;
+#if ISC_MEM_TRACKLINES
 	isc__mem_t *mctx;
-	element *item;
+#endif
 
 	REQUIRE(VALID_MEMPOOL(mpctx));
 	REQUIRE(mem != NULL);
 
-	mctx = mpctx->mctx;
-
-	if (mpctx->lock != NULL)
-		LOCK(mpctx->lock);
-
-	INSIST(mpctx->allocated > 0);
-	mpctx->allocated--;
+#ifdef USE_TCACHE
+	if (mpctx->tcache != NULL && !TCACHE_DEBUGGING &&
+	    tcache_poolput(mpctx, mem))
+		return;
+#endif
 
 #if ISC_MEM_TRACKLINES
+	mctx = mpctx->mctx;
 	if ((isc_mem_debugging & TRACE_OR_RECORD) != 0) {
 		MCTXLOCK(mctx, &mctx->lock);
 		DELETE_TRACE(mctx, mem, mpctx->size, file, line);
@@ -2070,30 +2661,10 @@ isc___mempool_put(isc_mempool_t *mpctx0, void *mem FLARG) {
 	}
 #endif /* ISC_MEM_TRACKLINES */
 
-	/*
-	 * If our free list is full, return this to the mctx directly.
-	 */
-	if (mpctx->freecount >= mpctx->freemax) {
-		MCTXLOCK(mctx, &mctx->lock);
-		if ((mctx->flags & ISC_MEMFLAG_INTERNAL) != 0) {
-			mem_putunlocked(mctx, mem, mpctx->size);
-		} else {
-			mem_putstats(mctx, mem, mpctx->size);
-			mem_put(mctx, mem, mpctx->size);
-		}
-		MCTXUNLOCK(mctx, &mctx->lock);
-		if (mpctx->lock != NULL)
-			UNLOCK(mpctx->lock);
-		return;
-	}
+	if (mpctx->lock != NULL)
+		LOCK(mpctx->lock);
 
-	/*
-	 * Otherwise, attach it to our free list and bump the counter.
-	 */
-	mpctx->freecount++;
-	item = (element *)mem;
-	item->next = mpctx->items;
-	mpctx->items = item;
+	mempool_putunlocked(mpctx, mem);
 
 	if (mpctx->lock != NULL)
 		UNLOCK(mpctx->lock);
@@ -2200,6 +2771,21 @@ isc__mempool_getallocated(isc_mempool_t *mpctx0) {
 		LOCK(mpctx->lock);
 
 	allocated = mpctx->allocated;
+#ifdef USE_TCACHE
+	/*
+	 * Items sitting in per-thread caches are free as far as the
+	 * pool's users are concerned.  The cache counts are updated by
+	 * their owning threads without the pool lock, so this may be
+	 * momentarily stale, but it is exact once those threads have
+	 * synchronized with the caller.
+	 */
+	if (mpctx->tcache != NULL) {
+		unsigned int i;
+
+		for (i = 0; i < TCACHE_SLOTS; i++)
+			allocated -= mpctx->tcache[i].count;
+	}
+#endif
 
 	if (mpctx->lock != NULL)
 		UNLOCK(mpctx->lock);
@@ -2331,6 +2917,53 @@ typedef struct summarystat {
 	isc_uint64_t	contextsize;
 } summarystat_t;
 
+#if defined(HAVE_JEMALLOC) && (defined(HAVE_LIBXML2) || defined(HAVE_JSON))
+/*
+ * Statistics kept by jemalloc itself; see the "stats." section of
+ * jemalloc(3).  'allocated' is what the application holds, the others
+ * how much memory jemalloc needs to provide that.
+ */
+typedef struct mallocstat {
+	const char *	name;
+	const char *	ctl;
+} mallocstat_t;
+
+static const mallocstat_t mallocstats[] = {
+	{ "MallocAllocated",	"stats.allocated" },
+	{ "MallocActive",	"stats.active" },
+	{ "MallocMetadata",	"stats.metadata" },
+	{ "MallocResident",	"stats.resident" },
+	{ "MallocMapped",	"stats.mapped" },
+};
+
+#define MALLOCSTATS (sizeof(mallocstats) / sizeof(mallocstats[0]))
+
+/*%
+ * Fetch the allocator statistics into 'values', returning ISC_FALSE
+ * if jemalloc was built without statistics.
+ */
+static isc_boolean_t
+malloc_getstats(isc_uint64_t values[MALLOCSTATS]) {
+	isc_uint64_t epoch = 1;
+	size_t len, value;
+	unsigned int i;
+
+	/*
+	 * jemalloc caches its statistics until the epoch is advanced.
+	 */
+	len = sizeof(epoch);
+	(void)mallctl("epoch", &epoch, &len, &epoch, len);
+
+	for (i = 0; i < MALLOCSTATS; i++) {
+		len = sizeof(value);
+		if (mallctl(mallocstats[i].ctl, &value, &len, NULL, 0) != 0)
+			return (ISC_FALSE);
+		values[i] = value;
+	}
+	return (ISC_TRUE);
+}
+#endif /* HAVE_JEMALLOC && (HAVE_LIBXML2 || HAVE_JSON) */
+
 #ifdef HAVE_LIBXML2
 #define TRY0(a) do { xmlrc = (a); if (xmlrc < 0) goto error; } while(0)
 static int
@@ -2435,6 +3068,10 @@ isc_mem_renderxml(xmlTextWriterPtr writer) {
 	summarystat_t summary;
 	isc_uint64_t lost;
 	int xmlrc;
+#ifdef HAVE_JEMALLOC
+	isc_uint64_t values[MALLOCSTATS];
+	unsigned int i;
+#endif
 
 	memset(&summary, 0, sizeof(summary));
 
@@ -2489,6 +3126,19 @@ isc_mem_renderxml(xmlTextWriterPtr writer) {
 					    lost));
 	TRY0(xmlTextWriterEndElement(writer)); /* Lost */
 
+#ifdef HAVE_JEMALLOC
+	if (malloc_getstats(values)) {
+		for (i = 0; i < MALLOCSTATS; i++) {
+			TRY0(xmlTextWriterStartElement(writer,
+				ISC_XMLCHAR mallocstats[i].name));
+			TRY0(xmlTextWriterWriteFormatString(writer,
+					    "%" ISC_PRINT_QUADFORMAT "u",
+					    values[i]));
+			TRY0(xmlTextWriterEndElement(writer));
+		}
+	}
+#endif
+
 	TRY0(xmlTextWriterEndElement(writer)); /* summary */
  error:
 	return (xmlrc);
@@ -2604,6 +3254,10 @@ isc_mem_renderjson(json_object *memobj) {
 	summarystat_t summary;
 	isc_uint64_t lost;
 	json_object *ctxarray, *obj;
+#ifdef HAVE_JEMALLOC
+	isc_uint64_t values[MALLOCSTATS];
+	unsigned int i;
+#endif
 
 	memset(&summary, 0, sizeof(summary));
 	RUNTIME_CHECK(isc_once_do(&once, initialize_action) == ISC_R_SUCCESS);
@@ -2644,6 +3298,17 @@ isc_mem_renderjson(json_object *memobj) {
 	CHECKMEM(obj);
 	json_object_object_add(memobj, "Lost", obj);
 
+#ifdef HAVE_JEMALLOC
+	if (malloc_getstats(values)) {
+		for (i = 0; i < MALLOCSTATS; i++) {
+			obj = json_object_new_int64(values[i]);
+			CHECKMEM(obj);
+			json_object_object_add(memobj, mallocstats[i].name,
+					       obj);
+		}
+	}
+#endif
+
 	json_object_object_add(memobj, "contexts", ctxarray);
 	return (ISC_R_SUCCESS);
 
@@ -22,3 +22,10 @@ void isc_thread_setname(isc_thread_t thread, const char *name) {
 	UNUSED(thread);
 	UNUSED(name);
 }
+
+isc_result_t
+isc_thread_setaffinity(isc_thread_t thread, int cpu) {
+	UNUSED(thread);
+	UNUSED(cpu);
+	return (ISC_R_NOTIMPLEMENTED);
+}
@@ -42,6 +42,19 @@ isc_thread_yield(void);
 void
 isc_thread_setname(isc_thread_t thread, const char *name);
 
+isc_result_t
+isc_thread_setaffinity(isc_thread_t thread, int cpu);
+/*%<
+ * Restrict 'thread' to run on CPU number 'cpu' only, or let it run on
+ * any CPU if 'cpu' is negative.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS
+ *\li	#ISC_R_RANGE		'cpu' is too large for this system
+ *\li	#ISC_R_FAILURE		the system refused, e.g. 'cpu' is offline
+ *\li	#ISC_R_NOTIMPLEMENTED
+ */
+
 /* XXX We could do fancier error handling... */
 
 #define isc_thread_join(t, rp) \
@@ -86,6 +86,31 @@ isc_thread_setname(isc_thread_t thread, const char *name) {
 #endif
 }
 
+isc_result_t
+isc_thread_setaffinity(isc_thread_t thread, int cpu) {
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SET)
+	cpu_set_t set;
+	int i;
+
+	CPU_ZERO(&set);
+	if (cpu < 0) {
+		for (i = 0; i < CPU_SETSIZE; i++)
+			CPU_SET(i, &set);
+	} else if (cpu < CPU_SETSIZE) {
+		CPU_SET(cpu, &set);
+	} else
+		return (ISC_R_RANGE);
+
+	if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0)
+		return (ISC_R_FAILURE);
+	return (ISC_R_SUCCESS);
+#else
+	UNUSED(thread);
+	UNUSED(cpu);
+	return (ISC_R_NOTIMPLEMENTED);
+#endif
+}
+
 void
 isc_thread_yield(void) {
 #if defined(HAVE_SCHED_YIELD)
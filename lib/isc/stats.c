@@ -13,15 +13,21 @@
 #include <config.h>
 
 #include <string.h>
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h> /* uintptr_t */
+#endif
 
 #include <isc/atomic.h>
 #include <isc/buffer.h>
 #include <isc/magic.h>
 #include <isc/mem.h>
+#include <isc/once.h>
+#include <isc/os.h>
 #include <isc/platform.h>
 #include <isc/print.h>
 #include <isc/rwlock.h>
 #include <isc/stats.h>
+#include <isc/thread.h>
 #include <isc/util.h>
 
 #if defined(ISC_PLATFORM_HAVESTDATOMIC)
@@ -96,11 +102,38 @@ typedef isc_uint64_t isc_stat_t;
 #endif
 #endif
 
+/*%
+ * Sharded statistics (ISC_STATSCREATE_SHARDED) keep one copy of the
+ * counters per shard, and each thread updates the copy chosen by its
+ * shard number, so that threads on different CPUs do not keep taking
+ * the same cache lines from each other.  The copies are summed when the
+ * counters are dumped.  Each copy is padded to a multiple of
+ * ISC_STATS_LINESIZE bytes, and the first one is aligned to it.
+ *
+ * Threads are numbered in the order in which they first update a
+ * sharded counter; thread 'n' uses shard 'n % nshards'.  Shards are
+ * not exclusive to a thread, so the updates are still atomic.
+ */
+#define ISC_STATS_LINESIZE		64
+#define ISC_STATS_MAXSHARDS		64
+
+#ifdef ISC_PLATFORM_USETHREADS
+static isc_once_t		shard_once = ISC_ONCE_INIT;
+static isc_boolean_t		shard_keyok = ISC_FALSE;
+static isc_thread_key_t		shard_key;
+static isc_mutex_t		shard_lock;
+static unsigned int		shard_next = 0;	/* locked by shard_lock */
+#endif
+
 struct isc_stats {
 	/*% Unlocked */
 	unsigned int	magic;
 	isc_mem_t	*mctx;
 	int		ncounters;
+	unsigned int	nshards;
+	int		stride;		/*%< counters per shard, padded */
+	size_t		allocated;	/*%< size of 'base' */
+	void		*base;
 
 	isc_mutex_t	lock;
 	unsigned int	references; /* locked by lock */
@@ -128,13 +161,76 @@ struct isc_stats {
 	isc_uint64_t	*copiedcounters;
 };
 
+#ifdef ISC_PLATFORM_USETHREADS
+static void
+shard_initialize(void) {
+	RUNTIME_CHECK(isc_mutex_init(&shard_lock) == ISC_R_SUCCESS);
+	shard_keyok = ISC_TF(isc_thread_key_create(&shard_key, NULL) == 0);
+}
+#endif
+
+/*!
+ * Return the index of the first counter of the calling thread's shard.
+ */
+static inline int
+shard_offset(isc_stats_t *stats) {
+#ifdef ISC_PLATFORM_USETHREADS
+	unsigned int thread;
+	void *value;
+
+	if (stats->nshards == 1 || !shard_keyok)
+		return (0);
+
+	/*
+	 * The key holds the thread number plus one, so that NULL means
+	 * that the thread has none yet.
+	 */
+	value = isc_thread_key_getspecific(shard_key);
+	if (ISC_UNLIKELY(value == NULL)) {
+		LOCK(&shard_lock);
+		thread = shard_next++;
+		UNLOCK(&shard_lock);
+		value = (void *)((uintptr_t)thread + 1);
+		(void)isc_thread_key_setspecific(shard_key, value);
+	}
+	thread = (unsigned int)((uintptr_t)value - 1);
+
+	return ((int)(thread % stats->nshards) * stats->stride);
+#else
+	UNUSED(stats);
+
+	return (0);
+#endif
+}
+
 static isc_result_t
-create_stats(isc_mem_t *mctx, int ncounters, isc_stats_t **statsp) {
+create_stats(isc_mem_t *mctx, int ncounters, unsigned int options,
+	     isc_stats_t **statsp)
+{
 	isc_stats_t *stats;
 	isc_result_t result = ISC_R_SUCCESS;
+	unsigned int nshards = 1;
+	int stride = ncounters;
+	int perline = ISC_STATS_LINESIZE / sizeof(isc_stat_t);
 
 	REQUIRE(statsp != NULL && *statsp == NULL);
 
+#ifdef ISC_PLATFORM_USETHREADS
+	if ((options & ISC_STATSCREATE_SHARDED) != 0) {
+		RUNTIME_CHECK(isc_once_do(&shard_once, shard_initialize) ==
+			      ISC_R_SUCCESS);
+		nshards = isc_os_ncpus();
+		if (nshards > ISC_STATS_MAXSHARDS)
+			nshards = ISC_STATS_MAXSHARDS;
+		if (!shard_keyok)
+			nshards = 1;
+	}
+#else
+	UNUSED(options);
+#endif
+	if (nshards > 1)
+		stride = (ncounters + perline - 1) / perline * perline;
+
 	stats = isc_mem_get(mctx, sizeof(*stats));
 	if (stats == NULL)
 		return (ISC_R_NOMEMORY);
@@ -143,11 +239,24 @@ create_stats(isc_mem_t *mctx, int ncounters, isc_stats_t **statsp) {
 	if (result != ISC_R_SUCCESS)
 		goto clean_stats;
 
-	stats->counters = isc_mem_get(mctx, sizeof(isc_stat_t) * ncounters);
-	if (stats->counters == NULL) {
+	stats->nshards = nshards;
+	stats->stride = stride;
+	stats->allocated = sizeof(isc_stat_t) * stride * nshards;
+	if (nshards > 1)
+		stats->allocated += ISC_STATS_LINESIZE;
+	stats->base = isc_mem_get(mctx, stats->allocated);
+	if (stats->base == NULL) {
 		result = ISC_R_NOMEMORY;
 		goto clean_mutex;
 	}
+	if (nshards > 1) {
+		uintptr_t addr = (uintptr_t)stats->base;
+
+		addr = (addr + ISC_STATS_LINESIZE - 1) &
+			~(uintptr_t)(ISC_STATS_LINESIZE - 1);
+		stats->counters = (isc_stat_t *)addr;
+	} else
+		stats->counters = stats->base;
 	stats->copiedcounters = isc_mem_get(mctx,
 					    sizeof(isc_uint64_t) * ncounters);
 	if (stats->copiedcounters == NULL) {
@@ -162,7 +271,7 @@ create_stats(isc_mem_t *mctx, int ncounters, isc_stats_t **statsp) {
 #endif
 
 	stats->references = 1;
-	memset(stats->counters, 0, sizeof(isc_stat_t) * ncounters);
+	memset(stats->counters, 0, sizeof(isc_stat_t) * stride * nshards);
 	stats->mctx = NULL;
 	isc_mem_attach(mctx, &stats->mctx);
 	stats->ncounters = ncounters;
@@ -173,7 +282,7 @@ create_stats(isc_mem_t *mctx, int ncounters, isc_stats_t **statsp) {
 	return (result);
 
 clean_counters:
-	isc_mem_put(mctx, stats->counters, sizeof(isc_stat_t) * ncounters);
+	isc_mem_put(mctx, stats->base, stats->allocated);
 
 #if ISC_STATS_LOCKCOUNTERS
 clean_copiedcounters:
@@ -217,8 +326,7 @@ isc_stats_detach(isc_stats_t **statsp) {
 	if (stats->references == 0) {
 		isc_mem_put(stats->mctx, stats->copiedcounters,
 			    sizeof(isc_stat_t) * stats->ncounters);
-		isc_mem_put(stats->mctx, stats->counters,
-			    sizeof(isc_stat_t) * stats->ncounters);
+		isc_mem_put(stats->mctx, stats->base, stats->allocated);
 		UNLOCK(&stats->lock);
 		DESTROYLOCK(&stats->lock);
 #if ISC_STATS_LOCKCOUNTERS
@@ -242,6 +350,8 @@ static inline void
 incrementcounter(isc_stats_t *stats, int counter) {
 	isc_int32_t prev;
 
+	counter += shard_offset(stats);
+
 #if ISC_STATS_LOCKCOUNTERS
 	/*
 	 * We use a "read" lock to prevent other threads from reading the
@@ -296,6 +406,8 @@ static inline void
 decrementcounter(isc_stats_t *stats, int counter) {
 	isc_int32_t prev;
 
+	counter += shard_offset(stats);
+
 #if ISC_STATS_LOCKCOUNTERS
 	isc_rwlock_lock(&stats->counterlock, isc_rwlocktype_read);
 #endif
@@ -334,8 +446,45 @@ decrementcounter(isc_stats_t *stats, int counter) {
 #endif
 }
 
+static inline isc_uint64_t
+loadcounter(isc_stats_t *stats, int i) {
+#if ISC_STATS_USEMULTIFIELDS
+	return ((isc_uint64_t)(stats->counters[i].hi) << 32 |
+		stats->counters[i].lo);
+#elif ISC_STATS_HAVEATOMICQ
+#if defined(ISC_STATS_HAVESTDATOMICQ)
+	return (atomic_load_explicit(&stats->counters[i],
+				     memory_order_relaxed));
+#else
+	/* use xaddq(..., 0) as an atomic load */
+	return ((isc_uint64_t)
+		isc_atomic_xaddq((isc_int64_t *)&stats->counters[i], 0));
+#endif
+#else
+	return (stats->counters[i]);
+#endif
+}
+
+static inline void
+storecounter(isc_stats_t *stats, int i, isc_uint64_t val) {
+#if ISC_STATS_USEMULTIFIELDS
+	stats->counters[i].hi = (isc_uint32_t)((val >> 32) & 0xffffffff);
+	stats->counters[i].lo = (isc_uint32_t)(val & 0xffffffff);
+#elif ISC_STATS_HAVEATOMICQ
+#if defined(ISC_STATS_HAVESTDATOMICQ)
+	atomic_store_explicit(&stats->counters[i], val, memory_order_relaxed);
+#else
+	isc_atomic_storeq((isc_int64_t *)&stats->counters[i], val);
+#endif
+#else
+	stats->counters[i] = val;
+#endif
+}
+
 static void
 copy_counters(isc_stats_t *stats) {
+	unsigned int shard;
+	isc_uint64_t value;
 	int i;
 
 #if ISC_STATS_LOCKCOUNTERS
@@ -347,23 +496,18 @@ copy_counters(isc_stats_t *stats) {
 #endif
 
 	for (i = 0; i < stats->ncounters; i++) {
-#if ISC_STATS_USEMULTIFIELDS
-		stats->copiedcounters[i] =
-			(isc_uint64_t)(stats->counters[i].hi) << 32 |
-			stats->counters[i].lo;
-#elif ISC_STATS_HAVEATOMICQ
-#if defined(ISC_STATS_HAVESTDATOMICQ)
-		stats->copiedcounters[i] =
-			atomic_load_explicit(&stats->counters[i],
-					     memory_order_relaxed);
-#else
-		/* use xaddq(..., 0) as an atomic load */
-		stats->copiedcounters[i] =
-			(isc_uint64_t)isc_atomic_xaddq((isc_int64_t *)&stats->counters[i], 0);
-#endif
-#else
-		stats->copiedcounters[i] = stats->counters[i];
-#endif
+		value = 0;
+		for (shard = 0; shard < stats->nshards; shard++)
+			value += loadcounter(stats,
+					     (int)shard * stats->stride + i);
+		/*
+		 * A counter that is incremented in one shard and then
+		 * decremented in another can be caught in between, with
+		 * only the decrement seen, and so appear to be negative.
+		 */
+		if (stats->nshards > 1 && (isc_int64_t)value < 0)
+			value = 0;
+		stats->copiedcounters[i] = value;
 	}
 
 #if ISC_STATS_LOCKCOUNTERS
@@ -375,7 +519,16 @@ isc_result_t
 isc_stats_create(isc_mem_t *mctx, isc_stats_t **statsp, int ncounters) {
 	REQUIRE(statsp != NULL && *statsp == NULL);
 
-	return (create_stats(mctx, ncounters, statsp));
+	return (create_stats(mctx, ncounters, 0, statsp));
+}
+
+isc_result_t
+isc_stats_create2(isc_mem_t *mctx, isc_stats_t **statsp, int ncounters,
+		  unsigned int options)
+{
+	REQUIRE(statsp != NULL && *statsp == NULL);
+
+	return (create_stats(mctx, ncounters, options, statsp));
 }
 
 void
@@ -416,6 +569,8 @@ void
 isc_stats_set(isc_stats_t *stats, isc_uint64_t val,
 	      isc_statscounter_t counter)
 {
+	unsigned int shard;
+
 	REQUIRE(ISC_STATS_VALID(stats));
 	REQUIRE(counter < stats->ncounters);
 
@@ -427,19 +582,15 @@ isc_stats_set(isc_stats_t *stats, isc_uint64_t val,
 	isc_rwlock_lock(&stats->counterlock, isc_rwlocktype_write);
 #endif
 
-#if ISC_STATS_USEMULTIFIELDS
-	stats->counters[counter].hi = (isc_uint32_t)((val >> 32) & 0xffffffff);
-	stats->counters[counter].lo = (isc_uint32_t)(val & 0xffffffff);
-#elif ISC_STATS_HAVEATOMICQ
-#if defined(ISC_STATS_HAVESTDATOMICQ)
-	atomic_store_explicit(&stats->counters[counter], val,
-			      memory_order_relaxed);
-#else
-	isc_atomic_storeq((isc_int64_t *)&stats->counters[counter], val);
-#endif
-#else
-	stats->counters[counter] = val;
-#endif
+	/*
+	 * The value goes in the first shard.  The other shards are
+	 * cleared, so this is only exact if no thread updates the
+	 * counter at the same time.
+	 */
+	storecounter(stats, (int)counter, val);
+	for (shard = 1; shard < stats->nshards; shard++)
+		storecounter(stats,
+			     (int)shard * stats->stride + (int)counter, 0);
 
 #if ISC_STATS_LOCKCOUNTERS
 	isc_rwlock_unlock(&stats->counterlock, isc_rwlocktype_write);
@@ -27,6 +27,7 @@
 #include <isc/once.h>
 #include <isc/platform.h>
 #include <isc/print.h>
+#include <isc/stats.h>
 #include <isc/string.h>
 #include <isc/task.h>
 #include <isc/thread.h>
@@ -38,6 +39,10 @@
 #include <openssl/err.h>
 #endif
 
+#if defined(ISC_PLATFORM_HAVESTDATOMIC)
+#include <stdatomic.h>
+#endif
+
 /*%
  * For BIND9 internal applications:
  * when built with threads we use multiple worker threads shared by the whole
@@ -56,6 +61,19 @@
 #define USE_SHARED_MANAGER
 #endif	/* ISC_PLATFORM_USETHREADS */
 
+/*%
+ * When lock-free atomic integers and pointers are available, events are
+ * sent to a task without taking any lock: they are pushed onto the
+ * task's 'incoming' stack, and the idle to ready transition is done with
+ * a compare-and-swap on the task state.  The task's own event list is
+ * still protected by the task lock; whoever holds the lock moves the
+ * incoming events over to it (see task_drain()) before using it.
+ */
+#if defined(ISC_PLATFORM_HAVESTDATOMIC) && \
+    defined(ATOMIC_INT_LOCK_FREE) && defined(ATOMIC_POINTER_LOCK_FREE)
+#define USE_ATOMIC_SEND
+#endif
+
 #include "task_p.h"
 
 #ifdef ISC_TASK_TRACE
@@ -91,14 +109,56 @@ static const char *statenames[] = {
 
 typedef struct isc__task isc__task_t;
 typedef struct isc__taskmgr isc__taskmgr_t;
+typedef struct isc__taskstats isc__taskstats_t;
+
+/*%
+ * Latency histograms, kept per task name while enabled with
+ * isc_taskmgr_setlatencystats().  Bucket 0 counts zero values and bucket
+ * N > 0 counts values from 2^(N-1) up to 2^N - 1; the last bucket also
+ * counts everything larger.
+ */
+#define TASKSTATS_BUCKETS		24
+
+typedef enum {
+	taskstats_queued = 0,	/*%< microseconds spent ready */
+	taskstats_run = 1,	/*%< microseconds per event action */
+	taskstats_quantum = 2,	/*%< events run per quantum */
+	taskstats_max = 3
+} taskstats_type_t;
+
+#if defined(HAVE_LIBXML2) || defined(HAVE_JSON)
+static const char *taskstats_names[] = { "queued", "run", "quantum" };
+#endif
+#ifdef HAVE_LIBXML2
+static const char *taskstats_units[] = { "us", "us", "events" };
+#endif
+
+struct isc__taskstats {
+	/* Not locked. */
+	char				name[16];
+	isc_stats_t *			counters;
+	/* Locked by task manager stats lock. */
+	LINK(isc__taskstats_t)		link;
+};
 
 struct isc__task {
 	/* Not locked. */
 	isc_task_t			common;
 	isc__taskmgr_t *		manager;
 	isc_mutex_t			lock;
+#ifdef USE_ATOMIC_SEND
+	/*
+	 * Changed from idle to ready by compare-and-swap, otherwise
+	 * only while holding the task lock.
+	 */
+	atomic_int			state;
+	/* Events sent but not yet moved to 'events'; LIFO. */
+	_Atomic(isc_event_t *)		incoming;
+#endif
 	/* Locked by task lock. */
+#ifndef USE_ATOMIC_SEND
 	task_state_t			state;
+#endif
 	unsigned int			references;
 	isc_eventlist_t			events;
 	isc_eventlist_t			on_shutdown;
@@ -109,14 +169,23 @@ struct isc__task {
 	isc_time_t			tnow;
 	char				name[16];
 	void *				tag;
+	isc__taskstats_t *		stats;
+	/*
+	 * Set by whoever makes the task ready, before it is put on a
+	 * ready queue, when latency statistics are enabled.
+	 */
+	isc_time_t			tready;
 	/* Locked by task manager lock. */
 	LINK(isc__task_t)		link;
+	/* Locked by the lock of queue 'threadid'. */
+	unsigned int			threadid;
 	LINK(isc__task_t)		ready_link;
 	LINK(isc__task_t)		ready_priority_link;
 };
 
 #define TASK_F_SHUTTINGDOWN		0x01
 #define TASK_F_PRIVILEGED		0x02
+#define TASK_F_BOUND			0x04
 
 #define TASK_SHUTTINGDOWN(t)		(((t)->flags & TASK_F_SHUTTINGDOWN) \
 					 != 0)
@@ -126,11 +195,35 @@ struct isc__task {
 
 typedef ISC_LIST(isc__task_t)	isc__tasklist_t;
 
+/*%
+ * Each worker thread has its own ready queue.  A task is queued on the
+ * worker that last ran it; a worker whose queue is empty steals from
+ * the others.  'tasks_running' counts the tasks that were taken from
+ * this queue and are currently running, wherever they run.
+ */
+typedef struct isc__taskqueue {
+	/* Not locked. */
+	isc__taskmgr_t *		manager;
+	unsigned int			threadid;
+	isc_mutex_t			lock;
+	/* Locked by queue lock. */
+	isc__tasklist_t			ready_tasks;
+	isc__tasklist_t			ready_priority_tasks;
+#ifdef ISC_PLATFORM_USETHREADS
+	isc_condition_t			work_available;
+	isc_boolean_t			idle;
+#endif /* ISC_PLATFORM_USETHREADS */
+	unsigned int			tasks_running;
+	unsigned int			tasks_ready;
+} isc__taskqueue_t;
+
 struct isc__taskmgr {
 	/* Not locked. */
 	isc_taskmgr_t			common;
 	isc_mem_t *			mctx;
 	isc_mutex_t			lock;
+	unsigned int			nqueues;
+	isc__taskqueue_t *		queues;
 #ifdef ISC_PLATFORM_USETHREADS
 	unsigned int			workers;
 	isc_thread_t *			threads;
@@ -138,19 +231,20 @@ struct isc__taskmgr {
 	/* Locked by task manager lock. */
 	unsigned int			default_quantum;
 	LIST(isc__task_t)		tasks;
-	isc__tasklist_t			ready_tasks;
-	isc__tasklist_t			ready_priority_tasks;
-	isc_taskmgrmode_t		mode;
+	unsigned int			curq;
 #ifdef ISC_PLATFORM_USETHREADS
-	isc_condition_t			work_available;
 	isc_condition_t			exclusive_granted;
 	isc_condition_t			paused;
 #endif /* ISC_PLATFORM_USETHREADS */
-	unsigned int			tasks_running;
-	unsigned int			tasks_ready;
+	/*
+	 * Locked by task manager lock and all queue locks; may be read
+	 * while holding either.
+	 */
+	isc_taskmgrmode_t		mode;
 	isc_boolean_t			pause_requested;
 	isc_boolean_t			exclusive_requested;
 	isc_boolean_t			exiting;
+	isc_boolean_t			finished;
 
 	/*
 	 * Multiple threads can read/write 'excl' at the same time, so we need
@@ -159,6 +253,11 @@ struct isc__taskmgr {
 	 */
 	isc_mutex_t			excl_lock;
 	isc__task_t			*excl;
+	/* Not locked; only a hint for the workers. */
+	isc_boolean_t			latencystats;
+	/* Locked by stats lock. */
+	isc_mutex_t			stats_lock;
+	LIST(isc__taskstats_t)		taskstats;
 #ifdef USE_SHARED_MANAGER
 	unsigned int			refs;
 #endif /* ISC_PLATFORM_USETHREADS */
@@ -244,13 +343,25 @@ isc_taskmgrmode_t
 isc__taskmgr_mode(isc_taskmgr_t *manager0);
 
 static inline isc_boolean_t
-empty_readyq(isc__taskmgr_t *manager);
+empty_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue);
 
 static inline isc__task_t *
-pop_readyq(isc__taskmgr_t *manager);
+pop_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue);
 
 static inline void
-push_readyq(isc__taskmgr_t *manager, isc__task_t *task);
+push_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue,
+	    isc__task_t *task);
+
+static void
+lock_queues(isc__taskmgr_t *manager);
+
+static void
+unlock_queues(isc__taskmgr_t *manager, isc_boolean_t wakeup);
+
+#ifdef USE_WORKER_THREADS
+static void
+wakeup_idle(isc__taskmgr_t *manager, unsigned int threadid);
+#endif
 
 static struct isc__taskmethods {
 	isc_taskmethods_t methods;
@@ -313,7 +424,6 @@ task_finished(isc__task_t *task) {
 
 	LOCK(&manager->lock);
 	UNLINK(manager->tasks, task, link);
-#ifdef USE_WORKER_THREADS
 	if (FINISHED(manager)) {
 		/*
 		 * All tasks have completed and the
@@ -321,9 +431,10 @@ task_finished(isc__task_t *task) {
 		 * any idle worker threads so they
 		 * can exit.
 		 */
-		BROADCAST(&manager->work_available);
+		lock_queues(manager);
+		manager->finished = ISC_TRUE;
+		unlock_queues(manager, ISC_TRUE);
 	}
-#endif /* USE_WORKER_THREADS */
 	UNLOCK(&manager->lock);
 
 	DESTROYLOCK(&task->lock);
@@ -332,11 +443,15 @@ task_finished(isc__task_t *task) {
 	isc_mem_put(manager->mctx, task, sizeof(*task));
 }
 
-isc_result_t
-isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
-		 isc_task_t **taskp)
+/*
+ * Create a task whose home queue is that of worker 'threadid' modulo
+ * the number of workers, or the next queue in turn if 'threadid' is
+ * negative.
+ */
+static isc_result_t
+task_create(isc__taskmgr_t *manager, unsigned int quantum, int threadid,
+	    isc_task_t **taskp)
 {
-	isc__taskmgr_t *manager = (isc__taskmgr_t *)manager0;
 	isc__task_t *task;
 	isc_boolean_t exiting;
 	isc_result_t result;
@@ -354,7 +469,12 @@ isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
 		isc_mem_put(manager->mctx, task, sizeof(*task));
 		return (result);
 	}
+#ifdef USE_ATOMIC_SEND
+	atomic_init(&task->state, task_state_idle);
+	atomic_init(&task->incoming, NULL);
+#else
 	task->state = task_state_idle;
+#endif
 	task->references = 1;
 	INIT_LIST(task->events);
 	INIT_LIST(task->on_shutdown);
@@ -365,6 +485,8 @@ isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
 	isc_time_settoepoch(&task->tnow);
 	memset(task->name, 0, sizeof(task->name));
 	task->tag = NULL;
+	task->stats = NULL;
+	isc_time_settoepoch(&task->tready);
 	INIT_LINK(task, link);
 	INIT_LINK(task, ready_link);
 	INIT_LINK(task, ready_priority_link);
@@ -374,6 +496,20 @@ isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
 	if (!manager->exiting) {
 		if (task->quantum == 0)
 			task->quantum = manager->default_quantum;
+		/*
+		 * Spread new tasks over the worker queues, unless the
+		 * caller chose one.
+		 */
+#ifdef USE_WORKER_THREADS
+		if (threadid >= 0) {
+			task->threadid = threadid % manager->workers;
+			task->flags |= TASK_F_BOUND;
+		} else
+			task->threadid = manager->curq++ % manager->workers;
+#else
+		UNUSED(threadid);
+		task->threadid = 0;
+#endif
 		APPEND(manager->tasks, task, link);
 	} else
 		exiting = ISC_TRUE;
@@ -393,6 +529,21 @@ isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
 	return (ISC_R_SUCCESS);
 }
 
+isc_result_t
+isc__task_create(isc_taskmgr_t *manager0, unsigned int quantum,
+		 isc_task_t **taskp)
+{
+	return (task_create((isc__taskmgr_t *)manager0, quantum, -1, taskp));
+}
+
+isc_result_t
+isc_task_create_bound(isc_taskmgr_t *manager0, unsigned int quantum,
+		      isc_task_t **taskp, int threadid)
+{
+	return (task_create((isc__taskmgr_t *)manager0, quantum, threadid,
+			    taskp));
+}
+
 void
 isc__task_attach(isc_task_t *source0, isc_task_t **targetp) {
 	isc__task_t *source = (isc__task_t *)source0;
@@ -413,6 +564,60 @@ isc__task_attach(isc_task_t *source0, isc_task_t **targetp) {
 	*targetp = (isc_task_t *)source;
 }
 
+/*
+ * Move a task from idle to ready.  Returns ISC_TRUE if this call did so,
+ * in which case the caller must put the task on a ready queue.
+ *
+ * Caller must be holding the task's lock, unless USE_ATOMIC_SEND.
+ */
+static inline isc_boolean_t
+task_makeready(isc__task_t *task) {
+#ifdef USE_ATOMIC_SEND
+	int expected = task_state_idle;
+
+	return (ISC_TF(atomic_compare_exchange_strong(&task->state,
+						      &expected,
+						      task_state_ready)));
+#else
+	if (task->state != task_state_idle)
+		return (ISC_FALSE);
+	task->state = task_state_ready;
+	return (ISC_TRUE);
+#endif
+}
+
+/*
+ * Append the events sent since the last call to the task's event list,
+ * in the order they were sent.
+ *
+ * Caller must be holding the task's lock.
+ */
+static inline void
+task_drain(isc__task_t *task) {
+#ifdef USE_ATOMIC_SEND
+	isc_event_t *event, *next, *head = NULL;
+
+	if (atomic_load(&task->incoming) == NULL)
+		return;
+
+	event = atomic_exchange(&task->incoming, NULL);
+	while (event != NULL) {
+		next = event->ev_link.next;
+		event->ev_link.next = head;
+		head = event;
+		event = next;
+	}
+	for (event = head; event != NULL; event = next) {
+		next = event->ev_link.next;
+		ISC_LINK_INIT(event, ev_link);
+		ENQUEUE(task->events, event, ev_link);
+		task->nevents++;
+	}
+#else
+	UNUSED(task);
+#endif
+}
+
 static inline isc_boolean_t
 task_shutdown(isc__task_t *task) {
 	isc_boolean_t was_idle = ISC_FALSE;
@@ -428,17 +633,15 @@ task_shutdown(isc__task_t *task) {
 		XTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 				      ISC_MSG_SHUTTINGDOWN, "shutting down"));
 		task->flags |= TASK_F_SHUTTINGDOWN;
-		if (task->state == task_state_idle) {
-			INSIST(EMPTY(task->events));
-			task->state = task_state_ready;
-			was_idle = ISC_TRUE;
-		}
+		was_idle = task_makeready(task);
 		INSIST(task->state == task_state_ready ||
 		       task->state == task_state_running);
 
 		/*
+		 * Shutdown events go after any event already sent.
 		 * Note that we post shutdown events LIFO.
 		 */
+		task_drain(task);
 		for (event = TAIL(task->on_shutdown);
 		     event != NULL;
 		     event = prev) {
@@ -460,8 +663,10 @@ task_shutdown(isc__task_t *task) {
 static inline void
 task_ready(isc__task_t *task) {
 	isc__taskmgr_t *manager = task->manager;
+	isc__taskqueue_t *queue;
 #ifdef USE_WORKER_THREADS
 	isc_boolean_t has_privilege = isc__task_privilege((isc_task_t *) task);
+	isc_boolean_t wakeup = ISC_FALSE, busy = ISC_FALSE;
 #endif /* USE_WORKER_THREADS */
 
 	REQUIRE(VALID_MANAGER(manager));
@@ -469,13 +674,28 @@ task_ready(isc__task_t *task) {
 
 	XTRACE("task_ready");
 
-	LOCK(&manager->lock);
-	push_readyq(manager, task);
+	if (manager->latencystats)
+		TIME_NOW(&task->tready);
+
+	queue = &manager->queues[task->threadid];
+	LOCK(&queue->lock);
+	push_readyq(manager, queue, task);
 #ifdef USE_WORKER_THREADS
-	if (manager->mode == isc_taskmgrmode_normal || has_privilege)
-		SIGNAL(&manager->work_available);
+	if (manager->mode == isc_taskmgrmode_normal || has_privilege) {
+		wakeup = ISC_TRUE;
+		busy = ISC_TF(!queue->idle);
+		SIGNAL(&queue->work_available);
+	}
+#endif /* USE_WORKER_THREADS */
+	UNLOCK(&queue->lock);
+
+#ifdef USE_WORKER_THREADS
+	/*
+	 * If the task's own worker is busy, let an idle one steal it.
+	 */
+	if (wakeup && busy)
+		wakeup_idle(manager, task->threadid);
 #endif /* USE_WORKER_THREADS */
-	UNLOCK(&manager->lock);
 }
 
 static inline isc_boolean_t
@@ -490,8 +710,7 @@ task_detach(isc__task_t *task) {
 	XTRACE("detach");
 
 	task->references--;
-	if (task->references == 0 && task->state == task_state_idle) {
-		INSIST(EMPTY(task->events));
+	if (task->references == 0 && task_makeready(task)) {
 		/*
 		 * There are no references to this task, and no
 		 * pending events.  We could try to optimize and
@@ -500,7 +719,6 @@ task_detach(isc__task_t *task) {
 		 * make the task ready and allow run() or the event
 		 * loop to deal with shutting down and termination.
 		 */
-		task->state = task_state_ready;
 		return (ISC_TRUE);
 	}
 
@@ -534,11 +752,14 @@ isc__task_detach(isc_task_t **taskp) {
 
 static inline isc_boolean_t
 task_send(isc__task_t *task, isc_event_t **eventp) {
-	isc_boolean_t was_idle = ISC_FALSE;
+	isc_boolean_t was_idle;
 	isc_event_t *event;
+#ifdef USE_ATOMIC_SEND
+	isc_event_t *head;
+#endif
 
 	/*
-	 * Caller must be holding the task lock.
+	 * Caller must be holding the task lock, unless USE_ATOMIC_SEND.
 	 */
 
 	REQUIRE(eventp != NULL);
@@ -550,15 +771,26 @@ task_send(isc__task_t *task, isc_event_t **eventp) {
 
 	XTRACE("task_send");
 
-	if (task->state == task_state_idle) {
-		was_idle = ISC_TRUE;
-		INSIST(EMPTY(task->events));
-		task->state = task_state_ready;
-	}
+#ifdef USE_ATOMIC_SEND
+	/*
+	 * The event must be visible on 'incoming' before we look at the
+	 * state: run_task() stores the idle state before it checks
+	 * 'incoming' one last time, so either it sees the event or we
+	 * see the task idle.
+	 */
+	head = atomic_load_explicit(&task->incoming, memory_order_relaxed);
+	do {
+		event->ev_link.next = head;
+	} while (!atomic_compare_exchange_weak(&task->incoming, &head,
+					       event));
+	was_idle = task_makeready(task);
+#else
+	was_idle = task_makeready(task);
 	INSIST(task->state == task_state_ready ||
 	       task->state == task_state_running);
 	ENQUEUE(task->events, event, ev_link);
 	task->nevents++;
+#endif
 	*eventp = NULL;
 
 	return (was_idle);
@@ -582,9 +814,13 @@ isc__task_send(isc_task_t *task0, isc_event_t **eventp) {
 	 * We're also trying to hold as few locks as possible.  This is why
 	 * some processing is deferred until after the lock is released.
 	 */
+#ifdef USE_ATOMIC_SEND
+	was_idle = task_send(task, eventp);
+#else
 	LOCK(&task->lock);
 	was_idle = task_send(task, eventp);
 	UNLOCK(&task->lock);
+#endif
 
 	if (was_idle) {
 		/*
@@ -622,6 +858,23 @@ isc__task_sendanddetach(isc_task_t **taskp, isc_event_t **eventp) {
 
 	XTRACE("isc_task_sendanddetach");
 
+#ifdef USE_ATOMIC_SEND
+	/*
+	 * The event is sent without the task lock, so the task may run
+	 * and go idle again before we detach.  Each idle to ready
+	 * transition queues the task once.
+	 */
+	idle1 = task_send(task, eventp);
+	if (idle1)
+		task_ready(task);
+
+	LOCK(&task->lock);
+	idle2 = task_detach(task);
+	UNLOCK(&task->lock);
+
+	if (idle2)
+		task_ready(task);
+#else
 	LOCK(&task->lock);
 	idle1 = task_send(task, eventp);
 	idle2 = task_detach(task);
@@ -636,6 +889,7 @@ isc__task_sendanddetach(isc_task_t **taskp, isc_event_t **eventp) {
 
 	if (idle1 || idle2)
 		task_ready(task);
+#endif
 
 	*taskp = NULL;
 }
@@ -664,6 +918,7 @@ dequeue_events(isc__task_t *task, void *sender, isc_eventtype_t first,
 	 */
 
 	LOCK(&task->lock);
+	task_drain(task);
 
 	for (event = HEAD(task->events); event != NULL; event = next_event) {
 		next_event = NEXT(event, ev_link);
@@ -753,6 +1008,7 @@ isc_task_purgeevent(isc_task_t *task0, isc_event_t *event) {
 	 */
 
 	LOCK(&task->lock);
+	task_drain(task);
 	for (curr_event = HEAD(task->events);
 	     curr_event != NULL;
 	     curr_event = next_event) {
@@ -887,6 +1143,7 @@ isc__task_setname(isc_task_t *task0, const char *name, void *tag) {
 	LOCK(&task->lock);
 	strlcpy(task->name, name, sizeof(task->name));
 	task->tag = tag;
+	task->stats = NULL;
 	UNLOCK(&task->lock);
 }
 
@@ -937,45 +1194,46 @@ isc__task_getcurrenttimex(isc_task_t *task0, isc_time_t *t) {
  ***/
 
 /*
- * Return ISC_TRUE if the current ready list for the manager, which is
+ * Return ISC_TRUE if the current ready list of 'queue', which is
  * either ready_tasks or the ready_priority_tasks, depending on whether
- * the manager is currently in normal or privileged execution mode.
+ * the manager is currently in normal or privileged execution mode,
+ * is empty.
  *
- * Caller must hold the task manager lock.
+ * Caller must hold the queue lock.
  */
 static inline isc_boolean_t
-empty_readyq(isc__taskmgr_t *manager) {
-	isc__tasklist_t queue;
+empty_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue) {
+	isc__tasklist_t list;
 
 	if (manager->mode == isc_taskmgrmode_normal)
-		queue = manager->ready_tasks;
+		list = queue->ready_tasks;
 	else
-		queue = manager->ready_priority_tasks;
+		list = queue->ready_priority_tasks;
 
-	return (ISC_TF(EMPTY(queue)));
+	return (ISC_TF(EMPTY(list)));
 }
 
 /*
  * Dequeue and return a pointer to the first task on the current ready
- * list for the manager.
+ * list of 'queue'.
  * If the task is privileged, dequeue it from the other ready list
  * as well.
  *
- * Caller must hold the task manager lock.
+ * Caller must hold the queue lock.
  */
 static inline isc__task_t *
-pop_readyq(isc__taskmgr_t *manager) {
+pop_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue) {
 	isc__task_t *task;
 
 	if (manager->mode == isc_taskmgrmode_normal)
-		task = HEAD(manager->ready_tasks);
+		task = HEAD(queue->ready_tasks);
 	else
-		task = HEAD(manager->ready_priority_tasks);
+		task = HEAD(queue->ready_priority_tasks);
 
 	if (task != NULL) {
-		DEQUEUE(manager->ready_tasks, task, ready_link);
+		DEQUEUE(queue->ready_tasks, task, ready_link);
 		if (ISC_LINK_LINKED(task, ready_priority_link))
-			DEQUEUE(manager->ready_priority_tasks, task,
+			DEQUEUE(queue->ready_priority_tasks, task,
 				ready_priority_link);
 	}
 
@@ -986,317 +1244,611 @@ pop_readyq(isc__taskmgr_t *manager) {
  * Push 'task' onto the ready_tasks queue.  If 'task' has the privilege
  * flag set, then also push it onto the ready_priority_tasks queue.
  *
- * Caller must hold the task manager lock.
+ * Caller must hold the queue lock.
  */
 static inline void
-push_readyq(isc__taskmgr_t *manager, isc__task_t *task) {
-	ENQUEUE(manager->ready_tasks, task, ready_link);
+push_readyq(isc__taskmgr_t *manager, isc__taskqueue_t *queue,
+	    isc__task_t *task)
+{
+	UNUSED(manager);
+
+	ENQUEUE(queue->ready_tasks, task, ready_link);
 	if ((task->flags & TASK_F_PRIVILEGED) != 0)
-		ENQUEUE(manager->ready_priority_tasks, task,
+		ENQUEUE(queue->ready_priority_tasks, task,
 			ready_priority_link);
-	manager->tasks_ready++;
+	queue->tasks_ready++;
 }
 
+/*
+ * Lock every queue, in order.  Used when changing the state the workers
+ * check before picking up work (mode, pause and exclusive requests,
+ * shutdown).
+ *
+ * Caller must hold the task manager lock.
+ */
 static void
-dispatch(isc__taskmgr_t *manager) {
-	isc__task_t *task;
-#ifndef USE_WORKER_THREADS
-	unsigned int total_dispatch_count = 0;
-	isc__tasklist_t new_ready_tasks;
-	isc__tasklist_t new_priority_tasks;
-	unsigned int tasks_ready = 0;
-#endif /* USE_WORKER_THREADS */
+lock_queues(isc__taskmgr_t *manager) {
+	unsigned int i;
 
-	REQUIRE(VALID_MANAGER(manager));
+	for (i = 0; i < manager->nqueues; i++)
+		LOCK(&manager->queues[i].lock);
+}
 
-	/*
-	 * Again we're trying to hold the lock for as short a time as possible
-	 * and to do as little locking and unlocking as possible.
-	 *
-	 * In both while loops, the appropriate lock must be held before the
-	 * while body starts.  Code which acquired the lock at the top of
-	 * the loop would be more readable, but would result in a lot of
-	 * extra locking.  Compare:
-	 *
-	 * Straightforward:
-	 *
-	 *	LOCK();
-	 *	...
-	 *	UNLOCK();
-	 *	while (expression) {
-	 *		LOCK();
-	 *		...
-	 *		UNLOCK();
-	 *
-	 *	       	Unlocked part here...
-	 *
-	 *		LOCK();
-	 *		...
-	 *		UNLOCK();
-	 *	}
-	 *
-	 * Note how if the loop continues we unlock and then immediately lock.
-	 * For N iterations of the loop, this code does 2N+1 locks and 2N+1
-	 * unlocks.  Also note that the lock is not held when the while
-	 * condition is tested, which may or may not be important, depending
-	 * on the expression.
-	 *
-	 * As written:
-	 *
-	 *	LOCK();
-	 *	while (expression) {
-	 *		...
-	 *		UNLOCK();
-	 *
-	 *	       	Unlocked part here...
-	 *
-	 *		LOCK();
-	 *		...
-	 *	}
-	 *	UNLOCK();
-	 *
-	 * For N iterations of the loop, this code does N+1 locks and N+1
-	 * unlocks.  The while expression is always protected by the lock.
-	 */
+/*
+ * Unlock every queue, waking up its worker first if 'wakeup' is set.
+ */
+static void
+unlock_queues(isc__taskmgr_t *manager, isc_boolean_t wakeup) {
+	unsigned int i;
 
-#ifndef USE_WORKER_THREADS
-	ISC_LIST_INIT(new_ready_tasks);
-	ISC_LIST_INIT(new_priority_tasks);
+	for (i = manager->nqueues; i > 0; i--) {
+#ifdef USE_WORKER_THREADS
+		if (wakeup)
+			BROADCAST(&manager->queues[i - 1].work_available);
+#else
+		UNUSED(wakeup);
 #endif
-	LOCK(&manager->lock);
+		UNLOCK(&manager->queues[i - 1].lock);
+	}
+}
+
+/*
+ * Return the number of tasks currently running.
+ *
+ * Caller must hold the task manager lock and no queue lock.
+ */
+static unsigned int
+tasks_running(isc__taskmgr_t *manager) {
+	unsigned int i, n = 0;
+
+	for (i = 0; i < manager->nqueues; i++) {
+		LOCK(&manager->queues[i].lock);
+		n += manager->queues[i].tasks_running;
+		UNLOCK(&manager->queues[i].lock);
+	}
+
+	return (n);
+}
+
+#if defined(HAVE_LIBXML2) || defined(HAVE_JSON)
+/*
+ * Return the number of tasks waiting to run.
+ *
+ * Caller must hold the task manager lock and no queue lock.
+ */
+static unsigned int
+tasks_ready(isc__taskmgr_t *manager) {
+	unsigned int i, n = 0;
+
+	for (i = 0; i < manager->nqueues; i++) {
+		LOCK(&manager->queues[i].lock);
+		n += manager->queues[i].tasks_ready;
+		UNLOCK(&manager->queues[i].lock);
+	}
+
+	return (n);
+}
+#endif /* HAVE_LIBXML2 || HAVE_JSON */
+
+/*
+ * Find or create the latency histograms for the name of 'task'.
+ * Returns NULL if they could not be allocated.
+ *
+ * Caller must be holding the task's lock.
+ */
+static isc__taskstats_t *
+task_getstats(isc__task_t *task) {
+	isc__taskmgr_t *manager = task->manager;
+	isc__taskstats_t *stats;
+
+	if (task->stats != NULL)
+		return (task->stats);
+
+	LOCK(&manager->stats_lock);
+	for (stats = HEAD(manager->taskstats);
+	     stats != NULL;
+	     stats = NEXT(stats, link))
+	{
+		if (strcmp(stats->name, task->name) == 0)
+			break;
+	}
+	if (stats == NULL) {
+		stats = isc_mem_get(manager->mctx, sizeof(*stats));
+		if (stats == NULL)
+			goto unlock;
+		memmove(stats->name, task->name, sizeof(stats->name));
+		stats->counters = NULL;
+		if (isc_stats_create(manager->mctx, &stats->counters,
+				     taskstats_max * TASKSTATS_BUCKETS)
+		    != ISC_R_SUCCESS)
+		{
+			isc_mem_put(manager->mctx, stats, sizeof(*stats));
+			stats = NULL;
+			goto unlock;
+		}
+		INIT_LINK(stats, link);
+		APPEND(manager->taskstats, stats, link);
+	}
+	task->stats = stats;
+ unlock:
+	UNLOCK(&manager->stats_lock);
+
+	return (stats);
+}
+
+static void
+taskstats_add(isc__taskstats_t *stats, taskstats_type_t type,
+	      isc_uint64_t value)
+{
+	unsigned int bucket = 0;
+
+	while (value != 0 && bucket < TASKSTATS_BUCKETS - 1) {
+		value >>= 1;
+		bucket++;
+	}
+	isc_stats_increment(stats->counters,
+			    type * TASKSTATS_BUCKETS + bucket);
+}
+
+/*
+ * Run the events of 'task', which has just been taken off a ready queue,
+ * until it has none left or its quantum has expired.  '*countp' is
+ * incremented for every event dispatched.  Returns ISC_TRUE if the task
+ * still has events and must be put back on a ready queue.
+ *
+ * Caller must not hold any lock.
+ */
+static isc_boolean_t
+run_task(isc__task_t *task, unsigned int *countp) {
+	unsigned int dispatch_count = 0;
+	isc_boolean_t done = ISC_FALSE;
+	isc_boolean_t requeue = ISC_FALSE;
+	isc_boolean_t finished = ISC_FALSE;
+	isc_event_t *event;
+	isc__taskstats_t *stats = NULL;
+	isc_time_t start, end;
+
+	INSIST(VALID_TASK(task));
+
+	LOCK(&task->lock);
+	INSIST(task->state == task_state_ready);
+	task->state = task_state_running;
+	XTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
+			      ISC_MSG_RUNNING, "running"));
+	TIME_NOW(&task->tnow);
+	task->now = isc_time_seconds(&task->tnow);
+	if (task->manager->latencystats) {
+		stats = task_getstats(task);
+		if (stats != NULL && !isc_time_isepoch(&task->tready))
+			taskstats_add(stats, taskstats_queued,
+				      isc_time_microdiff(&task->tnow,
+							 &task->tready));
+	}
+	isc_time_settoepoch(&task->tready);
+	task_drain(task);
+	do {
+		if (!EMPTY(task->events)) {
+			event = HEAD(task->events);
+			DEQUEUE(task->events, event, ev_link);
+			task->nevents--;
+
+			/*
+			 * Execute the event action.
+			 */
+			XTRACE(isc_msgcat_get(isc_msgcat,
+					      ISC_MSGSET_TASK,
+					      ISC_MSG_EXECUTE,
+					      "execute action"));
+			if (event->ev_action != NULL) {
+				UNLOCK(&task->lock);
+				if (stats != NULL)
+					TIME_NOW(&start);
+				(event->ev_action)((isc_task_t *)task, event);
+				if (stats != NULL) {
+					TIME_NOW(&end);
+					taskstats_add(stats, taskstats_run,
+						      isc_time_microdiff(&end,
+									 &start));
+				}
+				LOCK(&task->lock);
+			}
+			dispatch_count++;
+			(*countp)++;
+			task_drain(task);
+		}
+
+		if (task->references == 0 &&
+		    EMPTY(task->events) &&
+		    !TASK_SHUTTINGDOWN(task)) {
+			isc_boolean_t was_idle;
+
+			/*
+			 * There are no references and no
+			 * pending events for this task,
+			 * which means it will not become
+			 * runnable again via an external
+			 * action (such as sending an event
+			 * or detaching).
+			 *
+			 * We initiate shutdown to prevent
+			 * it from becoming a zombie.
+			 *
+			 * We do this here instead of in
+			 * the "if EMPTY(task->events)" block
+			 * below because:
+			 *
+			 *	If we post no shutdown events,
+			 *	we want the task to finish.
+			 *
+			 *	If we did post shutdown events,
+			 *	will still want the task's
+			 *	quantum to be applied.
+			 */
+			was_idle = task_shutdown(task);
+			INSIST(!was_idle);
+		}
+
+		if (EMPTY(task->events)) {
+			/*
+			 * Nothing else to do for this task
+			 * right now.
+			 */
+			XTRACE(isc_msgcat_get(isc_msgcat,
+					      ISC_MSGSET_TASK,
+					      ISC_MSG_EMPTY,
+					      "empty"));
+			if (task->references == 0 &&
+			    TASK_SHUTTINGDOWN(task)) {
+				/*
+				 * The task is done.
+				 */
+				XTRACE(isc_msgcat_get(isc_msgcat,
+						      ISC_MSGSET_TASK,
+						      ISC_MSG_DONE,
+						      "done"));
+				finished = ISC_TRUE;
+				task->state = task_state_done;
+				done = ISC_TRUE;
+			} else {
+				task->state = task_state_idle;
+				done = ISC_TRUE;
+#ifdef USE_ATOMIC_SEND
+				/*
+				 * An event may have been sent after our
+				 * last task_drain() by a sender that saw
+				 * us running.  If so, and the sender has
+				 * not made us ready already, carry on.
+				 */
+				if (atomic_load(&task->incoming) != NULL &&
+				    task_makeready(task))
+				{
+					task->state = task_state_running;
+					task_drain(task);
+					done = ISC_FALSE;
+				}
+#endif
+			}
+		} else if (dispatch_count >= task->quantum) {
+			/*
+			 * Our quantum has expired, but
+			 * there is more work to be done.
+			 * We'll requeue it to the ready
+			 * queue later.
+			 *
+			 * We don't check quantum until
+			 * dispatching at least one event,
+			 * so the minimum quantum is one.
+			 */
+			XTRACE(isc_msgcat_get(isc_msgcat,
+					      ISC_MSGSET_TASK,
+					      ISC_MSG_QUANTUM,
+					      "quantum"));
+			task->state = task_state_ready;
+			if (stats != NULL)
+				TIME_NOW(&task->tready);
+			requeue = ISC_TRUE;
+			done = ISC_TRUE;
+		}
+	} while (!done);
+	UNLOCK(&task->lock);
+
+	if (stats != NULL)
+		taskstats_add(stats, taskstats_quantum, dispatch_count);
+
+	if (finished)
+		task_finished(task);
+
+	return (requeue);
+}
 
-	while (!FINISHED(manager)) {
 #ifdef USE_WORKER_THREADS
+/*
+ * Wake up one idle worker other than 'threadid' so that it can steal
+ * work.  The idle flags are only read as a hint here and are checked
+ * again under the queue lock.
+ */
+static void
+wakeup_idle(isc__taskmgr_t *manager, unsigned int threadid) {
+	isc__taskqueue_t *queue;
+	unsigned int i;
+
+	for (i = 1; i < manager->nqueues; i++) {
+		queue = &manager->queues[(threadid + i) % manager->nqueues];
+		if (!queue->idle)
+			continue;
+		LOCK(&queue->lock);
+		if (queue->idle) {
+			SIGNAL(&queue->work_available);
+			UNLOCK(&queue->lock);
+			return;
+		}
+		UNLOCK(&queue->lock);
+	}
+}
+
+/*
+ * Take a runnable task from another worker's queue and make it ours.
+ * On success the task is counted as running on the queue it was taken
+ * from, which is returned in '*fromp'.
+ *
+ * Caller must not hold any queue lock.
+ */
+static isc__task_t *
+steal_readyq(isc__taskmgr_t *manager, unsigned int threadid,
+	     isc__taskqueue_t **fromp)
+{
+	isc__taskqueue_t *queue;
+	isc__task_t *task;
+	unsigned int i;
+
+	for (i = 1; i < manager->nqueues; i++) {
+		queue = &manager->queues[(threadid + i) % manager->nqueues];
+		LOCK(&queue->lock);
+		if (manager->pause_requested || manager->exclusive_requested) {
+			UNLOCK(&queue->lock);
+			return (NULL);
+		}
+		task = pop_readyq(manager, queue);
+		if (task != NULL) {
+			queue->tasks_ready--;
+			queue->tasks_running++;
+			/*
+			 * A bound task runs here this once, but stays
+			 * queued on its own worker from now on.
+			 */
+			if ((task->flags & TASK_F_BOUND) == 0)
+				task->threadid = threadid;
+			UNLOCK(&queue->lock);
+			*fromp = queue;
+			return (task);
+		}
+		UNLOCK(&queue->lock);
+	}
+
+	return (NULL);
+}
+
+/*
+ * If we are in privileged execution mode and there are no privileged
+ * tasks left to run anywhere, we're stuck.  Automatically drop
+ * privileges at that point and continue with the regular ready queues.
+ *
+ * Caller must not hold any queue lock.
+ */
+static void
+check_privilege(isc__taskmgr_t *manager) {
+	unsigned int i;
+	isc_boolean_t stuck = ISC_TRUE;
+
+	LOCK(&manager->lock);
+	lock_queues(manager);
+	if (manager->mode != isc_taskmgrmode_privileged) {
+		unlock_queues(manager, ISC_FALSE);
+		UNLOCK(&manager->lock);
+		return;
+	}
+	for (i = 0; i < manager->nqueues; i++) {
+		if (manager->queues[i].tasks_running != 0 ||
+		    !empty_readyq(manager, &manager->queues[i]))
+		{
+			stuck = ISC_FALSE;
+			break;
+		}
+	}
+	if (stuck)
+		manager->mode = isc_taskmgrmode_normal;
+	unlock_queues(manager, stuck);
+	UNLOCK(&manager->lock);
+}
+
+static void
+dispatch(isc__taskmgr_t *manager, unsigned int threadid) {
+	isc__taskqueue_t *queue, *from, *home;
+	isc__task_t *task;
+	isc_boolean_t requeue, privileged;
+	unsigned int count = 0;
+
+	REQUIRE(VALID_MANAGER(manager));
+	REQUIRE(threadid < manager->nqueues);
+
+	queue = &manager->queues[threadid];
+
+	LOCK(&queue->lock);
+	while (!manager->finished) {
 		/*
-		 * For reasons similar to those given in the comment in
-		 * isc_task_send() above, it is safe for us to dequeue
-		 * the task while only holding the manager lock, and then
-		 * change the task to running state while only holding the
-		 * task lock.
-		 *
-		 * If a pause has been requested, don't do any work
-		 * until it's been released.
+		 * Look for a task on our own queue first and on the
+		 * others if ours is empty.  If a pause or exclusive
+		 * access has been requested, don't do any work until
+		 * it's been released.
 		 */
-		while ((empty_readyq(manager) || manager->pause_requested ||
-			manager->exclusive_requested) && !FINISHED(manager))
+		task = NULL;
+		from = queue;
+		if (!manager->pause_requested &&
+		    !manager->exclusive_requested)
 		{
+			task = pop_readyq(manager, queue);
+			if (task != NULL) {
+				queue->tasks_ready--;
+				queue->tasks_running++;
+			} else {
+				privileged = ISC_TF(manager->mode ==
+					       isc_taskmgrmode_privileged);
+				UNLOCK(&queue->lock);
+				task = steal_readyq(manager, threadid, &from);
+				if (task == NULL && privileged)
+					check_privilege(manager);
+				LOCK(&queue->lock);
+				/*
+				 * Work may have been queued for us, or
+				 * the manager may have finished, while we
+				 * weren't holding our queue lock; the
+				 * wakeup for that has been missed.
+				 */
+				if (task == NULL &&
+				    (manager->finished ||
+				     !empty_readyq(manager, queue)))
+					continue;
+			}
+		}
+
+		if (task == NULL) {
 			XTHREADTRACE(isc_msgcat_get(isc_msgcat,
 						    ISC_MSGSET_GENERAL,
 						    ISC_MSG_WAIT, "wait"));
-			WAIT(&manager->work_available, &manager->lock);
+			queue->idle = ISC_TRUE;
+			WAIT(&queue->work_available, &queue->lock);
+			queue->idle = ISC_FALSE;
 			XTHREADTRACE(isc_msgcat_get(isc_msgcat,
 						    ISC_MSGSET_TASK,
 						    ISC_MSG_AWAKE, "awake"));
+			continue;
+		}
+		UNLOCK(&queue->lock);
+
+		XTHREADTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TASK,
+					    ISC_MSG_WORKING, "working"));
+
+		/*
+		 * For reasons similar to those given in the comment in
+		 * isc_task_send() above, it is safe for us to dequeue
+		 * the task while only holding the queue lock, and then
+		 * change the task to running state while only holding the
+		 * task lock.
+		 */
+		requeue = run_task(task, &count);
+
+		LOCK(&from->lock);
+		from->tasks_running--;
+		if (manager->exclusive_requested || manager->pause_requested) {
+			UNLOCK(&from->lock);
+			LOCK(&manager->lock);
+			SIGNAL(&manager->exclusive_granted);
+			SIGNAL(&manager->paused);
+			UNLOCK(&manager->lock);
+		} else
+			UNLOCK(&from->lock);
+
+		if (requeue && task->threadid != threadid) {
+			/*
+			 * A bound task we stole goes back to its own
+			 * worker.
+			 */
+			home = &manager->queues[task->threadid];
+			LOCK(&home->lock);
+			push_readyq(manager, home, task);
+			SIGNAL(&home->work_available);
+			UNLOCK(&home->lock);
+			requeue = ISC_FALSE;
+		}
+
+		LOCK(&queue->lock);
+		if (requeue) {
+			/*
+			 * We know we're awake, so we don't have
+			 * to wakeup any sleeping threads if the
+			 * ready queue is empty before we requeue.
+			 *
+			 * A possible optimization if the queue is
+			 * empty is to 'goto' the 'if (task != NULL)'
+			 * block, avoiding the ENQUEUE of the task
+			 * and the subsequent immediate DEQUEUE
+			 * (since it is the only executable task).
+			 * We don't do this because then we'd be
+			 * skipping the exit_requested check.  The
+			 * cost of ENQUEUE is low anyway, especially
+			 * when you consider that we'd have to do
+			 * an extra EMPTY check to see if we could
+			 * do the optimization.  If the ready queue
+			 * were usually nonempty, the 'optimization'
+			 * might even hurt rather than help.
+			 */
+			push_readyq(manager, queue, task);
 		}
+	}
+	UNLOCK(&queue->lock);
+}
 #else /* USE_WORKER_THREADS */
+static void
+dispatch(isc__taskmgr_t *manager) {
+	isc__taskqueue_t *queue;
+	isc__task_t *task;
+	unsigned int total_dispatch_count = 0;
+	isc__tasklist_t new_ready_tasks;
+	isc__tasklist_t new_priority_tasks;
+	unsigned int tasks_ready = 0;
+
+	REQUIRE(VALID_MANAGER(manager));
+
+	queue = &manager->queues[0];
+
+	ISC_LIST_INIT(new_ready_tasks);
+	ISC_LIST_INIT(new_priority_tasks);
+	LOCK(&queue->lock);
+
+	while (!manager->finished) {
 		if (total_dispatch_count >= DEFAULT_TASKMGR_QUANTUM ||
-		    empty_readyq(manager))
+		    empty_readyq(manager, queue))
 			break;
-#endif /* USE_WORKER_THREADS */
 		XTHREADTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TASK,
 					    ISC_MSG_WORKING, "working"));
 
-		task = pop_readyq(manager);
+		task = pop_readyq(manager, queue);
 		if (task != NULL) {
-			unsigned int dispatch_count = 0;
-			isc_boolean_t done = ISC_FALSE;
-			isc_boolean_t requeue = ISC_FALSE;
-			isc_boolean_t finished = ISC_FALSE;
-			isc_event_t *event;
-
-			INSIST(VALID_TASK(task));
+			isc_boolean_t requeue;
 
 			/*
-			 * Note we only unlock the manager lock if we actually
-			 * have a task to do.  We must reacquire the manager
+			 * Note we only unlock the queue lock if we actually
+			 * have a task to do.  We must reacquire the queue
 			 * lock before exiting the 'if (task != NULL)' block.
 			 */
-			manager->tasks_ready--;
-			manager->tasks_running++;
-			UNLOCK(&manager->lock);
+			queue->tasks_ready--;
+			queue->tasks_running++;
+			UNLOCK(&queue->lock);
 
-			LOCK(&task->lock);
-			INSIST(task->state == task_state_ready);
-			task->state = task_state_running;
-			XTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
-					      ISC_MSG_RUNNING, "running"));
-			TIME_NOW(&task->tnow);
-			task->now = isc_time_seconds(&task->tnow);
-			do {
-				if (!EMPTY(task->events)) {
-					event = HEAD(task->events);
-					DEQUEUE(task->events, event, ev_link);
-					task->nevents--;
-
-					/*
-					 * Execute the event action.
-					 */
-					XTRACE(isc_msgcat_get(isc_msgcat,
-							    ISC_MSGSET_TASK,
-							    ISC_MSG_EXECUTE,
-							    "execute action"));
-					if (event->ev_action != NULL) {
-						UNLOCK(&task->lock);
-						(event->ev_action)(
-							(isc_task_t *)task,
-							event);
-						LOCK(&task->lock);
-					}
-					dispatch_count++;
-#ifndef USE_WORKER_THREADS
-					total_dispatch_count++;
-#endif /* USE_WORKER_THREADS */
-				}
-
-				if (task->references == 0 &&
-				    EMPTY(task->events) &&
-				    !TASK_SHUTTINGDOWN(task)) {
-					isc_boolean_t was_idle;
-
-					/*
-					 * There are no references and no
-					 * pending events for this task,
-					 * which means it will not become
-					 * runnable again via an external
-					 * action (such as sending an event
-					 * or detaching).
-					 *
-					 * We initiate shutdown to prevent
-					 * it from becoming a zombie.
-					 *
-					 * We do this here instead of in
-					 * the "if EMPTY(task->events)" block
-					 * below because:
-					 *
-					 *	If we post no shutdown events,
-					 *	we want the task to finish.
-					 *
-					 *	If we did post shutdown events,
-					 *	will still want the task's
-					 *	quantum to be applied.
-					 */
-					was_idle = task_shutdown(task);
-					INSIST(!was_idle);
-				}
+			requeue = run_task(task, &total_dispatch_count);
 
-				if (EMPTY(task->events)) {
-					/*
-					 * Nothing else to do for this task
-					 * right now.
-					 */
-					XTRACE(isc_msgcat_get(isc_msgcat,
-							      ISC_MSGSET_TASK,
-							      ISC_MSG_EMPTY,
-							      "empty"));
-					if (task->references == 0 &&
-					    TASK_SHUTTINGDOWN(task)) {
-						/*
-						 * The task is done.
-						 */
-						XTRACE(isc_msgcat_get(
-							       isc_msgcat,
-							       ISC_MSGSET_TASK,
-							       ISC_MSG_DONE,
-							       "done"));
-						finished = ISC_TRUE;
-						task->state = task_state_done;
-					} else
-						task->state = task_state_idle;
-					done = ISC_TRUE;
-				} else if (dispatch_count >= task->quantum) {
-					/*
-					 * Our quantum has expired, but
-					 * there is more work to be done.
-					 * We'll requeue it to the ready
-					 * queue later.
-					 *
-					 * We don't check quantum until
-					 * dispatching at least one event,
-					 * so the minimum quantum is one.
-					 */
-					XTRACE(isc_msgcat_get(isc_msgcat,
-							      ISC_MSGSET_TASK,
-							      ISC_MSG_QUANTUM,
-							      "quantum"));
-					task->state = task_state_ready;
-					requeue = ISC_TRUE;
-					done = ISC_TRUE;
-				}
-			} while (!done);
-			UNLOCK(&task->lock);
-
-			if (finished)
-				task_finished(task);
-
-			LOCK(&manager->lock);
-			manager->tasks_running--;
-#ifdef USE_WORKER_THREADS
-			if (manager->exclusive_requested &&
-			    manager->tasks_running == 1) {
-				SIGNAL(&manager->exclusive_granted);
-			} else if (manager->pause_requested &&
-				   manager->tasks_running == 0) {
-				SIGNAL(&manager->paused);
-			}
-#endif /* USE_WORKER_THREADS */
+			LOCK(&queue->lock);
+			queue->tasks_running--;
 			if (requeue) {
-				/*
-				 * We know we're awake, so we don't have
-				 * to wakeup any sleeping threads if the
-				 * ready queue is empty before we requeue.
-				 *
-				 * A possible optimization if the queue is
-				 * empty is to 'goto' the 'if (task != NULL)'
-				 * block, avoiding the ENQUEUE of the task
-				 * and the subsequent immediate DEQUEUE
-				 * (since it is the only executable task).
-				 * We don't do this because then we'd be
-				 * skipping the exit_requested check.  The
-				 * cost of ENQUEUE is low anyway, especially
-				 * when you consider that we'd have to do
-				 * an extra EMPTY check to see if we could
-				 * do the optimization.  If the ready queue
-				 * were usually nonempty, the 'optimization'
-				 * might even hurt rather than help.
-				 */
-#ifdef USE_WORKER_THREADS
-				push_readyq(manager, task);
-#else
 				ENQUEUE(new_ready_tasks, task, ready_link);
 				if ((task->flags & TASK_F_PRIVILEGED) != 0)
 					ENQUEUE(new_priority_tasks, task,
 						ready_priority_link);
 				tasks_ready++;
-#endif
 			}
 		}
-
-#ifdef USE_WORKER_THREADS
-		/*
-		 * If we are in privileged execution mode and there are no
-		 * tasks remaining on the current ready queue, then
-		 * we're stuck.  Automatically drop privileges at that
-		 * point and continue with the regular ready queue.
-		 */
-		if (manager->tasks_running == 0 && empty_readyq(manager)) {
-			manager->mode = isc_taskmgrmode_normal;
-			if (!empty_readyq(manager))
-				BROADCAST(&manager->work_available);
-		}
-#endif
 	}
 
-#ifndef USE_WORKER_THREADS
-	ISC_LIST_APPENDLIST(manager->ready_tasks, new_ready_tasks, ready_link);
-	ISC_LIST_APPENDLIST(manager->ready_priority_tasks, new_priority_tasks,
+	ISC_LIST_APPENDLIST(queue->ready_tasks, new_ready_tasks, ready_link);
+	ISC_LIST_APPENDLIST(queue->ready_priority_tasks, new_priority_tasks,
 			    ready_priority_link);
-	manager->tasks_ready += tasks_ready;
-	if (empty_readyq(manager))
+	queue->tasks_ready += tasks_ready;
+	if (empty_readyq(manager, queue))
 		manager->mode = isc_taskmgrmode_normal;
-#endif
 
-	UNLOCK(&manager->lock);
+	UNLOCK(&queue->lock);
 }
+#endif /* USE_WORKER_THREADS */
 
 #ifdef USE_WORKER_THREADS
 static isc_threadresult_t
@@ -1304,12 +1856,12 @@ static isc_threadresult_t
 WINAPI
 #endif
 run(void *uap) {
-	isc__taskmgr_t *manager = uap;
+	isc__taskqueue_t *queue = uap;
 
 	XTHREADTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 				    ISC_MSG_STARTING, "starting"));
 
-	dispatch(manager);
+	dispatch(queue->manager, queue->threadid);
 
 	XTHREADTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 				    ISC_MSG_EXITING, "exiting"));
@@ -1324,14 +1876,30 @@ run(void *uap) {
 
 static void
 manager_free(isc__taskmgr_t *manager) {
+	isc__taskstats_t *stats;
 	isc_mem_t *mctx;
+	unsigned int i;
 
+	for (i = 0; i < manager->nqueues; i++) {
+#ifdef USE_WORKER_THREADS
+		(void)isc_condition_destroy(
+				&manager->queues[i].work_available);
+#endif /* USE_WORKER_THREADS */
+		DESTROYLOCK(&manager->queues[i].lock);
+	}
+	isc_mem_put(manager->mctx, manager->queues,
+		    manager->nqueues * sizeof(isc__taskqueue_t));
 #ifdef USE_WORKER_THREADS
 	(void)isc_condition_destroy(&manager->exclusive_granted);
-	(void)isc_condition_destroy(&manager->work_available);
 	(void)isc_condition_destroy(&manager->paused);
 	isc_mem_free(manager->mctx, manager->threads);
 #endif /* USE_WORKER_THREADS */
+	while ((stats = HEAD(manager->taskstats)) != NULL) {
+		UNLINK(manager->taskstats, stats, link);
+		isc_stats_detach(&stats->counters);
+		isc_mem_put(manager->mctx, stats, sizeof(*stats));
+	}
+	DESTROYLOCK(&manager->stats_lock);
 	DESTROYLOCK(&manager->lock);
 	DESTROYLOCK(&manager->excl_lock);
 	manager->common.impmagic = 0;
@@ -1361,7 +1929,6 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 	REQUIRE(managerp != NULL && *managerp == NULL);
 
 #ifndef USE_WORKER_THREADS
-	UNUSED(i);
 	UNUSED(started);
 #endif
 
@@ -1391,6 +1958,12 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 		DESTROYLOCK(&manager->lock);
 		goto cleanup_mgr;
 	}
+	result = isc_mutex_init(&manager->stats_lock);
+	if (result != ISC_R_SUCCESS) {
+		DESTROYLOCK(&manager->excl_lock);
+		DESTROYLOCK(&manager->lock);
+		goto cleanup_mgr;
+	}
 
 #ifdef USE_WORKER_THREADS
 	manager->workers = 0;
@@ -1400,21 +1973,53 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 		result = ISC_R_NOMEMORY;
 		goto cleanup_lock;
 	}
-	if (isc_condition_init(&manager->work_available) != ISC_R_SUCCESS) {
-		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "isc_condition_init() %s",
-				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
-						ISC_MSG_FAILED, "failed"));
-		result = ISC_R_UNEXPECTED;
+	manager->nqueues = workers;
+#else
+	manager->nqueues = 1;
+#endif /* USE_WORKER_THREADS */
+	manager->queues = isc_mem_get(mctx, manager->nqueues *
+				      sizeof(isc__taskqueue_t));
+	if (manager->queues == NULL) {
+		result = ISC_R_NOMEMORY;
 		goto cleanup_threads;
 	}
+	for (i = 0; i < manager->nqueues; i++) {
+		isc__taskqueue_t *queue = &manager->queues[i];
+
+		queue->manager = manager;
+		queue->threadid = i;
+		INIT_LIST(queue->ready_tasks);
+		INIT_LIST(queue->ready_priority_tasks);
+		queue->tasks_running = 0;
+		queue->tasks_ready = 0;
+		result = isc_mutex_init(&queue->lock);
+		if (result != ISC_R_SUCCESS)
+			goto cleanup_queues;
+#ifdef USE_WORKER_THREADS
+		queue->idle = ISC_FALSE;
+		if (isc_condition_init(&queue->work_available) !=
+		    ISC_R_SUCCESS)
+		{
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "isc_condition_init() %s",
+					 isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_GENERAL,
+							ISC_MSG_FAILED,
+							"failed"));
+			DESTROYLOCK(&queue->lock);
+			result = ISC_R_UNEXPECTED;
+			goto cleanup_queues;
+		}
+#endif /* USE_WORKER_THREADS */
+	}
+#ifdef USE_WORKER_THREADS
 	if (isc_condition_init(&manager->exclusive_granted) != ISC_R_SUCCESS) {
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
 				 "isc_condition_init() %s",
 				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 						ISC_MSG_FAILED, "failed"));
 		result = ISC_R_UNEXPECTED;
-		goto cleanup_workavailable;
+		goto cleanup_queues;
 	}
 	if (isc_condition_init(&manager->paused) != ISC_R_SUCCESS) {
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
@@ -1429,14 +2034,14 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 		default_quantum = DEFAULT_DEFAULT_QUANTUM;
 	manager->default_quantum = default_quantum;
 	INIT_LIST(manager->tasks);
-	INIT_LIST(manager->ready_tasks);
-	INIT_LIST(manager->ready_priority_tasks);
-	manager->tasks_running = 0;
-	manager->tasks_ready = 0;
+	manager->curq = 0;
 	manager->exclusive_requested = ISC_FALSE;
 	manager->pause_requested = ISC_FALSE;
 	manager->exiting = ISC_FALSE;
+	manager->finished = ISC_FALSE;
 	manager->excl = NULL;
+	manager->latencystats = ISC_FALSE;
+	INIT_LIST(manager->taskstats);
 
 	isc_mem_attach(mctx, &manager->mctx);
 
@@ -1446,7 +2051,8 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 	 * Start workers.
 	 */
 	for (i = 0; i < workers; i++) {
-		if (isc_thread_create(run, manager,
+		if (isc_thread_create(run,
+				      &manager->queues[manager->workers],
 				      &manager->threads[manager->workers]) ==
 		    ISC_R_SUCCESS) {
 			char name[16];	/* thread name limit on Linux */
@@ -1477,13 +2083,25 @@ isc__taskmgr_create(isc_mem_t *mctx, unsigned int workers,
 #ifdef USE_WORKER_THREADS
  cleanup_exclusivegranted:
 	(void)isc_condition_destroy(&manager->exclusive_granted);
- cleanup_workavailable:
-	(void)isc_condition_destroy(&manager->work_available);
+#endif
+ cleanup_queues:
+	while (i-- > 0) {
+#ifdef USE_WORKER_THREADS
+		(void)isc_condition_destroy(
+				&manager->queues[i].work_available);
+#endif
+		DESTROYLOCK(&manager->queues[i].lock);
+	}
+	isc_mem_put(mctx, manager->queues,
+		    manager->nqueues * sizeof(isc__taskqueue_t));
  cleanup_threads:
+#ifdef USE_WORKER_THREADS
 	isc_mem_free(mctx, manager->threads);
  cleanup_lock:
-	DESTROYLOCK(&manager->lock);
 #endif
+	DESTROYLOCK(&manager->stats_lock);
+	DESTROYLOCK(&manager->lock);
+	DESTROYLOCK(&manager->excl_lock);
  cleanup_mgr:
 	isc_mem_put(mctx, manager, sizeof(*manager));
 	return (result);
@@ -1542,6 +2160,7 @@ isc__taskmgr_destroy(isc_taskmgr_t **managerp) {
 	 */
 
 	LOCK(&manager->lock);
+	lock_queues(manager);
 
 	/*
 	 * Make sure we only get called once.
@@ -1563,16 +2182,19 @@ isc__taskmgr_destroy(isc_taskmgr_t **managerp) {
 	     task = NEXT(task, link)) {
 		LOCK(&task->lock);
 		if (task_shutdown(task))
-			push_readyq(manager, task);
+			push_readyq(manager, &manager->queues[task->threadid],
+				    task);
 		UNLOCK(&task->lock);
 	}
+	if (FINISHED(manager))
+		manager->finished = ISC_TRUE;
 #ifdef USE_WORKER_THREADS
 	/*
 	 * Wake up any sleeping workers.  This ensures we get work done if
 	 * there's work left to do, and if there are already no tasks left
-	 * it will cause the workers to see manager->exiting.
+	 * it will cause the workers to see manager->finished.
 	 */
-	BROADCAST(&manager->work_available);
+	unlock_queues(manager, ISC_TRUE);
 	UNLOCK(&manager->lock);
 
 	/*
@@ -1584,6 +2206,7 @@ isc__taskmgr_destroy(isc_taskmgr_t **managerp) {
 	/*
 	 * Dispatch the shutdown events.
 	 */
+	unlock_queues(manager, ISC_FALSE);
 	UNLOCK(&manager->lock);
 	while (isc__taskmgr_ready((isc_taskmgr_t *)manager))
 		(void)isc__taskmgr_dispatch((isc_taskmgr_t *)manager);
@@ -1605,7 +2228,9 @@ isc__taskmgr_setmode(isc_taskmgr_t *manager0, isc_taskmgrmode_t mode) {
 	isc__taskmgr_t *manager = (isc__taskmgr_t *)manager0;
 
 	LOCK(&manager->lock);
+	lock_queues(manager);
 	manager->mode = mode;
+	unlock_queues(manager, ISC_TRUE);
 	UNLOCK(&manager->lock);
 }
 
@@ -1632,9 +2257,9 @@ isc__taskmgr_ready(isc_taskmgr_t *manager0) {
 	if (manager == NULL)
 		return (ISC_FALSE);
 
-	LOCK(&manager->lock);
-	is_ready = !empty_readyq(manager);
-	UNLOCK(&manager->lock);
+	LOCK(&manager->queues[0].lock);
+	is_ready = !empty_readyq(manager, &manager->queues[0]);
+	UNLOCK(&manager->queues[0].lock);
 
 	return (is_ready);
 }
@@ -1659,9 +2284,12 @@ isc__taskmgr_dispatch(isc_taskmgr_t *manager0) {
 void
 isc__taskmgr_pause(isc_taskmgr_t *manager0) {
 	isc__taskmgr_t *manager = (isc__taskmgr_t *)manager0;
-	manager->pause_requested = ISC_TRUE;
+
 	LOCK(&manager->lock);
-	while (manager->tasks_running > 0) {
+	lock_queues(manager);
+	manager->pause_requested = ISC_TRUE;
+	unlock_queues(manager, ISC_FALSE);
+	while (tasks_running(manager) > 0) {
 		WAIT(&manager->paused, &manager->lock);
 	}
 	UNLOCK(&manager->lock);
@@ -1673,8 +2301,9 @@ isc__taskmgr_resume(isc_taskmgr_t *manager0) {
 
 	LOCK(&manager->lock);
 	if (manager->pause_requested) {
+		lock_queues(manager);
 		manager->pause_requested = ISC_FALSE;
-		BROADCAST(&manager->work_available);
+		unlock_queues(manager, ISC_TRUE);
 	}
 	UNLOCK(&manager->lock);
 }
@@ -1712,6 +2341,63 @@ isc_taskmgr_excltask(isc_taskmgr_t *mgr0, isc_task_t **taskp) {
 	return (result);
 }
 
+isc_result_t
+isc_taskmgr_setaffinity(isc_taskmgr_t *mgr0, const unsigned int *cpus,
+			unsigned int ncpus)
+{
+	isc__taskmgr_t *mgr = (isc__taskmgr_t *) mgr0;
+	isc_result_t result = ISC_R_SUCCESS;
+#ifdef USE_WORKER_THREADS
+	isc_result_t tresult;
+	unsigned int i;
+#endif
+
+	REQUIRE(VALID_MANAGER(mgr));
+	REQUIRE(cpus != NULL || ncpus == 0);
+
+#ifdef USE_WORKER_THREADS
+	LOCK(&mgr->lock);
+	for (i = 0; i < mgr->workers; i++) {
+		tresult = isc_thread_setaffinity(mgr->threads[i],
+						 ncpus == 0 ? -1 :
+						 (int)cpus[i % ncpus]);
+		if (tresult != ISC_R_SUCCESS && result == ISC_R_SUCCESS)
+			result = tresult;
+	}
+	UNLOCK(&mgr->lock);
+#else
+	if (ncpus != 0)
+		result = ISC_R_NOTIMPLEMENTED;
+#endif
+
+	return (result);
+}
+
+void
+isc_taskmgr_setlatencystats(isc_taskmgr_t *mgr0, isc_boolean_t enable) {
+	isc__taskmgr_t *mgr = (isc__taskmgr_t *) mgr0;
+
+	REQUIRE(VALID_MANAGER(mgr));
+
+	LOCK(&mgr->stats_lock);
+	mgr->latencystats = enable;
+	UNLOCK(&mgr->stats_lock);
+}
+
+isc_boolean_t
+isc_taskmgr_latencystats(isc_taskmgr_t *mgr0) {
+	isc__taskmgr_t *mgr = (isc__taskmgr_t *) mgr0;
+	isc_boolean_t enabled;
+
+	REQUIRE(VALID_MANAGER(mgr));
+
+	LOCK(&mgr->stats_lock);
+	enabled = mgr->latencystats;
+	UNLOCK(&mgr->stats_lock);
+
+	return (enabled);
+}
+
 isc_result_t
 isc__task_beginexclusive(isc_task_t *task0) {
 #ifdef USE_WORKER_THREADS
@@ -1729,8 +2415,10 @@ isc__task_beginexclusive(isc_task_t *task0) {
 		UNLOCK(&manager->lock);
 		return (ISC_R_LOCKBUSY);
 	}
+	lock_queues(manager);
 	manager->exclusive_requested = ISC_TRUE;
-	while (manager->tasks_running > 1) {
+	unlock_queues(manager, ISC_FALSE);
+	while (tasks_running(manager) > 1) {
 		WAIT(&manager->exclusive_granted, &manager->lock);
 	}
 	UNLOCK(&manager->lock);
@@ -1749,8 +2437,9 @@ isc__task_endexclusive(isc_task_t *task0) {
 	REQUIRE(task->state == task_state_running);
 	LOCK(&manager->lock);
 	REQUIRE(manager->exclusive_requested);
+	lock_queues(manager);
 	manager->exclusive_requested = ISC_FALSE;
-	BROADCAST(&manager->work_available);
+	unlock_queues(manager, ISC_TRUE);
 	UNLOCK(&manager->lock);
 #else
 	UNUSED(task0);
@@ -1761,6 +2450,7 @@ void
 isc__task_setprivilege(isc_task_t *task0, isc_boolean_t priv) {
 	isc__task_t *task = (isc__task_t *)task0;
 	isc__taskmgr_t *manager = task->manager;
+	isc__taskqueue_t *queue;
 	isc_boolean_t oldpriv;
 
 	LOCK(&task->lock);
@@ -1774,13 +2464,20 @@ isc__task_setprivilege(isc_task_t *task0, isc_boolean_t priv) {
 	if (priv == oldpriv)
 		return;
 
+	/*
+	 * The task's ready queue can change whenever a worker steals it,
+	 * so hold every queue lock while moving it between the lists.
+	 */
 	LOCK(&manager->lock);
+	lock_queues(manager);
+	queue = &manager->queues[task->threadid];
 	if (priv && ISC_LINK_LINKED(task, ready_link))
-		ENQUEUE(manager->ready_priority_tasks, task,
+		ENQUEUE(queue->ready_priority_tasks, task,
 			ready_priority_link);
 	else if (!priv && ISC_LINK_LINKED(task, ready_priority_link))
-		DEQUEUE(manager->ready_priority_tasks, task,
+		DEQUEUE(queue->ready_priority_tasks, task,
 			ready_priority_link);
+	unlock_queues(manager, ISC_FALSE);
 	UNLOCK(&manager->lock);
 }
 
@@ -1809,12 +2506,33 @@ isc_task_exiting(isc_task_t *t) {
 }
 
 
+#if defined(HAVE_LIBXML2) || defined(HAVE_JSON)
+static void
+taskstats_dump(isc_statscounter_t counter, isc_uint64_t value, void *arg) {
+	isc_uint64_t *values = arg;
+
+	values[counter] = value;
+}
+
+/*
+ * Lower bound of histogram bucket 'bucket'.
+ */
+static isc_uint64_t
+taskstats_lower(unsigned int bucket) {
+	return (bucket == 0 ? 0 : (isc_uint64_t)1 << (bucket - 1));
+}
+#endif /* HAVE_LIBXML2 || HAVE_JSON */
+
 #ifdef HAVE_LIBXML2
 #define TRY0(a) do { xmlrc = (a); if (xmlrc < 0) goto error; } while(0)
 int
 isc_taskmgr_renderxml(isc_taskmgr_t *mgr0, xmlTextWriterPtr writer) {
 	isc__taskmgr_t *mgr = (isc__taskmgr_t *)mgr0;
 	isc__task_t *task = NULL;
+	isc__taskstats_t *stats;
+	isc_uint64_t values[taskstats_max * TASKSTATS_BUCKETS];
+	isc_boolean_t statslocked = ISC_FALSE;
+	unsigned int type, bucket;
 	int xmlrc;
 
 	LOCK(&mgr->lock);
@@ -1848,11 +2566,13 @@ isc_taskmgr_renderxml(isc_taskmgr_t *mgr0, xmlTextWriterPtr writer) {
 	TRY0(xmlTextWriterEndElement(writer)); /* default-quantum */
 
 	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "tasks-running"));
-	TRY0(xmlTextWriterWriteFormatString(writer, "%d", mgr->tasks_running));
+	TRY0(xmlTextWriterWriteFormatString(writer, "%d",
+					    tasks_running(mgr)));
 	TRY0(xmlTextWriterEndElement(writer)); /* tasks-running */
 
 	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "tasks-ready"));
-	TRY0(xmlTextWriterWriteFormatString(writer, "%d", mgr->tasks_ready));
+	TRY0(xmlTextWriterWriteFormatString(writer, "%d",
+					    tasks_ready(mgr)));
 	TRY0(xmlTextWriterEndElement(writer)); /* tasks-ready */
 
 	TRY0(xmlTextWriterEndElement(writer)); /* thread-model */
@@ -1903,7 +2623,59 @@ isc_taskmgr_renderxml(isc_taskmgr_t *mgr0, xmlTextWriterPtr writer) {
 	}
 	TRY0(xmlTextWriterEndElement(writer)); /* tasks */
 
+	LOCK(&mgr->stats_lock);
+	statslocked = ISC_TRUE;
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "task-latency"));
+	TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "enabled",
+					 ISC_XMLCHAR (mgr->latencystats ?
+						      "yes" : "no")));
+	for (stats = ISC_LIST_HEAD(mgr->taskstats);
+	     stats != NULL;
+	     stats = ISC_LIST_NEXT(stats, link))
+	{
+		memset(values, 0, sizeof(values));
+		isc_stats_dump(stats->counters, taskstats_dump, values, 0);
+
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "task"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "name",
+						 ISC_XMLCHAR stats->name));
+		for (type = 0; type < taskstats_max; type++) {
+			TRY0(xmlTextWriterStartElement(writer,
+						ISC_XMLCHAR "histogram"));
+			TRY0(xmlTextWriterWriteAttribute(writer,
+						ISC_XMLCHAR "type",
+						ISC_XMLCHAR
+						taskstats_names[type]));
+			TRY0(xmlTextWriterWriteAttribute(writer,
+						ISC_XMLCHAR "unit",
+						ISC_XMLCHAR
+						taskstats_units[type]));
+			for (bucket = 0; bucket < TASKSTATS_BUCKETS; bucket++) {
+				isc_uint64_t value;
+
+				value = values[type * TASKSTATS_BUCKETS +
+					       bucket];
+				if (value == 0)
+					continue;
+				TRY0(xmlTextWriterStartElement(writer,
+							ISC_XMLCHAR "bucket"));
+				TRY0(xmlTextWriterWriteFormatAttribute(writer,
+					ISC_XMLCHAR "ge",
+					"%" ISC_PRINT_QUADFORMAT "u",
+					taskstats_lower(bucket)));
+				TRY0(xmlTextWriterWriteFormatString(writer,
+					"%" ISC_PRINT_QUADFORMAT "u", value));
+				TRY0(xmlTextWriterEndElement(writer));
+			}
+			TRY0(xmlTextWriterEndElement(writer)); /* histogram */
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* task */
+	}
+	TRY0(xmlTextWriterEndElement(writer)); /* task-latency */
+
  error:
+	if (statslocked)
+		UNLOCK(&mgr->stats_lock);
 	if (task != NULL)
 		UNLOCK(&task->lock);
 	UNLOCK(&mgr->lock);
@@ -1925,7 +2697,12 @@ isc_taskmgr_renderjson(isc_taskmgr_t *mgr0, json_object *tasks) {
 	isc_result_t result = ISC_R_SUCCESS;
 	isc__taskmgr_t *mgr = (isc__taskmgr_t *)mgr0;
 	isc__task_t *task = NULL;
+	isc__taskstats_t *stats;
+	isc_uint64_t values[taskstats_max * TASKSTATS_BUCKETS];
+	isc_boolean_t statslocked = ISC_FALSE;
+	unsigned int type, bucket;
 	json_object *obj = NULL, *array = NULL, *taskobj = NULL;
+	json_object *latency = NULL, *histobj;
 
 	LOCK(&mgr->lock);
 
@@ -1955,11 +2732,11 @@ isc_taskmgr_renderjson(isc_taskmgr_t *mgr0, json_object *tasks) {
 	CHECKMEM(obj);
 	json_object_object_add(tasks, "default-quantum", obj);
 
-	obj = json_object_new_int(mgr->tasks_running);
+	obj = json_object_new_int(tasks_running(mgr));
 	CHECKMEM(obj);
 	json_object_object_add(tasks, "tasks-running", obj);
 
-	obj = json_object_new_int(mgr->tasks_ready);
+	obj = json_object_new_int(tasks_ready(mgr));
 	CHECKMEM(obj);
 	json_object_object_add(tasks, "tasks-ready", obj);
 
@@ -2010,9 +2787,60 @@ isc_taskmgr_renderjson(isc_taskmgr_t *mgr0, json_object *tasks) {
 
 	json_object_object_add(tasks, "tasks", array);
 	array = NULL;
+
+	latency = json_object_new_object();
+	CHECKMEM(latency);
+
+	LOCK(&mgr->stats_lock);
+	statslocked = ISC_TRUE;
+	obj = json_object_new_boolean(mgr->latencystats);
+	CHECKMEM(obj);
+	json_object_object_add(latency, "enabled", obj);
+
+	for (stats = ISC_LIST_HEAD(mgr->taskstats);
+	     stats != NULL;
+	     stats = ISC_LIST_NEXT(stats, link))
+	{
+		memset(values, 0, sizeof(values));
+		isc_stats_dump(stats->counters, taskstats_dump, values, 0);
+
+		taskobj = json_object_new_object();
+		CHECKMEM(taskobj);
+		json_object_object_add(latency, stats->name, taskobj);
+
+		for (type = 0; type < taskstats_max; type++) {
+			histobj = json_object_new_object();
+			CHECKMEM(histobj);
+			json_object_object_add(taskobj, taskstats_names[type],
+					       histobj);
+
+			for (bucket = 0; bucket < TASKSTATS_BUCKETS; bucket++) {
+				char buf[32];
+				isc_uint64_t value;
+
+				value = values[type * TASKSTATS_BUCKETS +
+					       bucket];
+				if (value == 0)
+					continue;
+				obj = json_object_new_int64(value);
+				CHECKMEM(obj);
+				snprintf(buf, sizeof(buf),
+					 "%" ISC_PRINT_QUADFORMAT "u",
+					 taskstats_lower(bucket));
+				json_object_object_add(histobj, buf, obj);
+			}
+		}
+	}
+
+	json_object_object_add(tasks, "task-latency", latency);
+	latency = NULL;
 	result = ISC_R_SUCCESS;
 
  error:
+	if (statslocked)
+		UNLOCK(&mgr->stats_lock);
+	if (latency != NULL)
+		json_object_put(latency);
 	if (array != NULL)
 		json_object_put(array);
 
@@ -16,8 +16,11 @@
 #include "isctest.h"
 
 #include <isc/mem.h>
+#include <isc/mutex.h>
 #include <isc/print.h>
 #include <isc/result.h>
+#include <isc/thread.h>
+#include <isc/util.h>
 
 static void *
 default_memalloc(void *arg, size_t size) {
@@ -141,12 +144,127 @@ ATF_TC_BODY(isc_mem_inuse, tc) {
 	isc_test_end();
 }
 
+#ifdef ISC_PLATFORM_USETHREADS
+#define TC_THREADS	4
+#define TC_ITERATIONS	20000
+
+static isc_mem_t *tc_mctx = NULL;
+static isc_mempool_t *tc_pool = NULL;
+
+static isc_threadresult_t
+#ifdef WIN32
+WINAPI
+#endif
+tc_thread(isc_threadarg_t arg) {
+	void *ptrs[8], *items[8];
+	unsigned int i, j;
+
+	UNUSED(arg);
+
+	for (i = 0; i < TC_ITERATIONS; i++) {
+		for (j = 0; j < 8; j++) {
+			ptrs[j] = isc_mem_get(tc_mctx, 16 + j * 40);
+			items[j] = isc_mempool_get(tc_pool);
+		}
+		for (j = 0; j < 8; j++) {
+			if (ptrs[j] != NULL)
+				isc_mem_put(tc_mctx, ptrs[j], 16 + j * 40);
+			if (items[j] != NULL)
+				isc_mempool_put(tc_pool, items[j]);
+		}
+	}
+
+	return ((isc_threadresult_t)0);
+}
+#endif
+
+ATF_TC(isc_mem_threadcache);
+ATF_TC_HEAD(isc_mem_threadcache, tc) {
+	atf_tc_set_md_var(tc, "descr", "per-thread memory caches");
+}
+
+ATF_TC_BODY(isc_mem_threadcache, tc) {
+#ifdef ISC_PLATFORM_USETHREADS
+	isc_result_t result;
+	isc_thread_t threads[TC_THREADS];
+	isc_mutex_t lock;
+	size_t before;
+	void *ptr, *ptr2;
+	unsigned int i, debugging;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/* The caches are bypassed while recording allocations. */
+	debugging = isc_mem_debugging;
+	isc_mem_debugging = 0;
+
+	result = isc_mem_createx2(0, 0, default_memalloc, default_memfree,
+				  NULL, &tc_mctx, ISC_MEMFLAG_INTERNAL |
+				  ISC_MEMFLAG_THREADCACHE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * A block that is put is the next one got, and stays counted
+	 * as in use while it is cached.
+	 */
+	before = isc_mem_inuse(tc_mctx);
+	ptr = isc_mem_get(tc_mctx, 100);
+	ATF_REQUIRE(ptr != NULL);
+	ATF_CHECK(isc_mem_inuse(tc_mctx) >= before + 100);
+	ptr2 = ptr;
+	isc_mem_put(tc_mctx, ptr, 100);
+	ATF_CHECK(isc_mem_inuse(tc_mctx) >= before + 100);
+	ptr = isc_mem_get(tc_mctx, 100);
+	ATF_CHECK_EQ(ptr, ptr2);
+	isc_mem_put(tc_mctx, ptr, 100);
+
+	result = isc_mutex_init(&lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_mempool_create(tc_mctx, 48, &tc_pool);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	isc_mempool_associatelock(tc_pool, &lock);
+	isc_mempool_setmaxalloc(tc_pool, TC_THREADS * 8 + 32);
+
+	for (i = 0; i < TC_THREADS; i++) {
+		result = isc_thread_create(tc_thread, NULL, &threads[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	}
+	for (i = 0; i < TC_THREADS; i++)
+		ATF_CHECK_EQ(isc_thread_join(threads[i], NULL),
+			     ISC_R_SUCCESS);
+
+	/*
+	 * Items left in the caches of the exited threads still count
+	 * as allocated, within bounds.
+	 */
+	ATF_CHECK(isc_mempool_getallocated(tc_pool) <= TC_THREADS * 8 + 32);
+
+	/*
+	 * Destroying the pool and the context returns the cached
+	 * items; leaks would trigger an assertion.
+	 */
+	isc_mempool_destroy(&tc_pool);
+	DESTROYLOCK(&lock);
+	isc_mem_destroy(&tc_mctx);
+
+	isc_mem_debugging = debugging;
+	isc_test_end();
+#else
+	UNUSED(tc);
+	atf_tc_skip("threads not enabled");
+#endif
+}
+
 /*
  * Main
  */
 ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, isc_mem_total);
 	ATF_TP_ADD_TC(tp, isc_mem_inuse);
+	ATF_TP_ADD_TC(tp, isc_mem_threadcache);
 
 	return (atf_no_error());
 }
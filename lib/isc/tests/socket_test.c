@@ -313,6 +313,278 @@ ATF_TC_BODY(udp_dup, tc) {
 	isc_test_end();
 }
 
+/* Test binding several UDP sockets to one port with SO_REUSEPORT */
+ATF_TC(udp_reuseport);
+ATF_TC_HEAD(udp_reuseport, tc) {
+	atf_tc_set_md_var(tc, "descr", "SO_REUSEPORT bind/sendto/recv");
+}
+ATF_TC_BODY(udp_reuseport, tc) {
+	isc_result_t result;
+	isc_sockaddr_t addr1, addr2;
+	struct in_addr in;
+	isc_socket_t *s1 = NULL, *s2 = NULL, *s3 = NULL;
+	isc_task_t *task = NULL;
+	char sendbuf[BUFSIZ], recvbuf[BUFSIZ];
+	completion_t completion;
+	isc_region_t r;
+	unsigned int options = ISC_SOCKET_REUSEADDRESS | ISC_SOCKET_REUSEPORT;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	in.s_addr = inet_addr("127.0.0.1");
+	isc_sockaddr_fromin(&addr1, &in, 0);
+	isc_sockaddr_fromin(&addr2, &in, 0);
+
+	result = isc_socket_create(socketmgr, PF_INET, isc_sockettype_udp, &s1);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_bind(s1, &addr1, 0);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Pick a free port, then bind two sockets to it.
+	 */
+	result = isc_socket_create(socketmgr, PF_INET, isc_sockettype_udp, &s2);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_bind(s2, &addr2, options);
+	if (result == ISC_R_NOTIMPLEMENTED) {
+		isc_socket_detach(&s1);
+		isc_socket_detach(&s2);
+		isc_test_end();
+		atf_tc_skip("SO_REUSEPORT not supported");
+	}
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_getsockname(s2, &addr2);
+	ATF_CHECK_EQ_MSG(result, ISC_R_SUCCESS, "%s",
+			 isc_result_totext(result));
+	ATF_REQUIRE(isc_sockaddr_getport(&addr2) != 0);
+
+	result = isc_socket_create(socketmgr, PF_INET, isc_sockettype_udp, &s3);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_bind(s3, &addr2, options);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_task_create(taskmgr, 0, &task);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	snprintf(sendbuf, sizeof(sendbuf), "Hello");
+	r.base = (void *) sendbuf;
+	r.length = strlen(sendbuf) + 1;
+
+	completion_init(&completion);
+	result = isc_socket_sendto(s1, &r, task, event_done, &completion,
+				   &addr2, NULL);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	waitfor(&completion);
+	ATF_CHECK(completion.done);
+	ATF_CHECK_EQ(completion.result, ISC_R_SUCCESS);
+
+	/*
+	 * The kernel delivers the datagram to exactly one of the two
+	 * sockets; cancel the receive that does not complete.
+	 */
+	r.base = (void *) recvbuf;
+	r.length = BUFSIZ;
+	completion_init(&completion);
+	result = isc_socket_recv(s2, &r, 1, task, event_done, &completion);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_recv(s3, &r, 1, task, event_done, &completion);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	waitfor(&completion);
+	ATF_CHECK(completion.done);
+	ATF_CHECK_EQ(completion.result, ISC_R_SUCCESS);
+	ATF_CHECK_STREQ(recvbuf, "Hello");
+
+	isc_socket_cancel(s2, task, ISC_SOCKCANCEL_RECV);
+	isc_socket_cancel(s3, task, ISC_SOCKCANCEL_RECV);
+
+	isc_task_detach(&task);
+
+	isc_socket_detach(&s1);
+	isc_socket_detach(&s2);
+	isc_socket_detach(&s3);
+
+	isc_test_end();
+}
+
+/* Test batched UDP sendto/recv (IPv4) */
+#define NBATCH 4
+ATF_TC(udp_batch);
+ATF_TC_HEAD(udp_batch, tc) {
+	atf_tc_set_md_var(tc, "descr", "batched sendto/recv");
+}
+ATF_TC_BODY(udp_batch, tc) {
+	isc_result_t result;
+	isc_sockaddr_t addr1, addr2;
+	struct in_addr in;
+	isc_socket_t *s1 = NULL, *s2 = NULL;
+	isc_task_t *task = NULL;
+	char sendbuf[NBATCH][BUFSIZ], recvbuf[NBATCH][BUFSIZ];
+	completion_t scompletion[NBATCH], rcompletion[NBATCH];
+	isc_region_t r;
+	int i;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	isc__socketmgr_setudpbatch(socketmgr, 8);
+
+	in.s_addr = inet_addr("127.0.0.1");
+	isc_sockaddr_fromin(&addr1, &in, 0);
+	isc_sockaddr_fromin(&addr2, &in, 0);
+
+	result = isc_socket_create(socketmgr, PF_INET, isc_sockettype_udp, &s1);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_bind(s1, &addr1, 0);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_socket_create(socketmgr, PF_INET, isc_sockettype_udp, &s2);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_bind(s2, &addr2, 0);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	result = isc_socket_getsockname(s2, &addr2);
+	ATF_CHECK_EQ_MSG(result, ISC_R_SUCCESS, "%s",
+			 isc_result_totext(result));
+	ATF_REQUIRE(isc_sockaddr_getport(&addr2) != 0);
+
+	result = isc_task_create(taskmgr, 0, &task);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Queue all the receives first so that they can be
+	 * satisfied by a single batched system call.
+	 */
+	for (i = 0; i < NBATCH; i++) {
+		r.base = (void *) recvbuf[i];
+		r.length = BUFSIZ;
+		completion_init(&rcompletion[i]);
+		result = isc_socket_recv(s2, &r, 1, task, event_done,
+					 &rcompletion[i]);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	}
+
+	for (i = 0; i < NBATCH; i++) {
+		snprintf(sendbuf[i], sizeof(sendbuf[i]), "Hello %d", i);
+		r.base = (void *) sendbuf[i];
+		r.length = strlen(sendbuf[i]) + 1;
+		completion_init(&scompletion[i]);
+		result = isc_socket_sendto(s1, &r, task, event_done,
+					   &scompletion[i], &addr2, NULL);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	}
+
+	for (i = 0; i < NBATCH; i++) {
+		waitfor2(&scompletion[i], &rcompletion[i]);
+		ATF_CHECK(scompletion[i].done);
+		ATF_CHECK_EQ(scompletion[i].result, ISC_R_SUCCESS);
+		ATF_CHECK(rcompletion[i].done);
+		ATF_CHECK_EQ(rcompletion[i].result, ISC_R_SUCCESS);
+		ATF_CHECK_STREQ(recvbuf[i], sendbuf[i]);
+	}
+
+	isc_task_detach(&task);
+
+	isc_socket_detach(&s1);
+	isc_socket_detach(&s2);
+
+	isc__socketmgr_setudpbatch(socketmgr, 0);
+
+	isc_test_end();
+}
+#undef NBATCH
+
+/* Test UDP sendto/recv with several socket watchers */
+#define NWATCHERS 4
+ATF_TC(udp_watchers);
+ATF_TC_HEAD(udp_watchers, tc) {
+	atf_tc_set_md_var(tc, "descr", "sendto/recv with several watchers");
+}
+ATF_TC_BODY(udp_watchers, tc) {
+	isc_result_t result;
+	isc_socketmgr_t *mgr = NULL;
+	isc_sockaddr_t addr[NWATCHERS];
+	struct in_addr in;
+	isc_socket_t *s[NWATCHERS];
+	isc_task_t *task = NULL;
+	char sendbuf[NWATCHERS][BUFSIZ], recvbuf[NWATCHERS][BUFSIZ];
+	completion_t scompletion[NWATCHERS], rcompletion[NWATCHERS];
+	isc_region_t r;
+	int i;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_socketmgr_create3(mctx, &mgr, 0, NWATCHERS);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Consecutive descriptors land on different watchers.
+	 */
+	in.s_addr = inet_addr("127.0.0.1");
+	for (i = 0; i < NWATCHERS; i++) {
+		s[i] = NULL;
+		isc_sockaddr_fromin(&addr[i], &in, 0);
+		result = isc_socket_create(mgr, PF_INET, isc_sockettype_udp,
+					   &s[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		result = isc_socket_bind(s[i], &addr[i], 0);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		result = isc_socket_getsockname(s[i], &addr[i]);
+		ATF_CHECK_EQ_MSG(result, ISC_R_SUCCESS, "%s",
+				 isc_result_totext(result));
+		ATF_REQUIRE(isc_sockaddr_getport(&addr[i]) != 0);
+	}
+
+	result = isc_task_create(taskmgr, 0, &task);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (i = 0; i < NWATCHERS; i++) {
+		r.base = (void *) recvbuf[i];
+		r.length = BUFSIZ;
+		completion_init(&rcompletion[i]);
+		result = isc_socket_recv(s[i], &r, 1, task, event_done,
+					 &rcompletion[i]);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	}
+
+	for (i = 0; i < NWATCHERS; i++) {
+		int to = (i + 1) % NWATCHERS;
+
+		snprintf(sendbuf[to], sizeof(sendbuf[to]), "Hello %d", to);
+		r.base = (void *) sendbuf[to];
+		r.length = strlen(sendbuf[to]) + 1;
+		completion_init(&scompletion[i]);
+		result = isc_socket_sendto(s[i], &r, task, event_done,
+					   &scompletion[i], &addr[to], NULL);
+		ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+	}
+
+	for (i = 0; i < NWATCHERS; i++) {
+		waitfor2(&scompletion[i], &rcompletion[i]);
+		ATF_CHECK(scompletion[i].done);
+		ATF_CHECK_EQ(scompletion[i].result, ISC_R_SUCCESS);
+		ATF_CHECK(rcompletion[i].done);
+		ATF_CHECK_EQ(rcompletion[i].result, ISC_R_SUCCESS);
+		ATF_CHECK_STREQ(recvbuf[i], sendbuf[i]);
+	}
+
+	isc_task_detach(&task);
+
+	for (i = 0; i < NWATCHERS; i++)
+		isc_socket_detach(&s[i]);
+
+	isc_socketmgr_destroy(&mgr);
+
+	isc_test_end();
+}
+#undef NWATCHERS
+
 /* Test TCP sendto/recv (IPv4) */
 ATF_TC(udp_dscp_v4);
 ATF_TC_HEAD(udp_dscp_v4, tc) {
@@ -780,6 +1052,9 @@ ATF_TC_BODY(net_probedscp, tc) {
 ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, udp_sendto);
 	ATF_TP_ADD_TC(tp, udp_dup);
+	ATF_TP_ADD_TC(tp, udp_reuseport);
+	ATF_TP_ADD_TC(tp, udp_batch);
+	ATF_TP_ADD_TC(tp, udp_watchers);
 	ATF_TP_ADD_TC(tp, tcp_dscp_v4);
 	ATF_TP_ADD_TC(tp, tcp_dscp_v6);
 	ATF_TP_ADD_TC(tp, udp_dscp_v4);
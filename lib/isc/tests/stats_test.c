@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+
+#include <atf-c.h>
+
+#include "isctest.h"
+
+#include <isc/result.h>
+#include <isc/stats.h>
+#include <isc/thread.h>
+#include <isc/util.h>
+
+#define NCOUNTERS	3
+#define NTHREADS	8
+#define NINCREMENTS	10000
+
+static isc_uint64_t values[NCOUNTERS];
+
+static void
+getvalues(isc_statscounter_t counter, isc_uint64_t value, void *arg) {
+	UNUSED(arg);
+
+	ATF_REQUIRE(counter < NCOUNTERS);
+	values[counter] = value;
+}
+
+static void
+dumpvalues(isc_stats_t *stats) {
+	int i;
+
+	for (i = 0; i < NCOUNTERS; i++)
+		values[i] = 0;
+	isc_stats_dump(stats, getvalues, NULL, ISC_STATSDUMP_VERBOSE);
+}
+
+static void
+basic(unsigned int options) {
+	isc_stats_t *stats = NULL;
+	isc_result_t result;
+
+	result = isc_stats_create2(mctx, &stats, NCOUNTERS, options);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	ATF_CHECK_EQ(isc_stats_ncounters(stats), NCOUNTERS);
+
+	isc_stats_increment(stats, 0);
+	isc_stats_increment(stats, 0);
+	isc_stats_increment(stats, 2);
+	isc_stats_decrement(stats, 2);
+	isc_stats_set(stats, 42, 1);
+	dumpvalues(stats);
+	ATF_CHECK_EQ(values[0], 2);
+	ATF_CHECK_EQ(values[1], 42);
+	ATF_CHECK_EQ(values[2], 0);
+
+	isc_stats_detach(&stats);
+}
+
+ATF_TC(isc_stats);
+ATF_TC_HEAD(isc_stats, tc) {
+	atf_tc_set_md_var(tc, "descr", "isc stats counters");
+}
+ATF_TC_BODY(isc_stats, tc) {
+	isc_result_t result;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	basic(0);
+	basic(ISC_STATSCREATE_SHARDED);
+
+	isc_test_end();
+}
+
+#ifdef ISC_PLATFORM_USETHREADS
+static isc_stats_t *shared = NULL;
+
+static isc_threadresult_t
+#ifdef WIN32
+WINAPI
+#endif
+update(isc_threadarg_t arg) {
+	int i;
+
+	UNUSED(arg);
+
+	for (i = 0; i < NINCREMENTS; i++) {
+		isc_stats_increment(shared, 0);
+		isc_stats_increment(shared, 1);
+		isc_stats_decrement(shared, 1);
+	}
+
+	return ((isc_threadresult_t)0);
+}
+#endif
+
+ATF_TC(sharded);
+ATF_TC_HEAD(sharded, tc) {
+	atf_tc_set_md_var(tc, "descr",
+			  "sharded counters updated by several threads add "
+			  "up when dumped");
+}
+ATF_TC_BODY(sharded, tc) {
+#ifdef ISC_PLATFORM_USETHREADS
+	isc_thread_t threads[NTHREADS];
+	isc_result_t result;
+	int i;
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_FALSE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_stats_create2(mctx, &shared, NCOUNTERS,
+				   ISC_STATSCREATE_SHARDED);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (i = 0; i < NTHREADS; i++) {
+		result = isc_thread_create(update, NULL, &threads[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	}
+	for (i = 0; i < NTHREADS; i++)
+		ATF_CHECK_EQ(isc_thread_join(threads[i], NULL),
+			     ISC_R_SUCCESS);
+
+	dumpvalues(shared);
+	ATF_CHECK_EQ(values[0], NTHREADS * NINCREMENTS);
+	ATF_CHECK_EQ(values[1], 0);
+	ATF_CHECK_EQ(values[2], 0);
+
+	/*
+	 * Setting a counter replaces what every thread has added.
+	 */
+	isc_stats_set(shared, 7, 0);
+	dumpvalues(shared);
+	ATF_CHECK_EQ(values[0], 7);
+
+	isc_stats_detach(&shared);
+	isc_test_end();
+#else
+	UNUSED(tc);
+	atf_tc_skip("threads not enabled");
+#endif
+}
+
+/*
+ * Main
+ */
+ATF_TP_ADD_TCS(tp) {
+	ATF_TP_ADD_TC(tp, isc_stats);
+	ATF_TP_ADD_TC(tp, sharded);
+	return (atf_no_error());
+}
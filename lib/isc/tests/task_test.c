@@ -14,10 +14,12 @@
 
 #include <atf-c.h>
 
+#include <string.h>
 #include <unistd.h>
 
 #include <isc/task.h>
 #include <isc/util.h>
+#include <isc/xml.h>
 
 #include "../task_p.h"
 #include "isctest.h"
@@ -56,6 +58,36 @@ set_and_drop(isc_task_t *task, isc_event_t *event) {
 	isc_taskmgr_setmode(taskmgr, isc_taskmgrmode_normal);
 }
 
+static void
+count(isc_task_t *task, isc_event_t *event) {
+	UNUSED(task);
+
+	isc_event_free(&event);
+	LOCK(&set_lock);
+	counter++;
+	UNLOCK(&set_lock);
+}
+
+/* sends 'fanout' events to the task in ev_arg */
+static int fanout = 100;
+
+static void
+send_many(isc_task_t *task, isc_event_t *event) {
+	isc_task_t *target = event->ev_arg;
+	isc_event_t *ev;
+	int i;
+
+	UNUSED(task);
+
+	isc_event_free(&event);
+	for (i = 0; i < fanout; i++) {
+		ev = isc_event_allocate(mctx, target, ISC_TASKEVENT_TEST,
+					count, NULL, sizeof (isc_event_t));
+		if (ev != NULL)
+			isc_task_send(target, &ev);
+	}
+}
+
 /*
  * Individual unit tests
  */
@@ -394,6 +426,395 @@ ATF_TC_BODY(privilege_drop, tc) {
 	isc_test_end();
 }
 
+/*
+ * Queue events on more tasks than there are workers and check that
+ * every one of them runs, whichever worker queue it ends up on.
+ */
+ATF_TC(many_tasks);
+ATF_TC_HEAD(many_tasks, tc) {
+	atf_tc_set_md_var(tc, "descr", "process events on many tasks");
+}
+ATF_TC_BODY(many_tasks, tc) {
+	isc_result_t result;
+	isc_taskmgr_t *manager = NULL;
+	isc_task_t *tasks[16];
+	isc_event_t *event;
+	int i, j;
+
+	UNUSED(tc);
+
+	counter = 0;
+	result = isc_mutex_init(&set_lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_taskmgr_create(mctx, 4, 0, &manager);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+#ifdef ISC_PLATFORM_USETHREADS
+	isc__taskmgr_pause(manager);
+#endif
+
+	for (i = 0; i < 16; i++) {
+		tasks[i] = NULL;
+		result = isc_task_create(manager, 0, &tasks[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	}
+
+	/*
+	 * Load the first task far more heavily than the others, so
+	 * that idle workers have something to take over.
+	 */
+	for (i = 0; i < 16; i++) {
+		for (j = 0; j < (i == 0 ? 64 : 4); j++) {
+			event = isc_event_allocate(mctx, tasks[i],
+						   ISC_TASKEVENT_TEST,
+						   count, NULL,
+						   sizeof (isc_event_t));
+			ATF_REQUIRE(event != NULL);
+			isc_task_send(tasks[i], &event);
+		}
+	}
+
+#ifdef ISC_PLATFORM_USETHREADS
+	isc__taskmgr_resume(manager);
+#endif
+
+	i = 0;
+	while (counter < 64 + 15 * 4 && i++ < 5000) {
+#ifndef ISC_PLATFORM_USETHREADS
+		while (isc__taskmgr_ready(manager))
+			isc__taskmgr_dispatch(manager);
+#endif
+		isc_test_nap(1000);
+	}
+
+	ATF_CHECK_EQ(counter, 64 + 15 * 4);
+
+	for (i = 0; i < 16; i++)
+		isc_task_detach(&tasks[i]);
+	isc_taskmgr_destroy(&manager);
+	ATF_REQUIRE_EQ(manager, NULL);
+
+	isc_test_end();
+}
+
+/*
+ * Many tasks sending to one task at the same time.
+ */
+ATF_TC(many_senders);
+ATF_TC_HEAD(many_senders, tc) {
+	atf_tc_set_md_var(tc, "descr", "send events from many tasks");
+}
+ATF_TC_BODY(many_senders, tc) {
+	isc_result_t result;
+	isc_taskmgr_t *manager = NULL;
+	isc_task_t *senders[8];
+	isc_task_t *target = NULL;
+	isc_event_t *event;
+	int i;
+
+	UNUSED(tc);
+
+	counter = 0;
+	result = isc_mutex_init(&set_lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_taskmgr_create(mctx, 4, 0, &manager);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_task_create(manager, 0, &target);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (i = 0; i < 8; i++) {
+		senders[i] = NULL;
+		result = isc_task_create(manager, 0, &senders[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		event = isc_event_allocate(mctx, senders[i],
+					   ISC_TASKEVENT_TEST, send_many,
+					   target, sizeof (isc_event_t));
+		ATF_REQUIRE(event != NULL);
+		isc_task_send(senders[i], &event);
+	}
+
+	i = 0;
+	while (counter < 8 * fanout && i++ < 5000) {
+#ifndef ISC_PLATFORM_USETHREADS
+		while (isc__taskmgr_ready(manager))
+			isc__taskmgr_dispatch(manager);
+#endif
+		isc_test_nap(1000);
+	}
+
+	ATF_CHECK_EQ(counter, 8 * fanout);
+
+	for (i = 0; i < 8; i++)
+		isc_task_detach(&senders[i]);
+	isc_task_detach(&target);
+	isc_taskmgr_destroy(&manager);
+	ATF_REQUIRE_EQ(manager, NULL);
+
+	isc_test_end();
+}
+
+/*
+ * Tasks bound to one worker still get all their events run when other
+ * workers help out.
+ */
+ATF_TC(bound_tasks);
+ATF_TC_HEAD(bound_tasks, tc) {
+	atf_tc_set_md_var(tc, "descr", "run events of tasks bound to a "
+			  "worker");
+}
+ATF_TC_BODY(bound_tasks, tc) {
+	isc_result_t result;
+	isc_taskmgr_t *manager = NULL;
+	isc_task_t *senders[8];
+	isc_task_t *targets[8];
+	isc_event_t *event;
+	int i;
+
+	UNUSED(tc);
+
+	counter = 0;
+	result = isc_mutex_init(&set_lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_taskmgr_create(mctx, 4, 0, &manager);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (i = 0; i < 8; i++) {
+		/*
+		 * Worker 0, 4 and 8 are all the first worker.
+		 */
+		targets[i] = NULL;
+		result = isc_task_create_bound(manager, 0, &targets[i],
+					       4 * (i % 3));
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	}
+
+	for (i = 0; i < 8; i++) {
+		senders[i] = NULL;
+		result = isc_task_create(manager, 0, &senders[i]);
+		ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+		event = isc_event_allocate(mctx, senders[i],
+					   ISC_TASKEVENT_TEST, send_many,
+					   targets[i], sizeof (isc_event_t));
+		ATF_REQUIRE(event != NULL);
+		isc_task_send(senders[i], &event);
+	}
+
+	i = 0;
+	while (counter < 8 * fanout && i++ < 5000) {
+#ifndef ISC_PLATFORM_USETHREADS
+		while (isc__taskmgr_ready(manager))
+			isc__taskmgr_dispatch(manager);
+#endif
+		isc_test_nap(1000);
+	}
+
+	ATF_CHECK_EQ(counter, 8 * fanout);
+
+	for (i = 0; i < 8; i++) {
+		isc_task_detach(&senders[i]);
+		isc_task_detach(&targets[i]);
+	}
+	isc_taskmgr_destroy(&manager);
+	ATF_REQUIRE_EQ(manager, NULL);
+
+	isc_test_end();
+}
+
+/*
+ * Purge and unsend find events that have been sent but not yet run.
+ */
+ATF_TC(purge_sent);
+ATF_TC_HEAD(purge_sent, tc) {
+	atf_tc_set_md_var(tc, "descr", "purge and unsend queued events");
+}
+ATF_TC_BODY(purge_sent, tc) {
+	isc_result_t result;
+	isc_task_t *task = NULL;
+	isc_event_t *event, *next;
+	isc_eventlist_t events;
+	int tag = 0;
+	unsigned int n;
+	int i;
+
+	UNUSED(tc);
+
+	counter = 0;
+	result = isc_mutex_init(&set_lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+#ifdef ISC_PLATFORM_USETHREADS
+	isc__taskmgr_pause(taskmgr);
+#endif
+
+	result = isc_task_create(taskmgr, 0, &task);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	for (i = 0; i < 30; i++) {
+		event = isc_event_allocate(mctx, task,
+					   ISC_TASKEVENT_TEST + (i % 3),
+					   count, NULL, sizeof (isc_event_t));
+		ATF_REQUIRE(event != NULL);
+		if (i % 3 == 2)
+			event->ev_tag = &tag;
+		isc_task_send(task, &event);
+	}
+
+	n = isc_task_purge(task, NULL, ISC_TASKEVENT_TEST, NULL);
+	ATF_CHECK_EQ(n, 10);
+
+	ISC_LIST_INIT(events);
+	n = isc_task_unsend(task, NULL, ISC_TASKEVENT_TEST + 2, &tag,
+			    &events);
+	ATF_CHECK_EQ(n, 10);
+	for (event = ISC_LIST_HEAD(events); event != NULL; event = next) {
+		next = ISC_LIST_NEXT(event, ev_link);
+		ISC_LIST_UNLINK(events, event, ev_link);
+		isc_event_free(&event);
+	}
+
+#ifdef ISC_PLATFORM_USETHREADS
+	isc__taskmgr_resume(taskmgr);
+#endif
+
+	i = 0;
+	while (counter < 10 && i++ < 5000) {
+#ifndef ISC_PLATFORM_USETHREADS
+		while (isc__taskmgr_ready(taskmgr))
+			isc__taskmgr_dispatch(taskmgr);
+#endif
+		isc_test_nap(1000);
+	}
+	isc_test_nap(10000);
+
+	ATF_CHECK_EQ(counter, 10);
+
+	isc_task_destroy(&task);
+	ATF_REQUIRE_EQ(task, NULL);
+
+	isc_test_end();
+}
+
+/*
+ * Latency statistics can be switched on and off while tasks run.
+ */
+ATF_TC(latency_stats);
+ATF_TC_HEAD(latency_stats, tc) {
+	atf_tc_set_md_var(tc, "descr", "collect task latency statistics");
+}
+ATF_TC_BODY(latency_stats, tc) {
+	isc_result_t result;
+	isc_task_t *task = NULL;
+	isc_event_t *event;
+	int i;
+#ifdef HAVE_LIBXML2
+	xmlBufferPtr buf;
+	xmlTextWriterPtr writer;
+#endif
+
+	UNUSED(tc);
+
+	counter = 0;
+	result = isc_mutex_init(&set_lock);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	ATF_CHECK(!isc_taskmgr_latencystats(taskmgr));
+	isc_taskmgr_setlatencystats(taskmgr, ISC_TRUE);
+	ATF_CHECK(isc_taskmgr_latencystats(taskmgr));
+
+	result = isc_task_create(taskmgr, 0, &task);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+	isc_task_setname(task, "latency", NULL);
+
+	for (i = 0; i < 20; i++) {
+		event = isc_event_allocate(mctx, task, ISC_TASKEVENT_TEST,
+					   count, NULL, sizeof (isc_event_t));
+		ATF_REQUIRE(event != NULL);
+		isc_task_send(task, &event);
+	}
+
+	i = 0;
+	while (counter < 20 && i++ < 5000) {
+#ifndef ISC_PLATFORM_USETHREADS
+		while (isc__taskmgr_ready(taskmgr))
+			isc__taskmgr_dispatch(taskmgr);
+#endif
+		isc_test_nap(1000);
+	}
+	ATF_CHECK_EQ(counter, 20);
+
+#ifdef HAVE_LIBXML2
+	buf = xmlBufferCreate();
+	ATF_REQUIRE(buf != NULL);
+	writer = xmlNewTextWriterMemory(buf, 0);
+	ATF_REQUIRE(writer != NULL);
+	ATF_CHECK(xmlTextWriterStartDocument(writer, NULL, "UTF-8",
+					     NULL) >= 0);
+	ATF_CHECK(xmlTextWriterStartElement(writer,
+					    ISC_XMLCHAR "taskmgr") >= 0);
+	ATF_CHECK(isc_taskmgr_renderxml(taskmgr, writer) >= 0);
+	ATF_CHECK(xmlTextWriterEndElement(writer) >= 0);
+	ATF_CHECK(xmlTextWriterEndDocument(writer) >= 0);
+	xmlFreeTextWriter(writer);
+	ATF_CHECK(strstr((const char *)xmlBufferContent(buf),
+			 "<task name=\"latency\">") != NULL);
+	xmlBufferFree(buf);
+#endif
+
+	isc_taskmgr_setlatencystats(taskmgr, ISC_FALSE);
+	ATF_CHECK(!isc_taskmgr_latencystats(taskmgr));
+
+	isc_task_destroy(&task);
+	ATF_REQUIRE_EQ(task, NULL);
+
+	isc_test_end();
+}
+
+ATF_TC(affinity);
+ATF_TC_HEAD(affinity, tc) {
+	atf_tc_set_md_var(tc, "descr", "bind worker threads to CPUs");
+}
+ATF_TC_BODY(affinity, tc) {
+	isc_result_t result;
+	unsigned int cpus[1] = { 0 };
+
+	UNUSED(tc);
+
+	result = isc_test_begin(NULL, ISC_TRUE);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_taskmgr_setaffinity(taskmgr, cpus, 1);
+	if (result == ISC_R_NOTIMPLEMENTED) {
+		isc_test_end();
+		atf_tc_skip("CPU affinity not supported");
+	}
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+
+	/* Unbind again. */
+	result = isc_taskmgr_setaffinity(taskmgr, NULL, 0);
+	ATF_CHECK_EQ(result, ISC_R_SUCCESS);
+
+	isc_test_end();
+}
+
 /*
  * Main
  */
@@ -402,6 +823,12 @@ ATF_TP_ADD_TCS(tp) {
 	ATF_TP_ADD_TC(tp, all_events);
 	ATF_TP_ADD_TC(tp, privileged_events);
 	ATF_TP_ADD_TC(tp, privilege_drop);
+	ATF_TP_ADD_TC(tp, many_tasks);
+	ATF_TP_ADD_TC(tp, many_senders);
+	ATF_TP_ADD_TC(tp, bound_tasks);
+	ATF_TP_ADD_TC(tp, purge_sent);
+	ATF_TP_ADD_TC(tp, latency_stats);
+	ATF_TP_ADD_TC(tp, affinity);
 
 	return (atf_no_error());
 }
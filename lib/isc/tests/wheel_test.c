@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* ! \file */
+
+#include <config.h>
+
+#include <atf-c.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <isc/mem.h>
+#include <isc/wheel.h>
+
+#include <isc/util.h>
+
+#define NELTS 5000
+
+struct e {
+	isc_uint64_t tick;
+	isc_wheelentry_t entry;
+};
+
+static struct e elts[NELTS];
+
+ATF_TC(isc_wheel_expire);
+ATF_TC_HEAD(isc_wheel_expire, tc) {
+	atf_tc_set_md_var(tc, "descr", "test isc_wheel_expire ordering");
+}
+ATF_TC_BODY(isc_wheel_expire, tc) {
+	isc_mem_t *mctx = NULL;
+	isc_wheel_t *wheel = NULL;
+	isc_result_t result;
+	isc_uint64_t now = 1000, last = 0, next, tick;
+	isc_uint32_t r = 1;
+	unsigned int i, n = 0;
+	struct e *e;
+
+	UNUSED(tc);
+
+	result = isc_mem_create(0, 0, &mctx);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	result = isc_wheel_create(mctx, now, &wheel);
+	ATF_REQUIRE_EQ(result, ISC_R_SUCCESS);
+
+	/*
+	 * Deadlines spread over every level of the wheel, and some in
+	 * the past.
+	 */
+	for (i = 0; i < NELTS; i++) {
+		r = r * 1103515245 + 12345;
+		tick = (isc_uint64_t)1 << (r % 40);
+		tick = now - 10 + (r >> 8) % tick;
+		elts[i].tick = tick;
+		ISC_WHEELENTRY_INIT(&elts[i].entry);
+		isc_wheel_insert(wheel, &elts[i].entry, tick, &elts[i]);
+		ATF_REQUIRE(ISC_WHEELENTRY_SCHEDULED(&elts[i].entry));
+	}
+	ATF_REQUIRE_EQ(isc_wheel_count(wheel), NELTS);
+
+	/*
+	 * Every other entry is taken out again.
+	 */
+	for (i = 0; i < NELTS; i += 2) {
+		isc_wheel_delete(wheel, &elts[i].entry);
+		ATF_REQUIRE(!ISC_WHEELENTRY_SCHEDULED(&elts[i].entry));
+	}
+	ATF_REQUIRE_EQ(isc_wheel_count(wheel), NELTS / 2);
+
+	/*
+	 * Jump from one event to the next, checking that entries come
+	 * out in order, never early, and on time.
+	 */
+	while (isc_wheel_next(wheel, &next)) {
+		ATF_REQUIRE(next > now || n == 0);
+		now = ISC_MAX(now, next);
+		while ((e = isc_wheel_expire(wheel, now)) != NULL) {
+			/*
+			 * Deadlines already passed when they were
+			 * inserted are treated as the next tick.
+			 */
+			tick = ISC_MAX(e->tick, 1001);
+			ATF_REQUIRE_EQ(tick, now);
+			ATF_REQUIRE(tick >= last);
+			ATF_REQUIRE(!ISC_WHEELENTRY_SCHEDULED(&e->entry));
+			ATF_REQUIRE(((e - elts) % 2) == 1);
+			last = tick;
+			n++;
+		}
+	}
+	ATF_CHECK_EQ(n, NELTS / 2);
+	ATF_CHECK_EQ(isc_wheel_count(wheel), 0);
+
+	isc_wheel_destroy(&wheel);
+	ATF_REQUIRE_EQ(wheel, NULL);
+
+	isc_mem_detach(&mctx);
+	ATF_REQUIRE_EQ(mctx, NULL);
+}
+
+/*
+ * Main
+ */
+ATF_TP_ADD_TCS(tp) {
+	ATF_TP_ADD_TC(tp, isc_wheel_expire);
+
+	return (atf_no_error());
+}
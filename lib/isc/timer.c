@@ -14,7 +14,6 @@
 
 #include <isc/app.h>
 #include <isc/condition.h>
-#include <isc/heap.h>
 #include <isc/log.h>
 #include <isc/magic.h>
 #include <isc/mem.h>
@@ -27,6 +26,7 @@
 #include <isc/time.h>
 #include <isc/timer.h>
 #include <isc/util.h>
+#include <isc/wheel.h>
 
 #ifdef OPENSSL_LEAKS
 #include <openssl/err.h>
@@ -81,7 +81,7 @@ struct isc__timer {
 	isc_task_t *			task;
 	isc_taskaction_t		action;
 	void *				arg;
-	unsigned int			index;
+	isc_wheelentry_t		entry;
 	isc_time_t			due;
 	LINK(isc__timer_t)		link;
 };
@@ -106,9 +106,32 @@ struct isc__timermgr {
 #ifdef USE_SHARED_MANAGER
 	unsigned int			refs;
 #endif /* USE_SHARED_MANAGER */
-	isc_heap_t *			heap;
+	isc_wheel_t *			wheel;
 };
 
+/*%
+ * Timers are kept in a timing wheel with a resolution of one
+ * millisecond.  Due times are rounded up to the next tick, so that
+ * timers never fire early.
+ */
+static inline isc_uint64_t
+time2tick(const isc_time_t *t, isc_boolean_t roundup) {
+	isc_uint64_t tick;
+	unsigned int ns;
+
+	tick = (isc_uint64_t)isc_time_seconds(t) * 1000;
+	ns = isc_time_nanoseconds(t);
+	if (roundup)
+		ns += 999999;
+	return (tick + ns / 1000000);
+}
+
+static inline void
+tick2time(isc_uint64_t tick, isc_time_t *t) {
+	isc_time_set(t, (unsigned int)(tick / 1000),
+		     (unsigned int)(tick % 1000) * 1000000);
+}
+
 /*%
  * The following are intended for internal use (indicated by "isc__"
  * prefix) but are not declared as static, allowing direct access from
@@ -179,7 +202,7 @@ schedule(isc__timer_t *timer, isc_time_t *now, isc_boolean_t signal_ok) {
 	isc_result_t result;
 	isc__timermgr_t *manager;
 	isc_time_t due;
-	int cmp;
+	isc_uint64_t tick;
 #ifdef USE_TIMER_THREAD
 	isc_boolean_t timedwait;
 #endif
@@ -230,41 +253,30 @@ schedule(isc__timer_t *timer, isc_time_t *now, isc_boolean_t signal_ok) {
 	 * Schedule the timer.
 	 */
 
-	if (timer->index > 0) {
+	tick = time2tick(&due, ISC_TRUE);
+	if (ISC_WHEELENTRY_SCHEDULED(&timer->entry)) {
 		/*
 		 * Already scheduled.
 		 */
-		cmp = isc_time_compare(&due, &timer->due);
-		timer->due = due;
-		switch (cmp) {
-		case -1:
-			isc_heap_increased(manager->heap, timer->index);
-			break;
-		case 1:
-			isc_heap_decreased(manager->heap, timer->index);
-			break;
-		case 0:
-			/* Nothing to do. */
-			break;
+		if (tick != time2tick(&timer->due, ISC_TRUE)) {
+			isc_wheel_delete(manager->wheel, &timer->entry);
+			isc_wheel_insert(manager->wheel, &timer->entry,
+					 tick, timer);
 		}
 	} else {
-		timer->due = due;
-		result = isc_heap_insert(manager->heap, timer);
-		if (result != ISC_R_SUCCESS) {
-			INSIST(result == ISC_R_NOMEMORY);
-			return (ISC_R_NOMEMORY);
-		}
+		isc_wheel_insert(manager->wheel, &timer->entry, tick, timer);
 		manager->nscheduled++;
 	}
+	timer->due = due;
 
 	XTRACETIMER(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TIMER,
 				   ISC_MSG_SCHEDULE, "schedule"), timer, due);
 
 	/*
-	 * If this timer is at the head of the queue, we need to ensure
-	 * that we won't miss it if it has a more recent due time than
-	 * the current "next" timer.  We do this either by waking up the
-	 * run thread, or explicitly setting the value in the manager.
+	 * If this timer is due before the manager was next going to look
+	 * at the wheel, we need to ensure that we won't miss it.  We do
+	 * this either by waking up the run thread, or explicitly setting
+	 * the value in the manager.
 	 */
 #ifdef USE_TIMER_THREAD
 
@@ -293,16 +305,17 @@ schedule(isc__timer_t *timer, isc_time_t *now, isc_boolean_t signal_ok) {
 		}
 	}
 
-	if (timer->index == 1 && signal_ok) {
+	if (signal_ok &&
+	    (!timedwait || tick < time2tick(&manager->due, ISC_FALSE))) {
 		XTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TIMER,
 				      ISC_MSG_SIGNALSCHED,
 				      "signal (schedule)"));
 		SIGNAL(&manager->wakeup);
 	}
 #else /* USE_TIMER_THREAD */
-	if (timer->index == 1 &&
-	    isc_time_compare(&timer->due, &manager->due) < 0)
-		manager->due = timer->due;
+	if (manager->nscheduled == 1 ||
+	    tick < time2tick(&manager->due, ISC_FALSE))
+		tick2time(tick, &manager->due);
 #endif /* USE_TIMER_THREAD */
 
 	return (ISC_R_SUCCESS);
@@ -310,33 +323,20 @@ schedule(isc__timer_t *timer, isc_time_t *now, isc_boolean_t signal_ok) {
 
 static inline void
 deschedule(isc__timer_t *timer) {
-#ifdef USE_TIMER_THREAD
-	isc_boolean_t need_wakeup = ISC_FALSE;
-#endif
 	isc__timermgr_t *manager;
 
 	/*
 	 * The caller must ensure locking.
+	 *
+	 * The run thread is not woken up; at worst it wakes up at the
+	 * old due time and finds nothing to do.
 	 */
 
 	manager = timer->manager;
-	if (timer->index > 0) {
-#ifdef USE_TIMER_THREAD
-		if (timer->index == 1)
-			need_wakeup = ISC_TRUE;
-#endif
-		isc_heap_delete(manager->heap, timer->index);
-		timer->index = 0;
+	if (ISC_WHEELENTRY_SCHEDULED(&timer->entry)) {
+		isc_wheel_delete(manager->wheel, &timer->entry);
 		INSIST(manager->nscheduled > 0);
 		manager->nscheduled--;
-#ifdef USE_TIMER_THREAD
-		if (need_wakeup) {
-			XTRACE(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TIMER,
-					      ISC_MSG_SIGNALDESCHED,
-					      "signal (deschedule)"));
-			SIGNAL(&manager->wakeup);
-		}
-#endif /* USE_TIMER_THREAD */
 	}
 }
 
@@ -447,7 +447,7 @@ isc__timer_create(isc_timermgr_t *manager0, isc_timertype_t type,
 	 * keep track of whether arg started as a true const.
 	 */
 	DE_CONST(arg, timer->arg);
-	timer->index = 0;
+	ISC_WHEELENTRY_INIT(&timer->entry);
 	result = isc_mutex_init(&timer->lock);
 	if (result != ISC_R_SUCCESS) {
 		isc_task_detach(&timer->task);
@@ -656,121 +656,117 @@ isc__timer_detach(isc_timer_t **timerp) {
 
 static void
 dispatch(isc__timermgr_t *manager, isc_time_t *now) {
-	isc_boolean_t done = ISC_FALSE, post_event, need_schedule;
+	isc_boolean_t post_event, need_schedule;
 	isc_timerevent_t *event;
 	isc_eventtype_t type = 0;
 	isc__timer_t *timer;
 	isc_result_t result;
 	isc_boolean_t idle;
+	isc_uint64_t tick;
 
 	/*!
 	 * The caller must be holding the manager lock.
 	 */
 
-	while (manager->nscheduled > 0 && !done) {
-		timer = isc_heap_element(manager->heap, 1);
-		INSIST(timer != NULL && timer->type != isc_timertype_inactive);
-		if (isc_time_compare(now, &timer->due) >= 0) {
-			if (timer->type == isc_timertype_ticker) {
-				type = ISC_TIMEREVENT_TICK;
-				post_event = ISC_TRUE;
-				need_schedule = ISC_TRUE;
-			} else if (timer->type == isc_timertype_limited) {
-				int cmp;
-				cmp = isc_time_compare(now, &timer->expires);
-				if (cmp >= 0) {
-					type = ISC_TIMEREVENT_LIFE;
-					post_event = ISC_TRUE;
-					need_schedule = ISC_FALSE;
-				} else {
-					type = ISC_TIMEREVENT_TICK;
-					post_event = ISC_TRUE;
-					need_schedule = ISC_TRUE;
-				}
-			} else if (!isc_time_isepoch(&timer->expires) &&
-				   isc_time_compare(now,
-						    &timer->expires) >= 0) {
+	while ((timer = isc_wheel_expire(manager->wheel,
+					 time2tick(now, ISC_FALSE))) != NULL)
+	{
+		INSIST(timer->type != isc_timertype_inactive);
+		INSIST(isc_time_compare(now, &timer->due) >= 0);
+		INSIST(manager->nscheduled > 0);
+		manager->nscheduled--;
+
+		if (timer->type == isc_timertype_ticker) {
+			type = ISC_TIMEREVENT_TICK;
+			post_event = ISC_TRUE;
+			need_schedule = ISC_TRUE;
+		} else if (timer->type == isc_timertype_limited) {
+			int cmp;
+			cmp = isc_time_compare(now, &timer->expires);
+			if (cmp >= 0) {
 				type = ISC_TIMEREVENT_LIFE;
 				post_event = ISC_TRUE;
 				need_schedule = ISC_FALSE;
 			} else {
-				idle = ISC_FALSE;
-
-				LOCK(&timer->lock);
-				if (!isc_time_isepoch(&timer->idle) &&
-				    isc_time_compare(now,
-						     &timer->idle) >= 0) {
-					idle = ISC_TRUE;
-				}
-				UNLOCK(&timer->lock);
-				if (idle) {
-					type = ISC_TIMEREVENT_IDLE;
-					post_event = ISC_TRUE;
-					need_schedule = ISC_FALSE;
-				} else {
-					/*
-					 * Idle timer has been touched;
-					 * reschedule.
-					 */
-					XTRACEID(isc_msgcat_get(isc_msgcat,
-								ISC_MSGSET_TIMER,
-								ISC_MSG_IDLERESCHED,
-								"idle reschedule"),
-						 timer);
-					post_event = ISC_FALSE;
-					need_schedule = ISC_TRUE;
-				}
+				type = ISC_TIMEREVENT_TICK;
+				post_event = ISC_TRUE;
+				need_schedule = ISC_TRUE;
 			}
+		} else if (!isc_time_isepoch(&timer->expires) &&
+			   isc_time_compare(now, &timer->expires) >= 0) {
+			type = ISC_TIMEREVENT_LIFE;
+			post_event = ISC_TRUE;
+			need_schedule = ISC_FALSE;
+		} else {
+			idle = ISC_FALSE;
 
-			if (post_event) {
-				XTRACEID(isc_msgcat_get(isc_msgcat,
-							ISC_MSGSET_TIMER,
-							ISC_MSG_POSTING,
-							"posting"), timer);
+			LOCK(&timer->lock);
+			if (!isc_time_isepoch(&timer->idle) &&
+			    isc_time_compare(now, &timer->idle) >= 0) {
+				idle = ISC_TRUE;
+			}
+			UNLOCK(&timer->lock);
+			if (idle) {
+				type = ISC_TIMEREVENT_IDLE;
+				post_event = ISC_TRUE;
+				need_schedule = ISC_FALSE;
+			} else {
 				/*
-				 * XXX We could preallocate this event.
+				 * Idle timer has been touched; reschedule.
 				 */
-				event = (isc_timerevent_t *)isc_event_allocate(manager->mctx,
+				XTRACEID(isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_TIMER,
+							ISC_MSG_IDLERESCHED,
+							"idle reschedule"),
+					 timer);
+				post_event = ISC_FALSE;
+				need_schedule = ISC_TRUE;
+			}
+		}
+
+		if (post_event) {
+			XTRACEID(isc_msgcat_get(isc_msgcat, ISC_MSGSET_TIMER,
+						ISC_MSG_POSTING, "posting"),
+				 timer);
+			/*
+			 * XXX We could preallocate this event.
+			 */
+			event = (isc_timerevent_t *)isc_event_allocate(manager->mctx,
 							   timer,
 							   type,
 							   timer->action,
 							   timer->arg,
 							   sizeof(*event));
 
-				if (event != NULL) {
-					event->due = timer->due;
-					isc_task_send(timer->task,
-						      ISC_EVENT_PTR(&event));
-				} else
-					UNEXPECTED_ERROR(__FILE__, __LINE__, "%s",
+			if (event != NULL) {
+				event->due = timer->due;
+				isc_task_send(timer->task,
+					      ISC_EVENT_PTR(&event));
+			} else
+				UNEXPECTED_ERROR(__FILE__, __LINE__, "%s",
 						 isc_msgcat_get(isc_msgcat,
 							 ISC_MSGSET_TIMER,
 							 ISC_MSG_EVENTNOTALLOC,
 							 "couldn't "
 							 "allocate event"));
-			}
-
-			timer->index = 0;
-			isc_heap_delete(manager->heap, 1);
-			manager->nscheduled--;
+		}
 
-			if (need_schedule) {
-				result = schedule(timer, now, ISC_FALSE);
-				if (result != ISC_R_SUCCESS)
-					UNEXPECTED_ERROR(__FILE__, __LINE__,
-							 "%s: %u",
-						isc_msgcat_get(isc_msgcat,
+		if (need_schedule) {
+			result = schedule(timer, now, ISC_FALSE);
+			if (result != ISC_R_SUCCESS)
+				UNEXPECTED_ERROR(__FILE__, __LINE__,
+						 "%s: %u",
+						 isc_msgcat_get(isc_msgcat,
 							ISC_MSGSET_TIMER,
 							ISC_MSG_SCHEDFAIL,
 							"couldn't schedule "
 							"timer"),
-							 result);
-			}
-		} else {
-			manager->due = timer->due;
-			done = ISC_TRUE;
+						 result);
 		}
 	}
+
+	if (isc_wheel_next(manager->wheel, &tick))
+		tick2time(tick, &manager->due);
 }
 
 #ifdef USE_TIMER_THREAD
@@ -820,34 +816,11 @@ run(void *uap) {
 }
 #endif /* USE_TIMER_THREAD */
 
-static isc_boolean_t
-sooner(void *v1, void *v2) {
-	isc__timer_t *t1, *t2;
-
-	t1 = v1;
-	t2 = v2;
-	REQUIRE(VALID_TIMER(t1));
-	REQUIRE(VALID_TIMER(t2));
-
-	if (isc_time_compare(&t1->due, &t2->due) < 0)
-		return (ISC_TRUE);
-	return (ISC_FALSE);
-}
-
-static void
-set_index(void *what, unsigned int index) {
-	isc__timer_t *timer;
-
-	timer = what;
-	REQUIRE(VALID_TIMER(timer));
-
-	timer->index = index;
-}
-
 isc_result_t
 isc__timermgr_create(isc_mem_t *mctx, isc_timermgr_t **managerp) {
 	isc__timermgr_t *manager;
 	isc_result_t result;
+	isc_time_t now;
 
 	/*
 	 * Create a timer manager.
@@ -875,8 +848,10 @@ isc__timermgr_create(isc_mem_t *mctx, isc_timermgr_t **managerp) {
 	INIT_LIST(manager->timers);
 	manager->nscheduled = 0;
 	isc_time_settoepoch(&manager->due);
-	manager->heap = NULL;
-	result = isc_heap_create(mctx, sooner, set_index, 0, &manager->heap);
+	manager->wheel = NULL;
+	TIME_NOW(&now);
+	result = isc_wheel_create(mctx, time2tick(&now, ISC_FALSE),
+				  &manager->wheel);
 	if (result != ISC_R_SUCCESS) {
 		INSIST(result == ISC_R_NOMEMORY);
 		isc_mem_put(mctx, manager, sizeof(*manager));
@@ -884,7 +859,7 @@ isc__timermgr_create(isc_mem_t *mctx, isc_timermgr_t **managerp) {
 	}
 	result = isc_mutex_init(&manager->lock);
 	if (result != ISC_R_SUCCESS) {
-		isc_heap_destroy(&manager->heap);
+		isc_wheel_destroy(&manager->wheel);
 		isc_mem_put(mctx, manager, sizeof(*manager));
 		return (result);
 	}
@@ -893,7 +868,7 @@ isc__timermgr_create(isc_mem_t *mctx, isc_timermgr_t **managerp) {
 	if (isc_condition_init(&manager->wakeup) != ISC_R_SUCCESS) {
 		isc_mem_detach(&manager->mctx);
 		DESTROYLOCK(&manager->lock);
-		isc_heap_destroy(&manager->heap);
+		isc_wheel_destroy(&manager->wheel);
 		isc_mem_put(mctx, manager, sizeof(*manager));
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
 				 "isc_condition_init() %s",
@@ -906,7 +881,7 @@ isc__timermgr_create(isc_mem_t *mctx, isc_timermgr_t **managerp) {
 		isc_mem_detach(&manager->mctx);
 		(void)isc_condition_destroy(&manager->wakeup);
 		DESTROYLOCK(&manager->lock);
-		isc_heap_destroy(&manager->heap);
+		isc_wheel_destroy(&manager->wheel);
 		isc_mem_put(mctx, manager, sizeof(*manager));
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
 				 "isc_thread_create() %s",
@@ -997,7 +972,7 @@ isc__timermgr_destroy(isc_timermgr_t **managerp) {
 	(void)isc_condition_destroy(&manager->wakeup);
 #endif /* USE_TIMER_THREAD */
 	DESTROYLOCK(&manager->lock);
-	isc_heap_destroy(&manager->heap);
+	isc_wheel_destroy(&manager->wheel);
 	manager->common.impmagic = 0;
 	manager->common.magic = 0;
 	mctx = manager->mctx;
@@ -304,6 +304,23 @@ typedef isc_event_t intev_t;
 #endif
 #endif
 
+/*%
+ * Batched UDP I/O.  When the manager's batch size is greater than one,
+ * queued UDP receive and send requests are serviced with a single
+ * recvmmsg()/sendmmsg() call per readiness notification instead of one
+ * system call per datagram.
+ */
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG) && \
+    defined(ISC_NET_BSD44MSGHDR)
+#define USE_MMSG	1
+#define MAXBATCH	ISC_SOCKET_MAXBATCH
+/*
+ * Per-datagram control buffer space used by a batch.  This must cover
+ * both recvcmsgbuflen and sendcmsgbuflen, which are a few dozen bytes.
+ */
+#define BATCH_CMSGLEN	256
+#endif
+
 /*%
  * The size to raise the receive buffer to (from BIND 8).
  */
@@ -388,6 +405,27 @@ struct isc__socket {
 #define SOCKET_MANAGER_MAGIC	ISC_MAGIC('I', 'O', 'm', 'g')
 #define VALID_MANAGER(m)	ISC_MAGIC_VALID(m, SOCKET_MANAGER_MAGIC)
 
+/*%
+ * A socket watcher.  Each watcher owns a control pipe and, with epoll,
+ * its own epoll instance; descriptors are assigned to watchers by
+ * FDTHREAD().  Other multiplexing methods always use a single watcher.
+ */
+typedef struct isc__socketthread {
+	isc__socketmgr_t	*manager;
+	int			threadid;
+#ifdef USE_EPOLL
+	int			epoll_fd;
+	struct epoll_event	*events;
+#endif	/* USE_EPOLL */
+#ifdef USE_WATCHER_THREAD
+	int			pipe_fds[2];
+	isc_thread_t		thread;
+#endif	/* USE_WATCHER_THREAD */
+} isc__socketthread_t;
+
+#define FDTHREAD_ID(m, fd)	((fd) % (m)->nthreads)
+#define FDTHREAD(m, fd)		(&(m)->threads[FDTHREAD_ID(m, fd)])
+
 struct isc__socketmgr {
 	/* Not locked. */
 	isc_socketmgr_t		common;
@@ -401,9 +439,7 @@ struct isc__socketmgr {
 	struct kevent		*events;
 #endif	/* USE_KQUEUE */
 #ifdef USE_EPOLL
-	int			epoll_fd;
 	int			nevents;
-	struct epoll_event	*events;
 #endif	/* USE_EPOLL */
 #ifdef USE_DEVPOLL
 	int			devpoll_fd;
@@ -416,9 +452,8 @@ struct isc__socketmgr {
 	int			fd_bufsize;
 #endif	/* USE_SELECT */
 	unsigned int		maxsocks;
-#ifdef ISC_PLATFORM_USETHREADS
-	int			pipe_fds[2];
-#endif
+	int			nthreads;
+	isc__socketthread_t	*threads;
 
 	/* Locked by fdlock. */
 	isc__socket_t	       **fds;
@@ -441,12 +476,12 @@ struct isc__socketmgr {
 #endif	/* USE_SELECT */
 	int			reserved;	/* unlocked */
 #ifdef USE_WATCHER_THREAD
-	isc_thread_t		watcher;
 	isc_condition_t		shutdown_ok;
 #else /* USE_WATCHER_THREAD */
 	unsigned int		refs;
 #endif /* USE_WATCHER_THREAD */
 	int			maxudp;
+	unsigned int		udpbatch;	/* unlocked */
 };
 
 #ifdef USE_SHARED_MANAGER
@@ -490,7 +525,7 @@ static void build_msghdr_send(isc__socket_t *, isc_socketevent_t *,
 static void build_msghdr_recv(isc__socket_t *, isc_socketevent_t *,
 			      struct msghdr *, struct iovec *, size_t *);
 #ifdef USE_WATCHER_THREAD
-static isc_boolean_t process_ctlfd(isc__socketmgr_t *manager);
+static isc_boolean_t process_ctlfd(isc__socketthread_t *thread);
 #endif
 static void setdscp(isc__socket_t *sock, isc_dscp_t dscp);
 
@@ -602,6 +637,9 @@ isc_result_t
 isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 		       unsigned int maxsocks);
 isc_result_t
+isc__socketmgr_create3(isc_mem_t *mctx, isc_socketmgr_t **managerp,
+		       unsigned int maxsocks, unsigned int nthreads);
+isc_result_t
 isc_socketmgr_getmaxsockets(isc_socketmgr_t *manager0, unsigned int *nsockp);
 void
 isc_socketmgr_setstats(isc_socketmgr_t *manager0, isc_stats_t *stats);
@@ -932,7 +970,7 @@ watch_fd(isc__socketmgr_t *manager, int fd, int msg) {
 	event.data.fd = fd;
 
 	op = (oldevents == 0U) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
-	ret = epoll_ctl(manager->epoll_fd, op, fd, &event);
+	ret = epoll_ctl(FDTHREAD(manager, fd)->epoll_fd, op, fd, &event);
 	if (ret == -1) {
 		if (errno == EEXIST)
 			UNEXPECTED_ERROR(__FILE__, __LINE__,
@@ -1010,7 +1048,7 @@ unwatch_fd(isc__socketmgr_t *manager, int fd, int msg) {
 	event.data.fd = fd;
 
 	op = (event.events == 0U) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
-	ret = epoll_ctl(manager->epoll_fd, op, fd, &event);
+	ret = epoll_ctl(FDTHREAD(manager, fd)->epoll_fd, op, fd, &event);
 	if (ret == -1 && errno != ENOENT) {
 		char strbuf[ISC_STRERRORSIZE];
 		isc__strerror(errno, strbuf, sizeof(strbuf));
@@ -1134,12 +1172,12 @@ wakeup_socket(isc__socketmgr_t *manager, int fd, int msg) {
 
 #ifdef USE_WATCHER_THREAD
 /*
- * Poke the select loop when there is something for us to do.
+ * Poke a watcher's select loop when there is something for it to do.
  * The write is required (by POSIX) to complete.  That is, we
  * will not get partial writes.
  */
 static void
-select_poke(isc__socketmgr_t *mgr, int fd, int msg) {
+select_poke_thread(isc__socketthread_t *thread, int fd, int msg) {
 	int cc;
 	int buf[2];
 	char strbuf[ISC_STRERRORSIZE];
@@ -1148,7 +1186,7 @@ select_poke(isc__socketmgr_t *mgr, int fd, int msg) {
 	buf[1] = msg;
 
 	do {
-		cc = write(mgr->pipe_fds[1], buf, sizeof(buf));
+		cc = write(thread->pipe_fds[1], buf, sizeof(buf));
 #ifdef ENOSR
 		/*
 		 * Treat ENOSR as EAGAIN but loop slowly as it is
@@ -1174,16 +1212,30 @@ select_poke(isc__socketmgr_t *mgr, int fd, int msg) {
 	INSIST(cc == sizeof(buf));
 }
 
+/*
+ * Poke the watcher responsible for 'fd', or every watcher on shutdown.
+ */
+static void
+select_poke(isc__socketmgr_t *mgr, int fd, int msg) {
+	int i;
+
+	if (msg == SELECT_POKE_SHUTDOWN) {
+		for (i = 0; i < mgr->nthreads; i++)
+			select_poke_thread(&mgr->threads[i], fd, msg);
+	} else
+		select_poke_thread(FDTHREAD(mgr, fd), fd, msg);
+}
+
 /*
  * Read a message on the internal fd.
  */
 static void
-select_readmsg(isc__socketmgr_t *mgr, int *fd, int *msg) {
+select_readmsg(isc__socketthread_t *thread, int *fd, int *msg) {
 	int buf[2];
 	int cc;
 	char strbuf[ISC_STRERRORSIZE];
 
-	cc = read(mgr->pipe_fds[0], buf, sizeof(buf));
+	cc = read(thread->pipe_fds[0], buf, sizeof(buf));
 	if (cc < 0) {
 		*msg = SELECT_POKE_NOTHING;
 		*fd = -1;	/* Silence compiler. */
@@ -1856,14 +1908,16 @@ dump_msg(struct msghdr *msg) {
 #define DOIO_HARD		2	/* i/o error, event sent */
 #define DOIO_EOF		3	/* EOF, no event sent */
 
+static int
+doio_recvdone(isc__socket_t *sock, isc_socketevent_t *dev,
+	      struct msghdr *msghdr, int cc, size_t read_count);
+
 static int
 doio_recv(isc__socket_t *sock, isc_socketevent_t *dev) {
 	int cc;
 	struct iovec iov[MAXSCATTERGATHER_RECV];
 	size_t read_count;
-	size_t actual_count;
 	struct msghdr msghdr;
-	isc_buffer_t *buffer;
 	int recv_errno;
 	char strbuf[ISC_STRERRORSIZE];
 
@@ -1940,6 +1994,20 @@ doio_recv(isc__socket_t *sock, isc_socketevent_t *dev) {
 		return (DOIO_HARD);
 	}
 
+	return (doio_recvdone(sock, dev, &msghdr, cc, read_count));
+}
+
+/*
+ * Complete a receive of 'cc' bytes into 'dev' as described by 'msghdr'.
+ * Shared by doio_recv() and doio_recvbatch().
+ */
+static int
+doio_recvdone(isc__socket_t *sock, isc_socketevent_t *dev,
+	      struct msghdr *msghdr, int cc, size_t read_count)
+{
+	size_t actual_count;
+	isc_buffer_t *buffer;
+
 	/*
 	 * On TCP and UNIX sockets, zero length reads indicate EOF,
 	 * while on UDP sockets, zero length reads are perfectly valid,
@@ -1960,7 +2028,7 @@ doio_recv(isc__socket_t *sock, isc_socketevent_t *dev) {
 	}
 
 	if (sock->type == isc_sockettype_udp) {
-		dev->address.length = msghdr.msg_namelen;
+		dev->address.length = msghdr->msg_namelen;
 		if (isc_sockaddr_getport(&dev->address) == 0) {
 			if (isc_log_wouldlog(isc_lctx, IOEVENT_LEVEL)) {
 				socket_log(sock, &dev->address, IOEVENT,
@@ -1998,7 +2066,7 @@ doio_recv(isc__socket_t *sock, isc_socketevent_t *dev) {
 	 * If there are control messages attached, run through them and pull
 	 * out the interesting bits.
 	 */
-	process_cmsg(sock, &msghdr, dev);
+	process_cmsg(sock, msghdr, dev);
 
 	/*
 	 * update the buffers (if any) and the i/o count
@@ -2164,6 +2232,179 @@ doio_send(isc__socket_t *sock, isc_socketevent_t *dev) {
 	return (DOIO_SUCCESS);
 }
 
+#ifdef USE_MMSG
+/*
+ * Receive up to 'udpbatch' datagrams into the requests at the head of
+ * the receive queue with a single recvmmsg() call, and post a done
+ * event for each request that was filled.
+ *
+ * Returns:
+ *	DOIO_SUCCESS	At least one request was completed.
+ *
+ *	DOIO_SOFT	No data was available.
+ *
+ *	DOIO_HARD	recvmmsg() failed.  No event was sent; the caller
+ *			should fall back to doio_recv() to report the error.
+ *
+ * The socket must be locked.
+ */
+static int
+doio_recvbatch(isc__socket_t *sock) {
+	struct mmsghdr msgs[MAXBATCH];
+	struct iovec iov[MAXBATCH][MAXSCATTERGATHER_RECV];
+	size_t read_count[MAXBATCH];
+	isc_socketevent_t *devs[MAXBATCH];
+#ifdef USE_CMSG
+	char cmsgbuf[MAXBATCH][BATCH_CMSGLEN];
+#endif
+	isc_socketevent_t *dev;
+	unsigned int i, n, max;
+	int cc;
+
+	INSIST(sock->type == isc_sockettype_udp);
+#ifdef USE_CMSG
+	INSIST(sock->recvcmsgbuflen <= BATCH_CMSGLEN);
+#endif
+
+	max = ISC_MIN(sock->manager->udpbatch, MAXBATCH);
+	n = 0;
+	for (dev = ISC_LIST_HEAD(sock->recv_list);
+	     dev != NULL && n < max;
+	     dev = ISC_LIST_NEXT(dev, ev_link))
+	{
+		build_msghdr_recv(sock, dev, &msgs[n].msg_hdr, iov[n],
+				  &read_count[n]);
+#ifdef USE_CMSG
+		if (msgs[n].msg_hdr.msg_controllen != 0U)
+			msgs[n].msg_hdr.msg_control = cmsgbuf[n];
+#endif
+		msgs[n].msg_len = 0;
+		devs[n++] = dev;
+	}
+
+	cc = recvmmsg(sock->fd, msgs, n, 0, NULL);
+	if (cc < 0) {
+		if (SOFT_ERROR(errno))
+			return (DOIO_SOFT);
+		return (DOIO_HARD);
+	}
+	if (cc == 0)
+		return (DOIO_SOFT);
+
+	/*
+	 * Datagrams that are dropped (e.g. source port zero) leave their
+	 * request on the queue to be reused.
+	 */
+	for (i = 0; i < (unsigned int)cc; i++) {
+		if (doio_recvdone(sock, devs[i], &msgs[i].msg_hdr,
+				  (int)msgs[i].msg_len,
+				  read_count[i]) == DOIO_SUCCESS)
+			send_recvdone_event(sock, &devs[i]);
+	}
+
+	return (DOIO_SUCCESS);
+}
+
+/*
+ * Send the datagrams of up to 'udpbatch' requests at the head of the
+ * send queue with a single sendmmsg() call, and post a done event for
+ * each request that was sent.  A request whose datagram was reported
+ * as only partly sent fails with ISC_R_UNEXPECTED.
+ *
+ * Returns:
+ *	DOIO_SUCCESS	At least one request was completed.
+ *
+ *	DOIO_SOFT	The socket would block.
+ *
+ *	DOIO_HARD	sendmmsg() failed on the first datagram.  No event
+ *			was sent; the caller should fall back to doio_send()
+ *			to report the error.
+ *
+ * The socket must be locked.
+ */
+static int
+doio_sendbatch(isc__socket_t *sock) {
+	struct mmsghdr msgs[MAXBATCH];
+	struct iovec iov[MAXBATCH][MAXSCATTERGATHER_SEND];
+	size_t write_count[MAXBATCH];
+	isc_socketevent_t *devs[MAXBATCH];
+#ifdef USE_CMSG
+	char cmsgbuf[MAXBATCH][BATCH_CMSGLEN];
+#endif
+	isc_socketevent_t *dev;
+	unsigned int i, n, max;
+	int cc;
+
+	INSIST(sock->type == isc_sockettype_udp);
+#ifdef USE_CMSG
+	INSIST(sock->sendcmsgbuflen <= BATCH_CMSGLEN);
+#endif
+
+	max = ISC_MIN(sock->manager->udpbatch, MAXBATCH);
+	n = 0;
+	for (dev = ISC_LIST_HEAD(sock->send_list);
+	     dev != NULL && n < max;
+	     dev = ISC_LIST_NEXT(dev, ev_link))
+	{
+		build_msghdr_send(sock, dev, &msgs[n].msg_hdr, iov[n],
+				  &write_count[n]);
+#ifdef USE_CMSG
+		/*
+		 * build_msghdr_send() uses the socket's single control
+		 * buffer; give each datagram a copy of its own.
+		 */
+		if (msgs[n].msg_hdr.msg_controllen != 0U) {
+			memmove(cmsgbuf[n], msgs[n].msg_hdr.msg_control,
+				msgs[n].msg_hdr.msg_controllen);
+			msgs[n].msg_hdr.msg_control = cmsgbuf[n];
+		}
+#endif
+		msgs[n].msg_len = 0;
+		devs[n++] = dev;
+	}
+
+	cc = sendmmsg(sock->fd, msgs, n, 0);
+	if (cc < 0) {
+		if (errno == EWOULDBLOCK || errno == EAGAIN)
+			return (DOIO_SOFT);
+		return (DOIO_HARD);
+	}
+	if (cc == 0)
+		return (DOIO_SOFT);
+
+	/*
+	 * A datagram is sent whole or not at all, so a short count
+	 * can't be finished later; fail that request, and complete the
+	 * others that were sent by the same call.
+	 */
+	for (i = 0; i < (unsigned int)cc; i++) {
+		devs[i]->n += msgs[i].msg_len;
+		if ((size_t)msgs[i].msg_len == write_count[i])
+			devs[i]->result = ISC_R_SUCCESS;
+		else {
+			devs[i]->result = ISC_R_UNEXPECTED;
+			inc_stats(sock->manager->stats,
+				  sock->statsindex[STATID_SENDFAIL]);
+		}
+		send_senddone_event(sock, &devs[i]);
+	}
+
+	return (DOIO_SUCCESS);
+}
+
+/*
+ * Return ISC_TRUE if another request is queued behind 'dev' and the
+ * manager has batching enabled for UDP socket 'sock'.
+ */
+static inline isc_boolean_t
+use_batch(isc__socket_t *sock, isc_socketevent_t *dev) {
+	return (ISC_TF(sock->type == isc_sockettype_udp &&
+		       sock->manager->udpbatch > 1 &&
+		       sock->manager->maxudp == 0 &&
+		       dev != NULL && ISC_LIST_NEXT(dev, ev_link) != NULL));
+}
+#endif /* USE_MMSG */
+
 /*
  * Kill.
  *
@@ -2229,8 +2470,8 @@ socketclose(isc__socketmgr_t *manager, isc__socket_t *sock, int fd) {
 			UNLOCK(&manager->fdlock[lockid]);
 		}
 #ifdef ISC_PLATFORM_USETHREADS
-		if (manager->maxfd < manager->pipe_fds[0])
-			manager->maxfd = manager->pipe_fds[0];
+		if (manager->maxfd < manager->threads[0].pipe_fds[0])
+			manager->maxfd = manager->threads[0].pipe_fds[0];
 #endif
 	}
 
@@ -3815,6 +4056,19 @@ internal_recv(isc_task_t *me, isc_event_t *ev) {
 	 */
 	dev = ISC_LIST_HEAD(sock->recv_list);
 	while (dev != NULL) {
+#ifdef USE_MMSG
+		if (use_batch(sock, dev)) {
+			switch (doio_recvbatch(sock)) {
+			case DOIO_SOFT:
+				goto poke;
+			case DOIO_SUCCESS:
+				dev = ISC_LIST_HEAD(sock->recv_list);
+				continue;
+			case DOIO_HARD:
+				break;
+			}
+		}
+#endif
 		switch (doio_recv(sock, dev)) {
 		case DOIO_SOFT:
 			goto poke;
@@ -3883,6 +4137,19 @@ internal_send(isc_task_t *me, isc_event_t *ev) {
 	 */
 	dev = ISC_LIST_HEAD(sock->send_list);
 	while (dev != NULL) {
+#ifdef USE_MMSG
+		if (use_batch(sock, dev)) {
+			switch (doio_sendbatch(sock)) {
+			case DOIO_SOFT:
+				goto poke;
+			case DOIO_SUCCESS:
+				dev = ISC_LIST_HEAD(sock->send_list);
+				continue;
+			case DOIO_HARD:
+				break;
+			}
+		}
+#endif
 		switch (doio_send(sock, dev)) {
 		case DOIO_SOFT:
 			goto poke;
@@ -4082,7 +4349,8 @@ process_fds(isc__socketmgr_t *manager, struct kevent *events, int nevents) {
 	for (i = 0; i < nevents; i++) {
 		REQUIRE(events[i].ident < manager->maxsocks);
 #ifdef USE_WATCHER_THREAD
-		if (events[i].ident == (uintptr_t)manager->pipe_fds[0]) {
+		if (events[i].ident ==
+		    (uintptr_t)manager->threads[0].pipe_fds[0]) {
 			have_ctlevent = ISC_TRUE;
 			continue;
 		}
@@ -4094,15 +4362,17 @@ process_fds(isc__socketmgr_t *manager, struct kevent *events, int nevents) {
 
 #ifdef USE_WATCHER_THREAD
 	if (have_ctlevent)
-		done = process_ctlfd(manager);
+		done = process_ctlfd(&manager->threads[0]);
 #endif
 
 	return (done);
 }
 #elif defined(USE_EPOLL)
 static isc_boolean_t
-process_fds(isc__socketmgr_t *manager, struct epoll_event *events, int nevents)
+process_fds(isc__socketthread_t *thread, struct epoll_event *events,
+	    int nevents)
 {
+	isc__socketmgr_t *manager = thread->manager;
 	int i;
 	isc_boolean_t done = ISC_FALSE;
 #ifdef USE_WATCHER_THREAD
@@ -4119,7 +4389,7 @@ process_fds(isc__socketmgr_t *manager, struct epoll_event *events, int nevents)
 	for (i = 0; i < nevents; i++) {
 		REQUIRE(events[i].data.fd < (int)manager->maxsocks);
 #ifdef USE_WATCHER_THREAD
-		if (events[i].data.fd == manager->pipe_fds[0]) {
+		if (events[i].data.fd == thread->pipe_fds[0]) {
 			have_ctlevent = ISC_TRUE;
 			continue;
 		}
@@ -4143,7 +4413,7 @@ process_fds(isc__socketmgr_t *manager, struct epoll_event *events, int nevents)
 
 #ifdef USE_WATCHER_THREAD
 	if (have_ctlevent)
-		done = process_ctlfd(manager);
+		done = process_ctlfd(thread);
 #endif
 
 	return (done);
@@ -4167,7 +4437,7 @@ process_fds(isc__socketmgr_t *manager, struct pollfd *events, int nevents) {
 	for (i = 0; i < nevents; i++) {
 		REQUIRE(events[i].fd < (int)manager->maxsocks);
 #ifdef USE_WATCHER_THREAD
-		if (events[i].fd == manager->pipe_fds[0]) {
+		if (events[i].fd == manager->threads[0].pipe_fds[0]) {
 			have_ctlevent = ISC_TRUE;
 			continue;
 		}
@@ -4179,7 +4449,7 @@ process_fds(isc__socketmgr_t *manager, struct pollfd *events, int nevents) {
 
 #ifdef USE_WATCHER_THREAD
 	if (have_ctlevent)
-		done = process_ctlfd(manager);
+		done = process_ctlfd(&manager->threads[0]);
 #endif
 
 	return (done);
@@ -4195,7 +4465,8 @@ process_fds(isc__socketmgr_t *manager, int maxfd, fd_set *readfds,
 
 	for (i = 0; i < maxfd; i++) {
 #ifdef USE_WATCHER_THREAD
-		if (i == manager->pipe_fds[0] || i == manager->pipe_fds[1])
+		if (i == manager->threads[0].pipe_fds[0] ||
+		    i == manager->threads[0].pipe_fds[1])
 			continue;
 #endif /* USE_WATCHER_THREAD */
 		process_fd(manager, i, FD_ISSET(i, readfds),
@@ -4206,11 +4477,12 @@ process_fds(isc__socketmgr_t *manager, int maxfd, fd_set *readfds,
 
 #ifdef USE_WATCHER_THREAD
 static isc_boolean_t
-process_ctlfd(isc__socketmgr_t *manager) {
+process_ctlfd(isc__socketthread_t *thread) {
+	isc__socketmgr_t *manager = thread->manager;
 	int msg, fd;
 
 	for (;;) {
-		select_readmsg(manager, &fd, &msg);
+		select_readmsg(thread, &fd, &msg);
 
 		manager_log(manager, IOEVENT,
 			    isc_msgcat_get(isc_msgcat, ISC_MSGSET_SOCKET,
@@ -4254,7 +4526,8 @@ process_ctlfd(isc__socketmgr_t *manager) {
  */
 static isc_threadresult_t
 watcher(void *uap) {
-	isc__socketmgr_t *manager = uap;
+	isc__socketthread_t *thread = uap;
+	isc__socketmgr_t *manager = thread->manager;
 	isc_boolean_t done;
 	int cc;
 #ifdef USE_KQUEUE
@@ -4280,7 +4553,7 @@ watcher(void *uap) {
 	/*
 	 * Get the control fd here.  This will never change.
 	 */
-	ctlfd = manager->pipe_fds[0];
+	ctlfd = thread->pipe_fds[0];
 #endif
 	done = ISC_FALSE;
 	while (!done) {
@@ -4289,7 +4562,7 @@ watcher(void *uap) {
 			cc = kevent(manager->kqueue_fd, NULL, 0,
 				    manager->events, manager->nevents, NULL);
 #elif defined(USE_EPOLL)
-			cc = epoll_wait(manager->epoll_fd, manager->events,
+			cc = epoll_wait(thread->epoll_fd, thread->events,
 					manager->nevents, -1);
 #elif defined(USE_DEVPOLL)
 			/*
@@ -4381,7 +4654,9 @@ watcher(void *uap) {
 #endif
 		} while (cc < 0);
 
-#if defined(USE_KQUEUE) || defined (USE_EPOLL) || defined (USE_DEVPOLL)
+#if defined(USE_EPOLL)
+		done = process_fds(thread, thread->events, cc);
+#elif defined(USE_KQUEUE) || defined (USE_DEVPOLL)
 		done = process_fds(manager, manager->events, cc);
 #elif defined(USE_SELECT)
 		process_fds(manager, maxfd, manager->read_fds_copy,
@@ -4391,7 +4666,7 @@ watcher(void *uap) {
 		 * Process reads on internal, control fd.
 		 */
 		if (FD_ISSET(ctlfd, manager->read_fds_copy))
-			done = process_ctlfd(manager);
+			done = process_ctlfd(thread);
 #endif
 	}
 
@@ -4421,74 +4696,163 @@ isc__socketmgr_maxudp(isc_socketmgr_t *manager0, int maxudp) {
 	manager->maxudp = maxudp;
 }
 
+void
+isc__socketmgr_setudpbatch(isc_socketmgr_t *manager0, unsigned int n) {
+	isc__socketmgr_t *manager = (isc__socketmgr_t *)manager0;
+
+	REQUIRE(VALID_MANAGER(manager));
+
+#ifdef USE_MMSG
+	manager->udpbatch = ISC_MIN(n, MAXBATCH);
+#else
+	UNUSED(n);
+#endif
+}
+
+isc_result_t
+isc__socketmgr_setaffinity(isc_socketmgr_t *manager0, const unsigned int *cpus,
+			   unsigned int ncpus)
+{
+	isc__socketmgr_t *manager = (isc__socketmgr_t *)manager0;
+	isc_result_t result = ISC_R_SUCCESS;
+#ifdef USE_WATCHER_THREAD
+	isc_result_t tresult;
+	int i;
+#endif
+
+	REQUIRE(VALID_MANAGER(manager));
+	REQUIRE(cpus != NULL || ncpus == 0);
+
+#ifdef USE_WATCHER_THREAD
+	for (i = 0; i < manager->nthreads; i++) {
+		tresult = isc_thread_setaffinity(manager->threads[i].thread,
+						 ncpus == 0 ? -1 :
+						 (int)cpus[i % ncpus]);
+		if (tresult != ISC_R_SUCCESS && result == ISC_R_SUCCESS)
+			result = tresult;
+	}
+#else
+	if (ncpus != 0)
+		result = ISC_R_NOTIMPLEMENTED;
+#endif
+
+	return (result);
+}
+
 /*
  * Create a new socket manager.
  */
 
+#ifdef USE_EPOLL
 static isc_result_t
-setup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
+setup_epoll(isc_mem_t *mctx, isc__socketthread_t *thread) {
+	isc__socketmgr_t *manager = thread->manager;
 	isc_result_t result;
-#if defined(USE_KQUEUE) || defined(USE_EPOLL) || defined(USE_DEVPOLL)
 	char strbuf[ISC_STRERRORSIZE];
+#ifdef USE_WATCHER_THREAD
+	struct epoll_event event;
 #endif
 
-#ifdef USE_KQUEUE
-	manager->nevents = ISC_SOCKET_MAXEVENTS;
-	manager->events = isc_mem_get(mctx, sizeof(struct kevent) *
-				      manager->nevents);
-	if (manager->events == NULL)
+	thread->events = isc_mem_get(mctx, sizeof(struct epoll_event) *
+				     manager->nevents);
+	if (thread->events == NULL)
 		return (ISC_R_NOMEMORY);
-	manager->kqueue_fd = kqueue();
-	if (manager->kqueue_fd == -1) {
+	thread->epoll_fd = epoll_create(manager->nevents);
+	if (thread->epoll_fd == -1) {
 		result = isc__errno2result(errno);
 		isc__strerror(errno, strbuf, sizeof(strbuf));
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "kqueue %s: %s",
+				 "epoll_create %s: %s",
 				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 						ISC_MSG_FAILED, "failed"),
 				 strbuf);
-		isc_mem_put(mctx, manager->events,
-			    sizeof(struct kevent) * manager->nevents);
+		isc_mem_put(mctx, thread->events,
+			    sizeof(struct epoll_event) * manager->nevents);
 		return (result);
 	}
-
 #ifdef USE_WATCHER_THREAD
-	result = watch_fd(manager, manager->pipe_fds[0], SELECT_POKE_READ);
-	if (result != ISC_R_SUCCESS) {
-		close(manager->kqueue_fd);
-		isc_mem_put(mctx, manager->events,
-			    sizeof(struct kevent) * manager->nevents);
+	/*
+	 * The control pipe does not belong to the watcher FDTHREAD()
+	 * would pick for it, so register it here rather than through
+	 * watch_fd().
+	 */
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = thread->pipe_fds[0];
+	if (epoll_ctl(thread->epoll_fd, EPOLL_CTL_ADD,
+		      thread->pipe_fds[0], &event) == -1)
+	{
+		result = isc__errno2result(errno);
+		close(thread->epoll_fd);
+		isc_mem_put(mctx, thread->events,
+			    sizeof(struct epoll_event) * manager->nevents);
 		return (result);
 	}
 #endif	/* USE_WATCHER_THREAD */
-#elif defined(USE_EPOLL)
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+cleanup_epoll(isc_mem_t *mctx, isc__socketthread_t *thread) {
+	isc__socketmgr_t *manager = thread->manager;
+
+	close(thread->epoll_fd);
+	isc_mem_put(mctx, thread->events,
+		    sizeof(struct epoll_event) * manager->nevents);
+}
+#endif	/* USE_EPOLL */
+
+static isc_result_t
+setup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
+	isc_result_t result;
+#if defined(USE_KQUEUE) || defined(USE_DEVPOLL)
+	char strbuf[ISC_STRERRORSIZE];
+#endif
+#ifdef USE_EPOLL
+	int i;
+#endif
+
+#ifdef USE_KQUEUE
 	manager->nevents = ISC_SOCKET_MAXEVENTS;
-	manager->events = isc_mem_get(mctx, sizeof(struct epoll_event) *
+	manager->events = isc_mem_get(mctx, sizeof(struct kevent) *
 				      manager->nevents);
 	if (manager->events == NULL)
 		return (ISC_R_NOMEMORY);
-	manager->epoll_fd = epoll_create(manager->nevents);
-	if (manager->epoll_fd == -1) {
+	manager->kqueue_fd = kqueue();
+	if (manager->kqueue_fd == -1) {
 		result = isc__errno2result(errno);
 		isc__strerror(errno, strbuf, sizeof(strbuf));
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "epoll_create %s: %s",
+				 "kqueue %s: %s",
 				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 						ISC_MSG_FAILED, "failed"),
 				 strbuf);
 		isc_mem_put(mctx, manager->events,
-			    sizeof(struct epoll_event) * manager->nevents);
+			    sizeof(struct kevent) * manager->nevents);
 		return (result);
 	}
+
 #ifdef USE_WATCHER_THREAD
-	result = watch_fd(manager, manager->pipe_fds[0], SELECT_POKE_READ);
+	result = watch_fd(manager, manager->threads[0].pipe_fds[0],
+			  SELECT_POKE_READ);
 	if (result != ISC_R_SUCCESS) {
-		close(manager->epoll_fd);
+		close(manager->kqueue_fd);
 		isc_mem_put(mctx, manager->events,
-			    sizeof(struct epoll_event) * manager->nevents);
+			    sizeof(struct kevent) * manager->nevents);
 		return (result);
 	}
 #endif	/* USE_WATCHER_THREAD */
+#elif defined(USE_EPOLL)
+	manager->nevents = ISC_SOCKET_MAXEVENTS;
+	for (i = 0; i < manager->nthreads; i++) {
+		result = setup_epoll(mctx, &manager->threads[i]);
+		if (result != ISC_R_SUCCESS) {
+			while (--i >= 0)
+				cleanup_epoll(mctx, &manager->threads[i]);
+			return (result);
+		}
+	}
 #elif defined(USE_DEVPOLL)
 	manager->nevents = ISC_SOCKET_MAXEVENTS;
 	result = isc_resource_getcurlimit(isc_resource_openfiles,
@@ -4528,7 +4892,8 @@ setup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
 		return (result);
 	}
 #ifdef USE_WATCHER_THREAD
-	result = watch_fd(manager, manager->pipe_fds[0], SELECT_POKE_READ);
+	result = watch_fd(manager, manager->threads[0].pipe_fds[0],
+			  SELECT_POKE_READ);
 	if (result != ISC_R_SUCCESS) {
 		close(manager->devpoll_fd);
 		isc_mem_put(mctx, manager->events,
@@ -4586,8 +4951,9 @@ setup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
 	memset(manager->write_fds, 0, manager->fd_bufsize);
 
 #ifdef USE_WATCHER_THREAD
-	(void)watch_fd(manager, manager->pipe_fds[0], SELECT_POKE_READ);
-	manager->maxfd = manager->pipe_fds[0];
+	(void)watch_fd(manager, manager->threads[0].pipe_fds[0],
+		       SELECT_POKE_READ);
+	manager->maxfd = manager->threads[0].pipe_fds[0];
 #else /* USE_WATCHER_THREAD */
 	manager->maxfd = 0;
 #endif /* USE_WATCHER_THREAD */
@@ -4598,26 +4964,28 @@ setup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
 
 static void
 cleanup_watcher(isc_mem_t *mctx, isc__socketmgr_t *manager) {
-#ifdef USE_WATCHER_THREAD
+#ifdef USE_EPOLL
+	int i;
+#elif defined(USE_WATCHER_THREAD)
 	isc_result_t result;
 
-	result = unwatch_fd(manager, manager->pipe_fds[0], SELECT_POKE_READ);
+	result = unwatch_fd(manager, manager->threads[0].pipe_fds[0],
+			    SELECT_POKE_READ);
 	if (result != ISC_R_SUCCESS) {
 		UNEXPECTED_ERROR(__FILE__, __LINE__,
 				 "epoll_ctl(DEL) %s",
 				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
 						ISC_MSG_FAILED, "failed"));
 	}
-#endif	/* USE_WATCHER_THREAD */
+#endif	/* USE_EPOLL */
 
 #ifdef USE_KQUEUE
 	close(manager->kqueue_fd);
 	isc_mem_put(mctx, manager->events,
 		    sizeof(struct kevent) * manager->nevents);
 #elif defined(USE_EPOLL)
-	close(manager->epoll_fd);
-	isc_mem_put(mctx, manager->events,
-		    sizeof(struct epoll_event) * manager->nevents);
+	for (i = 0; i < manager->nthreads; i++)
+		cleanup_epoll(mctx, &manager->threads[i]);
 #elif defined(USE_DEVPOLL)
 	close(manager->devpoll_fd);
 	isc_mem_put(mctx, manager->events,
@@ -4644,11 +5012,19 @@ isc__socketmgr_create(isc_mem_t *mctx, isc_socketmgr_t **managerp) {
 isc_result_t
 isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 		       unsigned int maxsocks)
+{
+	return (isc__socketmgr_create3(mctx, managerp, maxsocks, 1));
+}
+
+isc_result_t
+isc__socketmgr_create3(isc_mem_t *mctx, isc_socketmgr_t **managerp,
+		       unsigned int maxsocks, unsigned int nthreads)
 {
 	int i;
 	isc__socketmgr_t *manager;
 #ifdef USE_WATCHER_THREAD
 	char strbuf[ISC_STRERRORSIZE];
+	int t;
 #endif
 	isc_result_t result;
 
@@ -4669,6 +5045,18 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 	if (maxsocks == 0)
 		maxsocks = ISC_SOCKET_MAXSOCKETS;
 
+	/*
+	 * Only epoll can shard descriptors across several watchers.
+	 */
+#if defined(USE_EPOLL) && defined(USE_WATCHER_THREAD)
+	if (nthreads == 0)
+		nthreads = 1;
+	if (nthreads > ISC_SOCKET_MAXWATCHERS)
+		nthreads = ISC_SOCKET_MAXWATCHERS;
+#else
+	nthreads = 1;
+#endif
+
 	manager = isc_mem_get(mctx, sizeof(*manager));
 	if (manager == NULL)
 		return (ISC_R_NOMEMORY);
@@ -4678,6 +5066,24 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 	manager->maxsocks = maxsocks;
 	manager->reserved = 0;
 	manager->maxudp = 0;
+	manager->udpbatch = 0;
+	manager->nthreads = nthreads;
+	manager->threads = isc_mem_get(mctx, manager->nthreads *
+				       sizeof(isc__socketthread_t));
+	if (manager->threads == NULL) {
+		result = ISC_R_NOMEMORY;
+		goto free_manager;
+	}
+	memset(manager->threads, 0,
+	       manager->nthreads * sizeof(isc__socketthread_t));
+	for (i = 0; i < manager->nthreads; i++) {
+		manager->threads[i].manager = manager;
+		manager->threads[i].threadid = i;
+#ifdef USE_WATCHER_THREAD
+		manager->threads[i].pipe_fds[0] = -1;
+		manager->threads[i].pipe_fds[1] = -1;
+#endif
+	}
 	manager->fds = isc_mem_get(mctx,
 				   manager->maxsocks * sizeof(isc__socket_t *));
 	if (manager->fds == NULL) {
@@ -4738,23 +5144,31 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 
 	/*
 	 * Create the special fds that will be used to wake up the
-	 * select/poll loop when something internal needs to be done.
+	 * select/poll loops when something internal needs to be done.
 	 */
-	if (pipe(manager->pipe_fds) != 0) {
-		isc__strerror(errno, strbuf, sizeof(strbuf));
-		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "pipe() %s: %s",
-				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
-						ISC_MSG_FAILED, "failed"),
-				 strbuf);
-		result = ISC_R_UNEXPECTED;
-		goto cleanup_condition;
-	}
+	for (t = 0; t < manager->nthreads; t++) {
+		isc__socketthread_t *thread = &manager->threads[t];
 
-	RUNTIME_CHECK(make_nonblock(manager->pipe_fds[0]) == ISC_R_SUCCESS);
+		if (pipe(thread->pipe_fds) != 0) {
+			isc__strerror(errno, strbuf, sizeof(strbuf));
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "pipe() %s: %s",
+					 isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_GENERAL,
+							ISC_MSG_FAILED,
+							"failed"),
+					 strbuf);
+			result = ISC_R_UNEXPECTED;
+			goto cleanup;
+		}
+
+		RUNTIME_CHECK(make_nonblock(thread->pipe_fds[0]) ==
+			      ISC_R_SUCCESS);
 #if 0
-	RUNTIME_CHECK(make_nonblock(manager->pipe_fds[1]) == ISC_R_SUCCESS);
+		RUNTIME_CHECK(make_nonblock(thread->pipe_fds[1]) ==
+			      ISC_R_SUCCESS);
 #endif
+	}
 #endif	/* USE_WATCHER_THREAD */
 
 #ifdef USE_SHARED_MANAGER
@@ -4772,19 +5186,34 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 
 #ifdef USE_WATCHER_THREAD
 	/*
-	 * Start up the select/poll thread.
+	 * Start up the select/poll threads.
 	 */
-	if (isc_thread_create(watcher, manager, &manager->watcher) !=
-	    ISC_R_SUCCESS) {
-		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "isc_thread_create() %s",
-				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
-						ISC_MSG_FAILED, "failed"));
-		cleanup_watcher(mctx, manager);
-		result = ISC_R_UNEXPECTED;
-		goto cleanup;
+	for (t = 0; t < manager->nthreads; t++) {
+		isc__socketthread_t *thread = &manager->threads[t];
+
+		if (isc_thread_create(watcher, thread, &thread->thread) !=
+		    ISC_R_SUCCESS) {
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "isc_thread_create() %s",
+					 isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_GENERAL,
+							ISC_MSG_FAILED,
+							"failed"));
+			/*
+			 * Stop the watchers that are already running.
+			 */
+			while (--t >= 0) {
+				thread = &manager->threads[t];
+				select_poke_thread(thread, 0,
+						   SELECT_POKE_SHUTDOWN);
+				(void)isc_thread_join(thread->thread, NULL);
+			}
+			cleanup_watcher(mctx, manager);
+			result = ISC_R_UNEXPECTED;
+			goto cleanup;
+		}
+		isc_thread_setname(thread->thread, "isc-socket");
 	}
-	isc_thread_setname(manager->watcher, "isc-socket");
 #endif /* USE_WATCHER_THREAD */
 	isc_mem_attach(mctx, &manager->mctx);
 
@@ -4797,12 +5226,12 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 
 cleanup:
 #ifdef USE_WATCHER_THREAD
-	(void)close(manager->pipe_fds[0]);
-	(void)close(manager->pipe_fds[1]);
-#endif	/* USE_WATCHER_THREAD */
-
-#ifdef USE_WATCHER_THREAD
-cleanup_condition:
+	for (t = 0; t < manager->nthreads; t++) {
+		if (manager->threads[t].pipe_fds[0] != -1)
+			(void)close(manager->threads[t].pipe_fds[0]);
+		if (manager->threads[t].pipe_fds[1] != -1)
+			(void)close(manager->threads[t].pipe_fds[1]);
+	}
 	(void)isc_condition_destroy(&manager->shutdown_ok);
 #endif	/* USE_WATCHER_THREAD */
 
@@ -4819,6 +5248,10 @@ free_manager:
 		isc_mem_put(mctx, manager->fdlock,
 			    FDLOCK_COUNT * sizeof(isc_mutex_t));
 	}
+	if (manager->threads != NULL) {
+		isc_mem_put(mctx, manager->threads,
+			    manager->nthreads * sizeof(isc__socketthread_t));
+	}
 #if defined(USE_EPOLL)
 	if (manager->epoll_events != NULL) {
 		isc_mem_put(mctx, manager->epoll_events,
@@ -4914,13 +5347,18 @@ isc__socketmgr_destroy(isc_socketmgr_t **managerp) {
 
 #ifdef USE_WATCHER_THREAD
 	/*
-	 * Wait for thread to exit.
+	 * Wait for the threads to exit.
 	 */
-	if (isc_thread_join(manager->watcher, NULL) != ISC_R_SUCCESS)
-		UNEXPECTED_ERROR(__FILE__, __LINE__,
-				 "isc_thread_join() %s",
-				 isc_msgcat_get(isc_msgcat, ISC_MSGSET_GENERAL,
-						ISC_MSG_FAILED, "failed"));
+	for (i = 0; i < manager->nthreads; i++) {
+		if (isc_thread_join(manager->threads[i].thread, NULL) !=
+		    ISC_R_SUCCESS)
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "isc_thread_join() %s",
+					 isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_GENERAL,
+							ISC_MSG_FAILED,
+							"failed"));
+	}
 #endif /* USE_WATCHER_THREAD */
 
 	/*
@@ -4929,8 +5367,10 @@ isc__socketmgr_destroy(isc_socketmgr_t **managerp) {
 	cleanup_watcher(manager->mctx, manager);
 
 #ifdef USE_WATCHER_THREAD
-	(void)close(manager->pipe_fds[0]);
-	(void)close(manager->pipe_fds[1]);
+	for (i = 0; i < manager->nthreads; i++) {
+		(void)close(manager->threads[i].pipe_fds[0]);
+		(void)close(manager->threads[i].pipe_fds[1]);
+	}
 	(void)isc_condition_destroy(&manager->shutdown_ok);
 #endif /* USE_WATCHER_THREAD */
 
@@ -4946,6 +5386,8 @@ isc__socketmgr_destroy(isc_socketmgr_t **managerp) {
 		    manager->maxsocks * sizeof(isc__socket_t *));
 	isc_mem_put(manager->mctx, manager->fdstate,
 		    manager->maxsocks * sizeof(int));
+	isc_mem_put(manager->mctx, manager->threads,
+		    manager->nthreads * sizeof(isc__socketthread_t));
 
 	if (manager->stats != NULL)
 		isc_stats_detach(&manager->stats);
@@ -5591,6 +6033,28 @@ isc__socket_bind(isc_socket_t *sock0, isc_sockaddr_t *sockaddr,
 						ISC_MSG_FAILED, "failed"));
 		/* Press on... */
 	}
+	if ((options & ISC_SOCKET_REUSEPORT) != 0) {
+#ifdef SO_REUSEPORT
+		if (setsockopt(sock->fd, SOL_SOCKET, SO_REUSEPORT,
+			       (void *)&on, sizeof(on)) < 0)
+		{
+			isc__strerror(errno, strbuf, sizeof(strbuf));
+			UNLOCK(&sock->lock);
+			UNEXPECTED_ERROR(__FILE__, __LINE__,
+					 "setsockopt(%d, SO_REUSEPORT) %s: %s",
+					 sock->fd,
+					 isc_msgcat_get(isc_msgcat,
+							ISC_MSGSET_GENERAL,
+							ISC_MSG_FAILED,
+							"failed"),
+					 strbuf);
+			return (ISC_R_NOTIMPLEMENTED);
+		}
+#else
+		UNLOCK(&sock->lock);
+		return (ISC_R_NOTIMPLEMENTED);
+#endif
+	}
 #ifdef AF_UNIX
  bind_socket:
 #endif
@@ -6487,8 +6951,8 @@ isc__socketmgr_waitevents(isc_socketmgr_t *manager0, struct timeval *tvp,
 		timeout = tvp->tv_sec * 1000 + (tvp->tv_usec + 999) / 1000;
 	else
 		timeout = -1;
-	swait_private.nevents = epoll_wait(manager->epoll_fd,
-					   manager->events,
+	swait_private.nevents = epoll_wait(manager->threads[0].epoll_fd,
+					   manager->threads[0].events,
 					   manager->nevents, timeout);
 	n = swait_private.nevents;
 #elif defined(USE_DEVPOLL)
@@ -6557,7 +7021,11 @@ isc__socketmgr_dispatch(isc_socketmgr_t *manager0, isc_socketwait_t *swait) {
 	if (manager == NULL)
 		return (ISC_R_NOTFOUND);
 
-#if defined(USE_KQUEUE) || defined(USE_EPOLL) || defined(USE_DEVPOLL)
+#if defined(USE_EPOLL)
+	(void)process_fds(&manager->threads[0], manager->threads[0].events,
+			  swait->nevents);
+	return (ISC_R_SUCCESS);
+#elif defined(USE_KQUEUE) || defined(USE_DEVPOLL)
 	(void)process_fds(manager, manager->events, swait->nevents);
 	return (ISC_R_SUCCESS);
 #elif defined(USE_SELECT)
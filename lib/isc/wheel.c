@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2018  Internet Systems Consortium, Inc. ("ISC")
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*! \file
+ * Hierarchical timing wheel, after:
+ *
+ *	\li "Hashed and Hierarchical Timing Wheels: Data Structures for
+ *	the Efficient Implementation of a Timer Facility," Varghese and
+ *	Lauck, Proceedings of the 11th ACM Symposium on Operating Systems
+ *	Principles, 1987.
+ */
+
+#include <config.h>
+
+#include <isc/magic.h>
+#include <isc/mem.h>
+#include <isc/util.h>
+#include <isc/wheel.h>
+
+/*@{*/
+/*%
+ * Each level has WHEEL_SIZE slots.  A slot at level 'l' covers
+ * WHEEL_SIZE^l ticks, so the wheel as a whole covers WHEEL_SIZE^WHEEL_LEVELS
+ * ticks (2^48, almost 9000 years of milliseconds); entries further in the
+ * future than that are parked in the last slot and re-filed when it comes
+ * round.
+ */
+#define WHEEL_BITS		6
+#define WHEEL_SIZE		(1U << WHEEL_BITS)
+#define WHEEL_MASK		((isc_uint64_t)WHEEL_SIZE - 1)
+#define WHEEL_LEVELS		8
+#define WHEEL_SPAN		((isc_uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+/*@}*/
+
+/*%
+ * entry->slot is 0 for an unscheduled entry, the slot number plus one
+ * for an entry in a slot, and EXPIRED for an entry on the expired list.
+ */
+#define SLOT(level, idx)	((level) * WHEEL_SIZE + (unsigned int)(idx))
+#define EXPIRED			(WHEEL_LEVELS * WHEEL_SIZE + 1)
+
+#define WHEEL_MAGIC		ISC_MAGIC('W', 'H', 'E', 'L')
+#define VALID_WHEEL(w)		ISC_MAGIC_VALID(w, WHEEL_MAGIC)
+
+typedef ISC_LIST(isc_wheelentry_t) entrylist_t;
+
+/*% ISC timing wheel structure. */
+struct isc_wheel {
+	unsigned int			magic;
+	isc_mem_t *			mctx;
+	/*%
+	 * Every tick up to and including 'now' has been processed.
+	 */
+	isc_uint64_t			now;
+	unsigned int			count;
+	/*%
+	 * Bit 'i' of bitmap[l] is set when slot 'i' of level 'l' is
+	 * not empty.
+	 */
+	isc_uint64_t			bitmap[WHEEL_LEVELS];
+	entrylist_t			expired;
+	entrylist_t			slots[WHEEL_LEVELS * WHEEL_SIZE];
+};
+
+/*%
+ * Index of the lowest set bit of a non-zero 'w'.
+ */
+static inline unsigned int
+lowbit(isc_uint64_t w) {
+#ifdef HAVE_BUILTIN_CLZ
+	return (63 - __builtin_clzll(w & (~w + 1)));
+#else
+	unsigned int bit = 0;
+
+	if ((w & 0xffffffffU) == 0) {
+		w >>= 32;
+		bit += 32;
+	}
+	if ((w & 0xffff) == 0) {
+		w >>= 16;
+		bit += 16;
+	}
+	if ((w & 0xff) == 0) {
+		w >>= 8;
+		bit += 8;
+	}
+	if ((w & 0xf) == 0) {
+		w >>= 4;
+		bit += 4;
+	}
+	if ((w & 0x3) == 0) {
+		w >>= 2;
+		bit += 2;
+	}
+	if ((w & 0x1) == 0)
+		bit += 1;
+	return (bit);
+#endif
+}
+
+/*%
+ * File 'entry' in the slot from which it will next be moved, relative
+ * to the first unprocessed tick.
+ *
+ * An entry goes in the lowest level whose span covers the distance to
+ * its tick.  That guarantees that its slot is not reached again until
+ * the entry is due to move down a level (or expire, at level 0).
+ */
+static inline void
+place(isc_wheel_t *wheel, isc_wheelentry_t *entry) {
+	isc_uint64_t base, tick, delta;
+	unsigned int level, idx;
+
+	base = wheel->now + 1;
+	tick = ISC_MAX(entry->tick, base);
+	delta = tick - base;
+	if (delta >= WHEEL_SPAN) {
+		delta = WHEEL_SPAN - 1;
+		tick = base + delta;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if ((delta >> (WHEEL_BITS * (level + 1))) == 0)
+			break;
+
+	idx = (unsigned int)((tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+	ISC_LIST_APPEND(wheel->slots[SLOT(level, idx)], entry, link);
+	wheel->bitmap[level] |= (isc_uint64_t)1 << idx;
+	entry->slot = SLOT(level, idx) + 1;
+}
+
+/*%
+ * Find the first tick after wheel->now at which a slot is reached
+ * that has entries in it.
+ */
+static isc_boolean_t
+nextevent(isc_wheel_t *wheel, isc_uint64_t *tickp) {
+	isc_uint64_t base, k, bits, tick = 0;
+	isc_boolean_t found = ISC_FALSE;
+	unsigned int level, shift, rot;
+
+	base = wheel->now + 1;
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		if (wheel->bitmap[level] == 0)
+			continue;
+		/*
+		 * Slots at this level are reached every 2^shift ticks;
+		 * 'k' is the first such point not yet processed, and
+		 * rotating the bitmap by its slot index puts the slot
+		 * reached at 'k' in bit 0.
+		 */
+		shift = WHEEL_BITS * level;
+		k = (base + ((isc_uint64_t)1 << shift) - 1) >> shift;
+		rot = (unsigned int)(k & WHEEL_MASK);
+		bits = wheel->bitmap[level];
+		if (rot != 0)
+			bits = (bits >> rot) | (bits << (WHEEL_SIZE - rot));
+		k = (k + lowbit(bits)) << shift;
+		if (!found || k < tick) {
+			tick = k;
+			found = ISC_TRUE;
+		}
+	}
+
+	if (found)
+		*tickp = tick;
+	return (found);
+}
+
+/*%
+ * Process 'tick', which must be the next tick with work to do: move the
+ * entries in each slot reached at this tick to lower levels, and then
+ * those due now to the expired list.
+ */
+static void
+advance(isc_wheel_t *wheel, isc_uint64_t tick) {
+	entrylist_t *slot;
+	isc_wheelentry_t *entry;
+	unsigned int level, idx;
+
+	INSIST(tick > wheel->now);
+	wheel->now = tick - 1;
+
+	for (level = WHEEL_LEVELS - 1; level > 0; level--) {
+		if ((tick & (((isc_uint64_t)1 << (WHEEL_BITS * level)) - 1))
+		    != 0)
+			continue;
+		idx = (unsigned int)((tick >> (WHEEL_BITS * level)) &
+				     WHEEL_MASK);
+		slot = &wheel->slots[SLOT(level, idx)];
+		wheel->bitmap[level] &= ~((isc_uint64_t)1 << idx);
+		while ((entry = ISC_LIST_HEAD(*slot)) != NULL) {
+			ISC_LIST_UNLINK(*slot, entry, link);
+			place(wheel, entry);
+		}
+	}
+
+	idx = (unsigned int)(tick & WHEEL_MASK);
+	slot = &wheel->slots[SLOT(0, idx)];
+	wheel->bitmap[0] &= ~((isc_uint64_t)1 << idx);
+	while ((entry = ISC_LIST_HEAD(*slot)) != NULL) {
+		ISC_LIST_UNLINK(*slot, entry, link);
+		ISC_LIST_APPEND(wheel->expired, entry, link);
+		entry->slot = EXPIRED;
+	}
+
+	wheel->now = tick;
+}
+
+isc_result_t
+isc_wheel_create(isc_mem_t *mctx, isc_uint64_t now, isc_wheel_t **wheelp) {
+	isc_wheel_t *wheel;
+	unsigned int i;
+
+	REQUIRE(wheelp != NULL && *wheelp == NULL);
+
+	wheel = isc_mem_get(mctx, sizeof(*wheel));
+	if (wheel == NULL)
+		return (ISC_R_NOMEMORY);
+
+	wheel->mctx = NULL;
+	isc_mem_attach(mctx, &wheel->mctx);
+	wheel->now = now;
+	wheel->count = 0;
+	for (i = 0; i < WHEEL_LEVELS; i++)
+		wheel->bitmap[i] = 0;
+	ISC_LIST_INIT(wheel->expired);
+	for (i = 0; i < WHEEL_LEVELS * WHEEL_SIZE; i++)
+		ISC_LIST_INIT(wheel->slots[i]);
+	wheel->magic = WHEEL_MAGIC;
+
+	*wheelp = wheel;
+	return (ISC_R_SUCCESS);
+}
+
+void
+isc_wheel_destroy(isc_wheel_t **wheelp) {
+	isc_wheel_t *wheel;
+
+	REQUIRE(wheelp != NULL);
+	wheel = *wheelp;
+	REQUIRE(VALID_WHEEL(wheel));
+
+	wheel->magic = 0;
+	isc_mem_putanddetach(&wheel->mctx, wheel, sizeof(*wheel));
+
+	*wheelp = NULL;
+}
+
+void
+isc_wheel_insert(isc_wheel_t *wheel, isc_wheelentry_t *entry,
+		 isc_uint64_t tick, void *value)
+{
+	REQUIRE(VALID_WHEEL(wheel));
+	REQUIRE(entry != NULL && !ISC_WHEELENTRY_SCHEDULED(entry));
+
+	entry->tick = tick;
+	entry->value = value;
+	place(wheel, entry);
+	wheel->count++;
+}
+
+void
+isc_wheel_delete(isc_wheel_t *wheel, isc_wheelentry_t *entry) {
+	unsigned int slot;
+
+	REQUIRE(VALID_WHEEL(wheel));
+	REQUIRE(entry != NULL && ISC_WHEELENTRY_SCHEDULED(entry));
+
+	if (entry->slot == EXPIRED) {
+		ISC_LIST_UNLINK(wheel->expired, entry, link);
+	} else {
+		slot = entry->slot - 1;
+		ISC_LIST_UNLINK(wheel->slots[slot], entry, link);
+		if (ISC_LIST_EMPTY(wheel->slots[slot]))
+			wheel->bitmap[slot / WHEEL_SIZE] &=
+				~((isc_uint64_t)1 << (slot % WHEEL_SIZE));
+	}
+	entry->slot = 0;
+	INSIST(wheel->count > 0);
+	wheel->count--;
+}
+
+void *
+isc_wheel_expire(isc_wheel_t *wheel, isc_uint64_t now) {
+	isc_wheelentry_t *entry;
+	isc_uint64_t tick;
+
+	REQUIRE(VALID_WHEEL(wheel));
+
+	for (;;) {
+		entry = ISC_LIST_HEAD(wheel->expired);
+		if (entry != NULL) {
+			ISC_LIST_UNLINK(wheel->expired, entry, link);
+			entry->slot = 0;
+			INSIST(wheel->count > 0);
+			wheel->count--;
+			return (entry->value);
+		}
+
+		if (!nextevent(wheel, &tick) || tick > now) {
+			/*
+			 * Nothing happens between here and 'now'.
+			 */
+			if (now > wheel->now)
+				wheel->now = now;
+			return (NULL);
+		}
+		advance(wheel, tick);
+	}
+}
+
+isc_boolean_t
+isc_wheel_next(isc_wheel_t *wheel, isc_uint64_t *tickp) {
+	REQUIRE(VALID_WHEEL(wheel));
+	REQUIRE(tickp != NULL);
+
+	if (!ISC_LIST_EMPTY(wheel->expired)) {
+		*tickp = wheel->now;
+		return (ISC_TRUE);
+	}
+	return (nextevent(wheel, tickp));
+}
+
+unsigned int
+isc_wheel_count(isc_wheel_t *wheel) {
+	REQUIRE(VALID_WHEEL(wheel));
+
+	return (wheel->count);
+}
@@ -2706,6 +2706,18 @@ isc__socketmgr_create2(isc_mem_t *mctx, isc_socketmgr_t **managerp,
 	return (ISC_R_SUCCESS);
 }
 
+isc_result_t
+isc__socketmgr_create3(isc_mem_t *mctx, isc_socketmgr_t **managerp,
+		       unsigned int maxsocks, unsigned int nthreads)
+{
+	/*
+	 * The completion port already has its own pool of I/O threads.
+	 */
+	UNUSED(nthreads);
+
+	return (isc_socketmgr_create2(mctx, managerp, maxsocks));
+}
+
 isc_result_t
 isc_socketmgr_getmaxsockets(isc_socketmgr_t *manager, unsigned int *nsockp) {
 	REQUIRE(VALID_MANAGER(manager));
@@ -3260,6 +3272,13 @@ isc__socket_bind(isc_socket_t *sock, isc_sockaddr_t *sockaddr,
 		UNLOCK(&sock->lock);
 		return (ISC_R_FAMILYMISMATCH);
 	}
+	/*
+	 * There is no SO_REUSEPORT load balancing on Windows.
+	 */
+	if ((options & ISC_SOCKET_REUSEPORT) != 0) {
+		UNLOCK(&sock->lock);
+		return (ISC_R_NOTIMPLEMENTED);
+	}
 	/*
 	 * Only set SO_REUSEADDR when we want a specific port.
 	 */
@@ -3981,6 +4000,22 @@ isc___socketmgr_maxudp(isc_socketmgr_t *manager, int maxudp) {
 	UNUSED(maxudp);
 }
 
+void
+isc__socketmgr_setudpbatch(isc_socketmgr_t *manager, unsigned int n) {
+	UNUSED(manager);
+	UNUSED(n);
+}
+
+isc_result_t
+isc__socketmgr_setaffinity(isc_socketmgr_t *manager, const unsigned int *cpus,
+			   unsigned int ncpus)
+{
+	UNUSED(manager);
+	UNUSED(cpus);
+
+	return (ncpus == 0 ? ISC_R_SUCCESS : ISC_R_NOTIMPLEMENTED);
+}
+
 isc_socketevent_t *
 isc_socket_socketevent(isc_mem_t *mctx, void *sender,
 		       isc_eventtype_t eventtype, isc_taskaction_t action,
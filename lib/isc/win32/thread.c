@@ -63,6 +63,22 @@ isc_thread_setname(isc_thread_t thread, const char *name) {
 	UNUSED(name);
 }
 
+isc_result_t
+isc_thread_setaffinity(isc_thread_t thread, int cpu) {
+	DWORD_PTR mask;
+
+	if (cpu < 0)
+		mask = (DWORD_PTR)-1;
+	else if (cpu < (int)(sizeof(mask) * 8))
+		mask = (DWORD_PTR)1 << cpu;
+	else
+		return (ISC_R_RANGE);
+
+	if (SetThreadAffinityMask(thread, mask) == 0)
+		return (ISC_R_FAILURE);
+	return (ISC_R_SUCCESS);
+}
+
 void *
 isc_thread_key_getspecific(isc_thread_key_t key) {
 	return(TlsGetValue(key));
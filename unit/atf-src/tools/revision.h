@@ -0,0 +1 @@
+#define PACKAGE_REVISION_TYPE_DIST